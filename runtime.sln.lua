@@ -25,3 +25,4 @@
 	include "src/sledluaplugin_TestSimple/libsce_testsimple-5.1.4_sample.lua"
 	include "src/sledluaplugin_TestTarget/libsce_testtarget-5.1.4_sample.lua"
 	include "src/sledluaplugin_TestTarget/libsce_testtarget-5.2.3_sample.lua"
+	include "src/sledluaplugin_ProfileDiff/sce_sledprofilediff.lua"
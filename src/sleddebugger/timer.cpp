@@ -48,6 +48,18 @@ namespace sce { namespace Sled
 #endif
 		}
 
+		uint64_t ElapsedMicroseconds() const
+		{
+#if SCE_SLEDTARGET_OS_WINDOWS
+			LARGE_INTEGER end;
+			::QueryPerformanceCounter(&end);
+			// Split so the multiply can't overflow
+			const uint64_t iTicks = (uint64_t)(end.QuadPart - m_start.QuadPart);
+			const uint64_t iFreq = (uint64_t)m_freq.QuadPart;
+			return ((iTicks / iFreq) * 1000000) + (((iTicks % iFreq) * 1000000) / iFreq);
+#endif
+		}
+
 		void Reset() { Start(); }
 	private:
 #if SCE_SLEDTARGET_OS_WINDOWS
@@ -149,4 +161,9 @@ namespace sce { namespace Sled
 	{
 		return m_impl->Elapsed();
 	}
+
+	uint64_t Timer::elapsedMicroseconds() const
+	{
+		return m_impl->ElapsedMicroseconds();
+	}
 }}
@@ -96,6 +96,14 @@ namespace Sled
 		///
 		/// @return Elapsed time of <c>Timer</c>.
 		float elapsed() const;
+
+		/// Get the elapsed time of the <c>Timer</c> in whole microseconds, without the rounding of <c>elapsed</c>
+		/// over long runs.
+		/// @brief
+		/// Get elapsed time of <c>Timer</c> in microseconds.
+		///
+		/// @return Elapsed time of <c>Timer</c> in microseconds.
+		uint64_t elapsedMicroseconds() const;
 	private:
 		TimerImpl*	m_impl;
 		uint8_t		m_data[96];
@@ -0,0 +1,134 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "coveragewriter.h"
+#include "../sleddebugger/assert.h"
+
+#include <cstring>
+
+namespace sce { namespace Sled
+{
+	CoverageWriter::CoverageWriter(CoverageWriteCallback pfnWrite, void *pUserData)
+		: m_pfnWrite(pfnWrite)
+		, m_pUserData(pUserData)
+		, m_iBufferSize(0)
+		, m_iNumChunks(0)
+		, m_iNumBytes(0)
+		, m_bFailed(pfnWrite == NULL)
+	{
+	}
+
+	void CoverageWriter::begin()
+	{
+		putByte('S');
+		putByte('L');
+		putByte('C');
+		putByte('V');
+		putByte(kVersion);
+	}
+
+	void CoverageWriter::addChunk(const char *pszSource, int32_t iLineDefined, const int32_t *pLineInfo, int32_t iSizeLineInfo, const uint32_t *pCounts, int32_t iCountsFirstLine, int32_t iNumCounts)
+	{
+		SCE_SLED_ASSERT(pszSource != NULL);
+
+		if ((pLineInfo == NULL) || (iSizeLineInfo <= 0))
+			return;
+
+		int32_t iFirst = pLineInfo[0];
+		int32_t iLast = pLineInfo[0];
+		for (int32_t i = 1; i < iSizeLineInfo; i++)
+		{
+			if (pLineInfo[i] < iFirst)
+				iFirst = pLineInfo[i];
+			else if (pLineInfo[i] > iLast)
+				iLast = pLineInfo[i];
+		}
+
+		const int32_t iNumLines = iLast - iFirst + 1;
+		const std::size_t iSourceLen = std::strlen(pszSource);
+
+		putByte(kTagChunk);
+		putVarint(iSourceLen);
+		for (std::size_t i = 0; i < iSourceLen; i++)
+			putByte((uint8_t)pszSource[i]);
+		putVarint(iLineDefined < 0 ? 0 : iLineDefined);
+		putVarint(iFirst < 0 ? 0 : iFirst);
+		putVarint(iNumLines);
+
+		// Which lines hold code is only known from the instructions'
+		// lines, which aren't in order, so mark a window at a time
+		for (int32_t iWindow = 0; iWindow < iNumLines; iWindow += kWindowLines)
+		{
+			const int32_t iWindowLines = ((iNumLines - iWindow) < kWindowLines) ? (iNumLines - iWindow) : kWindowLines;
+			std::memset(m_window, 0, sizeof(m_window));
+
+			for (int32_t i = 0; i < iSizeLineInfo; i++)
+			{
+				const int32_t iLine = pLineInfo[i] - iFirst - iWindow;
+				if ((iLine >= 0) && (iLine < iWindowLines))
+					m_window[iLine >> 3] |= (uint8_t)(1 << (iLine & 7));
+			}
+
+			for (int32_t iGroup = 0; iGroup < iWindowLines; iGroup += 8)
+			{
+				const uint8_t iBits = m_window[iGroup >> 3];
+				putByte(iBits);
+
+				for (int32_t iBit = 0; iBit < 8; iBit++)
+				{
+					if ((iBits & (1 << iBit)) == 0)
+						continue;
+
+					const int32_t iCount = iFirst + iWindow + iGroup + iBit - iCountsFirstLine;
+					const bool bCounted = (pCounts != NULL) && (iCount >= 0) && (iCount < iNumCounts);
+					putVarint(bCounted ? pCounts[iCount] : 0);
+				}
+			}
+		}
+
+		m_iNumChunks++;
+	}
+
+	bool CoverageWriter::end()
+	{
+		putByte(kTagEnd);
+		putVarint(m_iNumChunks);
+		flush();
+
+		return !m_bFailed;
+	}
+
+	void CoverageWriter::putByte(uint8_t iByte)
+	{
+		if (m_iBufferSize == kMaxWriteSize)
+			flush();
+
+		m_buffer[m_iBufferSize++] = iByte;
+	}
+
+	void CoverageWriter::putVarint(uint64_t iValue)
+	{
+		while (iValue >= 0x80)
+		{
+			putByte((uint8_t)(iValue | 0x80));
+			iValue >>= 7;
+		}
+
+		putByte((uint8_t)iValue);
+	}
+
+	void CoverageWriter::flush()
+	{
+		if (!m_bFailed && (m_iBufferSize > 0))
+		{
+			if (m_pfnWrite(m_buffer, m_iBufferSize, m_pUserData))
+				m_iNumBytes += m_iBufferSize;
+			else
+				m_bFailed = true;
+		}
+
+		m_iBufferSize = 0;
+	}
+}}
@@ -0,0 +1,77 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#ifndef __SCE_LIBSLEDLUAPLUGIN_COVERAGEWRITER_H__
+#define __SCE_LIBSLEDLUAPLUGIN_COVERAGEWRITER_H__
+
+#include "../sledcore/base_types.h"
+#include <cstddef>
+
+#include "../sleddebugger/common.h"
+#include "params.h"
+
+namespace sce { namespace Sled
+{
+	// Encodes line coverage counts in the compact binary form handed to
+	// luaPluginWriteCoverage callbacks and streamed to SLED. All numbers
+	// other than the version are unsigned LEB128 varints.
+	//
+	//   header  'S' 'L' 'C' 'V', version byte
+	//   chunk   kTagChunk, source length, source bytes, line defined,
+	//           first line, number of lines, then for every 8 lines a
+	//           byte with bit i set if line (first + 8n + i) holds code,
+	//           followed by the count of each of those lines, lowest first
+	//   end     kTagEnd, number of chunks
+	//
+	// The output goes to the callback kMaxWriteSize bytes at a time at
+	// most; once the callback returns false nothing else is written.
+	class SCE_SLED_LINKAGE CoverageWriter
+	{
+	public:
+		static const uint8_t kVersion = 1;
+		static const uint8_t kTagEnd = 0;
+		static const uint8_t kTagChunk = 1;
+		static const int32_t kMaxWriteSize = 512;
+
+		CoverageWriter(CoverageWriteCallback pfnWrite, void *pUserData);
+	private:
+		CoverageWriter(const CoverageWriter&);
+		CoverageWriter& operator=(const CoverageWriter&);
+	public:
+		void begin();
+
+		// One function prototype. pCounts holds the counts of iNumCounts
+		// lines starting at iCountsFirstLine and may be NULL if none ran;
+		// pLineInfo is the line of every instruction.
+		void addChunk(const char *pszSource, int32_t iLineDefined, const int32_t *pLineInfo, int32_t iSizeLineInfo, const uint32_t *pCounts, int32_t iCountsFirstLine, int32_t iNumCounts);
+
+		// Writes the end marker and flushes; false if the callback failed
+		bool end();
+
+		inline uint32_t getNumChunks() const { return m_iNumChunks; }
+		inline uint64_t getNumBytes() const { return m_iNumBytes; }
+		inline bool hasFailed() const { return m_bFailed; }
+	private:
+		void putByte(uint8_t iByte);
+		void putVarint(uint64_t iValue);
+		void flush();
+	private:
+		// Lines whose code bits are worked out per pass over the line info
+		static const int32_t kWindowLines = 2048;
+
+		CoverageWriteCallback	m_pfnWrite;
+		void					*m_pUserData;
+
+		uint8_t		m_buffer[kMaxWriteSize];
+		int32_t		m_iBufferSize;
+		uint8_t		m_window[kWindowLines / 8];
+
+		uint32_t	m_iNumChunks;
+		uint64_t	m_iNumBytes;
+		bool		m_bFailed;
+	};
+}}
+
+#endif // __SCE_LIBSLEDLUAPLUGIN_COVERAGEWRITER_H__
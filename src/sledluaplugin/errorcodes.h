@@ -13,5 +13,21 @@
 #define SCE_SLED_LUA_ERROR_OVERLUASTATELIMIT			(int)(0x80831005)	///< Plugin already added; error code
 #define SCE_SLED_LUA_ERROR_LUASTATENOTFOUND				(int)(0x80831006)	///< Invalid plugin; error code
 #define SCE_SLED_LUA_ERROR_LUASTATEALREADYREGISTERED	(int)(0x80831007)	///< Lua state already registered; error code
+#define SCE_SLED_LUA_ERROR_HEAPCENSUSDISABLED			(int)(0x80831008)	///< Heap census not enabled in the configuration; error code
+#define SCE_SLED_LUA_ERROR_COVERAGEWRITEFAILED			(int)(0x80831009)	///< Coverage write callback stopped the write; error code
+#define SCE_SLED_LUA_ERROR_OPCODEPROFILEDISABLED		(int)(0x8083100A)	///< Opcode profile not enabled in the configuration; error code
+#define SCE_SLED_LUA_ERROR_CALLPATHSDISABLED			(int)(0x8083100B)	///< Profiler call paths not enabled in the configuration; error code
+#define SCE_SLED_LUA_ERROR_PROFILEFOLDEDWRITEFAILED		(int)(0x8083100C)	///< Folded-stack write callback stopped the write; error code
+#define SCE_SLED_LUA_ERROR_TRACEDISABLED				(int)(0x8083100D)	///< Timeline capture not enabled in the configuration; error code
+#define SCE_SLED_LUA_ERROR_TRACEWRITEFAILED				(int)(0x8083100E)	///< Trace write callback stopped the write; error code
+#define SCE_SLED_LUA_ERROR_LATENCYDISABLED				(int)(0x8083100F)	///< Profiler latency histograms not enabled in the configuration; error code
+#define SCE_SLED_LUA_ERROR_PROFILEFUNCTIONNOTFOUND		(int)(0x80831010)	///< Function not profiled, or has no latency histogram when asked for one; error code
+#define SCE_SLED_LUA_ERROR_FRAMESDISABLED				(int)(0x80831011)	///< Frame profiling not enabled in the configuration; error code
+#define SCE_SLED_LUA_ERROR_PERFWATCHESDISABLED			(int)(0x80831012)	///< Performance watches not enabled in the configuration; error code
+#define SCE_SLED_LUA_ERROR_PERFWATCHESFULL				(int)(0x80831013)	///< No room for another performance watch; error code
+#define SCE_SLED_LUA_ERROR_PROFILEZONENOTENTERED		(int)(0x80831014)	///< Profiler not running, or no room in the profile for the zone; error code
+#define SCE_SLED_LUA_ERROR_PROFILEFILTERSDISABLED		(int)(0x80831015)	///< Profile filters not enabled in the configuration; error code
+#define SCE_SLED_LUA_ERROR_PROFILEFILTERSFULL			(int)(0x80831016)	///< No room for another profile filter pattern; error code
+#define SCE_SLED_LUA_ERROR_PROFILECAPTUREWRITEFAILED	(int)(0x80831017)	///< Profile capture write callback stopped the write; error code
 
 #endif // __SCE_LIBSLEDLUAPLUGIN_ERRORCODES_H__
@@ -0,0 +1,104 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "foldedstackwriter.h"
+#include "numberformat.h"
+#include "../sleddebugger/assert.h"
+
+namespace sce { namespace Sled
+{
+	FoldedStackWriter::FoldedStackWriter(ProfileFoldedWriteCallback pfnWrite, void *pUserData)
+		: m_pfnWrite(pfnWrite)
+		, m_pUserData(pUserData)
+		, m_iBufferSize(0)
+		, m_bLineStarted(false)
+		, m_iNumLines(0)
+		, m_iNumBytes(0)
+		, m_bFailed(pfnWrite == NULL)
+	{
+	}
+
+	void FoldedStackWriter::addFrame(const char *pszFnName, const char *pszFnFile, int32_t iFnLine)
+	{
+		SCE_SLED_ASSERT(pszFnName != NULL);
+		SCE_SLED_ASSERT(pszFnFile != NULL);
+
+		if (m_bLineStarted)
+			putChar(';');
+
+		char szLine[32];
+		NumberFormat::formatInteger(szLine, sizeof(szLine), iFnLine);
+
+		putName(pszFnName);
+		putText(" (");
+		putName(pszFnFile);
+		putChar(':');
+		putText(szLine);
+		putChar(')');
+
+		m_bLineStarted = true;
+	}
+
+	void FoldedStackWriter::endLine(uint64_t iValue)
+	{
+		if (!m_bLineStarted)
+			return;
+
+		char szValue[32];
+		NumberFormat::formatUnsigned(szValue, sizeof(szValue), iValue);
+
+		putChar(' ');
+		putText(szValue);
+		putChar('\n');
+
+		m_bLineStarted = false;
+		m_iNumLines++;
+	}
+
+	bool FoldedStackWriter::end()
+	{
+		flush();
+		return !m_bFailed;
+	}
+
+	void FoldedStackWriter::putChar(char ch)
+	{
+		if (m_iBufferSize == kMaxWriteSize)
+			flush();
+
+		m_buffer[m_iBufferSize++] = ch;
+	}
+
+	void FoldedStackWriter::putName(const char *pszName)
+	{
+		for (; *pszName != '\0'; ++pszName)
+		{
+			const char ch = *pszName;
+			if ((ch == ';') || (ch == '\n') || (ch == '\r'))
+				putChar('_');
+			else
+				putChar(ch);
+		}
+	}
+
+	void FoldedStackWriter::putText(const char *pszText)
+	{
+		for (; *pszText != '\0'; ++pszText)
+			putChar(*pszText);
+	}
+
+	void FoldedStackWriter::flush()
+	{
+		if (!m_bFailed && (m_iBufferSize > 0))
+		{
+			if (m_pfnWrite(m_buffer, m_iBufferSize, m_pUserData))
+				m_iNumBytes += m_iBufferSize;
+			else
+				m_bFailed = true;
+		}
+
+		m_iBufferSize = 0;
+	}
+}}
@@ -0,0 +1,64 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#ifndef __SCE_LIBSLEDLUAPLUGIN_FOLDEDSTACKWRITER_H__
+#define __SCE_LIBSLEDLUAPLUGIN_FOLDEDSTACKWRITER_H__
+
+#include "../sledcore/base_types.h"
+#include <cstddef>
+
+#include "../sleddebugger/common.h"
+#include "params.h"
+
+namespace sce { namespace Sled
+{
+	// Writes call paths as folded-stack text, one line per path:
+	//
+	//   outer (file.lua:1);inner (file.lua:10) 1234
+	//
+	// Semicolons and line breaks in names are replaced so they can't
+	// split a frame or a line. The output goes to the callback
+	// kMaxWriteSize bytes at a time at most; once the callback returns
+	// false nothing else is written.
+	class SCE_SLED_LINKAGE FoldedStackWriter
+	{
+	public:
+		static const int32_t kMaxWriteSize = 512;
+
+		FoldedStackWriter(ProfileFoldedWriteCallback pfnWrite, void *pUserData);
+	private:
+		FoldedStackWriter(const FoldedStackWriter&);
+		FoldedStackWriter& operator=(const FoldedStackWriter&);
+	public:
+		// Frames of the current line, outermost first
+		void addFrame(const char *pszFnName, const char *pszFnFile, int32_t iFnLine);
+		void endLine(uint64_t iValue);
+
+		// Flushes; false if the callback failed
+		bool end();
+
+		inline uint32_t getNumLines() const { return m_iNumLines; }
+		inline uint64_t getNumBytes() const { return m_iNumBytes; }
+		inline bool hasFailed() const { return m_bFailed; }
+	private:
+		void putChar(char ch);
+		void putName(const char *pszName);
+		void putText(const char *pszText);
+		void flush();
+	private:
+		ProfileFoldedWriteCallback	m_pfnWrite;
+		void						*m_pUserData;
+
+		char		m_buffer[kMaxWriteSize];
+		int32_t		m_iBufferSize;
+		bool		m_bLineStarted;
+
+		uint32_t	m_iNumLines;
+		uint64_t	m_iNumBytes;
+		bool		m_bFailed;
+	};
+}}
+
+#endif // __SCE_LIBSLEDLUAPLUGIN_FOLDEDSTACKWRITER_H__
@@ -0,0 +1,205 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "gcstats.h"
+#include "../sleddebugger/assert.h"
+#include "../sleddebugger/errorcodes.h"
+#include "../sleddebugger/sequentialallocator.h"
+#include "../sleddebugger/timer.h"
+
+#include <new>
+#include <cstring>
+
+namespace sce { namespace Sled
+{
+	// 10 microseconds
+	const float GcPauseHistogram::kFirstBucketUpperBound = 0.00001f;
+
+	void GcPauseHistogram::clear()
+	{
+		std::memset(buckets, 0, sizeof(buckets));
+		count = 0;
+		total = 0.0f;
+		longest = 0.0f;
+	}
+
+	void GcPauseHistogram::add(float flPause)
+	{
+		uint16_t iBucket = 0;
+		float flBound = kFirstBucketUpperBound;
+
+		while ((iBucket < (kNumBuckets - 1)) && (flPause >= flBound))
+		{
+			++iBucket;
+			flBound *= 2.0f;
+		}
+
+		buckets[iBucket]++;
+		count++;
+		total += flPause;
+
+		if (flPause > longest)
+			longest = flPause;
+	}
+
+	float GcPauseHistogram::getBucketUpperBound(uint16_t iBucket)
+	{
+		SCE_SLED_ASSERT(iBucket < kNumBuckets);
+
+		float flBound = kFirstBucketUpperBound;
+		for (uint16_t i = 0; i < iBucket; i++)
+			flBound *= 2.0f;
+
+		return flBound;
+	}
+
+	namespace
+	{
+		struct GcStatsSeats
+		{
+			void *m_this;
+			void *m_stepTimer;
+			void *m_atomicTimer;
+
+			void Allocate(ISequentialAllocator *pAllocator)
+			{
+				// For this
+				m_this = pAllocator->allocate(sizeof(GcStats), __alignof(GcStats));
+
+				// For m_pStepTimer
+				Timer::requiredMemoryHelper(pAllocator, &m_stepTimer);
+
+				// For m_pAtomicTimer
+				Timer::requiredMemoryHelper(pAllocator, &m_atomicTimer);
+			}
+		};
+	}
+
+	int32_t GcStats::create(void *pLocation, GcStats **ppStats)
+	{
+		SCE_SLED_ASSERT(pLocation != NULL);
+		SCE_SLED_ASSERT(ppStats != NULL);
+
+		std::size_t iMemSize = 0;
+
+		const int32_t iError = requiredMemory(&iMemSize);
+		if (iError != 0)
+			return iError;
+
+		SequentialAllocator allocator(pLocation, iMemSize);
+
+		GcStatsSeats seats;
+		seats.Allocate(&allocator);
+
+		SCE_SLED_ASSERT(seats.m_this != NULL);
+		SCE_SLED_ASSERT(seats.m_stepTimer != NULL);
+		SCE_SLED_ASSERT(seats.m_atomicTimer != NULL);
+
+		*ppStats = new (seats.m_this) GcStats(&seats);
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t GcStats::requiredMemory(std::size_t *iRequiredMemory)
+	{
+		SCE_SLED_ASSERT(iRequiredMemory != NULL);
+
+		SequentialAllocatorCalculator allocator;
+
+		GcStatsSeats seats;
+		seats.Allocate(&allocator);
+
+		*iRequiredMemory = allocator.bytesAllocated();
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t GcStats::requiredMemoryHelper(ISequentialAllocator *pAllocator, void **ppThis)
+	{
+		SCE_SLED_ASSERT(pAllocator != NULL);
+		SCE_SLED_ASSERT(ppThis != NULL);
+
+		GcStatsSeats seats;
+		seats.Allocate(pAllocator);
+
+		*ppThis = seats.m_this;
+		return SCE_SLED_ERROR_OK;
+	}
+
+	void GcStats::shutdown(GcStats *pStats)
+	{
+		SCE_SLED_ASSERT(pStats != NULL);
+		pStats->~GcStats();
+	}
+
+	GcStats::GcStats(const void *pStatsSeats)
+		: m_iStepDepth(0)
+		, m_bInAtomic(false)
+		, m_iNumCycles(0)
+		, m_iBytesSwept(0)
+		, m_iBytesInUse(0)
+	{
+		SCE_SLED_ASSERT(pStatsSeats != NULL);
+
+		const GcStatsSeats *pSeats = static_cast<const GcStatsSeats*>(pStatsSeats);
+
+		Timer::create(pSeats->m_stepTimer, &m_pStepTimer);
+		Timer::create(pSeats->m_atomicTimer, &m_pAtomicTimer);
+	}
+
+	void GcStats::clear()
+	{
+		m_stepPauses.clear();
+		m_atomicPauses.clear();
+
+		m_iStepDepth = 0;
+		m_bInAtomic = false;
+
+		m_iNumCycles = 0;
+		m_iBytesSwept = 0;
+		m_iBytesInUse = 0;
+	}
+
+	void GcStats::stepBegin()
+	{
+		// Only time the outermost step
+		if (m_iStepDepth++ == 0)
+			m_pStepTimer->reset();
+	}
+
+	void GcStats::stepEnd()
+	{
+		// Started before the stats were cleared
+		if (m_iStepDepth == 0)
+			return;
+
+		if (--m_iStepDepth == 0)
+			m_stepPauses.add(m_pStepTimer->elapsed());
+	}
+
+	void GcStats::atomicBegin()
+	{
+		m_bInAtomic = true;
+		m_pAtomicTimer->reset();
+	}
+
+	void GcStats::atomicEnd()
+	{
+		if (!m_bInAtomic)
+			return;
+
+		m_bInAtomic = false;
+		m_atomicPauses.add(m_pAtomicTimer->elapsed());
+	}
+
+	void GcStats::swept(std::size_t iBytes)
+	{
+		m_iBytesSwept += iBytes;
+	}
+
+	void GcStats::cycleEnd(std::size_t iBytesInUse)
+	{
+		m_iNumCycles++;
+		m_iBytesInUse = iBytesInUse;
+	}
+}}
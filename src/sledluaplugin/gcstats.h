@@ -0,0 +1,85 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#ifndef __SCE_LIBSLEDLUAPLUGIN_GCSTATS_H__
+#define __SCE_LIBSLEDLUAPLUGIN_GCSTATS_H__
+
+#include "../sledcore/base_types.h"
+#include <cstddef>
+
+#include "../sleddebugger/common.h"
+
+namespace sce { namespace Sled
+{
+	// Forward declarations
+	class Timer;
+	class ISequentialAllocator;
+
+	struct SCE_SLED_LINKAGE GcPauseHistogram
+	{
+		// Bucket 0 holds pauses under kFirstBucketUpperBound seconds and each
+		// following bucket doubles the bound; the last bucket is unbounded
+		static const uint16_t kNumBuckets = 16;
+		static const float kFirstBucketUpperBound;
+
+		GcPauseHistogram() { clear(); }
+
+		void clear();
+		void add(float flPause);
+
+		static float getBucketUpperBound(uint16_t iBucket);
+
+		uint32_t	buckets[kNumBuckets];
+		uint32_t	count;
+		float		total;
+		float		longest;
+	};
+
+	class SCE_SLED_LINKAGE GcStats
+	{
+	public:
+		static int32_t create(void *pLocation, GcStats **ppStats);
+		static int32_t requiredMemory(std::size_t *iRequiredMemory);
+		static int32_t requiredMemoryHelper(ISequentialAllocator *pAllocator, void **ppThis);
+		static void shutdown(GcStats *pStats);
+	private:
+		GcStats(const void *pStatsSeats);
+		~GcStats() {}
+		GcStats(const GcStats&);
+		GcStats& operator=(const GcStats&);
+	public:
+		void clear();
+
+		void stepBegin();
+		void stepEnd();
+		void atomicBegin();
+		void atomicEnd();
+		void swept(std::size_t iBytes);
+		void cycleEnd(std::size_t iBytesInUse);
+
+		inline bool hasData() const									{ return m_stepPauses.count != 0; }
+		inline const GcPauseHistogram& getStepPauses() const		{ return m_stepPauses; }
+		inline const GcPauseHistogram& getAtomicPauses() const		{ return m_atomicPauses; }
+		inline uint32_t getNumCycles() const						{ return m_iNumCycles; }
+		inline uint64_t getBytesSwept() const						{ return m_iBytesSwept; }
+		inline uint64_t getBytesInUse() const						{ return m_iBytesInUse; }
+	private:
+		GcPauseHistogram	m_stepPauses;
+		GcPauseHistogram	m_atomicPauses;
+
+		// Full collections can run from inside a step
+		uint16_t			m_iStepDepth;
+		bool				m_bInAtomic;
+
+		uint32_t			m_iNumCycles;
+		uint64_t			m_iBytesSwept;
+		uint64_t			m_iBytesInUse;
+
+		Timer*				m_pStepTimer;
+		Timer*				m_pAtomicTimer;
+	};
+}}
+
+#endif // __SCE_LIBSLEDLUAPLUGIN_GCSTATS_H__
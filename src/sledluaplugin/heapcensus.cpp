@@ -0,0 +1,435 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "heapcensus.h"
+#include "sledluaplugin.h"
+#include "../sleddebugger/assert.h"
+#include "../sleddebugger/errorcodes.h"
+#include "../sleddebugger/sequentialallocator.h"
+#include "../sleddebugger/timer.h"
+#include "../sleddebugger/utilities.h"
+
+#include <new>
+#include <cstring>
+
+namespace sce { namespace Sled
+{
+	void HeapCensusConfig::init(const HeapCensusConfig& rhs)
+	{
+		maxObjects = rhs.maxObjects;
+		maxTables = rhs.maxTables;
+		maxRoots = rhs.maxRoots;
+		maxDepth = rhs.maxDepth;
+		timeBudget = rhs.timeBudget;
+	}
+
+	HeapCensusConfig::HeapCensusConfig(const LuaPluginConfig *pConfig)
+	{
+		SCE_SLED_ASSERT(pConfig != NULL);
+
+		maxObjects = pConfig->maxHeapCensusObjects;
+		maxTables = pConfig->maxHeapCensusTables;
+		maxRoots = pConfig->maxHeapCensusRoots;
+		maxDepth = pConfig->maxHeapCensusDepth;
+		timeBudget = (float)pConfig->heapCensusTimeBudgetMs / 1000.0f;
+	}
+
+	namespace
+	{
+		// How many newly visited objects between checks of the time budget
+		const uint32_t kTimerCheckInterval = 64;
+
+		// Largest object budget that still lets the visited set size fit in 32 bits
+		const uint32_t kMaxObjectsLimit = 0x40000000;
+
+		inline uint32_t VisitedSetSize(uint32_t iMaxObjects)
+		{
+			if (iMaxObjects == 0)
+				return 0;
+
+			// Power of two with at least half the slots free when full
+			uint32_t iSize = 1;
+			while (iSize < (iMaxObjects * 2))
+				iSize <<= 1;
+
+			return iSize;
+		}
+
+		inline uint32_t VisitedSetHash(const void *pObject)
+		{
+			const uintptr_t iPtr = reinterpret_cast<uintptr_t>(pObject);
+			return (uint32_t)((iPtr >> 3) ^ (iPtr >> 17)) * 2654435761u;
+		}
+
+		inline std::size_t CeilPowerOfTwo(uint32_t iCount)
+		{
+			std::size_t iSize = 1;
+			while (iSize < iCount)
+				iSize <<= 1;
+
+			return iSize;
+		}
+
+		struct HeapCensusSeats
+		{
+			void *m_this;
+			void *m_visited;
+			void *m_visitedDepths;
+			void *m_tables;
+			void *m_roots;
+			void *m_timer;
+
+			void Allocate(const HeapCensusConfig& censusConfig, ISequentialAllocator *pAllocator)
+			{
+				// For this
+				m_this = pAllocator->allocate(sizeof(HeapCensus), __alignof(HeapCensus));
+
+				// For m_ppVisited
+				m_visited = pAllocator->allocate(sizeof(const void*) * VisitedSetSize(censusConfig.maxObjects), __alignof(const void*));
+
+				// For m_pVisitedDepths
+				m_visitedDepths = pAllocator->allocate(sizeof(uint16_t) * VisitedSetSize(censusConfig.maxObjects), __alignof(uint16_t));
+
+				// For m_pTables
+				m_tables = pAllocator->allocate(sizeof(HeapCensusTableEntry) * censusConfig.maxTables, __alignof(HeapCensusTableEntry));
+
+				// For m_pRoots
+				m_roots = pAllocator->allocate(sizeof(HeapCensusRootEntry) * censusConfig.maxRoots, __alignof(HeapCensusRootEntry));
+
+				// For m_pTimer
+				Timer::requiredMemoryHelper(pAllocator, &m_timer);
+			}
+		};
+
+		inline int32_t ValidateConfig(const HeapCensusConfig& config)
+		{
+			if (config.maxObjects > kMaxObjectsLimit)
+				return SCE_SLED_ERROR_INVALIDCONFIGURATION;
+
+			if ((config.maxObjects != 0) && (config.maxDepth == 0))
+				return SCE_SLED_ERROR_INVALIDCONFIGURATION;
+
+			if (config.timeBudget < 0.0f)
+				return SCE_SLED_ERROR_INVALIDCONFIGURATION;
+
+			return SCE_SLED_ERROR_OK;
+		}
+	}
+
+	int32_t HeapCensus::create(const HeapCensusConfig& censusConfig, void *pLocation, HeapCensus **ppCensus)
+	{
+		SCE_SLED_ASSERT(pLocation != NULL);
+		SCE_SLED_ASSERT(ppCensus != NULL);
+
+		std::size_t iMemSize = 0;
+
+		const int32_t iConfigError = requiredMemory(censusConfig, &iMemSize);
+		if (iConfigError != 0)
+			return iConfigError;
+
+		SequentialAllocator allocator(pLocation, iMemSize);
+
+		HeapCensusSeats seats;
+		seats.Allocate(censusConfig, &allocator);
+
+		SCE_SLED_ASSERT(seats.m_this != NULL);
+		SCE_SLED_ASSERT(seats.m_visited != NULL);
+		SCE_SLED_ASSERT(seats.m_tables != NULL);
+		SCE_SLED_ASSERT(seats.m_roots != NULL);
+		SCE_SLED_ASSERT(seats.m_timer != NULL);
+
+		*ppCensus = new (seats.m_this) HeapCensus(censusConfig, &seats);
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t HeapCensus::requiredMemory(const HeapCensusConfig& censusConfig, std::size_t *iRequiredMemory)
+	{
+		SCE_SLED_ASSERT(iRequiredMemory != NULL);
+
+		const int32_t iConfigError = ValidateConfig(censusConfig);
+		if (iConfigError != 0)
+			return iConfigError;
+
+		SequentialAllocatorCalculator allocator;
+
+		HeapCensusSeats seats;
+		seats.Allocate(censusConfig, &allocator);
+
+		*iRequiredMemory = allocator.bytesAllocated();
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t HeapCensus::requiredMemoryHelper(const HeapCensusConfig& censusConfig, ISequentialAllocator *pAllocator, void **ppThis)
+	{
+		SCE_SLED_ASSERT(pAllocator != NULL);
+		SCE_SLED_ASSERT(ppThis != NULL);
+
+		const int32_t iConfigError = ValidateConfig(censusConfig);
+		if (iConfigError != 0)
+			return iConfigError;
+
+		HeapCensusSeats seats;
+		seats.Allocate(censusConfig, pAllocator);
+
+		*ppThis = seats.m_this;
+		return SCE_SLED_ERROR_OK;
+	}
+
+	void HeapCensus::shutdown(HeapCensus *pCensus)
+	{
+		SCE_SLED_ASSERT(pCensus != NULL);
+		pCensus->~HeapCensus();
+	}
+
+	HeapCensus::HeapCensus(const HeapCensusConfig& censusConfig, const void *pCensusSeats)
+		: m_iMaxObjects(censusConfig.maxObjects)
+		, m_iNumObjects(0)
+		, m_iVisitedSize(VisitedSetSize(censusConfig.maxObjects))
+		, m_iMaxTables(censusConfig.maxTables)
+		, m_iNumTables(0)
+		, m_iMaxRoots(censusConfig.maxRoots)
+		, m_iNumRoots(0)
+		, m_iMaxDepth(censusConfig.maxDepth)
+		, m_iTotalBytes(0)
+		, m_bInRoot(false)
+		, m_bTruncated(false)
+		, m_flTimeBudget(censusConfig.timeBudget)
+		, m_flElapsed(0.0f)
+	{
+		SCE_SLED_ASSERT(pCensusSeats != NULL);
+
+		const HeapCensusSeats *pSeats = static_cast<const HeapCensusSeats*>(pCensusSeats);
+
+		m_ppVisited = new (pSeats->m_visited) const void*[m_iVisitedSize];
+		m_pVisitedDepths = new (pSeats->m_visitedDepths) uint16_t[m_iVisitedSize];
+		m_pTables = new (pSeats->m_tables) HeapCensusTableEntry[censusConfig.maxTables];
+		m_pRoots = new (pSeats->m_roots) HeapCensusRootEntry[censusConfig.maxRoots];
+
+		Timer::create(pSeats->m_timer, &m_pTimer);
+
+		std::memset(m_iTypeCounts, 0, sizeof(m_iTypeCounts));
+		std::memset(m_iTypeBytes, 0, sizeof(m_iTypeBytes));
+		std::memset(&m_curRoot, 0, sizeof(HeapCensusRootEntry));
+	}
+
+	std::size_t HeapCensus::estimateStringBytes(std::size_t iLen)
+	{
+		// TString header plus the characters and terminator
+		return (sizeof(void*) * 3) + iLen + 1;
+	}
+
+	std::size_t HeapCensus::estimateTableBytes(uint32_t iArrayCount, uint32_t iHashCount)
+	{
+		// Table header, array part of TValues and hash part of Nodes; both parts
+		// are sized to powers of two by the VM
+		const std::size_t iTValue = sizeof(double) * 2;
+		const std::size_t iNode = (iTValue * 2) + sizeof(void*);
+
+		std::size_t iBytes = sizeof(void*) * 8;
+
+		if (iArrayCount > 0)
+			iBytes += CeilPowerOfTwo(iArrayCount) * iTValue;
+
+		if (iHashCount > 0)
+			iBytes += CeilPowerOfTwo(iHashCount) * iNode;
+
+		return iBytes;
+	}
+
+	std::size_t HeapCensus::estimateUserDataBytes(std::size_t iLen)
+	{
+		// Udata header plus the block itself
+		return (sizeof(void*) * 5) + iLen;
+	}
+
+	std::size_t HeapCensus::estimateClosureBytes(int32_t iNumUpvalues, bool bLuaFunction)
+	{
+		// Lua closures hold pointers to UpVal objects while C closures hold the values
+		const std::size_t iUpvalue = bLuaFunction ? (sizeof(void*) * 5) : (sizeof(double) * 2);
+		return (sizeof(void*) * 5) + ((std::size_t)iNumUpvalues * iUpvalue);
+	}
+
+	std::size_t HeapCensus::estimateThreadBytes()
+	{
+		// lua_State plus the default stack and CallInfo allocations
+		return (sizeof(void*) * 24) + (sizeof(double) * 2 * 45) + (sizeof(void*) * 8 * 8);
+	}
+
+	void HeapCensus::begin()
+	{
+		if (m_iVisitedSize != 0)
+			std::memset(m_ppVisited, 0, sizeof(const void*) * m_iVisitedSize);
+
+		m_iNumObjects = 0;
+		m_iNumTables = 0;
+		m_iNumRoots = 0;
+		m_iTotalBytes = 0;
+
+		std::memset(m_iTypeCounts, 0, sizeof(m_iTypeCounts));
+		std::memset(m_iTypeBytes, 0, sizeof(m_iTypeBytes));
+
+		m_bInRoot = false;
+		m_bTruncated = false;
+		m_flElapsed = 0.0f;
+
+		m_pTimer->reset();
+	}
+
+	void HeapCensus::end()
+	{
+		if (m_bInRoot)
+			endRoot();
+
+		m_flElapsed = m_pTimer->elapsed();
+	}
+
+	HeapCensus::Visit HeapCensus::visit(const void *pObject, uint16_t iDepth)
+	{
+		if (m_bTruncated || (pObject == NULL) || (m_iVisitedSize == 0))
+			return kVisitSkip;
+
+		const uint32_t iMask = m_iVisitedSize - 1;
+		uint32_t iSlot = VisitedSetHash(pObject) & iMask;
+
+		// Linear probe; the set is never more than half full so this terminates
+		while (m_ppVisited[iSlot] != NULL)
+		{
+			if (m_ppVisited[iSlot] == pObject)
+			{
+				// Reached closer to a root than before, so what it references
+				// may now be within the depth limit where it wasn't
+				if ((iDepth >= m_pVisitedDepths[iSlot]) || (iDepth >= m_iMaxDepth))
+					return kVisitSkip;
+
+				m_pVisitedDepths[iSlot] = iDepth;
+				return kVisitAgain;
+			}
+
+			iSlot = (iSlot + 1) & iMask;
+		}
+
+		// Object budget used up
+		if (m_iNumObjects == m_iMaxObjects)
+		{
+			m_bTruncated = true;
+			return kVisitSkip;
+		}
+
+		m_ppVisited[iSlot] = pObject;
+		m_pVisitedDepths[iSlot] = iDepth;
+		++m_iNumObjects;
+
+		// Time budget used up
+		if ((m_flTimeBudget > 0.0f) && ((m_iNumObjects % kTimerCheckInterval) == 0))
+		{
+			if (m_pTimer->elapsed() > m_flTimeBudget)
+				m_bTruncated = true;
+		}
+
+		return kVisitNew;
+	}
+
+	void HeapCensus::addObject(int32_t iLuaType, std::size_t iBytes)
+	{
+		if ((iLuaType < 0) || (iLuaType >= kNumLuaTypes))
+			return;
+
+		m_iTypeCounts[iLuaType]++;
+		m_iTypeBytes[iLuaType] += iBytes;
+		m_iTotalBytes += iBytes;
+
+		if (m_bInRoot)
+		{
+			m_curRoot.objects++;
+			m_curRoot.bytes += iBytes;
+		}
+	}
+
+	void HeapCensus::addTable(const void *pTable, uint32_t iArrayCount, uint32_t iHashCount, std::size_t iBytes)
+	{
+		if (m_iMaxTables == 0)
+			return;
+
+		// Smaller than everything already kept
+		if ((m_iNumTables == m_iMaxTables) && (iBytes <= m_pTables[m_iNumTables - 1].bytes))
+			return;
+
+		// Kept sorted largest first
+		uint16_t iPos = (m_iNumTables == m_iMaxTables) ? (uint16_t)(m_iNumTables - 1) : m_iNumTables;
+		while ((iPos > 0) && (m_pTables[iPos - 1].bytes < iBytes))
+		{
+			m_pTables[iPos] = m_pTables[iPos - 1];
+			--iPos;
+		}
+
+		HeapCensusTableEntry& entry = m_pTables[iPos];
+		entry.table = pTable;
+		entry.arrayCount = iArrayCount;
+		entry.hashCount = iHashCount;
+		entry.bytes = (uint32_t)iBytes;
+		Utilities::copyString(entry.root, HeapCensusTableEntry::kNameLen, m_bInRoot ? m_curRoot.name : "");
+
+		if (m_iNumTables < m_iMaxTables)
+			++m_iNumTables;
+	}
+
+	void HeapCensus::beginRoot(const char *pszName)
+	{
+		SCE_SLED_ASSERT(pszName != NULL);
+
+		if (m_bInRoot)
+			endRoot();
+
+		Utilities::copyString(m_curRoot.name, HeapCensusRootEntry::kNameLen, pszName);
+		m_curRoot.objects = 0;
+		m_curRoot.bytes = 0;
+		m_bInRoot = true;
+	}
+
+	void HeapCensus::endRoot()
+	{
+		if (!m_bInRoot)
+			return;
+
+		m_bInRoot = false;
+
+		// Nothing retained that wasn't already reached through an earlier root
+		if ((m_iMaxRoots == 0) || (m_curRoot.objects == 0))
+			return;
+
+		if ((m_iNumRoots == m_iMaxRoots) && (m_curRoot.bytes <= m_pRoots[m_iNumRoots - 1].bytes))
+			return;
+
+		// Kept sorted largest first
+		uint16_t iPos = (m_iNumRoots == m_iMaxRoots) ? (uint16_t)(m_iNumRoots - 1) : m_iNumRoots;
+		while ((iPos > 0) && (m_pRoots[iPos - 1].bytes < m_curRoot.bytes))
+		{
+			m_pRoots[iPos] = m_pRoots[iPos - 1];
+			--iPos;
+		}
+
+		m_pRoots[iPos] = m_curRoot;
+
+		if (m_iNumRoots < m_iMaxRoots)
+			++m_iNumRoots;
+	}
+
+	void HeapCensus::getSummary(HeapCensusSummary *pSummary) const
+	{
+		SCE_SLED_ASSERT(pSummary != NULL);
+
+		pSummary->numObjects = m_iNumObjects;
+		pSummary->totalBytes = m_iTotalBytes;
+
+		for (int32_t i = 0; i < kNumLuaTypes; i++)
+		{
+			pSummary->typeCounts[i] = m_iTypeCounts[i];
+			pSummary->typeBytes[i] = m_iTypeBytes[i];
+		}
+
+		pSummary->elapsed = m_flElapsed;
+		pSummary->truncated = m_bTruncated;
+	}
+}}
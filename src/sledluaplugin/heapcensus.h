@@ -0,0 +1,148 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#ifndef __SCE_LIBSLEDLUAPLUGIN_HEAPCENSUS_H__
+#define __SCE_LIBSLEDLUAPLUGIN_HEAPCENSUS_H__
+
+#include "../sledcore/base_types.h"
+#include <cstddef>
+
+#include "../sleddebugger/common.h"
+
+namespace sce { namespace Sled
+{
+	// Forward declarations
+	class Timer;
+	class ISequentialAllocator;
+
+	// Forward declarations
+	struct LuaPluginConfig;
+	struct HeapCensusSummary;
+
+	struct SCE_SLED_LINKAGE HeapCensusTableEntry
+	{
+		static const uint16_t kNameLen = 64;
+
+		const void*		table;
+		uint32_t		arrayCount;
+		uint32_t		hashCount;
+		uint32_t		bytes;
+		char			root[kNameLen];
+	};
+
+	struct SCE_SLED_LINKAGE HeapCensusRootEntry
+	{
+		static const uint16_t kNameLen = 64;
+
+		char			name[kNameLen];
+		uint32_t		objects;
+		uint64_t		bytes;
+	};
+
+	struct SCE_SLED_LINKAGE HeapCensusConfig
+	{
+		HeapCensusConfig() : maxObjects(0), maxTables(0), maxRoots(0), maxDepth(0), timeBudget(0.0f) {}
+		HeapCensusConfig(const HeapCensusConfig& rhs) { init(rhs); }
+		HeapCensusConfig& operator=(const HeapCensusConfig& rhs) { init(rhs); return *this; }
+
+		HeapCensusConfig(const LuaPluginConfig *pConfig);
+
+	private:
+		void init(const HeapCensusConfig& rhs);
+	public:
+
+		uint32_t		maxObjects;		///< Maximum number of objects to visit (0 disables the census)
+		uint16_t		maxTables;		///< Number of largest tables to keep
+		uint16_t		maxRoots;		///< Number of largest global roots to keep
+		uint16_t		maxDepth;		///< Maximum nesting depth to follow
+		float			timeBudget;		///< Maximum time, in seconds, to spend walking (0 = no limit)
+	};
+
+	class SCE_SLED_LINKAGE HeapCensus
+	{
+	public:
+		static int32_t create(const HeapCensusConfig& censusConfig, void *pLocation, HeapCensus **ppCensus);
+		static int32_t requiredMemory(const HeapCensusConfig& censusConfig, std::size_t *iRequiredMemory);
+		static int32_t requiredMemoryHelper(const HeapCensusConfig& censusConfig, ISequentialAllocator *pAllocator, void **ppThis);
+		static void shutdown(HeapCensus *pCensus);
+	private:
+		HeapCensus(const HeapCensusConfig& censusConfig, const void *pCensusSeats);
+		~HeapCensus() {}
+		HeapCensus(const HeapCensus&);
+		HeapCensus& operator=(const HeapCensus&);
+	public:
+		// Approximate in-memory sizes of Lua objects. Only the public Lua API is
+		// available to the plugin so these are estimates, not exact figures.
+		static std::size_t estimateStringBytes(std::size_t iLen);
+		static std::size_t estimateTableBytes(uint32_t iArrayCount, uint32_t iHashCount);
+		static std::size_t estimateUserDataBytes(std::size_t iLen);
+		static std::size_t estimateClosureBytes(int32_t iNumUpvalues, bool bLuaFunction);
+		static std::size_t estimateThreadBytes();
+	public:
+		// What to do with an object reached by the walk
+		enum Visit
+		{
+			kVisitSkip,		// Already walked at the same or a shallower depth
+			kVisitNew,		// First time seen; count and walk it
+			kVisitAgain		// Seen deeper before; walk it again but don't count it
+		};
+
+		void begin();
+		void end();
+		Visit visit(const void *pObject, uint16_t iDepth);
+		void addObject(int32_t iLuaType, std::size_t iBytes);
+		void addTable(const void *pTable, uint32_t iArrayCount, uint32_t iHashCount, std::size_t iBytes);
+		void beginRoot(const char *pszName);
+		void endRoot();
+		void getSummary(HeapCensusSummary *pSummary) const;
+		inline void truncate()							{ m_bTruncated = true; }
+		inline bool isEnabled() const					{ return m_iMaxObjects != 0; }
+		inline bool isTruncated() const					{ return m_bTruncated; }
+		inline uint16_t getMaxDepth() const				{ return m_iMaxDepth; }
+		inline uint32_t getNumObjects() const			{ return m_iNumObjects; }
+		inline uint64_t getTotalBytes() const			{ return m_iTotalBytes; }
+		inline uint32_t getTypeCount(int32_t iLuaType) const	{ return m_iTypeCounts[iLuaType]; }
+		inline uint64_t getTypeBytes(int32_t iLuaType) const	{ return m_iTypeBytes[iLuaType]; }
+		inline float getElapsed() const					{ return m_flElapsed; }
+		inline uint16_t getNumTables() const			{ return m_iNumTables; }
+		inline const HeapCensusTableEntry *getTable(uint16_t iIndex) const	{ return (iIndex < m_iNumTables) ? &m_pTables[iIndex] : 0; }
+		inline uint16_t getNumRoots() const				{ return m_iNumRoots; }
+		inline const HeapCensusRootEntry *getRoot(uint16_t iIndex) const		{ return (iIndex < m_iNumRoots) ? &m_pRoots[iIndex] : 0; }
+	public:
+		static const int32_t kNumLuaTypes = 9;
+	private:
+		const uint32_t			m_iMaxObjects;
+		uint32_t				m_iNumObjects;
+		const uint32_t			m_iVisitedSize;
+		const void**			m_ppVisited;
+		// Shallowest depth each m_ppVisited object was reached at
+		uint16_t*				m_pVisitedDepths;
+
+		const uint16_t			m_iMaxTables;
+		uint16_t				m_iNumTables;
+		HeapCensusTableEntry*	m_pTables;
+
+		const uint16_t			m_iMaxRoots;
+		uint16_t				m_iNumRoots;
+		HeapCensusRootEntry*	m_pRoots;
+
+		const uint16_t			m_iMaxDepth;
+
+		uint32_t				m_iTypeCounts[kNumLuaTypes];
+		uint64_t				m_iTypeBytes[kNumLuaTypes];
+		uint64_t				m_iTotalBytes;
+
+		// Root currently being walked
+		bool					m_bInRoot;
+		HeapCensusRootEntry		m_curRoot;
+
+		bool					m_bTruncated;
+		const float				m_flTimeBudget;
+		float					m_flElapsed;
+		Timer*					m_pTimer;
+	};
+}}
+
+#endif // __SCE_LIBSLEDLUAPLUGIN_HEAPCENSUS_H__
@@ -24,6 +24,8 @@ sdk_project "libsce_sledluaplugin-5.1.4"
 
 	files {		
 		"errorcodes.h",
+		"gcstats.*",
+		"heapcensus.*",
 		"luautils.h",
 		"luautils_5.1.4.cpp",
 		"luautils_common.cpp",
@@ -36,6 +38,7 @@ sdk_project "libsce_sledluaplugin-5.1.4"
 		"sledluaplugin_class.h",		
 		"sledluaplugin_class_5.1.4.cpp",
 		"varfilter.*",
+		"varsnapshot.*",
 		"../sledcore/*.h",
 		"../sledcore/windows/*.h"
 	}
@@ -24,6 +24,8 @@ sdk_project "libsce_sledluaplugin-5.2.3"
 
 	files {		
 		"errorcodes.h",
+		"gcstats.*",
+		"heapcensus.*",
 		"luautils.h",
 		"luautils_5.2.3.cpp",
 		"luautils_common.cpp",
@@ -0,0 +1,563 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "numberformat.h"
+#include "../sleddebugger/assert.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace sce { namespace Sled
+{
+	namespace
+	{
+		const char s_digitPairs[] =
+			"00010203040506070809"
+			"10111213141516171819"
+			"20212223242526272829"
+			"30313233343536373839"
+			"40414243444546474849"
+			"50515253545556575859"
+			"60616263646566676869"
+			"70717273747576777879"
+			"80818283848586878889"
+			"90919293949596979899";
+
+		const char s_hexDigits[] = "0123456789ABCDEF";
+
+		inline std::size_t CopyOut(char *pszBuffer, std::size_t len, const char *pszText, std::size_t textLen)
+		{
+			SCE_SLED_ASSERT(pszBuffer != NULL);
+
+			if (len == 0)
+				return 0;
+
+			const std::size_t iCopyLen = (textLen < len) ? textLen : (len - 1);
+			std::memcpy(pszBuffer, pszText, iCopyLen);
+			pszBuffer[iCopyLen] = '\0';
+			return iCopyLen;
+		}
+
+		inline char *WriteDigitPair(char *pEnd, uint32_t value)
+		{
+			*--pEnd = s_digitPairs[(value * 2) + 1];
+			*--pEnd = s_digitPairs[value * 2];
+			return pEnd;
+		}
+
+		// Writes the digits of value so they end just before pEnd and
+		// returns where they start
+		char *WriteUnsignedBackwards(char *pEnd, uint64_t value)
+		{
+			char *p = pEnd;
+
+			// 64 bit division is a library call on 32 bit targets so only
+			// use it for the digits that need it
+			while (value > 0xFFFFFFFFULL)
+			{
+				const uint32_t iRemainder = (uint32_t)(value % 100);
+				value /= 100;
+				p = WriteDigitPair(p, iRemainder);
+			}
+
+			uint32_t iValue = (uint32_t)value;
+			while (iValue >= 100)
+			{
+				const uint32_t iRemainder = iValue % 100;
+				iValue /= 100;
+				p = WriteDigitPair(p, iRemainder);
+			}
+
+			if (iValue >= 10)
+				p = WriteDigitPair(p, iValue);
+			else
+				*--p = (char)('0' + iValue);
+
+			return p;
+		}
+
+		// Shortest round trip digit generation is Grisu3 (Loitsch, "Printing
+		// Floating-Point Numbers Quickly and Accurately with Integers"). It
+		// proves its result for the vast majority of doubles; the rest go
+		// through a slower printf/strtod search.
+		struct DiyFp
+		{
+			DiyFp() : f(0), e(0) {}
+			DiyFp(uint64_t f_, int e_) : f(f_), e(e_) {}
+
+			uint64_t	f;
+			int			e;
+		};
+
+		struct CachedPower
+		{
+			uint64_t	f;
+			int16_t		e;
+			int16_t		k;
+		};
+
+		// Normalized 10^k for k = -348, -340, ..., 340
+		const CachedPower s_cachedPowers[] =
+		{
+			{ 0xFA8FD5A0081C0288ULL, -1220, -348 },
+			{ 0xBAAEE17FA23EBF76ULL, -1193, -340 },
+			{ 0x8B16FB203055AC76ULL, -1166, -332 },
+			{ 0xCF42894A5DCE35EAULL, -1140, -324 },
+			{ 0x9A6BB0AA55653B2DULL, -1113, -316 },
+			{ 0xE61ACF033D1A45DFULL, -1087, -308 },
+			{ 0xAB70FE17C79AC6CAULL, -1060, -300 },
+			{ 0xFF77B1FCBEBCDC4FULL, -1034, -292 },
+			{ 0xBE5691EF416BD60CULL, -1007, -284 },
+			{ 0x8DD01FAD907FFC3CULL, -980, -276 },
+			{ 0xD3515C2831559A83ULL, -954, -268 },
+			{ 0x9D71AC8FADA6C9B5ULL, -927, -260 },
+			{ 0xEA9C227723EE8BCBULL, -901, -252 },
+			{ 0xAECC49914078536DULL, -874, -244 },
+			{ 0x823C12795DB6CE57ULL, -847, -236 },
+			{ 0xC21094364DFB5637ULL, -821, -228 },
+			{ 0x9096EA6F3848984FULL, -794, -220 },
+			{ 0xD77485CB25823AC7ULL, -768, -212 },
+			{ 0xA086CFCD97BF97F4ULL, -741, -204 },
+			{ 0xEF340A98172AACE5ULL, -715, -196 },
+			{ 0xB23867FB2A35B28EULL, -688, -188 },
+			{ 0x84C8D4DFD2C63F3BULL, -661, -180 },
+			{ 0xC5DD44271AD3CDBAULL, -635, -172 },
+			{ 0x936B9FCEBB25C996ULL, -608, -164 },
+			{ 0xDBAC6C247D62A584ULL, -582, -156 },
+			{ 0xA3AB66580D5FDAF6ULL, -555, -148 },
+			{ 0xF3E2F893DEC3F126ULL, -529, -140 },
+			{ 0xB5B5ADA8AAFF80B8ULL, -502, -132 },
+			{ 0x87625F056C7C4A8BULL, -475, -124 },
+			{ 0xC9BCFF6034C13053ULL, -449, -116 },
+			{ 0x964E858C91BA2655ULL, -422, -108 },
+			{ 0xDFF9772470297EBDULL, -396, -100 },
+			{ 0xA6DFBD9FB8E5B88FULL, -369, -92 },
+			{ 0xF8A95FCF88747D94ULL, -343, -84 },
+			{ 0xB94470938FA89BCFULL, -316, -76 },
+			{ 0x8A08F0F8BF0F156BULL, -289, -68 },
+			{ 0xCDB02555653131B6ULL, -263, -60 },
+			{ 0x993FE2C6D07B7FACULL, -236, -52 },
+			{ 0xE45C10C42A2B3B06ULL, -210, -44 },
+			{ 0xAA242499697392D3ULL, -183, -36 },
+			{ 0xFD87B5F28300CA0EULL, -157, -28 },
+			{ 0xBCE5086492111AEBULL, -130, -20 },
+			{ 0x8CBCCC096F5088CCULL, -103, -12 },
+			{ 0xD1B71758E219652CULL, -77, -4 },
+			{ 0x9C40000000000000ULL, -50, 4 },
+			{ 0xE8D4A51000000000ULL, -24, 12 },
+			{ 0xAD78EBC5AC620000ULL, 3, 20 },
+			{ 0x813F3978F8940984ULL, 30, 28 },
+			{ 0xC097CE7BC90715B3ULL, 56, 36 },
+			{ 0x8F7E32CE7BEA5C70ULL, 83, 44 },
+			{ 0xD5D238A4ABE98068ULL, 109, 52 },
+			{ 0x9F4F2726179A2245ULL, 136, 60 },
+			{ 0xED63A231D4C4FB27ULL, 162, 68 },
+			{ 0xB0DE65388CC8ADA8ULL, 189, 76 },
+			{ 0x83C7088E1AAB65DBULL, 216, 84 },
+			{ 0xC45D1DF942711D9AULL, 242, 92 },
+			{ 0x924D692CA61BE758ULL, 269, 100 },
+			{ 0xDA01EE641A708DEAULL, 295, 108 },
+			{ 0xA26DA3999AEF774AULL, 322, 116 },
+			{ 0xF209787BB47D6B85ULL, 348, 124 },
+			{ 0xB454E4A179DD1877ULL, 375, 132 },
+			{ 0x865B86925B9BC5C2ULL, 402, 140 },
+			{ 0xC83553C5C8965D3DULL, 428, 148 },
+			{ 0x952AB45CFA97A0B3ULL, 455, 156 },
+			{ 0xDE469FBD99A05FE3ULL, 481, 164 },
+			{ 0xA59BC234DB398C25ULL, 508, 172 },
+			{ 0xF6C69A72A3989F5CULL, 534, 180 },
+			{ 0xB7DCBF5354E9BECEULL, 561, 188 },
+			{ 0x88FCF317F22241E2ULL, 588, 196 },
+			{ 0xCC20CE9BD35C78A5ULL, 614, 204 },
+			{ 0x98165AF37B2153DFULL, 641, 212 },
+			{ 0xE2A0B5DC971F303AULL, 667, 220 },
+			{ 0xA8D9D1535CE3B396ULL, 694, 228 },
+			{ 0xFB9B7CD9A4A7443CULL, 720, 236 },
+			{ 0xBB764C4CA7A44410ULL, 747, 244 },
+			{ 0x8BAB8EEFB6409C1AULL, 774, 252 },
+			{ 0xD01FEF10A657842CULL, 800, 260 },
+			{ 0x9B10A4E5E9913129ULL, 827, 268 },
+			{ 0xE7109BFBA19C0C9DULL, 853, 276 },
+			{ 0xAC2820D9623BF429ULL, 880, 284 },
+			{ 0x80444B5E7AA7CF85ULL, 907, 292 },
+			{ 0xBF21E44003ACDD2DULL, 933, 300 },
+			{ 0x8E679C2F5E44FF8FULL, 960, 308 },
+			{ 0xD433179D9C8CB841ULL, 986, 316 },
+			{ 0x9E19DB92B4E31BA9ULL, 1013, 324 },
+			{ 0xEB96BF6EBADF77D9ULL, 1039, 332 },
+			{ 0xAF87023B9BF0EE6BULL, 1066, 340 },
+		};
+
+		const int kCachedPowersOffset = 348;
+		const int kCachedPowersStep = 8;
+
+		// Window the scaled value's binary exponent has to land in for
+		// digit generation to work on 32 bit integral parts
+		const int kMinimalTargetExponent = -60;
+		const int kMaximalTargetExponent = -32;
+
+		const uint64_t kSignificandMask = 0x000FFFFFFFFFFFFFULL;
+		const uint64_t kHiddenBit = 0x0010000000000000ULL;
+		const int kExponentBias = 0x3FF + 52;
+		const int kDenormalExponent = 1 - kExponentBias;
+
+		const int kMaxDigits = 17;
+
+		inline DiyFp Multiply(const DiyFp& x, const DiyFp& y)
+		{
+			// 64x64 -> upper 64 bits of the product, rounded
+			const uint64_t kMask32 = 0xFFFFFFFFULL;
+			const uint64_t a = x.f >> 32;
+			const uint64_t b = x.f & kMask32;
+			const uint64_t c = y.f >> 32;
+			const uint64_t d = y.f & kMask32;
+
+			const uint64_t ac = a * c;
+			const uint64_t bc = b * c;
+			const uint64_t ad = a * d;
+			const uint64_t bd = b * d;
+
+			uint64_t tmp = (bd >> 32) + (ad & kMask32) + (bc & kMask32);
+			tmp += 1U << 31;
+
+			return DiyFp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), x.e + y.e + 64);
+		}
+
+		inline DiyFp Normalize(DiyFp x)
+		{
+			SCE_SLED_ASSERT(x.f != 0);
+
+			while ((x.f & 0xFFC0000000000000ULL) == 0)
+			{
+				x.f <<= 10;
+				x.e -= 10;
+			}
+
+			while ((x.f & 0x8000000000000000ULL) == 0)
+			{
+				x.f <<= 1;
+				x.e -= 1;
+			}
+
+			return x;
+		}
+
+		bool RoundWeed(char *pDigits, int iLength, uint64_t distanceTooHighW, uint64_t unsafeInterval, uint64_t rest, uint64_t tenKappa, uint64_t unit)
+		{
+			const uint64_t smallDistance = distanceTooHighW - unit;
+			const uint64_t bigDistance = distanceTooHighW + unit;
+
+			// Move the last digit down while that gets closer to the real value
+			while ((rest < smallDistance) &&
+				   ((unsafeInterval - rest) >= tenKappa) &&
+				   (((rest + tenKappa) < smallDistance) || ((smallDistance - rest) >= (rest + tenKappa - smallDistance))))
+			{
+				pDigits[iLength - 1]--;
+				rest += tenKappa;
+			}
+
+			// Can't tell which candidate is closest
+			if ((rest < bigDistance) &&
+				((unsafeInterval - rest) >= tenKappa) &&
+				(((rest + tenKappa) < bigDistance) || ((bigDistance - rest) > (rest + tenKappa - bigDistance))))
+				return false;
+
+			// Must be safely inside the rounding interval
+			return ((2 * unit) <= rest) && (rest <= (unsafeInterval - (4 * unit)));
+		}
+
+		bool DigitGen(const DiyFp& low, const DiyFp& w, const DiyFp& high, char *pDigits, int *pLength, int *pKappa)
+		{
+			SCE_SLED_ASSERT((low.e == w.e) && (w.e == high.e));
+			SCE_SLED_ASSERT((w.e >= kMinimalTargetExponent) && (w.e <= kMaximalTargetExponent));
+
+			uint64_t unit = 1;
+			const DiyFp tooLow(low.f - unit, low.e);
+			const DiyFp tooHigh(high.f + unit, high.e);
+			uint64_t unsafeInterval = tooHigh.f - tooLow.f;
+
+			const int iShift = -w.e;
+			const uint64_t one = 1ULL << iShift;
+
+			uint32_t integrals = (uint32_t)(tooHigh.f >> iShift);
+			uint64_t fractionals = tooHigh.f & (one - 1);
+
+			uint32_t divisor = 1;
+			int kappa = 1;
+			while (divisor <= (integrals / 10))
+			{
+				divisor *= 10;
+				kappa++;
+			}
+
+			*pLength = 0;
+
+			while (kappa > 0)
+			{
+				pDigits[(*pLength)++] = (char)('0' + (integrals / divisor));
+				integrals %= divisor;
+				kappa--;
+
+				const uint64_t rest = ((uint64_t)integrals << iShift) + fractionals;
+				if (rest < unsafeInterval)
+				{
+					*pKappa = kappa;
+					return RoundWeed(pDigits, *pLength, tooHigh.f - w.f, unsafeInterval, rest, (uint64_t)divisor << iShift, unit);
+				}
+
+				divisor /= 10;
+			}
+
+			for (;;)
+			{
+				fractionals *= 10;
+				unit *= 10;
+				unsafeInterval *= 10;
+
+				pDigits[(*pLength)++] = (char)('0' + (int)(fractionals >> iShift));
+				fractionals &= one - 1;
+				kappa--;
+
+				if (fractionals < unsafeInterval)
+				{
+					*pKappa = kappa;
+					return RoundWeed(pDigits, *pLength, (tooHigh.f - w.f) * unit, unsafeInterval, fractionals, one, unit);
+				}
+			}
+		}
+
+		// Shortest digits for a positive, finite, non-zero value such that
+		// value == digits * 10^exponent
+		bool Grisu3(double value, char *pDigits, int *pLength, int *pExponent)
+		{
+			uint64_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+
+			const int iBiased = (int)((bits >> 52) & 0x7FF);
+			const uint64_t fraction = bits & kSignificandMask;
+
+			const DiyFp v = (iBiased == 0)
+				? DiyFp(fraction, kDenormalExponent)
+				: DiyFp(fraction + kHiddenBit, iBiased - kExponentBias);
+
+			// Boundaries halfway to the neighbouring doubles; the lower one
+			// is closer when the significand is a power of two
+			const DiyFp plus = Normalize(DiyFp((v.f << 1) + 1, v.e - 1));
+			DiyFp minus = ((fraction == 0) && (iBiased > 1))
+				? DiyFp((v.f << 2) - 1, v.e - 2)
+				: DiyFp((v.f << 1) - 1, v.e - 1);
+			minus.f <<= minus.e - plus.e;
+			minus.e = plus.e;
+
+			const DiyFp w = Normalize(v);
+			SCE_SLED_ASSERT(w.e == plus.e);
+
+			// Pick the cached power that scales w into the target window
+			const int iMinExponent = kMinimalTargetExponent - (w.e + 64);
+			const int k = (int)std::ceil((iMinExponent + 63) * 0.30102999566398114);
+			const int iIndex = ((kCachedPowersOffset + k - 1) / kCachedPowersStep) + 1;
+			const CachedPower& cached = s_cachedPowers[iIndex];
+			SCE_SLED_ASSERT(iMinExponent <= cached.e);
+			SCE_SLED_ASSERT(cached.e <= (kMaximalTargetExponent - (w.e + 64)));
+
+			const DiyFp tenMk(cached.f, cached.e);
+			const DiyFp scaledW = Multiply(w, tenMk);
+			const DiyFp scaledMinus = Multiply(minus, tenMk);
+			const DiyFp scaledPlus = Multiply(plus, tenMk);
+
+			int kappa = 0;
+			const bool bResult = DigitGen(scaledMinus, scaledW, scaledPlus, pDigits, pLength, &kappa);
+			*pExponent = kappa - cached.k;
+			return bResult;
+		}
+
+		// Exact but slow; finds the shortest precision that reads back
+		void ShortestFallback(double value, char *pDigits, int *pLength, int *pExponent)
+		{
+			char szTemp[40];
+			for (int iPrecision = 1; iPrecision <= kMaxDigits; ++iPrecision)
+			{
+				std::sprintf(szTemp, "%.*e", iPrecision - 1, value);
+				if (std::strtod(szTemp, NULL) == value)
+					break;
+			}
+
+			// "d.ddde+xx"
+			int iLength = 0;
+			const char *p = szTemp;
+			for (; (*p != 'e') && (*p != '\0'); ++p)
+			{
+				if (*p != '.')
+					pDigits[iLength++] = *p;
+			}
+
+			const int iExponent = (*p == 'e') ? std::atoi(p + 1) : 0;
+
+			*pLength = iLength;
+			*pExponent = iExponent - (iLength - 1);
+		}
+
+		char *WriteExponent(char *p, int iExponent)
+		{
+			*p++ = 'e';
+			if (iExponent < 0)
+			{
+				*p++ = '-';
+				iExponent = -iExponent;
+			}
+			else
+			{
+				*p++ = '+';
+			}
+
+			// At least two digits, like printf
+			char szTemp[8];
+			char *pEnd = szTemp + sizeof(szTemp);
+			char *pStart = WriteUnsignedBackwards(pEnd, (uint64_t)iExponent);
+			if ((pEnd - pStart) < 2)
+				*p++ = '0';
+
+			while (pStart != pEnd)
+				*p++ = *pStart++;
+
+			return p;
+		}
+
+		// Lays the digits out the way "%.17g" would
+		std::size_t WriteDecimal(char *pOut, const char *pDigits, int iLength, int iExponent)
+		{
+			char *p = pOut;
+			const int iPoint = iLength + iExponent;
+
+			if ((iPoint > kMaxDigits) || (iPoint < -3))
+			{
+				*p++ = pDigits[0];
+				if (iLength > 1)
+				{
+					*p++ = '.';
+					std::memcpy(p, pDigits + 1, iLength - 1);
+					p += iLength - 1;
+				}
+
+				p = WriteExponent(p, iPoint - 1);
+			}
+			else if (iPoint <= 0)
+			{
+				*p++ = '0';
+				*p++ = '.';
+				for (int i = iPoint; i < 0; ++i)
+					*p++ = '0';
+
+				std::memcpy(p, pDigits, iLength);
+				p += iLength;
+			}
+			else if (iPoint >= iLength)
+			{
+				std::memcpy(p, pDigits, iLength);
+				p += iLength;
+				for (int i = iLength; i < iPoint; ++i)
+					*p++ = '0';
+			}
+			else
+			{
+				std::memcpy(p, pDigits, iPoint);
+				p += iPoint;
+				*p++ = '.';
+				std::memcpy(p, pDigits + iPoint, iLength - iPoint);
+				p += iLength - iPoint;
+			}
+
+			return (std::size_t)(p - pOut);
+		}
+	}
+
+	namespace NumberFormat
+	{
+		std::size_t formatUnsigned(char *pszBuffer, std::size_t len, uint64_t value)
+		{
+			char szTemp[24];
+			char *pEnd = szTemp + sizeof(szTemp);
+			const char *pStart = WriteUnsignedBackwards(pEnd, value);
+			return CopyOut(pszBuffer, len, pStart, (std::size_t)(pEnd - pStart));
+		}
+
+		std::size_t formatInteger(char *pszBuffer, std::size_t len, int64_t value)
+		{
+			char szTemp[24];
+			char *pEnd = szTemp + sizeof(szTemp);
+
+			// Negate in unsigned so INT64_MIN works
+			const uint64_t magnitude = (value < 0) ? (0 - (uint64_t)value) : (uint64_t)value;
+
+			char *pStart = WriteUnsignedBackwards(pEnd, magnitude);
+			if (value < 0)
+				*--pStart = '-';
+
+			return CopyOut(pszBuffer, len, pStart, (std::size_t)(pEnd - pStart));
+		}
+
+		std::size_t formatDouble(char *pszBuffer, std::size_t len, double value)
+		{
+			if (value != value)
+				return CopyOut(pszBuffer, len, "nan", 3);
+
+			// Integral values are by far the most common
+			const double kMaxExactInteger = 9007199254740992.0; // 2^53
+			if ((value > -kMaxExactInteger) && (value < kMaxExactInteger))
+			{
+				const int64_t iValue = (int64_t)value;
+				if ((double)iValue == value)
+					return formatInteger(pszBuffer, len, iValue);
+			}
+
+			char szTemp[kMaxDoubleLen];
+			char *p = szTemp;
+
+			if (value < 0.0)
+			{
+				*p++ = '-';
+				value = -value;
+			}
+
+			if (value > 1.7976931348623157e308)
+			{
+				std::memcpy(p, "inf", 3);
+				p += 3;
+				return CopyOut(pszBuffer, len, szTemp, (std::size_t)(p - szTemp));
+			}
+
+			char digits[kMaxDigits + 1];
+			int iLength = 0;
+			int iExponent = 0;
+
+			if (!Grisu3(value, digits, &iLength, &iExponent))
+				ShortestFallback(value, digits, &iLength, &iExponent);
+
+			p += WriteDecimal(p, digits, iLength, iExponent);
+			return CopyOut(pszBuffer, len, szTemp, (std::size_t)(p - szTemp));
+		}
+
+		std::size_t formatPointer(char *pszBuffer, std::size_t len, const void *ptr, bool bPrefix /* = true */)
+		{
+			char szTemp[2 + (sizeof(void*) * 2)];
+			char *p = szTemp;
+
+			if (bPrefix)
+			{
+				*p++ = '0';
+				*p++ = 'x';
+			}
+
+			uintptr_t value = (uintptr_t)ptr;
+			char *pEnd = p + (sizeof(void*) * 2);
+			for (char *pDigit = pEnd; pDigit != p; value >>= 4)
+				*--pDigit = s_hexDigits[value & 0xF];
+
+			return CopyOut(pszBuffer, len, szTemp, (std::size_t)(pEnd - szTemp));
+		}
+	}
+}}
@@ -0,0 +1,39 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#ifndef __SCE_LIBSLEDLUAPLUGIN_NUMBERFORMAT_H__
+#define __SCE_LIBSLEDLUAPLUGIN_NUMBERFORMAT_H__
+
+#include "../sledcore/base_types.h"
+#include <cstddef>
+
+#include "../sleddebugger/common.h"
+
+namespace sce { namespace Sled
+{
+	// Number to text conversion that does not go through printf or Lua.
+	// Every function writes a null terminated string, truncating it to
+	// fit len, and returns the number of characters written.
+	namespace NumberFormat
+	{
+		// Longest text formatDouble can produce, plus the terminator
+		static const std::size_t kMaxDoubleLen = 32;
+
+		SCE_SLED_LINKAGE std::size_t formatInteger(char *pszBuffer, std::size_t len, int64_t value);
+		SCE_SLED_LINKAGE std::size_t formatUnsigned(char *pszBuffer, std::size_t len, uint64_t value);
+
+		// Shortest text that reads back as exactly the same double.
+		// Integral values print without a decimal point ("42"), large and
+		// small magnitudes use an exponent ("1e+300"), and non-finite
+		// values print as "inf", "-inf" and "nan".
+		SCE_SLED_LINKAGE std::size_t formatDouble(char *pszBuffer, std::size_t len, double value);
+
+		// Upper case hex padded to the pointer width, same as "%p" (with
+		// a leading "0x" when bPrefix is set)
+		SCE_SLED_LINKAGE std::size_t formatPointer(char *pszBuffer, std::size_t len, const void *ptr, bool bPrefix = true);
+	}
+}}
+
+#endif // __SCE_LIBSLEDLUAPLUGIN_NUMBERFORMAT_H__
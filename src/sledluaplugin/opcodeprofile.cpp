@@ -0,0 +1,221 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "opcodeprofile.h"
+#include "sledluaplugin.h"
+#include "../sleddebugger/assert.h"
+#include "../sleddebugger/errorcodes.h"
+#include "../sleddebugger/sequentialallocator.h"
+#include "../sleddebugger/utilities.h"
+
+#include <new>
+#include <cstring>
+
+namespace sce { namespace Sled
+{
+	void OpcodeProfileConfig::init(const OpcodeProfileConfig& rhs)
+	{
+		maxFunctions = rhs.maxFunctions;
+	}
+
+	OpcodeProfileConfig::OpcodeProfileConfig(const LuaPluginConfig *pConfig)
+	{
+		SCE_SLED_ASSERT(pConfig != NULL);
+
+		maxFunctions = pConfig->maxOpcodeProfileFunctions;
+	}
+
+	namespace
+	{
+		struct OpcodeProfileSeats
+		{
+			void *m_this;
+			void *m_functions;
+
+			void Allocate(const OpcodeProfileConfig& profileConfig, ISequentialAllocator *pAllocator)
+			{
+				// For this
+				m_this = pAllocator->allocate(sizeof(OpcodeProfile), __alignof(OpcodeProfile));
+
+				// For m_pFunctions
+				m_functions = pAllocator->allocate(sizeof(OpcodeProfileFunction) * profileConfig.maxFunctions, __alignof(OpcodeProfileFunction));
+			}
+		};
+	}
+
+	int32_t OpcodeProfile::create(const OpcodeProfileConfig& profileConfig, void *pLocation, OpcodeProfile **ppProfile)
+	{
+		SCE_SLED_ASSERT(pLocation != NULL);
+		SCE_SLED_ASSERT(ppProfile != NULL);
+
+		std::size_t iMemSize = 0;
+
+		const int32_t iConfigError = requiredMemory(profileConfig, &iMemSize);
+		if (iConfigError != 0)
+			return iConfigError;
+
+		SequentialAllocator allocator(pLocation, iMemSize);
+
+		OpcodeProfileSeats seats;
+		seats.Allocate(profileConfig, &allocator);
+
+		SCE_SLED_ASSERT(seats.m_this != NULL);
+		SCE_SLED_ASSERT(seats.m_functions != NULL);
+
+		*ppProfile = new (seats.m_this) OpcodeProfile(profileConfig, &seats);
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t OpcodeProfile::requiredMemory(const OpcodeProfileConfig& profileConfig, std::size_t *iRequiredMemory)
+	{
+		SCE_SLED_ASSERT(iRequiredMemory != NULL);
+
+		SequentialAllocatorCalculator allocator;
+
+		OpcodeProfileSeats seats;
+		seats.Allocate(profileConfig, &allocator);
+
+		*iRequiredMemory = allocator.bytesAllocated();
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t OpcodeProfile::requiredMemoryHelper(const OpcodeProfileConfig& profileConfig, ISequentialAllocator *pAllocator, void **ppThis)
+	{
+		SCE_SLED_ASSERT(pAllocator != NULL);
+		SCE_SLED_ASSERT(ppThis != NULL);
+
+		OpcodeProfileSeats seats;
+		seats.Allocate(profileConfig, pAllocator);
+
+		*ppThis = seats.m_this;
+		return SCE_SLED_ERROR_OK;
+	}
+
+	void OpcodeProfile::shutdown(OpcodeProfile *pProfile)
+	{
+		SCE_SLED_ASSERT(pProfile != NULL);
+		pProfile->~OpcodeProfile();
+	}
+
+	OpcodeProfile::OpcodeProfile(const OpcodeProfileConfig& profileConfig, const void *pProfileSeats)
+		: m_iMaxFunctions(profileConfig.maxFunctions)
+		, m_iNumFunctions(0)
+		, m_iNumFunctionsSeen(0)
+		, m_iNumOpcodes(0)
+		, m_iTotalInstructions(0)
+	{
+		SCE_SLED_ASSERT(pProfileSeats != NULL);
+
+		const OpcodeProfileSeats *pSeats = static_cast<const OpcodeProfileSeats*>(pProfileSeats);
+
+		m_pFunctions = new (pSeats->m_functions) OpcodeProfileFunction[profileConfig.maxFunctions];
+
+		std::memset(m_pszNames, 0, sizeof(m_pszNames));
+		std::memset(m_iTotals, 0, sizeof(m_iTotals));
+	}
+
+	void OpcodeProfile::begin(int32_t iNumOpcodes)
+	{
+		m_iNumFunctions = 0;
+		m_iNumFunctionsSeen = 0;
+		m_iTotalInstructions = 0;
+
+		if (iNumOpcodes < 0)
+			iNumOpcodes = 0;
+		else if (iNumOpcodes > OpcodeProfileFunction::kMaxOpcodes)
+			iNumOpcodes = OpcodeProfileFunction::kMaxOpcodes;
+
+		m_iNumOpcodes = (uint16_t)iNumOpcodes;
+
+		std::memset(m_pszNames, 0, sizeof(m_pszNames));
+		std::memset(m_iTotals, 0, sizeof(m_iTotals));
+	}
+
+	void OpcodeProfile::setOpcode(int32_t iOpcode, const char *pszName, uint64_t iTotal)
+	{
+		if ((iOpcode < 0) || (iOpcode >= m_iNumOpcodes))
+			return;
+
+		m_pszNames[iOpcode] = pszName;
+		m_iTotals[iOpcode] = iTotal;
+		m_iTotalInstructions += iTotal;
+	}
+
+	void OpcodeProfile::addFunction(const char *pszSource, int32_t iLineDefined, const std::size_t *pCounts)
+	{
+		SCE_SLED_ASSERT(pszSource != NULL);
+		SCE_SLED_ASSERT(pCounts != NULL);
+
+		m_iNumFunctionsSeen++;
+
+		if (m_iMaxFunctions == 0)
+			return;
+
+		uint64_t iTotal = 0;
+		for (uint16_t i = 0; i < m_iNumOpcodes; i++)
+			iTotal += pCounts[i];
+
+		if (iTotal == 0)
+			return;
+
+		// Fill up first, then replace whichever kept function ran the least
+		uint16_t iSlot = m_iNumFunctions;
+		if (m_iNumFunctions == m_iMaxFunctions)
+		{
+			iSlot = 0;
+			for (uint16_t i = 1; i < m_iNumFunctions; i++)
+			{
+				if (m_pFunctions[i].total < m_pFunctions[iSlot].total)
+					iSlot = i;
+			}
+
+			if (m_pFunctions[iSlot].total >= iTotal)
+				return;
+		}
+		else
+		{
+			m_iNumFunctions++;
+		}
+
+		OpcodeProfileFunction& entry = m_pFunctions[iSlot];
+		Utilities::copyString(entry.source, OpcodeProfileFunction::kNameLen, pszSource);
+		entry.lineDefined = iLineDefined;
+		entry.total = iTotal;
+
+		std::memset(entry.counts, 0, sizeof(entry.counts));
+		for (uint16_t i = 0; i < m_iNumOpcodes; i++)
+			entry.counts[i] = pCounts[i];
+	}
+
+	void OpcodeProfile::end()
+	{
+		// Few entries so insertion sort is plenty
+		for (uint16_t i = 1; i < m_iNumFunctions; i++)
+		{
+			for (uint16_t j = i; (j > 0) && (m_pFunctions[j - 1].total < m_pFunctions[j].total); j--)
+			{
+				const OpcodeProfileFunction temp = m_pFunctions[j];
+				m_pFunctions[j] = m_pFunctions[j - 1];
+				m_pFunctions[j - 1] = temp;
+			}
+		}
+	}
+
+	void OpcodeProfile::getSummary(OpcodeProfileSummary *pSummary) const
+	{
+		SCE_SLED_ASSERT(pSummary != NULL);
+
+		pSummary->numOpcodes = m_iNumOpcodes;
+
+		for (uint16_t i = 0; i < OpcodeProfileSummary::kMaxOpcodes; i++)
+		{
+			pSummary->opcodeNames[i] = (i < m_iNumOpcodes) ? m_pszNames[i] : 0;
+			pSummary->opcodeCounts[i] = (i < m_iNumOpcodes) ? m_iTotals[i] : 0;
+		}
+
+		pSummary->totalInstructions = m_iTotalInstructions;
+		pSummary->numFunctions = m_iNumFunctionsSeen;
+	}
+}}
@@ -0,0 +1,93 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#ifndef __SCE_LIBSLEDLUAPLUGIN_OPCODEPROFILE_H__
+#define __SCE_LIBSLEDLUAPLUGIN_OPCODEPROFILE_H__
+
+#include "../sledcore/base_types.h"
+#include <cstddef>
+
+#include "../sleddebugger/common.h"
+
+namespace sce { namespace Sled
+{
+	// Forward declarations
+	class ISequentialAllocator;
+
+	// Forward declarations
+	struct LuaPluginConfig;
+	struct OpcodeProfileSummary;
+
+	struct SCE_SLED_LINKAGE OpcodeProfileFunction
+	{
+		static const uint16_t kNameLen = 64;
+		static const uint16_t kMaxOpcodes = 64;
+
+		char			source[kNameLen];
+		int32_t			lineDefined;
+		uint64_t		total;
+		uint64_t		counts[kMaxOpcodes];
+	};
+
+	struct SCE_SLED_LINKAGE OpcodeProfileConfig
+	{
+		OpcodeProfileConfig() : maxFunctions(0) {}
+		OpcodeProfileConfig(const OpcodeProfileConfig& rhs) { init(rhs); }
+		OpcodeProfileConfig& operator=(const OpcodeProfileConfig& rhs) { init(rhs); return *this; }
+
+		OpcodeProfileConfig(const LuaPluginConfig *pConfig);
+
+	private:
+		void init(const OpcodeProfileConfig& rhs);
+	public:
+
+		uint16_t		maxFunctions;	///< Number of functions running the most instructions to keep (0 disables the opcode profile)
+	};
+
+	// Opcode counts the VM gathered for a Lua state, boiled down to the
+	// totals & the functions that ran the most instructions. Knows
+	// nothing of Lua; the opcode names are the VM's own strings.
+	class SCE_SLED_LINKAGE OpcodeProfile
+	{
+	public:
+		static int32_t create(const OpcodeProfileConfig& profileConfig, void *pLocation, OpcodeProfile **ppProfile);
+		static int32_t requiredMemory(const OpcodeProfileConfig& profileConfig, std::size_t *iRequiredMemory);
+		static int32_t requiredMemoryHelper(const OpcodeProfileConfig& profileConfig, ISequentialAllocator *pAllocator, void **ppThis);
+		static void shutdown(OpcodeProfile *pProfile);
+	private:
+		OpcodeProfile(const OpcodeProfileConfig& profileConfig, const void *pProfileSeats);
+		~OpcodeProfile() {}
+		OpcodeProfile(const OpcodeProfile&);
+		OpcodeProfile& operator=(const OpcodeProfile&);
+	public:
+		// Opcodes past kMaxOpcodes are ignored
+		void begin(int32_t iNumOpcodes);
+		void setOpcode(int32_t iOpcode, const char *pszName, uint64_t iTotal);
+		void addFunction(const char *pszSource, int32_t iLineDefined, const std::size_t *pCounts);
+		// Orders the functions kept, most instructions first
+		void end();
+		void getSummary(OpcodeProfileSummary *pSummary) const;
+		inline bool isEnabled() const					{ return m_iMaxFunctions != 0; }
+		inline uint16_t getNumOpcodes() const			{ return m_iNumOpcodes; }
+		inline const char *getOpcodeName(uint16_t iOpcode) const	{ return (iOpcode < m_iNumOpcodes) ? m_pszNames[iOpcode] : 0; }
+		inline uint64_t getOpcodeTotal(uint16_t iOpcode) const		{ return (iOpcode < m_iNumOpcodes) ? m_iTotals[iOpcode] : 0; }
+		inline uint64_t getTotalInstructions() const	{ return m_iTotalInstructions; }
+		inline uint32_t getNumFunctionsSeen() const		{ return m_iNumFunctionsSeen; }
+		inline uint16_t getNumFunctions() const			{ return m_iNumFunctions; }
+		inline const OpcodeProfileFunction *getFunction(uint16_t iIndex) const	{ return (iIndex < m_iNumFunctions) ? &m_pFunctions[iIndex] : 0; }
+	private:
+		const uint16_t			m_iMaxFunctions;
+		uint16_t				m_iNumFunctions;
+		OpcodeProfileFunction*	m_pFunctions;
+		uint32_t				m_iNumFunctionsSeen;
+
+		uint16_t				m_iNumOpcodes;
+		const char*				m_pszNames[OpcodeProfileFunction::kMaxOpcodes];
+		uint64_t				m_iTotals[OpcodeProfileFunction::kMaxOpcodes];
+		uint64_t				m_iTotalInstructions;
+	};
+}}
+
+#endif // __SCE_LIBSLEDLUAPLUGIN_OPCODEPROFILE_H__
@@ -78,6 +78,81 @@ namespace Sled
 	/// <c>EditAndContinueCallback</c>
 	typedef void (*EditAndContinueFinishCallback)(const char *pszFilePath, void *pUserData);
 
+	/// Typedef for a coverage write callback function. This function receives line coverage data written by <c>luaPluginWriteCoverage()</c>,
+	/// a piece at a time and in order, for the application to save or send wherever it wants.
+	/// @brief
+	/// Typedef for coverage write callback function.
+	///
+	/// @param pData Next piece of coverage data
+	/// @param iSize Size, in bytes, of <c>pData</c> (never more than 512)
+	/// @param pUserData Optional user-controlled userdata
+	/// @return True to carry on writing; false to stop
+	///
+	/// @see
+	/// <c>luaPluginWriteCoverage</c>
+	typedef bool (*CoverageWriteCallback)(const uint8_t *pData, int32_t iSize, void *pUserData);
+
+	/// Callback the profiler's call paths are written through, in the folded-stack text format flame graph tools read:
+	/// one line per call path, the functions from the outermost in, separated by semicolons, then a space and the weight.
+	/// Text comes a piece at a time and in order; a line may be split across calls.
+	/// @brief
+	/// Typedef for folded-stack write callback function.
+	///
+	/// @param pszText Next piece of text; not null-terminated
+	/// @param iLen Length, in bytes, of <c>pszText</c> (never more than 512)
+	/// @param pUserData Optional user-controlled userdata
+	/// @return True to carry on writing; false to stop
+	///
+	/// @see
+	/// <c>luaPluginWriteProfileFolded</c>
+	typedef bool (*ProfileFoldedWriteCallback)(const char *pszText, int32_t iLen, void *pUserData);
+
+	/// Callback a profile capture is written through: every profiled function with its times, the calls between
+	/// functions, call paths, latency histograms and a header naming the build. The data is binary and comes a piece at a
+	/// time and in order; written to a file, it can be compared against a capture of another build with the profile diff tool.
+	/// @brief
+	/// Typedef for profile capture write callback function.
+	///
+	/// @param pData Next piece of capture data
+	/// @param iSize Size, in bytes, of <c>pData</c> (never more than 512)
+	/// @param pUserData Optional user-controlled userdata
+	/// @return True to carry on writing; false to stop
+	///
+	/// @see
+	/// <c>luaPluginWriteProfileCapture</c>
+	typedef bool (*ProfileCaptureWriteCallback)(const uint8_t *pData, int32_t iSize, void *pUserData);
+
+	/// Callback the profiler's timeline capture is written through, as Chrome trace-event JSON that trace viewers such as
+	/// chrome://tracing load. Text comes a piece at a time and in order.
+	/// @brief
+	/// Typedef for trace write callback function.
+	///
+	/// @param pszText Next piece of text; not null-terminated
+	/// @param iLen Length, in bytes, of <c>pszText</c> (never more than 512)
+	/// @param pUserData Optional user-controlled userdata
+	/// @return True to carry on writing; false to stop
+	///
+	/// @see
+	/// <c>luaPluginWriteTrace</c>
+	typedef bool (*TraceWriteCallback)(const char *pszText, int32_t iLen, void *pUserData);
+
+	// Forward declaration
+	struct ProfileFrameFunction;
+
+	/// Callback receiving the per frame profile of one function, from the rolling window of recent frames or from a
+	/// frame kept for going over the frame budget.
+	///
+	/// @brief
+	/// Typedef for profiled frame function callback function.
+	///
+	/// @param pFunction Function and its calls and times
+	/// @param pUserData Optional user-controlled userdata
+	/// @return None
+	///
+	/// @see
+	/// <c>luaPluginProfilerFrameFunctions</c>, <c>luaPluginProfilerSlowFrame</c>
+	typedef void (*ProfileFrameFunctionCallback)(const ProfileFrameFunction *pFunction, void *pUserData);
+
 	/// Namespace to scope variable exclude flags. Variable exclude flags exclude certain variable groups from being processed and 
 	/// sent to SLED when execution stops on a breakpoint.
 	/// @brief
@@ -97,6 +172,70 @@ namespace Sled
 			kEnvironment	= (1 << 4),	///< Exclude processing and sending environment table variables
 		};
 	}
+
+	/// Namespace to scope variable transfer modes. The variable transfer mode controls how much variable data is
+	/// processed and sent to SLED when execution stops on a breakpoint.
+	/// @brief
+	/// Namespace to scope variable transfer modes.
+	namespace VarTransferMode
+	{
+		/// @brief
+		/// Variable transfer modes for execution stops on a breakpoint.
+		///
+		/// In lazy mode only the callstack and the names and types of locals are sent when execution stops. Globals,
+		/// upvalues, environment tables and table contents are then sent on request in pages of entries.
+		enum Enum
+		{
+			kEager	= 0,	///< Send all variable values when execution stops. This is the default behavior.
+			kLazy	= 1,	///< Send only the callstack and local names and types when execution stops
+		};
+	}
+
+	/// Namespace to scope folded-stack weights.
+	/// @brief
+	/// Namespace to scope folded-stack weights.
+	namespace ProfileFoldedWeight
+	{
+		/// @brief
+		/// What the number ending each folded-stack line counts.
+		enum Enum
+		{
+			kSelfTime	= 0,	///< Microseconds spent in the last function of the call path, less the functions it called
+			kCallCount	= 1,	///< Number of times the last function of the call path was called from it
+		};
+	}
+
+	/// Namespace to scope performance watch flags.
+	/// @brief
+	/// Namespace to scope performance watch flags.
+	namespace PerfWatchFlags
+	{
+		/// @brief
+		/// Which time a performance watch checks and what it does, besides keeping an incident, when the time is over budget.
+		enum Enum
+		{
+			kNone		= 0,		///< Check the time including the functions called and only keep an incident. This is the default behavior.
+			kInnerTime	= (1 << 0),	///< Check the time excluding the functions called
+			kBreak		= (1 << 1),	///< Break in SLED, as <c>luaPluginDebuggerBreak</c> does, if SLED is connected
+			kTtyNotify	= (1 << 2),	///< Send a line of text about the incident to SLED's output window
+		};
+	}
+
+	/// Namespace to scope profile filter kinds.
+	/// @brief
+	/// Namespace to scope profile filter kinds.
+	namespace ProfileFilterKind
+	{
+		/// @brief
+		/// What a profile filter pattern is matched against and whether matching it lets a function be profiled or keeps it out.
+		enum Enum
+		{
+			kIncludeSource		= 0,	///< Script, as the profiler shows it; with any of these only functions in a matching script are profiled
+			kExcludeSource		= 1,	///< Script, as the profiler shows it; functions in a matching script aren't profiled
+			kIncludeFunction	= 2,	///< Function name, as the profiler shows it; with any of these only functions with a matching name are profiled
+			kExcludeFunction	= 3,	///< Function name, as the profiler shows it; functions with a matching name aren't profiled
+		};
+	}
 	
 	/// @brief
 	/// LuaPlugin configuration parameters.
@@ -121,6 +260,29 @@ namespace Sled
 			, maxPatternsPerVarFilter(0)
 			, maxProfileFunctions(0)
 			, maxProfileCallStackDepth(0)
+			, maxProfileCallPaths(0)
+			, maxProfileHistograms(0)
+			, maxProfileFrames(0)
+			, maxProfileSlowFrames(0)
+			, profileFrameBudgetUs(0)
+			, profileCalibrationCalls(0)
+			, maxPerfWatches(0)
+			, maxPerfIncidents(0)
+			, maxProfileFilters(0)
+			, maxProfileFilterPatternLen(0)
+			, maxTraceEvents(0)
+			, maxHeapCensusObjects(0)
+			, maxHeapCensusTables(0)
+			, maxHeapCensusRoots(0)
+			, maxHeapCensusDepth(0)
+			, heapCensusTimeBudgetMs(0)
+			, maxOpcodeProfileFunctions(0)
+			, maxSnapshotVars(0)
+			, maxSnapshotNameBytes(0)
+			, maxBreakpointVars(0)
+			, maxBreakpointVarBytes(0)
+			, breakpointVarTimeBudgetMs(0)
+			, breakpointSendArenaSize(0)
 			, numPathChopChars(0)
 			, pfnChopCharsCallback(0)
 			, pfnEditAndContinueCallback(0)
@@ -145,6 +307,33 @@ namespace Sled
 
 		uint16_t	maxProfileFunctions;		///< Maximum number of functions to profile
 		uint16_t	maxProfileCallStackDepth;	///< Maximum call stack depth
+		uint32_t	maxProfileCallPaths;		///< Maximum number of unique call paths the profiler tracks for folded-stack export (0 disables call paths)
+		uint16_t	maxProfileHistograms;		///< Number of profiled functions, in the order first called, that keep latency histograms for percentiles (0 disables latency histograms)
+		uint16_t	maxProfileFrames;			///< Number of most recent frames, as marked by <c>luaPluginProfilerFrameMark</c>, the profiler rolls up per function (0 disables frame profiling)
+		uint16_t	maxProfileSlowFrames;		///< Number of most recent frames over <c>profileFrameBudgetUs</c> the profiler keeps a per function breakdown of
+		uint32_t	profileFrameBudgetUs;		///< Frame time, in microseconds, a frame has to go over to be counted as over budget (0 for no budget)
+		uint16_t	profileCalibrationCalls;	///< Number of empty calls timed through the profiler when it starts, to estimate its own overhead and take it off corrected function times (0 disables the correction)
+		uint16_t	maxPerfWatches;				///< Maximum number of profiled function time budgets watched at once (0 disables performance watches)
+		uint16_t	maxPerfIncidents;			///< Number of most recent performance watch incidents kept (at least 1 if performance watches are enabled)
+		uint16_t	maxProfileFilters;			///< Maximum number of profile filter patterns, of all kinds, at once (0 disables profile filters)
+		uint16_t	maxProfileFilterPatternLen;	///< Maximum length of a profile filter pattern
+		uint32_t	maxTraceEvents;				///< Number of most recent function calls and returns the profiler's timeline capture keeps per Lua state (0 disables timeline capture)
+
+		uint32_t	maxHeapCensusObjects;		///< Maximum number of objects a heap census visits (0 disables the heap census)
+		uint16_t	maxHeapCensusTables;		///< Number of largest tables a heap census reports
+		uint16_t	maxHeapCensusRoots;			///< Number of largest global roots a heap census reports
+		uint16_t	maxHeapCensusDepth;			///< Maximum nesting depth a heap census follows
+		uint32_t	heapCensusTimeBudgetMs;		///< Maximum time, in milliseconds, a heap census runs for (0 for no limit)
+
+		uint16_t	maxOpcodeProfileFunctions;	///< Number of functions running the most instructions an opcode profile reports (0 disables the opcode profile)
+
+		uint32_t	maxSnapshotVars;			///< Maximum number of variables remembered between breakpoint stops so only changes are sent (0 disables snapshot diffing)
+		uint32_t	maxSnapshotNameBytes;		///< Size, in bytes, of the storage for variable names remembered between breakpoint stops
+
+		uint32_t	maxBreakpointVars;			///< Maximum number of variables sent when execution stops on a breakpoint; SLED pages in the rest (0 for no limit)
+		uint32_t	maxBreakpointVarBytes;		///< Maximum number of bytes of variable data sent when execution stops on a breakpoint (0 for no limit)
+		uint32_t	breakpointVarTimeBudgetMs;	///< Maximum time, in milliseconds, spent collecting variables when execution stops on a breakpoint (0 for no limit)
+		uint32_t	breakpointSendArenaSize;	///< Size, in bytes, of the queue used to send variables from a worker thread while the game thread collects them at a breakpoint (0 to send them on the game thread)
 
 		int32_t		numPathChopChars;			///< The number of characters to strip off the beginning of a path string
 
@@ -156,6 +345,217 @@ namespace Sled
 
 		uint32_t	maxWorkBufferSize;			///< Maximum size of the work buffer (1024 recommended at a minimum)
 	};
+
+	/// @brief
+	/// Heap census summary.
+	///
+	/// Object counts and approximate sizes gathered by a heap census. The per-type
+	/// arrays are indexed by Lua type (<c>LUA_TNIL</c> through <c>LUA_TTHREAD</c>).
+	struct SCE_SLED_LINKAGE HeapCensusSummary
+	{
+		/// Constructor to initialize items.
+		///
+		/// @brief
+		/// HeapCensusSummary constructor.
+		HeapCensusSummary()
+			: numObjects(0)
+			, totalBytes(0)
+			, elapsed(0.0f)
+			, truncated(false)
+		{
+			for (int i = 0; i < 9; i++)
+			{
+				typeCounts[i] = 0;
+				typeBytes[i] = 0;
+			}
+		}
+
+		uint32_t	numObjects;		///< Number of objects visited
+		uint64_t	totalBytes;		///< Approximate size, in bytes, of all objects visited
+		uint32_t	typeCounts[9];	///< Number of objects visited per Lua type
+		uint64_t	typeBytes[9];	///< Approximate size, in bytes, of objects visited per Lua type
+		float		elapsed;		///< Time, in seconds, the heap census took
+		bool		truncated;		///< Whether the heap census stopped early because the object or time budget ran out
+	};
+
+	/// @brief
+	/// Opcode profile summary.
+	///
+	/// Number of instructions the Lua VM ran per opcode while the opcode profile was on. The per-opcode
+	/// arrays are indexed by the opcode numbers of the Lua version in use.
+	struct SCE_SLED_LINKAGE OpcodeProfileSummary
+	{
+		static const uint16_t kMaxOpcodes = 64;	///< Size of the per-opcode arrays
+
+		/// Constructor to initialize items.
+		///
+		/// @brief
+		/// OpcodeProfileSummary constructor.
+		OpcodeProfileSummary()
+			: numOpcodes(0)
+			, totalInstructions(0)
+			, numFunctions(0)
+		{
+			for (uint16_t i = 0; i < kMaxOpcodes; i++)
+			{
+				opcodeNames[i] = 0;
+				opcodeCounts[i] = 0;
+			}
+		}
+
+		uint16_t	numOpcodes;						///< Number of opcodes of the Lua VM
+		const char*	opcodeNames[kMaxOpcodes];		///< Name of each opcode, such as "GETTABLE"
+		uint64_t	opcodeCounts[kMaxOpcodes];		///< Number of instructions run per opcode
+		uint64_t	totalInstructions;				///< Number of instructions run
+		uint32_t	numFunctions;					///< Number of functions still loaded that ran instructions
+	};
+
+	/// @brief
+	/// Profiled function call time percentiles.
+	///
+	/// Times, in microseconds, from a function's latency histogram. Each percentile is the upper
+	/// bound of the histogram bucket it falls in, which is within an eighth of the actual time.
+	struct SCE_SLED_LINKAGE ProfileLatencyPercentiles
+	{
+		uint64_t	p50;		///< Time half of the calls took at most
+		uint64_t	p90;		///< Time 90% of the calls took at most
+		uint64_t	p99;		///< Time 99% of the calls took at most
+		uint64_t	p999;		///< Time 99.9% of the calls took at most
+		uint64_t	longest;	///< Longest call
+	};
+
+	/// @brief
+	/// Profiled function latency summary.
+	///
+	/// Call time percentiles of one profiled function, both including and excluding the time spent in
+	/// the functions it called.
+	struct SCE_SLED_LINKAGE ProfileLatencySummary
+	{
+		uint32_t					callCount;	///< Number of calls that returned
+		ProfileLatencyPercentiles	elapsed;	///< Percentiles of call times including the functions called
+		ProfileLatencyPercentiles	inner;		///< Percentiles of call times excluding the functions called
+	};
+
+	/// @brief
+	/// Profile zone call site.
+	///
+	/// Name and location of a native profile zone, and which profiled function the plugin found it to be. One is declared
+	/// static at each <c>SCE_SLED_PROFILE_ZONE</c> so the zone's name is only looked up the first time through after the
+	/// profile is reset.
+	struct SCE_SLED_LINKAGE ProfileZoneSite
+	{
+		const char*	name;		///< Name of the zone, as the profiler shows it
+		const char*	file;		///< Source file of the zone
+		int32_t		line;		///< Line of the zone
+		const void*	owner;		///< Profiler the zone was last found in; set by the plugin
+		uint32_t	generation;	///< Which reset of that profiler's profile the zone was found after; set by the plugin
+		uint16_t	index;		///< Profiled function of the zone; set by the plugin
+	};
+
+	/// @brief
+	/// Profiler overhead.
+	///
+	/// The profiler's own overhead, in nanoseconds, as estimated when the profiler last started.
+	struct SCE_SLED_LINKAGE ProfileOverhead
+	{
+		uint16_t	calibrationCalls;	///< Number of empty calls timed per round (0 if calibration is disabled)
+		uint32_t	selfTime;			///< Overhead counted in a call's own time
+		uint32_t	callTime;			///< Overhead each call adds to the time of the functions it was called from
+	};
+
+	/// @brief
+	/// Profiled function times.
+	///
+	/// Total time of one profiled function, in microseconds, both as measured and corrected by taking off
+	/// the profiler's own overhead.
+	struct SCE_SLED_LINKAGE ProfileFunctionTimes
+	{
+		uint32_t	callCount;					///< Number of calls
+		uint64_t	timeElapsed;				///< Total time including the functions called
+		uint64_t	timeElapsedCorrected;		///< Total time including the functions called, less the profiler's overhead
+		uint64_t	timeInnerElapsed;			///< Total time excluding the functions called
+		uint64_t	timeInnerElapsedCorrected;	///< Total time excluding the functions called, less the profiler's overhead
+	};
+
+	/// @brief
+	/// Profiled function allocations.
+	///
+	/// Lua memory allocated and freed while one profiled function was the innermost one running, as reported
+	/// through <c>luaPluginMemoryTraceNotify</c>. Memory freed is mostly the garbage collector's work, done in
+	/// whichever function's allocation brought on a collection step.
+	struct SCE_SLED_LINKAGE ProfileFunctionAllocations
+	{
+		uint32_t	allocCount;		///< Number of allocations, counting reallocations that grew a block
+		uint64_t	allocBytes;		///< Bytes allocated, counting only the growth of reallocated blocks
+		uint64_t	freeBytes;		///< Bytes freed, counting only the shrinkage of reallocated blocks
+	};
+
+	/// @brief
+	/// Profiled frame statistics.
+	///
+	/// Frame times, in microseconds, over the rolling window of the most recent frames and since the profile
+	/// was last reset. A frame runs from one <c>luaPluginProfilerFrameMark</c> call to the next.
+	struct SCE_SLED_LINKAGE ProfileFrameStats
+	{
+		uint64_t	numFrames;				///< Frames marked since the profile was last reset
+		uint64_t	numFramesOverBudget;	///< Frames over budget since the profile was last reset
+		uint32_t	frameBudget;			///< Frame budget (0 for none)
+		uint16_t	windowFrames;			///< Frames in the window
+		uint16_t	windowFramesOverBudget;	///< Frames in the window over budget
+		uint64_t	windowFrameTime;		///< Total time of the frames in the window
+		uint64_t	windowLongestFrameTime;	///< Longest frame in the window
+		uint64_t	windowProfiledTime;		///< Total time spent in profiled functions, not counting functions they called, in the window
+		uint16_t	numSlowFrames;			///< Frames over budget kept with a per function breakdown
+	};
+
+	/// @brief
+	/// Profiled frame function.
+	///
+	/// Calls of one function that returned within a frame or the frames of the window, and the time, in microseconds,
+	/// they took.
+	struct SCE_SLED_LINKAGE ProfileFrameFunction
+	{
+		const char*	name;				///< Function name, or "(anonymous)"
+		const char*	source;				///< Script the function is in
+		int32_t		line;				///< Line the function is defined on
+		uint32_t	callCount;			///< Number of calls
+		uint64_t	timeElapsed;		///< Time of the calls including the functions called
+		uint64_t	timeInnerElapsed;	///< Time of the calls excluding the functions called
+	};
+
+	/// @brief
+	/// Profiled slow frame.
+	///
+	/// A frame that went over the frame budget, its time in microseconds, and its number.
+	struct SCE_SLED_LINKAGE ProfileSlowFrame
+	{
+		uint64_t	frame;			///< Number of the frame, counting from 1 since the profile was last reset
+		uint64_t	frameTime;		///< Frame time
+		uint64_t	profiledTime;	///< Time spent in profiled functions, not counting functions they called
+		uint16_t	numFunctions;	///< Number of functions in the breakdown
+	};
+
+	/// @brief
+	/// Performance watch incident.
+	///
+	/// A call that went over the time budget of a performance watch, with the functions that were running at the time.
+	/// Times are in microseconds. Function names and sources point into the profiler and stay valid until the profile is
+	/// reset.
+	struct SCE_SLED_LINKAGE PerfIncident
+	{
+		static const uint16_t kMaxCallPathDepth = 16;	///< Size of <c>callPath</c>
+
+		uint16_t	watch;						///< Id of the watch, as returned by <c>luaPluginAddPerfWatch</c>
+		uint64_t	frame;						///< Number of the frame, as counted by <c>luaPluginProfilerFrameMark</c> (0 if frames aren't profiled)
+		uint32_t	budget;						///< Budget of the watch at the time
+		uint64_t	timeElapsed;				///< Time of the call including the functions called
+		uint64_t	timeInnerElapsed;			///< Time of the call excluding the functions called
+		const char*	source;						///< Script the function is in
+		int32_t		line;						///< Line the function is defined on
+		uint16_t	callPathDepth;				///< Number of <c>callPath</c> entries
+		bool		callPathTruncated;			///< Whether outer callers were left out of <c>callPath</c>
+		const char*	callPath[kMaxCallPathDepth];	///< Function names, outermost caller first and ending with the function itself
+	};
 }}
 
 #endif // __SCE_LIBSLEDLUAPLUGIN_PARAMS_H__
@@ -0,0 +1,342 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "perfwatch.h"
+#include "profilestack.h"
+#include "sledluaplugin.h"
+#include "../sleddebugger/assert.h"
+#include "../sleddebugger/errorcodes.h"
+#include "../sleddebugger/sequentialallocator.h"
+#include "../sleddebugger/sleddebugger_class.h"
+
+#include <new>
+#include <cstring>
+
+namespace sce { namespace Sled
+{
+	void PerfWatchConfig::init(const PerfWatchConfig& rhs)
+	{
+		maxWatches = rhs.maxWatches;
+		maxIncidents = rhs.maxIncidents;
+		maxFunctions = rhs.maxFunctions;
+	}
+
+	PerfWatchConfig::PerfWatchConfig(const LuaPluginConfig *pConfig)
+	{
+		SCE_SLED_ASSERT(pConfig != NULL);
+
+		maxWatches = pConfig->maxPerfWatches;
+		maxIncidents = pConfig->maxPerfIncidents;
+		maxFunctions = pConfig->maxProfileFunctions;
+	}
+
+	namespace
+	{
+		struct PerfWatchSeats
+		{
+			void *m_this;
+			void *m_watches;
+			void *m_fnWatches;
+			void *m_fnGenerations;
+			void *m_incidents;
+
+			void Allocate(const PerfWatchConfig& watchConfig, ISequentialAllocator *pAllocator)
+			{
+				// For this
+				m_this = pAllocator->allocate(sizeof(PerfWatch), __alignof(PerfWatch));
+
+				// Nothing else unless enabled
+				const bool bEnabled = watchConfig.maxWatches != 0;
+				const uint16_t iNumFunctions = bEnabled ? watchConfig.maxFunctions : 0;
+				const uint16_t iNumIncidents = bEnabled ? watchConfig.maxIncidents : 0;
+
+				// For m_pWatches
+				m_watches = pAllocator->allocate(sizeof(PerfWatchRule) * watchConfig.maxWatches, __alignof(PerfWatchRule));
+
+				// For m_pFnWatches & m_pFnGenerations
+				m_fnWatches = pAllocator->allocate(sizeof(uint16_t) * iNumFunctions, __alignof(uint16_t));
+				m_fnGenerations = pAllocator->allocate(sizeof(uint32_t) * iNumFunctions, __alignof(uint32_t));
+
+				// For m_pIncidents
+				m_incidents = pAllocator->allocate(sizeof(PerfWatchIncident) * iNumIncidents, __alignof(PerfWatchIncident));
+			}
+		};
+
+		inline int32_t ValidateConfig(const PerfWatchConfig& config)
+		{
+			// Watches are checked as the profile stack sees calls return
+			if ((config.maxWatches != 0) && (config.maxFunctions == 0))
+				return SCE_SLED_ERROR_INVALIDCONFIGURATION;
+
+			// The incident is handed back to act on even when it isn't asked for later
+			if ((config.maxWatches != 0) && (config.maxIncidents == 0))
+				return SCE_SLED_ERROR_INVALIDCONFIGURATION;
+
+			if (config.maxWatches == PerfWatch::kNoWatch)
+				return SCE_SLED_ERROR_INVALIDCONFIGURATION;
+
+			return SCE_SLED_ERROR_OK;
+		}
+	}
+
+	int32_t PerfWatch::create(const PerfWatchConfig& watchConfig, void *pLocation, PerfWatch **ppWatch)
+	{
+		SCE_SLED_ASSERT(pLocation != NULL);
+		SCE_SLED_ASSERT(ppWatch != NULL);
+
+		std::size_t iMemSize = 0;
+
+		const int32_t iConfigError = requiredMemory(watchConfig, &iMemSize);
+		if (iConfigError != 0)
+			return iConfigError;
+
+		SequentialAllocator allocator(pLocation, iMemSize);
+
+		PerfWatchSeats seats;
+		seats.Allocate(watchConfig, &allocator);
+
+		SCE_SLED_ASSERT(seats.m_this != NULL);
+		SCE_SLED_ASSERT(seats.m_watches != NULL);
+		SCE_SLED_ASSERT(seats.m_fnWatches != NULL);
+		SCE_SLED_ASSERT(seats.m_fnGenerations != NULL);
+		SCE_SLED_ASSERT(seats.m_incidents != NULL);
+
+		*ppWatch = new (seats.m_this) PerfWatch(watchConfig, &seats);
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t PerfWatch::requiredMemory(const PerfWatchConfig& watchConfig, std::size_t *iRequiredMemory)
+	{
+		SCE_SLED_ASSERT(iRequiredMemory != NULL);
+
+		const int32_t iConfigError = ValidateConfig(watchConfig);
+		if (iConfigError != 0)
+			return iConfigError;
+
+		SequentialAllocatorCalculator allocator;
+
+		PerfWatchSeats seats;
+		seats.Allocate(watchConfig, &allocator);
+
+		*iRequiredMemory = allocator.bytesAllocated();
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t PerfWatch::requiredMemoryHelper(const PerfWatchConfig& watchConfig, ISequentialAllocator *pAllocator, void **ppThis)
+	{
+		SCE_SLED_ASSERT(pAllocator != NULL);
+		SCE_SLED_ASSERT(ppThis != NULL);
+
+		const int32_t iConfigError = ValidateConfig(watchConfig);
+		if (iConfigError != 0)
+			return iConfigError;
+
+		PerfWatchSeats seats;
+		seats.Allocate(watchConfig, pAllocator);
+
+		*ppThis = seats.m_this;
+		return SCE_SLED_ERROR_OK;
+	}
+
+	void PerfWatch::shutdown(PerfWatch *pWatch)
+	{
+		SCE_SLED_ASSERT(pWatch != NULL);
+		pWatch->~PerfWatch();
+	}
+
+	PerfWatch::PerfWatch(const PerfWatchConfig& watchConfig, const void *pWatchSeats)
+		: m_iMaxWatches(watchConfig.maxWatches)
+		, m_iMaxIncidents((watchConfig.maxWatches != 0) ? watchConfig.maxIncidents : 0)
+		, m_iMaxFunctions((watchConfig.maxWatches != 0) ? watchConfig.maxFunctions : 0)
+		, m_iNumWatches(0)
+		, m_iGeneration(1)
+		, m_iIncidentHead(0)
+		, m_iNumIncidents(0)
+		, m_iNumIncidentsTotal(0)
+	{
+		SCE_SLED_ASSERT(pWatchSeats != NULL);
+
+		const PerfWatchSeats *pSeats = static_cast<const PerfWatchSeats*>(pWatchSeats);
+
+		m_pWatches = static_cast<PerfWatchRule*>(pSeats->m_watches);
+		m_pFnWatches = static_cast<uint16_t*>(pSeats->m_fnWatches);
+		m_pFnGenerations = static_cast<uint32_t*>(pSeats->m_fnGenerations);
+		m_pIncidents = static_cast<PerfWatchIncident*>(pSeats->m_incidents);
+
+		for (uint16_t i = 0; i < m_iMaxWatches; i++)
+			m_pWatches[i].used = false;
+
+		for (uint16_t i = 0; i < m_iMaxFunctions; i++)
+			m_pFnGenerations[i] = 0;
+	}
+
+	int32_t PerfWatch::add(const char *pszFnName, const char *pszFnFile, uint32_t iBudget, uint32_t iFlags, uint16_t *pId)
+	{
+		SCE_SLED_ASSERT(pszFnName != NULL);
+		SCE_SLED_ASSERT(pId != NULL);
+
+		for (uint16_t i = 0; i < m_iMaxWatches; i++)
+		{
+			PerfWatchRule& rule = m_pWatches[i];
+			if (rule.used)
+				continue;
+
+			rule.fnNameHash = SledDebugger::generateFNV1AHash(pszFnName);
+			rule.fnFileHash = pszFnFile ? SledDebugger::generateFNV1AHash(pszFnFile) : 0;
+			rule.anyFile = (pszFnFile == NULL);
+			rule.used = true;
+			rule.budget = iBudget;
+			rule.flags = iFlags;
+
+			m_iNumWatches++;
+			forgetMatches();
+
+			*pId = i;
+			return SCE_SLED_ERROR_OK;
+		}
+
+		return SCE_SLED_LUA_ERROR_PERFWATCHESFULL;
+	}
+
+	bool PerfWatch::remove(uint16_t iId)
+	{
+		if ((iId >= m_iMaxWatches) || !m_pWatches[iId].used)
+			return false;
+
+		m_pWatches[iId].used = false;
+		m_iNumWatches--;
+		forgetMatches();
+
+		return true;
+	}
+
+	const PerfWatchIncident *PerfWatch::check(const ProfileStack *pStack, const ProfileEntry *pEntry, uint64_t iFrame)
+	{
+		SCE_SLED_ASSERT(pStack != NULL);
+		SCE_SLED_ASSERT(pEntry != NULL);
+
+		const uint32_t iFn = pStack->getFnIndex(pEntry);
+		if (iFn >= m_iMaxFunctions)
+			return 0;
+
+		// Names are only compared the first time a function returns
+		// after the watches change
+		if (m_pFnGenerations[iFn] != m_iGeneration)
+		{
+			m_pFnWatches[iFn] = findWatch(pEntry);
+			m_pFnGenerations[iFn] = m_iGeneration;
+		}
+
+		const uint16_t iWatch = m_pFnWatches[iFn];
+		if (iWatch == kNoWatch)
+			return 0;
+
+		const PerfWatchRule& rule = m_pWatches[iWatch];
+		const uint64_t iTime = ((rule.flags & PerfWatchFlags::kInnerTime) != 0)
+			? pEntry->getFnLastTimeInnerElapsed()
+			: pEntry->getFnLastTimeElapsed();
+
+		if (iTime <= rule.budget)
+			return 0;
+
+		m_iNumIncidentsTotal++;
+
+		PerfWatchIncident& incident = m_pIncidents[m_iIncidentHead];
+		incident.watch = iWatch;
+		incident.flags = rule.flags;
+		incident.frame = iFrame;
+		incident.budget = rule.budget;
+		incident.timeElapsed = pEntry->getFnLastTimeElapsed();
+		incident.timeInnerElapsed = pEntry->getFnLastTimeInnerElapsed();
+
+		// The call has already left the stack; keep the innermost callers
+		const uint16_t iMaxCallers = PerfIncident::kMaxCallPathDepth - 1;
+		const uint16_t iDepth = pStack->getCallStackDepth();
+		const uint16_t iFirst = (iDepth > iMaxCallers) ? (iDepth - iMaxCallers) : 0;
+
+		incident.callPathDepth = 0;
+		incident.callPathTruncated = (iFirst != 0);
+		for (uint16_t i = iFirst; i < iDepth; i++)
+			incident.callPath[incident.callPathDepth++] = pStack->getFnIndex(pStack->getCallStackFn(i));
+		incident.callPath[incident.callPathDepth++] = iFn;
+
+		if (++m_iIncidentHead == m_iMaxIncidents)
+			m_iIncidentHead = 0;
+
+		if (m_iNumIncidents < m_iMaxIncidents)
+			m_iNumIncidents++;
+
+		return &incident;
+	}
+
+	void PerfWatch::clear()
+	{
+		m_iIncidentHead = 0;
+		m_iNumIncidents = 0;
+		m_iNumIncidentsTotal = 0;
+
+		forgetMatches();
+	}
+
+	bool PerfWatch::getIncident(const ProfileStack *pStack, uint16_t iIndex, PerfIncident *pIncident) const
+	{
+		SCE_SLED_ASSERT(pStack != NULL);
+		SCE_SLED_ASSERT(pIncident != NULL);
+
+		if (iIndex >= m_iNumIncidents)
+			return false;
+
+		const PerfWatchIncident& incident = m_pIncidents[(m_iIncidentHead + m_iMaxIncidents - 1 - iIndex) % m_iMaxIncidents];
+		const ProfileEntry *pEntry = pStack->getFn(incident.callPath[incident.callPathDepth - 1]);
+		SCE_SLED_ASSERT(pEntry != NULL);
+
+		pIncident->watch = incident.watch;
+		pIncident->frame = incident.frame;
+		pIncident->budget = incident.budget;
+		pIncident->timeElapsed = incident.timeElapsed;
+		pIncident->timeInnerElapsed = incident.timeInnerElapsed;
+		pIncident->source = pEntry->getFnFile();
+		pIncident->line = pEntry->getFnLine();
+		pIncident->callPathDepth = incident.callPathDepth;
+		pIncident->callPathTruncated = incident.callPathTruncated;
+
+		// Functions without a name are tagged ":<line>:<file>" for SLED to look up
+		for (uint16_t i = 0; i < incident.callPathDepth; i++)
+		{
+			const char *pszFnName = pStack->getFn(incident.callPath[i])->getFnName();
+			pIncident->callPath[i] = (pszFnName[0] == ':') ? "(anonymous)" : pszFnName;
+		}
+
+		return true;
+	}
+
+	uint16_t PerfWatch::findWatch(const ProfileEntry *pEntry) const
+	{
+		for (uint16_t i = 0; i < m_iMaxWatches; i++)
+		{
+			const PerfWatchRule& rule = m_pWatches[i];
+
+			if (!rule.used || (rule.fnNameHash != pEntry->getFnNameHash()))
+				continue;
+
+			if (rule.anyFile || (rule.fnFileHash == pEntry->getFnFileHash()))
+				return i;
+		}
+
+		return kNoWatch;
+	}
+
+	void PerfWatch::forgetMatches()
+	{
+		// Generation 0 is what the functions start at
+		if (++m_iGeneration == 0)
+		{
+			for (uint16_t i = 0; i < m_iMaxFunctions; i++)
+				m_pFnGenerations[i] = 0;
+
+			m_iGeneration = 1;
+		}
+	}
+}}
@@ -0,0 +1,129 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#ifndef __SCE_LIBSLEDLUAPLUGIN_PERFWATCH_H__
+#define __SCE_LIBSLEDLUAPLUGIN_PERFWATCH_H__
+
+#include "../sledcore/base_types.h"
+#include <cstddef>
+
+#include "../sleddebugger/common.h"
+#include "params.h"
+
+namespace sce { namespace Sled
+{
+	// Forward declarations
+	class ISequentialAllocator;
+	class ProfileStack;
+	class ProfileEntry;
+
+	// Forward declarations
+	struct LuaPluginConfig;
+
+	struct SCE_SLED_LINKAGE PerfWatchConfig
+	{
+		PerfWatchConfig() : maxWatches(0), maxIncidents(0), maxFunctions(0) {}
+		PerfWatchConfig(const PerfWatchConfig& rhs) { init(rhs); }
+		PerfWatchConfig& operator=(const PerfWatchConfig& rhs) { init(rhs); return *this; }
+
+		PerfWatchConfig(const LuaPluginConfig *pConfig);
+
+	private:
+		void init(const PerfWatchConfig& rhs);
+	public:
+
+		uint16_t		maxWatches;		///< Maximum number of watches at once (0 disables watches)
+		uint16_t		maxIncidents;	///< Number of most recent incidents kept
+		uint16_t		maxFunctions;	///< Maximum number of functions the profile stack tracks
+	};
+
+	// A function's time budget; functions are matched the way the profile
+	// stack matches them, by hashes
+	struct SCE_SLED_LINKAGE PerfWatchRule
+	{
+		uint32_t	fnNameHash;
+		uint32_t	fnFileHash;
+		bool		anyFile;
+		bool		used;
+		uint32_t	budget;
+		uint32_t	flags;
+	};
+
+	// An incident with its call path as ProfileStack indices
+	struct SCE_SLED_LINKAGE PerfWatchIncident
+	{
+		uint16_t	watch;
+		uint32_t	flags;
+		uint64_t	frame;
+		uint32_t	budget;
+		uint64_t	timeElapsed;
+		uint64_t	timeInnerElapsed;
+		uint16_t	callPathDepth;
+		bool		callPathTruncated;
+		uint32_t	callPath[PerfIncident::kMaxCallPathDepth];
+	};
+
+	// Time budgets of profiled functions, checked as each call returns,
+	// and a ring of the last maxIncidents calls over budget
+	class SCE_SLED_LINKAGE PerfWatch
+	{
+	public:
+		static const uint16_t kNoWatch = 0xFFFF;
+	public:
+		static int32_t create(const PerfWatchConfig& watchConfig, void *pLocation, PerfWatch **ppWatch);
+		static int32_t requiredMemory(const PerfWatchConfig& watchConfig, std::size_t *iRequiredMemory);
+		static int32_t requiredMemoryHelper(const PerfWatchConfig& watchConfig, ISequentialAllocator *pAllocator, void **ppThis);
+		static void shutdown(PerfWatch *pWatch);
+	private:
+		PerfWatch(const PerfWatchConfig& watchConfig, const void *pWatchSeats);
+		~PerfWatch() {}
+		PerfWatch(const PerfWatch&);
+		PerfWatch& operator=(const PerfWatch&);
+	public:
+		// pszFnFile may be NULL to match the function in any script
+		int32_t add(const char *pszFnName, const char *pszFnFile, uint32_t iBudget, uint32_t iFlags, uint16_t *pId);
+		bool remove(uint16_t iId);
+
+		// Keeps & returns an incident if pEntry, whose call just returned,
+		// is watched & went over budget; NULL otherwise
+		const PerfWatchIncident *check(const ProfileStack *pStack, const ProfileEntry *pEntry, uint64_t iFrame);
+
+		// Forgets the incidents & which watch each function matched;
+		// function indices of the stack are about to go
+		void clear();
+
+		// 0 is the most recent; false if there isn't one that recent
+		bool getIncident(const ProfileStack *pStack, uint16_t iIndex, PerfIncident *pIncident) const;
+
+		inline bool isEnabled() const					{ return m_iMaxWatches != 0; }
+		inline bool hasWatches() const					{ return m_iNumWatches != 0; }
+		inline uint16_t getNumWatches() const			{ return m_iNumWatches; }
+		inline uint16_t getNumIncidents() const			{ return m_iNumIncidents; }
+		inline uint64_t getNumIncidentsTotal() const	{ return m_iNumIncidentsTotal; }
+	private:
+		uint16_t findWatch(const ProfileEntry *pEntry) const;
+		void forgetMatches();
+	private:
+		const uint16_t		m_iMaxWatches;
+		const uint16_t		m_iMaxIncidents;
+		const uint16_t		m_iMaxFunctions;
+
+		PerfWatchRule*		m_pWatches;
+		uint16_t			m_iNumWatches;
+
+		// Watch matched to each function by ProfileStack index, good while
+		// its generation is the current one
+		uint16_t*			m_pFnWatches;
+		uint32_t*			m_pFnGenerations;
+		uint32_t			m_iGeneration;
+
+		PerfWatchIncident*	m_pIncidents;
+		uint16_t			m_iIncidentHead;
+		uint16_t			m_iNumIncidents;
+		uint64_t			m_iNumIncidentsTotal;
+	};
+}}
+
+#endif // __SCE_LIBSLEDLUAPLUGIN_PERFWATCH_H__
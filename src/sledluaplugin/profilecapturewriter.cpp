@@ -0,0 +1,187 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "profilecapturewriter.h"
+#include "profilestack.h"
+#include "sledluaplugin.h"
+#include "../sleddebugger/assert.h"
+
+#include <cstring>
+
+namespace sce { namespace Sled
+{
+	ProfileCaptureWriter::ProfileCaptureWriter(ProfileCaptureWriteCallback pfnWrite, void *pUserData)
+		: m_pfnWrite(pfnWrite)
+		, m_pUserData(pUserData)
+		, m_iBufferSize(0)
+		, m_iNumFunctions(0)
+		, m_iNumBytes(0)
+		, m_bFailed(pfnWrite == NULL)
+	{
+	}
+
+	void ProfileCaptureWriter::begin()
+	{
+		putByte('S');
+		putByte('L');
+		putByte('P');
+		putByte('C');
+		putByte(kVersion);
+	}
+
+	void ProfileCaptureWriter::addInfo(const char *pszBuildId, uint64_t iTimeProfiled, uint64_t iNumFrames, const ProfileOverhead& overhead)
+	{
+		putByte(kTagInfo);
+		putString(pszBuildId ? pszBuildId : "");
+		putVarint(SCE_LIBSLEDLUAPLUGIN_VER_MAJOR);
+		putVarint(SCE_LIBSLEDLUAPLUGIN_VER_MINOR);
+		putVarint(SCE_LIBSLEDLUAPLUGIN_VER_REVISION);
+		putVarint(iTimeProfiled);
+		putVarint(iNumFrames);
+		putVarint(overhead.calibrationCalls);
+		putVarint(overhead.selfTime);
+		putVarint(overhead.callTime);
+	}
+
+	void ProfileCaptureWriter::addFunction(const ProfileCaptureFunction& function)
+	{
+		SCE_SLED_ASSERT(function.name != NULL);
+		SCE_SLED_ASSERT(function.file != NULL);
+
+		putByte(kTagFunction);
+		putString(function.name);
+		putString(function.file);
+		putSigned(function.line);
+		putVarint(function.callCount);
+		putVarint(function.timeElapsed);
+		putVarint(function.timeElapsedShortest);
+		putVarint(function.timeElapsedLongest);
+		putVarint(function.timeInnerElapsed);
+		putVarint(function.timeInnerElapsedShortest);
+		putVarint(function.timeInnerElapsedLongest);
+		putVarint(function.timeElapsedCorrected);
+		putVarint(function.timeInnerElapsedCorrected);
+
+		m_iNumFunctions++;
+	}
+
+	void ProfileCaptureWriter::addEdge(uint32_t iCaller, uint32_t iCallee)
+	{
+		SCE_SLED_ASSERT(iCaller < m_iNumFunctions);
+		SCE_SLED_ASSERT(iCallee < m_iNumFunctions);
+
+		putByte(kTagEdge);
+		putVarint(iCaller);
+		putVarint(iCallee);
+	}
+
+	void ProfileCaptureWriter::addCallPath(uint32_t iParent, uint32_t iFunction, uint32_t iCallCount, uint64_t iTimeInclusive)
+	{
+		SCE_SLED_ASSERT(iFunction < m_iNumFunctions);
+
+		putByte(kTagCallPath);
+		putVarint((iParent == ProfileCallPath::kNone) ? 0 : ((uint64_t)iParent + 1));
+		putVarint(iFunction);
+		putVarint(iCallCount);
+		putVarint(iTimeInclusive);
+	}
+
+	void ProfileCaptureWriter::addHistogram(uint32_t iFunction, uint8_t iWhich, const ProfileLatencyHistogram& histogram)
+	{
+		SCE_SLED_ASSERT(iFunction < m_iNumFunctions);
+		SCE_SLED_ASSERT((iWhich == kHistogramElapsed) || (iWhich == kHistogramInner));
+
+		uint16_t iNumUsed = 0;
+		for (uint16_t i = 0; i < ProfileLatencyHistogram::kNumBuckets; i++)
+		{
+			if (histogram.counts[i] != 0)
+				iNumUsed++;
+		}
+
+		putByte(kTagHistogram);
+		putVarint(iFunction);
+		putByte(iWhich);
+		putVarint(histogram.count);
+		putVarint(histogram.longest);
+		putVarint(iNumUsed);
+
+		uint16_t iNext = 0;
+		for (uint16_t i = 0; i < ProfileLatencyHistogram::kNumBuckets; i++)
+		{
+			if (histogram.counts[i] == 0)
+				continue;
+
+			putVarint(i - iNext);
+			putVarint(histogram.counts[i]);
+			iNext = i + 1;
+		}
+	}
+
+	void ProfileCaptureWriter::addMemory(uint32_t iFunction, uint32_t iAllocCount, uint64_t iAllocBytes, uint64_t iFreeBytes)
+	{
+		SCE_SLED_ASSERT(iFunction < m_iNumFunctions);
+
+		putByte(kTagMemory);
+		putVarint(iFunction);
+		putVarint(iAllocCount);
+		putVarint(iAllocBytes);
+		putVarint(iFreeBytes);
+	}
+
+	bool ProfileCaptureWriter::end()
+	{
+		putByte(kTagEnd);
+		putVarint(m_iNumFunctions);
+		flush();
+
+		return !m_bFailed;
+	}
+
+	void ProfileCaptureWriter::putByte(uint8_t iByte)
+	{
+		if (m_iBufferSize == kMaxWriteSize)
+			flush();
+
+		m_buffer[m_iBufferSize++] = iByte;
+	}
+
+	void ProfileCaptureWriter::putVarint(uint64_t iValue)
+	{
+		while (iValue >= 0x80)
+		{
+			putByte((uint8_t)(iValue | 0x80));
+			iValue >>= 7;
+		}
+
+		putByte((uint8_t)iValue);
+	}
+
+	void ProfileCaptureWriter::putSigned(int64_t iValue)
+	{
+		putVarint((iValue < 0) ? ((((uint64_t)~iValue) << 1) | 1) : ((uint64_t)iValue << 1));
+	}
+
+	void ProfileCaptureWriter::putString(const char *pszString)
+	{
+		const std::size_t iLen = std::strlen(pszString);
+
+		putVarint(iLen);
+		for (std::size_t i = 0; i < iLen; i++)
+			putByte((uint8_t)pszString[i]);
+	}
+
+	void ProfileCaptureWriter::flush()
+	{
+		if (!m_bFailed && (m_iBufferSize > 0))
+		{
+			if (m_pfnWrite(m_buffer, m_iBufferSize, m_pUserData))
+				m_iNumBytes += m_iBufferSize;
+			else
+				m_bFailed = true;
+		}
+
+		m_iBufferSize = 0;
+	}
+}}
@@ -0,0 +1,121 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#ifndef __SCE_LIBSLEDLUAPLUGIN_PROFILECAPTUREWRITER_H__
+#define __SCE_LIBSLEDLUAPLUGIN_PROFILECAPTUREWRITER_H__
+
+#include "../sledcore/base_types.h"
+#include <cstddef>
+
+#include "../sleddebugger/common.h"
+#include "params.h"
+
+namespace sce { namespace Sled
+{
+	struct ProfileLatencyHistogram;
+
+	// One profiled function as written to a capture; times in microseconds
+	struct ProfileCaptureFunction
+	{
+		const char	*name;
+		const char	*file;
+		int32_t		line;
+		uint32_t	callCount;
+		uint64_t	timeElapsed;
+		uint64_t	timeElapsedShortest;
+		uint64_t	timeElapsedLongest;
+		uint64_t	timeInnerElapsed;
+		uint64_t	timeInnerElapsedShortest;
+		uint64_t	timeInnerElapsedLongest;
+		uint64_t	timeElapsedCorrected;
+		uint64_t	timeInnerElapsedCorrected;
+	};
+
+	// Encodes a whole profile in the compact binary form handed to
+	// luaPluginWriteProfileCapture callbacks and read back by the
+	// profile diff tool. All numbers other than the version are unsigned
+	// LEB128 varints; strings are a length then that many bytes, and
+	// signed numbers are zigzag encoded. Functions are numbered in the
+	// order they are written, call paths likewise.
+	//
+	//   header     'S' 'L' 'P' 'C', version byte
+	//   info       kTagInfo, build id string, plugin major, minor and
+	//              revision, microseconds profiled, frames marked,
+	//              calibration calls, self & call overhead (nanoseconds)
+	//   function   kTagFunction, name, file, line (zigzag), call count,
+	//              time, shortest, longest, inner time, inner shortest,
+	//              inner longest, corrected time, corrected inner time
+	//   edge       kTagEdge, caller function, callee function
+	//   call path  kTagCallPath, parent path + 1 (0 for none), function,
+	//              call count, inclusive time
+	//   histogram  kTagHistogram, function, kHistogramElapsed or
+	//              kHistogramInner, call count, longest, number of used
+	//              buckets, then for each the gap from the previous used
+	//              bucket + 1 (the bucket itself for the first) and count
+	//   memory     kTagMemory, function, allocation count, bytes
+	//              allocated, bytes freed; only functions that had any
+	//              (version 2 on)
+	//   end        kTagEnd, number of functions
+	//
+	// Edges, histograms and memory only name functions already written,
+	// and call paths only parents already written. The output goes to the
+	// callback kMaxWriteSize bytes at a time at most; once the callback
+	// returns false nothing else is written.
+	class SCE_SLED_LINKAGE ProfileCaptureWriter
+	{
+	public:
+		static const uint8_t kVersion = 2;
+		static const uint8_t kTagEnd = 0;
+		static const uint8_t kTagInfo = 1;
+		static const uint8_t kTagFunction = 2;
+		static const uint8_t kTagEdge = 3;
+		static const uint8_t kTagCallPath = 4;
+		static const uint8_t kTagHistogram = 5;
+		static const uint8_t kTagMemory = 6;
+		static const uint8_t kHistogramElapsed = 0;
+		static const uint8_t kHistogramInner = 1;
+		static const int32_t kMaxWriteSize = 512;
+
+		ProfileCaptureWriter(ProfileCaptureWriteCallback pfnWrite, void *pUserData);
+	private:
+		ProfileCaptureWriter(const ProfileCaptureWriter&);
+		ProfileCaptureWriter& operator=(const ProfileCaptureWriter&);
+	public:
+		void begin();
+
+		// pszBuildId may be NULL; it's written as an empty string
+		void addInfo(const char *pszBuildId, uint64_t iTimeProfiled, uint64_t iNumFrames, const ProfileOverhead& overhead);
+		void addFunction(const ProfileCaptureFunction& function);
+		void addEdge(uint32_t iCaller, uint32_t iCallee);
+		void addCallPath(uint32_t iParent, uint32_t iFunction, uint32_t iCallCount, uint64_t iTimeInclusive);
+		void addHistogram(uint32_t iFunction, uint8_t iWhich, const ProfileLatencyHistogram& histogram);
+		void addMemory(uint32_t iFunction, uint32_t iAllocCount, uint64_t iAllocBytes, uint64_t iFreeBytes);
+
+		// Writes the end marker and flushes; false if the callback failed
+		bool end();
+
+		inline uint32_t getNumFunctions() const { return m_iNumFunctions; }
+		inline uint64_t getNumBytes() const { return m_iNumBytes; }
+		inline bool hasFailed() const { return m_bFailed; }
+	private:
+		void putByte(uint8_t iByte);
+		void putVarint(uint64_t iValue);
+		void putSigned(int64_t iValue);
+		void putString(const char *pszString);
+		void flush();
+	private:
+		ProfileCaptureWriteCallback	m_pfnWrite;
+		void						*m_pUserData;
+
+		uint8_t		m_buffer[kMaxWriteSize];
+		int32_t		m_iBufferSize;
+
+		uint32_t	m_iNumFunctions;
+		uint64_t	m_iNumBytes;
+		bool		m_bFailed;
+	};
+}}
+
+#endif // __SCE_LIBSLEDLUAPLUGIN_PROFILECAPTUREWRITER_H__
@@ -0,0 +1,306 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "profilefilter.h"
+#include "sledluaplugin.h"
+#include "../sleddebugger/assert.h"
+#include "../sleddebugger/errorcodes.h"
+#include "../sleddebugger/sequentialallocator.h"
+
+#include <new>
+#include <cstring>
+
+namespace sce { namespace Sled
+{
+	void ProfileFilterConfig::init(const ProfileFilterConfig& rhs)
+	{
+		maxFilters = rhs.maxFilters;
+		maxPatternLen = rhs.maxPatternLen;
+	}
+
+	ProfileFilterConfig::ProfileFilterConfig(const LuaPluginConfig *pConfig)
+	{
+		SCE_SLED_ASSERT(pConfig != NULL);
+
+		maxFilters = pConfig->maxProfileFilters;
+		maxPatternLen = pConfig->maxProfileFilterPatternLen;
+	}
+
+	namespace
+	{
+		struct ProfileFilterSeats
+		{
+			void *m_this;
+			void *m_patterns;
+			void *m_text;
+
+			void Allocate(const ProfileFilterConfig& filterConfig, ISequentialAllocator *pAllocator)
+			{
+				// For this
+				m_this = pAllocator->allocate(sizeof(ProfileFilter), __alignof(ProfileFilter));
+
+				// For m_pPatterns
+				m_patterns = pAllocator->allocate(sizeof(ProfileFilterPattern) * filterConfig.maxFilters, __alignof(ProfileFilterPattern));
+
+				// For m_pText (each pattern & its terminator)
+				m_text = pAllocator->allocate(sizeof(char) * filterConfig.maxFilters * (filterConfig.maxPatternLen + 1), __alignof(char));
+			}
+		};
+
+		inline int32_t ValidateConfig(const ProfileFilterConfig& config)
+		{
+			const bool bAnyFilters = config.maxFilters != 0;
+			const bool bAnyLength = config.maxPatternLen != 0;
+
+			if ((bAnyFilters && !bAnyLength) || (!bAnyFilters && bAnyLength))
+				return SCE_SLED_ERROR_INVALIDCONFIGURATION;
+
+			return SCE_SLED_ERROR_OK;
+		}
+	}
+
+	int32_t ProfileFilter::create(const ProfileFilterConfig& filterConfig, void *pLocation, ProfileFilter **ppFilter)
+	{
+		SCE_SLED_ASSERT(pLocation != NULL);
+		SCE_SLED_ASSERT(ppFilter != NULL);
+
+		std::size_t iMemSize = 0;
+
+		const int32_t iConfigError = requiredMemory(filterConfig, &iMemSize);
+		if (iConfigError != 0)
+			return iConfigError;
+
+		SequentialAllocator allocator(pLocation, iMemSize);
+
+		ProfileFilterSeats seats;
+		seats.Allocate(filterConfig, &allocator);
+
+		SCE_SLED_ASSERT(seats.m_this != NULL);
+		SCE_SLED_ASSERT(seats.m_patterns != NULL);
+		SCE_SLED_ASSERT(seats.m_text != NULL);
+
+		*ppFilter = new (seats.m_this) ProfileFilter(filterConfig, &seats);
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t ProfileFilter::requiredMemory(const ProfileFilterConfig& filterConfig, std::size_t *iRequiredMemory)
+	{
+		SCE_SLED_ASSERT(iRequiredMemory != NULL);
+
+		const int32_t iConfigError = ValidateConfig(filterConfig);
+		if (iConfigError != 0)
+			return iConfigError;
+
+		SequentialAllocatorCalculator allocator;
+
+		ProfileFilterSeats seats;
+		seats.Allocate(filterConfig, &allocator);
+
+		*iRequiredMemory = allocator.bytesAllocated();
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t ProfileFilter::requiredMemoryHelper(const ProfileFilterConfig& filterConfig, ISequentialAllocator *pAllocator, void **ppThis)
+	{
+		SCE_SLED_ASSERT(pAllocator != NULL);
+		SCE_SLED_ASSERT(ppThis != NULL);
+
+		const int32_t iConfigError = ValidateConfig(filterConfig);
+		if (iConfigError != 0)
+			return iConfigError;
+
+		ProfileFilterSeats seats;
+		seats.Allocate(filterConfig, pAllocator);
+
+		*ppThis = seats.m_this;
+		return SCE_SLED_ERROR_OK;
+	}
+
+	void ProfileFilter::shutdown(ProfileFilter *pFilter)
+	{
+		SCE_SLED_ASSERT(pFilter != NULL);
+		pFilter->~ProfileFilter();
+	}
+
+	ProfileFilter::ProfileFilter(const ProfileFilterConfig& filterConfig, const void *pFilterSeats)
+		: m_iMaxFilters(filterConfig.maxFilters)
+		, m_iMaxPatternLen(filterConfig.maxPatternLen)
+		, m_iNumFilters(0)
+	{
+		SCE_SLED_ASSERT(pFilterSeats != NULL);
+
+		const ProfileFilterSeats *pSeats = static_cast<const ProfileFilterSeats*>(pFilterSeats);
+
+		m_pPatterns = static_cast<ProfileFilterPattern*>(pSeats->m_patterns);
+		m_pText = static_cast<char*>(pSeats->m_text);
+
+		for (uint8_t i = 0; i < kNumKinds; i++)
+			m_iNumByKind[i] = 0;
+	}
+
+	int32_t ProfileFilter::add(ProfileFilterKind::Enum kind, const char *pszPattern)
+	{
+		SCE_SLED_ASSERT(pszPattern != NULL);
+
+		if (((uint32_t)kind >= kNumKinds) || (pszPattern[0] == '\0'))
+			return SCE_SLED_ERROR_INVALIDPARAMETER;
+
+		const std::size_t iLen = std::strlen(pszPattern);
+		if (iLen > m_iMaxPatternLen)
+			return SCE_SLED_ERROR_INVALIDPARAMETER;
+
+		if (m_iNumFilters == m_iMaxFilters)
+			return SCE_SLED_LUA_ERROR_PROFILEFILTERSFULL;
+
+		ProfileFilterPattern& pattern = m_pPatterns[m_iNumFilters];
+		pattern.kind = (uint8_t)kind;
+		pattern.text = m_pText + (m_iNumFilters * (m_iMaxPatternLen + 1));
+
+		// Work out which stars there are; '?' always needs the full match
+		std::size_t iNumStars = 0;
+		bool bAnyQuestion = false;
+		for (std::size_t i = 0; i < iLen; i++)
+		{
+			if (pszPattern[i] == '*')
+				iNumStars++;
+			else if (pszPattern[i] == '?')
+				bAnyQuestion = true;
+		}
+
+		const bool bLeading = pszPattern[0] == '*';
+		const bool bTrailing = (iLen > 1) && (pszPattern[iLen - 1] == '*');
+		const std::size_t iEdgeStars = (bLeading ? 1 : 0) + (bTrailing ? 1 : 0);
+
+		pattern.minLen = (uint16_t)(iLen - iNumStars);
+
+		if (bAnyQuestion || (iNumStars != iEdgeStars))
+		{
+			pattern.shape = ProfileFilterPattern::kGlob;
+			std::memcpy(pattern.text, pszPattern, iLen);
+			pattern.textLen = (uint16_t)iLen;
+		}
+		else
+		{
+			if (bLeading && bTrailing)
+				pattern.shape = ProfileFilterPattern::kContains;
+			else if (bLeading)
+				pattern.shape = ProfileFilterPattern::kSuffix;
+			else if (bTrailing)
+				pattern.shape = ProfileFilterPattern::kPrefix;
+			else
+				pattern.shape = ProfileFilterPattern::kExact;
+
+			// Keep only the literal text between the stars
+			std::memcpy(pattern.text, pszPattern + (bLeading ? 1 : 0), pattern.minLen);
+			pattern.textLen = pattern.minLen;
+		}
+
+		pattern.text[pattern.textLen] = '\0';
+
+		m_iNumFilters++;
+		m_iNumByKind[kind]++;
+		return SCE_SLED_ERROR_OK;
+	}
+
+	void ProfileFilter::clear()
+	{
+		m_iNumFilters = 0;
+
+		for (uint8_t i = 0; i < kNumKinds; i++)
+			m_iNumByKind[i] = 0;
+	}
+
+	bool ProfileFilter::isSourceProfiled(const char *pszSource) const
+	{
+		return isProfiled(ProfileFilterKind::kIncludeSource, ProfileFilterKind::kExcludeSource, pszSource);
+	}
+
+	bool ProfileFilter::isFunctionProfiled(const char *pszFnName) const
+	{
+		return isProfiled(ProfileFilterKind::kIncludeFunction, ProfileFilterKind::kExcludeFunction, pszFnName);
+	}
+
+	bool ProfileFilter::isProfiled(ProfileFilterKind::Enum include, ProfileFilterKind::Enum exclude, const char *pszName) const
+	{
+		SCE_SLED_ASSERT(pszName != NULL);
+
+		if ((m_iNumByKind[include] != 0) && !isAnyMatch(include, pszName))
+			return false;
+
+		return (m_iNumByKind[exclude] == 0) || !isAnyMatch(exclude, pszName);
+	}
+
+	bool ProfileFilter::isAnyMatch(ProfileFilterKind::Enum kind, const char *pszName) const
+	{
+		const std::size_t iNameLen = std::strlen(pszName);
+
+		for (uint16_t i = 0; i < m_iNumFilters; i++)
+		{
+			if ((m_pPatterns[i].kind == kind) && isMatch(m_pPatterns[i], pszName, iNameLen))
+				return true;
+		}
+
+		return false;
+	}
+
+	bool ProfileFilter::isMatch(const ProfileFilterPattern& pattern, const char *pszName, std::size_t iNameLen)
+	{
+		if (iNameLen < pattern.minLen)
+			return false;
+
+		switch (pattern.shape)
+		{
+		case ProfileFilterPattern::kExact:
+			return (iNameLen == pattern.textLen) && (std::memcmp(pszName, pattern.text, iNameLen) == 0);
+		case ProfileFilterPattern::kPrefix:
+			return std::memcmp(pszName, pattern.text, pattern.textLen) == 0;
+		case ProfileFilterPattern::kSuffix:
+			return std::memcmp(pszName + iNameLen - pattern.textLen, pattern.text, pattern.textLen) == 0;
+		case ProfileFilterPattern::kContains:
+			return std::strstr(pszName, pattern.text) != NULL;
+		default:
+			return isGlobMatch(pattern.text, pszName);
+		}
+	}
+
+	bool ProfileFilter::isGlobMatch(const char *pszPattern, const char *pszName)
+	{
+		SCE_SLED_ASSERT(pszPattern != NULL);
+		SCE_SLED_ASSERT(pszName != NULL);
+
+		// On a mismatch only the last star needs to take one more
+		// character; earlier stars can't do any better
+		const char *pszStar = NULL;
+		const char *pszResume = NULL;
+
+		while (*pszName != '\0')
+		{
+			if (*pszPattern == '*')
+			{
+				pszStar = pszPattern++;
+				pszResume = pszName;
+			}
+			else if ((*pszPattern == '?') || (*pszPattern == *pszName))
+			{
+				pszPattern++;
+				pszName++;
+			}
+			else if (pszStar)
+			{
+				pszPattern = pszStar + 1;
+				pszName = ++pszResume;
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		while (*pszPattern == '*')
+			pszPattern++;
+
+		return *pszPattern == '\0';
+	}
+}}
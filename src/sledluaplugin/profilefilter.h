@@ -0,0 +1,106 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#ifndef __SCE_LIBSLEDLUAPLUGIN_PROFILEFILTER_H__
+#define __SCE_LIBSLEDLUAPLUGIN_PROFILEFILTER_H__
+
+#include "../sledcore/base_types.h"
+#include <cstddef>
+
+#include "../sleddebugger/common.h"
+#include "params.h"
+
+namespace sce { namespace Sled
+{
+	// Forward declarations
+	class ISequentialAllocator;
+
+	// Forward declarations
+	struct LuaPluginConfig;
+
+	struct SCE_SLED_LINKAGE ProfileFilterConfig
+	{
+		ProfileFilterConfig() : maxFilters(0), maxPatternLen(0) {}
+		ProfileFilterConfig(const ProfileFilterConfig& rhs) { init(rhs); }
+		ProfileFilterConfig& operator=(const ProfileFilterConfig& rhs) { init(rhs); return *this; }
+
+		ProfileFilterConfig(const LuaPluginConfig *pConfig);
+
+	private:
+		void init(const ProfileFilterConfig& rhs);
+	public:
+
+		uint16_t		maxFilters;		///< Maximum number of patterns of all kinds (0 disables filters)
+		uint16_t		maxPatternLen;	///< Maximum length of a pattern
+	};
+
+	// A glob compiled when it's added; most patterns only need one
+	// compare or search of their literal text
+	struct SCE_SLED_LINKAGE ProfileFilterPattern
+	{
+		enum Shape
+		{
+			kExact		= 0,	// abc
+			kPrefix		= 1,	// abc*
+			kSuffix		= 2,	// *abc
+			kContains	= 3,	// *abc*
+			kGlob		= 4,	// anything else; matched a character at a time
+		};
+
+		uint8_t		kind;
+		uint8_t		shape;
+		uint16_t	textLen;	///< Length of text; for kGlob the whole pattern
+		uint16_t	minLen;		///< Characters, other than '*', a name needs at least
+		char*		text;
+	};
+
+	// Include & exclude globs for the scripts and function names the
+	// profiler hooks. '*' matches any run of characters, path separators
+	// included, and '?' any one character
+	class SCE_SLED_LINKAGE ProfileFilter
+	{
+	public:
+		static const uint8_t kNumKinds = 4;
+	public:
+		static int32_t create(const ProfileFilterConfig& filterConfig, void *pLocation, ProfileFilter **ppFilter);
+		static int32_t requiredMemory(const ProfileFilterConfig& filterConfig, std::size_t *iRequiredMemory);
+		static int32_t requiredMemoryHelper(const ProfileFilterConfig& filterConfig, ISequentialAllocator *pAllocator, void **ppThis);
+		static void shutdown(ProfileFilter *pFilter);
+	private:
+		ProfileFilter(const ProfileFilterConfig& filterConfig, const void *pFilterSeats);
+		~ProfileFilter() {}
+		ProfileFilter(const ProfileFilter&);
+		ProfileFilter& operator=(const ProfileFilter&);
+	public:
+		int32_t add(ProfileFilterKind::Enum kind, const char *pszPattern);
+		void clear();
+
+		// With include patterns of its kind a name has to match one of
+		// them; it must match none of the exclude patterns
+		bool isSourceProfiled(const char *pszSource) const;
+		bool isFunctionProfiled(const char *pszFnName) const;
+
+		inline bool isEnabled() const			{ return m_iMaxFilters != 0; }
+		inline uint16_t getNumFilters() const	{ return m_iNumFilters; }
+		inline bool hasSourceFilters() const	{ return (m_iNumByKind[ProfileFilterKind::kIncludeSource] + m_iNumByKind[ProfileFilterKind::kExcludeSource]) != 0; }
+		inline bool hasFunctionFilters() const	{ return (m_iNumByKind[ProfileFilterKind::kIncludeFunction] + m_iNumByKind[ProfileFilterKind::kExcludeFunction]) != 0; }
+	public:
+		static bool isGlobMatch(const char *pszPattern, const char *pszName);
+	private:
+		bool isProfiled(ProfileFilterKind::Enum include, ProfileFilterKind::Enum exclude, const char *pszName) const;
+		bool isAnyMatch(ProfileFilterKind::Enum kind, const char *pszName) const;
+		static bool isMatch(const ProfileFilterPattern& pattern, const char *pszName, std::size_t iNameLen);
+	private:
+		const uint16_t			m_iMaxFilters;
+		const uint16_t			m_iMaxPatternLen;
+
+		ProfileFilterPattern*	m_pPatterns;
+		char*					m_pText;
+		uint16_t				m_iNumFilters;
+		uint16_t				m_iNumByKind[kNumKinds];
+	};
+}}
+
+#endif // __SCE_LIBSLEDLUAPLUGIN_PROFILEFILTER_H__
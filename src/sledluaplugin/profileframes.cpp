@@ -0,0 +1,431 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "profileframes.h"
+#include "profilestack.h"
+#include "sledluaplugin.h"
+#include "../sleddebugger/assert.h"
+#include "../sleddebugger/errorcodes.h"
+#include "../sleddebugger/sequentialallocator.h"
+#include "../sleddebugger/timer.h"
+
+#include <new>
+#include <cstring>
+
+namespace sce { namespace Sled
+{
+	void ProfileFramesConfig::init(const ProfileFramesConfig& rhs)
+	{
+		maxFrames = rhs.maxFrames;
+		maxSlowFrames = rhs.maxSlowFrames;
+		maxFunctions = rhs.maxFunctions;
+		frameBudget = rhs.frameBudget;
+	}
+
+	ProfileFramesConfig::ProfileFramesConfig(const LuaPluginConfig *pConfig)
+	{
+		SCE_SLED_ASSERT(pConfig != NULL);
+
+		maxFrames = pConfig->maxProfileFrames;
+		maxSlowFrames = pConfig->maxProfileSlowFrames;
+		maxFunctions = pConfig->maxProfileFunctions;
+		frameBudget = pConfig->profileFrameBudgetUs;
+	}
+
+	namespace
+	{
+		struct ProfileFramesSeats
+		{
+			void *m_this;
+			void *m_windowCells;
+			void *m_frameTimes;
+			void *m_profiledTimes;
+			void *m_totalCallCounts;
+			void *m_totalTimesElapsed;
+			void *m_totalTimesInnerElapsed;
+			void *m_slowCells;
+			void *m_slowFrames;
+			void *m_timer;
+
+			void Allocate(const ProfileFramesConfig& framesConfig, ISequentialAllocator *pAllocator)
+			{
+				// For this
+				m_this = pAllocator->allocate(sizeof(ProfileFrames), __alignof(ProfileFrames));
+
+				// Nothing per function unless enabled
+				const uint16_t iNumFunctions = (framesConfig.maxFrames != 0) ? framesConfig.maxFunctions : 0;
+
+				// For m_pWindowCells, m_pFrameTimes & m_pProfiledTimes
+				m_windowCells = pAllocator->allocate(sizeof(ProfileFrameCell) * framesConfig.maxFrames * iNumFunctions, __alignof(ProfileFrameCell));
+				m_frameTimes = pAllocator->allocate(sizeof(uint64_t) * framesConfig.maxFrames, __alignof(uint64_t));
+				m_profiledTimes = pAllocator->allocate(sizeof(uint64_t) * framesConfig.maxFrames, __alignof(uint64_t));
+
+				// For m_pTotalCallCounts, m_pTotalTimesElapsed & m_pTotalTimesInnerElapsed
+				m_totalCallCounts = pAllocator->allocate(sizeof(uint64_t) * iNumFunctions, __alignof(uint64_t));
+				m_totalTimesElapsed = pAllocator->allocate(sizeof(uint64_t) * iNumFunctions, __alignof(uint64_t));
+				m_totalTimesInnerElapsed = pAllocator->allocate(sizeof(uint64_t) * iNumFunctions, __alignof(uint64_t));
+
+				// For m_pSlowCells & m_pSlowFrames
+				m_slowCells = pAllocator->allocate(sizeof(ProfileFrameCell) * framesConfig.maxSlowFrames * iNumFunctions, __alignof(ProfileFrameCell));
+				m_slowFrames = pAllocator->allocate(sizeof(ProfileSlowFrame) * framesConfig.maxSlowFrames, __alignof(ProfileSlowFrame));
+
+				// For m_pTimer
+				Timer::requiredMemoryHelper(pAllocator, &m_timer);
+			}
+		};
+
+		inline int32_t ValidateConfig(const ProfileFramesConfig& config)
+		{
+			// Frames are rolled up from the functions the profile stack tracks
+			if ((config.maxFrames != 0) && (config.maxFunctions == 0))
+				return SCE_SLED_ERROR_INVALIDCONFIGURATION;
+
+			if ((config.maxSlowFrames != 0) && (config.maxFrames == 0))
+				return SCE_SLED_ERROR_INVALIDCONFIGURATION;
+
+			return SCE_SLED_ERROR_OK;
+		}
+
+		inline uint32_t ClampToCell(uint64_t iValue)
+		{
+			return (iValue > 0xFFFFFFFF) ? 0xFFFFFFFF : (uint32_t)iValue;
+		}
+
+		void FillFunction(const ProfileStack *pStack, uint32_t iFn, uint64_t iCallCount, uint64_t iTimeElapsed, uint64_t iTimeInnerElapsed, ProfileFrameFunction *pFunction)
+		{
+			const ProfileEntry *pEntry = pStack->getFn(iFn);
+			SCE_SLED_ASSERT(pEntry != NULL);
+
+			// Functions without a name are tagged ":<line>:<file>" for SLED to look up
+			pFunction->name = (pEntry->getFnName()[0] == ':') ? "(anonymous)" : pEntry->getFnName();
+			pFunction->source = pEntry->getFnFile();
+			pFunction->line = pEntry->getFnLine();
+			pFunction->callCount = ClampToCell(iCallCount);
+			pFunction->timeElapsed = iTimeElapsed;
+			pFunction->timeInnerElapsed = iTimeInnerElapsed;
+		}
+	}
+
+	int32_t ProfileFrames::create(const ProfileFramesConfig& framesConfig, void *pLocation, ProfileFrames **ppFrames)
+	{
+		SCE_SLED_ASSERT(pLocation != NULL);
+		SCE_SLED_ASSERT(ppFrames != NULL);
+
+		std::size_t iMemSize = 0;
+
+		const int32_t iConfigError = requiredMemory(framesConfig, &iMemSize);
+		if (iConfigError != 0)
+			return iConfigError;
+
+		SequentialAllocator allocator(pLocation, iMemSize);
+
+		ProfileFramesSeats seats;
+		seats.Allocate(framesConfig, &allocator);
+
+		SCE_SLED_ASSERT(seats.m_this != NULL);
+		SCE_SLED_ASSERT(seats.m_windowCells != NULL);
+		SCE_SLED_ASSERT(seats.m_frameTimes != NULL);
+		SCE_SLED_ASSERT(seats.m_profiledTimes != NULL);
+		SCE_SLED_ASSERT(seats.m_totalCallCounts != NULL);
+		SCE_SLED_ASSERT(seats.m_totalTimesElapsed != NULL);
+		SCE_SLED_ASSERT(seats.m_totalTimesInnerElapsed != NULL);
+		SCE_SLED_ASSERT(seats.m_slowCells != NULL);
+		SCE_SLED_ASSERT(seats.m_slowFrames != NULL);
+		SCE_SLED_ASSERT(seats.m_timer != NULL);
+
+		*ppFrames = new (seats.m_this) ProfileFrames(framesConfig, &seats);
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t ProfileFrames::requiredMemory(const ProfileFramesConfig& framesConfig, std::size_t *iRequiredMemory)
+	{
+		SCE_SLED_ASSERT(iRequiredMemory != NULL);
+
+		const int32_t iConfigError = ValidateConfig(framesConfig);
+		if (iConfigError != 0)
+			return iConfigError;
+
+		SequentialAllocatorCalculator allocator;
+
+		ProfileFramesSeats seats;
+		seats.Allocate(framesConfig, &allocator);
+
+		*iRequiredMemory = allocator.bytesAllocated();
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t ProfileFrames::requiredMemoryHelper(const ProfileFramesConfig& framesConfig, ISequentialAllocator *pAllocator, void **ppThis)
+	{
+		SCE_SLED_ASSERT(pAllocator != NULL);
+		SCE_SLED_ASSERT(ppThis != NULL);
+
+		const int32_t iConfigError = ValidateConfig(framesConfig);
+		if (iConfigError != 0)
+			return iConfigError;
+
+		ProfileFramesSeats seats;
+		seats.Allocate(framesConfig, pAllocator);
+
+		*ppThis = seats.m_this;
+		return SCE_SLED_ERROR_OK;
+	}
+
+	void ProfileFrames::shutdown(ProfileFrames *pFrames)
+	{
+		SCE_SLED_ASSERT(pFrames != NULL);
+		pFrames->~ProfileFrames();
+	}
+
+	ProfileFrames::ProfileFrames(const ProfileFramesConfig& framesConfig, const void *pFramesSeats)
+		: m_iMaxFrames(framesConfig.maxFrames)
+		, m_iMaxSlowFrames(framesConfig.maxSlowFrames)
+		, m_iMaxFunctions((framesConfig.maxFrames != 0) ? framesConfig.maxFunctions : 0)
+		, m_iFrameBudget(framesConfig.frameBudget)
+	{
+		SCE_SLED_ASSERT(pFramesSeats != NULL);
+
+		const ProfileFramesSeats *pSeats = static_cast<const ProfileFramesSeats*>(pFramesSeats);
+
+		m_pWindowCells = static_cast<ProfileFrameCell*>(pSeats->m_windowCells);
+		m_pFrameTimes = static_cast<uint64_t*>(pSeats->m_frameTimes);
+		m_pProfiledTimes = static_cast<uint64_t*>(pSeats->m_profiledTimes);
+		m_pTotalCallCounts = static_cast<uint64_t*>(pSeats->m_totalCallCounts);
+		m_pTotalTimesElapsed = static_cast<uint64_t*>(pSeats->m_totalTimesElapsed);
+		m_pTotalTimesInnerElapsed = static_cast<uint64_t*>(pSeats->m_totalTimesInnerElapsed);
+		m_pSlowCells = static_cast<ProfileFrameCell*>(pSeats->m_slowCells);
+		m_pSlowFrames = static_cast<ProfileSlowFrame*>(pSeats->m_slowFrames);
+
+		Timer::create(pSeats->m_timer, &m_pTimer);
+
+		clear();
+	}
+
+	void ProfileFrames::mark(ProfileStack *pStack)
+	{
+		SCE_SLED_ASSERT(pStack != NULL);
+
+		const uint64_t iNow = now();
+
+		if (!m_bFrameStarted)
+		{
+			m_bFrameStarted = true;
+			m_iFrameStart = iNow;
+			pStack->endFrame();
+			return;
+		}
+
+		const uint64_t iFrameTime = iNow - m_iFrameStart;
+		m_iFrameStart = iNow;
+
+		const bool bOverBudget = (m_iFrameBudget != 0) && (iFrameTime > m_iFrameBudget);
+		const uint16_t iFrame = m_iWindowHead;
+		ProfileFrameCell *pCells = &m_pWindowCells[iFrame * m_iMaxFunctions];
+
+		// Once the window is full the oldest frame, in the seat about to
+		// be taken, rolls out of the totals
+		if (m_iNumWindowFrames == m_iMaxFrames)
+		{
+			for (uint16_t i = 0; i < m_iMaxFunctions; i++)
+			{
+				m_pTotalCallCounts[i] -= pCells[i].callCount;
+				m_pTotalTimesElapsed[i] -= pCells[i].timeElapsed;
+				m_pTotalTimesInnerElapsed[i] -= pCells[i].timeInnerElapsed;
+			}
+
+			m_iTotalFrameTime -= m_pFrameTimes[iFrame];
+			m_iTotalProfiledTime -= m_pProfiledTimes[iFrame];
+
+			if ((m_iFrameBudget != 0) && (m_pFrameTimes[iFrame] > m_iFrameBudget))
+				m_iNumWindowFramesOverBudget--;
+		}
+		else
+		{
+			m_iNumWindowFrames++;
+		}
+
+		m_iNumFrames++;
+
+		ProfileSlowFrame *pSlowFrame = 0;
+		ProfileFrameCell *pSlowCells = 0;
+		if (bOverBudget && (m_iMaxSlowFrames != 0))
+		{
+			pSlowFrame = &m_pSlowFrames[m_iSlowHead];
+			pSlowFrame->frame = m_iNumFrames;
+			pSlowFrame->frameTime = iFrameTime;
+			pSlowFrame->numFunctions = 0;
+			pSlowCells = &m_pSlowCells[m_iSlowHead * m_iMaxFunctions];
+
+			if (++m_iSlowHead == m_iMaxSlowFrames)
+				m_iSlowHead = 0;
+
+			if (m_iNumSlowFrames < m_iMaxSlowFrames)
+				m_iNumSlowFrames++;
+		}
+
+		const uint16_t iNumFunctions = (uint16_t)pStack->getNumFunctions();
+		uint64_t iProfiledTime = 0;
+
+		for (uint16_t i = 0; i < m_iMaxFunctions; i++)
+		{
+			ProfileFrameCell& cell = pCells[i];
+			cell.fn = i;
+
+			const ProfileEntry *pEntry = (i < iNumFunctions) ? pStack->getFn(i) : 0;
+			if (!pEntry || (pEntry->getFnFrameCallCount() == 0))
+			{
+				cell.callCount = 0;
+				cell.timeElapsed = 0;
+				cell.timeInnerElapsed = 0;
+				continue;
+			}
+
+			cell.callCount = pEntry->getFnFrameCallCount();
+			cell.timeElapsed = ClampToCell(pEntry->getFnFrameTimeElapsed());
+			cell.timeInnerElapsed = ClampToCell(pEntry->getFnFrameTimeInnerElapsed());
+
+			m_pTotalCallCounts[i] += cell.callCount;
+			m_pTotalTimesElapsed[i] += cell.timeElapsed;
+			m_pTotalTimesInnerElapsed[i] += cell.timeInnerElapsed;
+			iProfiledTime += cell.timeInnerElapsed;
+
+			if (pSlowCells)
+				pSlowCells[pSlowFrame->numFunctions++] = cell;
+		}
+
+		m_pFrameTimes[iFrame] = iFrameTime;
+		m_pProfiledTimes[iFrame] = iProfiledTime;
+		m_iTotalFrameTime += iFrameTime;
+		m_iTotalProfiledTime += iProfiledTime;
+
+		if (pSlowFrame)
+			pSlowFrame->profiledTime = iProfiledTime;
+
+		if (bOverBudget)
+		{
+			m_iNumFramesOverBudget++;
+			m_iNumWindowFramesOverBudget++;
+		}
+
+		if (++m_iWindowHead == m_iMaxFrames)
+			m_iWindowHead = 0;
+
+		pStack->endFrame();
+	}
+
+	void ProfileFrames::skip()
+	{
+		m_bFrameStarted = false;
+	}
+
+	void ProfileFrames::preBreakpoint()
+	{
+		m_iBpStopTime = m_pTimer->elapsedMicroseconds();
+	}
+
+	void ProfileFrames::postBreakpoint()
+	{
+		m_iBpTotalTime += (m_pTimer->elapsedMicroseconds() - m_iBpStopTime);
+	}
+
+	void ProfileFrames::clear()
+	{
+		// Cells are written before they're read back, so only the totals
+		// need emptying
+		for (uint16_t i = 0; i < m_iMaxFunctions; i++)
+		{
+			m_pTotalCallCounts[i] = 0;
+			m_pTotalTimesElapsed[i] = 0;
+			m_pTotalTimesInnerElapsed[i] = 0;
+		}
+
+		m_iWindowHead = 0;
+		m_iNumWindowFrames = 0;
+		m_iNumWindowFramesOverBudget = 0;
+		m_iTotalFrameTime = 0;
+		m_iTotalProfiledTime = 0;
+
+		m_iSlowHead = 0;
+		m_iNumSlowFrames = 0;
+
+		m_iNumFrames = 0;
+		m_iNumFramesOverBudget = 0;
+		m_iFrameStart = 0;
+		m_bFrameStarted = false;
+
+		m_iBpStopTime = 0;
+		m_iBpTotalTime = 0;
+
+		m_pTimer->reset();
+	}
+
+	void ProfileFrames::getStats(ProfileFrameStats *pStats) const
+	{
+		SCE_SLED_ASSERT(pStats != NULL);
+
+		pStats->numFrames = m_iNumFrames;
+		pStats->numFramesOverBudget = m_iNumFramesOverBudget;
+		pStats->frameBudget = m_iFrameBudget;
+		pStats->windowFrames = m_iNumWindowFrames;
+		pStats->windowFramesOverBudget = m_iNumWindowFramesOverBudget;
+		pStats->windowFrameTime = m_iTotalFrameTime;
+		pStats->windowProfiledTime = m_iTotalProfiledTime;
+		pStats->numSlowFrames = m_iNumSlowFrames;
+
+		pStats->windowLongestFrameTime = 0;
+		for (uint16_t i = 0; i < m_iNumWindowFrames; i++)
+		{
+			if (m_pFrameTimes[i] > pStats->windowLongestFrameTime)
+				pStats->windowLongestFrameTime = m_pFrameTimes[i];
+		}
+	}
+
+	void ProfileFrames::forEachFunction(const ProfileStack *pStack, ProfileFrameFunctionCallback pfnCallback, void *pUserData) const
+	{
+		SCE_SLED_ASSERT(pStack != NULL);
+		SCE_SLED_ASSERT(pfnCallback != NULL);
+
+		const uint32_t iNumFunctions = (pStack->getNumFunctions() < m_iMaxFunctions) ? pStack->getNumFunctions() : m_iMaxFunctions;
+
+		for (uint32_t i = 0; i < iNumFunctions; i++)
+		{
+			if (m_pTotalCallCounts[i] == 0)
+				continue;
+
+			ProfileFrameFunction function;
+			FillFunction(pStack, i, m_pTotalCallCounts[i], m_pTotalTimesElapsed[i], m_pTotalTimesInnerElapsed[i], &function);
+			pfnCallback(&function, pUserData);
+		}
+	}
+
+	bool ProfileFrames::getSlowFrame(const ProfileStack *pStack, uint16_t iIndex, ProfileSlowFrame *pFrame, ProfileFrameFunctionCallback pfnCallback, void *pUserData) const
+	{
+		SCE_SLED_ASSERT(pStack != NULL);
+		SCE_SLED_ASSERT(pFrame != NULL);
+
+		if (iIndex >= m_iNumSlowFrames)
+			return false;
+
+		const uint16_t iSlot = (uint16_t)((m_iSlowHead + m_iMaxSlowFrames - 1 - iIndex) % m_iMaxSlowFrames);
+		*pFrame = m_pSlowFrames[iSlot];
+
+		if (pfnCallback)
+		{
+			const ProfileFrameCell *pCells = &m_pSlowCells[iSlot * m_iMaxFunctions];
+			for (uint16_t i = 0; i < pFrame->numFunctions; i++)
+			{
+				ProfileFrameFunction function;
+				FillFunction(pStack, pCells[i].fn, pCells[i].callCount, pCells[i].timeElapsed, pCells[i].timeInnerElapsed, &function);
+				pfnCallback(&function, pUserData);
+			}
+		}
+
+		return true;
+	}
+
+	uint64_t ProfileFrames::now() const
+	{
+		return m_pTimer->elapsedMicroseconds() - m_iBpTotalTime;
+	}
+}}
@@ -0,0 +1,134 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#ifndef __SCE_LIBSLEDLUAPLUGIN_PROFILEFRAMES_H__
+#define __SCE_LIBSLEDLUAPLUGIN_PROFILEFRAMES_H__
+
+#include "../sledcore/base_types.h"
+#include <cstddef>
+
+#include "../sleddebugger/common.h"
+#include "params.h"
+
+namespace sce { namespace Sled
+{
+	// Forward declarations
+	class Timer;
+	class ISequentialAllocator;
+	class ProfileStack;
+
+	// Forward declarations
+	struct LuaPluginConfig;
+
+	struct SCE_SLED_LINKAGE ProfileFramesConfig
+	{
+		ProfileFramesConfig() : maxFrames(0), maxSlowFrames(0), maxFunctions(0), frameBudget(0) {}
+		ProfileFramesConfig(const ProfileFramesConfig& rhs) { init(rhs); }
+		ProfileFramesConfig& operator=(const ProfileFramesConfig& rhs) { init(rhs); return *this; }
+
+		ProfileFramesConfig(const LuaPluginConfig *pConfig);
+
+	private:
+		void init(const ProfileFramesConfig& rhs);
+	public:
+
+		uint16_t		maxFrames;		///< Number of most recent frames rolled up (0 disables frame profiling)
+		uint16_t		maxSlowFrames;	///< Number of most recent frames over budget kept with a breakdown
+		uint16_t		maxFunctions;	///< Maximum number of functions the profile stack tracks
+		uint32_t		frameBudget;	///< Frame time, in microseconds, to go over to be over budget (0 for none)
+	};
+
+	// One function's calls in a frame, by ProfileStack index; times are
+	// microseconds
+	struct SCE_SLED_LINKAGE ProfileFrameCell
+	{
+		uint32_t	fn;
+		uint32_t	callCount;
+		uint32_t	timeElapsed;
+		uint32_t	timeInnerElapsed;
+	};
+
+	// Per function times of the last maxFrames frames, rolled up as
+	// frames are marked, and a breakdown of the last maxSlowFrames frames
+	// over budget. Frame times leave out time stopped on breakpoints.
+	class SCE_SLED_LINKAGE ProfileFrames
+	{
+	public:
+		static int32_t create(const ProfileFramesConfig& framesConfig, void *pLocation, ProfileFrames **ppFrames);
+		static int32_t requiredMemory(const ProfileFramesConfig& framesConfig, std::size_t *iRequiredMemory);
+		static int32_t requiredMemoryHelper(const ProfileFramesConfig& framesConfig, ISequentialAllocator *pAllocator, void **ppThis);
+		static void shutdown(ProfileFrames *pFrames);
+	private:
+		ProfileFrames(const ProfileFramesConfig& framesConfig, const void *pFramesSeats);
+		~ProfileFrames() {}
+		ProfileFrames(const ProfileFrames&);
+		ProfileFrames& operator=(const ProfileFrames&);
+	public:
+		// Ends the frame running since the last mark & starts the next;
+		// the first mark after a clear or skip only starts one
+		void mark(ProfileStack *pStack);
+		// Drops the frame running, for when the profiler wasn't on for all of it
+		void skip();
+		void preBreakpoint();
+		void postBreakpoint();
+
+		// Forgets every frame; function indices of pStack are about to go
+		void clear();
+
+		void getStats(ProfileFrameStats *pStats) const;
+		// Window totals of every function that ran in the window
+		void forEachFunction(const ProfileStack *pStack, ProfileFrameFunctionCallback pfnCallback, void *pUserData) const;
+		// 0 is the most recent; false if there isn't one that recent
+		bool getSlowFrame(const ProfileStack *pStack, uint16_t iIndex, ProfileSlowFrame *pFrame, ProfileFrameFunctionCallback pfnCallback, void *pUserData) const;
+
+		inline bool isEnabled() const				{ return m_iMaxFrames != 0; }
+		inline uint16_t getMaxFrames() const		{ return m_iMaxFrames; }
+		inline uint16_t getMaxSlowFrames() const	{ return m_iMaxSlowFrames; }
+		inline uint16_t getNumWindowFrames() const	{ return m_iNumWindowFrames; }
+		inline uint16_t getNumSlowFrames() const	{ return m_iNumSlowFrames; }
+		// Number of the frame running, counting from 1; 0 before the first mark
+		inline uint64_t getCurrentFrame() const		{ return m_bFrameStarted ? (m_iNumFrames + 1) : 0; }
+	private:
+		uint64_t now() const;
+	private:
+		const uint16_t		m_iMaxFrames;
+		const uint16_t		m_iMaxSlowFrames;
+		const uint16_t		m_iMaxFunctions;
+		const uint32_t		m_iFrameBudget;
+
+		// m_iMaxFunctions cells per frame in the window, by function index
+		ProfileFrameCell*	m_pWindowCells;
+		uint64_t*			m_pFrameTimes;
+		uint64_t*			m_pProfiledTimes;
+		uint16_t			m_iWindowHead;
+		uint16_t			m_iNumWindowFrames;
+		uint16_t			m_iNumWindowFramesOverBudget;
+
+		// Window totals, by function index
+		uint64_t*			m_pTotalCallCounts;
+		uint64_t*			m_pTotalTimesElapsed;
+		uint64_t*			m_pTotalTimesInnerElapsed;
+		uint64_t			m_iTotalFrameTime;
+		uint64_t			m_iTotalProfiledTime;
+
+		// Up to m_iMaxFunctions cells per slow frame, only the functions
+		// that ran in it
+		ProfileFrameCell*	m_pSlowCells;
+		ProfileSlowFrame*	m_pSlowFrames;
+		uint16_t			m_iSlowHead;
+		uint16_t			m_iNumSlowFrames;
+
+		uint64_t			m_iNumFrames;
+		uint64_t			m_iNumFramesOverBudget;
+		uint64_t			m_iFrameStart;
+		bool				m_bFrameStarted;
+
+		uint64_t			m_iBpStopTime;
+		uint64_t			m_iBpTotalTime;
+		Timer*				m_pTimer;
+	};
+}}
+
+#endif // __SCE_LIBSLEDLUAPLUGIN_PROFILEFRAMES_H__
@@ -4,6 +4,8 @@
  */
 
 #include "profilestack.h"
+#include "foldedstackwriter.h"
+#include "profilecapturewriter.h"
 #include "sledluaplugin.h"
 #include "../sleddebugger/assert.h"
 #include "../sleddebugger/errorcodes.h"
@@ -17,6 +19,87 @@
 
 namespace sce { namespace Sled
 {
+	namespace
+	{
+		inline uint64_t ToMicroseconds(float flSeconds)
+		{
+			return (flSeconds > 0.0f) ? (uint64_t)((double)flSeconds * 1000000.0 + 0.5) : 0;
+		}
+	}
+
+	void ProfileLatencyHistogram::clear()
+	{
+		std::memset(counts, 0, sizeof(counts));
+		count = 0;
+		longest = 0;
+	}
+
+	void ProfileLatencyHistogram::add(uint64_t iMicroseconds)
+	{
+		counts[getBucket(iMicroseconds)]++;
+		count++;
+
+		if (iMicroseconds > longest)
+			longest = iMicroseconds;
+	}
+
+	uint64_t ProfileLatencyHistogram::getValueAtPercentile(double flPercentile) const
+	{
+		if (count == 0)
+			return 0;
+
+		// Rank of the call wanted, counting from 1
+		uint64_t iRank = (uint64_t)((flPercentile / 100.0) * (double)count + 0.999999);
+		if (iRank < 1)
+			iRank = 1;
+		else if (iRank > count)
+			iRank = count;
+
+		uint64_t iSeen = 0;
+		for (uint16_t i = 0; i < kNumBuckets; i++)
+		{
+			iSeen += counts[i];
+			if (iSeen >= iRank)
+			{
+				const uint64_t iBound = getBucketUpperBound(i);
+				return (iBound < longest) ? iBound : longest;
+			}
+		}
+
+		return longest;
+	}
+
+	uint16_t ProfileLatencyHistogram::getBucket(uint64_t iMicroseconds)
+	{
+		if (iMicroseconds > 0xFFFFFFFF)
+			iMicroseconds = 0xFFFFFFFF;
+
+		if (iMicroseconds < kSubBuckets)
+			return (uint16_t)iMicroseconds;
+
+		uint16_t iTopBit = kSubBucketBits;
+		while ((iMicroseconds >> (iTopBit + 1)) != 0)
+			++iTopBit;
+
+		// Keep the top kSubBucketBits bits; the highest is always set
+		const uint16_t iShift = iTopBit - (kSubBucketBits - 1);
+		return (uint16_t)(kSubBuckets + ((iTopBit - kSubBucketBits) * (kSubBuckets / 2)) + ((iMicroseconds >> iShift) - (kSubBuckets / 2)));
+	}
+
+	uint64_t ProfileLatencyHistogram::getBucketUpperBound(uint16_t iBucket)
+	{
+		SCE_SLED_ASSERT(iBucket < kNumBuckets);
+
+		if (iBucket < kSubBuckets)
+			return iBucket;
+
+		const uint16_t iHalf = kSubBuckets / 2;
+		const uint16_t iShift = ((iBucket - kSubBuckets) / iHalf) + 1;
+		const uint64_t iLowerBound = (uint64_t)(iHalf + ((iBucket - kSubBuckets) % iHalf)) << iShift;
+
+		return iLowerBound + ((uint64_t)1 << iShift) - 1;
+	}
+
 	ProfileEntryFunctionConstIterator::ProfileEntryFunctionConstIterator(const ProfileEntry *pEntry)
 		: m_pEntry(pEntry)
 		, m_iIndex(0)
@@ -51,6 +134,19 @@ namespace sce { namespace Sled
 		, m_flFnTimeInnerElapsedShortest(0.0f)
 		, m_flFnTimeInnerElapsedLongest(0.0f)
 		, m_iNumFnCalls(0)
+		, m_pLatency(0)
+		, m_iFrameCallCount(0)
+		, m_iFrameTimeElapsed(0)
+		, m_iFrameTimeInnerElapsed(0)
+		, m_iLastTimeElapsed(0)
+		, m_iLastTimeInnerElapsed(0)
+		, m_iCallsAtEnter(0)
+		, m_flFnOverheadInner(0.0f)
+		, m_flFnTimeElapsedCorrected(0.0f)
+		, m_flFnTimeInnerElapsedCorrected(0.0f)
+		, m_iAllocCount(0)
+		, m_iAllocBytes(0)
+		, m_iFreeBytes(0)
 	{
 		Utilities::copyString(m_szFnName, kFuncLen, pszFnName);
 		Utilities::copyString(m_szFnFile, kSourceLen, pszFnFile);
@@ -97,6 +193,9 @@ namespace sce { namespace Sled
 	{
 		maxFunctions = rhs.maxFunctions;
 		maxCallStackDepth = rhs.maxCallStackDepth;
+		maxCallPaths = rhs.maxCallPaths;
+		maxHistograms = rhs.maxHistograms;
+		calibrationCalls = rhs.calibrationCalls;
 	}
 
 	ProfileStackConfig::ProfileStackConfig(const LuaPluginConfig *pConfig)
@@ -106,6 +205,9 @@ namespace sce { namespace Sled
 		maxFunctions = pConfig->maxProfileFunctions;
 		//maxFuncCalls = pConfig->maxProfileFunctionCalls;
 		maxCallStackDepth = pConfig->maxProfileCallStackDepth;
+		maxCallPaths = pConfig->maxProfileCallPaths;
+		maxHistograms = pConfig->maxProfileHistograms;
+		calibrationCalls = pConfig->profileCalibrationCalls;
 	}
 
 	namespace
@@ -115,6 +217,10 @@ namespace sce { namespace Sled
 			void *m_this;
 			void *m_funcs;
 			void *m_callStack;
+			void *m_histograms;
+			void *m_callPaths;
+			void *m_callPathStack;
+			void *m_callPathScratch;
 			void *m_timer;
 
 			void Allocate(const ProfileStackConfig& stackConfig, ISequentialAllocator *pAllocator)
@@ -128,6 +234,15 @@ namespace sce { namespace Sled
 				// For m_ppCallStack
 				m_callStack = pAllocator->allocate(sizeof(ProfileEntry*) * stackConfig.maxCallStackDepth, __alignof(ProfileEntry*));
 
+				// For m_pHistograms
+				m_histograms = pAllocator->allocate(sizeof(ProfileLatencyHistogram) * 2 * stackConfig.maxHistograms, __alignof(ProfileLatencyHistogram));
+
+				// For m_pCallPaths, m_pCallPathStack & m_pCallPathScratch
+				const uint16_t iCallPathDepth = (stackConfig.maxCallPaths != 0) ? stackConfig.maxCallStackDepth : 0;
+				m_callPaths = pAllocator->allocate(sizeof(ProfileCallPath) * stackConfig.maxCallPaths, __alignof(ProfileCallPath));
+				m_callPathStack = pAllocator->allocate(sizeof(uint32_t) * iCallPathDepth, __alignof(uint32_t));
+				m_callPathScratch = pAllocator->allocate(sizeof(uint32_t) * iCallPathDepth, __alignof(uint32_t));
+
 				// For m_pTimer
 				Timer::requiredMemoryHelper(pAllocator, &m_timer);
 			}
@@ -142,6 +257,20 @@ namespace sce { namespace Sled
 				(bAnyFunctions && !bAnyCallStack))
 				return SCE_SLED_ERROR_INVALIDCONFIGURATION;
 
+			// Call paths hang off the functions tracked
+			if (!bAnyFunctions && (config.maxCallPaths != 0))
+				return SCE_SLED_ERROR_INVALIDCONFIGURATION;
+
+			if (config.maxCallPaths == ProfileCallPath::kNone)
+				return SCE_SLED_ERROR_INVALIDCONFIGURATION;
+
+			if (config.maxHistograms > config.maxFunctions)
+				return SCE_SLED_ERROR_INVALIDCONFIGURATION;
+
+			// Calibration times calls made from inside another call
+			if ((config.calibrationCalls != 0) && ((config.maxFunctions < 2) || (config.maxCallStackDepth < 2)))
+				return SCE_SLED_ERROR_INVALIDCONFIGURATION;
+
 			return SCE_SLED_ERROR_OK;
 		}
 	}
@@ -165,6 +294,10 @@ namespace sce { namespace Sled
 		SCE_SLED_ASSERT(seats.m_this != NULL);
 		SCE_SLED_ASSERT(seats.m_funcs != NULL);
 		SCE_SLED_ASSERT(seats.m_callStack != NULL);
+		SCE_SLED_ASSERT(seats.m_histograms != NULL);
+		SCE_SLED_ASSERT(seats.m_callPaths != NULL);
+		SCE_SLED_ASSERT(seats.m_callPathStack != NULL);
+		SCE_SLED_ASSERT(seats.m_callPathScratch != NULL);
 		SCE_SLED_ASSERT(seats.m_timer != NULL);
 	
 		*ppStack = new (seats.m_this) ProfileStack(stackConfig, &seats);
@@ -215,6 +348,16 @@ namespace sce { namespace Sled
 		, m_iNumFuncs(0)
 		, m_iMaxCallStack(stackConfig.maxCallStackDepth)
 		, m_iNumCallStack(0)
+		, m_iMaxHistograms(stackConfig.maxHistograms)
+		, m_iMaxCallPaths(stackConfig.maxCallPaths)
+		, m_iNumCallPaths(0)
+		, m_iNumCallPathsDropped(0)
+		, m_iFirstRootCallPath(ProfileCallPath::kNone)
+		, m_iGeneration(1)
+		, m_iCalibrationCalls(stackConfig.calibrationCalls)
+		, m_iNumCallsEntered(0)
+		, m_flSelfOverhead(0.0f)
+		, m_flCallOverhead(0.0f)
 	{
 		SCE_SLED_ASSERT(pStackSeats != NULL);
 
@@ -222,6 +365,10 @@ namespace sce { namespace Sled
 
 		m_pFuncs = new (pSeats->m_funcs) ProfileEntry[stackConfig.maxFunctions];
 		m_ppCallStack = new (pSeats->m_callStack) ProfileEntry*[stackConfig.maxCallStackDepth];
+		m_pHistograms = static_cast<ProfileLatencyHistogram*>(pSeats->m_histograms);
+		m_pCallPaths = static_cast<ProfileCallPath*>(pSeats->m_callPaths);
+		m_pCallPathStack = static_cast<uint32_t*>(pSeats->m_callPathStack);
+		m_pCallPathScratch = static_cast<uint32_t*>(pSeats->m_callPathScratch);
 	
 		Timer::create(pSeats->m_timer, &m_pTimer);
 	}
@@ -240,33 +387,98 @@ namespace sce { namespace Sled
 	//	SCE_SLED_LOG(Logging::kInfo, "[SLED] [ProfileStack] Finished!");
 	//}
 
-	void ProfileStack::enterFn(const char *pszFnName, const char *pszFnFile, const int32_t& iFnLine)
+	ProfileEntry *ProfileStack::enterFn(const char *pszFnName, const char *pszFnFile, const int32_t& iFnLine)
 	{	
 		SCE_SLED_ASSERT(pszFnName != NULL);
 		SCE_SLED_ASSERT(pszFnFile != NULL);
 	
 		// Find the existing function (if any)
-		ProfileEntry *pEntry = findFn(pszFnName, pszFnFile, iFnLine);
+		return enterEntry(findFn(pszFnName, pszFnFile, iFnLine), pszFnName, pszFnFile, iFnLine);
+	}
+
+	ProfileEntry *ProfileStack::leaveFn(const char *pszFnName, const char *pszFnFile, const int32_t& iFnLine)
+	{
+		// Won't be any entries to modify
+		if (isEmpty())
+			return 0;
 
+		// Find this function
+		return leaveEntry(findFn(pszFnName, pszFnFile, iFnLine));
+	}
+
+	ProfileEntry *ProfileStack::leaveTop()
+	{
+		// Won't be any entries to modify
+		if (m_iNumCallStack == 0)
+			return 0;
+
+		return leaveEntry(m_ppCallStack[m_iNumCallStack - 1]);
+	}
+
+	ProfileEntry *ProfileStack::enterZone(ProfileZoneSite *pSite)
+	{
+		SCE_SLED_ASSERT(pSite != NULL);
+		SCE_SLED_ASSERT(pSite->name != NULL);
+		SCE_SLED_ASSERT(pSite->file != NULL);
+
+		ProfileEntry *pEntry = enterEntry(findZone(pSite), pSite->name, pSite->file, pSite->line);
+		if (pEntry)
+		{
+			pSite->owner = this;
+			pSite->generation = m_iGeneration;
+			pSite->index = (uint16_t)getFnIndex(pEntry);
+		}
+
+		return pEntry;
+	}
+
+	ProfileEntry *ProfileStack::leaveZone(ProfileZoneSite *pSite)
+	{
+		SCE_SLED_ASSERT(pSite != NULL);
+
+		if (isEmpty())
+			return 0;
+
+		return leaveEntry(findZone(pSite));
+	}
+
+	ProfileEntry *ProfileStack::findZone(const ProfileZoneSite *pSite) const
+	{
+		// Only the first time through since the last clear looks the zone up
+		if ((pSite->owner == this) && (pSite->generation == m_iGeneration) && (pSite->index < m_iNumFuncs))
+			return &m_pFuncs[pSite->index];
+
+		return findFn(pSite->name, pSite->file, pSite->line);
+	}
+
+	ProfileEntry *ProfileStack::enterEntry(ProfileEntry *pEntry, const char *pszFnName, const char *pszFnFile, const int32_t& iFnLine)
+	{
 		// Check if we can create a new entry	
 		if (!pEntry && (m_iNumFuncs == m_iMaxFuncs))
 		{
 			SCE_SLED_LOG(Logging::kError, "[SLED] Profile function list has no free space; can't add entry for function %s!", pszFnName);
-			return;
+			return 0;
 		}
 
 		// Check if we can add to callstack
 		if (m_iNumCallStack == m_iMaxCallStack)
 		{
 			SCE_SLED_LOG(Logging::kError, "[SLED] Profile callstack is full; can't add entry for function %s!", pszFnName);
-			return;
+			return 0;
 		}	
 
 		// Create new entry
 		if (!pEntry)
 		{
-			void *pSeat = &m_pFuncs[m_iNumFuncs++];
-			pEntry = new (pSeat) ProfileEntry(pszFnName, pszFnFile, iFnLine);
+			const uint16_t iFunc = m_iNumFuncs++;
+			pEntry = new (&m_pFuncs[iFunc]) ProfileEntry(pszFnName, pszFnFile, iFnLine);
+
+			if (iFunc < m_iMaxHistograms)
+			{
+				pEntry->m_pLatency = &m_pHistograms[iFunc * 2];
+				pEntry->m_pLatency[0].clear();
+				pEntry->m_pLatency[1].clear();
+			}
 		}
 
 		// Update function call references
@@ -278,6 +490,10 @@ namespace sce { namespace Sled
 			pLastFn->addFnCall(pEntry);
 		}
 
+		// Call path up to & including this function
+		if (m_iMaxCallPaths != 0)
+			m_pCallPathStack[m_iNumCallStack] = enterCallPath(pEntry);
+
 		// Add current entry to call stack
 		m_ppCallStack[m_iNumCallStack++] = pEntry;
 
@@ -285,26 +501,24 @@ namespace sce { namespace Sled
 		pEntry->m_flFnTimeStart = (m_pTimer->elapsed() - m_flBpTotalTime);
 		pEntry->m_iFnCallCount++;
 		pEntry->m_flFnTimeInner = 0.0f;		
+		pEntry->m_iCallsAtEnter = ++m_iNumCallsEntered;
+		pEntry->m_flFnOverheadInner = 0.0f;
 
 		//// Print out functions
 		//DumpFunctions(m_pFuncs, m_iNumFuncs);
+
+		return pEntry;
 	}
 
-	void ProfileStack::leaveFn(const char *pszFnName, const char *pszFnFile, const int32_t& iFnLine)
+	ProfileEntry *ProfileStack::leaveEntry(ProfileEntry *pEntry)
 	{
-		// Won't be any entries to modify
-		if (isEmpty())
-			return;
-
-		// Find this function
-		ProfileEntry *pEntry = findFn(pszFnName, pszFnFile, iFnLine);
-
 		// No entry; nothing to modify
 		if (!pEntry)
-			return;
+			return 0;
 
 		// Update call stack - pop off _this_ function that just ended
-		if (m_iNumCallStack != 0)
+		const bool bPopped = (m_iNumCallStack != 0);
+		if (bPopped)
 			m_iNumCallStack--;
 
 		//
@@ -314,6 +528,7 @@ namespace sce { namespace Sled
 		// This is the time the function took from start to end - this value includes
 		// any functions that were called inside this function as well
 		const float flElapsed = (m_pTimer->elapsed() - m_flBpTotalTime) - pEntry->m_flFnTimeStart;
+		const uint64_t iElapsed = ToMicroseconds(flElapsed);
 
 		/*
 		static ProfileEntry* fnTimesWrapper = NULL;
@@ -332,6 +547,13 @@ namespace sce { namespace Sled
 		}
 		*/
 
+		if (bPopped && (m_iMaxCallPaths != 0))
+		{
+			const uint32_t iPath = m_pCallPathStack[m_iNumCallStack];
+			if (iPath != ProfileCallPath::kNone)
+				m_pCallPaths[iPath].timeInclusive += iElapsed;
+		}
+
 		// This is the time the function took from start to end excluding time spent
 		// in functions called from this function
 		float flElapsedInner = flElapsed - pEntry->m_flFnTimeInner;
@@ -339,6 +561,29 @@ namespace sce { namespace Sled
 		// Clamp at zero
 		if (flElapsedInner < 0.0f)
 			flElapsedInner = 0.0f;
+
+		const uint64_t iElapsedInner = ToMicroseconds(flElapsedInner);
+
+		// The profiler's part of this call, plus all of each call made under
+		// it; the inner time only lost what the functions called didn't
+		const uint32_t iNumCallsUnder = m_iNumCallsEntered - pEntry->m_iCallsAtEnter;
+		const float flOverhead = m_flSelfOverhead + ((float)iNumCallsUnder * m_flCallOverhead);
+		const float flOverheadInner = flOverhead - pEntry->m_flFnOverheadInner;
+
+		pEntry->m_flFnTimeElapsedCorrected += (flElapsed > flOverhead) ? (flElapsed - flOverhead) : 0.0f;
+		pEntry->m_flFnTimeInnerElapsedCorrected += (flElapsedInner > flOverheadInner) ? (flElapsedInner - flOverheadInner) : 0.0f;
+
+		if (pEntry->m_pLatency)
+		{
+			pEntry->m_pLatency[0].add(iElapsed);
+			pEntry->m_pLatency[1].add(iElapsedInner);
+		}
+
+		pEntry->m_iFrameCallCount++;
+		pEntry->m_iFrameTimeElapsed += iElapsed;
+		pEntry->m_iFrameTimeInnerElapsed += iElapsedInner;
+		pEntry->m_iLastTimeElapsed = iElapsed;
+		pEntry->m_iLastTimeInnerElapsed = iElapsedInner;
 	
 		if (pEntry->m_iFnCallCount == 1)
 		{
@@ -376,10 +621,13 @@ namespace sce { namespace Sled
 		{
 			ProfileEntry *pParentFunc = m_ppCallStack[m_iNumCallStack - 1];
 			pParentFunc->m_flFnTimeInner += flElapsedInner;
+			pParentFunc->m_flFnOverheadInner += flOverheadInner;
 		}
 
 		//// Print out functions
 		//DumpFunctions(m_pFuncs, m_iNumFuncs);
+
+		return pEntry;
 	}
 
 	ProfileEntry *ProfileStack::findFn(const char *pszFnName, const char *pszFnFile, const int32_t& iFnLine) const	
@@ -401,6 +649,171 @@ namespace sce { namespace Sled
 		return 0;
 	}
 
+	uint32_t ProfileStack::enterCallPath(const ProfileEntry *pEntry)
+	{
+		uint32_t iParent = ProfileCallPath::kNone;
+		if (m_iNumCallStack >= 1)
+		{
+			iParent = m_pCallPathStack[m_iNumCallStack - 1];
+
+			// Whatever the caller's path ran out of room for, so do its callees
+			if (iParent == ProfileCallPath::kNone)
+			{
+				m_iNumCallPathsDropped++;
+				return ProfileCallPath::kNone;
+			}
+		}
+
+		uint32_t& iFirstChild = (iParent == ProfileCallPath::kNone) ? m_iFirstRootCallPath : m_pCallPaths[iParent].firstChild;
+
+		for (uint32_t iPath = iFirstChild; iPath != ProfileCallPath::kNone; iPath = m_pCallPaths[iPath].nextSibling)
+		{
+			if (m_pCallPaths[iPath].entry == pEntry)
+			{
+				m_pCallPaths[iPath].callCount++;
+				return iPath;
+			}
+		}
+
+		if (m_iNumCallPaths == m_iMaxCallPaths)
+		{
+			m_iNumCallPathsDropped++;
+			return ProfileCallPath::kNone;
+		}
+
+		const uint32_t iPath = m_iNumCallPaths++;
+
+		ProfileCallPath& path = m_pCallPaths[iPath];
+		path.entry = pEntry;
+		path.parent = iParent;
+		path.firstChild = ProfileCallPath::kNone;
+		path.nextSibling = iFirstChild;
+		path.callCount = 1;
+		path.timeInclusive = 0;
+
+		iFirstChild = iPath;
+		return iPath;
+	}
+
+	void ProfileStack::writeFolded(FoldedStackWriter *pWriter, ProfileFoldedWeight::Enum weight)
+	{
+		SCE_SLED_ASSERT(pWriter != NULL);
+
+		for (uint32_t i = 0; (i < m_iNumCallPaths) && !pWriter->hasFailed(); i++)
+		{
+			const ProfileCallPath& path = m_pCallPaths[i];
+
+			uint64_t iValue = path.callCount;
+			if (weight == ProfileFoldedWeight::kSelfTime)
+			{
+				uint64_t iChildTime = 0;
+				for (uint32_t iChild = path.firstChild; iChild != ProfileCallPath::kNone; iChild = m_pCallPaths[iChild].nextSibling)
+					iChildTime += m_pCallPaths[iChild].timeInclusive;
+
+				iValue = (path.timeInclusive > iChildTime) ? (path.timeInclusive - iChildTime) : 0;
+			}
+
+			// Callers' paths carry the weight of their callees
+			if (iValue == 0)
+				continue;
+
+			// Paths are never deeper than the call stack they were made from
+			uint16_t iDepth = 0;
+			for (uint32_t iPath = i; (iPath != ProfileCallPath::kNone) && (iDepth < m_iMaxCallStack); iPath = m_pCallPaths[iPath].parent)
+				m_pCallPathScratch[iDepth++] = iPath;
+
+			while (iDepth > 0)
+			{
+				const ProfileEntry *pEntry = m_pCallPaths[m_pCallPathScratch[--iDepth]].entry;
+
+				// Functions without a name are tagged ":<line>:<file>" for SLED to look up
+				const char *pszFnName = pEntry->getFnName();
+				if (pszFnName[0] == ':')
+					pszFnName = "(anonymous)";
+
+				pWriter->addFrame(pszFnName, pEntry->getFnFile(), pEntry->getFnLine());
+			}
+
+			pWriter->endLine(iValue);
+		}
+	}
+
+	void ProfileStack::writeCapture(ProfileCaptureWriter *pWriter) const
+	{
+		SCE_SLED_ASSERT(pWriter != NULL);
+
+		for (uint16_t i = 0; i < m_iNumFuncs; i++)
+		{
+			const ProfileEntry& entry = m_pFuncs[i];
+
+			ProfileCaptureFunction function;
+			function.name = entry.m_szFnName;
+			function.file = entry.m_szFnFile;
+			function.line = entry.m_iFnLine;
+			function.callCount = entry.m_iFnCallCount;
+			function.timeElapsed = ToMicroseconds(entry.m_flFnTimeElapsed);
+			function.timeElapsedShortest = ToMicroseconds(entry.m_flFnTimeElapsedShortest);
+			function.timeElapsedLongest = ToMicroseconds(entry.m_flFnTimeElapsedLongest);
+			function.timeInnerElapsed = ToMicroseconds(entry.m_flFnTimeInnerElapsed);
+			function.timeInnerElapsedShortest = ToMicroseconds(entry.m_flFnTimeInnerElapsedShortest);
+			function.timeInnerElapsedLongest = ToMicroseconds(entry.m_flFnTimeInnerElapsedLongest);
+			function.timeElapsedCorrected = ToMicroseconds(entry.m_flFnTimeElapsedCorrected);
+			function.timeInnerElapsedCorrected = ToMicroseconds(entry.m_flFnTimeInnerElapsedCorrected);
+			pWriter->addFunction(function);
+		}
+
+		for (uint16_t i = 0; (i < m_iNumFuncs) && !pWriter->hasFailed(); i++)
+		{
+			const ProfileEntry& entry = m_pFuncs[i];
+			for (uint16_t iCall = 0; iCall < entry.m_iNumFnCalls; iCall++)
+				pWriter->addEdge(i, getFnIndex(entry.m_hFnCalls[iCall]));
+		}
+
+		// Parents are always made before their children
+		for (uint32_t i = 0; (i < m_iNumCallPaths) && !pWriter->hasFailed(); i++)
+		{
+			const ProfileCallPath& path = m_pCallPaths[i];
+			pWriter->addCallPath(path.parent, getFnIndex(path.entry), path.callCount, path.timeInclusive);
+		}
+
+		for (uint16_t i = 0; (i < m_iNumFuncs) && !pWriter->hasFailed(); i++)
+		{
+			const ProfileEntry& entry = m_pFuncs[i];
+			if (!entry.m_pLatency)
+				continue;
+
+			pWriter->addHistogram(i, ProfileCaptureWriter::kHistogramElapsed, entry.m_pLatency[0]);
+			pWriter->addHistogram(i, ProfileCaptureWriter::kHistogramInner, entry.m_pLatency[1]);
+		}
+
+		for (uint16_t i = 0; (i < m_iNumFuncs) && !pWriter->hasFailed(); i++)
+		{
+			const ProfileEntry& entry = m_pFuncs[i];
+			if ((entry.m_iAllocCount != 0) || (entry.m_iFreeBytes != 0))
+				pWriter->addMemory(i, entry.m_iAllocCount, entry.m_iAllocBytes, entry.m_iFreeBytes);
+		}
+	}
+
+	float ProfileStack::getTimeElapsed() const
+	{
+		return m_pTimer->elapsed() - m_flBpTotalTime;
+	}
+
+	void ProfileStack::chargeMemory(std::size_t iAllocBytes, std::size_t iFreeBytes)
+	{
+		if (m_iNumCallStack == 0)
+			return;
+
+		ProfileEntry *pEntry = m_ppCallStack[m_iNumCallStack - 1];
+		if (iAllocBytes != 0)
+		{
+			pEntry->m_iAllocCount++;
+			pEntry->m_iAllocBytes += iAllocBytes;
+		}
+
+		pEntry->m_iFreeBytes += iFreeBytes;
+	}
+
 	void ProfileStack::preBreakpoint()
 	{
 		m_flBpStopTime = m_pTimer->elapsed();
@@ -416,9 +829,79 @@ namespace sce { namespace Sled
 		m_iNumFuncs = 0;
 		m_iNumCallStack = 0;
 
+		m_iNumCallPaths = 0;
+		m_iNumCallPathsDropped = 0;
+		m_iFirstRootCallPath = ProfileCallPath::kNone;
+
+		// Zone sites start at generation 0
+		if (++m_iGeneration == 0)
+			m_iGeneration = 1;
+
 		m_flBpStopTime = 0.0f;
 		m_flBpTotalTime = 0.0f;
 
 		m_pTimer->reset();
 	}
+
+	void ProfileStack::calibrate()
+	{
+		if (m_iCalibrationCalls == 0)
+			return;
+
+		static const int kRounds = 5;
+
+		// Take the quickest of a few rounds; anything else running only adds time
+		float flSelfOverhead = 0.0f;
+		float flCallOverhead = 0.0f;
+
+		setOverhead(0.0f, 0.0f);
+
+		for (int i = 0; i < kRounds; i++)
+		{
+			clear();
+
+			ProfileEntry *pOuter = enterFn("(calibration)", "=sled", 0);
+			for (uint16_t j = 0; j < m_iCalibrationCalls; j++)
+			{
+				enterFn("(calibration call)", "=sled", 0);
+				leaveFn("(calibration call)", "=sled", 0);
+			}
+			leaveFn("(calibration)", "=sled", 0);
+
+			const ProfileEntry *pInner = findFn("(calibration call)", "=sled", 0);
+			SCE_SLED_ASSERT(pOuter != NULL);
+			SCE_SLED_ASSERT(pInner != NULL);
+
+			// Every empty call's own time is overhead; the outer call's time
+			// is its own share plus every empty call in full
+			const float flSelf = pInner->getFnTimeElapsed() / (float)m_iCalibrationCalls;
+			float flCall = (pOuter->getFnTimeElapsed() - flSelf) / (float)m_iCalibrationCalls;
+			if (flCall < flSelf)
+				flCall = flSelf;
+
+			if ((i == 0) || (flSelf < flSelfOverhead))
+				flSelfOverhead = flSelf;
+			if ((i == 0) || (flCall < flCallOverhead))
+				flCallOverhead = flCall;
+		}
+
+		clear();
+		setOverhead(flSelfOverhead, flCallOverhead);
+	}
+
+	void ProfileStack::setOverhead(float flSelfOverhead, float flCallOverhead)
+	{
+		m_flSelfOverhead = flSelfOverhead;
+		m_flCallOverhead = flCallOverhead;
+	}
+
+	void ProfileStack::endFrame()
+	{
+		for (uint16_t i = 0; i < m_iNumFuncs; i++)
+		{
+			m_pFuncs[i].m_iFrameCallCount = 0;
+			m_pFuncs[i].m_iFrameTimeElapsed = 0;
+			m_pFuncs[i].m_iFrameTimeInnerElapsed = 0;
+		}
+	}
 }}
@@ -10,12 +10,15 @@
 #include <cstdio>
 
 #include "../sleddebugger/common.h"
+#include "params.h"
 
 namespace sce { namespace Sled
 {
 	// Forward declarations
 	class Timer; 
 	class ISequentialAllocator;
+	class FoldedStackWriter;
+	class ProfileCaptureWriter;
 
 	// Forward declaration
 	class ProfileStack;
@@ -41,6 +44,31 @@ namespace sce { namespace Sled
 		uint16_t m_iIndex;
 	};
 
+	// Log-linear (HDR style) histogram of call times in microseconds:
+	// one bucket per microsecond below kSubBuckets, then kSubBuckets / 2
+	// buckets per power of two, so no bucket is wider than an eighth of
+	// the times it holds. Times past 2^32 - 1 go in the last bucket.
+	struct SCE_SLED_LINKAGE ProfileLatencyHistogram
+	{
+		static const uint16_t kSubBucketBits = 4;
+		static const uint16_t kSubBuckets = 1 << kSubBucketBits;
+		static const uint16_t kNumBuckets = kSubBuckets + ((32 - kSubBucketBits) * (kSubBuckets / 2));
+
+		void clear();
+		void add(uint64_t iMicroseconds);
+
+		// Highest time in the bucket holding the given percentile (0 to 100)
+		// of calls, but never more than the longest call
+		uint64_t getValueAtPercentile(double flPercentile) const;
+
+		static uint16_t getBucket(uint64_t iMicroseconds);
+		static uint64_t getBucketUpperBound(uint16_t iBucket);
+
+		uint32_t	counts[kNumBuckets];
+		uint32_t	count;
+		uint64_t	longest;
+	};
+
 	class SCE_SLED_LINKAGE ProfileEntry
 	{
 	public:
@@ -74,6 +102,21 @@ namespace sce { namespace Sled
 		inline float getFnTimeInnerElapsedShortest() const	{ return m_flFnTimeInnerElapsedShortest; }
 		inline float getFnTimeInnerElapsedLongest() const	{ return m_flFnTimeInnerElapsedLongest; }
 		inline uint16_t getFnCalls() const					{ return m_iNumFnCalls; }
+		// NULL unless the entry is one of the first maxHistograms functions
+		inline const ProfileLatencyHistogram *getFnLatency() const		{ return m_pLatency; }
+		inline const ProfileLatencyHistogram *getFnInnerLatency() const	{ return m_pLatency ? &m_pLatency[1] : 0; }
+		inline uint32_t getFnFrameCallCount() const			{ return m_iFrameCallCount; }
+		inline uint64_t getFnFrameTimeElapsed() const		{ return m_iFrameTimeElapsed; }
+		inline uint64_t getFnFrameTimeInnerElapsed() const	{ return m_iFrameTimeInnerElapsed; }
+		inline uint64_t getFnLastTimeElapsed() const		{ return m_iLastTimeElapsed; }
+		inline uint64_t getFnLastTimeInnerElapsed() const	{ return m_iLastTimeInnerElapsed; }
+		// Totals less the profiler's own overhead, as estimated by ProfileStack::calibrate
+		inline float getFnTimeElapsedCorrected() const		{ return m_flFnTimeElapsedCorrected; }
+		inline float getFnTimeInnerElapsedCorrected() const	{ return m_flFnTimeInnerElapsedCorrected; }
+		// Memory charged while the function was on top of the call stack
+		inline uint32_t getFnAllocCount() const				{ return m_iAllocCount; }
+		inline uint64_t getFnAllocBytes() const				{ return m_iAllocBytes; }
+		inline uint64_t getFnFreeBytes() const				{ return m_iFreeBytes; }
 	private:
 		char			m_szFnName[kFuncLen];
 		char			m_szFnFile[kSourceLen];
@@ -102,6 +145,28 @@ namespace sce { namespace Sled
 		// List of functions this function has called
 		ProfileEntry*	m_hFnCalls[kMaxFnCalls];
 		uint16_t		m_iNumFnCalls;	
+		// Elapsed & inner elapsed time histograms, side by side
+		ProfileLatencyHistogram*	m_pLatency;
+		// Calls that returned since the last frame mark & the time they
+		// took, in microseconds
+		uint32_t		m_iFrameCallCount;
+		uint64_t		m_iFrameTimeElapsed;
+		uint64_t		m_iFrameTimeInnerElapsed;
+		// Times of the call that returned last, in microseconds
+		uint64_t		m_iLastTimeElapsed;
+		uint64_t		m_iLastTimeInnerElapsed;
+		// Calls entered on the stack up to & including this one, so the
+		// ones made under it are known when it returns
+		uint32_t		m_iCallsAtEnter;
+		// Overhead already taken off the inner times of functions this
+		// function called (its raw inner time subtracts theirs)
+		float			m_flFnOverheadInner;
+		float			m_flFnTimeElapsedCorrected;
+		float			m_flFnTimeInnerElapsedCorrected;
+
+		uint32_t		m_iAllocCount;
+		uint64_t		m_iAllocBytes;
+		uint64_t		m_iFreeBytes;
 	private:
 		void addFnCall(ProfileEntry *m_pFunc);
 	private:
@@ -109,6 +174,21 @@ namespace sce { namespace Sled
 		friend class ProfileStack;	
 	};
 
+	// One node of the call path trie: a function as called through the
+	// exact chain of callers leading up to its parent node
+	struct SCE_SLED_LINKAGE ProfileCallPath
+	{
+		static const uint32_t kNone = 0xFFFFFFFF;
+
+		const ProfileEntry	*entry;
+		uint32_t			parent;
+		uint32_t			firstChild;
+		uint32_t			nextSibling;
+		uint32_t			callCount;
+		// Microseconds, including the time of functions called
+		uint64_t			timeInclusive;
+	};
+
 	class SCE_SLED_LINKAGE ProfileStackFunctionConstIterator
 	{
 	public:
@@ -130,7 +210,7 @@ namespace sce { namespace Sled
 
 	struct SCE_SLED_LINKAGE ProfileStackConfig
 	{
-		ProfileStackConfig() : maxFunctions(0), maxCallStackDepth(0) {}
+		ProfileStackConfig() : maxFunctions(0), maxCallStackDepth(0), maxCallPaths(0), maxHistograms(0), calibrationCalls(0) {}
 		ProfileStackConfig(const ProfileStackConfig& rhs) { init(rhs); }
 		ProfileStackConfig& operator=(const ProfileStackConfig& rhs) { init(rhs); return *this; }
 
@@ -143,6 +223,9 @@ namespace sce { namespace Sled
 		uint16_t		maxFunctions;		///< Maximum number of functions to track
 		//uint16_t		maxFuncCalls;		///< Maximum number of entries to keep for a function call
 		uint16_t		maxCallStackDepth;	///< Maximum callstack depth
+		uint32_t		maxCallPaths;		///< Maximum number of unique call paths to track (0 disables call paths)
+		uint16_t		maxHistograms;		///< Number of functions, in the order first called, that keep latency histograms (0 disables them)
+		uint16_t		calibrationCalls;	///< Number of empty calls calibrate times per round (0 disables calibration)
 	};
 
 	class SCE_SLED_LINKAGE ProfileStack
@@ -161,16 +244,60 @@ namespace sce { namespace Sled
 		ProfileStack(const ProfileStack&);
 		ProfileStack& operator=(const ProfileStack&);
 	public:
-		void enterFn(const char *pszFnName, const char *pszFnFile, const int32_t& iFnLine);
-		void leaveFn(const char *pszFnName, const char *pszFnFile, const int32_t& iFnLine);
+		// Both return the function's entry; NULL if it isn't tracked
+		ProfileEntry *enterFn(const char *pszFnName, const char *pszFnFile, const int32_t& iFnLine);
+		ProfileEntry *leaveFn(const char *pszFnName, const char *pszFnFile, const int32_t& iFnLine);
+		// Leaves whatever is on top of the call stack
+		ProfileEntry *leaveTop();
 		ProfileEntry *findFn(const char *pszFnName, const char *pszFnFile, const int32_t& iFnLine) const;
+		// Same as enterFn & leaveFn for a native zone; the site remembers
+		// its entry until the next clear
+		ProfileEntry *enterZone(ProfileZoneSite *pSite);
+		ProfileEntry *leaveZone(ProfileZoneSite *pSite);
+		// Charges memory allocated or freed to the function on top of the
+		// call stack; nothing if the stack is empty
+		void chargeMemory(std::size_t iAllocBytes, std::size_t iFreeBytes);
 		void preBreakpoint();
 		void postBreakpoint();
 		void clear();
+		// Starts the per frame counts of every function over
+		void endFrame();
+		// Times empty calls through enterFn & leaveFn to estimate the
+		// profiler's own overhead, then clears the stack
+		void calibrate();
+		// Seconds of overhead inside a call's own time, and added to its
+		// callers' times by each call; taken off the corrected times
+		void setOverhead(float flSelfOverhead, float flCallOverhead);
+		inline float getSelfOverhead() const	{ return m_flSelfOverhead; }
+		inline float getCallOverhead() const	{ return m_flCallOverhead; }
+		inline uint16_t getCalibrationCalls() const	{ return m_iCalibrationCalls; }
+		// One line per call path that has any weight, outermost caller first
+		void writeFolded(FoldedStackWriter *pWriter, ProfileFoldedWeight::Enum weight);
+		// Every function, the calls between them, call paths and
+		// histograms; the caller writes the header, info and end
+		void writeCapture(ProfileCaptureWriter *pWriter) const;
+		// Seconds since the last clear, less time stopped at breakpoints
+		float getTimeElapsed() const;
 		uint16_t getMaxFunctions() const	{ return m_iMaxFuncs; }
 		uint32_t getNumFunctions() const	{ return m_iNumFuncs; }
 		inline bool isEmpty() const			{ return m_iNumFuncs == 0; }
 		inline bool isFull() const			{ return m_iNumFuncs == m_iMaxFuncs; }	
+		// Index of an entry stays the same until the next clear
+		inline uint32_t getFnIndex(const ProfileEntry *pEntry) const	{ return (uint32_t)(pEntry - m_pFuncs); }
+		inline const ProfileEntry *getFn(uint32_t iIndex) const			{ return (iIndex < m_iNumFuncs) ? &m_pFuncs[iIndex] : 0; }
+		// Functions running, outermost first
+		inline uint16_t getCallStackDepth() const						{ return m_iNumCallStack; }
+		inline const ProfileEntry *getCallStackFn(uint16_t iDepth) const	{ return (iDepth < m_iNumCallStack) ? m_ppCallStack[iDepth] : 0; }
+		inline uint16_t getMaxHistograms() const		{ return m_iMaxHistograms; }
+		inline uint32_t getMaxCallPaths() const			{ return m_iMaxCallPaths; }
+		inline uint32_t getNumCallPaths() const			{ return m_iNumCallPaths; }
+		inline uint32_t getNumCallPathsDropped() const	{ return m_iNumCallPathsDropped; }
+		inline const ProfileCallPath *getCallPath(uint32_t iIndex) const	{ return (iIndex < m_iNumCallPaths) ? &m_pCallPaths[iIndex] : 0; }
+	private:
+		ProfileEntry *findZone(const ProfileZoneSite *pSite) const;
+		ProfileEntry *enterEntry(ProfileEntry *pEntry, const char *pszFnName, const char *pszFnFile, const int32_t& iFnLine);
+		ProfileEntry *leaveEntry(ProfileEntry *pEntry);
+		uint32_t enterCallPath(const ProfileEntry *pEntry);
 	private:
 		const uint16_t		m_iMaxFuncs;
 		uint16_t			m_iNumFuncs;
@@ -180,6 +307,26 @@ namespace sce { namespace Sled
 		uint16_t			m_iNumCallStack;
 		ProfileEntry**		m_ppCallStack;
 
+		const uint16_t				m_iMaxHistograms;
+		ProfileLatencyHistogram*	m_pHistograms;
+
+		// Call path of each m_ppCallStack entry; kNone if it isn't tracked
+		const uint32_t		m_iMaxCallPaths;
+		uint32_t			m_iNumCallPaths;
+		uint32_t			m_iNumCallPathsDropped;
+		uint32_t			m_iFirstRootCallPath;
+		ProfileCallPath*	m_pCallPaths;
+		uint32_t*			m_pCallPathStack;
+		uint32_t*			m_pCallPathScratch;
+
+		// Bumped by clear so zone sites know their entry is gone
+		uint32_t			m_iGeneration;
+
+		const uint16_t		m_iCalibrationCalls;
+		uint32_t			m_iNumCallsEntered;
+		float				m_flSelfOverhead;
+		float				m_flCallOverhead;
+
 		float				m_flBpStopTime;
 		float				m_flBpTotalTime;
 		Timer*				m_pTimer;
@@ -8,8 +8,11 @@
 #include "../sleddebugger/buffer.h"
 #include "../sleddebugger/utilities.h"
 #include "luautils.h"
+#include "numberformat.h"
+#include "profilestack.h"
 #include "../sleddebugger/assert.h"
 
+#include <cmath>
 #include <cstdio>
 #include <cstring>
 
@@ -21,8 +24,8 @@ namespace sce { namespace Sled { namespace SCMP
 		pluginId = iPluginId;
 	
 		what = (uint8_t)chWhat;
-		StringUtilities::copyString(oldPtr, Sizes::kPtrLen, "0x%p", pOldPtr);
-		StringUtilities::copyString(newPtr, Sizes::kPtrLen, "0x%p", pNewPtr);
+		NumberFormat::formatPointer(oldPtr, Sizes::kPtrLen, pOldPtr);
+		NumberFormat::formatPointer(newPtr, Sizes::kPtrLen, pNewPtr);
 		oldSize = (int32_t)iOldSize;
 		newSize = (int32_t)iNewSize;
 	
@@ -57,8 +60,8 @@ namespace sce { namespace Sled { namespace SCMP
 		pluginId = iPluginId;
 
 		what = (uint8_t)chWhat;
-		StringUtilities::copyString(oldPtr, Sizes::kPtrLen, "0x%p", pOldPtr);
-		StringUtilities::copyString(newPtr, Sizes::kPtrLen, "0x%p", pNewPtr);
+		NumberFormat::formatPointer(oldPtr, Sizes::kPtrLen, pOldPtr);
+		NumberFormat::formatPointer(newPtr, Sizes::kPtrLen, pNewPtr);
 		oldSize = (int32_t)iOldSize;
 		newSize = (int32_t)iNewSize;
 
@@ -341,20 +344,144 @@ namespace sce { namespace Sled { namespace SCMP
 		what = reader->readUInt8_t();
 	}
 
-	GlobalVar::GlobalVar(uint16_t iPluginId, const LuaVariable *pParent, const char *pszName, int16_t iNameType, const char *pszValue, int16_t iValueType, NetworkBuffer *pBuffer /* = 0 */)
+	void VarValue::setText(const char *pszText)
+	{
+		kind = kText;
+		truncated = 0;
+		length = 0;
+		Utilities::copyString(text, Sizes::kVarValueLen, pszText);
+	}
+
+	void VarValue::setNumber(double value)
+	{
+		// -2^63 <= value < 2^63; NaN & infinities fail the range check
+		if ((value >= -9223372036854775808.0) && (value < 9223372036854775808.0) && (std::floor(value) == value))
+		{
+			kind = kInteger;
+			integer = (int64_t)value;
+		}
+		else
+		{
+			kind = kNumber;
+			number = value;
+		}
+	}
+
+	void VarValue::setBoolean(bool value)
+	{
+		kind = kBoolean;
+		integer = value ? 1 : 0;
+	}
+
+	void VarValue::setString(const char *pszString, std::size_t len)
+	{
+		SCE_SLED_ASSERT(pszString != NULL);
+
+		const std::size_t iCopyLen = (len < (std::size_t)(Sizes::kVarValueLen - 1)) ? len : (std::size_t)(Sizes::kVarValueLen - 1);
+		std::memcpy(text, pszString, iCopyLen);
+		text[iCopyLen] = '\0';
+
+		// Embedded zeros end the slice early too
+		kind = kString;
+		length = (uint32_t)len;
+		truncated = (std::strlen(text) < len) ? 1 : 0;
+	}
+
+	const void *VarValue::getData() const
+	{
+		switch (kind)
+		{
+		case kNumber: return &number;
+		case kInteger:
+		case kBoolean: return &integer;
+		default: return text;
+		}
+	}
+
+	std::size_t VarValue::getDataLen() const
+	{
+		switch (kind)
+		{
+		case kNumber: return sizeof(number);
+		case kInteger:
+		case kBoolean: return sizeof(integer);
+		default: return std::strlen(text);
+		}
+	}
+
+	namespace
+	{
+		int VarValueSize(const VarValue& value, uint8_t iEncoding)
+		{
+			const int iTextSize = Base::kSizeOfuint16_t + (int)std::strlen(value.text);
+
+			if (iEncoding != VarValueEncoding::kBinary)
+				return iTextSize;
+
+			switch (value.kind)
+			{
+			case VarValue::kNumber: return Base::kSizeOfuint8_t + Base::kSizeOfdouble;
+			case VarValue::kInteger: return Base::kSizeOfuint8_t + Base::kSizeOfint64_t;
+			case VarValue::kBoolean: return Base::kSizeOfuint8_t + Base::kSizeOfuint8_t;
+			case VarValue::kString: return Base::kSizeOfuint8_t + Base::kSizeOfuint32_t + Base::kSizeOfuint8_t + iTextSize;
+			default: return Base::kSizeOfuint8_t + iTextSize;
+			}
+		}
+
+		// String encoding: text only. Binary encoding: kind followed by
+		//	kText		string
+		//	kNumber		double
+		//	kInteger	int64
+		//	kBoolean	uint8
+		//	kString		uint32 full length, uint8 truncated, string
+		void PackVarValue(NetworkBufferPacker *pPacker, const VarValue& value, uint8_t iEncoding)
+		{
+			if (iEncoding != VarValueEncoding::kBinary)
+			{
+				pPacker->packString(value.text);
+				return;
+			}
+
+			pPacker->packUInt8_t(value.kind);
+
+			switch (value.kind)
+			{
+			case VarValue::kNumber:
+				pPacker->packDouble(value.number);
+				break;
+			case VarValue::kInteger:
+				pPacker->packInt64_t(value.integer);
+				break;
+			case VarValue::kBoolean:
+				pPacker->packUInt8_t((uint8_t)value.integer);
+				break;
+			case VarValue::kString:
+				pPacker->packUInt32_t(value.length);
+				pPacker->packUInt8_t(value.truncated);
+				pPacker->packString(value.text);
+				break;
+			default:
+				pPacker->packString(value.text);
+				break;
+			}
+		}
+	}
+
+	GlobalVar::GlobalVar(uint16_t iPluginId, const LuaVariable *pParent, const char *pszName, int16_t iNameType, const VarValue& varValue, int16_t iValueType, uint8_t iEncoding, NetworkBuffer *pBuffer /* = 0 */)
 		: parent(pParent)
 		, name(pszName)
 		, nameType(iNameType)
-		, value(pszValue)
+		, value(&varValue)
 		, valueType(iValueType)
+		, encoding(iEncoding)
 	{
-		typeCode = LuaTypeCodes::kGlobalVar;
+		typeCode = (encoding == VarValueEncoding::kBinary) ? LuaTypeCodes::kGlobalVarBinary : LuaTypeCodes::kGlobalVar;
 		pluginId = iPluginId;
 
 		length = kSizeOfBase
 			+ kSizeOfuint16_t + (int)std::strlen(name) // name
 			+ kSizeOfint16_t // name type
-			+ kSizeOfuint16_t + (int)std::strlen(value) // value
+			+ VarValueSize(*value, encoding) // value
 			+ kSizeOfint16_t // value type
 			+ kSizeOfuint16_t; // # of parent and key-value-pairs
 
@@ -386,7 +513,7 @@ namespace sce { namespace Sled { namespace SCMP
 
 		packer.packString(name);
 		packer.packInt16_t(nameType);
-		packer.packString(value);
+		PackVarValue(&packer, *value, encoding);
 		packer.packInt16_t(valueType);
 
 		const uint16_t extraOffset = parent == NULL ? 0 : parent->bFlag ? 1 : 0;
@@ -409,22 +536,23 @@ namespace sce { namespace Sled { namespace SCMP
 		}
 	}
 
-	LocalVar::LocalVar(uint16_t iPluginId, const LuaVariable *pParent, const char *pszName, int16_t iNameType, const char *pszValue, int16_t iValueType, int16_t iStackLevel, int32_t iIndex, NetworkBuffer *pBuffer /* = 0 */)
+	LocalVar::LocalVar(uint16_t iPluginId, const LuaVariable *pParent, const char *pszName, int16_t iNameType, const VarValue& varValue, int16_t iValueType, uint8_t iEncoding, int16_t iStackLevel, int32_t iIndex, NetworkBuffer *pBuffer /* = 0 */)
 		: parent(pParent)
 		, name(pszName)
 		, nameType(iNameType)
-		, value(pszValue)
+		, value(&varValue)
 		, valueType(iValueType)
+		, encoding(iEncoding)
 		, stackLevel(iStackLevel)
 		, index(iIndex)
 	{
-		typeCode = LuaTypeCodes::kLocalVar;
+		typeCode = (encoding == VarValueEncoding::kBinary) ? LuaTypeCodes::kLocalVarBinary : LuaTypeCodes::kLocalVar;
 		pluginId = iPluginId;
 
 		length = kSizeOfBase
 			+ kSizeOfuint16_t + (int)std::strlen(name) // name
 			+ kSizeOfint16_t // name type
-			+ kSizeOfuint16_t + (int)std::strlen(value) // value
+			+ VarValueSize(*value, encoding) // value
 			+ kSizeOfint16_t // value type
 			+ kSizeOfint16_t // stack level
 			+ kSizeOfint32_t // index		
@@ -458,7 +586,7 @@ namespace sce { namespace Sled { namespace SCMP
 
 		packer.packString(name);
 		packer.packInt16_t(nameType);
-		packer.packString(value);
+		PackVarValue(&packer, *value, encoding);
 		packer.packInt16_t(valueType);
 
 		packer.packInt16_t(stackLevel);
@@ -484,22 +612,23 @@ namespace sce { namespace Sled { namespace SCMP
 		}
 	}
 
-	UpvalueVar::UpvalueVar(uint16_t iPluginId, const LuaVariable *pParent, const char *pszName, int16_t iNameType, const char *pszValue, int16_t iValueType, int16_t iStackLevel, int32_t iIndex, NetworkBuffer *pBuffer /* = 0 */)
+	UpvalueVar::UpvalueVar(uint16_t iPluginId, const LuaVariable *pParent, const char *pszName, int16_t iNameType, const VarValue& varValue, int16_t iValueType, uint8_t iEncoding, int16_t iStackLevel, int32_t iIndex, NetworkBuffer *pBuffer /* = 0 */)
 		: parent(pParent)
 		, name(pszName)
 		, nameType(iNameType)
-		, value(pszValue)
+		, value(&varValue)
 		, valueType(iValueType)
+		, encoding(iEncoding)
 		, stackLevel(iStackLevel)
 		, index(iIndex)
 	{
-		typeCode = LuaTypeCodes::kUpvalueVar;
+		typeCode = (encoding == VarValueEncoding::kBinary) ? LuaTypeCodes::kUpvalueVarBinary : LuaTypeCodes::kUpvalueVar;
 		pluginId = iPluginId;
 
 		length = kSizeOfBase
 			+ kSizeOfuint16_t + (int)std::strlen(name) // name
 			+ kSizeOfint16_t // name type
-			+ kSizeOfuint16_t + (int)std::strlen(value) // value
+			+ VarValueSize(*value, encoding) // value
 			+ kSizeOfint16_t // value type
 			+ kSizeOfint16_t // stack level
 			+ kSizeOfint32_t // index		
@@ -533,7 +662,7 @@ namespace sce { namespace Sled { namespace SCMP
 
 		packer.packString(name);
 		packer.packInt16_t(nameType);
-		packer.packString(value);
+		PackVarValue(&packer, *value, encoding);
 		packer.packInt16_t(valueType);
 
 		packer.packInt16_t(stackLevel);
@@ -559,21 +688,22 @@ namespace sce { namespace Sled { namespace SCMP
 		}
 	}
 
-	EnvVar::EnvVar(uint16_t iPluginId, const LuaVariable *pParent, const char *pszName, int16_t iNameType, const char *pszValue, int16_t iValueType, int16_t iStackLevel, NetworkBuffer *pBuffer /* = 0 */)
+	EnvVar::EnvVar(uint16_t iPluginId, const LuaVariable *pParent, const char *pszName, int16_t iNameType, const VarValue& varValue, int16_t iValueType, uint8_t iEncoding, int16_t iStackLevel, NetworkBuffer *pBuffer /* = 0 */)
 		: parent(pParent)
 		, name(pszName)
 		, nameType(iNameType)
-		, value(pszValue)
+		, value(&varValue)
 		, valueType(iValueType)
+		, encoding(iEncoding)
 		, stackLevel(iStackLevel)
 	{
-		typeCode = LuaTypeCodes::kEnvVar;
+		typeCode = (encoding == VarValueEncoding::kBinary) ? LuaTypeCodes::kEnvVarBinary : LuaTypeCodes::kEnvVar;
 		pluginId = iPluginId;
 
 		length = kSizeOfBase
 			+ kSizeOfuint16_t + (int)std::strlen(name) // name
 			+ kSizeOfint16_t // name type
-			+ kSizeOfuint16_t + (int)std::strlen(value) // value
+			+ VarValueSize(*value, encoding) // value
 			+ kSizeOfint16_t // value type
 			+ kSizeOfint16_t // stack level
 			+ kSizeOfuint16_t; // # of parent and key-value-pairs
@@ -606,7 +736,7 @@ namespace sce { namespace Sled { namespace SCMP
 
 		packer.packString(name);
 		packer.packInt16_t(nameType);
-		packer.packString(value);
+		PackVarValue(&packer, *value, encoding);
 		packer.packInt16_t(valueType);
 
 		packer.packInt16_t(stackLevel);
@@ -968,4 +1098,850 @@ namespace sce { namespace Sled { namespace SCMP
 		packer.packUInt8_t(profilerEnabled);
 		packer.packUInt8_t(memoryTracerEnabled);
 	}
+
+	HeapCensusType::HeapCensusType(uint16_t iPluginId, int16_t iLuaType, uint32_t iCount, uint64_t iBytes, NetworkBuffer *pBuffer /* = 0 */)
+	{
+		typeCode = LuaTypeCodes::kHeapCensusType;
+		pluginId = iPluginId;
+
+		luaType = iLuaType;
+		count = iCount;
+		bytes = iBytes;
+
+		length = kSizeOfBase
+			+ kSizeOfint16_t
+			+ kSizeOfuint32_t
+			+ kSizeOfuint64_t;
+
+		if (pBuffer)
+			pack(pBuffer);
+	}
+
+	void HeapCensusType::pack(NetworkBuffer *pBuffer)
+	{
+		NetworkBufferPacker packer(pBuffer);
+
+		packer.packInt32_t(length);
+		packer.packUInt16_t(typeCode);
+		packer.packUInt16_t(pluginId);
+		packer.packInt16_t(luaType);
+		packer.packUInt32_t(count);
+		packer.packUInt64_t(bytes);
+	}
+
+	HeapCensusTable::HeapCensusTable(uint16_t iPluginId, const void *pTable, const char *pszRoot, uint32_t iArrayCount, uint32_t iHashCount, uint32_t iBytes, NetworkBuffer *pBuffer /* = 0 */)
+	{
+		typeCode = LuaTypeCodes::kHeapCensusTable;
+		pluginId = iPluginId;
+
+		NumberFormat::formatPointer(address, Sizes::kPtrLen, pTable);
+		Utilities::copyString(root, kStringLen, pszRoot);
+		arrayCount = iArrayCount;
+		hashCount = iHashCount;
+		bytes = iBytes;
+
+		length = kSizeOfBase
+			+ kSizeOfuint16_t + (int)std::strlen(address)
+			+ kSizeOfuint16_t + (int)std::strlen(root)
+			+ (kSizeOfuint32_t * 3);
+
+		if (pBuffer)
+			pack(pBuffer);
+	}
+
+	void HeapCensusTable::pack(NetworkBuffer *pBuffer)
+	{
+		NetworkBufferPacker packer(pBuffer);
+
+		packer.packInt32_t(length);
+		packer.packUInt16_t(typeCode);
+		packer.packUInt16_t(pluginId);
+		packer.packString(address);
+		packer.packString(root);
+		packer.packUInt32_t(arrayCount);
+		packer.packUInt32_t(hashCount);
+		packer.packUInt32_t(bytes);
+	}
+
+	HeapCensusRoot::HeapCensusRoot(uint16_t iPluginId, const char *pszName, uint32_t iObjects, uint64_t iBytes, NetworkBuffer *pBuffer /* = 0 */)
+	{
+		typeCode = LuaTypeCodes::kHeapCensusRoot;
+		pluginId = iPluginId;
+
+		Utilities::copyString(name, kStringLen, pszName);
+		objects = iObjects;
+		bytes = iBytes;
+
+		length = kSizeOfBase
+			+ kSizeOfuint16_t + (int)std::strlen(name)
+			+ kSizeOfuint32_t
+			+ kSizeOfuint64_t;
+
+		if (pBuffer)
+			pack(pBuffer);
+	}
+
+	void HeapCensusRoot::pack(NetworkBuffer *pBuffer)
+	{
+		NetworkBufferPacker packer(pBuffer);
+
+		packer.packInt32_t(length);
+		packer.packUInt16_t(typeCode);
+		packer.packUInt16_t(pluginId);
+		packer.packString(name);
+		packer.packUInt32_t(objects);
+		packer.packUInt64_t(bytes);
+	}
+
+	HeapCensusEnd::HeapCensusEnd(uint16_t iPluginId, uint32_t iNumObjects, uint64_t iTotalBytes, float flElapsed, bool bTruncated, NetworkBuffer *pBuffer /* = 0 */)
+	{
+		typeCode = LuaTypeCodes::kHeapCensusEnd;
+		pluginId = iPluginId;
+
+		numObjects = iNumObjects;
+		totalBytes = iTotalBytes;
+		elapsed = flElapsed;
+		truncated = bTruncated ? 1 : 0;
+
+		length = kSizeOfBase
+			+ kSizeOfuint32_t
+			+ kSizeOfuint64_t
+			+ kSizeOffloat
+			+ kSizeOfuint8_t;
+
+		if (pBuffer)
+			pack(pBuffer);
+	}
+
+	void HeapCensusEnd::pack(NetworkBuffer *pBuffer)
+	{
+		NetworkBufferPacker packer(pBuffer);
+
+		packer.packInt32_t(length);
+		packer.packUInt16_t(typeCode);
+		packer.packUInt16_t(pluginId);
+		packer.packUInt32_t(numObjects);
+		packer.packUInt64_t(totalBytes);
+		packer.packFloat(elapsed);
+		packer.packUInt8_t(truncated);
+	}
+
+	GcPauseInfo::GcPauseInfo(uint16_t iPluginId, char chWhat, uint32_t iCount, float flTotal, float flLongest, float flFirstBucketUpperBound, const uint32_t *pBuckets, uint16_t iNumBuckets, NetworkBuffer *pBuffer /* = 0 */)
+	{
+		SCE_SLED_ASSERT(pBuckets != NULL);
+		SCE_SLED_ASSERT(iNumBuckets <= Sizes::kGcPauseBuckets);
+
+		typeCode = LuaTypeCodes::kGcPauseInfo;
+		pluginId = iPluginId;
+
+		what = (uint8_t)chWhat;
+		count = iCount;
+		total = flTotal;
+		longest = flLongest;
+		firstBucketUpperBound = flFirstBucketUpperBound;
+
+		numBuckets = (iNumBuckets > Sizes::kGcPauseBuckets) ? Sizes::kGcPauseBuckets : iNumBuckets;
+		for (uint16_t i = 0; i < numBuckets; i++)
+			buckets[i] = pBuckets[i];
+
+		length = kSizeOfBase
+			+ kSizeOfuint8_t
+			+ kSizeOfuint32_t
+			+ kSizeOffloat
+			+ kSizeOffloat
+			+ kSizeOffloat
+			+ kSizeOfuint16_t
+			+ (kSizeOfuint32_t * numBuckets);
+
+		if (pBuffer)
+			pack(pBuffer);
+	}
+
+	void GcPauseInfo::pack(NetworkBuffer *pBuffer)
+	{
+		NetworkBufferPacker packer(pBuffer);
+
+		packer.packInt32_t(length);
+		packer.packUInt16_t(typeCode);
+		packer.packUInt16_t(pluginId);
+		packer.packUInt8_t(what);
+		packer.packUInt32_t(count);
+		packer.packFloat(total);
+		packer.packFloat(longest);
+		packer.packFloat(firstBucketUpperBound);
+		packer.packUInt16_t(numBuckets);
+		for (uint16_t i = 0; i < numBuckets; i++)
+			packer.packUInt32_t(buckets[i]);
+	}
+
+	GcInfoEnd::GcInfoEnd(uint16_t iPluginId, uint32_t iNumCycles, uint64_t iBytesSwept, uint64_t iBytesInUse, NetworkBuffer *pBuffer /* = 0 */)
+	{
+		typeCode = LuaTypeCodes::kGcInfoEnd;
+		pluginId = iPluginId;
+
+		numCycles = iNumCycles;
+		bytesSwept = iBytesSwept;
+		bytesInUse = iBytesInUse;
+
+		length = kSizeOfBase
+			+ kSizeOfuint32_t
+			+ kSizeOfuint64_t
+			+ kSizeOfuint64_t;
+
+		if (pBuffer)
+			pack(pBuffer);
+	}
+
+	void GcInfoEnd::pack(NetworkBuffer *pBuffer)
+	{
+		NetworkBufferPacker packer(pBuffer);
+
+		packer.packInt32_t(length);
+		packer.packUInt16_t(typeCode);
+		packer.packUInt16_t(pluginId);
+		packer.packUInt32_t(numCycles);
+		packer.packUInt64_t(bytesSwept);
+		packer.packUInt64_t(bytesInUse);
+	}
+
+	void VarLookUpPage::unpack(NetworkBufferReader *reader, uint8_t *scratchBuffer, uint16_t scratchBufferMaxSize)
+	{
+		length = reader->readInt32_t();
+		typeCode = reader->readUInt16_t();
+		pluginId = reader->readUInt16_t();
+
+		variable.what = (LuaVariableScope::Enum)reader->readUInt8_t();
+		variable.context = (LuaVariableContext::Enum)reader->readUInt8_t();
+		variable.numKeyValues = reader->readUInt16_t() - 1;
+		variable.level = reader->readInt16_t();
+		variable.index = reader->readInt32_t();
+		offset = reader->readUInt32_t();
+		limit = reader->readUInt32_t();
+
+		std::size_t position = 0;
+		reader->readString((char*)(scratchBuffer + position), scratchBufferMaxSize);
+
+		variable.name = (char*)(scratchBuffer + position);
+		variable.nameType = reader->readUInt16_t();
+
+		position += (std::strlen(variable.name) + 1);
+
+		for (int i = 0; i < variable.numKeyValues; ++i)
+		{
+			reader->readString((char*)(scratchBuffer + position), scratchBufferMaxSize - (uint16_t)position);
+
+			variable.hKeyValues[i].name = (char*)(scratchBuffer + position);
+			variable.hKeyValues[i].type = reader->readUInt16_t();
+
+			position += (std::strlen(variable.hKeyValues[i].name) + 1);
+		}
+	}
+
+	VarLookUpPageBegin::VarLookUpPageBegin(uint16_t iPluginId, uint8_t iWhat, uint32_t iOffset, uint32_t iLimit, NetworkBuffer *pBuffer /* = 0 */)
+	{
+		typeCode = LuaTypeCodes::kVarLookUpPageBegin;
+		pluginId = iPluginId;
+
+		what = iWhat;
+		offset = iOffset;
+		limit = iLimit;
+
+		length = kSizeOfBase
+			+ kSizeOfuint8_t
+			+ kSizeOfuint32_t
+			+ kSizeOfuint32_t;
+
+		if (pBuffer)
+			pack(pBuffer);
+	}
+
+	void VarLookUpPageBegin::pack(NetworkBuffer *pBuffer)
+	{
+		NetworkBufferPacker packer(pBuffer);
+
+		packer.packInt32_t(length);
+		packer.packUInt16_t(typeCode);
+		packer.packUInt16_t(pluginId);
+		packer.packUInt8_t(what);
+		packer.packUInt32_t(offset);
+		packer.packUInt32_t(limit);
+	}
+
+	VarLookUpPageEnd::VarLookUpPageEnd(uint16_t iPluginId, uint8_t iWhat, uint32_t iOffset, uint32_t iTotal, NetworkBuffer *pBuffer /* = 0 */)
+	{
+		typeCode = LuaTypeCodes::kVarLookUpPageEnd;
+		pluginId = iPluginId;
+
+		what = iWhat;
+		offset = iOffset;
+		total = iTotal;
+
+		length = kSizeOfBase
+			+ kSizeOfuint8_t
+			+ kSizeOfuint32_t
+			+ kSizeOfuint32_t;
+
+		if (pBuffer)
+			pack(pBuffer);
+	}
+
+	void VarLookUpPageEnd::pack(NetworkBuffer *pBuffer)
+	{
+		NetworkBufferPacker packer(pBuffer);
+
+		packer.packInt32_t(length);
+		packer.packUInt16_t(typeCode);
+		packer.packUInt16_t(pluginId);
+		packer.packUInt8_t(what);
+		packer.packUInt32_t(offset);
+		packer.packUInt32_t(total);
+	}
+
+	VarSnapshotBegin::VarSnapshotBegin(uint16_t iPluginId, bool bFull, NetworkBuffer *pBuffer /* = 0 */)
+	{
+		typeCode = LuaTypeCodes::kVarSnapshotBegin;
+		pluginId = iPluginId;
+
+		full = bFull ? 1 : 0;
+
+		length = kSizeOfBase
+			+ kSizeOfuint8_t;
+
+		if (pBuffer)
+			pack(pBuffer);
+	}
+
+	void VarSnapshotBegin::pack(NetworkBuffer *pBuffer)
+	{
+		NetworkBufferPacker packer(pBuffer);
+
+		packer.packInt32_t(length);
+		packer.packUInt16_t(typeCode);
+		packer.packUInt16_t(pluginId);
+		packer.packUInt8_t(full);
+	}
+
+	VarSnapshotRemoved::VarSnapshotRemoved(uint16_t iPluginId, char chWhat, const char *pszName, int16_t iNameType, int16_t iStackLevel, int32_t iIndex, NetworkBuffer *pBuffer /* = 0 */)
+		: name(pszName)
+	{
+		typeCode = LuaTypeCodes::kVarSnapshotRemoved;
+		pluginId = iPluginId;
+
+		what = (uint8_t)chWhat;
+		nameType = iNameType;
+		stackLevel = iStackLevel;
+		index = iIndex;
+
+		length = kSizeOfBase
+			+ kSizeOfuint8_t // what
+			+ kSizeOfuint16_t + (int)std::strlen(name) // name
+			+ kSizeOfint16_t // name type
+			+ kSizeOfint16_t // stack level
+			+ kSizeOfint32_t; // index
+
+		if (pBuffer)
+			pack(pBuffer);
+	}
+
+	void VarSnapshotRemoved::pack(NetworkBuffer *pBuffer)
+	{
+		NetworkBufferPacker packer(pBuffer);
+
+		packer.packInt32_t(length);
+		packer.packUInt16_t(typeCode);
+		packer.packUInt16_t(pluginId);
+		packer.packUInt8_t(what);
+		packer.packString(name);
+		packer.packInt16_t(nameType);
+		packer.packInt16_t(stackLevel);
+		packer.packInt32_t(index);
+	}
+
+	VarSnapshotEnd::VarSnapshotEnd(uint16_t iPluginId, uint32_t iNumAdded, uint32_t iNumChanged, uint32_t iNumUnchanged, uint32_t iNumRemoved, NetworkBuffer *pBuffer /* = 0 */)
+	{
+		typeCode = LuaTypeCodes::kVarSnapshotEnd;
+		pluginId = iPluginId;
+
+		numAdded = iNumAdded;
+		numChanged = iNumChanged;
+		numUnchanged = iNumUnchanged;
+		numRemoved = iNumRemoved;
+
+		length = kSizeOfBase
+			+ kSizeOfuint32_t
+			+ kSizeOfuint32_t
+			+ kSizeOfuint32_t
+			+ kSizeOfuint32_t;
+
+		if (pBuffer)
+			pack(pBuffer);
+	}
+
+	void VarSnapshotEnd::pack(NetworkBuffer *pBuffer)
+	{
+		NetworkBufferPacker packer(pBuffer);
+
+		packer.packInt32_t(length);
+		packer.packUInt16_t(typeCode);
+		packer.packUInt16_t(pluginId);
+		packer.packUInt32_t(numAdded);
+		packer.packUInt32_t(numChanged);
+		packer.packUInt32_t(numUnchanged);
+		packer.packUInt32_t(numRemoved);
+	}
+
+	VarEncoding::VarEncoding(uint16_t iPluginId, uint8_t iEncoding, NetworkBuffer *pBuffer /* = 0 */)
+		: encoding(iEncoding)
+	{
+		typeCode = LuaTypeCodes::kVarEncoding;
+		pluginId = iPluginId;
+
+		length = kSizeOfBase
+			+ kSizeOfuint8_t;
+
+		if (pBuffer)
+			pack(pBuffer);
+	}
+
+	void VarEncoding::pack(NetworkBuffer *pBuffer)
+	{
+		NetworkBufferPacker packer(pBuffer);
+
+		packer.packInt32_t(length);
+		packer.packUInt16_t(typeCode);
+		packer.packUInt16_t(pluginId);
+		packer.packUInt8_t(encoding);
+	}
+
+	void VarEncoding::unpack(NetworkBufferReader *reader)
+	{
+		length = reader->readInt32_t();
+		typeCode = reader->readUInt16_t();
+		pluginId = reader->readUInt16_t();
+		encoding = reader->readUInt8_t();
+	}
+
+	VarTableId::VarTableId(uint16_t iPluginId, uint8_t iWhat, uint32_t iId, uint32_t iVersion, bool bUnchanged, NetworkBuffer *pBuffer /* = 0 */)
+	{
+		typeCode = LuaTypeCodes::kVarTableId;
+		pluginId = iPluginId;
+
+		what = iWhat;
+		id = iId;
+		version = iVersion;
+		unchanged = bUnchanged ? 1 : 0;
+
+		length = kSizeOfBase
+			+ kSizeOfuint8_t
+			+ kSizeOfuint32_t
+			+ kSizeOfuint32_t
+			+ kSizeOfuint8_t;
+
+		if (pBuffer)
+			pack(pBuffer);
+	}
+
+	void VarTableId::pack(NetworkBuffer *pBuffer)
+	{
+		NetworkBufferPacker packer(pBuffer);
+
+		packer.packInt32_t(length);
+		packer.packUInt16_t(typeCode);
+		packer.packUInt16_t(pluginId);
+		packer.packUInt8_t(what);
+		packer.packUInt32_t(id);
+		packer.packUInt32_t(version);
+		packer.packUInt8_t(unchanged);
+	}
+
+	void VarLookUpById::unpack(NetworkBufferReader *reader, uint8_t *scratchBuffer, uint16_t scratchBufferMaxSize)
+	{
+		length = reader->readInt32_t();
+		typeCode = reader->readUInt16_t();
+		pluginId = reader->readUInt16_t();
+
+		variable.what = (LuaVariableScope::Enum)reader->readUInt8_t();
+		variable.context = (LuaVariableContext::Enum)reader->readUInt8_t();
+		variable.numKeyValues = reader->readUInt16_t() - 1;
+		variable.level = reader->readInt16_t();
+		variable.index = reader->readInt32_t();
+		id = reader->readUInt32_t();
+		version = reader->readUInt32_t();
+
+		std::size_t position = 0;
+		reader->readString((char*)(scratchBuffer + position), scratchBufferMaxSize);
+
+		variable.name = (char*)(scratchBuffer + position);
+		variable.nameType = reader->readUInt16_t();
+
+		position += (std::strlen(variable.name) + 1);
+
+		for (int i = 0; i < variable.numKeyValues; ++i)
+		{
+			reader->readString((char*)(scratchBuffer + position), scratchBufferMaxSize - (uint16_t)position);
+
+			variable.hKeyValues[i].name = (char*)(scratchBuffer + position);
+			variable.hKeyValues[i].type = reader->readUInt16_t();
+
+			position += (std::strlen(variable.hKeyValues[i].name) + 1);
+		}
+	}
+
+	VarTruncated::VarTruncated(uint16_t iPluginId, uint8_t iWhat, int16_t iStackLevel, uint32_t iOffset, NetworkBuffer *pBuffer /* = 0 */)
+	{
+		typeCode = LuaTypeCodes::kVarTruncated;
+		pluginId = iPluginId;
+
+		what = iWhat;
+		stackLevel = iStackLevel;
+		offset = iOffset;
+
+		length = kSizeOfBase
+			+ kSizeOfuint8_t
+			+ kSizeOfint16_t
+			+ kSizeOfuint32_t;
+
+		if (pBuffer)
+			pack(pBuffer);
+	}
+
+	void VarTruncated::pack(NetworkBuffer *pBuffer)
+	{
+		NetworkBufferPacker packer(pBuffer);
+
+		packer.packInt32_t(length);
+		packer.packUInt16_t(typeCode);
+		packer.packUInt16_t(pluginId);
+		packer.packUInt8_t(what);
+		packer.packInt16_t(stackLevel);
+		packer.packUInt32_t(offset);
+	}
+
+	CoverageBegin::CoverageBegin(uint16_t iPluginId, bool bRunning, NetworkBuffer *pBuffer /* = 0 */)
+	{
+		typeCode = LuaTypeCodes::kCoverageBegin;
+		pluginId = iPluginId;
+
+		running = bRunning ? 1 : 0;
+
+		length = kSizeOfBase
+			+ kSizeOfuint8_t;
+
+		if (pBuffer)
+			pack(pBuffer);
+	}
+
+	void CoverageBegin::pack(NetworkBuffer *pBuffer)
+	{
+		NetworkBufferPacker packer(pBuffer);
+
+		packer.packInt32_t(length);
+		packer.packUInt16_t(typeCode);
+		packer.packUInt16_t(pluginId);
+		packer.packUInt8_t(running);
+	}
+
+	CoverageData::CoverageData(uint16_t iPluginId, const uint8_t *pData, uint16_t iSize, NetworkBuffer *pBuffer /* = 0 */)
+	{
+		SCE_SLED_ASSERT(iSize <= Sizes::kCoverageDataLen);
+
+		typeCode = LuaTypeCodes::kCoverageData;
+		pluginId = iPluginId;
+
+		size = (iSize < Sizes::kCoverageDataLen) ? iSize : Sizes::kCoverageDataLen;
+		std::memcpy(data, pData, size);
+
+		length = kSizeOfBase
+			+ kSizeOfuint16_t
+			+ (kSizeOfuint8_t * size);
+
+		if (pBuffer)
+			pack(pBuffer);
+	}
+
+	void CoverageData::pack(NetworkBuffer *pBuffer)
+	{
+		NetworkBufferPacker packer(pBuffer);
+
+		packer.packInt32_t(length);
+		packer.packUInt16_t(typeCode);
+		packer.packUInt16_t(pluginId);
+		packer.packUInt16_t(size);
+
+		for (uint16_t i = 0; i < size; i++)
+			packer.packUInt8_t(data[i]);
+	}
+
+	CoverageEnd::CoverageEnd(uint16_t iPluginId, uint32_t iNumChunks, uint64_t iNumBytes, bool bComplete, NetworkBuffer *pBuffer /* = 0 */)
+	{
+		typeCode = LuaTypeCodes::kCoverageEnd;
+		pluginId = iPluginId;
+
+		numChunks = iNumChunks;
+		numBytes = iNumBytes;
+		complete = bComplete ? 1 : 0;
+
+		length = kSizeOfBase
+			+ kSizeOfuint32_t
+			+ kSizeOfuint64_t
+			+ kSizeOfuint8_t;
+
+		if (pBuffer)
+			pack(pBuffer);
+	}
+
+	void CoverageEnd::pack(NetworkBuffer *pBuffer)
+	{
+		NetworkBufferPacker packer(pBuffer);
+
+		packer.packInt32_t(length);
+		packer.packUInt16_t(typeCode);
+		packer.packUInt16_t(pluginId);
+		packer.packUInt32_t(numChunks);
+		packer.packUInt64_t(numBytes);
+		packer.packUInt8_t(complete);
+	}
+
+	OpcodeProfileBegin::OpcodeProfileBegin(uint16_t iPluginId, uint16_t iNumOpcodes, bool bRunning, NetworkBuffer *pBuffer /* = 0 */)
+	{
+		typeCode = LuaTypeCodes::kOpcodeProfileBegin;
+		pluginId = iPluginId;
+
+		numOpcodes = iNumOpcodes;
+		running = bRunning ? 1 : 0;
+
+		length = kSizeOfBase
+			+ kSizeOfuint16_t
+			+ kSizeOfuint8_t;
+
+		if (pBuffer)
+			pack(pBuffer);
+	}
+
+	void OpcodeProfileBegin::pack(NetworkBuffer *pBuffer)
+	{
+		NetworkBufferPacker packer(pBuffer);
+
+		packer.packInt32_t(length);
+		packer.packUInt16_t(typeCode);
+		packer.packUInt16_t(pluginId);
+		packer.packUInt16_t(numOpcodes);
+		packer.packUInt8_t(running);
+	}
+
+	OpcodeProfileOpcode::OpcodeProfileOpcode(uint16_t iPluginId, uint16_t iOpcode, const char *pszName, uint64_t iCount, NetworkBuffer *pBuffer /* = 0 */)
+	{
+		typeCode = LuaTypeCodes::kOpcodeProfileOpcode;
+		pluginId = iPluginId;
+
+		opcode = iOpcode;
+		Utilities::copyString(name, kStringLen, pszName ? pszName : "");
+		count = iCount;
+
+		length = kSizeOfBase
+			+ kSizeOfuint16_t
+			+ kSizeOfuint16_t + (int)std::strlen(name)
+			+ kSizeOfuint64_t;
+
+		if (pBuffer)
+			pack(pBuffer);
+	}
+
+	void OpcodeProfileOpcode::pack(NetworkBuffer *pBuffer)
+	{
+		NetworkBufferPacker packer(pBuffer);
+
+		packer.packInt32_t(length);
+		packer.packUInt16_t(typeCode);
+		packer.packUInt16_t(pluginId);
+		packer.packUInt16_t(opcode);
+		packer.packString(name);
+		packer.packUInt64_t(count);
+	}
+
+	OpcodeProfileFunction::OpcodeProfileFunction(uint16_t iPluginId, const char *pszSource, int32_t iLineDefined, uint64_t iTotal, const uint64_t *pCounts, uint16_t iNumOpcodes, NetworkBuffer *pBuffer /* = 0 */)
+	{
+		SCE_SLED_ASSERT(pCounts != NULL);
+
+		typeCode = LuaTypeCodes::kOpcodeProfileFunction;
+		pluginId = iPluginId;
+
+		Utilities::copyString(source, kStringLen, pszSource);
+		lineDefined = iLineDefined;
+		total = iTotal;
+		numOpcodes = iNumOpcodes;
+		counts = pCounts;
+
+		uint16_t iNumRun = 0;
+		for (uint16_t i = 0; i < numOpcodes; i++)
+		{
+			if (counts[i] != 0)
+				iNumRun++;
+		}
+
+		length = kSizeOfBase
+			+ kSizeOfuint16_t + (int)std::strlen(source)
+			+ kSizeOfint32_t
+			+ kSizeOfuint64_t
+			+ kSizeOfuint16_t
+			+ ((kSizeOfuint16_t + kSizeOfuint64_t) * iNumRun);
+
+		if (pBuffer)
+			pack(pBuffer);
+	}
+
+	void OpcodeProfileFunction::pack(NetworkBuffer *pBuffer)
+	{
+		NetworkBufferPacker packer(pBuffer);
+
+		uint16_t iNumRun = 0;
+		for (uint16_t i = 0; i < numOpcodes; i++)
+		{
+			if (counts[i] != 0)
+				iNumRun++;
+		}
+
+		packer.packInt32_t(length);
+		packer.packUInt16_t(typeCode);
+		packer.packUInt16_t(pluginId);
+		packer.packString(source);
+		packer.packInt32_t(lineDefined);
+		packer.packUInt64_t(total);
+		packer.packUInt16_t(iNumRun);
+
+		for (uint16_t i = 0; i < numOpcodes; i++)
+		{
+			if (counts[i] == 0)
+				continue;
+
+			packer.packUInt16_t(i);
+			packer.packUInt64_t(counts[i]);
+		}
+	}
+
+	OpcodeProfileEnd::OpcodeProfileEnd(uint16_t iPluginId, uint64_t iTotalInstructions, uint32_t iNumFunctions, NetworkBuffer *pBuffer /* = 0 */)
+	{
+		typeCode = LuaTypeCodes::kOpcodeProfileEnd;
+		pluginId = iPluginId;
+
+		totalInstructions = iTotalInstructions;
+		numFunctions = iNumFunctions;
+
+		length = kSizeOfBase
+			+ kSizeOfuint64_t
+			+ kSizeOfuint32_t;
+
+		if (pBuffer)
+			pack(pBuffer);
+	}
+
+	void OpcodeProfileEnd::pack(NetworkBuffer *pBuffer)
+	{
+		NetworkBufferPacker packer(pBuffer);
+
+		packer.packInt32_t(length);
+		packer.packUInt16_t(typeCode);
+		packer.packUInt16_t(pluginId);
+		packer.packUInt64_t(totalInstructions);
+		packer.packUInt32_t(numFunctions);
+	}
+
+	ProfileLatency::ProfileLatency(uint16_t iPluginId, char chWhat, const ProfileLatencyHistogram *pHistogram, NetworkBuffer *pBuffer /* = 0 */)
+	{
+		SCE_SLED_ASSERT(pHistogram != NULL);
+
+		typeCode = LuaTypeCodes::kProfileLatency;
+		pluginId = iPluginId;
+
+		what = (uint8_t)chWhat;
+		count = pHistogram->count;
+		longest = pHistogram->longest;
+		p50 = pHistogram->getValueAtPercentile(50.0);
+		p90 = pHistogram->getValueAtPercentile(90.0);
+		p99 = pHistogram->getValueAtPercentile(99.0);
+		p999 = pHistogram->getValueAtPercentile(99.9);
+		subBucketBits = (uint8_t)ProfileLatencyHistogram::kSubBucketBits;
+		histogram = pHistogram;
+
+		length = kSizeOfBase
+			+ kSizeOfuint8_t
+			+ kSizeOfuint32_t
+			+ (kSizeOfuint64_t * 5)
+			+ kSizeOfuint8_t
+			+ kSizeOfuint16_t;
+
+		const int32_t iPairSize = kSizeOfuint16_t + kSizeOfuint32_t;
+		const int32_t iMaxLength = pBuffer ? (int32_t)pBuffer->getMaxSize() : 0x7FFFFFFF;
+
+		numPairs = 0;
+		for (uint16_t i = 0; (i < ProfileLatencyHistogram::kNumBuckets) && ((length + iPairSize) <= iMaxLength); i++)
+		{
+			if (histogram->counts[i] == 0)
+				continue;
+
+			numPairs++;
+			length += iPairSize;
+		}
+
+		if (pBuffer)
+			pack(pBuffer);
+	}
+
+	void ProfileLatency::pack(NetworkBuffer *pBuffer)
+	{
+		NetworkBufferPacker packer(pBuffer);
+
+		packer.packInt32_t(length);
+		packer.packUInt16_t(typeCode);
+		packer.packUInt16_t(pluginId);
+		packer.packUInt8_t(what);
+		packer.packUInt32_t(count);
+		packer.packUInt64_t(longest);
+		packer.packUInt64_t(p50);
+		packer.packUInt64_t(p90);
+		packer.packUInt64_t(p99);
+		packer.packUInt64_t(p999);
+		packer.packUInt8_t(subBucketBits);
+		packer.packUInt16_t(numPairs);
+
+		uint16_t iNumPacked = 0;
+		for (uint16_t i = 0; (i < ProfileLatencyHistogram::kNumBuckets) && (iNumPacked < numPairs); i++)
+		{
+			if (histogram->counts[i] == 0)
+				continue;
+
+			packer.packUInt16_t(i);
+			packer.packUInt32_t(histogram->counts[i]);
+			iNumPacked++;
+		}
+	}
+
+	ProfileAllocations::ProfileAllocations(uint16_t iPluginId, uint32_t iAllocCount, uint64_t iAllocBytes, uint64_t iFreeBytes, NetworkBuffer *pBuffer /* = 0 */)
+	{
+		typeCode = LuaTypeCodes::kProfileAllocations;
+		pluginId = iPluginId;
+
+		allocCount = iAllocCount;
+		allocBytes = iAllocBytes;
+		freeBytes = iFreeBytes;
+
+		length = kSizeOfBase
+			+ kSizeOfuint32_t
+			+ (kSizeOfuint64_t * 2);
+
+		if (pBuffer)
+			pack(pBuffer);
+	}
+
+	void ProfileAllocations::pack(NetworkBuffer *pBuffer)
+	{
+		NetworkBufferPacker packer(pBuffer);
+
+		packer.packInt32_t(length);
+		packer.packUInt16_t(typeCode);
+		packer.packUInt16_t(pluginId);
+		packer.packUInt32_t(allocCount);
+		packer.packUInt64_t(allocBytes);
+		packer.packUInt64_t(freeBytes);
+	}
 }}}
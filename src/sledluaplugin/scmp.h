@@ -13,6 +13,12 @@
 
 #include "../sleddebugger/common.h"
 
+namespace sce { namespace Sled
+{
+	// Forward declarations
+	struct ProfileLatencyHistogram;
+}}
+
 namespace sce { namespace Sled { namespace SCMP
 {
 	namespace LuaTypeCodes
@@ -95,6 +101,54 @@ namespace sce { namespace Sled { namespace SCMP
 			kProfilerToggle = 301,
 
 			kLimits = 310,
+
+			kHeapCensusPerform = 320,
+			kHeapCensusBegin = 321,
+			kHeapCensusType = 322,
+			kHeapCensusTable = 323,
+			kHeapCensusRoot = 324,
+			kHeapCensusEnd = 325,
+
+			kGcInfoBegin = 330,
+			kGcPauseInfo = 331,
+			kGcInfoEnd = 332,
+
+			kVarLookUpPage = 340,
+			kVarLookUpPageBegin = 341,
+			kVarLookUpPageEnd = 342,
+
+			kVarSnapshotBegin = 350,
+			kVarSnapshotRemoved = 351,
+			kVarSnapshotEnd = 352,
+
+			kVarEncoding = 360,
+			kGlobalVarBinary = 361,
+			kLocalVarBinary = 362,
+			kUpvalueVarBinary = 363,
+			kEnvVarBinary = 364,
+
+			kVarTableId = 370,
+			kVarLookUpById = 371,
+
+			kVarTruncated = 380,
+
+			kCoverageToggle = 390,
+			kCoverageReset = 391,
+			kCoveragePerform = 392,
+			kCoverageBegin = 393,
+			kCoverageData = 394,
+			kCoverageEnd = 395,
+
+			kOpcodeProfileToggle = 400,
+			kOpcodeProfileReset = 401,
+			kOpcodeProfilePerform = 402,
+			kOpcodeProfileBegin = 403,
+			kOpcodeProfileOpcode = 404,
+			kOpcodeProfileFunction = 405,
+			kOpcodeProfileEnd = 406,
+
+			kProfileLatency = 410,
+			kProfileAllocations = 411,
 		};
 	}
 	
@@ -104,8 +158,55 @@ namespace sce { namespace Sled { namespace SCMP
 		static const uint16_t kVarNameLen = 256;
 		static const uint16_t kVarValueLen = 256;
 		static const uint16_t kVarKeyValueLen = 128;
+		static const uint16_t kGcPauseBuckets = 16;
+		static const uint16_t kCoverageDataLen = 512;
+	}
+
+	/// How variable values travel in GlobalVar, LocalVar, UpvalueVar & EnvVar.
+	/// Strings is what every client understands; binary is used once a client
+	/// asks for it with a VarEncoding message.
+	namespace VarValueEncoding
+	{
+		enum Enum
+		{
+			kString = 0,
+			kBinary = 1
+		};
 	}
 
+	/// Value of a variable looked up at a breakpoint. With the string encoding
+	/// only text is used. The binary encoding sends numbers, booleans and strings
+	/// as they are and falls back to text for everything else.
+	struct SCE_SLED_LINKAGE VarValue
+	{
+		enum Kind
+		{
+			kText = 0,
+			kNumber = 1,
+			kInteger = 2,		///< Integral number that fits in 64 bits
+			kBoolean = 3,
+			kString = 4			///< Length prefixed slice of a Lua string
+		};
+
+		VarValue() : kind(kText), truncated(0), length(0), number(0.0), integer(0) { text[0] = '\0'; }
+
+		void setText(const char *pszText);
+		void setNumber(double value);
+		void setBoolean(bool value);
+		void setString(const char *pszString, std::size_t len);
+
+		// Bytes identifying the value (for comparing against the previous stop)
+		const void *getData() const;
+		std::size_t getDataLen() const;
+
+		uint8_t		kind;
+		uint8_t		truncated;
+		uint32_t	length;		///< Full length of a string value
+		double		number;
+		int64_t		integer;	///< Integral numbers & booleans
+		char		text[Sizes::kVarValueLen];
+	};
+
 	struct SCE_SLED_LINKAGE MemoryTraceBegin : public Sled::SCMP::Base
 	{
 		MemoryTraceBegin(uint16_t iPluginId)
@@ -336,7 +437,7 @@ namespace sce { namespace Sled { namespace SCMP
 
 	struct SCE_SLED_LINKAGE GlobalVar : public Sled::SCMP::Base
 	{
-		GlobalVar(uint16_t iPluginId, const LuaVariable *pParent, const char *pzsName, int16_t iNameType, const char *pszValue, int16_t iValueType, NetworkBuffer *pBuffer = 0);
+		GlobalVar(uint16_t iPluginId, const LuaVariable *pParent, const char *pzsName, int16_t iNameType, const VarValue& varValue, int16_t iValueType, uint8_t iEncoding, NetworkBuffer *pBuffer = 0);
 		void pack(NetworkBuffer *pBuffer);	
 
 		const LuaVariable *parent;
@@ -344,8 +445,9 @@ namespace sce { namespace Sled { namespace SCMP
 		const char	*name;
 		int16_t		nameType;
 
-		const char	*value;
+		const VarValue	*value;
 		int16_t		valueType;
+		uint8_t		encoding;
 	};
 
 	struct SCE_SLED_LINKAGE GlobalVarEnd : public Sled::SCMP::Base
@@ -390,7 +492,7 @@ namespace sce { namespace Sled { namespace SCMP
 
 	struct SCE_SLED_LINKAGE LocalVar : public Sled::SCMP::Base
 	{
-		LocalVar(uint16_t iPluginId, const LuaVariable *pParent, const char *pszName, int16_t iNameType, const char *pszValue, int16_t iValueType, int16_t iStackLevel, int32_t iIndex, NetworkBuffer *pBuffer = 0);	
+		LocalVar(uint16_t iPluginId, const LuaVariable *pParent, const char *pszName, int16_t iNameType, const VarValue& varValue, int16_t iValueType, uint8_t iEncoding, int16_t iStackLevel, int32_t iIndex, NetworkBuffer *pBuffer = 0);	
 		void pack(NetworkBuffer *pBuffer);	
 
 		const LuaVariable *parent;
@@ -398,8 +500,9 @@ namespace sce { namespace Sled { namespace SCMP
 		const char	*name;
 		int16_t		nameType;
 
-		const char	*value;
+		const VarValue	*value;
 		int16_t		valueType;
+		uint8_t		encoding;
 
 		int16_t		stackLevel;
 		int32_t		index;	
@@ -447,7 +550,7 @@ namespace sce { namespace Sled { namespace SCMP
 
 	struct SCE_SLED_LINKAGE UpvalueVar : public Sled::SCMP::Base
 	{
-		UpvalueVar(uint16_t iPluginId, const LuaVariable *pParent, const char *pszName, int16_t iNameType, const char *pszValue, int16_t iValueType, int16_t iStackLevel, int32_t iIndex, NetworkBuffer *pBuffer = 0);
+		UpvalueVar(uint16_t iPluginId, const LuaVariable *pParent, const char *pszName, int16_t iNameType, const VarValue& varValue, int16_t iValueType, uint8_t iEncoding, int16_t iStackLevel, int32_t iIndex, NetworkBuffer *pBuffer = 0);
 		void pack(NetworkBuffer *pBuffer);	
 
 		const LuaVariable *parent;
@@ -455,8 +558,9 @@ namespace sce { namespace Sled { namespace SCMP
 		const char	*name;
 		int16_t		nameType;
 
-		const char	*value;
+		const VarValue	*value;
 		int16_t		valueType;
+		uint8_t		encoding;
 
 		int16_t		stackLevel;
 		int32_t		index;	
@@ -504,7 +608,7 @@ namespace sce { namespace Sled { namespace SCMP
 
 	struct SCE_SLED_LINKAGE EnvVar : public Sled::SCMP::Base
 	{
-		EnvVar(uint16_t iPluginId, const LuaVariable *pParent, const char *pszName, int16_t iNameType, const char *pszValue, int16_t iValueType, int16_t iStackLevel, NetworkBuffer *pBuffer = 0);
+		EnvVar(uint16_t iPluginId, const LuaVariable *pParent, const char *pszName, int16_t iNameType, const VarValue& varValue, int16_t iValueType, uint8_t iEncoding, int16_t iStackLevel, NetworkBuffer *pBuffer = 0);
 		void pack(NetworkBuffer *pBuffer);	
 
 		const LuaVariable *parent;
@@ -512,8 +616,9 @@ namespace sce { namespace Sled { namespace SCMP
 		const char	*name;
 		int16_t		nameType;
 
-		const char	*value;
+		const VarValue	*value;
 		int16_t		valueType;
+		uint8_t		encoding;
 
 		int16_t		stackLevel;	
 	};
@@ -788,6 +893,375 @@ namespace sce { namespace Sled { namespace SCMP
 		uint8_t		profilerEnabled;
 		uint8_t		memoryTracerEnabled;
 	};
+
+	struct SCE_SLED_LINKAGE HeapCensusPerform : public Sled::SCMP::Base
+	{
+		HeapCensusPerform(uint16_t iPluginId)
+		{
+			length = sizeof(HeapCensusPerform);
+			typeCode = LuaTypeCodes::kHeapCensusPerform;
+			pluginId = iPluginId;
+		}
+	};
+
+	struct SCE_SLED_LINKAGE HeapCensusBegin : public Sled::SCMP::Base
+	{
+		HeapCensusBegin(uint16_t iPluginId)
+		{
+			length = sizeof(HeapCensusBegin);
+			typeCode = LuaTypeCodes::kHeapCensusBegin;
+			pluginId = iPluginId;
+		}
+	};
+
+	struct SCE_SLED_LINKAGE HeapCensusType : public Sled::SCMP::Base
+	{
+		HeapCensusType(uint16_t iPluginId, int16_t iLuaType, uint32_t iCount, uint64_t iBytes, NetworkBuffer *pBuffer = 0);
+		void pack(NetworkBuffer *pBuffer);
+
+		int16_t		luaType;
+		uint32_t	count;
+		uint64_t	bytes;
+	};
+
+	struct SCE_SLED_LINKAGE HeapCensusTable : public Sled::SCMP::Base
+	{
+		HeapCensusTable(uint16_t iPluginId, const void *pTable, const char *pszRoot, uint32_t iArrayCount, uint32_t iHashCount, uint32_t iBytes, NetworkBuffer *pBuffer = 0);
+		void pack(NetworkBuffer *pBuffer);
+
+		char		address[Sizes::kPtrLen];
+		char		root[kStringLen];
+		uint32_t	arrayCount;
+		uint32_t	hashCount;
+		uint32_t	bytes;
+	};
+
+	struct SCE_SLED_LINKAGE HeapCensusRoot : public Sled::SCMP::Base
+	{
+		HeapCensusRoot(uint16_t iPluginId, const char *pszName, uint32_t iObjects, uint64_t iBytes, NetworkBuffer *pBuffer = 0);
+		void pack(NetworkBuffer *pBuffer);
+
+		char		name[kStringLen];
+		uint32_t	objects;
+		uint64_t	bytes;
+	};
+
+	struct SCE_SLED_LINKAGE HeapCensusEnd : public Sled::SCMP::Base
+	{
+		HeapCensusEnd(uint16_t iPluginId, uint32_t iNumObjects, uint64_t iTotalBytes, float flElapsed, bool bTruncated, NetworkBuffer *pBuffer = 0);
+		void pack(NetworkBuffer *pBuffer);
+
+		uint32_t	numObjects;
+		uint64_t	totalBytes;
+		float		elapsed;
+		uint8_t		truncated;
+	};
+
+	struct SCE_SLED_LINKAGE GcInfoBegin : public Sled::SCMP::Base
+	{
+		GcInfoBegin(uint16_t iPluginId)
+		{
+			length = sizeof(GcInfoBegin);
+			typeCode = LuaTypeCodes::kGcInfoBegin;
+			pluginId = iPluginId;
+		}
+	};
+
+	struct SCE_SLED_LINKAGE GcPauseInfo : public Sled::SCMP::Base
+	{
+		GcPauseInfo(uint16_t iPluginId, char chWhat, uint32_t iCount, float flTotal, float flLongest, float flFirstBucketUpperBound, const uint32_t *pBuckets, uint16_t iNumBuckets, NetworkBuffer *pBuffer = 0);
+		void pack(NetworkBuffer *pBuffer);
+
+		uint8_t		what;
+		uint32_t	count;
+		float		total;
+		float		longest;
+		float		firstBucketUpperBound;
+		uint16_t	numBuckets;
+		uint32_t	buckets[Sizes::kGcPauseBuckets];
+	};
+
+	struct SCE_SLED_LINKAGE GcInfoEnd : public Sled::SCMP::Base
+	{
+		GcInfoEnd(uint16_t iPluginId, uint32_t iNumCycles, uint64_t iBytesSwept, uint64_t iBytesInUse, NetworkBuffer *pBuffer = 0);
+		void pack(NetworkBuffer *pBuffer);
+
+		uint32_t	numCycles;
+		uint64_t	bytesSwept;
+		uint64_t	bytesInUse;
+	};
+
+	struct SCE_SLED_LINKAGE VarLookUpPage : public Sled::SCMP::Base
+	{
+		VarLookUpPage(NetworkBufferReader *reader, uint8_t *scratchBuffer, uint16_t scratchBufferMaxSize) { unpack(reader, scratchBuffer, scratchBufferMaxSize); }
+		void unpack(NetworkBufferReader *reader, uint8_t *scratchBuffer, uint16_t scratchBufferMaxSize);
+
+		// An empty name with no key values pages the scope itself
+		inline bool isScope() const { return (variable.name[0] == '\0') && (variable.numKeyValues == 0); }
+
+		LuaVariable	variable;
+		uint32_t	offset;
+		uint32_t	limit;
+	};
+
+	struct SCE_SLED_LINKAGE VarLookUpPageBegin : public Sled::SCMP::Base
+	{
+		VarLookUpPageBegin(uint16_t iPluginId, uint8_t iWhat, uint32_t iOffset, uint32_t iLimit, NetworkBuffer *pBuffer = 0);
+		void pack(NetworkBuffer *pBuffer);
+
+		uint8_t		what;
+		uint32_t	offset;
+		uint32_t	limit;
+	};
+
+	struct SCE_SLED_LINKAGE VarLookUpPageEnd : public Sled::SCMP::Base
+	{
+		VarLookUpPageEnd(uint16_t iPluginId, uint8_t iWhat, uint32_t iOffset, uint32_t iTotal, NetworkBuffer *pBuffer = 0);
+		void pack(NetworkBuffer *pBuffer);
+
+		uint8_t		what;
+		uint32_t	offset;
+		uint32_t	total;
+	};
+
+	struct SCE_SLED_LINKAGE VarSnapshotBegin : public Sled::SCMP::Base
+	{
+		VarSnapshotBegin(uint16_t iPluginId, bool bFull, NetworkBuffer *pBuffer = 0);
+		void pack(NetworkBuffer *pBuffer);
+
+		uint8_t		full;
+	};
+
+	struct SCE_SLED_LINKAGE VarSnapshotRemoved : public Sled::SCMP::Base
+	{
+		VarSnapshotRemoved(uint16_t iPluginId, char chWhat, const char *pszName, int16_t iNameType, int16_t iStackLevel, int32_t iIndex, NetworkBuffer *pBuffer = 0);
+		void pack(NetworkBuffer *pBuffer);
+
+		uint8_t		what;
+		const char*	name;
+		int16_t		nameType;
+		int16_t		stackLevel;
+		int32_t		index;
+	};
+
+	struct SCE_SLED_LINKAGE VarSnapshotEnd : public Sled::SCMP::Base
+	{
+		VarSnapshotEnd(uint16_t iPluginId, uint32_t iNumAdded, uint32_t iNumChanged, uint32_t iNumUnchanged, uint32_t iNumRemoved, NetworkBuffer *pBuffer = 0);
+		void pack(NetworkBuffer *pBuffer);
+
+		uint32_t	numAdded;
+		uint32_t	numChanged;
+		uint32_t	numUnchanged;
+		uint32_t	numRemoved;
+	};
+
+	struct SCE_SLED_LINKAGE VarEncoding : public Sled::SCMP::Base
+	{
+		VarEncoding(uint16_t iPluginId, uint8_t iEncoding, NetworkBuffer *pBuffer = 0);
+		VarEncoding(NetworkBufferReader *reader) { unpack(reader); }
+		void pack(NetworkBuffer *pBuffer);
+		void unpack(NetworkBufferReader *reader);
+
+		uint8_t		encoding;
+	};
+
+	struct SCE_SLED_LINKAGE VarTableId : public Sled::SCMP::Base
+	{
+		VarTableId(uint16_t iPluginId, uint8_t iWhat, uint32_t iId, uint32_t iVersion, bool bUnchanged, NetworkBuffer *pBuffer = 0);
+		void pack(NetworkBuffer *pBuffer);
+
+		uint8_t		what;
+		uint32_t	id;
+		uint32_t	version;
+		uint8_t		unchanged;
+	};
+
+	struct SCE_SLED_LINKAGE VarLookUpById : public Sled::SCMP::Base
+	{
+		VarLookUpById(NetworkBufferReader *reader, uint8_t *scratchBuffer, uint16_t scratchBufferMaxSize) { unpack(reader, scratchBuffer, scratchBufferMaxSize); }
+		void unpack(NetworkBufferReader *reader, uint8_t *scratchBuffer, uint16_t scratchBufferMaxSize);
+
+		// An empty name with no key values looks the table up by id alone
+		inline bool isIdOnly() const { return (variable.name[0] == '\0') && (variable.numKeyValues == 0); }
+
+		LuaVariable	variable;
+		uint32_t	id;
+		uint32_t	version;
+	};
+
+	struct SCE_SLED_LINKAGE VarTruncated : public Sled::SCMP::Base
+	{
+		VarTruncated(uint16_t iPluginId, uint8_t iWhat, int16_t iStackLevel, uint32_t iOffset, NetworkBuffer *pBuffer = 0);
+		void pack(NetworkBuffer *pBuffer);
+
+		uint8_t		what;
+		int16_t		stackLevel;
+		uint32_t	offset;
+	};
+
+	struct SCE_SLED_LINKAGE CoverageToggle : public Sled::SCMP::Base
+	{
+		CoverageToggle(uint16_t iPluginId)
+		{
+			length = sizeof(CoverageToggle);
+			typeCode = LuaTypeCodes::kCoverageToggle;
+			pluginId = iPluginId;
+		}
+	};
+
+	struct SCE_SLED_LINKAGE CoverageReset : public Sled::SCMP::Base
+	{
+		CoverageReset(uint16_t iPluginId)
+		{
+			length = sizeof(CoverageReset);
+			typeCode = LuaTypeCodes::kCoverageReset;
+			pluginId = iPluginId;
+		}
+	};
+
+	struct SCE_SLED_LINKAGE CoveragePerform : public Sled::SCMP::Base
+	{
+		CoveragePerform(uint16_t iPluginId)
+		{
+			length = sizeof(CoveragePerform);
+			typeCode = LuaTypeCodes::kCoveragePerform;
+			pluginId = iPluginId;
+		}
+	};
+
+	struct SCE_SLED_LINKAGE CoverageBegin : public Sled::SCMP::Base
+	{
+		CoverageBegin(uint16_t iPluginId, bool bRunning, NetworkBuffer *pBuffer = 0);
+		void pack(NetworkBuffer *pBuffer);
+
+		uint8_t		running;
+	};
+
+	/// A piece of the CoverageWriter output; the pieces in between a
+	/// CoverageBegin & CoverageEnd put back together make the whole of it
+	struct SCE_SLED_LINKAGE CoverageData : public Sled::SCMP::Base
+	{
+		CoverageData(uint16_t iPluginId, const uint8_t *pData, uint16_t iSize, NetworkBuffer *pBuffer = 0);
+		void pack(NetworkBuffer *pBuffer);
+
+		uint16_t	size;
+		uint8_t		data[Sizes::kCoverageDataLen];
+	};
+
+	struct SCE_SLED_LINKAGE CoverageEnd : public Sled::SCMP::Base
+	{
+		CoverageEnd(uint16_t iPluginId, uint32_t iNumChunks, uint64_t iNumBytes, bool bComplete, NetworkBuffer *pBuffer = 0);
+		void pack(NetworkBuffer *pBuffer);
+
+		uint32_t	numChunks;
+		uint64_t	numBytes;
+		uint8_t		complete;
+	};
+
+	struct SCE_SLED_LINKAGE OpcodeProfileToggle : public Sled::SCMP::Base
+	{
+		OpcodeProfileToggle(uint16_t iPluginId)
+		{
+			length = sizeof(OpcodeProfileToggle);
+			typeCode = LuaTypeCodes::kOpcodeProfileToggle;
+			pluginId = iPluginId;
+		}
+	};
+
+	struct SCE_SLED_LINKAGE OpcodeProfileReset : public Sled::SCMP::Base
+	{
+		OpcodeProfileReset(uint16_t iPluginId)
+		{
+			length = sizeof(OpcodeProfileReset);
+			typeCode = LuaTypeCodes::kOpcodeProfileReset;
+			pluginId = iPluginId;
+		}
+	};
+
+	struct SCE_SLED_LINKAGE OpcodeProfilePerform : public Sled::SCMP::Base
+	{
+		OpcodeProfilePerform(uint16_t iPluginId)
+		{
+			length = sizeof(OpcodeProfilePerform);
+			typeCode = LuaTypeCodes::kOpcodeProfilePerform;
+			pluginId = iPluginId;
+		}
+	};
+
+	struct SCE_SLED_LINKAGE OpcodeProfileBegin : public Sled::SCMP::Base
+	{
+		OpcodeProfileBegin(uint16_t iPluginId, uint16_t iNumOpcodes, bool bRunning, NetworkBuffer *pBuffer = 0);
+		void pack(NetworkBuffer *pBuffer);
+
+		uint16_t	numOpcodes;
+		uint8_t		running;
+	};
+
+	struct SCE_SLED_LINKAGE OpcodeProfileOpcode : public Sled::SCMP::Base
+	{
+		OpcodeProfileOpcode(uint16_t iPluginId, uint16_t iOpcode, const char *pszName, uint64_t iCount, NetworkBuffer *pBuffer = 0);
+		void pack(NetworkBuffer *pBuffer);
+
+		uint16_t	opcode;
+		char		name[kStringLen];
+		uint64_t	count;
+	};
+
+	/// One function's counts, sent as opcode & count pairs for the
+	/// opcodes it ran
+	struct SCE_SLED_LINKAGE OpcodeProfileFunction : public Sled::SCMP::Base
+	{
+		OpcodeProfileFunction(uint16_t iPluginId, const char *pszSource, int32_t iLineDefined, uint64_t iTotal, const uint64_t *pCounts, uint16_t iNumOpcodes, NetworkBuffer *pBuffer = 0);
+		void pack(NetworkBuffer *pBuffer);
+
+		char			source[kStringLen];
+		int32_t			lineDefined;
+		uint64_t		total;
+		uint16_t		numOpcodes;
+		const uint64_t	*counts;
+	};
+
+	struct SCE_SLED_LINKAGE OpcodeProfileEnd : public Sled::SCMP::Base
+	{
+		OpcodeProfileEnd(uint16_t iPluginId, uint64_t iTotalInstructions, uint32_t iNumFunctions, NetworkBuffer *pBuffer = 0);
+		void pack(NetworkBuffer *pBuffer);
+
+		uint64_t	totalInstructions;
+		uint32_t	numFunctions;
+	};
+
+	/// One latency histogram of the function in the ProfileInfo sent
+	/// just before it, sent as bucket & count pairs for the buckets in
+	/// use; pairs that don't fit the send buffer are left out
+	struct SCE_SLED_LINKAGE ProfileLatency : public Sled::SCMP::Base
+	{
+		ProfileLatency(uint16_t iPluginId, char chWhat, const ProfileLatencyHistogram *pHistogram, NetworkBuffer *pBuffer = 0);
+		void pack(NetworkBuffer *pBuffer);
+
+		uint8_t							what;
+		uint32_t						count;
+		uint64_t						longest;
+		uint64_t						p50;
+		uint64_t						p90;
+		uint64_t						p99;
+		uint64_t						p999;
+		uint8_t							subBucketBits;
+		uint16_t						numPairs;
+		const ProfileLatencyHistogram	*histogram;
+	};
+
+	/// Memory charged to the function in the ProfileInfo sent just
+	/// before it while allocations are being profiled; only sent for
+	/// functions that had any
+	struct SCE_SLED_LINKAGE ProfileAllocations : public Sled::SCMP::Base
+	{
+		ProfileAllocations(uint16_t iPluginId, uint32_t iAllocCount, uint64_t iAllocBytes, uint64_t iFreeBytes, NetworkBuffer *pBuffer = 0);
+		void pack(NetworkBuffer *pBuffer);
+
+		uint32_t	allocCount;
+		uint64_t	allocBytes;
+		uint64_t	freeBytes;
+	};
 }}}
 
 #endif // __SCE_LIBSLEDLUAPLUGIN_SCMP_H__
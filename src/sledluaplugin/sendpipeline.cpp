@@ -0,0 +1,321 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "sendpipeline.h"
+#include "sledluaplugin.h"
+#include "../sleddebugger/assert.h"
+#include "../sleddebugger/errorcodes.h"
+#include "../sleddebugger/sequentialallocator.h"
+#include "../sleddebugger/utilities.h"
+
+#include "../sledcore/mutex.h"
+#include "../sledcore/thread.h"
+#include "../sledcore/sleep.h"
+
+#include <cstring>
+#include <new>
+
+namespace sce { namespace Sled
+{
+	void SendPipelineConfig::init(const SendPipelineConfig& rhs)
+	{
+		arenaSize = rhs.arenaSize;
+	}
+
+	SendPipelineConfig::SendPipelineConfig(const LuaPluginConfig *pConfig)
+	{
+		SCE_SLED_ASSERT(pConfig != NULL);
+
+		arenaSize = pConfig->breakpointSendArenaSize;
+	}
+
+	namespace
+	{
+		struct SendPipelineSeats
+		{
+			void *m_this;
+			void *m_arena;
+			void *m_mutex;
+			void *m_thread;
+
+			void Allocate(const SendPipelineConfig& pipelineConfig, ISequentialAllocator *pAllocator)
+			{
+				// For this
+				m_this = pAllocator->allocate(sizeof(SendPipeline), __alignof(SendPipeline));
+
+				// Nothing else is needed when the pipeline is off
+				m_arena = 0;
+				m_mutex = 0;
+				m_thread = 0;
+
+				if (pipelineConfig.arenaSize == 0)
+					return;
+
+				// For m_pArena
+				m_arena = pAllocator->allocate(sizeof(uint8_t) * pipelineConfig.arenaSize, __alignof(uint8_t));
+
+				// For m_pMutex
+				m_mutex = pAllocator->allocate(sizeof(SceSledPlatformMutex), __alignof(SceSledPlatformMutex));
+
+				// For m_pThread
+				m_thread = pAllocator->allocate(sizeof(SceSledPlatformThread), __alignof(SceSledPlatformThread));
+			}
+		};
+
+		const char *kWorkerThreadName = "SledLuaPluginSend";
+	}
+
+	int32_t SendPipeline::create(const SendPipelineConfig& pipelineConfig, void *pLocation, SendPipeline **ppPipeline)
+	{
+		SCE_SLED_ASSERT(pLocation != NULL);
+		SCE_SLED_ASSERT(ppPipeline != NULL);
+
+		std::size_t iMemSize = 0;
+
+		const int32_t iError = requiredMemory(pipelineConfig, &iMemSize);
+		if (iError != 0)
+			return iError;
+
+		SequentialAllocator allocator(pLocation, iMemSize);
+
+		SendPipelineSeats seats;
+		seats.Allocate(pipelineConfig, &allocator);
+
+		SCE_SLED_ASSERT(seats.m_this != NULL);
+
+		*ppPipeline = new (seats.m_this) SendPipeline(pipelineConfig, &seats);
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t SendPipeline::requiredMemory(const SendPipelineConfig& pipelineConfig, std::size_t *iRequiredMemory)
+	{
+		SCE_SLED_ASSERT(iRequiredMemory != NULL);
+
+		SequentialAllocatorCalculator allocator;
+
+		SendPipelineSeats seats;
+		seats.Allocate(pipelineConfig, &allocator);
+
+		*iRequiredMemory = allocator.bytesAllocated();
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t SendPipeline::requiredMemoryHelper(const SendPipelineConfig& pipelineConfig, ISequentialAllocator *pAllocator, void **ppThis)
+	{
+		SCE_SLED_ASSERT(pAllocator != NULL);
+		SCE_SLED_ASSERT(ppThis != NULL);
+
+		SendPipelineSeats seats;
+		seats.Allocate(pipelineConfig, pAllocator);
+
+		*ppThis = seats.m_this;
+		return SCE_SLED_ERROR_OK;
+	}
+
+	void SendPipeline::shutdown(SendPipeline *pPipeline)
+	{
+		SCE_SLED_ASSERT(pPipeline != NULL);
+		pPipeline->~SendPipeline();
+	}
+
+	SendPipeline::SendPipeline(const SendPipelineConfig& pipelineConfig, const void *pPipelineSeats)
+		: m_iArenaSize(pipelineConfig.arenaSize)
+		, m_pArena(0)
+		, m_pMutex(0)
+		, m_pThread(0)
+		, m_pfnSend(0)
+		, m_pUserData(0)
+		, m_iReadPos(0)
+		, m_iNumQueued(0)
+		, m_bStopping(false)
+		, m_bSendError(false)
+		, m_iNumSends(0)
+		, m_iNumBytes(0)
+		, m_iWritePos(0)
+		, m_bRunning(false)
+	{
+		SCE_SLED_ASSERT(pPipelineSeats != NULL);
+
+		const SendPipelineSeats *pSeats = static_cast<const SendPipelineSeats*>(pPipelineSeats);
+
+		if (m_iArenaSize == 0)
+			return;
+
+		m_pArena = new (pSeats->m_arena) uint8_t[m_iArenaSize];
+
+		m_pMutex = new (pSeats->m_mutex) SceSledPlatformMutex;
+		sceSledPlatformMutexAllocate(m_pMutex, SCE_SLEDPLATFORM_MUTEX_RECURSIVE);
+
+		m_pThread = new (pSeats->m_thread) SceSledPlatformThread;
+		sceSledPlatformThreadInvalidate(m_pThread);
+	}
+
+	SendPipeline::~SendPipeline()
+	{
+		if (m_iArenaSize == 0)
+			return;
+
+		end();
+		sceSledPlatformMutexDeallocate(m_pMutex);
+	}
+
+	void SendPipeline::begin(SendCallback pfnSend, void *pUserData)
+	{
+		SCE_SLED_ASSERT(isEnabled());
+		SCE_SLED_ASSERT(pfnSend != NULL);
+		SCE_SLED_ASSERT(!m_bRunning);
+
+		m_pfnSend = pfnSend;
+		m_pUserData = pUserData;
+
+		m_iReadPos = 0;
+		m_iWritePos = 0;
+		m_iNumQueued = 0;
+		m_bStopping = false;
+		m_bSendError = false;
+		m_iNumSends = 0;
+		m_iNumBytes = 0;
+
+		SceSledPlatformThreadAttr attr = SCE_SLEDPLATFORM_THREADATTR_INITIALIZER;
+		Utilities::copyString(attr.name, SCE_SLEDPLATFORM_THREAD_NAME_MAX, kWorkerThreadName);
+
+		sceSledPlatformThreadCreate(m_pThread, &attr, workerEntry, this);
+		m_bRunning = true;
+	}
+
+	void SendPipeline::enqueue(const uint8_t *pData, int32_t iSize)
+	{
+		SCE_SLED_ASSERT(m_bRunning);
+		SCE_SLED_ASSERT(pData != NULL);
+
+		uint32_t iRemaining = (iSize > 0) ? (uint32_t)iSize : 0;
+		while (iRemaining > 0)
+		{
+			const uint32_t iFree = m_iArenaSize - getNumQueued();
+			if (iFree == 0)
+			{
+				// Worker is behind; let it catch up
+				sceSledPlatformThreadSleepMilliseconds(0);
+				continue;
+			}
+
+			// Copy as much as fits before the arena wraps
+			uint32_t iChunk = m_iArenaSize - m_iWritePos;
+			if (iChunk > iFree)
+				iChunk = iFree;
+			if (iChunk > iRemaining)
+				iChunk = iRemaining;
+
+			std::memcpy(m_pArena + m_iWritePos, pData, iChunk);
+			m_iWritePos = (m_iWritePos + iChunk) % m_iArenaSize;
+			pData += iChunk;
+			iRemaining -= iChunk;
+
+			const sce::SledPlatform::MutexLocker smg(m_pMutex);
+			m_iNumQueued += iChunk;
+		}
+	}
+
+	void SendPipeline::drain()
+	{
+		if (!m_bRunning)
+			return;
+
+		while (getNumQueued() != 0)
+			sceSledPlatformThreadSleepMilliseconds(0);
+	}
+
+	void SendPipeline::end()
+	{
+		if (!m_bRunning)
+			return;
+
+		drain();
+
+		{
+			const sce::SledPlatform::MutexLocker smg(m_pMutex);
+			m_bStopping = true;
+		}
+
+		sceSledPlatformThreadJoin(m_pThread);
+		sceSledPlatformThreadInvalidate(m_pThread);
+		m_bRunning = false;
+	}
+
+	void SendPipeline::workerEntry(void *pParameter)
+	{
+		SCE_SLED_ASSERT(pParameter != NULL);
+		static_cast<SendPipeline*>(pParameter)->workerLoop();
+	}
+
+	void SendPipeline::workerLoop()
+	{
+		for (;;)
+		{
+			uint32_t iReadPos = 0;
+			uint32_t iQueued = 0;
+			bool bStopping = false;
+			bool bSendError = false;
+
+			{
+				const sce::SledPlatform::MutexLocker smg(m_pMutex);
+				iReadPos = m_iReadPos;
+				iQueued = m_iNumQueued;
+				bStopping = m_bStopping;
+				bSendError = m_bSendError;
+			}
+
+			if (iQueued == 0)
+			{
+				if (bStopping)
+					return;
+
+				sceSledPlatformThreadSleepMilliseconds(0);
+				continue;
+			}
+
+			// Everything up to the end of the arena in one go; whatever
+			// wrapped around goes out on the next pass
+			uint32_t iRun = m_iArenaSize - iReadPos;
+			if (iRun > iQueued)
+				iRun = iQueued;
+
+			// After a failed send the rest of the stop is dropped
+			uint32_t iConsumed = iRun;
+			bool bSent = false;
+			if (!bSendError)
+			{
+				const int32_t iSent = m_pfnSend(m_pUserData, m_pArena + iReadPos, (int32_t)iRun);
+				if (iSent > 0)
+				{
+					// Partial sends pick up where they left off next pass
+					iConsumed = (uint32_t)iSent;
+					bSent = true;
+				}
+				else
+				{
+					bSendError = true;
+				}
+			}
+
+			const sce::SledPlatform::MutexLocker smg(m_pMutex);
+			m_iReadPos = (iReadPos + iConsumed) % m_iArenaSize;
+			m_iNumQueued -= iConsumed;
+			m_bSendError = bSendError;
+
+			if (bSent)
+			{
+				m_iNumSends++;
+				m_iNumBytes += iConsumed;
+			}
+		}
+	}
+
+	uint32_t SendPipeline::getNumQueued()
+	{
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+		return m_iNumQueued;
+	}
+}}
@@ -0,0 +1,105 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#ifndef __SCE_LIBSLEDLUAPLUGIN_SENDPIPELINE_H__
+#define __SCE_LIBSLEDLUAPLUGIN_SENDPIPELINE_H__
+
+#include "../sledcore/base_types.h"
+#include <cstddef>
+
+#include "../sleddebugger/common.h"
+
+// Forward declarations
+struct SceSledPlatformMutex;
+struct SceSledPlatformThread;
+
+namespace sce { namespace Sled
+{
+	// Forward declarations
+	class ISequentialAllocator;
+
+	// Forward declarations
+	struct LuaPluginConfig;
+
+	struct SCE_SLED_LINKAGE SendPipelineConfig
+	{
+		SendPipelineConfig() : arenaSize(0) {}
+		SendPipelineConfig(const SendPipelineConfig& rhs) { init(rhs); }
+		SendPipelineConfig& operator=(const SendPipelineConfig& rhs) { init(rhs); return *this; }
+
+		SendPipelineConfig(const LuaPluginConfig *pConfig);
+
+	private:
+		void init(const SendPipelineConfig& rhs);
+	public:
+
+		uint32_t		arenaSize;		///< Size, in bytes, of the queue between the game thread and the send thread (0 = send on the game thread)
+	};
+
+	// Hands packed messages from the game thread to a worker thread that
+	// does the blocking socket sends, so walking the Lua state and network
+	// I/O overlap. Messages go out in the order they were queued.
+	class SCE_SLED_LINKAGE SendPipeline
+	{
+	public:
+		// Called on the worker thread; returns the number of bytes sent or a negative error
+		typedef int32_t (*SendCallback)(void *pUserData, const uint8_t *pData, int32_t iSize);
+	public:
+		static int32_t create(const SendPipelineConfig& pipelineConfig, void *pLocation, SendPipeline **ppPipeline);
+		static int32_t requiredMemory(const SendPipelineConfig& pipelineConfig, std::size_t *iRequiredMemory);
+		static int32_t requiredMemoryHelper(const SendPipelineConfig& pipelineConfig, ISequentialAllocator *pAllocator, void **ppThis);
+		static void shutdown(SendPipeline *pPipeline);
+	private:
+		SendPipeline(const SendPipelineConfig& pipelineConfig, const void *pPipelineSeats);
+		~SendPipeline();
+		SendPipeline(const SendPipeline&);
+		SendPipeline& operator=(const SendPipeline&);
+	public:
+		// Starts the worker thread
+		void begin(SendCallback pfnSend, void *pUserData);
+
+		// Copies a message into the arena, waiting for room if the worker is behind
+		void enqueue(const uint8_t *pData, int32_t iSize);
+
+		// Waits until everything queued so far has been sent
+		void drain();
+
+		// Drains then stops the worker thread
+		void end();
+
+		inline bool isEnabled() const					{ return m_iArenaSize != 0; }
+		inline bool isRunning() const					{ return m_bRunning; }
+		inline uint32_t getNumSends() const				{ return m_iNumSends; }
+		inline uint64_t getNumBytes() const				{ return m_iNumBytes; }
+		inline bool hadSendError() const				{ return m_bSendError; }
+	private:
+		static void workerEntry(void *pParameter);
+		void workerLoop();
+		uint32_t getNumQueued();
+	private:
+		const uint32_t			m_iArenaSize;
+		uint8_t*				m_pArena;
+
+		SceSledPlatformMutex*	m_pMutex;
+		SceSledPlatformThread*	m_pThread;
+
+		SendCallback			m_pfnSend;
+		void*					m_pUserData;
+
+		// Shared with the worker; guarded by m_pMutex
+		uint32_t				m_iReadPos;
+		uint32_t				m_iNumQueued;
+		bool					m_bStopping;
+		bool					m_bSendError;
+		uint32_t				m_iNumSends;
+		uint64_t				m_iNumBytes;
+
+		// Game thread only
+		uint32_t				m_iWritePos;
+		bool					m_bRunning;
+	};
+}}
+
+#endif // __SCE_LIBSLEDLUAPLUGIN_SENDPIPELINE_H__
@@ -155,6 +155,24 @@ namespace sce { namespace Sled
 		return SCE_SLED_ERROR_OK;
 	}
 
+	int32_t luaPluginSetVarTransferMode(LuaPlugin *plugin, VarTransferMode::Enum mode)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		plugin->setVarTransferMode(mode);
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t luaPluginGetVarTransferMode(const LuaPlugin *plugin, VarTransferMode::Enum *outMode)
+	{
+		if ((plugin == NULL) || (outMode == NULL))
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		(*outMode) = plugin->getVarTransferMode();
+		return SCE_SLED_ERROR_OK;
+	}
+
 	int32_t luaPluginMemoryTraceNotify(LuaPlugin *plugin, void *userData, void *oldPtr, void *newPtr, std::size_t oldSize, std::size_t newSize, bool *outResult)
 	{
 		if (plugin == NULL)
@@ -164,6 +182,295 @@ namespace sce { namespace Sled
 		return SCE_SLED_ERROR_OK;
 	}
 
+	int32_t luaPluginHeapCensus(LuaPlugin *plugin, lua_State *luaState, HeapCensusSummary *outSummary)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->heapCensus(luaState, outSummary);
+	}
+
+	int32_t luaPluginSetCoverage(LuaPlugin *plugin, bool enable)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		plugin->setCoverage(enable);
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t luaPluginIsCoverageRunning(const LuaPlugin *plugin, bool *outResult)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		(*outResult) = plugin->isCoverageRunning();
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t luaPluginResetCoverage(LuaPlugin *plugin)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		plugin->resetCoverage();
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t luaPluginWriteCoverage(LuaPlugin *plugin, lua_State *luaState, CoverageWriteCallback writeCallback, void *userData)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->writeCoverage(luaState, writeCallback, userData);
+	}
+
+	int32_t luaPluginSendCoverage(LuaPlugin *plugin, lua_State *luaState)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->sendCoverage(luaState);
+	}
+
+	int32_t luaPluginSetOpcodeProfile(LuaPlugin *plugin, bool enable)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->setOpcodeProfile(enable);
+	}
+
+	int32_t luaPluginIsOpcodeProfileRunning(const LuaPlugin *plugin, bool *outResult)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		(*outResult) = plugin->isOpcodeProfileRunning();
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t luaPluginResetOpcodeProfile(LuaPlugin *plugin)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		plugin->resetOpcodeProfile();
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t luaPluginOpcodeProfile(LuaPlugin *plugin, lua_State *luaState, OpcodeProfileSummary *outSummary)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->opcodeProfile(luaState, outSummary);
+	}
+
+	int32_t luaPluginWriteProfileFolded(LuaPlugin *plugin, ProfileFoldedWriteCallback writeCallback, void *userData, ProfileFoldedWeight::Enum weight)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->writeProfileFolded(writeCallback, userData, weight);
+	}
+
+	int32_t luaPluginWriteProfileCapture(LuaPlugin *plugin, ProfileCaptureWriteCallback writeCallback, void *userData, const char *buildId)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->writeProfileCapture(writeCallback, userData, buildId);
+	}
+
+	int32_t luaPluginProfileLatency(const LuaPlugin *plugin, const char *source, int32_t lineDefined, ProfileLatencySummary *outSummary)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->profileLatency(source, lineDefined, outSummary);
+	}
+
+	int32_t luaPluginProfileFunctionTimes(const LuaPlugin *plugin, const char *source, int32_t lineDefined, ProfileFunctionTimes *outTimes)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->profileFunctionTimes(source, lineDefined, outTimes);
+	}
+
+	int32_t luaPluginSetAllocationProfile(LuaPlugin *plugin, bool enable)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		plugin->setAllocationProfile(enable);
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t luaPluginIsAllocationProfileRunning(const LuaPlugin *plugin, bool *outResult)
+	{
+		if ((plugin == NULL) || (outResult == NULL))
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		(*outResult) = plugin->isAllocationProfileRunning();
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t luaPluginProfileAllocations(const LuaPlugin *plugin, const char *source, int32_t lineDefined, ProfileFunctionAllocations *outAllocations)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->profileAllocations(source, lineDefined, outAllocations);
+	}
+
+	int32_t luaPluginProfilerOverhead(const LuaPlugin *plugin, ProfileOverhead *outOverhead)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->profilerOverhead(outOverhead);
+	}
+
+	int32_t luaPluginProfileZoneBegin(LuaPlugin *plugin, ProfileZoneSite *site)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->profileZoneBegin(site);
+	}
+
+	int32_t luaPluginProfileZoneEnd(LuaPlugin *plugin, ProfileZoneSite *site)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->profileZoneEnd(site);
+	}
+
+	int32_t luaPluginProfilerFrameMark(LuaPlugin *plugin)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->profilerFrameMark();
+	}
+
+	int32_t luaPluginProfilerFrameStats(const LuaPlugin *plugin, ProfileFrameStats *outStats)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->profilerFrameStats(outStats);
+	}
+
+	int32_t luaPluginProfilerFrameFunctions(const LuaPlugin *plugin, ProfileFrameFunctionCallback callback, void *userData)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->profilerFrameFunctions(callback, userData);
+	}
+
+	int32_t luaPluginProfilerSlowFrame(const LuaPlugin *plugin, uint16_t index, ProfileSlowFrame *outFrame, ProfileFrameFunctionCallback callback, void *userData)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->profilerSlowFrame(index, outFrame, callback, userData);
+	}
+
+	int32_t luaPluginAddPerfWatch(LuaPlugin *plugin, const char *functionName, const char *source, uint32_t budget, uint32_t flags, uint16_t *outId)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->addPerfWatch(functionName, source, budget, flags, outId);
+	}
+
+	int32_t luaPluginRemovePerfWatch(LuaPlugin *plugin, uint16_t id)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->removePerfWatch(id);
+	}
+
+	int32_t luaPluginPerfIncident(const LuaPlugin *plugin, uint16_t index, PerfIncident *outIncident)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->perfIncident(index, outIncident);
+	}
+
+	int32_t luaPluginPerfIncidentCount(const LuaPlugin *plugin, uint16_t *outNumKept, uint64_t *outNumTotal)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->perfIncidentCount(outNumKept, outNumTotal);
+	}
+
+	int32_t luaPluginAddProfileFilter(LuaPlugin *plugin, ProfileFilterKind::Enum kind, const char *pattern)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->addProfileFilter(kind, pattern);
+	}
+
+	int32_t luaPluginClearProfileFilters(LuaPlugin *plugin)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->clearProfileFilters();
+	}
+
+	int32_t luaPluginSetProfiler(LuaPlugin *plugin, bool enable)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		plugin->setProfiler(enable);
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t luaPluginSetTraceCapture(LuaPlugin *plugin, bool enable)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->setTraceCapture(enable);
+	}
+
+	int32_t luaPluginIsTraceCaptureRunning(const LuaPlugin *plugin, bool *outResult)
+	{
+		if ((plugin == NULL) || (outResult == NULL))
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		(*outResult) = plugin->isTraceCaptureRunning();
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t luaPluginGetTraceTime(const LuaPlugin *plugin, uint64_t *outMicroseconds)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->getTraceTime(outMicroseconds);
+	}
+
+	int32_t luaPluginWriteTrace(LuaPlugin *plugin, TraceWriteCallback writeCallback, void *userData, uint64_t windowStart, uint64_t windowEnd)
+	{
+		if (plugin == NULL)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		return plugin->writeTrace(writeCallback, userData, windowStart, windowEnd);
+	}
+
 	int32_t debuggerAddLuaPlugin(SledDebugger *debugger, LuaPlugin *plugin)
 	{
 		return debuggerAddPlugin(debugger, plugin);
@@ -318,6 +318,43 @@ namespace Sled
 	/// <c>luaPluginSetVarExcludeFlags</c>, <c>luaPluginDebuggerBreak</c>
 	SCE_SLED_LINKAGE int32_t luaPluginGetVarExcludeFlags(const LuaPlugin *plugin, int32_t *outFlags);
 
+	/// Set how variables are transferred to SLED when hitting a breakpoint.
+	/// @brief
+	/// Set variable transfer mode.
+	///
+	/// In lazy mode a breakpoint sends only the callstack and the names and types of locals. SLED then requests
+	/// globals, upvalues, environment tables and table contents in pages of entries as they are expanded.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param mode Variable transfer mode
+	///
+	/// @retval SCE_SLED_ERROR_OK						Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER			Null plugin
+	///
+	/// @see
+	/// <c>luaPluginGetVarTransferMode</c>, <c>luaPluginSetVarExcludeFlags</c>
+	SCE_SLED_LINKAGE int32_t luaPluginSetVarTransferMode(LuaPlugin *plugin, VarTransferMode::Enum mode);
+
+	/// Get the current variable transfer mode.
+	/// @brief
+	/// Get current variable transfer mode.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param outMode Current variable transfer mode
+	///
+	/// @retval SCE_SLED_ERROR_OK						Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER			Null plugin or outMode
+	///
+	/// @see
+	/// <c>luaPluginSetVarTransferMode</c>, <c>luaPluginGetVarExcludeFlags</c>
+	SCE_SLED_LINKAGE int32_t luaPluginGetVarTransferMode(const LuaPlugin *plugin, VarTransferMode::Enum *outMode);
+
 	/// Provide a way to report Lua allocations to the library for tracking using the memory tracer. 
 	/// Call this function from the allocator that is making all the Lua allocations, deallocations, and reallocations.
 	/// @brief
@@ -338,9 +375,712 @@ namespace Sled
 	/// @retval SCE_SLED_ERROR_NULLPARAMETER			Null plugin or <c>outResult</c>
 	///
 	/// @see
-	/// <c>luaPluginIsMemoryTracerRunning</c>, <c>luaPluginResetMemoryTrace</c>
+	/// <c>luaPluginIsMemoryTracerRunning</c>, <c>luaPluginResetMemoryTrace</c>, <c>luaPluginSetAllocationProfile</c>
 	SCE_SLED_LINKAGE int32_t luaPluginMemoryTraceNotify(LuaPlugin *plugin, void *userData, void *oldPtr, void *newPtr, std::size_t oldSize, std::size_t newSize, bool *outResult);
 
+	/// Walk everything reachable from the globals table and the registry of a Lua state and tally object counts and approximate sizes per Lua type,
+	/// the largest tables found and the globals that retain the most memory. Results are returned in <c>outSummary</c> and, if SLED is connected,
+	/// sent to SLED. The walk is bounded by the <c>maxHeapCensus*</c> and <c>heapCensusTimeBudgetMs</c> settings in <c>LuaPluginConfig</c>.
+	/// @brief
+	/// Take census of Lua heap.
+	///
+	/// @par Calling Conditions
+	/// Multithread safe.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param luaState Pointer to a <c>lua_State</c>
+	/// @param outSummary Census totals; may be NULL if only sending results to SLED
+	///
+	/// @retval SCE_SLED_ERROR_OK						Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER			Null plugin
+	/// @retval SCE_SLED_LUA_ERROR_NODEBUGGERINSTANCE	Plugin not added to a <c>SledDebugger</c>
+	/// @retval SCE_SLED_LUA_ERROR_INVALIDLUASTATE		Null <c>lua_State</c>
+	/// @retval SCE_SLED_LUA_ERROR_HEAPCENSUSDISABLED	Heap census disabled because <c>maxHeapCensusObjects</c> is 0
+	SCE_SLED_LINKAGE int32_t luaPluginHeapCensus(LuaPlugin *plugin, lua_State *luaState, HeapCensusSummary *outSummary);
+
+	/// Start or stop counting how many times each line of Lua script runs, for code coverage. Lines are counted by the Lua VM
+	/// itself rather than through a hook, for every registered Lua state, for Lua states registered later, and for threads (coroutines)
+	/// they create while counting is on. Counts belong to the function they are for and go away when it is garbage collected.
+	/// @brief
+	/// Start or stop line coverage counting.
+	///
+	/// @par Calling Conditions
+	/// Multithread safe.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param enable True to start counting; false to stop
+	///
+	/// @retval SCE_SLED_ERROR_OK						Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER			Null plugin
+	///
+	/// @see
+	/// <c>luaPluginIsCoverageRunning</c>, <c>luaPluginResetCoverage</c>, <c>luaPluginWriteCoverage</c>, <c>luaPluginSendCoverage</c>
+	SCE_SLED_LINKAGE int32_t luaPluginSetCoverage(LuaPlugin *plugin, bool enable);
+
+	/// Determine whether line coverage counting is on.
+	/// @brief
+	/// Determine whether line coverage counting is on.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param outResult True if counting; false if not
+	///
+	/// @retval SCE_SLED_ERROR_OK						Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER			Null plugin
+	///
+	/// @see
+	/// <c>luaPluginSetCoverage</c>
+	SCE_SLED_LINKAGE int32_t luaPluginIsCoverageRunning(const LuaPlugin *plugin, bool *outResult);
+
+	/// Set every line coverage count of the registered Lua states back to zero.
+	/// @brief
+	/// Reset line coverage counts.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe. Call only while no registered Lua state is running.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	///
+	/// @retval SCE_SLED_ERROR_OK						Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER			Null plugin
+	///
+	/// @see
+	/// <c>luaPluginSetCoverage</c>
+	SCE_SLED_LINKAGE int32_t luaPluginResetCoverage(LuaPlugin *plugin);
+
+	/// Write a snapshot of the line coverage counts of a Lua state, in a compact binary format, through a callback. The application
+	/// decides where the data goes, for example a file to merge with the results of other runs. Every function with line information
+	/// is written, including those that never ran, along with which of its lines hold code.
+	/// @brief
+	/// Write line coverage counts.
+	///
+	/// @par Calling Conditions
+	/// Multithread safe.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param luaState Pointer to a <c>lua_State</c>
+	/// @param writeCallback Callback receiving the data
+	/// @param userData Optional user-controlled userdata passed to <c>writeCallback</c>
+	///
+	/// @retval SCE_SLED_ERROR_OK						Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER			Null plugin or <c>writeCallback</c>
+	/// @retval SCE_SLED_LUA_ERROR_NODEBUGGERINSTANCE	Plugin not added to a <c>SledDebugger</c>
+	/// @retval SCE_SLED_LUA_ERROR_INVALIDLUASTATE		Null <c>lua_State</c>
+	/// @retval SCE_SLED_LUA_ERROR_COVERAGEWRITEFAILED	<c>writeCallback</c> returned false
+	///
+	/// @see
+	/// <c>CoverageWriteCallback</c>, <c>luaPluginSendCoverage</c>
+	SCE_SLED_LINKAGE int32_t luaPluginWriteCoverage(LuaPlugin *plugin, lua_State *luaState, CoverageWriteCallback writeCallback, void *userData);
+
+	/// Send a snapshot of the line coverage counts of a Lua state to SLED, in the same format <c>luaPluginWriteCoverage</c> writes.
+	/// @brief
+	/// Send line coverage counts to SLED.
+	///
+	/// @par Calling Conditions
+	/// Multithread safe.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param luaState Pointer to a <c>lua_State</c>
+	///
+	/// @retval SCE_SLED_ERROR_OK						Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER			Null plugin
+	/// @retval SCE_SLED_ERROR_TCPNOTCONNECTED			SLED not connected
+	/// @retval SCE_SLED_LUA_ERROR_NODEBUGGERINSTANCE	Plugin not added to a <c>SledDebugger</c>
+	/// @retval SCE_SLED_LUA_ERROR_INVALIDLUASTATE		Null <c>lua_State</c>
+	///
+	/// @see
+	/// <c>luaPluginWriteCoverage</c>
+	SCE_SLED_LINKAGE int32_t luaPluginSendCoverage(LuaPlugin *plugin, lua_State *luaState);
+
+	/// Start or stop counting the instructions the Lua VM runs, per opcode and per function, for every registered Lua state, for Lua states
+	/// registered later, and for threads (coroutines) they create while counting is on. Counting is done by the Lua VM itself rather than
+	/// through a hook. Per-opcode totals are kept for the whole Lua state; per-function counts go away when the function is garbage collected.
+	/// @brief
+	/// Start or stop the opcode profile.
+	///
+	/// @par Calling Conditions
+	/// Multithread safe.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param enable True to start counting; false to stop
+	///
+	/// @retval SCE_SLED_ERROR_OK							Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER				Null plugin
+	/// @retval SCE_SLED_LUA_ERROR_OPCODEPROFILEDISABLED	Opcode profile disabled because <c>maxOpcodeProfileFunctions</c> is 0
+	///
+	/// @see
+	/// <c>luaPluginIsOpcodeProfileRunning</c>, <c>luaPluginResetOpcodeProfile</c>, <c>luaPluginOpcodeProfile</c>
+	SCE_SLED_LINKAGE int32_t luaPluginSetOpcodeProfile(LuaPlugin *plugin, bool enable);
+
+	/// Determine whether the opcode profile is counting.
+	/// @brief
+	/// Determine whether the opcode profile is counting.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param outResult True if counting; false if not
+	///
+	/// @retval SCE_SLED_ERROR_OK						Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER			Null plugin
+	///
+	/// @see
+	/// <c>luaPluginSetOpcodeProfile</c>
+	SCE_SLED_LINKAGE int32_t luaPluginIsOpcodeProfileRunning(const LuaPlugin *plugin, bool *outResult);
+
+	/// Set every opcode profile count of the registered Lua states back to zero.
+	/// @brief
+	/// Reset opcode profile counts.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe. Call only while no registered Lua state is running.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	///
+	/// @retval SCE_SLED_ERROR_OK						Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER			Null plugin
+	///
+	/// @see
+	/// <c>luaPluginSetOpcodeProfile</c>
+	SCE_SLED_LINKAGE int32_t luaPluginResetOpcodeProfile(LuaPlugin *plugin);
+
+	/// Gather the opcode profile of a Lua state: the instructions run per opcode and the functions that ran the most of them, up to
+	/// <c>maxOpcodeProfileFunctions</c> in <c>LuaPluginConfig</c>. Totals are returned in <c>outSummary</c> and, if SLED is connected,
+	/// the full results are sent to SLED.
+	/// @brief
+	/// Gather opcode profile.
+	///
+	/// @par Calling Conditions
+	/// Multithread safe.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param luaState Pointer to a <c>lua_State</c>
+	/// @param outSummary Per-opcode totals; may be NULL if only sending results to SLED
+	///
+	/// @retval SCE_SLED_ERROR_OK							Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER				Null plugin
+	/// @retval SCE_SLED_LUA_ERROR_NODEBUGGERINSTANCE		Plugin not added to a <c>SledDebugger</c>
+	/// @retval SCE_SLED_LUA_ERROR_INVALIDLUASTATE			Null <c>lua_State</c>
+	/// @retval SCE_SLED_LUA_ERROR_OPCODEPROFILEDISABLED	Opcode profile disabled because <c>maxOpcodeProfileFunctions</c> is 0
+	///
+	/// @see
+	/// <c>luaPluginSetOpcodeProfile</c>
+	SCE_SLED_LINKAGE int32_t luaPluginOpcodeProfile(LuaPlugin *plugin, lua_State *luaState, OpcodeProfileSummary *outSummary);
+
+	/// Write the profiler's call paths through a callback as folded-stack text, for flame graph tools to render without SLED.
+	/// The profiler keeps the time and call count of every unique call path it sees while running, up to <c>maxProfileCallPaths</c>
+	/// in <c>LuaPluginConfig</c>; calls under a path that didn't fit are left out. To write to a file, pass a callback that
+	/// writes each piece of text to it.
+	/// @brief
+	/// Write profiler call paths as folded stacks.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe. Call only while no registered Lua state is running.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param writeCallback Callback receiving the text
+	/// @param userData Optional user-controlled userdata passed to <c>writeCallback</c>
+	/// @param weight What the number ending each line counts
+	///
+	/// @retval SCE_SLED_ERROR_OK							Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER				Null plugin or <c>writeCallback</c>
+	/// @retval SCE_SLED_LUA_ERROR_CALLPATHSDISABLED		Call paths disabled because <c>maxProfileCallPaths</c> is 0
+	/// @retval SCE_SLED_LUA_ERROR_PROFILEFOLDEDWRITEFAILED	<c>writeCallback</c> returned false
+	///
+	/// @see
+	/// <c>ProfileFoldedWriteCallback</c>, <c>ProfileFoldedWeight</c>
+	SCE_SLED_LINKAGE int32_t luaPluginWriteProfileFolded(LuaPlugin *plugin, ProfileFoldedWriteCallback writeCallback, void *userData, ProfileFoldedWeight::Enum weight);
+
+	/// Write the whole profile through a callback as a compact binary capture: a header with the build id, the time
+	/// profiled, frames marked and the profiler's overhead, then every profiled function with its times, the calls between
+	/// functions, the call paths and latency histograms the configuration keeps, and memory charged while allocations were
+	/// profiled. Captures of two builds written to files
+	/// can be compared offline with the profile diff tool, which lists the functions that got slower.
+	/// @brief
+	/// Write a binary profile capture.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe. Call only while no registered Lua state is running.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param writeCallback Callback receiving the capture data
+	/// @param userData Optional user-controlled userdata passed to <c>writeCallback</c>
+	/// @param buildId Optional text naming the build profiled, such as a version control revision; may be NULL
+	///
+	/// @retval SCE_SLED_ERROR_OK								Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER					Null plugin or <c>writeCallback</c>
+	/// @retval SCE_SLED_LUA_ERROR_PROFILECAPTUREWRITEFAILED	<c>writeCallback</c> returned false
+	///
+	/// @see
+	/// <c>ProfileCaptureWriteCallback</c>, <c>luaPluginWriteProfileFolded</c>
+	SCE_SLED_LINKAGE int32_t luaPluginWriteProfileCapture(LuaPlugin *plugin, ProfileCaptureWriteCallback writeCallback, void *userData, const char *buildId);
+
+	/// Get call time percentiles of a profiled function from its latency histograms. Only the first <c>maxProfileHistograms</c>
+	/// (from <c>LuaPluginConfig</c>) functions the profiler sees keep histograms. The same histograms are sent to SLED with the
+	/// rest of the profile information.
+	/// @brief
+	/// Get profiled function call time percentiles.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe. Call only while no registered Lua state is running.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param source Script the function is in, as SLED shows it
+	/// @param lineDefined Line the function is defined on
+	/// @param outSummary Call time percentiles
+	///
+	/// @retval SCE_SLED_ERROR_OK							Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER				Null plugin, <c>source</c> or <c>outSummary</c>
+	/// @retval SCE_SLED_LUA_ERROR_LATENCYDISABLED			Latency histograms disabled because <c>maxProfileHistograms</c> is 0
+	/// @retval SCE_SLED_LUA_ERROR_PROFILEFUNCTIONNOTFOUND	Function not profiled or has no latency histogram
+	///
+	/// @see
+	/// <c>ProfileLatencySummary</c>, <c>luaPluginResetProfileInfo</c>
+	SCE_SLED_LINKAGE int32_t luaPluginProfileLatency(const LuaPlugin *plugin, const char *source, int32_t lineDefined, ProfileLatencySummary *outSummary);
+
+	/// Get the total time of a profiled function both as measured and less the profiler's own overhead. The overhead is
+	/// estimated when the profiler starts if <c>profileCalibrationCalls</c> (from <c>LuaPluginConfig</c>) isn't 0;
+	/// otherwise the corrected times are the measured ones. Times sent to SLED are the measured ones.
+	/// @brief
+	/// Get profiled function times.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe. Call only while no registered Lua state is running.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param source Script the function is in, as SLED shows it
+	/// @param lineDefined Line the function is defined on
+	/// @param outTimes Function times
+	///
+	/// @retval SCE_SLED_ERROR_OK							Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER				Null plugin, <c>source</c> or <c>outTimes</c>
+	/// @retval SCE_SLED_LUA_ERROR_PROFILEFUNCTIONNOTFOUND	Function not profiled
+	///
+	/// @see
+	/// <c>ProfileFunctionTimes</c>, <c>luaPluginProfilerOverhead</c>
+	SCE_SLED_LINKAGE int32_t luaPluginProfileFunctionTimes(const LuaPlugin *plugin, const char *source, int32_t lineDefined, ProfileFunctionTimes *outTimes);
+
+	/// Start or stop charging the allocations reported through <c>luaPluginMemoryTraceNotify</c> to the profiler. While
+	/// on, and while the profiler runs, each allocation and free is charged to the innermost profiled function running,
+	/// whether or not the memory tracer is running. The totals go to SLED with the rest of the profile information and
+	/// are kept until the profile is reset.
+	/// @brief
+	/// Start or stop allocation profiling.
+	///
+	/// @par Calling Conditions
+	/// Multithread safe.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param enable True to start charging allocations; false to stop
+	///
+	/// @retval SCE_SLED_ERROR_OK						Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER			Null plugin
+	///
+	/// @see
+	/// <c>luaPluginIsAllocationProfileRunning</c>, <c>luaPluginProfileAllocations</c>, <c>luaPluginMemoryTraceNotify</c>
+	SCE_SLED_LINKAGE int32_t luaPluginSetAllocationProfile(LuaPlugin *plugin, bool enable);
+
+	/// Determine whether allocations are being charged to the profiler.
+	/// @brief
+	/// Determine whether allocation profiling is on.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param outResult True if charging allocations; false if not
+	///
+	/// @retval SCE_SLED_ERROR_OK						Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER			Null plugin or <c>outResult</c>
+	///
+	/// @see
+	/// <c>luaPluginSetAllocationProfile</c>
+	SCE_SLED_LINKAGE int32_t luaPluginIsAllocationProfileRunning(const LuaPlugin *plugin, bool *outResult);
+
+	/// Get the memory allocated and freed while a profiled function was the innermost one running.
+	/// @brief
+	/// Get profiled function allocations.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe. Call only while no registered Lua state is running.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param source Script the function is in, as SLED shows it
+	/// @param lineDefined Line the function is defined on
+	/// @param outAllocations Function allocations
+	///
+	/// @retval SCE_SLED_ERROR_OK							Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER				Null plugin, <c>source</c> or <c>outAllocations</c>
+	/// @retval SCE_SLED_LUA_ERROR_PROFILEFUNCTIONNOTFOUND	Function not profiled
+	///
+	/// @see
+	/// <c>ProfileFunctionAllocations</c>, <c>luaPluginSetAllocationProfile</c>
+	SCE_SLED_LINKAGE int32_t luaPluginProfileAllocations(const LuaPlugin *plugin, const char *source, int32_t lineDefined, ProfileFunctionAllocations *outAllocations);
+
+	/// Get the profiler's own overhead as estimated when it last started, by timing empty calls through the profiler.
+	/// The time Lua takes to run the hook and to look up a function's name and script isn't part of the estimate.
+	/// @brief
+	/// Get profiler overhead.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe. Call only while no registered Lua state is running.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param outOverhead Overhead
+	///
+	/// @retval SCE_SLED_ERROR_OK							Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER				Null plugin or <c>outOverhead</c>
+	///
+	/// @see
+	/// <c>ProfileOverhead</c>, <c>luaPluginProfileFunctionTimes</c>
+	SCE_SLED_LINKAGE int32_t luaPluginProfilerOverhead(const LuaPlugin *plugin, ProfileOverhead *outOverhead);
+
+	/// Begin a native profile zone. The zone is profiled as a function called by whatever function the profiler saw run
+	/// last, usually the C function Lua called, so native and script times are in the same profile. Zones must end in the
+	/// reverse order they began. <c>SCE_SLED_PROFILE_ZONE</c> declares the site and ends the zone at the end of the scope.
+	/// @brief
+	/// Begin profile zone.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe. Call only on the thread running the registered Lua states.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param site Call site of the zone, which must stay valid while the profile is kept
+	///
+	/// @retval SCE_SLED_ERROR_OK							Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER				Null plugin, <c>site</c> or <c>site</c> name or file
+	/// @retval SCE_SLED_LUA_ERROR_PROFILEZONENOTENTERED	Profiler not running, or no room in the profile for the zone
+	///
+	/// @see
+	/// <c>ProfileZoneSite</c>, <c>luaPluginProfileZoneEnd</c>, <c>SCE_SLED_PROFILE_ZONE</c>
+	SCE_SLED_LINKAGE int32_t luaPluginProfileZoneBegin(LuaPlugin *plugin, ProfileZoneSite *site);
+
+	/// End a native profile zone that <c>luaPluginProfileZoneBegin</c> began.
+	/// @brief
+	/// End profile zone.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe. Call only on the thread running the registered Lua states.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param site Call site of the zone
+	///
+	/// @retval SCE_SLED_ERROR_OK							Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER				Null plugin, <c>site</c> or <c>site</c> name or file
+	/// @retval SCE_SLED_LUA_ERROR_PROFILEZONENOTENTERED	Profiler stopped or profile reset since the zone began
+	///
+	/// @see
+	/// <c>luaPluginProfileZoneBegin</c>
+	SCE_SLED_LINKAGE int32_t luaPluginProfileZoneEnd(LuaPlugin *plugin, ProfileZoneSite *site);
+
+	/// Mark the end of one frame and the start of the next. The calls that returned since the last mark are rolled into the
+	/// per function totals of the last <c>maxProfileFrames</c> (from <c>LuaPluginConfig</c>) frames, without resetting the
+	/// rest of the profile. A frame longer than <c>profileFrameBudgetUs</c> is counted as over budget and, if
+	/// <c>maxProfileSlowFrames</c> isn't 0, kept with its own per function breakdown. Frames are only counted while the
+	/// profiler runs; the first mark after it starts only starts a frame.
+	/// @brief
+	/// Mark profiler frame.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe. Call once per frame while no registered Lua state is running.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	///
+	/// @retval SCE_SLED_ERROR_OK						Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER			Null plugin
+	/// @retval SCE_SLED_LUA_ERROR_FRAMESDISABLED		Frame profiling disabled because <c>maxProfileFrames</c> is 0
+	///
+	/// @see
+	/// <c>luaPluginProfilerFrameStats</c>, <c>luaPluginProfilerFrameFunctions</c>, <c>luaPluginProfilerSlowFrame</c>
+	SCE_SLED_LINKAGE int32_t luaPluginProfilerFrameMark(LuaPlugin *plugin);
+
+	/// Get frame times over the window of recent frames and the number of frames over budget.
+	/// @brief
+	/// Get profiler frame statistics.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param outStats Frame statistics
+	///
+	/// @retval SCE_SLED_ERROR_OK						Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER			Null plugin or <c>outStats</c>
+	/// @retval SCE_SLED_LUA_ERROR_FRAMESDISABLED		Frame profiling disabled because <c>maxProfileFrames</c> is 0
+	///
+	/// @see
+	/// <c>ProfileFrameStats</c>, <c>luaPluginProfilerFrameMark</c>
+	SCE_SLED_LINKAGE int32_t luaPluginProfilerFrameStats(const LuaPlugin *plugin, ProfileFrameStats *outStats);
+
+	/// Get the per function totals over the window of recent frames, through a callback called once per function that
+	/// returned in the window. Divide by <c>windowFrames</c> of <c>ProfileFrameStats</c> for per frame averages.
+	/// @brief
+	/// Get profiler per function frame window totals.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe. Call only while no registered Lua state is running.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param callback Callback receiving each function
+	/// @param userData Optional user-controlled userdata passed to <c>callback</c>
+	///
+	/// @retval SCE_SLED_ERROR_OK						Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER			Null plugin or <c>callback</c>
+	/// @retval SCE_SLED_LUA_ERROR_FRAMESDISABLED		Frame profiling disabled because <c>maxProfileFrames</c> is 0
+	///
+	/// @see
+	/// <c>ProfileFrameFunctionCallback</c>, <c>luaPluginProfilerFrameStats</c>
+	SCE_SLED_LINKAGE int32_t luaPluginProfilerFrameFunctions(const LuaPlugin *plugin, ProfileFrameFunctionCallback callback, void *userData);
+
+	/// Get one of the frames kept for going over the frame budget, and its per function breakdown through a callback
+	/// called once per function that returned in the frame.
+	/// @brief
+	/// Get profiler slow frame.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe. Call only while no registered Lua state is running.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param index Which frame; 0 for the most recent, up to <c>numSlowFrames</c> of <c>ProfileFrameStats</c> less 1
+	/// @param outFrame Frame
+	/// @param callback Optional callback receiving each function of the breakdown
+	/// @param userData Optional user-controlled userdata passed to <c>callback</c>
+	///
+	/// @retval SCE_SLED_ERROR_OK						Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER			Null plugin or <c>outFrame</c>
+	/// @retval SCE_SLED_ERROR_INVALIDPARAMETER			No slow frame kept at <c>index</c>
+	/// @retval SCE_SLED_LUA_ERROR_FRAMESDISABLED		Frame profiling disabled because <c>maxProfileFrames</c> is 0
+	///
+	/// @see
+	/// <c>ProfileSlowFrame</c>, <c>ProfileFrameFunctionCallback</c>
+	SCE_SLED_LINKAGE int32_t luaPluginProfilerSlowFrame(const LuaPlugin *plugin, uint16_t index, ProfileSlowFrame *outFrame, ProfileFrameFunctionCallback callback, void *userData);
+
+	/// Watch a profiled function for calls that take longer than a time budget. While the profiler runs, each such call is
+	/// kept as a <c>PerfIncident</c> with the functions that were running at the time, and, depending on <c>flags</c>,
+	/// the debugger is broken into or told through TTY. Functions are matched by the name the profiler gives them.
+	/// @brief
+	/// Add performance watch.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe. Call only while no registered Lua state is running.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param functionName Name of the function, as the profiler shows it
+	/// @param source Script the function is in, as the profiler shows it; NULL matches the function in any script
+	/// @param budget Time budget of a call in microseconds
+	/// @param flags Combination of <c>PerfWatchFlags</c>
+	/// @param outId Id of the watch
+	///
+	/// @retval SCE_SLED_ERROR_OK							Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER				Null plugin, <c>functionName</c> or <c>outId</c>
+	/// @retval SCE_SLED_LUA_ERROR_PERFWATCHESDISABLED		Performance watches disabled because <c>maxPerfWatches</c> is 0
+	/// @retval SCE_SLED_LUA_ERROR_PERFWATCHESFULL			Already watching <c>maxPerfWatches</c> functions
+	///
+	/// @see
+	/// <c>luaPluginRemovePerfWatch</c>, <c>luaPluginPerfIncident</c>
+	SCE_SLED_LINKAGE int32_t luaPluginAddPerfWatch(LuaPlugin *plugin, const char *functionName, const char *source, uint32_t budget, uint32_t flags, uint16_t *outId);
+
+	/// Stop watching a function. Incidents already kept stay until the profile is reset.
+	/// @brief
+	/// Remove performance watch.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe. Call only while no registered Lua state is running.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param id Id of the watch, as returned by <c>luaPluginAddPerfWatch</c>
+	///
+	/// @retval SCE_SLED_ERROR_OK							Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER				Null plugin
+	/// @retval SCE_SLED_ERROR_INVALIDPARAMETER				No watch with that id
+	/// @retval SCE_SLED_LUA_ERROR_PERFWATCHESDISABLED		Performance watches disabled because <c>maxPerfWatches</c> is 0
+	///
+	/// @see
+	/// <c>luaPluginAddPerfWatch</c>
+	SCE_SLED_LINKAGE int32_t luaPluginRemovePerfWatch(LuaPlugin *plugin, uint16_t id);
+
+	/// Get one of the most recent performance watch incidents.
+	/// @brief
+	/// Get performance watch incident.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe. Call only while no registered Lua state is running.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param index Which incident; 0 for the most recent, up to the number kept less 1
+	/// @param outIncident Incident
+	///
+	/// @retval SCE_SLED_ERROR_OK							Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER				Null plugin or <c>outIncident</c>
+	/// @retval SCE_SLED_ERROR_INVALIDPARAMETER				No incident kept at <c>index</c>
+	/// @retval SCE_SLED_LUA_ERROR_PERFWATCHESDISABLED		Performance watches disabled because <c>maxPerfWatches</c> is 0
+	///
+	/// @see
+	/// <c>PerfIncident</c>, <c>luaPluginPerfIncidentCount</c>
+	SCE_SLED_LINKAGE int32_t luaPluginPerfIncident(const LuaPlugin *plugin, uint16_t index, PerfIncident *outIncident);
+
+	/// Get how many performance watch incidents are kept, and how many there were since the profile was last reset.
+	/// @brief
+	/// Get performance watch incident counts.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe. Call only while no registered Lua state is running.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param outNumKept Number of incidents kept, at most <c>maxPerfIncidents</c>
+	/// @param outNumTotal Number of incidents since the profile was last reset
+	///
+	/// @retval SCE_SLED_ERROR_OK							Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER				Null plugin, <c>outNumKept</c> or <c>outNumTotal</c>
+	/// @retval SCE_SLED_LUA_ERROR_PERFWATCHESDISABLED		Performance watches disabled because <c>maxPerfWatches</c> is 0
+	///
+	/// @see
+	/// <c>luaPluginPerfIncident</c>
+	SCE_SLED_LINKAGE int32_t luaPluginPerfIncidentCount(const LuaPlugin *plugin, uint16_t *outNumKept, uint64_t *outNumTotal);
+
+	/// Add an include or exclude pattern limiting which functions the profiler hooks, so it can be pointed at one
+	/// subsystem without slowing down the rest. In a pattern '*' matches any run of characters, path separators included,
+	/// and '?' matches any one character. Script patterns are checked once per function by the Lua VM, which then skips
+	/// the hook for calls and returns of functions they keep out; function name patterns are checked in the hook.
+	/// Changing the filters resets the profile.
+	/// @brief
+	/// Add profile filter.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe. Call only while no registered Lua state is running.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param kind What the pattern is matched against and whether it includes or excludes
+	/// @param pattern Pattern, at most <c>maxProfileFilterPatternLen</c> characters
+	///
+	/// @retval SCE_SLED_ERROR_OK							Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER				Null plugin or <c>pattern</c>
+	/// @retval SCE_SLED_ERROR_INVALIDPARAMETER				Unknown <c>kind</c>, or empty or too long <c>pattern</c>
+	/// @retval SCE_SLED_LUA_ERROR_PROFILEFILTERSDISABLED	Profile filters disabled because <c>maxProfileFilters</c> is 0
+	/// @retval SCE_SLED_LUA_ERROR_PROFILEFILTERSFULL		Already holding <c>maxProfileFilters</c> patterns
+	///
+	/// @see
+	/// <c>luaPluginClearProfileFilters</c>, <c>ProfileFilterKind</c>
+	SCE_SLED_LINKAGE int32_t luaPluginAddProfileFilter(LuaPlugin *plugin, ProfileFilterKind::Enum kind, const char *pattern);
+
+	/// Remove every profile filter pattern so the profiler hooks all functions again. Resets the profile.
+	/// @brief
+	/// Clear profile filters.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe. Call only while no registered Lua state is running.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	///
+	/// @retval SCE_SLED_ERROR_OK							Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER				Null plugin
+	/// @retval SCE_SLED_LUA_ERROR_PROFILEFILTERSDISABLED	Profile filters disabled because <c>maxProfileFilters</c> is 0
+	///
+	/// @see
+	/// <c>luaPluginAddProfileFilter</c>
+	SCE_SLED_LINKAGE int32_t luaPluginClearProfileFilters(LuaPlugin *plugin);
+
+	/// Start or stop the profiler without SLED, the same as toggling it from SLED's profiler window.
+	/// Starting or stopping it clears what the profiler has collected.
+	/// @brief
+	/// Start or stop profiler.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe. Call only while no registered Lua state is running.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param enable True to start the profiler; false to stop it
+	///
+	/// @retval SCE_SLED_ERROR_OK						Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER			Null plugin
+	///
+	/// @see
+	/// <c>luaPluginIsProfilerRunning</c>, <c>luaPluginSetTraceCapture</c>
+	SCE_SLED_LINKAGE int32_t luaPluginSetProfiler(LuaPlugin *plugin, bool enable);
+
+	/// Start or stop recording a timeline of the calls the profiler sees. Each registered Lua state keeps its last
+	/// <c>maxTraceEvents</c> (from <c>LuaPluginConfig</c>) call entries and exits, with coroutines recorded into the
+	/// timeline of the state that owns them. Nothing is recorded unless the profiler is running too.
+	/// @brief
+	/// Start or stop timeline capture.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param enable True to start recording; false to stop
+	///
+	/// @retval SCE_SLED_ERROR_OK						Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER			Null plugin
+	/// @retval SCE_SLED_LUA_ERROR_TRACEDISABLED		Timeline capture disabled because <c>maxTraceEvents</c> is 0
+	///
+	/// @see
+	/// <c>luaPluginSetProfiler</c>, <c>luaPluginWriteTrace</c>
+	SCE_SLED_LINKAGE int32_t luaPluginSetTraceCapture(LuaPlugin *plugin, bool enable);
+
+	/// Determine whether or not the timeline capture is recording.
+	/// @brief
+	/// Check whether timeline capture is recording.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param outResult True if the timeline capture is recording; false if it is not
+	///
+	/// @retval SCE_SLED_ERROR_OK						Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER			Null plugin or <c>outResult</c>
+	///
+	/// @see
+	/// <c>luaPluginSetTraceCapture</c>
+	SCE_SLED_LINKAGE int32_t luaPluginIsTraceCaptureRunning(const LuaPlugin *plugin, bool *outResult);
+
+	/// Get the timeline clock's current time, to mark the start or end of a window for <c>luaPluginWriteTrace</c>.
+	/// Time spent stopped at breakpoints isn't counted.
+	/// @brief
+	/// Get timeline clock time.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param outMicroseconds Current time in microseconds
+	///
+	/// @retval SCE_SLED_ERROR_OK						Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER			Null plugin or <c>outMicroseconds</c>
+	/// @retval SCE_SLED_LUA_ERROR_TRACEDISABLED		Timeline capture disabled because <c>maxTraceEvents</c> is 0
+	///
+	/// @see
+	/// <c>luaPluginWriteTrace</c>
+	SCE_SLED_LINKAGE int32_t luaPluginGetTraceTime(const LuaPlugin *plugin, uint64_t *outMicroseconds);
+
+	/// Write the recorded timeline through a callback as Chrome trace-event JSON, which chrome://tracing and Perfetto
+	/// open directly. Each registered Lua state is written as its own thread. Calls still open at the end of the
+	/// window are closed there. To write to a file, pass a callback that writes each piece of text to it.
+	/// @brief
+	/// Write timeline as Chrome trace-event JSON.
+	///
+	/// @par Calling Conditions
+	/// Not multithread safe. Call only while no registered Lua state is running.
+	///
+	/// @param plugin <c>LuaPlugin</c> to use
+	/// @param writeCallback Callback receiving the text
+	/// @param userData Optional user-controlled userdata passed to <c>writeCallback</c>
+	/// @param windowStart Earliest event time to write, in microseconds (0 for the oldest recorded)
+	/// @param windowEnd Latest event time to write, in microseconds (0 for the newest recorded)
+	///
+	/// @retval SCE_SLED_ERROR_OK						Success
+	/// @retval SCE_SLED_ERROR_NULLPARAMETER			Null plugin or <c>writeCallback</c>
+	/// @retval SCE_SLED_LUA_ERROR_TRACEDISABLED		Timeline capture disabled because <c>maxTraceEvents</c> is 0
+	/// @retval SCE_SLED_LUA_ERROR_TRACEWRITEFAILED		<c>writeCallback</c> returned false
+	///
+	/// @see
+	/// <c>TraceWriteCallback</c>, <c>luaPluginGetTraceTime</c>
+	SCE_SLED_LINKAGE int32_t luaPluginWriteTrace(LuaPlugin *plugin, TraceWriteCallback writeCallback, void *userData, uint64_t windowStart, uint64_t windowEnd);
+
 	/// Add a <c>LuaPlugin</c> to the <c>SledDebugger</c>. It's a helper method, because <c>LuaPlugin</c> is an incomplete type and
 	/// the <c>SledDebugger</c> <c>debuggerAddPlugin()</c> method is expecting a <c>SledDebuggerPlugin</c> instance.
 	/// @brief
@@ -358,6 +1098,47 @@ namespace Sled
 	/// @see
 	/// <c>luaPluginCreate</c>
 	SCE_SLED_LINKAGE int32_t debuggerAddLuaPlugin(SledDebugger *debugger, LuaPlugin *plugin);
+
+	/// Profile zone covering the rest of a scope; use through <c>SCE_SLED_PROFILE_ZONE</c>.
+	/// @brief
+	/// Scoped profile zone.
+	///
+	/// @see
+	/// <c>luaPluginProfileZoneBegin</c>, <c>luaPluginProfileZoneEnd</c>
+	class ProfileZone
+	{
+	public:
+		ProfileZone(LuaPlugin *plugin, ProfileZoneSite *site)
+			: m_plugin(plugin)
+			, m_site(site)
+			, m_bEntered(luaPluginProfileZoneBegin(plugin, site) == 0)
+		{}
+
+		~ProfileZone()
+		{
+			if (m_bEntered)
+				luaPluginProfileZoneEnd(m_plugin, m_site);
+		}
+	private:
+		ProfileZone(const ProfileZone&);
+		ProfileZone& operator=(const ProfileZone&);
+	private:
+		LuaPlugin		*m_plugin;
+		ProfileZoneSite	*m_site;
+		const bool		m_bEntered;
+	};
 }}
 
+/// Profile the rest of the enclosing scope as a function named <c>name</c>, a string literal, called by the Lua code
+/// running at the time. The site is a static initialized at compile time, so only the first zone after each profile
+/// reset looks the name up. Does nothing while the profiler isn't running, or if <c>plugin</c> is NULL.
+/// @brief
+/// Profile zone.
+///
+/// @param plugin <c>LuaPlugin</c> to use
+/// @param name Name of the zone, as the profiler shows it
+#define SCE_SLED_PROFILE_ZONE(plugin, name) \
+	static sce::Sled::ProfileZoneSite SCE_SLEDSTRING_CONCATENATE(sledProfileZoneSite_, __LINE__) = { name, __FILE__, __LINE__, 0, 0, 0 }; \
+	const sce::Sled::ProfileZone SCE_SLEDSTRING_CONCATENATE(sledProfileZone_, __LINE__)((plugin), &SCE_SLEDSTRING_CONCATENATE(sledProfileZoneSite_, __LINE__))
+
 #endif // __SCE_LIBSLEDLUAPLUGIN_H__
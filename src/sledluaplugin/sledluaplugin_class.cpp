@@ -17,7 +17,21 @@
 #include "luautils.h"
 #include "scmp.h"
 #include "profilestack.h"
+#include "heapcensus.h"
+#include "gcstats.h"
+#include "varsnapshot.h"
+#include "varbudget.h"
+#include "sendpipeline.h"
 #include "varfilter.h"
+#include "numberformat.h"
+#include "coveragewriter.h"
+#include "opcodeprofile.h"
+#include "foldedstackwriter.h"
+#include "tracetimeline.h"
+#include "profileframes.h"
+#include "perfwatch.h"
+#include "profilefilter.h"
+#include "profilecapturewriter.h"
 
 #include "../sledcore/mutex.h"
 
@@ -47,6 +61,16 @@ namespace sce { namespace Sled
 			void *m_this;
 			void *m_sendBuf;
 			void *m_profileStack;
+			void *m_heapCensus;
+			void *m_opcodeProfile;
+			void *m_traceTimeline;
+			void *m_profileFrames;
+			void *m_perfWatch;
+			void *m_profileFilter;
+			void *m_gcStats;
+			void *m_varSnapshot;
+			void *m_varBudget;
+			void *m_sendPipeline;
 			void *m_luaStateParams;
 			void *m_luaStatesNames;
 			void *m_memTraceParams;
@@ -74,6 +98,63 @@ namespace sce { namespace Sled
 					ProfileStack::requiredMemoryHelper(config, pAllocator, &m_profileStack);
 				}
 
+				// For m_pHeapCensus
+				{
+					HeapCensusConfig config(&luaConfig);
+					HeapCensus::requiredMemoryHelper(config, pAllocator, &m_heapCensus);
+				}
+
+				// For m_pOpcodeProfile
+				{
+					OpcodeProfileConfig config(&luaConfig);
+					OpcodeProfile::requiredMemoryHelper(config, pAllocator, &m_opcodeProfile);
+				}
+
+				// For m_pTraceTimeline
+				{
+					TraceTimelineConfig config(&luaConfig);
+					TraceTimeline::requiredMemoryHelper(config, pAllocator, &m_traceTimeline);
+				}
+
+				// For m_pProfileFrames
+				{
+					ProfileFramesConfig config(&luaConfig);
+					ProfileFrames::requiredMemoryHelper(config, pAllocator, &m_profileFrames);
+				}
+
+				// For m_pPerfWatch
+				{
+					PerfWatchConfig config(&luaConfig);
+					PerfWatch::requiredMemoryHelper(config, pAllocator, &m_perfWatch);
+				}
+
+				// For m_pProfileFilter
+				{
+					ProfileFilterConfig config(&luaConfig);
+					ProfileFilter::requiredMemoryHelper(config, pAllocator, &m_profileFilter);
+				}
+
+				// For m_pGcStats
+				GcStats::requiredMemoryHelper(pAllocator, &m_gcStats);
+
+				// For m_pVarSnapshot
+				{
+					VarSnapshotConfig config(&luaConfig);
+					VarSnapshot::requiredMemoryHelper(config, pAllocator, &m_varSnapshot);
+				}
+
+				// For m_pVarBudget
+				{
+					VarBudgetConfig config(&luaConfig);
+					VarBudget::requiredMemoryHelper(config, pAllocator, &m_varBudget);
+				}
+
+				// For m_pSendPipeline
+				{
+					SendPipelineConfig config(&luaConfig);
+					SendPipeline::requiredMemoryHelper(config, pAllocator, &m_sendPipeline);
+				}
+
 				// For m_pLuaStates
 				m_luaStateParams = pAllocator->allocate(sizeof(LuaStateParams) * luaConfig.maxLuaStates, __alignof(LuaStateParams));
 				m_luaStatesNames = pAllocator->allocate(sizeof(char) * luaConfig.maxLuaStates * luaConfig.maxLuaStateNameLen, __alignof(char));
@@ -134,6 +215,16 @@ namespace sce { namespace Sled
 			SCE_SLED_ASSERT(seats.m_this != NULL);
 			SCE_SLED_ASSERT(seats.m_sendBuf != NULL);
 			SCE_SLED_ASSERT(seats.m_profileStack != NULL);
+			SCE_SLED_ASSERT(seats.m_heapCensus != NULL);
+			SCE_SLED_ASSERT(seats.m_opcodeProfile != NULL);
+			SCE_SLED_ASSERT(seats.m_traceTimeline != NULL);
+			SCE_SLED_ASSERT(seats.m_profileFrames != NULL);
+			SCE_SLED_ASSERT(seats.m_perfWatch != NULL);
+			SCE_SLED_ASSERT(seats.m_profileFilter != NULL);
+			SCE_SLED_ASSERT(seats.m_gcStats != NULL);
+			SCE_SLED_ASSERT(seats.m_varSnapshot != NULL);
+			SCE_SLED_ASSERT(seats.m_varBudget != NULL);
+			SCE_SLED_ASSERT(seats.m_sendPipeline != NULL);
 			SCE_SLED_ASSERT(seats.m_luaStateParams != NULL);
 			SCE_SLED_ASSERT(seats.m_luaStatesNames != NULL);
 			SCE_SLED_ASSERT(seats.m_memTraceParams != NULL);
@@ -182,6 +273,14 @@ namespace sce { namespace Sled
 		, m_pEditAndContinueUserData(luaConfig.pEditAndContinueUserData)
 		, m_bLookUpWatches(false)
 		, m_iVarExcludeFlags(VarExcludeFlags::kNone)
+		, m_iVarTransferMode(VarTransferMode::kEager)
+		, m_iVarEncoding(SCMP::VarValueEncoding::kString)
+		, m_iVarPageOffset(0)
+		, m_iVarPageLimit(0)
+		, m_iVarPagePosition(0)
+		, m_iNextTableId(1)
+		, m_iVarLookUpTableId(0)
+		, m_iVarLookUpTableVersion(0)
 		, m_pCurHookLuaState(0)
 		, m_pCurHookLuaDebug(0)
 		, m_bHitBreakpoint(false)
@@ -189,6 +288,8 @@ namespace sce { namespace Sled
 		, m_iLastNumStackLevels(0)
 		, m_bAssertBreakpoint(false)
 		, m_bErrorBreakpoint(false)
+		, m_bVarSnapshotActive(false)
+		, m_bVarBudgetActive(false)
 		, m_iMaxLuaStates(luaConfig.maxLuaStates)
 		, m_iNumLuaStates(0)
 		, m_iMaxLuaStateNameLen(luaConfig.maxLuaStateNameLen)
@@ -196,6 +297,10 @@ namespace sce { namespace Sled
 		, m_iNumMemTraces(0)
 		, m_bProfilerRunning(false)
 		, m_bMemoryTracerRunning(false)
+		, m_bCoverageRunning(false)
+		, m_bOpcodeProfileRunning(false)
+		, m_bTraceRunning(false)
+		, m_bAllocationProfileRunning(false)
 		, m_iMaxBreakpoints(luaConfig.maxBreakpoints)	
 		, m_iNumBreakpoints(0)
 		, m_iWorkBufMaxSize(luaConfig.maxWorkBufferSize)
@@ -215,6 +320,53 @@ namespace sce { namespace Sled
 			ProfileStack::create(config, pSeats->m_profileStack, &m_pProfileStack);
 		}
 
+		{
+			HeapCensusConfig config(&luaConfig);
+			HeapCensus::create(config, pSeats->m_heapCensus, &m_pHeapCensus);
+		}
+
+		{
+			OpcodeProfileConfig config(&luaConfig);
+			OpcodeProfile::create(config, pSeats->m_opcodeProfile, &m_pOpcodeProfile);
+		}
+
+		{
+			TraceTimelineConfig config(&luaConfig);
+			TraceTimeline::create(config, pSeats->m_traceTimeline, &m_pTraceTimeline);
+		}
+
+		{
+			ProfileFramesConfig config(&luaConfig);
+			ProfileFrames::create(config, pSeats->m_profileFrames, &m_pProfileFrames);
+		}
+
+		{
+			PerfWatchConfig config(&luaConfig);
+			PerfWatch::create(config, pSeats->m_perfWatch, &m_pPerfWatch);
+		}
+
+		{
+			ProfileFilterConfig config(&luaConfig);
+			ProfileFilter::create(config, pSeats->m_profileFilter, &m_pProfileFilter);
+		}
+
+		GcStats::create(pSeats->m_gcStats, &m_pGcStats);
+
+		{
+			VarSnapshotConfig config(&luaConfig);
+			VarSnapshot::create(config, pSeats->m_varSnapshot, &m_pVarSnapshot);
+		}
+
+		{
+			VarBudgetConfig config(&luaConfig);
+			VarBudget::create(config, pSeats->m_varBudget, &m_pVarBudget);
+		}
+
+		{
+			SendPipelineConfig config(&luaConfig);
+			SendPipeline::create(config, pSeats->m_sendPipeline, &m_pSendPipeline);
+		}
+
 		m_pLuaStates = new (pSeats->m_luaStateParams) LuaStateParams[luaConfig.maxLuaStates];
 		m_pLuaStatesNames = new (pSeats->m_luaStatesNames) char[luaConfig.maxLuaStates * luaConfig.maxLuaStateNameLen];
 
@@ -256,6 +408,7 @@ namespace sce { namespace Sled
 
 		m_bInitialized = false;
 
+		SendPipeline::shutdown(m_pSendPipeline);
 		sceSledPlatformMutexDeallocate(m_pMutex);
 	}
 
@@ -280,27 +433,27 @@ namespace sce { namespace Sled
 										  (m_pProfileStack->getMaxFunctions() != 0 ? true : false),
 										  (m_iMaxMemTraces != 0 ? true : false),
 										  m_pSendBuf);
-			m_pScriptMan->send(m_pSendBuf->getData(), m_pSendBuf->getSize());
+			sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
 		}
 
 		// Send Lua state information
 		{
 			const SCMP::LuaStateBegin scmpLuaBeg(kLuaPluginId);
-			m_pScriptMan->send((uint8_t*)&scmpLuaBeg, scmpLuaBeg.length);
+			sendToClient((uint8_t*)&scmpLuaBeg, scmpLuaBeg.length);
 
 			for (uint16_t i = 0; i < m_iNumLuaStates; i++)
 			{
 				char szTemp[SCMP::Sizes::kPtrLen];
-				StringUtilities::copyString(szTemp, SCMP::Sizes::kPtrLen, "0x%p", m_pLuaStates[i].luaState);
+				NumberFormat::formatPointer(szTemp, SCMP::Sizes::kPtrLen, m_pLuaStates[i].luaState);
 
 				const char *name = m_pLuaStatesNames + (i * m_iMaxLuaStateNameLen);
 
 				const SCMP::LuaStateAdd scmpLua(kLuaPluginId, szTemp, name, m_pLuaStates[i].isDebugging(), m_pSendBuf);
-				m_pScriptMan->send(m_pSendBuf->getData(), m_pSendBuf->getSize());
+				sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
 			}
 
 			const SCMP::LuaStateEnd scmpLuaEnd(kLuaPluginId);
-			m_pScriptMan->send((uint8_t*)&scmpLuaEnd, scmpLuaEnd.length);
+			sendToClient((uint8_t*)&scmpLuaEnd, scmpLuaEnd.length);
 		}
 	}
 
@@ -317,6 +470,13 @@ namespace sce { namespace Sled
 		m_iNumMemTraces = 0;
 		m_bProfilerRunning = false;
 		m_pProfileStack->clear();
+		m_pTraceTimeline->clear();
+		m_pProfileFrames->clear();
+		m_pPerfWatch->clear();
+		m_pGcStats->clear();
+		m_pVarSnapshot->clear();
+		m_iVarEncoding = SCMP::VarValueEncoding::kString;
+		m_iNextTableId = 1;
 		ResetVarFilterType(m_bGlobalVarFilterType);
 		ResetVarFilterType(m_bLocalVarFilterType);
 		ResetVarFilterType(m_bUpvalueVarFilterType);
@@ -395,6 +555,36 @@ namespace sce { namespace Sled
 		case SCMP::LuaTypeCodes::kLuaStateToggle:
 			handleScmpLuaStateToggle(&reader);
 			break;
+		case SCMP::LuaTypeCodes::kHeapCensusPerform:
+			handleScmpHeapCensusPerform(&reader);
+			break;
+		case SCMP::LuaTypeCodes::kVarLookUpPage:
+			handleScmpVarLookUpPage(&reader);
+			break;
+		case SCMP::LuaTypeCodes::kVarEncoding:
+			handleScmpVarEncoding(&reader);
+			break;
+		case SCMP::LuaTypeCodes::kVarLookUpById:
+			handleScmpVarLookUpById(&reader);
+			break;
+		case SCMP::LuaTypeCodes::kCoverageToggle:
+			handleScmpCoverageToggle(&reader);
+			break;
+		case SCMP::LuaTypeCodes::kCoverageReset:
+			handleScmpCoverageReset(&reader);
+			break;
+		case SCMP::LuaTypeCodes::kCoveragePerform:
+			handleScmpCoveragePerform(&reader);
+			break;
+		case SCMP::LuaTypeCodes::kOpcodeProfileToggle:
+			handleScmpOpcodeProfileToggle(&reader);
+			break;
+		case SCMP::LuaTypeCodes::kOpcodeProfileReset:
+			handleScmpOpcodeProfileReset(&reader);
+			break;
+		case SCMP::LuaTypeCodes::kOpcodeProfilePerform:
+			handleScmpOpcodeProfilePerform(&reader);
+			break;
 		}
 	}
 
@@ -407,17 +597,61 @@ namespace sce { namespace Sled
 		{
 			// Pause timers
 			m_pProfileStack->preBreakpoint();
+			m_pTraceTimeline->preBreakpoint();
+			m_pProfileFrames->preBreakpoint();
 			return;
 		}	
 	
+		// Hand packed messages to a worker thread so sends overlap walking the Lua state
+		const bool bSendPipeline = m_pSendPipeline->isEnabled() && m_pScriptMan->isDebuggerConnected();
+		if (bSendPipeline)
+			m_pSendPipeline->begin(sendPipelineCallback, this);
+
+		// Only send variables that changed since the previous stop if snapshot diffing is enabled
+		const bool bVarSnapshot = m_pVarSnapshot->isEnabled();
+		if (bVarSnapshot)
+		{
+			m_pVarSnapshot->begin(m_pCurHookLuaState);
+			m_bVarSnapshotActive = true;
+
+			const SCMP::VarSnapshotBegin vsBeg(kLuaPluginId, m_pVarSnapshot->isFull(), m_pSendBuf);
+			sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+		}
+
+		// Bound the number of variables, bytes and time spent collecting them
+		const bool bVarBudget = m_pVarBudget->isEnabled();
+		if (bVarBudget)
+		{
+			m_pVarBudget->begin();
+			m_bVarBudgetActive = true;
+		}
+
 		// Get globals and callstack information (locals/upvalues/environment) if not excluded
 		clientBreakpointBeginLua(pParams);
 
+		m_bVarBudgetActive = false;
+
+		if (bVarSnapshot)
+		{
+			m_bVarSnapshotActive = false;
+
+			// A stop cut short is no base for the next diff
+			if (bVarBudget && m_pVarBudget->wasExhausted())
+				m_pVarSnapshot->truncate();
+
+			sendVarSnapshotRemoved();
+			m_pVarSnapshot->end();
+		}
+
+		// Everything for this stop has to be out before SledDebugger sends its own messages
+		if (bSendPipeline)
+			m_pSendPipeline->end();
+
 		// Send profile information
 		if (m_pProfileStack->getNumFunctions() > 0)
 		{
 			const SCMP::ProfileInfoBegin piBeg(kLuaPluginId);
-			m_pScriptMan->send((uint8_t*)&piBeg, piBeg.length);
+			sendToClient((uint8_t*)&piBeg, piBeg.length);
 
 			ProfileStack::ConstIterator iter(m_pProfileStack);
 			for (; iter(); ++iter)
@@ -439,18 +673,53 @@ namespace sce { namespace Sled
 										   pEntry->getFnLine(),
 										   (int32_t)pEntry->getFnCalls(),
 										   m_pSendBuf);
-				m_pScriptMan->send(m_pSendBuf->getData(), m_pSendBuf->getSize());
+				sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+
+				// Only the first functions profiled have them
+				if (pEntry->getFnLatency())
+				{
+					const SCMP::ProfileLatency plElapsed(kLuaPluginId, 'e', pEntry->getFnLatency(), m_pSendBuf);
+					sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+
+					const SCMP::ProfileLatency plInner(kLuaPluginId, 'i', pEntry->getFnInnerLatency(), m_pSendBuf);
+					sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+				}
+
+				// Only functions charged any memory while allocations were profiled
+				if ((pEntry->getFnAllocCount() != 0) || (pEntry->getFnFreeBytes() != 0))
+				{
+					const SCMP::ProfileAllocations pa(kLuaPluginId, pEntry->getFnAllocCount(), pEntry->getFnAllocBytes(), pEntry->getFnFreeBytes(), m_pSendBuf);
+					sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+				}
 			}
 
 			const SCMP::ProfileInfoEnd piEnd(kLuaPluginId);
-			m_pScriptMan->send((uint8_t*)&piEnd, piEnd.length);
+			sendToClient((uint8_t*)&piEnd, piEnd.length);
+		}
+
+		// Send garbage collector pause information
+		if (m_pGcStats->hasData())
+		{
+			const SCMP::GcInfoBegin gcBeg(kLuaPluginId);
+			sendToClient((uint8_t*)&gcBeg, gcBeg.length);
+
+			const GcPauseHistogram& steps = m_pGcStats->getStepPauses();
+			const SCMP::GcPauseInfo gcSteps(kLuaPluginId, 's', steps.count, steps.total, steps.longest, GcPauseHistogram::kFirstBucketUpperBound, steps.buckets, GcPauseHistogram::kNumBuckets, m_pSendBuf);
+			sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+
+			const GcPauseHistogram& atomics = m_pGcStats->getAtomicPauses();
+			const SCMP::GcPauseInfo gcAtomics(kLuaPluginId, 'a', atomics.count, atomics.total, atomics.longest, GcPauseHistogram::kFirstBucketUpperBound, atomics.buckets, GcPauseHistogram::kNumBuckets, m_pSendBuf);
+			sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+
+			const SCMP::GcInfoEnd gcEnd(kLuaPluginId, m_pGcStats->getNumCycles(), m_pGcStats->getBytesSwept(), m_pGcStats->getBytesInUse(), m_pSendBuf);
+			sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
 		}
 
 		// Send memory trace information
 		if (m_iNumMemTraces > 0)
 		{
 			const SCMP::MemoryTraceBegin mtBeg(kLuaPluginId);
-			m_pScriptMan->send((uint8_t*)&mtBeg, mtBeg.length);
+			sendToClient((uint8_t*)&mtBeg, mtBeg.length);
 
 			for (uint32_t i = 0; i < m_iNumMemTraces; i++)
 			{
@@ -461,13 +730,13 @@ namespace sce { namespace Sled
 										   m_pMemTraces[i].oldSize,
 										   m_pMemTraces[i].newSize,
 										   m_pSendBuf);
-				m_pScriptMan->send(m_pSendBuf->getData(), m_pSendBuf->getSize());
+				sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
 			}
 
 			m_iNumMemTraces = 0;
 
 			const SCMP::MemoryTraceEnd mtEnd(kLuaPluginId);
-			m_pScriptMan->send((uint8_t*)&mtEnd, mtEnd.length);
+			sendToClient((uint8_t*)&mtEnd, mtEnd.length);
 		}
 	}
 
@@ -481,6 +750,8 @@ namespace sce { namespace Sled
 		{
 			// Resume timers
 			m_pProfileStack->postBreakpoint();
+			m_pTraceTimeline->postBreakpoint();
+			m_pProfileFrames->postBreakpoint();
 		}
 	}
 
@@ -494,6 +765,56 @@ namespace sce { namespace Sled
 	void LuaPlugin::resetProfileInfo()
 	{
 		m_pProfileStack->clear();
+		m_pTraceTimeline->clear();
+		m_pProfileFrames->clear();
+		m_pPerfWatch->clear();
+		m_pGcStats->clear();
+	}
+
+	void LuaPlugin::setProfiler(bool bEnable)
+	{
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+
+		if (bEnable != m_bProfilerRunning)
+			toggleProfilerLua();
+	}
+
+	int32_t LuaPlugin::setTraceCapture(bool bEnable)
+	{
+		if (!m_pTraceTimeline->isEnabled())
+			return SCE_SLED_LUA_ERROR_TRACEDISABLED;
+
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+
+		m_bTraceRunning = bEnable;
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t LuaPlugin::getTraceTime(uint64_t *pTime) const
+	{
+		if (!pTime)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		if (!m_pTraceTimeline->isEnabled())
+			return SCE_SLED_LUA_ERROR_TRACEDISABLED;
+
+		*pTime = m_pTraceTimeline->now();
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t LuaPlugin::writeTrace(TraceWriteCallback pfnWrite, void *pUserData, uint64_t iWindowStart, uint64_t iWindowEnd)
+	{
+		if (!pfnWrite)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		if (!m_pTraceTimeline->isEnabled())
+			return SCE_SLED_LUA_ERROR_TRACEDISABLED;
+
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+
+		return m_pTraceTimeline->writeJson(m_pProfileStack, pfnWrite, pUserData, iWindowStart, iWindowEnd)
+			? SCE_SLED_ERROR_OK
+			: SCE_SLED_LUA_ERROR_TRACEWRITEFAILED;
 	}
 
 	void LuaPlugin::resetMemoryTrace()
@@ -505,6 +826,18 @@ namespace sce { namespace Sled
 	{
 		SCE_SLEDUNUSED(ud);
 
+		// Like the profiler hook this runs on the Lua state's thread, so
+		// the profile is charged without the lock
+		if (m_bAllocationProfileRunning && m_bProfilerRunning)
+		{
+			// The old size of a new block is the type of object in 5.2
+			const std::size_t iOldSize = oldPtr ? oldSize : 0;
+			if (newSize > iOldSize)
+				m_pProfileStack->chargeMemory(newSize - iOldSize, 0);
+			else if (iOldSize > newSize)
+				m_pProfileStack->chargeMemory(0, iOldSize - newSize);
+		}
+
 		// Not running and/or no space allocated
 		if (!m_bMemoryTracerRunning || (m_iMaxMemTraces == 0))
 			return false;
@@ -525,7 +858,7 @@ namespace sce { namespace Sled
 				const sce::SledPlatform::MutexLocker smg(m_pMutex);
 
 				const SCMP::MemoryTraceStreamBegin scmpMemTrBeg(kLuaPluginId);
-				m_pScriptMan->send((uint8_t*)&scmpMemTrBeg, scmpMemTrBeg.length);
+				sendToClient((uint8_t*)&scmpMemTrBeg, scmpMemTrBeg.length);
 
 				for (uint32_t i = 0; i < m_iNumMemTraces; i++)
 				{
@@ -536,11 +869,11 @@ namespace sce { namespace Sled
 															m_pMemTraces[i].oldSize,
 															m_pMemTraces[i].newSize,
 															m_pSendBuf);
-					m_pScriptMan->send(m_pSendBuf->getData(), m_pSendBuf->getSize());
+					sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
 				}
 
 				const SCMP::MemoryTraceStreamEnd scmpMemTrEnd(kLuaPluginId);
-				m_pScriptMan->send((uint8_t*)&scmpMemTrEnd, scmpMemTrEnd.length);
+				sendToClient((uint8_t*)&scmpMemTrEnd, scmpMemTrEnd.length);
 			}
 
 			// Reset
@@ -550,143 +883,980 @@ namespace sce { namespace Sled
 		return true;
 	}
 
-	int32_t LuaPlugin::ttyNotify(const char *pszMessage)
+	int32_t LuaPlugin::heapCensus(lua_State *luaState, HeapCensusSummary *pSummary)
 	{
+		// SledDebugger instance must be valid first
 		if (!m_pScriptMan)
 			return SCE_SLED_LUA_ERROR_NODEBUGGERINSTANCE;
 
-		return m_pScriptMan->ttyNotify(pszMessage);
-	}
+		if (!luaState)
+			return SCE_SLED_LUA_ERROR_INVALIDLUASTATE;
 
-	const char *LuaPlugin::trimFileName(const char *pszFileName)
-	{
-		if (m_pfnChopCharsCallback)
-		{
-			return m_pfnChopCharsCallback(pszFileName);
-		}
-		else
-		{
-			int32_t iChop = m_iPathChopChars;
-			if (pszFileName[0] == '@')
-				++iChop;
+		if (!m_pHeapCensus->isEnabled())
+			return SCE_SLED_LUA_ERROR_HEAPCENSUSDISABLED;
 
-			return pszFileName + iChop;
-		}
+		const sce::SledPlatform::MutexLocker smgSm(m_pScriptMan->getMutex());
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+
+		heapCensusLua(luaState);
+
+		if (pSummary)
+			m_pHeapCensus->getSummary(pSummary);
+
+		// Send the full results along if anyone is listening
+		if (m_pScriptMan->isDebuggerConnected())
+			sendHeapCensus();
+
+		return SCE_SLED_ERROR_OK;
 	}
 
-	void LuaPlugin::tagFuncForLookUp(char *pszBuffer, std::size_t iBufLen, const char *pszFuncName, const char *pszFileName, const int32_t& iLine)
+	void LuaPlugin::setCoverage(bool bEnable)
 	{
-		SCE_SLED_ASSERT(pszBuffer != NULL);
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
 
-		if (pszFuncName)
-		{
-			// If the function name is known then we simply use it
-			Utilities::copyString(pszBuffer, iBufLen, pszFuncName);
-		}
-		else
-		{
-			// Otherwise generate some sort of tag so SLED can look up the function
-			StringUtilities::copyString(pszBuffer, iBufLen, ":%i:%s", iLine, pszFileName);
-		}
+		m_bCoverageRunning = bEnable;
+		updateCoverage();
 	}
 
-	bool LuaPlugin::isVarNameFiltered(const char *pszName, char chWhat) const
+	void LuaPlugin::resetCoverage()
 	{
-		return m_pVarFilterNames->isFiltered(pszName, chWhat);
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+		resetCoverageLua();
 	}
 
-	void LuaPlugin::sendGlobal(const LuaVariable *parent, const char *name, int32_t nameType, const char *value, int32_t valueType)
+	int32_t LuaPlugin::writeCoverage(lua_State *luaState, CoverageWriteCallback pfnWrite, void *pUserData)
 	{
-		const SCMP::GlobalVar global(kLuaPluginId, parent, name, (int16_t)nameType, value, (int16_t)valueType, m_pSendBuf);
-		m_pScriptMan->send(m_pSendBuf->getData(), m_pSendBuf->getSize());
+		// SledDebugger instance must be valid first
+		if (!m_pScriptMan)
+			return SCE_SLED_LUA_ERROR_NODEBUGGERINSTANCE;
+
+		if (!luaState)
+			return SCE_SLED_LUA_ERROR_INVALIDLUASTATE;
+
+		if (!pfnWrite)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		const sce::SledPlatform::MutexLocker smgSm(m_pScriptMan->getMutex());
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+
+		CoverageWriter writer(pfnWrite, pUserData);
+		writer.begin();
+		writeCoverageLua(luaState, &writer);
+
+		return writer.end() ? SCE_SLED_ERROR_OK : SCE_SLED_LUA_ERROR_COVERAGEWRITEFAILED;
 	}
 
-	void LuaPlugin::sendLocal(const LuaVariable *parent, const char *name, int32_t nameType, const char *value, int32_t valueType, int32_t stackLevel, int32_t index)
+	int32_t LuaPlugin::sendCoverage(lua_State *luaState)
 	{
-		// Don't send temporary variables
-		if (name[0] == '(')
-			return;
+		// SledDebugger instance must be valid first
+		if (!m_pScriptMan)
+			return SCE_SLED_LUA_ERROR_NODEBUGGERINSTANCE;
 
-		const SCMP::LocalVar var(kLuaPluginId, parent, name, (int16_t)nameType, value, (int16_t)valueType, (int16_t)stackLevel, index, m_pSendBuf);
-		m_pScriptMan->send(m_pSendBuf->getData(), m_pSendBuf->getSize());
+		if (!luaState)
+			return SCE_SLED_LUA_ERROR_INVALIDLUASTATE;
+
+		const sce::SledPlatform::MutexLocker smgSm(m_pScriptMan->getMutex());
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+
+		if (!m_pScriptMan->isDebuggerConnected())
+			return SCE_SLED_ERROR_TCPNOTCONNECTED;
+
+		sendCoverageData(luaState);
+		return SCE_SLED_ERROR_OK;
 	}
 
-	void LuaPlugin::sendUpvalue(const LuaVariable *parent, const char *name, int32_t nameType, const char *value, int32_t valueType, int32_t stackLevel, int32_t index)
+	int32_t LuaPlugin::setOpcodeProfile(bool bEnable)
 	{
-		// Don't send temporary variables
-		if (name[0] == '(')
-			return;
+		if (!m_pOpcodeProfile->isEnabled())
+			return SCE_SLED_LUA_ERROR_OPCODEPROFILEDISABLED;
+
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
 
-		const SCMP::UpvalueVar var(kLuaPluginId, parent, name, (int16_t)nameType, value, (int16_t)valueType, (int16_t)stackLevel, index, m_pSendBuf);
-		m_pScriptMan->send(m_pSendBuf->getData(), m_pSendBuf->getSize());
+		m_bOpcodeProfileRunning = bEnable;
+		updateOpcodeProfile();
+
+		return SCE_SLED_ERROR_OK;
 	}
 
-	void LuaPlugin::sendEnvVar(const LuaVariable *parent, const char *name, int32_t nameType, const char *value, int32_t valueType, int32_t stackLevel)
+	void LuaPlugin::resetOpcodeProfile()
 	{
-		const SCMP::EnvVar var(kLuaPluginId, parent, name, (int16_t)nameType, value, (int16_t)valueType, (int16_t)stackLevel, m_pSendBuf);
-		m_pScriptMan->send(m_pSendBuf->getData(), m_pSendBuf->getSize());
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+		resetOpcodeProfileLua();
 	}
 
-	void LuaPlugin::handleScmpBreakpointDetails(NetworkBufferReader *pReader)
+	int32_t LuaPlugin::opcodeProfile(lua_State *luaState, OpcodeProfileSummary *pSummary)
 	{
-		SCE_SLED_ASSERT(pReader != NULL);
-		handleScmpBreakpointDetailsLua(pReader);
+		// SledDebugger instance must be valid first
+		if (!m_pScriptMan)
+			return SCE_SLED_LUA_ERROR_NODEBUGGERINSTANCE;
+
+		if (!luaState)
+			return SCE_SLED_LUA_ERROR_INVALIDLUASTATE;
+
+		if (!m_pOpcodeProfile->isEnabled())
+			return SCE_SLED_LUA_ERROR_OPCODEPROFILEDISABLED;
+
+		const sce::SledPlatform::MutexLocker smgSm(m_pScriptMan->getMutex());
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+
+		opcodeProfileLua(luaState);
+
+		if (pSummary)
+			m_pOpcodeProfile->getSummary(pSummary);
+
+		// Send the full results along if anyone is listening
+		if (m_pScriptMan->isDebuggerConnected())
+			sendOpcodeProfile();
+
+		return SCE_SLED_ERROR_OK;
 	}
 
-	void LuaPlugin::handleScmpVarFilterStateNameBegin(NetworkBufferReader *pReader)
+	int32_t LuaPlugin::writeProfileFolded(ProfileFoldedWriteCallback pfnWrite, void *pUserData, ProfileFoldedWeight::Enum weight)
 	{
-		SCE_SLED_ASSERT(pReader != NULL);
-		const SCMP::VarFilterStateNameBegin vfs(pReader);
-		//SCE_SLED_LOG(Logging::kInfo, "[SLED] [LuaPlugin] [Var Filter State Name Begin] [%c]", (char)vfs.what);
-		m_pVarFilterNames->clear(vfs.what);
+		if (!pfnWrite)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		if (m_pProfileStack->getMaxCallPaths() == 0)
+			return SCE_SLED_LUA_ERROR_CALLPATHSDISABLED;
+
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+
+		FoldedStackWriter writer(pfnWrite, pUserData);
+		m_pProfileStack->writeFolded(&writer, weight);
+
+		return writer.end() ? SCE_SLED_ERROR_OK : SCE_SLED_LUA_ERROR_PROFILEFOLDEDWRITEFAILED;
 	}
 
-	void LuaPlugin::handleScmpVarFilterStateName(NetworkBufferReader *pReader)
+	namespace
 	{
-		SCE_SLED_ASSERT(pReader != NULL);
-		const SCMP::VarFilterStateName vfs(pReader);
-		//SCE_SLED_LOG(Logging::kInfo, "[SLED] [LuaPlugin] [Var Filter State Name] [%c] [%s]", (char)vfs.what, vfs.filter);
-		m_pVarFilterNames->addFilter(vfs.what, vfs.filter);
+		void FillLatencyPercentiles(const ProfileLatencyHistogram *pHistogram, ProfileLatencyPercentiles *pPercentiles)
+		{
+			pPercentiles->p50 = pHistogram->getValueAtPercentile(50.0);
+			pPercentiles->p90 = pHistogram->getValueAtPercentile(90.0);
+			pPercentiles->p99 = pHistogram->getValueAtPercentile(99.0);
+			pPercentiles->p999 = pHistogram->getValueAtPercentile(99.9);
+			pPercentiles->longest = pHistogram->longest;
+		}
+
+		inline uint64_t ToMicroseconds(float flSeconds)
+		{
+			return (flSeconds > 0.0f) ? (uint64_t)((double)flSeconds * 1000000.0 + 0.5) : 0;
+		}
+
+		inline uint32_t ToNanoseconds(float flSeconds)
+		{
+			return (flSeconds > 0.0f) ? (uint32_t)((double)flSeconds * 1000000000.0 + 0.5) : 0;
+		}
 	}
 
-	void LuaPlugin::handleScmpVarFilterStateNameEnd(NetworkBufferReader *pReader)
+	int32_t LuaPlugin::profileLatency(const char *pszSource, int32_t iLineDefined, ProfileLatencySummary *pSummary) const
 	{
-		SCE_SLED_ASSERT(pReader != NULL);
-		/*SCMP::VarFilterStateNameEnd vfs(pReader);
-		SCE_SLED_LOG(Logging::kInfo, "[SLED] [LuaPlugin] [Var Filter State Name End] [%c]", (char)vfs.what);*/
+		if (!pszSource || !pSummary)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		if (m_pProfileStack->getMaxHistograms() == 0)
+			return SCE_SLED_LUA_ERROR_LATENCYDISABLED;
+
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+
+		// Entries are keyed by name too, but the name of a function
+		// without one is only a tag for SLED to look up
+		ProfileStack::ConstIterator iter(m_pProfileStack);
+		for (; iter(); ++iter)
+		{
+			const ProfileEntry *pEntry = iter.get();
+
+			if ((pEntry->getFnLine() != iLineDefined) || !pEntry->getFnLatency())
+				continue;
+
+			if (std::strcmp(pEntry->getFnFile(), pszSource) != 0)
+				continue;
+
+			pSummary->callCount = pEntry->getFnLatency()->count;
+			FillLatencyPercentiles(pEntry->getFnLatency(), &pSummary->elapsed);
+			FillLatencyPercentiles(pEntry->getFnInnerLatency(), &pSummary->inner);
+			return SCE_SLED_ERROR_OK;
+		}
+
+		return SCE_SLED_LUA_ERROR_PROFILEFUNCTIONNOTFOUND;
 	}
 
-	void LuaPlugin::handleScmpVarFilterStateTypeBegin(NetworkBufferReader *pReader)
+	int32_t LuaPlugin::profileFunctionTimes(const char *pszSource, int32_t iLineDefined, ProfileFunctionTimes *pTimes) const
 	{
-		SCE_SLED_ASSERT(pReader != NULL);
-		const SCMP::VarFilterStateTypeBegin vfs(pReader);
-		//SCE_SLED_LOG(Logging::kInfo, "[SLED] [LuaPlugin] [SCMP] [Lua] [Var Filter State Type Begin] [%c]", (char)vfs.what);
-		switch ((char)vfs.what)
+		if (!pszSource || !pTimes)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+
+		ProfileStack::ConstIterator iter(m_pProfileStack);
+		for (; iter(); ++iter)
 		{
-		case 'g':
-			ResetVarFilterType(m_bGlobalVarFilterType);
-			break;
-		case 'l':
-			ResetVarFilterType(m_bLocalVarFilterType);
-			break;
-		case 'u':
-			ResetVarFilterType(m_bUpvalueVarFilterType);
-			break;
-		case 'e':
-			ResetVarFilterType(m_bEnvVarVarFilterTypes);
-			break;
+			const ProfileEntry *pEntry = iter.get();
+
+			if (pEntry->getFnLine() != iLineDefined)
+				continue;
+
+			if (std::strcmp(pEntry->getFnFile(), pszSource) != 0)
+				continue;
+
+			pTimes->callCount = pEntry->getFnCallCount();
+			pTimes->timeElapsed = ToMicroseconds(pEntry->getFnTimeElapsed());
+			pTimes->timeElapsedCorrected = ToMicroseconds(pEntry->getFnTimeElapsedCorrected());
+			pTimes->timeInnerElapsed = ToMicroseconds(pEntry->getFnTimeInnerElapsed());
+			pTimes->timeInnerElapsedCorrected = ToMicroseconds(pEntry->getFnTimeInnerElapsedCorrected());
+			return SCE_SLED_ERROR_OK;
 		}
+
+		return SCE_SLED_LUA_ERROR_PROFILEFUNCTIONNOTFOUND;
 	}
 
-	void LuaPlugin::handleScmpVarFilterStateType(NetworkBufferReader *pReader)
+	void LuaPlugin::setAllocationProfile(bool bEnable)
 	{
-		SCE_SLED_ASSERT(pReader != NULL);
-		const SCMP::VarFilterStateType vfs(pReader);
-		/*SCE_SLED_LOG(Logging::kInfo, "[SLED] [LuaPlugin] [SCMP] [Lua] [Var Filter State Type] [%c] [%s,%s,%s,%s,%s,%s,%s,%s,%s]",
-			((char)vfs.what),
-			(vfs.filter[0] == 1 ? "true" : "false"),
-			(vfs.filter[1] == 1 ? "true" : "false"),
-			(vfs.filter[2] == 1 ? "true" : "false"),
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+
+		m_bAllocationProfileRunning = bEnable;
+	}
+
+	int32_t LuaPlugin::profileAllocations(const char *pszSource, int32_t iLineDefined, ProfileFunctionAllocations *pAllocations) const
+	{
+		if (!pszSource || !pAllocations)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+
+		ProfileStack::ConstIterator iter(m_pProfileStack);
+		for (; iter(); ++iter)
+		{
+			const ProfileEntry *pEntry = iter.get();
+
+			if (pEntry->getFnLine() != iLineDefined)
+				continue;
+
+			if (std::strcmp(pEntry->getFnFile(), pszSource) != 0)
+				continue;
+
+			pAllocations->allocCount = pEntry->getFnAllocCount();
+			pAllocations->allocBytes = pEntry->getFnAllocBytes();
+			pAllocations->freeBytes = pEntry->getFnFreeBytes();
+			return SCE_SLED_ERROR_OK;
+		}
+
+		return SCE_SLED_LUA_ERROR_PROFILEFUNCTIONNOTFOUND;
+	}
+
+	int32_t LuaPlugin::profilerOverhead(ProfileOverhead *pOverhead) const
+	{
+		if (!pOverhead)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+
+		pOverhead->calibrationCalls = m_pProfileStack->getCalibrationCalls();
+		pOverhead->selfTime = ToNanoseconds(m_pProfileStack->getSelfOverhead());
+		pOverhead->callTime = ToNanoseconds(m_pProfileStack->getCallOverhead());
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t LuaPlugin::writeProfileCapture(ProfileCaptureWriteCallback pfnWrite, void *pUserData, const char *pszBuildId)
+	{
+		if (!pfnWrite)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+
+		ProfileOverhead overhead;
+		overhead.calibrationCalls = m_pProfileStack->getCalibrationCalls();
+		overhead.selfTime = ToNanoseconds(m_pProfileStack->getSelfOverhead());
+		overhead.callTime = ToNanoseconds(m_pProfileStack->getCallOverhead());
+
+		// Frames still running aren't counted
+		const uint64_t iCurrentFrame = m_pProfileFrames->getCurrentFrame();
+
+		ProfileCaptureWriter writer(pfnWrite, pUserData);
+		writer.begin();
+		writer.addInfo(pszBuildId, ToMicroseconds(m_pProfileStack->getTimeElapsed()), (iCurrentFrame > 0) ? (iCurrentFrame - 1) : 0, overhead);
+		m_pProfileStack->writeCapture(&writer);
+
+		return writer.end() ? SCE_SLED_ERROR_OK : SCE_SLED_LUA_ERROR_PROFILECAPTUREWRITEFAILED;
+	}
+
+	int32_t LuaPlugin::profileZoneBegin(ProfileZoneSite *pSite)
+	{
+		if (!pSite || !pSite->name || !pSite->file)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		// Zones run on the Lua state's thread, under the C function Lua
+		// called, so like the profiler hook they go without the lock
+		if (!m_bProfilerRunning || !m_pProfileStack->enterZone(pSite))
+			return SCE_SLED_LUA_ERROR_PROFILEZONENOTENTERED;
+
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t LuaPlugin::profileZoneEnd(ProfileZoneSite *pSite)
+	{
+		if (!pSite || !pSite->name || !pSite->file)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		// The profile was reset, or the profiler stopped, inside the zone
+		if (!m_bProfilerRunning || !m_pProfileStack->leaveZone(pSite))
+			return SCE_SLED_LUA_ERROR_PROFILEZONENOTENTERED;
+
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t LuaPlugin::profilerFrameMark()
+	{
+		if (!m_pProfileFrames->isEnabled())
+			return SCE_SLED_LUA_ERROR_FRAMESDISABLED;
+
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+
+		// Function times are only counted while the profiler runs
+		if (m_bProfilerRunning)
+			m_pProfileFrames->mark(m_pProfileStack);
+		else
+			m_pProfileFrames->skip();
+
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t LuaPlugin::profilerFrameStats(ProfileFrameStats *pStats) const
+	{
+		if (!pStats)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		if (!m_pProfileFrames->isEnabled())
+			return SCE_SLED_LUA_ERROR_FRAMESDISABLED;
+
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+
+		m_pProfileFrames->getStats(pStats);
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t LuaPlugin::profilerFrameFunctions(ProfileFrameFunctionCallback pfnCallback, void *pUserData) const
+	{
+		if (!pfnCallback)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		if (!m_pProfileFrames->isEnabled())
+			return SCE_SLED_LUA_ERROR_FRAMESDISABLED;
+
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+
+		m_pProfileFrames->forEachFunction(m_pProfileStack, pfnCallback, pUserData);
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t LuaPlugin::profilerSlowFrame(uint16_t iIndex, ProfileSlowFrame *pFrame, ProfileFrameFunctionCallback pfnCallback, void *pUserData) const
+	{
+		if (!pFrame)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		if (!m_pProfileFrames->isEnabled())
+			return SCE_SLED_LUA_ERROR_FRAMESDISABLED;
+
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+
+		return m_pProfileFrames->getSlowFrame(m_pProfileStack, iIndex, pFrame, pfnCallback, pUserData)
+			? SCE_SLED_ERROR_OK
+			: SCE_SLED_ERROR_INVALIDPARAMETER;
+	}
+
+	int32_t LuaPlugin::addPerfWatch(const char *pszFnName, const char *pszSource, uint32_t iBudget, uint32_t iFlags, uint16_t *pId)
+	{
+		if (!pszFnName || !pId)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		if (!m_pPerfWatch->isEnabled())
+			return SCE_SLED_LUA_ERROR_PERFWATCHESDISABLED;
+
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+
+		return m_pPerfWatch->add(pszFnName, pszSource, iBudget, iFlags, pId);
+	}
+
+	int32_t LuaPlugin::removePerfWatch(uint16_t iId)
+	{
+		if (!m_pPerfWatch->isEnabled())
+			return SCE_SLED_LUA_ERROR_PERFWATCHESDISABLED;
+
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+
+		return m_pPerfWatch->remove(iId)
+			? SCE_SLED_ERROR_OK
+			: SCE_SLED_ERROR_INVALIDPARAMETER;
+	}
+
+	int32_t LuaPlugin::perfIncident(uint16_t iIndex, PerfIncident *pIncident) const
+	{
+		if (!pIncident)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		if (!m_pPerfWatch->isEnabled())
+			return SCE_SLED_LUA_ERROR_PERFWATCHESDISABLED;
+
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+
+		return m_pPerfWatch->getIncident(m_pProfileStack, iIndex, pIncident)
+			? SCE_SLED_ERROR_OK
+			: SCE_SLED_ERROR_INVALIDPARAMETER;
+	}
+
+	int32_t LuaPlugin::perfIncidentCount(uint16_t *pNumKept, uint64_t *pNumTotal) const
+	{
+		if (!pNumKept || !pNumTotal)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		if (!m_pPerfWatch->isEnabled())
+			return SCE_SLED_LUA_ERROR_PERFWATCHESDISABLED;
+
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+
+		*pNumKept = m_pPerfWatch->getNumIncidents();
+		*pNumTotal = m_pPerfWatch->getNumIncidentsTotal();
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t LuaPlugin::addProfileFilter(ProfileFilterKind::Enum kind, const char *pszPattern)
+	{
+		if (!pszPattern)
+			return SCE_SLED_ERROR_NULLPARAMETER;
+
+		if (!m_pProfileFilter->isEnabled())
+			return SCE_SLED_LUA_ERROR_PROFILEFILTERSDISABLED;
+
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+
+		const int32_t iError = m_pProfileFilter->add(kind, pszPattern);
+		if (iError != SCE_SLED_ERROR_OK)
+			return iError;
+
+		profileFiltersChanged();
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t LuaPlugin::clearProfileFilters()
+	{
+		if (!m_pProfileFilter->isEnabled())
+			return SCE_SLED_LUA_ERROR_PROFILEFILTERSDISABLED;
+
+		const sce::SledPlatform::MutexLocker smg(m_pMutex);
+
+		m_pProfileFilter->clear();
+		profileFiltersChanged();
+		return SCE_SLED_ERROR_OK;
+	}
+
+	void LuaPlugin::profileFiltersChanged()
+	{
+		// Calls entered under the old filters might not be left under the
+		// new ones, or the other way around, so start the profile over
+		resetProfileInfo();
+		updateProfileFilters();
+	}
+
+	int LuaPlugin::profileFilterFunc(const char *pszSource, int iLineDefined, void *pUserData)
+	{
+		SCE_SLED_ASSERT(pUserData != NULL);
+
+		// Runs inside the VM so must not touch the Lua state. Names the
+		// script the way hookFunc_Profiler does: C functions untrimmed
+		LuaPlugin *pPlugin = static_cast<LuaPlugin*>(pUserData);
+		const char *pszFile = (iLineDefined < 0) ? pszSource : pPlugin->trimFileName(pszSource);
+
+		return pPlugin->m_pProfileFilter->isSourceProfiled(pszFile) ? 1 : 0;
+	}
+
+	void LuaPlugin::checkPerfWatch(lua_State *luaState, const ProfileEntry *pEntry)
+	{
+		const PerfWatchIncident *pIncident = m_pPerfWatch->check(m_pProfileStack, pEntry, m_pProfileFrames->getCurrentFrame());
+		if (!pIncident)
+			return;
+
+		if ((pIncident->flags & (PerfWatchFlags::kBreak | PerfWatchFlags::kTtyNotify)) == 0)
+			return;
+
+		// [SLED] Performance watch <id>: <function> (<source>:<line>) took <time> us, budget <budget> us
+		char szMessage[384];
+		char szNumber[24];
+
+		Utilities::copyString(szMessage, sizeof(szMessage), "[SLED] Performance watch ");
+		NumberFormat::formatUnsigned(szNumber, sizeof(szNumber), pIncident->watch);
+		Utilities::appendString(szMessage, sizeof(szMessage), szNumber);
+		Utilities::appendString(szMessage, sizeof(szMessage), ": ");
+		Utilities::appendString(szMessage, sizeof(szMessage), (pEntry->getFnName()[0] == ':') ? "(anonymous)" : pEntry->getFnName());
+		Utilities::appendString(szMessage, sizeof(szMessage), " (");
+		Utilities::appendString(szMessage, sizeof(szMessage), pEntry->getFnFile());
+		Utilities::appendString(szMessage, sizeof(szMessage), ":");
+		NumberFormat::formatInteger(szNumber, sizeof(szNumber), pEntry->getFnLine());
+		Utilities::appendString(szMessage, sizeof(szMessage), szNumber);
+		Utilities::appendString(szMessage, sizeof(szMessage), ") took ");
+		NumberFormat::formatUnsigned(szNumber, sizeof(szNumber), ((pIncident->flags & PerfWatchFlags::kInnerTime) != 0) ? pIncident->timeInnerElapsed : pIncident->timeElapsed);
+		Utilities::appendString(szMessage, sizeof(szMessage), szNumber);
+		Utilities::appendString(szMessage, sizeof(szMessage), " us, budget ");
+		NumberFormat::formatUnsigned(szNumber, sizeof(szNumber), pIncident->budget);
+		Utilities::appendString(szMessage, sizeof(szMessage), szNumber);
+		Utilities::appendString(szMessage, sizeof(szMessage), " us");
+
+		if ((pIncident->flags & PerfWatchFlags::kBreak) != 0)
+		{
+			debuggerBreak(luaState, szMessage);
+		}
+		else
+		{
+			ttyNotify(szMessage);
+			ttyNotify("\n");
+		}
+	}
+
+	void LuaPlugin::sendOpcodeProfile()
+	{
+		const SCMP::OpcodeProfileBegin opBeg(kLuaPluginId, m_pOpcodeProfile->getNumOpcodes(), m_bOpcodeProfileRunning, m_pSendBuf);
+		sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+
+		for (uint16_t i = 0; i < m_pOpcodeProfile->getNumOpcodes(); i++)
+		{
+			const SCMP::OpcodeProfileOpcode opOpcode(kLuaPluginId, i, m_pOpcodeProfile->getOpcodeName(i), m_pOpcodeProfile->getOpcodeTotal(i), m_pSendBuf);
+			sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+		}
+
+		for (uint16_t i = 0; i < m_pOpcodeProfile->getNumFunctions(); i++)
+		{
+			const OpcodeProfileFunction *pFunc = m_pOpcodeProfile->getFunction(i);
+
+			const SCMP::OpcodeProfileFunction opFunc(kLuaPluginId, pFunc->source, pFunc->lineDefined, pFunc->total, pFunc->counts, m_pOpcodeProfile->getNumOpcodes(), m_pSendBuf);
+			sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+		}
+
+		const SCMP::OpcodeProfileEnd opEnd(kLuaPluginId, m_pOpcodeProfile->getTotalInstructions(), m_pOpcodeProfile->getNumFunctionsSeen(), m_pSendBuf);
+		sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+	}
+
+	bool LuaPlugin::coverageSendFunc(const uint8_t *pData, int32_t iSize, void *pUserData)
+	{
+		SCE_SLED_ASSERT(pUserData != NULL);
+
+		LuaPlugin *pPlugin = static_cast<LuaPlugin*>(pUserData);
+
+		const SCMP::CoverageData covData(kLuaPluginId, pData, (uint16_t)iSize, pPlugin->m_pSendBuf);
+		return pPlugin->sendToClient(pPlugin->m_pSendBuf->getData(), pPlugin->m_pSendBuf->getSize()) >= 0;
+	}
+
+	void LuaPlugin::sendCoverageData(lua_State *luaState)
+	{
+		const SCMP::CoverageBegin covBeg(kLuaPluginId, m_bCoverageRunning, m_pSendBuf);
+		sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+
+		// The same bytes luaPluginWriteCoverage hands out, cut to fit messages
+		CoverageWriter writer(LuaPlugin::coverageSendFunc, this);
+		writer.begin();
+		writeCoverageLua(luaState, &writer);
+		const bool bComplete = writer.end();
+
+		const SCMP::CoverageEnd covEnd(kLuaPluginId, writer.getNumChunks(), writer.getNumBytes(), bComplete, m_pSendBuf);
+		sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+	}
+
+	void LuaPlugin::sendVarSnapshotRemoved()
+	{
+		// Variables past the budget were never looked at so none can be called removed
+		const bool bTruncated = m_pVarSnapshot->isTruncated();
+
+		for (uint32_t i = 0; !bTruncated && (i < m_pVarSnapshot->getNumPrevious()); i++)
+		{
+			const VarSnapshotEntry *pEntry = m_pVarSnapshot->getRemoved(i);
+			if (pEntry == NULL)
+				continue;
+
+			const SCMP::VarSnapshotRemoved vsRem(kLuaPluginId,
+												 pEntry->what,
+												 m_pVarSnapshot->getRemovedName(pEntry),
+												 pEntry->nameType,
+												 pEntry->stackLevel,
+												 pEntry->index,
+												 m_pSendBuf);
+			sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+		}
+
+		const SCMP::VarSnapshotEnd vsEnd(kLuaPluginId,
+										 m_pVarSnapshot->getNumAdded(),
+										 m_pVarSnapshot->getNumChanged(),
+										 m_pVarSnapshot->getNumUnchanged(),
+										 bTruncated ? 0 : m_pVarSnapshot->getNumRemoved(),
+										 m_pSendBuf);
+		sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+	}
+
+	void LuaPlugin::sendHeapCensus()
+	{
+		const SCMP::HeapCensusBegin hcBeg(kLuaPluginId);
+		sendToClient((uint8_t*)&hcBeg, hcBeg.length);
+
+		for (int32_t i = 0; i < HeapCensus::kNumLuaTypes; i++)
+		{
+			if (m_pHeapCensus->getTypeCount(i) == 0)
+				continue;
+
+			const SCMP::HeapCensusType hcType(kLuaPluginId, (int16_t)i, m_pHeapCensus->getTypeCount(i), m_pHeapCensus->getTypeBytes(i), m_pSendBuf);
+			sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+		}
+
+		for (uint16_t i = 0; i < m_pHeapCensus->getNumTables(); i++)
+		{
+			const HeapCensusTableEntry *pTable = m_pHeapCensus->getTable(i);
+
+			const SCMP::HeapCensusTable hcTable(kLuaPluginId, pTable->table, pTable->root, pTable->arrayCount, pTable->hashCount, pTable->bytes, m_pSendBuf);
+			sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+		}
+
+		for (uint16_t i = 0; i < m_pHeapCensus->getNumRoots(); i++)
+		{
+			const HeapCensusRootEntry *pRoot = m_pHeapCensus->getRoot(i);
+
+			const SCMP::HeapCensusRoot hcRoot(kLuaPluginId, pRoot->name, pRoot->objects, pRoot->bytes, m_pSendBuf);
+			sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+		}
+
+		const SCMP::HeapCensusEnd hcEnd(kLuaPluginId,
+										m_pHeapCensus->getNumObjects(),
+										m_pHeapCensus->getTotalBytes(),
+										m_pHeapCensus->getElapsed(),
+										m_pHeapCensus->isTruncated(),
+										m_pSendBuf);
+		sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+	}
+
+	int32_t LuaPlugin::sendToClient(const uint8_t *pData, const int32_t& iSize)
+	{
+		// While a stop is being collected everything is queued so it stays in order
+		if (m_pSendPipeline->isRunning())
+		{
+			m_pSendPipeline->enqueue(pData, iSize);
+			return iSize;
+		}
+
+		return m_pScriptMan->send(pData, iSize);
+	}
+
+	int32_t LuaPlugin::sendPipelineCallback(void *pUserData, const uint8_t *pData, int32_t iSize)
+	{
+		SCE_SLED_ASSERT(pUserData != NULL);
+
+		LuaPlugin *pPlugin = static_cast<LuaPlugin*>(pUserData);
+		return pPlugin->m_pScriptMan->send(pData, iSize);
+	}
+
+	int32_t LuaPlugin::ttyNotify(const char *pszMessage)
+	{
+		if (!m_pScriptMan)
+			return SCE_SLED_LUA_ERROR_NODEBUGGERINSTANCE;
+
+		// SledDebugger sends tty text itself so let queued messages go first
+		m_pSendPipeline->drain();
+
+		return m_pScriptMan->ttyNotify(pszMessage);
+	}
+
+	const char *LuaPlugin::trimFileName(const char *pszFileName)
+	{
+		if (m_pfnChopCharsCallback)
+		{
+			return m_pfnChopCharsCallback(pszFileName);
+		}
+		else
+		{
+			int32_t iChop = m_iPathChopChars;
+			if (pszFileName[0] == '@')
+				++iChop;
+
+			return pszFileName + iChop;
+		}
+	}
+
+	void LuaPlugin::lineMaskFunc(const char *pszSource, int iFirstLine, int iNumLines, unsigned char *pMask, void *pUserData)
+	{
+		SCE_SLED_ASSERT(pUserData != NULL);
+
+		// Runs inside the VM so must not touch the Lua state
+		LuaPlugin *pPlugin = static_cast<LuaPlugin*>(pUserData);
+		const char *pszFile = pPlugin->trimFileName(pszSource);
+
+		for (uint16_t i = 0; i < pPlugin->m_iNumBreakpoints; i++)
+		{
+			const int32_t iLine = pPlugin->m_pBreakpoints[i].getLine();
+			if ((iLine < iFirstLine) || (iLine >= (iFirstLine + iNumLines)))
+				continue;
+
+			// Same match isLineBreakpoint makes once the line is reached
+			int32_t iHash = 0;
+			SledDebugger::generateHash(pszFile, iLine, &iHash);
+
+			if (pPlugin->m_pBreakpoints[i] == Breakpoint(pszFile, iLine, iHash))
+			{
+				const int iBit = iLine - iFirstLine;
+				pMask[iBit >> 3] |= (unsigned char)(1 << (iBit & 7));
+			}
+		}
+	}
+
+	void LuaPlugin::tagFuncForLookUp(char *pszBuffer, std::size_t iBufLen, const char *pszFuncName, const char *pszFileName, const int32_t& iLine)
+	{
+		SCE_SLED_ASSERT(pszBuffer != NULL);
+
+		if (pszFuncName)
+		{
+			// If the function name is known then we simply use it
+			Utilities::copyString(pszBuffer, iBufLen, pszFuncName);
+		}
+		else
+		{
+			// Otherwise generate some sort of tag so SLED can look up the function
+			// (":<line>:<file>")
+			char szLine[24];
+			szLine[0] = ':';
+			const std::size_t iLineLen = 1 + NumberFormat::formatInteger(szLine + 1, sizeof(szLine) - 2, iLine);
+			szLine[iLineLen] = ':';
+			szLine[iLineLen + 1] = '\0';
+
+			Utilities::copyString(pszBuffer, iBufLen, szLine);
+
+			const std::size_t iPos = std::strlen(pszBuffer);
+			Utilities::copyString(pszBuffer + iPos, iBufLen - iPos, pszFileName);
+		}
+	}
+
+	bool LuaPlugin::isVarNameFiltered(const char *pszName, char chWhat) const
+	{
+		return m_pVarFilterNames->isFiltered(pszName, chWhat);
+	}
+
+	bool LuaPlugin::isScopeVarTypeFiltered(LuaVariableScope::Enum what, int32_t iVarType) const
+	{
+		switch (what)
+		{
+		case LuaVariableScope::kGlobal:			return isGlobalVarTypeFiltered(iVarType);
+		case LuaVariableScope::kLocal:			return isLocalVarTypeFiltered(iVarType);
+		case LuaVariableScope::kUpvalue:		return isUpvalueVarTypeFiltered(iVarType);
+		case LuaVariableScope::kEnvironment:	return isEnvVarVarTypeFiltered(iVarType);
+		}
+
+		return false;
+	}
+
+	bool LuaPlugin::isScopeVarNameFiltered(LuaVariableScope::Enum what, const char *pszName) const
+	{
+		switch (what)
+		{
+		case LuaVariableScope::kGlobal:			return isGlobalVarNameFiltered(pszName);
+		case LuaVariableScope::kLocal:			return isLocalVarNameFiltered(pszName);
+		case LuaVariableScope::kUpvalue:		return isUpvalueVarNameFiltered(pszName);
+		case LuaVariableScope::kEnvironment:	return isEnvVarVarNameFiltered(pszName);
+		}
+
+		return false;
+	}
+
+	bool LuaPlugin::withinVarBudget(LuaVariableScope::Enum what, int32_t iStackLevel, uint32_t iOffset)
+	{
+		if (!m_bVarBudgetActive || !m_pVarBudget->isExhausted())
+			return true;
+
+		// iOffset is the page offset SLED can fetch the rest of the scope from
+		const SCMP::VarTruncated scmpTrunc(kLuaPluginId, (uint8_t)what, (int16_t)iStackLevel, iOffset, m_pSendBuf);
+		sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+
+		return false;
+	}
+
+	void LuaPlugin::sendGlobal(const LuaVariable *parent, const char *name, int32_t nameType, const SCMP::VarValue& value, int32_t valueType)
+	{
+		// Skip if unchanged since the previous stop
+		if (m_bVarSnapshotActive && (parent == NULL) && !m_pVarSnapshot->update('g', 0, 0, name, nameType, value, valueType))
+			return;
+
+		const SCMP::GlobalVar global(kLuaPluginId, parent, name, (int16_t)nameType, value, (int16_t)valueType, m_iVarEncoding, m_pSendBuf);
+		sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+
+		if (m_bVarBudgetActive)
+			m_pVarBudget->spend(m_pSendBuf->getSize());
+	}
+
+	void LuaPlugin::sendLocal(const LuaVariable *parent, const char *name, int32_t nameType, const SCMP::VarValue& value, int32_t valueType, int32_t stackLevel, int32_t index)
+	{
+		// Don't send temporary variables
+		if (name[0] == '(')
+			return;
+
+		// Skip if unchanged since the previous stop
+		if (m_bVarSnapshotActive && (parent == NULL) && !m_pVarSnapshot->update('l', stackLevel, index, name, nameType, value, valueType))
+			return;
+
+		const SCMP::LocalVar var(kLuaPluginId, parent, name, (int16_t)nameType, value, (int16_t)valueType, m_iVarEncoding, (int16_t)stackLevel, index, m_pSendBuf);
+		sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+
+		if (m_bVarBudgetActive)
+			m_pVarBudget->spend(m_pSendBuf->getSize());
+	}
+
+	void LuaPlugin::sendUpvalue(const LuaVariable *parent, const char *name, int32_t nameType, const SCMP::VarValue& value, int32_t valueType, int32_t stackLevel, int32_t index)
+	{
+		// Don't send temporary variables
+		if (name[0] == '(')
+			return;
+
+		// Skip if unchanged since the previous stop
+		if (m_bVarSnapshotActive && (parent == NULL) && !m_pVarSnapshot->update('u', stackLevel, index, name, nameType, value, valueType))
+			return;
+
+		const SCMP::UpvalueVar var(kLuaPluginId, parent, name, (int16_t)nameType, value, (int16_t)valueType, m_iVarEncoding, (int16_t)stackLevel, index, m_pSendBuf);
+		sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+
+		if (m_bVarBudgetActive)
+			m_pVarBudget->spend(m_pSendBuf->getSize());
+	}
+
+	void LuaPlugin::sendEnvVar(const LuaVariable *parent, const char *name, int32_t nameType, const SCMP::VarValue& value, int32_t valueType, int32_t stackLevel)
+	{
+		// Skip if unchanged since the previous stop
+		if (m_bVarSnapshotActive && (parent == NULL) && !m_pVarSnapshot->update('e', stackLevel, 0, name, nameType, value, valueType))
+			return;
+
+		const SCMP::EnvVar var(kLuaPluginId, parent, name, (int16_t)nameType, value, (int16_t)valueType, m_iVarEncoding, (int16_t)stackLevel, m_pSendBuf);
+		sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+
+		if (m_bVarBudgetActive)
+			m_pVarBudget->spend(m_pSendBuf->getSize());
+	}
+
+	void LuaPlugin::sendVarLookUpBegin(LuaVariableScope::Enum what)
+	{
+		// Prepare network message based on var type
+		switch (what)
+		{
+			case LuaVariableScope::kGlobal:
+			{
+				const SCMP::GlobalVarLookUpBegin scmp(kLuaPluginId);
+				sendToClient((uint8_t*)&scmp, scmp.length);
+			}
+			break;
+			case LuaVariableScope::kLocal:
+			{
+				const SCMP::LocalVarLookUpBegin scmp(kLuaPluginId);
+				sendToClient((uint8_t*)&scmp, scmp.length);
+			}
+			break;
+			case LuaVariableScope::kUpvalue:
+			{
+				const SCMP::UpvalueVarLookUpBegin scmp(kLuaPluginId);
+				sendToClient((uint8_t*)&scmp, scmp.length);
+			}
+			break;
+			case LuaVariableScope::kEnvironment:
+			{
+				const SCMP::EnvVarLookUpBegin scmp(kLuaPluginId);
+				sendToClient((uint8_t*)&scmp, scmp.length);
+			}
+			break;
+		}
+	}
+
+	void LuaPlugin::sendVarLookUpEnd(LuaVariableScope::Enum what)
+	{
+		// Prepare network message based on var type
+		switch (what)
+		{
+			case LuaVariableScope::kGlobal:
+			{
+				const SCMP::GlobalVarLookUpEnd scmp(kLuaPluginId);
+				sendToClient((uint8_t*)&scmp, scmp.length);
+			}
+			break;
+			case LuaVariableScope::kLocal:
+			{
+				const SCMP::LocalVarLookUpEnd scmp(kLuaPluginId);
+				sendToClient((uint8_t*)&scmp, scmp.length);
+			}
+			break;
+			case LuaVariableScope::kUpvalue:
+			{
+				const SCMP::UpvalueVarLookUpEnd scmp(kLuaPluginId);
+				sendToClient((uint8_t*)&scmp, scmp.length);
+			}
+			break;
+			case LuaVariableScope::kEnvironment:
+			{
+				const SCMP::EnvVarLookUpEnd scmp(kLuaPluginId);
+				sendToClient((uint8_t*)&scmp, scmp.length);
+			}
+			break;
+		}
+	}
+
+	void LuaPlugin::handleScmpBreakpointDetails(NetworkBufferReader *pReader)
+	{
+		SCE_SLED_ASSERT(pReader != NULL);
+		handleScmpBreakpointDetailsLua(pReader);
+	}
+
+	void LuaPlugin::handleScmpVarFilterStateNameBegin(NetworkBufferReader *pReader)
+	{
+		SCE_SLED_ASSERT(pReader != NULL);
+		const SCMP::VarFilterStateNameBegin vfs(pReader);
+		//SCE_SLED_LOG(Logging::kInfo, "[SLED] [LuaPlugin] [Var Filter State Name Begin] [%c]", (char)vfs.what);
+		m_pVarFilterNames->clear(vfs.what);
+	}
+
+	void LuaPlugin::handleScmpVarFilterStateName(NetworkBufferReader *pReader)
+	{
+		SCE_SLED_ASSERT(pReader != NULL);
+		const SCMP::VarFilterStateName vfs(pReader);
+		//SCE_SLED_LOG(Logging::kInfo, "[SLED] [LuaPlugin] [Var Filter State Name] [%c] [%s]", (char)vfs.what, vfs.filter);
+		m_pVarFilterNames->addFilter(vfs.what, vfs.filter);
+	}
+
+	void LuaPlugin::handleScmpVarFilterStateNameEnd(NetworkBufferReader *pReader)
+	{
+		SCE_SLED_ASSERT(pReader != NULL);
+		/*SCMP::VarFilterStateNameEnd vfs(pReader);
+		SCE_SLED_LOG(Logging::kInfo, "[SLED] [LuaPlugin] [Var Filter State Name End] [%c]", (char)vfs.what);*/
+
+		// Filter set is complete; build the matcher now instead of on the next breakpoint
+		m_pVarFilterNames->compile();
+	}
+
+	void LuaPlugin::handleScmpVarFilterStateTypeBegin(NetworkBufferReader *pReader)
+	{
+		SCE_SLED_ASSERT(pReader != NULL);
+		const SCMP::VarFilterStateTypeBegin vfs(pReader);
+		//SCE_SLED_LOG(Logging::kInfo, "[SLED] [LuaPlugin] [SCMP] [Lua] [Var Filter State Type Begin] [%c]", (char)vfs.what);
+		switch ((char)vfs.what)
+		{
+		case 'g':
+			ResetVarFilterType(m_bGlobalVarFilterType);
+			break;
+		case 'l':
+			ResetVarFilterType(m_bLocalVarFilterType);
+			break;
+		case 'u':
+			ResetVarFilterType(m_bUpvalueVarFilterType);
+			break;
+		case 'e':
+			ResetVarFilterType(m_bEnvVarVarFilterTypes);
+			break;
+		}
+	}
+
+	void LuaPlugin::handleScmpVarFilterStateType(NetworkBufferReader *pReader)
+	{
+		SCE_SLED_ASSERT(pReader != NULL);
+		const SCMP::VarFilterStateType vfs(pReader);
+		/*SCE_SLED_LOG(Logging::kInfo, "[SLED] [LuaPlugin] [SCMP] [Lua] [Var Filter State Type] [%c] [%s,%s,%s,%s,%s,%s,%s,%s,%s]",
+			((char)vfs.what),
+			(vfs.filter[0] == 1 ? "true" : "false"),
+			(vfs.filter[1] == 1 ? "true" : "false"),
+			(vfs.filter[2] == 1 ? "true" : "false"),
 			(vfs.filter[3] == 1 ? "true" : "false"),
 			(vfs.filter[4] == 1 ? "true" : "false"),
 			(vfs.filter[5] == 1 ? "true" : "false"),
@@ -727,7 +1897,7 @@ namespace sce { namespace Sled
 			lookup.variable.bFlag = true;
 
 			const SCMP::WatchLookUpClear scmpWtchLkClr(kLuaPluginId);
-			m_pScriptMan->send((uint8_t*)&scmpWtchLkClr, scmpWtchLkClr.length);
+			sendToClient((uint8_t*)&scmpWtchLkClr, scmpWtchLkClr.length);
 		}
 
 		const bool sendWatchProjBegEnd =
@@ -738,7 +1908,7 @@ namespace sce { namespace Sled
 		if (sendWatchProjBegEnd)
 		{
 			const SCMP::WatchLookUpProjectBegin scmpWtchLkPrjBeg(kLuaPluginId);
-			m_pScriptMan->send((uint8_t*)&scmpWtchLkPrjBeg, scmpWtchLkPrjBeg.length);
+			sendToClient((uint8_t*)&scmpWtchLkPrjBeg, scmpWtchLkPrjBeg.length);
 		}
 
 		if (lookup.variable.context == LuaVariableContext::kNormal)
@@ -752,18 +1922,18 @@ namespace sce { namespace Sled
 		else if (lookup.variable.context == LuaVariableContext::kWatchCustom)
 		{
 			const SCMP::WatchLookUpCustomBegin scmpWtchLkCstmBeg(kLuaPluginId);
-			m_pScriptMan->send((uint8_t*)&scmpWtchLkCstmBeg, scmpWtchLkCstmBeg.length);
+			sendToClient((uint8_t*)&scmpWtchLkCstmBeg, scmpWtchLkCstmBeg.length);
 
 			handleScmpVarLookUpCustom(&lookup);
 
 			const SCMP::WatchLookUpCustomEnd scmpWtchLkCstmEnd(kLuaPluginId);
-			m_pScriptMan->send((uint8_t*)&scmpWtchLkCstmEnd, scmpWtchLkCstmEnd.length);
+			sendToClient((uint8_t*)&scmpWtchLkCstmEnd, scmpWtchLkCstmEnd.length);
 		}
 
 		if (sendWatchProjBegEnd)
 		{
 			const SCMP::WatchLookUpProjectEnd scmpWtchLkPrjEnd(kLuaPluginId);
-			m_pScriptMan->send((uint8_t*)&scmpWtchLkPrjEnd, scmpWtchLkPrjEnd.length);
+			sendToClient((uint8_t*)&scmpWtchLkPrjEnd, scmpWtchLkPrjEnd.length);
 		}
 	}
 
@@ -777,71 +1947,13 @@ namespace sce { namespace Sled
 		const StackReconciler recon(luaState);
 
 		if (!m_bLookUpWatches)
-		{
-			// Prepare network message based on var type
-			switch (pLookUp->variable.what)
-			{
-				case LuaVariableScope::kGlobal:
-				{
-					const SCMP::GlobalVarLookUpBegin scmp(kLuaPluginId);
-					m_pScriptMan->send((uint8_t*)&scmp, scmp.length);
-				}
-				break;
-				case LuaVariableScope::kLocal:
-				{
-					const SCMP::LocalVarLookUpBegin scmp(kLuaPluginId);
-					m_pScriptMan->send((uint8_t*)&scmp, scmp.length);
-				}
-				break;
-				case LuaVariableScope::kUpvalue:
-				{
-					const SCMP::UpvalueVarLookUpBegin scmp(kLuaPluginId);
-					m_pScriptMan->send((uint8_t*)&scmp, scmp.length);
-				}
-				break;
-				case LuaVariableScope::kEnvironment:
-				{
-					const SCMP::EnvVarLookUpBegin scmp(kLuaPluginId);
-					m_pScriptMan->send((uint8_t*)&scmp, scmp.length);
-				}
-				break;
-			}
-		}
+			sendVarLookUpBegin(pLookUp->variable.what);
 
 		// Look up the variable
 		lookupVariable(luaState, &(pLookUp->variable));
 
 		if (!m_bLookUpWatches)
-		{
-			// Prepare network message based on var type
-			switch (pLookUp->variable.what)
-			{
-				case LuaVariableScope::kGlobal:
-				{
-					const SCMP::GlobalVarLookUpEnd scmp(kLuaPluginId);
-					m_pScriptMan->send((uint8_t*)&scmp, scmp.length);
-				}
-				break;
-				case LuaVariableScope::kLocal:
-				{
-					const SCMP::LocalVarLookUpEnd scmp(kLuaPluginId);
-					m_pScriptMan->send((uint8_t*)&scmp, scmp.length);
-				}
-				break;
-				case LuaVariableScope::kUpvalue:
-				{
-					const SCMP::UpvalueVarLookUpEnd scmp(kLuaPluginId);
-					m_pScriptMan->send((uint8_t*)&scmp, scmp.length);
-				}
-				break;
-				case LuaVariableScope::kEnvironment:
-				{
-					const SCMP::EnvVarLookUpEnd scmp(kLuaPluginId);
-					m_pScriptMan->send((uint8_t*)&scmp, scmp.length);
-				}
-				break;
-			}
-		}
+			sendVarLookUpEnd(pLookUp->variable.what);
 	}
 
 	void LuaPlugin::handleScmpVarLookUpCustom(SCMP::VarLookUp *pLookUp)
@@ -867,7 +1979,7 @@ namespace sce { namespace Sled
 
 		// Re-pack and send
 		const SCMP::WatchLookUpBegin lkBeg(kLuaPluginId, lookup.what, m_pSendBuf);
-		m_pScriptMan->send(m_pSendBuf->getData(), m_pSendBuf->getSize());
+		sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
 	}
 
 	void LuaPlugin::handleScmpWatchLookUpEnd(NetworkBufferReader *pReader)
@@ -880,7 +1992,7 @@ namespace sce { namespace Sled
 
 		// Re-pack and send
 		const SCMP::WatchLookUpEnd lkEnd(kLuaPluginId, lookup.what, m_pSendBuf);
-		m_pScriptMan->send(m_pSendBuf->getData(), m_pSendBuf->getSize());
+		sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
 	}
 
 	void LuaPlugin::handleScmpCallStackLookUpPerform(NetworkBufferReader *pReader)
@@ -924,7 +2036,7 @@ namespace sce { namespace Sled
 		if (pFunc)
 		{
 			const SCMP::ProfileInfoLookUpBegin scmpPILkBeg(kLuaPluginId);
-			m_pScriptMan->send((uint8_t*)&scmpPILkBeg, scmpPILkBeg.length);
+			sendToClient((uint8_t*)&scmpPILkBeg, scmpPILkBeg.length);
 
 			ProfileEntry::ConstIterator iter(pFunc);
 			for (; iter(); ++iter)
@@ -946,11 +2058,11 @@ namespace sce { namespace Sled
 													  pEntry->getFnLine(),
 													  (int32_t)pEntry->getFnCalls(),
 													  m_pSendBuf);
-				m_pScriptMan->send(m_pSendBuf->getData(), m_pSendBuf->getSize());
+				sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
 			}
 
 			const SCMP::ProfileInfoLookUpEnd scmpPILkEnd(kLuaPluginId);
-			m_pScriptMan->send((uint8_t*)&scmpPILkEnd, scmpPILkEnd.length);
+			sendToClient((uint8_t*)&scmpPILkEnd, scmpPILkEnd.length);
 		}
 	}
 
@@ -980,4 +2092,146 @@ namespace sce { namespace Sled
 		SCE_SLED_ASSERT(pReader != NULL);
 		handleScmpLuaStateToggleLua(pReader);
 	}
+
+	void LuaPlugin::handleScmpHeapCensusPerform(NetworkBufferReader *pReader)
+	{
+		SCE_SLED_ASSERT(pReader != NULL);
+
+		// Only possible while stopped on a breakpoint
+		if (!m_pHeapCensus->isEnabled() || (m_pCurHookLuaState == NULL))
+			return;
+
+		heapCensusLua(m_pCurHookLuaState);
+		sendHeapCensus();
+	}
+
+	void LuaPlugin::handleScmpCoverageToggle(NetworkBufferReader *pReader)
+	{
+		SCE_SLED_ASSERT(pReader != NULL);
+
+		m_bCoverageRunning = !m_bCoverageRunning;
+		updateCoverage();
+	}
+
+	void LuaPlugin::handleScmpCoverageReset(NetworkBufferReader *pReader)
+	{
+		SCE_SLED_ASSERT(pReader != NULL);
+
+		resetCoverageLua();
+	}
+
+	void LuaPlugin::handleScmpCoveragePerform(NetworkBufferReader *pReader)
+	{
+		SCE_SLED_ASSERT(pReader != NULL);
+
+		// Only possible while stopped on a breakpoint
+		if (m_pCurHookLuaState == NULL)
+			return;
+
+		sendCoverageData(m_pCurHookLuaState);
+	}
+
+	void LuaPlugin::handleScmpOpcodeProfileToggle(NetworkBufferReader *pReader)
+	{
+		SCE_SLED_ASSERT(pReader != NULL);
+
+		if (!m_pOpcodeProfile->isEnabled())
+			return;
+
+		m_bOpcodeProfileRunning = !m_bOpcodeProfileRunning;
+		updateOpcodeProfile();
+	}
+
+	void LuaPlugin::handleScmpOpcodeProfileReset(NetworkBufferReader *pReader)
+	{
+		SCE_SLED_ASSERT(pReader != NULL);
+
+		resetOpcodeProfileLua();
+	}
+
+	void LuaPlugin::handleScmpOpcodeProfilePerform(NetworkBufferReader *pReader)
+	{
+		SCE_SLED_ASSERT(pReader != NULL);
+
+		// Only possible while stopped on a breakpoint
+		if (!m_pOpcodeProfile->isEnabled() || (m_pCurHookLuaState == NULL))
+			return;
+
+		opcodeProfileLua(m_pCurHookLuaState);
+		sendOpcodeProfile();
+	}
+
+	void LuaPlugin::handleScmpVarLookUpPage(NetworkBufferReader *pReader)
+	{
+		SCE_SLED_ASSERT(pReader != NULL);
+		SCMP::VarLookUpPage page(pReader, m_pWorkBuf, (uint16_t)m_iWorkBufMaxSize);
+
+		// Only possible while stopped on a breakpoint
+		if (m_pCurHookLuaState == NULL)
+			return;
+
+		const SCMP::VarLookUpPageBegin scmpPgBeg(kLuaPluginId, (uint8_t)page.variable.what, page.offset, page.limit, m_pSendBuf);
+		sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+
+		// Entries are counted in lua_next order, which is stable
+		// as long as execution stays stopped on the breakpoint
+		m_iVarPageOffset = page.offset;
+		m_iVarPageLimit = page.limit;
+		m_iVarPagePosition = 0;
+
+		handleScmpVarLookUpPageLua(&page);
+
+		const uint32_t iTotal = m_iVarPagePosition;
+
+		m_iVarPageOffset = 0;
+		m_iVarPageLimit = 0;
+		m_iVarPagePosition = 0;
+
+		const SCMP::VarLookUpPageEnd scmpPgEnd(kLuaPluginId, (uint8_t)page.variable.what, page.offset, iTotal, m_pSendBuf);
+		sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+	}
+
+	void LuaPlugin::handleScmpVarEncoding(NetworkBufferReader *pReader)
+	{
+		SCE_SLED_ASSERT(pReader != NULL);
+		const SCMP::VarEncoding scmpEnc(pReader);
+
+		// Unknown encodings get strings; the reply tells the client which one it got
+		const uint8_t iEncoding = (scmpEnc.encoding == SCMP::VarValueEncoding::kBinary)
+			? (uint8_t)SCMP::VarValueEncoding::kBinary
+			: (uint8_t)SCMP::VarValueEncoding::kString;
+
+		// Values hash differently per encoding so the next stop can't be a diff
+		if (iEncoding != m_iVarEncoding)
+			m_pVarSnapshot->clear();
+
+		m_iVarEncoding = iEncoding;
+
+		const SCMP::VarEncoding scmpReply(kLuaPluginId, m_iVarEncoding, m_pSendBuf);
+		sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+	}
+
+	void LuaPlugin::handleScmpVarLookUpById(NetworkBufferReader *pReader)
+	{
+		SCE_SLED_ASSERT(pReader != NULL);
+		SCMP::VarLookUpById lookup(pReader, m_pWorkBuf, (uint16_t)m_iWorkBufMaxSize);
+
+		// Only possible while stopped on a breakpoint
+		if (m_pCurHookLuaState == NULL)
+			return;
+
+		sendVarLookUpBegin(lookup.variable.what);
+
+		// getTableValues replies with a single "unchanged" VarTableId instead of
+		// the contents if it reaches this table and nothing was stored into it
+		m_iVarLookUpTableId = lookup.id;
+		m_iVarLookUpTableVersion = lookup.version;
+
+		handleScmpVarLookUpByIdLua(&lookup);
+
+		m_iVarLookUpTableId = 0;
+		m_iVarLookUpTableVersion = 0;
+
+		sendVarLookUpEnd(lookup.variable.what);
+	}
 }}
@@ -22,6 +22,18 @@ namespace sce { namespace Sled
 	class NetworkBufferReader;
 	class StringArray;
 	class ProfileStack;
+	class ProfileEntry;
+	class HeapCensus;
+	class CoverageWriter;
+	class OpcodeProfile;
+	class TraceTimeline;
+	class ProfileFrames;
+	class PerfWatch;
+	class ProfileFilter;
+	class GcStats;
+	class VarSnapshot;
+	class VarBudget;
+	class SendPipeline;
 	struct LuaStateParams;
 	struct MemTraceParams;
 	class Breakpoint;
@@ -30,7 +42,7 @@ namespace sce { namespace Sled
 	struct SledLuaVariable;
 
 	/// @cond
-	namespace SCMP { struct VarLookUp; }
+	namespace SCMP { struct VarLookUp; struct VarLookUpPage; struct VarLookUpById; struct VarValue; }
 
 	const static uint16_t kLuaPluginId = SCE_LIBSLEDLUAPLUGIN_ID;
 
@@ -153,21 +165,72 @@ namespace sce { namespace Sled
 		void debuggerBreak(const char *pszText);
 		inline void setVarExcludeFlags(int32_t iFlags) { m_iVarExcludeFlags = iFlags; }
 		inline int32_t getVarExcludeFlags() const { return m_iVarExcludeFlags; }
+		inline void setVarTransferMode(VarTransferMode::Enum mode) { m_iVarTransferMode = mode; }
+		inline VarTransferMode::Enum getVarTransferMode() const { return m_iVarTransferMode; }
 		bool memoryTraceNotify(void *ud, void *oldPtr, void *newPtr, std::size_t oldSize, std::size_t newSize);
 		int32_t getErrorHandlerAbsStackIndex(lua_State *luaState, int *outAbsStackIndex);
+		int32_t heapCensus(lua_State *luaState, HeapCensusSummary *pSummary);
+		void setCoverage(bool bEnable);
+		inline bool isCoverageRunning() const { return m_bCoverageRunning; }
+		void resetCoverage();
+		int32_t writeCoverage(lua_State *luaState, CoverageWriteCallback pfnWrite, void *pUserData);
+		int32_t sendCoverage(lua_State *luaState);
+		int32_t setOpcodeProfile(bool bEnable);
+		inline bool isOpcodeProfileRunning() const { return m_bOpcodeProfileRunning; }
+		void resetOpcodeProfile();
+		int32_t opcodeProfile(lua_State *luaState, OpcodeProfileSummary *pSummary);
+		int32_t writeProfileFolded(ProfileFoldedWriteCallback pfnWrite, void *pUserData, ProfileFoldedWeight::Enum weight);
+		int32_t writeProfileCapture(ProfileCaptureWriteCallback pfnWrite, void *pUserData, const char *pszBuildId);
+		int32_t profileLatency(const char *pszSource, int32_t iLineDefined, ProfileLatencySummary *pSummary) const;
+		int32_t profileFunctionTimes(const char *pszSource, int32_t iLineDefined, ProfileFunctionTimes *pTimes) const;
+		void setAllocationProfile(bool bEnable);
+		inline bool isAllocationProfileRunning() const { return m_bAllocationProfileRunning; }
+		int32_t profileAllocations(const char *pszSource, int32_t iLineDefined, ProfileFunctionAllocations *pAllocations) const;
+		int32_t profilerOverhead(ProfileOverhead *pOverhead) const;
+		int32_t profileZoneBegin(ProfileZoneSite *pSite);
+		int32_t profileZoneEnd(ProfileZoneSite *pSite);
+		int32_t profilerFrameMark();
+		int32_t profilerFrameStats(ProfileFrameStats *pStats) const;
+		int32_t profilerFrameFunctions(ProfileFrameFunctionCallback pfnCallback, void *pUserData) const;
+		int32_t profilerSlowFrame(uint16_t iIndex, ProfileSlowFrame *pFrame, ProfileFrameFunctionCallback pfnCallback, void *pUserData) const;
+		int32_t addPerfWatch(const char *pszFnName, const char *pszSource, uint32_t iBudget, uint32_t iFlags, uint16_t *pId);
+		int32_t removePerfWatch(uint16_t iId);
+		int32_t perfIncident(uint16_t iIndex, PerfIncident *pIncident) const;
+		int32_t perfIncidentCount(uint16_t *pNumKept, uint64_t *pNumTotal) const;
+		int32_t addProfileFilter(ProfileFilterKind::Enum kind, const char *pszPattern);
+		int32_t clearProfileFilters();
+		void setProfiler(bool bEnable);
+		int32_t setTraceCapture(bool bEnable);
+		inline bool isTraceCaptureRunning() const { return m_bTraceRunning; }
+		int32_t getTraceTime(uint64_t *pTime) const;
+		int32_t writeTrace(TraceWriteCallback pfnWrite, void *pUserData, uint64_t iWindowStart, uint64_t iWindowEnd);
 	private:
 		static LuaPlugin *getWhichLuaPlugin(lua_State *luaState);
 		static void hookFunc(lua_State *luaState, lua_Debug *ar);
+		static void gcHookFunc(lua_State *luaState, int iEvent, std::size_t iArg, void *pUserData);
+		static void lineMaskFunc(const char *pszSource, int iFirstLine, int iNumLines, unsigned char *pMask, void *pUserData);
+		static int profileFilterFunc(const char *pszSource, int iLineDefined, void *pUserData);
 		static int luaAssert(lua_State *luaState);
 		static int luaTTY(lua_State *luaState);
 		static int luaErrorHandler(lua_State *luaState);	
+		static int32_t sendPipelineCallback(void *pUserData, const uint8_t *pData, int32_t iSize);
+		static bool coverageSendFunc(const uint8_t *pData, int32_t iSize, void *pUserData);
 	private:
+		int32_t sendToClient(const uint8_t *pData, const int32_t& iSize);
 		int32_t ttyNotify(const char *pszMessage);
 		const char *trimFileName(const char *pszFileName);
 		void luaAssertInternal(lua_State *luaState);
 		void luaErrorHandlerInternal(lua_State *luaState);
 		void hookFunc_Profiler(lua_State *luaState, lua_Debug *ar);
 		void hookFunc_Breakpoint(lua_State *luaState, lua_Debug *ar);
+		void checkPerfWatch(lua_State *luaState, const ProfileEntry *pEntry);
+		void updateGcHooks();
+		void removeGcHook(lua_State *luaState);
+		void updateLineMasks(DebuggerMode::Enum mode);
+		void updateProfileFilters();
+		void profileFiltersChanged();
+		void updateCoverage();
+		void updateOpcodeProfile();
 		void tagFuncForLookUp(char *pszBuffer, std::size_t iBufLen, const char *pszFuncName, const char *pszFileName, const int32_t& iLine);
 		bool isLineBreakpoint(lua_State *luaState, const char *pszSource, const int32_t& iCurrentLine);
 	private:
@@ -180,6 +243,16 @@ namespace sce { namespace Sled
 	private:
 		bool			m_bLookUpWatches;
 		int32_t			m_iVarExcludeFlags;
+		VarTransferMode::Enum	m_iVarTransferMode;
+		uint8_t			m_iVarEncoding;
+
+		uint32_t		m_iVarPageOffset;
+		uint32_t		m_iVarPageLimit;
+		uint32_t		m_iVarPagePosition;
+
+		uint32_t		m_iNextTableId;
+		uint32_t		m_iVarLookUpTableId;
+		uint32_t		m_iVarLookUpTableVersion;
 
 		lua_State*		m_pCurHookLuaState;
 		lua_Debug*		m_pCurHookLuaDebug;
@@ -191,6 +264,18 @@ namespace sce { namespace Sled
 
 		NetworkBuffer	*m_pSendBuf;
 		ProfileStack	*m_pProfileStack;
+		HeapCensus		*m_pHeapCensus;
+		OpcodeProfile	*m_pOpcodeProfile;
+		TraceTimeline	*m_pTraceTimeline;
+		ProfileFrames	*m_pProfileFrames;
+		PerfWatch		*m_pPerfWatch;
+		ProfileFilter	*m_pProfileFilter;
+		GcStats			*m_pGcStats;
+		VarSnapshot		*m_pVarSnapshot;
+		bool			m_bVarSnapshotActive;
+		VarBudget		*m_pVarBudget;
+		bool			m_bVarBudgetActive;
+		SendPipeline	*m_pSendPipeline;
 
 		const uint16_t	m_iMaxLuaStates;
 		uint16_t		m_iNumLuaStates;
@@ -204,6 +289,10 @@ namespace sce { namespace Sled
 
 		bool m_bProfilerRunning;
 		bool m_bMemoryTracerRunning;
+		bool m_bCoverageRunning;
+		bool m_bOpcodeProfileRunning;
+		bool m_bTraceRunning;
+		bool m_bAllocationProfileRunning;
 
 		const uint16_t	m_iMaxBreakpoints;
 		uint16_t		m_iNumBreakpoints;
@@ -231,6 +320,9 @@ namespace sce { namespace Sled
 		inline bool isLocalVarNameFiltered(const char *pszName) const { return isVarNameFiltered(pszName, 'l'); }
 		inline bool isUpvalueVarNameFiltered(const char *pszName) const { return isVarNameFiltered(pszName, 'u'); }
 		inline bool isEnvVarVarNameFiltered(const char *pszName) const { return isVarNameFiltered(pszName, 'e'); }
+		bool isScopeVarTypeFiltered(LuaVariableScope::Enum what, int32_t iVarType) const;
+		bool isScopeVarNameFiltered(LuaVariableScope::Enum what, const char *pszName) const;
+		bool withinVarBudget(LuaVariableScope::Enum what, int32_t iStackLevel, uint32_t iOffset);
 	private:
 		void setVariable(lua_State *luaState, const LuaVariable *pVar);
 		void lookupVariable(lua_State *luaState, const LuaVariable *pVar);
@@ -239,18 +331,36 @@ namespace sce { namespace Sled
 		void lookupUpvalueVariable(lua_State *luaState, const LuaVariable *pVar);
 		void lookupEnvironmentVariable(lua_State *luaState, const LuaVariable *pVar);
 		int32_t lookUpTypeVal(lua_State *luaState, int iIndex, char *pValue, const int& iValueLen, bool bPop = true);
+		int32_t lookUpTypeVal(lua_State *luaState, int iIndex, SCMP::VarValue& value, bool bPop = true);
 		bool getStackIndexInfo(lua_State *luaState, int index, char *pName, int nameStrLen, int32_t *luaType);
 		void getTableValues(lua_State *luaState, const LuaVariable *pVar, LuaVariableScope::Enum what, int32_t iVarIndex, int32_t iTableIndex, int32_t iStackLevel);
 		bool luaPushValue(lua_State *luaState, int32_t iType, const char *pszValue);
+		inline bool nextVarPageEntry() { const uint32_t iPos = m_iVarPagePosition++; return (iPos >= m_iVarPageOffset) && ((m_iVarPageLimit == 0) || ((iPos - m_iVarPageOffset) < m_iVarPageLimit)); }
 		int32_t getGlobals(lua_State *luaState);
-		void sendGlobal(const LuaVariable *parent, const char *name, int32_t nameType, const char *value, int32_t valueType);
-		int32_t getLocals(lua_State *luaState, lua_Debug *ar, int32_t iStackLevel);
-		void sendLocal(const LuaVariable *parent, const char *name, int32_t nameType, const char *value, int32_t valueType, int32_t stackLevel, int32_t index);
+		void sendGlobal(const LuaVariable *parent, const char *name, int32_t nameType, const SCMP::VarValue& value, int32_t valueType);
+		int32_t getLocals(lua_State *luaState, lua_Debug *ar, int32_t iStackLevel, bool bNamesOnly = false);
+		void sendLocal(const LuaVariable *parent, const char *name, int32_t nameType, const SCMP::VarValue& value, int32_t valueType, int32_t stackLevel, int32_t index);
 		int32_t getUpvalues(lua_State *luaState, int32_t iFuncIndex, int32_t iStackLevel);
-		void sendUpvalue(const LuaVariable *parent, const char *name, int32_t nameType, const char *value, int32_t valueType, int32_t stackLevel, int32_t index);
+		void sendUpvalue(const LuaVariable *parent, const char *name, int32_t nameType, const SCMP::VarValue& value, int32_t valueType, int32_t stackLevel, int32_t index);
 		void getEnvironment(lua_State *luaState, int iFuncIndex, int32_t iStackLevel);
-		void sendEnvVar(const LuaVariable *pVar, const char *name, int32_t nameType, const char *value, int32_t valueType, int32_t iStackLevel);
+		void sendEnvVar(const LuaVariable *pVar, const char *name, int32_t nameType, const SCMP::VarValue& value, int32_t valueType, int32_t iStackLevel);
+		void sendVarLookUpBegin(LuaVariableScope::Enum what);
+		void sendVarLookUpEnd(LuaVariableScope::Enum what);
+		uint32_t getTableId(lua_State *luaState, int iTableIndex);
+		bool pushTableById(lua_State *luaState, uint32_t iId);
+		void clearTableIds(lua_State *luaState);
+		bool sendVarTableId(lua_State *luaState, LuaVariableScope::Enum what, int iTableIndex);
 		void handleEditAndContinue(lua_State *luaState);
+		void heapCensusLua(lua_State *luaState);
+		void heapCensusWalk(lua_State *luaState, uint16_t iDepth);
+		void sendHeapCensus();
+		void sendVarSnapshotRemoved();
+		void resetCoverageLua();
+		void writeCoverageLua(lua_State *luaState, CoverageWriter *pWriter);
+		void sendCoverageData(lua_State *luaState);
+		void resetOpcodeProfileLua();
+		void opcodeProfileLua(lua_State *luaState);
+		void sendOpcodeProfile();
 	private:
 		void handleScmpBreakpointDetails(NetworkBufferReader *pReader);
 		void handleScmpVarFilterStateNameBegin(NetworkBufferReader *pReader);
@@ -272,13 +382,26 @@ namespace sce { namespace Sled
 		void handleScmpDevCmd(NetworkBufferReader *pReader);
 		void handleScmpEditAndContinue(NetworkBufferReader *pReader);
 		void handleScmpLuaStateToggle(NetworkBufferReader *pReader);
+		void handleScmpHeapCensusPerform(NetworkBufferReader *pReader);
+		void handleScmpVarLookUpPage(NetworkBufferReader *pReader);
+		void handleScmpVarEncoding(NetworkBufferReader *pReader);
+		void handleScmpVarLookUpById(NetworkBufferReader *pReader);
+		void handleScmpCoverageToggle(NetworkBufferReader *pReader);
+		void handleScmpCoverageReset(NetworkBufferReader *pReader);
+		void handleScmpCoveragePerform(NetworkBufferReader *pReader);
+		void handleScmpOpcodeProfileToggle(NetworkBufferReader *pReader);
+		void handleScmpOpcodeProfileReset(NetworkBufferReader *pReader);
+		void handleScmpOpcodeProfilePerform(NetworkBufferReader *pReader);
 	private:
 		void handleScmpBreakpointDetailsLua(NetworkBufferReader *pReader);
 		void handleScmpVarLookUpCustomLua(SCMP::VarLookUp *pLookUp);
 		void handleScmpCallStackLookUpPerformLua(NetworkBufferReader *pReader);
 		void handleScmpProfilerToggleLua(NetworkBufferReader *pReader);
+		void toggleProfilerLua();
 		void handleScmpDevCmdLua(NetworkBufferReader *pReader);
 		void handleScmpLuaStateToggleLua(NetworkBufferReader *pReader);
+		void handleScmpVarLookUpPageLua(SCMP::VarLookUpPage *pPage);
+		void handleScmpVarLookUpByIdLua(SCMP::VarLookUpById *pLookUp);
 		/// @endcond		
 	};
 }}
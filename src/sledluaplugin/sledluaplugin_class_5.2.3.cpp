@@ -17,7 +17,16 @@
 #include "luautils.h"
 #include "scmp.h"
 #include "profilestack.h"
+#include "heapcensus.h"
+#include "gcstats.h"
 #include "varfilter.h"
+#include "numberformat.h"
+#include "coveragewriter.h"
+#include "opcodeprofile.h"
+#include "tracetimeline.h"
+#include "profileframes.h"
+#include "perfwatch.h"
+#include "profilefilter.h"
 
 #include "../sledcore/mutex.h"
 
@@ -64,15 +73,147 @@ namespace sce { namespace Sled
 			else
 				::lua_rawset(state, idx);
 		}
+
+		// Stack slots the heap census needs for each level it descends
+		const int kHeapCensusStackSlots = 4;
+
+		inline bool HeapCensusIsArrayKey(lua_State *luaState, int iKeyIndex, std::size_t iLen)
+		{
+			if (::lua_type(luaState, iKeyIndex) != LUA_TNUMBER)
+				return false;
+
+			const lua_Number key = ::lua_tonumber(luaState, iKeyIndex);
+			return (key >= 1) && (key <= (lua_Number)iLen) && (::floor(key) == key);
+		}
+
+		// The addresses of these are the registry keys of the table id maps
+		char s_tableIdsKey = 0;
+		char s_tablesByIdKey = 0;
+
+		inline bool PushTableIdMap(lua_State *luaState, void *pKey, const char *pszMode, bool bCreate)
+		{
+			::lua_pushlightuserdata(luaState, pKey);
+			::lua_rawget(luaState, LUA_REGISTRYINDEX);
+			if (::lua_type(luaState, -1) == LUA_TTABLE)
+				return true;
+
+			::lua_pop(luaState, 1);
+			if (!bCreate)
+				return false;
+
+			::lua_newtable(luaState);
+
+			// Weak so having been sent to SLED doesn't keep a table alive
+			::lua_newtable(luaState);
+			::lua_pushstring(luaState, pszMode);
+			::lua_setfield(luaState, -2, "__mode");
+			::lua_setmetatable(luaState, -2);
+
+			::lua_pushlightuserdata(luaState, pKey);
+			::lua_pushvalue(luaState, -2);
+			::lua_rawset(luaState, LUA_REGISTRYINDEX);
+			return true;
+		}
+
+		// "<userdata - 0x...>", the pointer written the same way as a C function's
+		void UserdataToText(const void *pUserdata, char *pText, int iTextLen)
+		{
+			char szPtr[SCMP::Sizes::kPtrLen];
+			NumberFormat::formatPointer(szPtr, SCMP::Sizes::kPtrLen, pUserdata);
+
+			Utilities::copyString(pText, iTextLen, "<userdata - ");
+			Utilities::appendString(pText, iTextLen, szPtr);
+			Utilities::appendString(pText, iTextLen, ">");
+		}
+
+		// Entries filled per lua_walktable call when enumerating a table
+		const int kTableWalkBatch = 64;
+
+		// Types lua_walktable hands over by value; anything else is looked up through the stack
+		inline bool TableItemIsDirect(const lua_TableItem& item)
+		{
+			switch (item.type)
+			{
+				case LUA_TNIL:
+				case LUA_TNUMBER:
+				case LUA_TBOOLEAN:
+				case LUA_TSTRING:
+					return true;
+				default:
+					return false;
+			}
+		}
+
+		// Formats a direct item the same way lookUpTypeVal formats it from the stack
+		void TableItemToText(const lua_TableItem& item, char *pText, int iTextLen)
+		{
+			switch (item.type)
+			{
+				case LUA_TNIL:
+					Utilities::copyString(pText, iTextLen, "nil");
+					break;
+				case LUA_TNUMBER:
+					NumberFormat::formatDouble(pText, iTextLen, (double)item.v.n);
+					break;
+				case LUA_TBOOLEAN:
+					Utilities::copyString(pText, iTextLen, (item.v.b ? "true" : "false"));
+					break;
+				case LUA_TSTRING:
+					Utilities::copyString(pText, iTextLen, item.v.s);
+					break;
+			}
+		}
+
+		void TableItemToVarValue(const lua_TableItem& item, SCMP::VarValue& value, bool bBinary)
+		{
+			if (bBinary)
+			{
+				switch (item.type)
+				{
+					case LUA_TNUMBER:
+						value.setNumber((double)item.v.n);
+						return;
+					case LUA_TBOOLEAN:
+						value.setBoolean(item.v.b != 0);
+						return;
+					case LUA_TSTRING:
+						value.setString(item.v.s, item.len);
+						return;
+				}
+			}
+
+			value.kind = SCMP::VarValue::kText;
+			value.truncated = 0;
+			value.length = 0;
+			TableItemToText(item, value.text, SCMP::Sizes::kVarValueLen);
+		}
+
+		void CoverageVisitor(const lua_Coverage *pCoverage, void *pUserData)
+		{
+			CoverageWriter *pWriter = static_cast<CoverageWriter*>(pUserData);
+			pWriter->addChunk(pCoverage->source, pCoverage->linedefined, pCoverage->lineinfo, pCoverage->sizelineinfo, pCoverage->counts, pCoverage->firstline, pCoverage->nlines);
+		}
+
+		void OpcodeVisitor(const char *pszSource, int iLineDefined, const std::size_t *pCounts, void *pUserData)
+		{
+			OpcodeProfile *pProfile = static_cast<OpcodeProfile*>(pUserData);
+			pProfile->addFunction(pszSource, (int32_t)iLineDefined, pCounts);
+		}
 	}
 
 	void LuaPlugin::clientDisconnectedLua()
 	{
-		// Remove hook function from any Lua states & restore debugging state
+		// Remove hook functions from any Lua states & restore debugging state
 		for (uint16_t i = 0; i < m_iNumLuaStates; i++)
 		{
 			m_pLuaStates[i].setDebugging(true);
 			::lua_sethook(m_pLuaStates[i].luaState, 0, 0, 0);
+			::lua_setlinemask(m_pLuaStates[i].luaState, NULL, NULL);
+			::lua_setprofilefilter(m_pLuaStates[i].luaState, NULL, NULL);
+			removeGcHook(m_pLuaStates[i].luaState);
+
+			// Table ids are only valid for one connection
+			clearTableIds(m_pLuaStates[i].luaState);
 		}
 	}
 
@@ -84,21 +225,24 @@ namespace sce { namespace Sled
 		lua_State* const luaState = m_pCurHookLuaState;
 		lua_Debug* const ar = m_pCurHookLuaDebug;		
 
+		// In lazy mode only local names & types are sent and SLED pages in the rest
+		const bool bLazy = (m_iVarTransferMode == VarTransferMode::kLazy);
+
 		// Get globals if not excluded
-		if ((m_iVarExcludeFlags & VarExcludeFlags::kGlobals) != VarExcludeFlags::kGlobals)
+		if (!bLazy && ((m_iVarExcludeFlags & VarExcludeFlags::kGlobals) != VarExcludeFlags::kGlobals))
 		{
 			const SCMP::GlobalVarBegin scmpGlBeg(kLuaPluginId);
-			m_pScriptMan->send((uint8_t*)&scmpGlBeg, scmpGlBeg.length);
+			sendToClient((uint8_t*)&scmpGlBeg, scmpGlBeg.length);
 
 			getGlobals(luaState);
 
 			const SCMP::GlobalVarEnd scmpGlEnd(kLuaPluginId);
-			m_pScriptMan->send((uint8_t*)&scmpGlEnd, scmpGlEnd.length);
+			sendToClient((uint8_t*)&scmpGlEnd, scmpGlEnd.length);
 		}
 
 		// Start callstack information
 		const SCMP::CallStackBegin scmpCsBeg(kLuaPluginId);
-		m_pScriptMan->send((uint8_t*)&scmpCsBeg, scmpCsBeg.length);
+		sendToClient((uint8_t*)&scmpCsBeg, scmpCsBeg.length);
 
 		// Get some more info:
 		//	n = name, namewhat
@@ -110,42 +254,42 @@ namespace sce { namespace Sled
 
 			// Notify client to create a new callstack entry for this level (0)
 			const SCMP::CallStack scmpCsLv0(kLuaPluginId, m_pszSource, ar->currentline, ar->linedefined, ar->lastlinedefined, szFuncName, 0, m_pSendBuf);
-			m_pScriptMan->send(m_pSendBuf->getData(), m_pSendBuf->getSize());
+			sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
 
 			// Get locals for this stack level (0) and send to client (if not excluded)
 			if ((m_iVarExcludeFlags & VarExcludeFlags::kLocals) != VarExcludeFlags::kLocals)
 			{
 				const SCMP::LocalVarBegin scmpLoBeg(kLuaPluginId);
-				m_pScriptMan->send((uint8_t*)&scmpLoBeg, scmpLoBeg.length);
+				sendToClient((uint8_t*)&scmpLoBeg, scmpLoBeg.length);
 
-				getLocals(luaState, ar, 0);
+				getLocals(luaState, ar, 0, bLazy);
 
 				const SCMP::LocalVarEnd scmpLoEnd(kLuaPluginId);
-				m_pScriptMan->send((uint8_t*)&scmpLoEnd, scmpLoEnd.length);
+				sendToClient((uint8_t*)&scmpLoEnd, scmpLoEnd.length);
 			}
 
 			// Get upvalues for this stack level (0) and send to client (if not excluded)
-			if ((m_iVarExcludeFlags & VarExcludeFlags::kUpvalues) != VarExcludeFlags::kUpvalues)
+			if (!bLazy && ((m_iVarExcludeFlags & VarExcludeFlags::kUpvalues) != VarExcludeFlags::kUpvalues))
 			{
 				const SCMP::UpvalueVarBegin scmpUpBeg(kLuaPluginId);
-				m_pScriptMan->send((uint8_t*)&scmpUpBeg, scmpUpBeg.length);
+				sendToClient((uint8_t*)&scmpUpBeg, scmpUpBeg.length);
 
 				getUpvalues(luaState, -1, 0);
 
 				const SCMP::UpvalueVarEnd scmpUpEnd(kLuaPluginId);
-				m_pScriptMan->send((uint8_t*)&scmpUpEnd, scmpUpEnd.length);
+				sendToClient((uint8_t*)&scmpUpEnd, scmpUpEnd.length);
 			}
 
 			// Get environment for this function and send to client if not excluded
-			if ((m_iVarExcludeFlags & VarExcludeFlags::kEnvironment) != VarExcludeFlags::kEnvironment)
+			if (!bLazy && ((m_iVarExcludeFlags & VarExcludeFlags::kEnvironment) != VarExcludeFlags::kEnvironment))
 			{
 				const SCMP::EnvVarBegin scmpEnvBeg(kLuaPluginId);
-				m_pScriptMan->send((uint8_t*)&scmpEnvBeg, scmpEnvBeg.length);
+				sendToClient((uint8_t*)&scmpEnvBeg, scmpEnvBeg.length);
 
 				getEnvironment(luaState, ::lua_gettop(luaState), 0);
 
 				const SCMP::EnvVarEnd scmpEnvEnd(kLuaPluginId);
-				m_pScriptMan->send((uint8_t*)&scmpEnvEnd, scmpEnvEnd.length);
+				sendToClient((uint8_t*)&scmpEnvEnd, scmpEnvEnd.length);
 			}
 
 			// Pop function that was pushed on by lua_getinfo
@@ -165,7 +309,7 @@ namespace sce { namespace Sled
 
 					// Notify client to create a new callstack entry for this level
 					const SCMP::CallStack scmpCsLvX(kLuaPluginId, pszLevelSource, arStack.currentline, arStack.linedefined, arStack.lastlinedefined, szFuncName, (int16_t)iLevel, m_pSendBuf);
-					m_pScriptMan->send(m_pSendBuf->getData(), m_pSendBuf->getSize());
+					sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
 
 					// Pop function pushed by lua_getinfo
 					::lua_pop(luaState, 1);
@@ -180,7 +324,7 @@ namespace sce { namespace Sled
 		}
 
 		const SCMP::CallStackEnd scmpCsEnd(kLuaPluginId);
-		m_pScriptMan->send((uint8_t*)&scmpCsEnd, scmpCsEnd.length);
+		sendToClient((uint8_t*)&scmpCsEnd, scmpCsEnd.length);
 	}
 
 	void LuaPlugin::clientDebugModeChangedLua(DebuggerMode::Enum newMode)
@@ -231,6 +375,9 @@ namespace sce { namespace Sled
 			}
 			break;
 		}
+
+		// SledDebugger only stores the new mode after notifying plugins
+		updateLineMasks(newMode);
 	}
 
 	int32_t LuaPlugin::registerLuaState(lua_State *luaState, const char *pszName)
@@ -441,20 +588,37 @@ namespace sce { namespace Sled
 			::lua_sethook(luaState, LuaPlugin::hookFunc, iProfileMask | iBreakpointMask, 0);
 		}
 
+		// Collect garbage collector pauses alongside profile information
+		if (m_bProfilerRunning)
+			::lua_setgchook(luaState, LuaPlugin::gcHookFunc, this);
+
+		// Only scripts the profile filters let through reach the hook
+		if (m_bProfilerRunning && m_pProfileFilter->hasSourceFilters())
+			::lua_setprofilefilter(luaState, LuaPlugin::profileFilterFunc, this);
+
+		updateLineMasks(m_pScriptMan->getDebuggerMode());
+
+		// Count lines from the start if coverage is already running
+		::lua_setcoverage(luaState, m_bCoverageRunning ? 1 : 0);
+		::lua_setopcodeprofile(luaState, m_bOpcodeProfileRunning ? 1 : 0);
+
+		// Coroutines it creates share its timeline ring
+		m_pTraceTimeline->acquireRing(luaState);
+
 		// If already connected to SLED notify it of this Lua state
 		if (m_pScriptMan->isDebuggerConnected())
 		{
 			const SCMP::LuaStateBegin scmpLuaStBeg(kLuaPluginId);
-			m_pScriptMan->send((uint8_t*)&scmpLuaStBeg, scmpLuaStBeg.length);
+			sendToClient((uint8_t*)&scmpLuaStBeg, scmpLuaStBeg.length);
 
 			char szTemp[SCMP::Sizes::kPtrLen];
-			StringUtilities::copyString(szTemp, SCMP::Sizes::kPtrLen, "0x%p", luaState);
+			NumberFormat::formatPointer(szTemp, SCMP::Sizes::kPtrLen, luaState);
 
 			const SCMP::LuaStateAdd scmpLuaSt(kLuaPluginId, szTemp, pszName, true, m_pSendBuf);
-			m_pScriptMan->send(m_pSendBuf->getData(), m_pSendBuf->getSize());
+			sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
 
 			const SCMP::LuaStateEnd scmpLuaStEnd(kLuaPluginId);
-			m_pScriptMan->send((uint8_t*)&scmpLuaStEnd, scmpLuaStEnd.length);
+			sendToClient((uint8_t*)&scmpLuaStEnd, scmpLuaStEnd.length);
 		}				
 
 		return SCE_SLED_ERROR_OK;
@@ -512,21 +676,33 @@ namespace sce { namespace Sled
 
 		// Remove any hooks
 		::lua_sethook(luaState, NULL, 0, 0);
+		::lua_setcoverage(luaState, 0);
+		::lua_setopcodeprofile(luaState, 0);
+		m_pTraceTimeline->releaseRing(luaState);
+
+		// Remove the GC hook, line masks & profile filter, which are shared with
+		// any other registered threads of the same state, then put them back for those
+		removeGcHook(luaState);
+		updateGcHooks();
+		::lua_setlinemask(luaState, NULL, NULL);
+		updateLineMasks(m_pScriptMan->getDebuggerMode());
+		::lua_setprofilefilter(luaState, NULL, NULL);
+		updateProfileFilters();
 
 		// If SLED connected notify to remove this Lua state
 		if (m_pScriptMan->isDebuggerConnected())
 		{
 			const SCMP::LuaStateBegin scmpLuaStBeg(kLuaPluginId);
-			m_pScriptMan->send((uint8_t*)&scmpLuaStBeg, scmpLuaStBeg.length);
+			sendToClient((uint8_t*)&scmpLuaStBeg, scmpLuaStBeg.length);
 
 			char szTemp[SCMP::Sizes::kPtrLen];
-			StringUtilities::copyString(szTemp, SCMP::Sizes::kPtrLen, "0x%p", luaState);
+			NumberFormat::formatPointer(szTemp, SCMP::Sizes::kPtrLen, luaState);
 
 			const SCMP::LuaStateRemove scmpLuaSt(kLuaPluginId, szTemp, m_pSendBuf);
-			m_pScriptMan->send(m_pSendBuf->getData(), m_pSendBuf->getSize());
+			sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
 
 			const SCMP::LuaStateEnd scmpLuaStEnd(kLuaPluginId);
-			m_pScriptMan->send((uint8_t*)&scmpLuaStEnd, scmpLuaStEnd.length);
+			sendToClient((uint8_t*)&scmpLuaStEnd, scmpLuaStEnd.length);
 		}
 
 		return SCE_SLED_ERROR_OK;
@@ -566,6 +742,7 @@ namespace sce { namespace Sled
 
 			// Notify to stop
 			m_bAssertBreakpoint = true;
+			updateLineMasks(m_pScriptMan->getDebuggerMode());
 
 			// Optionally, send text to SLED
 			if (pszText && (std::strlen(pszText) > 0))
@@ -604,6 +781,7 @@ namespace sce { namespace Sled
 		{
 			// Notify to stop (eventually)
 			m_bAssertBreakpoint = true;
+			updateLineMasks(m_pScriptMan->getDebuggerMode());
 
 			// Optionally, send text to SLED
 			if (pszText && (std::strlen(pszText) > 0))
@@ -706,6 +884,126 @@ namespace sce { namespace Sled
 		}
 	}
 
+	void LuaPlugin::gcHookFunc(lua_State *luaState, int iEvent, std::size_t iArg, void *pUserData)
+	{
+		SCE_SLEDUNUSED(luaState);
+		SCE_SLED_ASSERT(pUserData != NULL);
+
+		// Runs inside the collector so must not touch the Lua state
+		LuaPlugin *pPlugin = static_cast<LuaPlugin*>(pUserData);
+		if (!pPlugin->m_bProfilerRunning)
+			return;
+
+		switch (iEvent)
+		{
+		case LUA_GCEVSTEPBEGIN:
+			pPlugin->m_pGcStats->stepBegin();
+			break;
+		case LUA_GCEVSTEPEND:
+			pPlugin->m_pGcStats->stepEnd();
+			break;
+		case LUA_GCEVATOMICBEGIN:
+			pPlugin->m_pGcStats->atomicBegin();
+			break;
+		case LUA_GCEVATOMICEND:
+			pPlugin->m_pGcStats->atomicEnd();
+			break;
+		case LUA_GCEVSWEEP:
+			pPlugin->m_pGcStats->swept(iArg);
+			break;
+		case LUA_GCEVCYCLEEND:
+			pPlugin->m_pGcStats->cycleEnd(iArg);
+			break;
+		}
+	}
+
+	void LuaPlugin::updateGcHooks()
+	{
+		// Several registered states can be threads sharing one collector
+		// so clear them all before adding back the ones still wanted
+		for (uint16_t i = 0; i < m_iNumLuaStates; i++)
+			removeGcHook(m_pLuaStates[i].luaState);
+
+		if (!m_bProfilerRunning)
+			return;
+
+		for (uint16_t i = 0; i < m_iNumLuaStates; i++)
+		{
+			// Skip states not being debugged
+			if (!m_pLuaStates[i].isDebugging())
+				continue;
+
+			::lua_setgchook(m_pLuaStates[i].luaState, LuaPlugin::gcHookFunc, this);
+		}
+	}
+
+	void LuaPlugin::removeGcHook(lua_State *luaState)
+	{
+		void *pUserData = NULL;
+
+		// Leave alone any hook that isn't ours
+		if ((::lua_getgchook(luaState, &pUserData) == LuaPlugin::gcHookFunc) && (pUserData == this))
+			::lua_setgchook(luaState, NULL, NULL);
+	}
+
+	void LuaPlugin::updateLineMasks(DebuggerMode::Enum mode)
+	{
+		// Only breakpoints can stop execution so the VM can skip the line
+		// hook on other lines; stepping & forced stops need every line
+		const bool bMasked =
+			(m_iNumBreakpoints != 0) &&
+			(mode == DebuggerMode::kNormal) &&
+			!m_bAssertBreakpoint &&
+			!m_bErrorBreakpoint;
+
+		for (uint16_t i = 0; i < m_iNumLuaStates; i++)
+		{
+			// Skip states not being debugged
+			if (!m_pLuaStates[i].isDebugging())
+				continue;
+
+			// Also discards masks built for the previous breakpoints
+			if (bMasked)
+				::lua_setlinemask(m_pLuaStates[i].luaState, LuaPlugin::lineMaskFunc, this);
+			else
+				::lua_setlinemask(m_pLuaStates[i].luaState, NULL, NULL);
+		}
+	}
+
+	void LuaPlugin::updateProfileFilters()
+	{
+		// Threads of one state share the filter, so as with the GC hook
+		// clear them all before setting it for the states still profiled
+		for (uint16_t i = 0; i < m_iNumLuaStates; i++)
+			::lua_setprofilefilter(m_pLuaStates[i].luaState, NULL, NULL);
+
+		if (!m_bProfilerRunning || !m_pProfileFilter->hasSourceFilters())
+			return;
+
+		for (uint16_t i = 0; i < m_iNumLuaStates; i++)
+		{
+			// Skip states not being debugged
+			if (!m_pLuaStates[i].isDebugging())
+				continue;
+
+			// Also discards what each function was told by the previous filters
+			::lua_setprofilefilter(m_pLuaStates[i].luaState, LuaPlugin::profileFilterFunc, this);
+		}
+	}
+
+	void LuaPlugin::updateCoverage()
+	{
+		// Threads these states create from now on inherit the setting
+		for (uint16_t i = 0; i < m_iNumLuaStates; i++)
+			::lua_setcoverage(m_pLuaStates[i].luaState, m_bCoverageRunning ? 1 : 0);
+	}
+
+	void LuaPlugin::updateOpcodeProfile()
+	{
+		for (uint16_t i = 0; i < m_iNumLuaStates; i++)
+			::lua_setopcodeprofile(m_pLuaStates[i].luaState, m_bOpcodeProfileRunning ? 1 : 0);
+	}
+
 	int LuaPlugin::luaAssert(lua_State *luaState)
 	{
 		SCE_SLED_ASSERT(luaState != NULL);
@@ -747,6 +1045,15 @@ namespace sce { namespace Sled
 			// Pull out strings
 			for (int i = 1; i <= iCount; i++)
 			{
+				if (::lua_type(luaState, i) == LUA_TNUMBER)
+				{
+					// Avoid converting the argument to a Lua string
+					char szNumber[NumberFormat::kMaxDoubleLen];
+					NumberFormat::formatDouble(szNumber, sizeof(szNumber), (double)::lua_tonumber(luaState, i));
+					pWhichPlugin->ttyNotify(szNumber);
+					continue;
+				}
+
 				const char *pszString = ::lua_tostring(luaState, i);
 				if (pszString != NULL)
 				{
@@ -855,37 +1162,66 @@ namespace sce { namespace Sled
 		SCE_SLED_ASSERT(luaState != NULL);
 		SCE_SLED_ASSERT(ar != NULL);
 
-		// Get info - fills out stuff in activation record:
-		// S = short_src, source, linedefined, lastlinedefined, what
-		// n = name, namewhat
-		::lua_getinfo(luaState, "Sn", ar);
+		ProfileEntry *pEntry = 0;
+		uint32_t iTraceType = TraceEvent::kEnter;
 
-		const char *pszSource = 0;
-
-		// Grab source file name (and if C code don't trim it)
-		if ((ar->what) && (ar->what[0] == 'C'))
-		{
-			pszSource = ar->source;
-		}
-		else
+		if (ar->event == LUA_HOOKCALL)
 		{
-			pszSource = trimFileName(ar->source);
-		}
+			// Get info - fills out stuff in activation record:
+			// S = short_src, source, linedefined, lastlinedefined, what
+			// n = name, namewhat
+			::lua_getinfo(luaState, "Sn", ar);
 
-		const std::size_t len = Sled::SCMP::Base::kStringLen;
+			// The VM already left out scripts the profile filters reject; names
+			// depend on the call site so those filters are checked here, and
+			// the VM is told to skip the matching return as well
+			if (m_pProfileFilter->hasFunctionFilters() && !m_pProfileFilter->isFunctionProfiled(ar->name ? ar->name : ""))
+			{
+				::lua_rejectprofilecall(luaState);
+				return;
+			}
 
-		// Get function name or indicate that SLED should look up the function
-		char szFuncName[len];
-		tagFuncForLookUp(szFuncName, len, ar->name, pszSource, ar->linedefined);
+			const char *pszSource = 0;
 
-		if (ar->event == LUA_HOOKCALL)
-		{
-			m_pProfileStack->enterFn(szFuncName, pszSource, ar->linedefined);
+			// Grab source file name (and if C code don't trim it)
+			if ((ar->what) && (ar->what[0] == 'C'))
+			{
+				pszSource = ar->source;
+			}
+			else
+			{
+				pszSource = trimFileName(ar->source);
+			}
+
+			const std::size_t len = Sled::SCMP::Base::kStringLen;
+
+			// Get function name or indicate that SLED should look up the function
+			char szFuncName[len];
+			tagFuncForLookUp(szFuncName, len, ar->name, pszSource, ar->linedefined);
+
+			pEntry = m_pProfileStack->enterFn(szFuncName, pszSource, ar->linedefined);
 		}
 		else
 		{
-			m_pProfileStack->leaveFn(szFuncName, pszSource, ar->linedefined);
+			// The VM only reports returns whose call it reported, so this is
+			// always the function on top. Looking it up by name wouldn't work
+			// for frames reused by tail calls, which return under another name.
+			pEntry = m_pProfileStack->leaveTop();
+			iTraceType = TraceEvent::kLeave;
+		}
+
+		if (m_bTraceRunning && pEntry)
+		{
+			const uint32_t iFn = m_pProfileStack->getFnIndex(pEntry);
+
+			// Coroutines aren't registered themselves; theirs is the ring of their state
+			if (!m_pTraceTimeline->record(luaState, iTraceType, iFn))
+				m_pTraceTimeline->record(::lua_mainthread(luaState), iTraceType, iFn);
 		}
+
+		// Watches only look at calls as they return
+		if ((iTraceType == TraceEvent::kLeave) && pEntry && m_pPerfWatch->hasWatches())
+			checkPerfWatch(luaState, pEntry);
 	}
 
 	void LuaPlugin::hookFunc_Breakpoint(lua_State *luaState, lua_Debug *ar)
@@ -954,6 +1290,8 @@ namespace sce { namespace Sled
 
 			// Pause profile timer & store some stuff
 			m_pProfileStack->preBreakpoint();
+			m_pTraceTimeline->preBreakpoint();
+			m_pProfileFrames->preBreakpoint();
 			m_pCurHookLuaState = luaState;
 			m_pCurHookLuaDebug = ar;
 			m_bHitBreakpoint = true;
@@ -969,6 +1307,8 @@ namespace sce { namespace Sled
 			// When control comes back to this function the breakpoint is over so we can
 			// re-continue the profile timer and clear out some stuff
 			m_pProfileStack->postBreakpoint();
+			m_pTraceTimeline->postBreakpoint();
+			m_pProfileFrames->postBreakpoint();
 			m_pCurHookLuaState = 0;
 			m_pCurHookLuaDebug = 0;
 			m_bHitBreakpoint = false;
@@ -1404,13 +1744,13 @@ namespace sce { namespace Sled
 		}
 		else
 		{
-			char szValue[SCMP::Sizes::kVarValueLen];
-			const int32_t iType = lookUpTypeVal(luaState, -1, szValue, SCMP::Sizes::kVarValueLen);
+			SCMP::VarValue varValue;
+			const int32_t iType = lookUpTypeVal(luaState, -1, varValue);
 			int32_t iKeyType = pVar->nameType;
 			if (pVar->numKeyValues != 0)
 				iKeyType = pVar->hKeyValues[pVar->numKeyValues - 1].type;
 
-			sendGlobal(pVar, lastName, iKeyType, szValue, iType);
+			sendGlobal(pVar, lastName, iKeyType, varValue, iType);
 		}
 	}
 
@@ -1449,13 +1789,13 @@ namespace sce { namespace Sled
 			}
 			else
 			{
-				char szValue[SCMP::Sizes::kVarValueLen];
-				const int32_t iType = lookUpTypeVal(luaState, -1, szValue, SCMP::Sizes::kVarValueLen);
+				SCMP::VarValue varValue;
+				const int32_t iType = lookUpTypeVal(luaState, -1, varValue);
 				int32_t iKeyType = pVar->nameType;
 				if (pVar->numKeyValues != 0)
 					iKeyType = pVar->hKeyValues[pVar->numKeyValues - 1].type;
 
-				sendLocal(pVar, lastName, iKeyType, szValue, iType, pVar->level, pVar->index);
+				sendLocal(pVar, lastName, iKeyType, varValue, iType, pVar->level, pVar->index);
 			}
 		}
 	}
@@ -1502,13 +1842,13 @@ namespace sce { namespace Sled
 			}
 			else
 			{
-				char szValue[SCMP::Sizes::kVarValueLen];
-				const int32_t iType = lookUpTypeVal(luaState, -1, szValue, SCMP::Sizes::kVarValueLen);
+				SCMP::VarValue varValue;
+				const int32_t iType = lookUpTypeVal(luaState, -1, varValue);
 				int32_t iKeyType = pVar->nameType;
 				if (pVar->numKeyValues != 0)
 					iKeyType = pVar->hKeyValues[pVar->numKeyValues - 1].type;
 
-				sendUpvalue(pVar, lastName, iKeyType, szValue, iType, pVar->level, pVar->index);
+				sendUpvalue(pVar, lastName, iKeyType, varValue, iType, pVar->level, pVar->index);
 			}
 		}
 	}
@@ -1558,13 +1898,13 @@ namespace sce { namespace Sled
 		}
 		else
 		{
-			char szValue[SCMP::Sizes::kVarValueLen];
-			const int32_t iType = lookUpTypeVal(luaState, -1, szValue, SCMP::Sizes::kVarValueLen);
+			SCMP::VarValue varValue;
+			const int32_t iType = lookUpTypeVal(luaState, -1, varValue);
 			int32_t iKeyType = pVar->nameType;
 			if (pVar->numKeyValues != 0)
 				iKeyType = pVar->hKeyValues[pVar->numKeyValues - 1].type;
 
-			sendEnvVar(pVar, lastName, iKeyType, szValue, iType, pVar->level);
+			sendEnvVar(pVar, lastName, iKeyType, varValue, iType, pVar->level);
 		}
 	}
 
@@ -1586,21 +1926,9 @@ namespace sce { namespace Sled
 				break;
 
 			case LUA_TNUMBER:
-			{
-				const StackReconciler recon(L);
-				::lua_pushvalue(L, iIndex);
-
-				lua_Number num = ::lua_tonumber(L, -1);
-				if (floor(num) == num)
-				{
-					StringUtilities::copyString(pValue, iValueLen, "%lu", (unsigned long)num);
-				}
-				else
-				{
-					Utilities::copyString(pValue, iValueLen, ::lua_tostring(L, -1));
-				}
-			}
-			break;
+				// Format directly; lua_tostring would allocate a Lua string
+				NumberFormat::formatDouble(pValue, iValueLen, (double)::lua_tonumber(L, iIndex));
+				break;
 
 			case LUA_TSTRING:
 			{		
@@ -1622,7 +1950,7 @@ namespace sce { namespace Sled
 			{
 				lua_CFunction pFunc = ::lua_tocfunction(L, iIndex);			
 				if (pFunc != NULL)
-					StringUtilities::copyString(pValue, iValueLen, "0x%p", pFunc);
+					NumberFormat::formatPointer(pValue, iValueLen, (const void*)pFunc);
 				else
 					Utilities::copyString(pValue, iValueLen, "Lua function");
 			}
@@ -1678,8 +2006,7 @@ namespace sce { namespace Sled
 							const int iRet = ::lua_pcall(L, 1, 1, 0);
 							if (iRet == 0)
 							{
-								const char *pszStr = ::lua_tostring(L, -1);
-								StringUtilities::copyString(pValue, iValueLen, "<userdata - 0x%x>", pszStr);
+								UserdataToText(::lua_touserdata(L, fixedIndex), pValue, iValueLen);
 							}
 							else
 							{
@@ -1702,8 +2029,7 @@ namespace sce { namespace Sled
 					if (!hasUserdataToStringCallback)
 					{
 						// Set the pointer as string.
-						void *pLuaUserData = ::lua_touserdata(L, fixedIndex);
-						StringUtilities::copyString(pValue, iValueLen, "<userdata - 0x%x>", pLuaUserData);
+						UserdataToText(::lua_touserdata(L, fixedIndex), pValue, iValueLen);
 					}
 				}
 			}
@@ -1767,6 +2093,58 @@ namespace sce { namespace Sled
 		return iType;
 	}
 
+	int32_t LuaPlugin::lookUpTypeVal(lua_State *L, int iIndex, SCMP::VarValue& value, bool bPop /* = true */)
+	{
+		SCE_SLED_ASSERT(L != NULL);
+
+		if (!L)
+			return -1;
+
+		// Binary encoding sends numbers, booleans & strings without formatting them
+		if (m_iVarEncoding == SCMP::VarValueEncoding::kBinary)
+		{
+			const int32_t iType = ::lua_type(L, iIndex);
+			bool bTyped = true;
+
+			switch (iType)
+			{
+				case LUA_TNUMBER:
+					value.setNumber((double)::lua_tonumber(L, iIndex));
+					break;
+
+				case LUA_TBOOLEAN:
+					value.setBoolean(::lua_toboolean(L, iIndex) != 0);
+					break;
+
+				case LUA_TSTRING:
+				{
+					// No conversion happens on a string so lua_next is safe
+					std::size_t len = 0;
+					const char *pszString = ::lua_tolstring(L, iIndex, &len);
+					value.setString(pszString, len);
+				}
+				break;
+
+				default:
+					bTyped = false;
+					break;
+			}
+
+			if (bTyped)
+			{
+				if (bPop)
+					::lua_pop(L, 1);
+
+				return iType;
+			}
+		}
+
+		value.kind = SCMP::VarValue::kText;
+		value.truncated = 0;
+		value.length = 0;
+		return lookUpTypeVal(L, iIndex, value.text, SCMP::Sizes::kVarValueLen, bPop);
+	}
+
 	bool LuaPlugin::getStackIndexInfo(lua_State *luaState, int index, char *pName, int nameStrLen, int32_t *luaType)
 	{
 		SCE_SLED_ASSERT(luaState != NULL);
@@ -1789,82 +2167,195 @@ namespace sce { namespace Sled
 
 		int32_t keyLuaType = 0;
 		char szKey[SCMP::Sizes::kVarNameLen];
-		char szValue[SCMP::Sizes::kVarValueLen];
+		SCMP::VarValue varValue;
 
 		const int keyIndex = -2;
 		const int valIndex = -1;	
 
-		::lua_pushnil(luaState);
-		while (::lua_next(luaState, iTableIndex) != 0)
-		{		
-			if (getStackIndexInfo(luaState, keyIndex, szKey, SCMP::Sizes::kVarNameLen, &keyLuaType))
+		// iTableIndex is where the table is once the first key has been pushed
+		const int iAbsTableIndex = (iTableIndex < 0) ? (::lua_gettop(luaState) + iTableIndex + 2) : iTableIndex;
+		if (!sendVarTableId(luaState, what, iAbsTableIndex))
+			return;
+
+		const bool bBinary = (m_iVarEncoding == SCMP::VarValueEncoding::kBinary);
+
+		// Walk the table in batches so numbers, booleans & strings never go
+		// through the stack; other values are pushed one slot at a time
+		lua_TableEntry entries[kTableWalkBatch];
+		unsigned int iCursor = 0;
+		int iNumEntries;
+
+		while ((iNumEntries = ::lua_walktable(luaState, iAbsTableIndex, &iCursor, entries, kTableWalkBatch)) > 0)
+		{
+			for (int i = 0; i < iNumEntries; i++)
 			{
-				// don't pop the value in lookUpTypeVal
-				const int32_t iType = lookUpTypeVal(luaState, valIndex, szValue, SCMP::Sizes::kVarValueLen, false);
+				const lua_TableEntry& entry = entries[i];
 
-				switch (what)
+				// Check the filters on the raw value type and the key before formatting the value
+				if (!nextVarPageEntry() || isScopeVarTypeFiltered(what, entry.value.type))
+					continue;
+
+				const bool bDirect = TableItemIsDirect(entry.key) && TableItemIsDirect(entry.value);
+				if (bDirect)
 				{
-					case LuaVariableScope::kGlobal:
-						// Check filter before sending
-						if (!isGlobalVarTypeFiltered(iType) && !isGlobalVarNameFiltered(szKey))
-						{
-							sendGlobal(pVar, szKey, keyLuaType, szValue, iType);
-						}
-						break;
-					case LuaVariableScope::kLocal:
-						// Check filter before sending
-						if (!isLocalVarTypeFiltered(iType) && !isLocalVarNameFiltered(szKey))
-						{
-							sendLocal(pVar, szKey, keyLuaType, szValue, iType, iStackLevel, iVarIndex);
-						}
-						break;			
-					case LuaVariableScope::kUpvalue:
-						// Check filter before sending
-						if (!isUpvalueVarTypeFiltered(iType) && !isUpvalueVarNameFiltered(szKey))
-						{
-							sendUpvalue(pVar, szKey, keyLuaType, szValue, iType, iStackLevel, iVarIndex);
-						}
-						break;
-					case LuaVariableScope::kEnvironment:
-						// Check filter before sending
-						if (!isEnvVarVarTypeFiltered(iType) && !isEnvVarVarNameFiltered(szKey))
-						{
-							sendEnvVar(pVar, szKey, keyLuaType, szValue, iType, iStackLevel);
-						}
+					TableItemToText(entry.key, szKey, SCMP::Sizes::kVarNameLen);
+					keyLuaType = entry.key.type;
+				}
+				else
+				{
+					if (!::lua_pushtableslot(luaState, iAbsTableIndex, entry.slot))
+						continue;
+
+					getStackIndexInfo(luaState, keyIndex, szKey, SCMP::Sizes::kVarNameLen, &keyLuaType);
+				}
+
+				if (!isScopeVarNameFiltered(what, szKey))
+				{
+					int32_t iType = entry.value.type;
+
+					if (bDirect)
+						TableItemToVarValue(entry.value, varValue, bBinary);
+					else
+						// don't pop the value in lookUpTypeVal
+						iType = lookUpTypeVal(luaState, valIndex, varValue, false);
+
+					switch (what)
+					{
+						case LuaVariableScope::kGlobal:
+							sendGlobal(pVar, szKey, keyLuaType, varValue, iType);
+							break;
+						case LuaVariableScope::kLocal:
+							sendLocal(pVar, szKey, keyLuaType, varValue, iType, iStackLevel, iVarIndex);
+							break;
+						case LuaVariableScope::kUpvalue:
+							sendUpvalue(pVar, szKey, keyLuaType, varValue, iType, iStackLevel, iVarIndex);
+							break;
+						case LuaVariableScope::kEnvironment:
+							sendEnvVar(pVar, szKey, keyLuaType, varValue, iType, iStackLevel);
+							break;
+					}
+				}
+
+				if (!bDirect)
+				{
+					// Pop the key and value
+					::lua_pop(luaState, 2);
+
+					// A __tostring metamethod can change the table or collect the
+					// strings the rest of the batch points at so walk again
+					if ((entry.key.type == LUA_TUSERDATA) || (entry.value.type == LUA_TUSERDATA))
+					{
+						iCursor = entry.slot + 1;
 						break;
+					}
 				}
 			}
-
-			// Pop the value (leaving original key alone)
-			::lua_pop(luaState, 1);
 		}
 	}
 
-	bool LuaPlugin::luaPushValue(lua_State *luaState, int32_t iType, const char *pszValue)
+	uint32_t LuaPlugin::getTableId(lua_State *luaState, int iTableIndex)
 	{
-		bool bPushed = true;
+		SCE_SLED_ASSERT(luaState != NULL);
+		SCE_SLED_ASSERT(iTableIndex > 0);
 
-		switch (iType)
-		{
-			case LUA_TNUMBER:
-				::lua_pushnumber(luaState, (::lua_Number)std::atof(pszValue));
-				break;
+		const StackReconciler recon(luaState);
 
-			case LUA_TBOOLEAN:
-				::lua_pushboolean(luaState, std::atoi(pszValue));
-				break;
+		// table -> id at -2, id -> table at -1
+		if (!PushTableIdMap(luaState, &s_tableIdsKey, "k", true) ||
+			!PushTableIdMap(luaState, &s_tablesByIdKey, "v", true))
+			return 0;
 
-			case LUA_TSTRING:
-				::lua_pushstring(luaState, pszValue);
-				break;
+		::lua_pushvalue(luaState, iTableIndex);
+		::lua_rawget(luaState, -3);
+		if (::lua_type(luaState, -1) == LUA_TNUMBER)
+			return (uint32_t)::lua_tointeger(luaState, -1);
 
-			default:
-				bPushed = false;
-				break;
-		}
+		::lua_pop(luaState, 1);
 
-		return bPushed;
-	}
+		const uint32_t iId = m_iNextTableId++;
+
+		::lua_pushvalue(luaState, iTableIndex);
+		::lua_pushinteger(luaState, (lua_Integer)iId);
+		::lua_rawset(luaState, -4);
+
+		::lua_pushinteger(luaState, (lua_Integer)iId);
+		::lua_pushvalue(luaState, iTableIndex);
+		::lua_rawset(luaState, -3);
+
+		return iId;
+	}
+
+	bool LuaPlugin::pushTableById(lua_State *luaState, uint32_t iId)
+	{
+		SCE_SLED_ASSERT(luaState != NULL);
+
+		if (!PushTableIdMap(luaState, &s_tablesByIdKey, "v", false))
+			return false;
+
+		::lua_pushinteger(luaState, (lua_Integer)iId);
+		::lua_rawget(luaState, -2);
+		::lua_remove(luaState, -2);
+
+		// Gone if the table has been collected since it was sent
+		if (::lua_type(luaState, -1) == LUA_TTABLE)
+			return true;
+
+		::lua_pop(luaState, 1);
+		return false;
+	}
+
+	void LuaPlugin::clearTableIds(lua_State *luaState)
+	{
+		SCE_SLED_ASSERT(luaState != NULL);
+
+		::lua_pushlightuserdata(luaState, &s_tableIdsKey);
+		::lua_pushnil(luaState);
+		::lua_rawset(luaState, LUA_REGISTRYINDEX);
+
+		::lua_pushlightuserdata(luaState, &s_tablesByIdKey);
+		::lua_pushnil(luaState);
+		::lua_rawset(luaState, LUA_REGISTRYINDEX);
+	}
+
+	bool LuaPlugin::sendVarTableId(lua_State *luaState, LuaVariableScope::Enum what, int iTableIndex)
+	{
+		const uint32_t iId = getTableId(luaState, iTableIndex);
+		const uint32_t iVersion = ::lua_tableversion(luaState, iTableIndex);
+
+		// Nothing stored into the table SLED is looking up by id since it got the contents
+		const bool bUnchanged = (iId != 0) && (iId == m_iVarLookUpTableId) && (iVersion == m_iVarLookUpTableVersion);
+
+		const SCMP::VarTableId scmpTblId(kLuaPluginId, (uint8_t)what, iId, iVersion, bUnchanged, m_pSendBuf);
+		sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+
+		return !bUnchanged;
+	}
+
+	bool LuaPlugin::luaPushValue(lua_State *luaState, int32_t iType, const char *pszValue)
+	{
+		bool bPushed = true;
+
+		switch (iType)
+		{
+			case LUA_TNUMBER:
+				::lua_pushnumber(luaState, (::lua_Number)std::atof(pszValue));
+				break;
+
+			case LUA_TBOOLEAN:
+				::lua_pushboolean(luaState, std::atoi(pszValue));
+				break;
+
+			case LUA_TSTRING:
+				::lua_pushstring(luaState, pszValue);
+				break;
+
+			default:
+				bPushed = false;
+				break;
+		}
+
+		return bPushed;
+	}
 
 	int32_t LuaPlugin::getGlobals(lua_State *luaState)
 	{	
@@ -1873,59 +2364,124 @@ namespace sce { namespace Sled
 		const StackReconciler recon(luaState);
 
 		::lua_pushglobaltable(luaState);
-		::lua_pushnil(luaState);
+		const int iTable = ::lua_gettop(luaState);
 
-		while (::lua_next(luaState, -2) != 0)
-		{
-			iGlobals++;
+		// Offsets SLED can page in the rest from if the budget runs out
+		const uint32_t iFirstEntry = m_iVarPagePosition;
+
+		const bool bBinary = (m_iVarEncoding == SCMP::VarValueEncoding::kBinary);
 
-			// Key is index -2
-			if (::lua_isstring(luaState, -2))
+		// Walk the table in batches so numbers, booleans & strings never go
+		// through the stack; other values are pushed one slot at a time
+		lua_TableEntry entries[kTableWalkBatch];
+		unsigned int iCursor = 0;
+		int iNumEntries;
+		bool bExhausted = false;
+
+		while (!bExhausted && ((iNumEntries = ::lua_walktable(luaState, iTable, &iCursor, entries, kTableWalkBatch)) > 0))
+		{
+			for (int i = 0; i < iNumEntries; i++)
 			{
-				// Make a copy since lua_tostring
-				// modifies it and will make lua_next
-				// fail because of the modification
-				::lua_pushvalue(luaState, -2);
+				const lua_TableEntry& entry = entries[i];
 
-				// Modify the newly created key copy
-				const char *name = ::lua_tostring(luaState, -1);
+				if (!withinVarBudget(LuaVariableScope::kGlobal, 0, m_iVarPagePosition - iFirstEntry))
+				{
+					bExhausted = true;
+					break;
+				}
 
-				char value[SCMP::Sizes::kVarValueLen];
+				iGlobals++;
 
-				// Gets info about the value and also pops
-				// the top element which is the key copy
-				const int32_t valueType = lookUpTypeVal(luaState, -2, value, SCMP::Sizes::kVarValueLen);
+				// Only string & number keys are names
+				if (((entry.key.type != LUA_TSTRING) && (entry.key.type != LUA_TNUMBER)) || !nextVarPageEntry())
+					continue;
 
-				// If filtered ignore sending
-				if (!isGlobalVarTypeFiltered(valueType) && !isGlobalVarNameFiltered(name))
-					sendGlobal(NULL, name, ::lua_type(luaState, -2), value, valueType);
-			}
+				// Check the type filter on the raw value before doing any other work
+				const int32_t iType = entry.value.type;
+				if (isGlobalVarTypeFiltered(iType))
+					continue;
 
-			// Pop the value (leaving the original key alone)
-			::lua_pop(luaState, 1);
+				char szName[SCMP::Sizes::kVarNameLen];
+				TableItemToText(entry.key, szName, SCMP::Sizes::kVarNameLen);
+
+				// If filtered ignore formatting and sending
+				if (isGlobalVarNameFiltered(szName))
+					continue;
+
+				SCMP::VarValue varValue;
+
+				if (TableItemIsDirect(entry.value))
+				{
+					TableItemToVarValue(entry.value, varValue, bBinary);
+				}
+				else
+				{
+					if (!::lua_pushtableslot(luaState, iTable, entry.slot))
+						continue;
+
+					// Gets info about the value and pops it, then pop the key
+					lookUpTypeVal(luaState, -1, varValue);
+					::lua_pop(luaState, 1);
+				}
+
+				sendGlobal(NULL, szName, entry.key.type, varValue, iType);
+
+				// A __tostring metamethod can change the table or collect the
+				// strings the rest of the batch points at so walk again
+				if (iType == LUA_TUSERDATA)
+				{
+					iCursor = entry.slot + 1;
+					break;
+				}
+			}
 		}
 
 		return iGlobals;
 	}
 
-	int32_t LuaPlugin::getLocals(lua_State *luaState, lua_Debug *ar, int32_t iStackLevel)
+	int32_t LuaPlugin::getLocals(lua_State *luaState, lua_Debug *ar, int32_t iStackLevel, bool bNamesOnly /* = false */)
 	{
 		int32_t iLocals = 1;
 
 		const StackReconciler recon(luaState);
 
+		const uint32_t iFirstEntry = m_iVarPagePosition;
+
 		// Get first
 		const char *pszLocal = ::lua_getlocal(luaState, ar, iLocals);
 
 		while (pszLocal)
 		{
-			char szValue[SCMP::Sizes::kVarValueLen];
+			if (!withinVarBudget(LuaVariableScope::kLocal, iStackLevel, m_iVarPagePosition - iFirstEntry))
+			{
+				::lua_pop(luaState, 1);
+				break;
+			}
+
+			const int32_t iType = ::lua_type(luaState, -1);
+
+			// If filtered ignore formatting and sending
+			if (!nextVarPageEntry() || isLocalVarTypeFiltered(iType) || isLocalVarNameFiltered(pszLocal))
+			{
+				::lua_pop(luaState, 1);
+			}
+			else
+			{
+				SCMP::VarValue varValue;
 
-			const int32_t iType = lookUpTypeVal(luaState, -1, szValue, SCMP::Sizes::kVarValueLen);
+				if (bNamesOnly)
+				{
+					// Type only; the value is looked up on request
+					varValue.setText("");
+					::lua_pop(luaState, 1);
+				}
+				else
+				{
+					lookUpTypeVal(luaState, -1, varValue);
+				}
 
-			// If filtered ignore sending
-			if (!isLocalVarTypeFiltered(iType) && !isLocalVarNameFiltered(pszLocal))
-				sendLocal(NULL, pszLocal, LUA_TSTRING, szValue, iType, iStackLevel, iLocals);
+				sendLocal(NULL, pszLocal, LUA_TSTRING, varValue, iType, iStackLevel, iLocals);
+			}
 
 			// Get next
 			pszLocal = ::lua_getlocal(luaState, ar, ++iLocals);
@@ -1941,18 +2497,34 @@ namespace sce { namespace Sled
 
 		const StackReconciler recon(luaState);
 
+		const uint32_t iFirstEntry = m_iVarPagePosition;
+
 		// Get first
 		const char *pszUpvalue = ::lua_getupvalue(luaState, iFuncIndex, iUpvalues);
 
 		while (pszUpvalue)
 		{
-			char szValue[SCMP::Sizes::kVarValueLen];
+			if (!withinVarBudget(LuaVariableScope::kUpvalue, iStackLevel, m_iVarPagePosition - iFirstEntry))
+			{
+				::lua_pop(luaState, 1);
+				break;
+			}
+
+			const int32_t iType = ::lua_type(luaState, -1);
+
+			// If filtered ignore formatting and sending
+			if (!nextVarPageEntry() || isUpvalueVarTypeFiltered(iType) || isUpvalueVarNameFiltered(pszUpvalue))
+			{
+				::lua_pop(luaState, 1);
+			}
+			else
+			{
+				SCMP::VarValue varValue;
 
-			const int32_t iType = lookUpTypeVal(luaState, -1, szValue, SCMP::Sizes::kVarValueLen);
+				lookUpTypeVal(luaState, -1, varValue);
 
-			// If filtered ignore sending
-			if (!isUpvalueVarTypeFiltered(iType) && !isUpvalueVarNameFiltered(pszUpvalue))
-				sendUpvalue(NULL, pszUpvalue, LUA_TSTRING, szValue, iType, iStackLevel, iUpvalues);
+				sendUpvalue(NULL, pszUpvalue, LUA_TSTRING, varValue, iType, iStackLevel, iUpvalues);
+			}
 
 			// Get next
 			pszUpvalue = ::lua_getupvalue(luaState, iFuncIndex, ++iUpvalues);
@@ -1974,30 +2546,71 @@ namespace sce { namespace Sled
 			return;
 
 		const int iTable = ::lua_gettop(luaState);
+		const uint32_t iFirstEntry = m_iVarPagePosition;
 
-		::lua_pushnil(luaState);
-		while (::lua_next(luaState, iTable) != 0)
+		const bool bBinary = (m_iVarEncoding == SCMP::VarValueEncoding::kBinary);
+
+		// Walk the table in batches so numbers, booleans & strings never go
+		// through the stack; other values are pushed one slot at a time
+		lua_TableEntry entries[kTableWalkBatch];
+		unsigned int iCursor = 0;
+		int iNumEntries;
+		bool bExhausted = false;
+
+		while (!bExhausted && ((iNumEntries = ::lua_walktable(luaState, iTable, &iCursor, entries, kTableWalkBatch)) > 0))
 		{
-			// Key is index -2
-			if (::lua_isstring(luaState, -2))
+			for (int i = 0; i < iNumEntries; i++)
 			{
-				// Make a copy as lua_tostring modifies the item and makes lua_next fail
-				::lua_pushvalue(luaState, -2);
+				const lua_TableEntry& entry = entries[i];
+
+				if (!withinVarBudget(LuaVariableScope::kEnvironment, iStackLevel, m_iVarPagePosition - iFirstEntry))
+				{
+					bExhausted = true;
+					break;
+				}
 
-				// Modify newly created key copy
-				const char *pszKey = ::lua_tostring(luaState, -1);
+				// Only string & number keys are names
+				if (((entry.key.type != LUA_TSTRING) && (entry.key.type != LUA_TNUMBER)) || !nextVarPageEntry())
+					continue;
 
-				char szValue[SCMP::Sizes::kVarValueLen];
+				// Check the type filter on the raw value before doing any other work
+				const int32_t iType = entry.value.type;
+				if (isEnvVarVarTypeFiltered(iType))
+					continue;
 
-				const int32_t iType = lookUpTypeVal(luaState, -2, szValue, SCMP::Sizes::kVarValueLen);
+				char szName[SCMP::Sizes::kVarNameLen];
+				TableItemToText(entry.key, szName, SCMP::Sizes::kVarNameLen);
 
-				// If filtered ignore sending
-				if (!isEnvVarVarTypeFiltered(iType) && !isEnvVarVarNameFiltered(pszKey))
-					sendEnvVar(NULL, pszKey, ::lua_type(luaState, -2), szValue, iType, iStackLevel);
-			}
+				// If filtered ignore formatting and sending
+				if (isEnvVarVarNameFiltered(szName))
+					continue;
 
-			// Pop the value (leaving the original key alone)
-			::lua_pop(luaState, 1);
+				SCMP::VarValue varValue;
+
+				if (TableItemIsDirect(entry.value))
+				{
+					TableItemToVarValue(entry.value, varValue, bBinary);
+				}
+				else
+				{
+					if (!::lua_pushtableslot(luaState, iTable, entry.slot))
+						continue;
+
+					// Gets info about the value and pops it, then pop the key
+					lookUpTypeVal(luaState, -1, varValue);
+					::lua_pop(luaState, 1);
+				}
+
+				sendEnvVar(NULL, szName, entry.key.type, varValue, iType, iStackLevel);
+
+				// A __tostring metamethod can change the table or collect the
+				// strings the rest of the batch points at so walk again
+				if (iType == LUA_TUSERDATA)
+				{
+					iCursor = entry.slot + 1;
+					break;
+				}
+			}
 		}
 	}
 
@@ -2123,6 +2736,277 @@ namespace sce { namespace Sled
 		m_pEditAndContinue->clear();
 	}
 
+	void LuaPlugin::heapCensusLua(lua_State *luaState)
+	{
+		SCE_SLED_ASSERT(luaState != NULL);
+
+		const StackReconciler recon(luaState);
+
+		m_pHeapCensus->begin();
+
+		if (::lua_checkstack(luaState, kHeapCensusStackSlots) == 0)
+		{
+			m_pHeapCensus->truncate();
+			m_pHeapCensus->end();
+			return;
+		}
+
+		// Walk each global as its own root so the size retained by every
+		// global is reported separately
+		::lua_pushglobaltable(luaState);
+		const int iGlobalsIdx = ::lua_gettop(luaState);
+		m_pHeapCensus->visit(::lua_topointer(luaState, iGlobalsIdx), 0);
+
+		const std::size_t iLen = ::lua_rawlen(luaState, iGlobalsIdx);
+		uint32_t iArrayCount = 0;
+		uint32_t iHashCount = 0;
+
+		::lua_pushnil(luaState);
+		while (::lua_next(luaState, iGlobalsIdx) != 0)
+		{
+			// Key is index -2, value is index -1
+			if (HeapCensusIsArrayKey(luaState, -2, iLen))
+				++iArrayCount;
+			else
+				++iHashCount;
+
+			char szName[HeapCensusRootEntry::kNameLen];
+			if (::lua_type(luaState, -2) == LUA_TSTRING)
+				Utilities::copyString(szName, HeapCensusRootEntry::kNameLen, ::lua_tostring(luaState, -2));
+			else
+				StringUtilities::copyString(szName, HeapCensusRootEntry::kNameLen, "[%s]", ::lua_typename(luaState, ::lua_type(luaState, -2)));
+
+			m_pHeapCensus->beginRoot(szName);
+
+			heapCensusWalk(luaState, 1);
+
+			::lua_pushvalue(luaState, -2);
+			heapCensusWalk(luaState, 1);
+			::lua_pop(luaState, 1);
+
+			m_pHeapCensus->endRoot();
+
+			// Pop value but leave key for lua_next
+			::lua_pop(luaState, 1);
+
+			if (m_pHeapCensus->isTruncated())
+			{
+				// Pop key
+				::lua_pop(luaState, 1);
+				break;
+			}
+		}
+
+		// The globals table itself
+		m_pHeapCensus->beginRoot("(globals)");
+		{
+			const std::size_t iBytes = HeapCensus::estimateTableBytes(iArrayCount, iHashCount);
+			m_pHeapCensus->addObject(LUA_TTABLE, iBytes);
+			m_pHeapCensus->addTable(::lua_topointer(luaState, iGlobalsIdx), iArrayCount, iHashCount, iBytes);
+
+			if (::lua_getmetatable(luaState, iGlobalsIdx) != 0)
+			{
+				heapCensusWalk(luaState, 1);
+				::lua_pop(luaState, 1);
+			}
+		}
+		m_pHeapCensus->endRoot();
+
+		// Pop globals table
+		::lua_pop(luaState, 1);
+
+		// Whatever is only reachable through the registry (loaded modules,
+		// references held by C code, userdata metatables)
+		m_pHeapCensus->beginRoot("(registry)");
+		::lua_pushvalue(luaState, LUA_REGISTRYINDEX);
+		heapCensusWalk(luaState, 1);
+		::lua_pop(luaState, 1);
+		m_pHeapCensus->endRoot();
+
+		m_pHeapCensus->end();
+	}
+
+	void LuaPlugin::heapCensusWalk(lua_State *luaState, uint16_t iDepth)
+	{
+		// The value to walk is at the top of the stack and is left there
+		const int iType = ::lua_type(luaState, -1);
+
+		// Only garbage collected objects take up heap space
+		if ((iType != LUA_TSTRING) &&
+			(iType != LUA_TTABLE) &&
+			(iType != LUA_TFUNCTION) &&
+			(iType != LUA_TUSERDATA) &&
+			(iType != LUA_TTHREAD))
+			return;
+
+		// lua_topointer doesn't work on strings but the string data
+		// pointer is unique per interned string
+		const void *pObject = (iType == LUA_TSTRING) ? ::lua_tostring(luaState, -1) : ::lua_topointer(luaState, -1);
+		const HeapCensus::Visit visit = m_pHeapCensus->visit(pObject, iDepth);
+		if (visit == HeapCensus::kVisitSkip)
+			return;
+
+		// An object reached again closer to a root is walked again so
+		// the depth limit doesn't depend on traversal order, but it was
+		// already counted the first time
+		const bool bCount = (visit == HeapCensus::kVisitNew);
+
+		if (::lua_checkstack(luaState, kHeapCensusStackSlots) == 0)
+		{
+			m_pHeapCensus->truncate();
+			return;
+		}
+
+		// Past the depth limit objects are still counted but what
+		// they reference is not followed
+		const bool bFollow = (iDepth < m_pHeapCensus->getMaxDepth());
+		const int iIndex = ::lua_gettop(luaState);
+
+		switch (iType)
+		{
+		case LUA_TSTRING:
+			if (bCount)
+				m_pHeapCensus->addObject(LUA_TSTRING, HeapCensus::estimateStringBytes(::lua_rawlen(luaState, iIndex)));
+			break;
+
+		case LUA_TTABLE:
+			{
+				const std::size_t iLen = ::lua_rawlen(luaState, iIndex);
+				uint32_t iArrayCount = 0;
+				uint32_t iHashCount = 0;
+
+				::lua_pushnil(luaState);
+				while (::lua_next(luaState, iIndex) != 0)
+				{
+					if (HeapCensusIsArrayKey(luaState, -2, iLen))
+						++iArrayCount;
+					else
+						++iHashCount;
+
+					if (bFollow)
+					{
+						heapCensusWalk(luaState, iDepth + 1);
+
+						::lua_pushvalue(luaState, -2);
+						heapCensusWalk(luaState, iDepth + 1);
+						::lua_pop(luaState, 1);
+					}
+
+					// Pop value but leave key for lua_next
+					::lua_pop(luaState, 1);
+
+					if (m_pHeapCensus->isTruncated())
+					{
+						// Pop key
+						::lua_pop(luaState, 1);
+						break;
+					}
+				}
+
+				if (bCount)
+				{
+					const std::size_t iBytes = HeapCensus::estimateTableBytes(iArrayCount, iHashCount);
+					m_pHeapCensus->addObject(LUA_TTABLE, iBytes);
+					m_pHeapCensus->addTable(::lua_topointer(luaState, iIndex), iArrayCount, iHashCount, iBytes);
+				}
+
+				if (bFollow && (::lua_getmetatable(luaState, iIndex) != 0))
+				{
+					heapCensusWalk(luaState, iDepth + 1);
+					::lua_pop(luaState, 1);
+				}
+			}
+			break;
+
+		case LUA_TFUNCTION:
+			{
+				const bool bLuaFunction = (::lua_iscfunction(luaState, iIndex) == 0);
+
+				// Upvalues (this includes _ENV)
+				int32_t iNumUpvalues = 0;
+				while (::lua_getupvalue(luaState, iIndex, iNumUpvalues + 1) != NULL)
+				{
+					++iNumUpvalues;
+
+					if (bFollow)
+						heapCensusWalk(luaState, iDepth + 1);
+
+					::lua_pop(luaState, 1);
+				}
+
+				if (bCount)
+					m_pHeapCensus->addObject(LUA_TFUNCTION, HeapCensus::estimateClosureBytes(iNumUpvalues, bLuaFunction));
+			}
+			break;
+
+		case LUA_TUSERDATA:
+			{
+				if (bCount)
+					m_pHeapCensus->addObject(LUA_TUSERDATA, HeapCensus::estimateUserDataBytes(::lua_rawlen(luaState, iIndex)));
+
+				if (bFollow)
+				{
+					if (::lua_getmetatable(luaState, iIndex) != 0)
+					{
+						heapCensusWalk(luaState, iDepth + 1);
+						::lua_pop(luaState, 1);
+					}
+					::lua_getuservalue(luaState, iIndex);
+					heapCensusWalk(luaState, iDepth + 1);
+					::lua_pop(luaState, 1);
+				}
+			}
+			break;
+
+		case LUA_TTHREAD:
+			if (bCount)
+				m_pHeapCensus->addObject(LUA_TTHREAD, HeapCensus::estimateThreadBytes());
+			break;
+		}
+	}
+
+	void LuaPlugin::resetCoverageLua()
+	{
+		// Registered threads of one state share its counters; clearing
+		// them more than once does no harm
+		for (uint16_t i = 0; i < m_iNumLuaStates; i++)
+			::lua_resetcoverage(m_pLuaStates[i].luaState);
+	}
+
+	void LuaPlugin::writeCoverageLua(lua_State *luaState, CoverageWriter *pWriter)
+	{
+		SCE_SLED_ASSERT(luaState != NULL);
+		SCE_SLED_ASSERT(pWriter != NULL);
+
+		// Doesn't touch the Lua stack, so is fine at any point Lua isn't running
+		::lua_visitcoverage(luaState, CoverageVisitor, pWriter);
+	}
+
+	void LuaPlugin::resetOpcodeProfileLua()
+	{
+		for (uint16_t i = 0; i < m_iNumLuaStates; i++)
+			::lua_resetopcodeprofile(m_pLuaStates[i].luaState);
+	}
+
+	void LuaPlugin::opcodeProfileLua(lua_State *luaState)
+	{
+		SCE_SLED_ASSERT(luaState != NULL);
+
+		const int iNumOpcodes = ::lua_numopcodes();
+		const std::size_t *pTotals = ::lua_opcodetotals(luaState);
+
+		m_pOpcodeProfile->begin((int32_t)iNumOpcodes);
+
+		for (int i = 0; i < iNumOpcodes; i++)
+			m_pOpcodeProfile->setOpcode((int32_t)i, ::lua_opcodename(i), pTotals ? (uint64_t)pTotals[i] : 0);
+
+		// Only functions still loaded report; the totals above include
+		// the ones collected since
+		::lua_visitopcodes(luaState, OpcodeVisitor, m_pOpcodeProfile);
+
+		m_pOpcodeProfile->end();
+	}
+
 	void LuaPlugin::handleScmpBreakpointDetailsLua(NetworkBufferReader *pReader)
 	{
 		const Sled::SCMP::Breakpoint::Details bp(pReader);
@@ -2224,6 +3108,8 @@ namespace sce { namespace Sled
 						::lua_sethook(m_pLuaStates[i].luaState, LuaPlugin::hookFunc, iProfileMask, 0);
 				}
 			}
+
+			updateLineMasks(m_pScriptMan->getDebuggerMode());
 		}
 	}
 
@@ -2305,15 +3191,15 @@ namespace sce { namespace Sled
 		}
 		else
 		{
-			char szValue[SCMP::Sizes::kVarValueLen];
-			const int32_t luaType = lookUpTypeVal(luaState, -1, szValue, SCMP::Sizes::kVarValueLen, false);
+			SCMP::VarValue varValue;
+			const int32_t luaType = lookUpTypeVal(luaState, -1, varValue, false);
 
-			//std::printf("Name: %s, NameType: %i, Value: %s, ValueType: %i\n", nameToUse, nameTypeToUse, szValue, luaType);
+			//std::printf("Name: %s, NameType: %i, Value: %s, ValueType: %i\n", nameToUse, nameTypeToUse, varValue.text, luaType);
 
 			switch (pLookUp->variable.what)
 			{
 				case LuaVariableScope::kGlobal:
-					sendGlobal(&(pLookUp->variable), nameToUse, nameTypeToUse, szValue, luaType);
+					sendGlobal(&(pLookUp->variable), nameToUse, nameTypeToUse, varValue, luaType);
 					break;
 
 				case LuaVariableScope::kLocal:
@@ -2325,7 +3211,7 @@ namespace sce { namespace Sled
 					break;
 
 				case LuaVariableScope::kEnvironment:
-					sendEnvVar(&(pLookUp->variable), nameToUse, nameTypeToUse, szValue, luaType, 0);
+					sendEnvVar(&(pLookUp->variable), nameToUse, nameTypeToUse, varValue, luaType, 0);
 					break;
 			}
 		}
@@ -2341,6 +3227,7 @@ namespace sce { namespace Sled
 			lua_State *luaState = m_pCurHookLuaState;
 			const StackReconciler recon(luaState);
 			const int32_t iLevel = (int32_t)lookup.stackLevel;
+			const bool bLazy = (m_iVarTransferMode == VarTransferMode::kLazy);
 
 			// Find right stack level and get locals & upvalues
 			lua_Debug arStack;								
@@ -2355,53 +3242,53 @@ namespace sce { namespace Sled
 					tagFuncForLookUp(szFuncName, iFuncTagLen, arStack.name, pszLevelSource, arStack.linedefined);
 
 					const SCMP::CallStackLookUpBegin scmpCsLBeg(kLuaPluginId);
-					m_pScriptMan->send((uint8_t*)&scmpCsLBeg, scmpCsLBeg.length);
+					sendToClient((uint8_t*)&scmpCsLBeg, scmpCsLBeg.length);
 
 					const SCMP::CallStackLookUp scmpCsL(kLuaPluginId,
 						szFuncName,
 						arStack.linedefined,
 						lookup.stackLevel,
 						m_pSendBuf);
-					m_pScriptMan->send(m_pSendBuf->getData(), m_pSendBuf->getSize());
+					sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
 
 					// Get locals for this stack level (0) and send to client (if not excluded)
 					if ((m_iVarExcludeFlags & VarExcludeFlags::kLocals) != VarExcludeFlags::kLocals)
 					{
 						const SCMP::LocalVarBegin scmpLoBeg(kLuaPluginId);
-						m_pScriptMan->send((uint8_t*)&scmpLoBeg, scmpLoBeg.length);
+						sendToClient((uint8_t*)&scmpLoBeg, scmpLoBeg.length);
 
-						getLocals(luaState, &arStack, iLevel);
+						getLocals(luaState, &arStack, iLevel, bLazy);
 
 						const SCMP::LocalVarEnd scmpLoEnd(kLuaPluginId);
-						m_pScriptMan->send((uint8_t*)&scmpLoEnd, scmpLoEnd.length);
+						sendToClient((uint8_t*)&scmpLoEnd, scmpLoEnd.length);
 					}
 
 					// Get upvalues for this stack level (0) and send to client (if not excluded)
-					if ((m_iVarExcludeFlags & VarExcludeFlags::kUpvalues) != VarExcludeFlags::kUpvalues)
+					if (!bLazy && ((m_iVarExcludeFlags & VarExcludeFlags::kUpvalues) != VarExcludeFlags::kUpvalues))
 					{
 						const SCMP::UpvalueVarBegin scmpUpBeg(kLuaPluginId);
-						m_pScriptMan->send((uint8_t*)&scmpUpBeg, scmpUpBeg.length);
+						sendToClient((uint8_t*)&scmpUpBeg, scmpUpBeg.length);
 
 						getUpvalues(luaState, -1, iLevel);
 
 						const SCMP::UpvalueVarEnd scmpUpEnd(kLuaPluginId);
-						m_pScriptMan->send((uint8_t*)&scmpUpEnd, scmpUpEnd.length);
+						sendToClient((uint8_t*)&scmpUpEnd, scmpUpEnd.length);
 					}
 
 					// Get environment for this function and send to client if not excluded
-					if ((m_iVarExcludeFlags & VarExcludeFlags::kEnvironment) != VarExcludeFlags::kEnvironment)
+					if (!bLazy && ((m_iVarExcludeFlags & VarExcludeFlags::kEnvironment) != VarExcludeFlags::kEnvironment))
 					{
 						const SCMP::EnvVarBegin scmpEnvBeg(kLuaPluginId);
-						m_pScriptMan->send((uint8_t*)&scmpEnvBeg, scmpEnvBeg.length);
+						sendToClient((uint8_t*)&scmpEnvBeg, scmpEnvBeg.length);
 
 						getEnvironment(luaState, ::lua_gettop(luaState), iLevel);
 
 						const SCMP::EnvVarEnd scmpEnvEnd(kLuaPluginId);
-						m_pScriptMan->send((uint8_t*)&scmpEnvEnd, scmpEnvEnd.length);
+						sendToClient((uint8_t*)&scmpEnvEnd, scmpEnvEnd.length);
 					}
 
 					const SCMP::CallStackLookUpEnd scmpCsLEnd(kLuaPluginId);
-					m_pScriptMan->send((uint8_t*)&scmpCsLEnd, scmpCsLEnd.length);
+					sendToClient((uint8_t*)&scmpCsLEnd, scmpCsLEnd.length);
 				}
 			}
 		}
@@ -2410,12 +3297,25 @@ namespace sce { namespace Sled
 	void LuaPlugin::handleScmpProfilerToggleLua(NetworkBufferReader *pReader)
 	{
 		SCE_SLED_ASSERT(pReader != NULL);
+		toggleProfilerLua();
+	}
 
+	void LuaPlugin::toggleProfilerLua()
+	{
 		const int iProfileMask = m_bProfilerRunning ? 0 : LUA_MASKCALL | LUA_MASKRET;
 		const int iBreakpointMask = (m_iNumBreakpoints == 0) ? 0 : LUA_MASKLINE;
 
 		m_bProfilerRunning = !m_bProfilerRunning;
+
+		// Time the profiler's own overhead before there's anything to profile
+		if (m_bProfilerRunning)
+			m_pProfileStack->calibrate();
+
 		m_pProfileStack->clear();
+		m_pTraceTimeline->clear();
+		m_pProfileFrames->clear();
+		m_pPerfWatch->clear();
+		m_pGcStats->clear();
 
 		for (uint16_t i = 0; i < m_iNumLuaStates; i++)
 		{
@@ -2430,6 +3330,9 @@ namespace sce { namespace Sled
 			if (iProfileMask || iBreakpointMask)
 				::lua_sethook(m_pLuaStates[i].luaState, LuaPlugin::hookFunc, iProfileMask | iBreakpointMask, 0);
 		}
+
+		updateGcHooks();
+		updateProfileFilters();
 	}
 
 	void LuaPlugin::handleScmpDevCmdLua(NetworkBufferReader *pReader)
@@ -2604,7 +3507,7 @@ namespace sce { namespace Sled
 		for (uint16_t i = 0; i < m_iNumLuaStates; i++)
 		{
 			char szTemp[SCMP::Sizes::kPtrLen];
-			StringUtilities::copyString(szTemp, SCMP::Sizes::kPtrLen, "%p", m_pLuaStates[i].luaState);
+			NumberFormat::formatPointer(szTemp, SCMP::Sizes::kPtrLen, m_pLuaStates[i].luaState, false);
 
 			if (Utilities::areStringsEqual(szTemp, stateToggle.address))
 			{
@@ -2612,6 +3515,7 @@ namespace sce { namespace Sled
 				{
 					// Remove all hooks
 					::lua_sethook(m_pLuaStates[i].luaState, NULL, 0, 0);
+					::lua_setlinemask(m_pLuaStates[i].luaState, NULL, NULL);
 				}
 				else
 				{
@@ -2626,8 +3530,89 @@ namespace sce { namespace Sled
 
 				// Change debugging state
 				m_pLuaStates[i].setDebugging(!m_pLuaStates[i].isDebugging());
+				updateGcHooks();
+				updateLineMasks(m_pScriptMan->getDebuggerMode());
+				updateProfileFilters();
 				break;
 			}
 		}
 	}
+
+	void LuaPlugin::handleScmpVarLookUpPageLua(SCMP::VarLookUpPage *pPage)
+	{
+		SCE_SLED_ASSERT(pPage != NULL);
+
+		lua_State* const luaState = m_pCurHookLuaState;
+		const LuaVariable *pVar = &(pPage->variable);
+
+		const StackReconciler recon(luaState);
+
+		// Page through the contents of a table
+		if (!pPage->isScope())
+		{
+			lookupVariable(luaState, pVar);
+			return;
+		}
+
+		// Page through the variables of the scope itself
+		if (pVar->what == LuaVariableScope::kGlobal)
+		{
+			getGlobals(luaState);
+			return;
+		}
+
+		lua_Debug ar;
+		if (::lua_getstack(luaState, pVar->level, &ar) != 1)
+			return;
+
+		switch (pVar->what)
+		{
+		case LuaVariableScope::kLocal:
+			getLocals(luaState, &ar, pVar->level);
+			break;
+
+		case LuaVariableScope::kUpvalue:
+			// Push the function running at this stack level onto the stack
+			if (::lua_getinfo(luaState, "f", &ar) == 1)
+				getUpvalues(luaState, -1, pVar->level);
+			break;
+
+		case LuaVariableScope::kEnvironment:
+			// Push the function running at this stack level onto the stack
+			if (::lua_getinfo(luaState, "f", &ar) == 1)
+				getEnvironment(luaState, ::lua_gettop(luaState), pVar->level);
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	void LuaPlugin::handleScmpVarLookUpByIdLua(SCMP::VarLookUpById *pLookUp)
+	{
+		SCE_SLED_ASSERT(pLookUp != NULL);
+
+		lua_State* const luaState = m_pCurHookLuaState;
+		const LuaVariable *pVar = &(pLookUp->variable);
+
+		const StackReconciler recon(luaState);
+
+		// Resolve the path again so a variable that now holds a
+		// different table is noticed; only the contents are skipped
+		if (!pLookUp->isIdOnly())
+		{
+			lookupVariable(luaState, pVar);
+			return;
+		}
+
+		if (pushTableById(luaState, pLookUp->id))
+		{
+			getTableValues(luaState, pVar, pVar->what, pVar->index, -2, pVar->level);
+			return;
+		}
+
+		// Id 0 tells SLED the table no longer exists
+		const SCMP::VarTableId scmpTblId(kLuaPluginId, (uint8_t)pVar->what, 0, 0, false, m_pSendBuf);
+		sendToClient(m_pSendBuf->getData(), m_pSendBuf->getSize());
+	}
 }}
@@ -0,0 +1,436 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "tracetimeline.h"
+#include "profilestack.h"
+#include "numberformat.h"
+#include "sledluaplugin.h"
+#include "../sleddebugger/assert.h"
+#include "../sleddebugger/errorcodes.h"
+#include "../sleddebugger/sequentialallocator.h"
+#include "../sleddebugger/timer.h"
+
+#include <new>
+#include <cstring>
+
+namespace sce { namespace Sled
+{
+	void TraceTimelineConfig::init(const TraceTimelineConfig& rhs)
+	{
+		maxEvents = rhs.maxEvents;
+		maxRings = rhs.maxRings;
+	}
+
+	TraceTimelineConfig::TraceTimelineConfig(const LuaPluginConfig *pConfig)
+	{
+		SCE_SLED_ASSERT(pConfig != NULL);
+
+		maxEvents = pConfig->maxTraceEvents;
+		maxRings = pConfig->maxLuaStates;
+	}
+
+	namespace
+	{
+		struct TraceTimelineSeats
+		{
+			void *m_this;
+			void *m_events;
+			void *m_owners;
+			void *m_heads;
+			void *m_counts;
+			void *m_timer;
+
+			void Allocate(const TraceTimelineConfig& timelineConfig, ISequentialAllocator *pAllocator)
+			{
+				// For this
+				m_this = pAllocator->allocate(sizeof(TraceTimeline), __alignof(TraceTimeline));
+
+				// Nothing per ring unless enabled
+				const uint16_t iNumRings = (timelineConfig.maxEvents != 0) ? timelineConfig.maxRings : 0;
+
+				// For m_pEvents
+				m_events = pAllocator->allocate(sizeof(TraceEvent) * timelineConfig.maxEvents * iNumRings, __alignof(TraceEvent));
+
+				// For m_ppOwners, m_pHeads & m_pCounts
+				m_owners = pAllocator->allocate(sizeof(const void*) * iNumRings, __alignof(const void*));
+				m_heads = pAllocator->allocate(sizeof(uint32_t) * iNumRings, __alignof(uint32_t));
+				m_counts = pAllocator->allocate(sizeof(uint32_t) * iNumRings, __alignof(uint32_t));
+
+				// For m_pTimer
+				Timer::requiredMemoryHelper(pAllocator, &m_timer);
+			}
+		};
+
+		// Buffers the JSON text so the callback sees it in pieces of up to
+		// kMaxWriteSize bytes; once the callback fails nothing more is written
+		class TraceJsonWriter
+		{
+		public:
+			static const int32_t kMaxWriteSize = 512;
+
+			TraceJsonWriter(TraceWriteCallback pfnWrite, void *pUserData)
+				: m_pfnWrite(pfnWrite), m_pUserData(pUserData), m_iBufferSize(0), m_bFailed(false) {}
+
+			void putChar(char ch)
+			{
+				if (m_iBufferSize == kMaxWriteSize)
+					flush();
+
+				m_buffer[m_iBufferSize++] = ch;
+			}
+
+			void putText(const char *pszText)
+			{
+				for (; *pszText != '\0'; ++pszText)
+					putChar(*pszText);
+			}
+
+			void putUnsigned(uint64_t iValue)
+			{
+				char szValue[32];
+				NumberFormat::formatUnsigned(szValue, sizeof(szValue), iValue);
+				putText(szValue);
+			}
+
+			void putString(const char *pszText)
+			{
+				static const char kHex[] = "0123456789abcdef";
+
+				putChar('"');
+				for (; *pszText != '\0'; ++pszText)
+				{
+					const unsigned char ch = (unsigned char)*pszText;
+					if ((ch == '"') || (ch == '\\'))
+					{
+						putChar('\\');
+						putChar((char)ch);
+					}
+					else if (ch < 0x20)
+					{
+						putText("\\u00");
+						putChar(kHex[ch >> 4]);
+						putChar(kHex[ch & 0xF]);
+					}
+					else
+					{
+						putChar((char)ch);
+					}
+				}
+				putChar('"');
+			}
+
+			// Common to every event: "ph", "ts", "pid" & "tid"
+			void putEventStart(const char *pszPhase, uint64_t iTime, uint16_t iRing)
+			{
+				putText("{\"ph\":\"");
+				putText(pszPhase);
+				putText("\",\"ts\":");
+				putUnsigned(iTime);
+				putText(",\"pid\":1,\"tid\":");
+				putUnsigned(iRing + 1);
+			}
+
+			bool end()
+			{
+				flush();
+				return !m_bFailed;
+			}
+
+			inline bool hasFailed() const { return m_bFailed; }
+		private:
+			void flush()
+			{
+				if (!m_bFailed && (m_iBufferSize > 0))
+					m_bFailed = !m_pfnWrite(m_buffer, m_iBufferSize, m_pUserData);
+
+				m_iBufferSize = 0;
+			}
+		private:
+			TraceWriteCallback	m_pfnWrite;
+			void				*m_pUserData;
+			char				m_buffer[kMaxWriteSize];
+			int32_t				m_iBufferSize;
+			bool				m_bFailed;
+		};
+	}
+
+	int32_t TraceTimeline::create(const TraceTimelineConfig& timelineConfig, void *pLocation, TraceTimeline **ppTimeline)
+	{
+		SCE_SLED_ASSERT(pLocation != NULL);
+		SCE_SLED_ASSERT(ppTimeline != NULL);
+
+		std::size_t iMemSize = 0;
+
+		const int32_t iConfigError = requiredMemory(timelineConfig, &iMemSize);
+		if (iConfigError != 0)
+			return iConfigError;
+
+		SequentialAllocator allocator(pLocation, iMemSize);
+
+		TraceTimelineSeats seats;
+		seats.Allocate(timelineConfig, &allocator);
+
+		SCE_SLED_ASSERT(seats.m_this != NULL);
+		SCE_SLED_ASSERT(seats.m_events != NULL);
+		SCE_SLED_ASSERT(seats.m_owners != NULL);
+		SCE_SLED_ASSERT(seats.m_heads != NULL);
+		SCE_SLED_ASSERT(seats.m_counts != NULL);
+		SCE_SLED_ASSERT(seats.m_timer != NULL);
+
+		*ppTimeline = new (seats.m_this) TraceTimeline(timelineConfig, &seats);
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t TraceTimeline::requiredMemory(const TraceTimelineConfig& timelineConfig, std::size_t *iRequiredMemory)
+	{
+		SCE_SLED_ASSERT(iRequiredMemory != NULL);
+
+		SequentialAllocatorCalculator allocator;
+
+		TraceTimelineSeats seats;
+		seats.Allocate(timelineConfig, &allocator);
+
+		*iRequiredMemory = allocator.bytesAllocated();
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t TraceTimeline::requiredMemoryHelper(const TraceTimelineConfig& timelineConfig, ISequentialAllocator *pAllocator, void **ppThis)
+	{
+		SCE_SLED_ASSERT(pAllocator != NULL);
+		SCE_SLED_ASSERT(ppThis != NULL);
+
+		TraceTimelineSeats seats;
+		seats.Allocate(timelineConfig, pAllocator);
+
+		*ppThis = seats.m_this;
+		return SCE_SLED_ERROR_OK;
+	}
+
+	void TraceTimeline::shutdown(TraceTimeline *pTimeline)
+	{
+		SCE_SLED_ASSERT(pTimeline != NULL);
+		pTimeline->~TraceTimeline();
+	}
+
+	TraceTimeline::TraceTimeline(const TraceTimelineConfig& timelineConfig, const void *pTimelineSeats)
+		: m_iMaxEvents(timelineConfig.maxEvents)
+		, m_iMaxRings((timelineConfig.maxEvents != 0) ? timelineConfig.maxRings : 0)
+		, m_iBpStopTime(0)
+		, m_iBpTotalTime(0)
+	{
+		SCE_SLED_ASSERT(pTimelineSeats != NULL);
+
+		const TraceTimelineSeats *pSeats = static_cast<const TraceTimelineSeats*>(pTimelineSeats);
+
+		m_pEvents = static_cast<TraceEvent*>(pSeats->m_events);
+		m_ppOwners = static_cast<const void**>(pSeats->m_owners);
+		m_pHeads = static_cast<uint32_t*>(pSeats->m_heads);
+		m_pCounts = static_cast<uint32_t*>(pSeats->m_counts);
+
+		for (uint16_t i = 0; i < m_iMaxRings; i++)
+		{
+			m_ppOwners[i] = 0;
+			m_pHeads[i] = 0;
+			m_pCounts[i] = 0;
+		}
+
+		Timer::create(pSeats->m_timer, &m_pTimer);
+	}
+
+	bool TraceTimeline::acquireRing(const void *pOwner)
+	{
+		SCE_SLED_ASSERT(pOwner != NULL);
+
+		int32_t iRing = findRing(pOwner);
+		if (iRing == -1)
+			iRing = findRing(0);
+
+		if (iRing == -1)
+			return false;
+
+		m_ppOwners[iRing] = pOwner;
+		m_pHeads[iRing] = 0;
+		m_pCounts[iRing] = 0;
+		return true;
+	}
+
+	void TraceTimeline::releaseRing(const void *pOwner)
+	{
+		SCE_SLED_ASSERT(pOwner != NULL);
+
+		const int32_t iRing = findRing(pOwner);
+		if (iRing == -1)
+			return;
+
+		m_ppOwners[iRing] = 0;
+		m_pHeads[iRing] = 0;
+		m_pCounts[iRing] = 0;
+	}
+
+	bool TraceTimeline::record(const void *pOwner, uint32_t iType, uint32_t iFn)
+	{
+		if (pOwner == 0)
+			return false;
+
+		const int32_t iRing = findRing(pOwner);
+		if (iRing == -1)
+			return false;
+
+		// Once full the oldest event goes
+		TraceEvent& event = m_pEvents[(iRing * m_iMaxEvents) + m_pHeads[iRing]];
+		event.time = now();
+		event.fn = iFn;
+		event.type = iType;
+
+		if (++m_pHeads[iRing] == m_iMaxEvents)
+			m_pHeads[iRing] = 0;
+
+		if (m_pCounts[iRing] < m_iMaxEvents)
+			m_pCounts[iRing]++;
+
+		return true;
+	}
+
+	uint64_t TraceTimeline::now() const
+	{
+		return m_pTimer->elapsedMicroseconds() - m_iBpTotalTime;
+	}
+
+	void TraceTimeline::preBreakpoint()
+	{
+		m_iBpStopTime = m_pTimer->elapsedMicroseconds();
+	}
+
+	void TraceTimeline::postBreakpoint()
+	{
+		m_iBpTotalTime += (m_pTimer->elapsedMicroseconds() - m_iBpStopTime);
+	}
+
+	void TraceTimeline::clear()
+	{
+		for (uint16_t i = 0; i < m_iMaxRings; i++)
+		{
+			m_pHeads[i] = 0;
+			m_pCounts[i] = 0;
+		}
+
+		m_iBpStopTime = 0;
+		m_iBpTotalTime = 0;
+
+		m_pTimer->reset();
+	}
+
+	bool TraceTimeline::writeJson(const ProfileStack *pStack, TraceWriteCallback pfnWrite, void *pUserData, uint64_t iWindowStart, uint64_t iWindowEnd) const
+	{
+		SCE_SLED_ASSERT(pStack != NULL);
+		SCE_SLED_ASSERT(pfnWrite != NULL);
+
+		TraceJsonWriter writer(pfnWrite, pUserData);
+		bool bFirst = true;
+
+		writer.putText("{\"traceEvents\":[\n");
+
+		for (uint16_t iRing = 0; (iRing < m_iMaxRings) && !writer.hasFailed(); iRing++)
+		{
+			if (m_ppOwners[iRing] == 0)
+				continue;
+
+			if (!bFirst)
+				writer.putText(",\n");
+			bFirst = false;
+
+			writer.putEventStart("M", 0, iRing);
+			writer.putText(",\"name\":\"thread_name\",\"args\":{\"name\":\"Lua state ");
+			writer.putUnsigned(iRing + 1);
+			writer.putText("\"}}");
+
+			const TraceEvent *pRing = &m_pEvents[iRing * m_iMaxEvents];
+			const uint32_t iCount = m_pCounts[iRing];
+			const uint32_t iOldest = (iCount < m_iMaxEvents) ? 0 : m_pHeads[iRing];
+
+			uint32_t iDepth = 0;
+			uint64_t iLastTime = iWindowStart;
+
+			for (uint32_t i = 0; (i < iCount) && !writer.hasFailed(); i++)
+			{
+				const TraceEvent& event = pRing[(iOldest + i) % m_iMaxEvents];
+
+				if (event.time < iWindowStart)
+					continue;
+
+				if ((iWindowEnd != 0) && (event.time > iWindowEnd))
+					break;
+
+				if (event.type == TraceEvent::kEnter)
+				{
+					const ProfileEntry *pEntry = pStack->getFn(event.fn);
+
+					// Functions without a name are tagged ":<line>:<file>" for SLED to look up
+					const char *pszFnName = pEntry ? pEntry->getFnName() : "?";
+					if (pszFnName[0] == ':')
+						pszFnName = "(anonymous)";
+
+					writer.putText(",\n");
+					writer.putEventStart("B", event.time, iRing);
+					writer.putText(",\"cat\":\"lua\",\"name\":");
+					writer.putString(pszFnName);
+
+					if (pEntry)
+					{
+						writer.putText(",\"args\":{\"source\":");
+						writer.putString(pEntry->getFnFile());
+						writer.putText(",\"line\":");
+						writer.putUnsigned(pEntry->getFnLine() < 0 ? 0 : (uint64_t)pEntry->getFnLine());
+						writer.putChar('}');
+					}
+
+					writer.putChar('}');
+					iDepth++;
+				}
+				else
+				{
+					// Called before the window or the oldest event kept
+					if (iDepth == 0)
+						continue;
+
+					writer.putText(",\n");
+					writer.putEventStart("E", event.time, iRing);
+					writer.putChar('}');
+					iDepth--;
+				}
+
+				iLastTime = event.time;
+			}
+
+			const uint64_t iCloseTime = (iWindowEnd != 0) ? iWindowEnd : iLastTime;
+			for (; iDepth > 0; iDepth--)
+			{
+				writer.putText(",\n");
+				writer.putEventStart("E", iCloseTime, iRing);
+				writer.putChar('}');
+			}
+		}
+
+		writer.putText("\n],\"displayTimeUnit\":\"ms\"}\n");
+		return writer.end();
+	}
+
+	uint32_t TraceTimeline::getNumEvents(const void *pOwner) const
+	{
+		const int32_t iRing = findRing(pOwner);
+		return (iRing == -1) ? 0 : m_pCounts[iRing];
+	}
+
+	int32_t TraceTimeline::findRing(const void *pOwner) const
+	{
+		for (uint16_t i = 0; i < m_iMaxRings; i++)
+		{
+			if (m_ppOwners[i] == pOwner)
+				return i;
+		}
+
+		return -1;
+	}
+}}
@@ -0,0 +1,108 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#ifndef __SCE_LIBSLEDLUAPLUGIN_TRACETIMELINE_H__
+#define __SCE_LIBSLEDLUAPLUGIN_TRACETIMELINE_H__
+
+#include "../sledcore/base_types.h"
+#include <cstddef>
+
+#include "../sleddebugger/common.h"
+#include "params.h"
+
+namespace sce { namespace Sled
+{
+	// Forward declarations
+	class Timer;
+	class ISequentialAllocator;
+	class ProfileStack;
+
+	// Forward declarations
+	struct LuaPluginConfig;
+
+	// One function call or return; the function is its ProfileStack index
+	struct SCE_SLED_LINKAGE TraceEvent
+	{
+		static const uint32_t kEnter = 0;
+		static const uint32_t kLeave = 1;
+
+		uint64_t	time;
+		uint32_t	fn;
+		uint32_t	type;
+	};
+
+	struct SCE_SLED_LINKAGE TraceTimelineConfig
+	{
+		TraceTimelineConfig() : maxEvents(0), maxRings(0) {}
+		TraceTimelineConfig(const TraceTimelineConfig& rhs) { init(rhs); }
+		TraceTimelineConfig& operator=(const TraceTimelineConfig& rhs) { init(rhs); return *this; }
+
+		TraceTimelineConfig(const LuaPluginConfig *pConfig);
+
+	private:
+		void init(const TraceTimelineConfig& rhs);
+	public:
+
+		uint32_t		maxEvents;	///< Number of most recent events kept per ring (0 disables the timeline)
+		uint16_t		maxRings;	///< Number of rings, one per Lua state
+	};
+
+	// Most recent calls & returns of each Lua state, kept in a ring per
+	// state, written out as Chrome trace-event JSON. Times are
+	// microseconds since the last clear, less time stopped on breakpoints.
+	class SCE_SLED_LINKAGE TraceTimeline
+	{
+	public:
+		static int32_t create(const TraceTimelineConfig& timelineConfig, void *pLocation, TraceTimeline **ppTimeline);
+		static int32_t requiredMemory(const TraceTimelineConfig& timelineConfig, std::size_t *iRequiredMemory);
+		static int32_t requiredMemoryHelper(const TraceTimelineConfig& timelineConfig, ISequentialAllocator *pAllocator, void **ppThis);
+		static void shutdown(TraceTimeline *pTimeline);
+	private:
+		TraceTimeline(const TraceTimelineConfig& timelineConfig, const void *pTimelineSeats);
+		~TraceTimeline() {}
+		TraceTimeline(const TraceTimeline&);
+		TraceTimeline& operator=(const TraceTimeline&);
+	public:
+		// Rings are handed out per owner (a lua_State) & emptied when
+		// taken or given back
+		bool acquireRing(const void *pOwner);
+		void releaseRing(const void *pOwner);
+
+		// False if pOwner has no ring
+		bool record(const void *pOwner, uint32_t iType, uint32_t iFn);
+
+		uint64_t now() const;
+		void preBreakpoint();
+		void postBreakpoint();
+
+		// Empties every ring & starts the clock over
+		void clear();
+
+		// Events between iWindowStart & iWindowEnd, inclusive (0 for no
+		// end). Returns that aren't matched by a call in the window are
+		// left out & calls still open at the end are closed there.
+		bool writeJson(const ProfileStack *pStack, TraceWriteCallback pfnWrite, void *pUserData, uint64_t iWindowStart, uint64_t iWindowEnd) const;
+
+		inline bool isEnabled() const						{ return m_iMaxEvents != 0; }
+		inline uint32_t getMaxEvents() const				{ return m_iMaxEvents; }
+		inline uint16_t getMaxRings() const					{ return m_iMaxRings; }
+		uint32_t getNumEvents(const void *pOwner) const;
+	private:
+		int32_t findRing(const void *pOwner) const;
+	private:
+		const uint32_t		m_iMaxEvents;
+		const uint16_t		m_iMaxRings;
+		TraceEvent*			m_pEvents;
+		const void**		m_ppOwners;
+		uint32_t*			m_pHeads;
+		uint32_t*			m_pCounts;
+
+		uint64_t			m_iBpStopTime;
+		uint64_t			m_iBpTotalTime;
+		Timer*				m_pTimer;
+	};
+}}
+
+#endif // __SCE_LIBSLEDLUAPLUGIN_TRACETIMELINE_H__
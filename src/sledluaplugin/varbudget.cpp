@@ -0,0 +1,151 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "varbudget.h"
+#include "sledluaplugin.h"
+#include "../sleddebugger/assert.h"
+#include "../sleddebugger/errorcodes.h"
+#include "../sleddebugger/sequentialallocator.h"
+#include "../sleddebugger/timer.h"
+
+#include <new>
+
+namespace sce { namespace Sled
+{
+	void VarBudgetConfig::init(const VarBudgetConfig& rhs)
+	{
+		maxEntries = rhs.maxEntries;
+		maxBytes = rhs.maxBytes;
+		timeBudget = rhs.timeBudget;
+	}
+
+	VarBudgetConfig::VarBudgetConfig(const LuaPluginConfig *pConfig)
+	{
+		SCE_SLED_ASSERT(pConfig != NULL);
+
+		maxEntries = pConfig->maxBreakpointVars;
+		maxBytes = pConfig->maxBreakpointVarBytes;
+		timeBudget = (float)pConfig->breakpointVarTimeBudgetMs / 1000.0f;
+	}
+
+	namespace
+	{
+		struct VarBudgetSeats
+		{
+			void *m_this;
+			void *m_timer;
+
+			void Allocate(ISequentialAllocator *pAllocator)
+			{
+				// For this
+				m_this = pAllocator->allocate(sizeof(VarBudget), __alignof(VarBudget));
+
+				// For m_pTimer
+				Timer::requiredMemoryHelper(pAllocator, &m_timer);
+			}
+		};
+	}
+
+	int32_t VarBudget::create(const VarBudgetConfig& budgetConfig, void *pLocation, VarBudget **ppBudget)
+	{
+		SCE_SLED_ASSERT(pLocation != NULL);
+		SCE_SLED_ASSERT(ppBudget != NULL);
+
+		std::size_t iMemSize = 0;
+
+		const int32_t iError = requiredMemory(budgetConfig, &iMemSize);
+		if (iError != 0)
+			return iError;
+
+		SequentialAllocator allocator(pLocation, iMemSize);
+
+		VarBudgetSeats seats;
+		seats.Allocate(&allocator);
+
+		SCE_SLED_ASSERT(seats.m_this != NULL);
+		SCE_SLED_ASSERT(seats.m_timer != NULL);
+
+		*ppBudget = new (seats.m_this) VarBudget(budgetConfig, &seats);
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t VarBudget::requiredMemory(const VarBudgetConfig& budgetConfig, std::size_t *iRequiredMemory)
+	{
+		SCE_SLED_ASSERT(iRequiredMemory != NULL);
+		SCE_SLEDUNUSED(budgetConfig);
+
+		SequentialAllocatorCalculator allocator;
+
+		VarBudgetSeats seats;
+		seats.Allocate(&allocator);
+
+		*iRequiredMemory = allocator.bytesAllocated();
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t VarBudget::requiredMemoryHelper(const VarBudgetConfig& budgetConfig, ISequentialAllocator *pAllocator, void **ppThis)
+	{
+		SCE_SLED_ASSERT(pAllocator != NULL);
+		SCE_SLED_ASSERT(ppThis != NULL);
+		SCE_SLEDUNUSED(budgetConfig);
+
+		VarBudgetSeats seats;
+		seats.Allocate(pAllocator);
+
+		*ppThis = seats.m_this;
+		return SCE_SLED_ERROR_OK;
+	}
+
+	void VarBudget::shutdown(VarBudget *pBudget)
+	{
+		SCE_SLED_ASSERT(pBudget != NULL);
+		pBudget->~VarBudget();
+	}
+
+	VarBudget::VarBudget(const VarBudgetConfig& budgetConfig, const void *pBudgetSeats)
+		: m_iMaxEntries(budgetConfig.maxEntries)
+		, m_iMaxBytes(budgetConfig.maxBytes)
+		, m_flTimeBudget(budgetConfig.timeBudget)
+		, m_iNumEntries(0)
+		, m_iNumBytes(0)
+		, m_bExhausted(false)
+	{
+		SCE_SLED_ASSERT(pBudgetSeats != NULL);
+
+		const VarBudgetSeats *pSeats = static_cast<const VarBudgetSeats*>(pBudgetSeats);
+
+		Timer::create(pSeats->m_timer, &m_pTimer);
+	}
+
+	void VarBudget::begin()
+	{
+		m_iNumEntries = 0;
+		m_iNumBytes = 0;
+		m_bExhausted = false;
+
+		m_pTimer->reset();
+	}
+
+	void VarBudget::spend(std::size_t iBytes)
+	{
+		m_iNumEntries++;
+		m_iNumBytes += iBytes;
+	}
+
+	bool VarBudget::isExhausted()
+	{
+		if (m_bExhausted)
+			return true;
+
+		// The clock is read every time since a single value (a __tostring
+		// metamethod, say) can take longer than a whole batch of others
+		m_bExhausted =
+			((m_iMaxEntries != 0) && (m_iNumEntries >= m_iMaxEntries)) ||
+			((m_iMaxBytes != 0) && (m_iNumBytes >= m_iMaxBytes)) ||
+			((m_flTimeBudget > 0.0f) && (m_pTimer->elapsed() >= m_flTimeBudget));
+
+		return m_bExhausted;
+	}
+}}
@@ -0,0 +1,75 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#ifndef __SCE_LIBSLEDLUAPLUGIN_VARBUDGET_H__
+#define __SCE_LIBSLEDLUAPLUGIN_VARBUDGET_H__
+
+#include "../sledcore/base_types.h"
+#include <cstddef>
+
+#include "../sleddebugger/common.h"
+
+namespace sce { namespace Sled
+{
+	// Forward declarations
+	class Timer;
+	class ISequentialAllocator;
+
+	// Forward declarations
+	struct LuaPluginConfig;
+
+	struct SCE_SLED_LINKAGE VarBudgetConfig
+	{
+		VarBudgetConfig() : maxEntries(0), maxBytes(0), timeBudget(0.0f) {}
+		VarBudgetConfig(const VarBudgetConfig& rhs) { init(rhs); }
+		VarBudgetConfig& operator=(const VarBudgetConfig& rhs) { init(rhs); return *this; }
+
+		VarBudgetConfig(const LuaPluginConfig *pConfig);
+
+	private:
+		void init(const VarBudgetConfig& rhs);
+	public:
+
+		uint32_t		maxEntries;		///< Maximum number of variables to send per stop (0 = no limit)
+		uint32_t		maxBytes;		///< Maximum number of bytes of variable messages to send per stop (0 = no limit)
+		float			timeBudget;		///< Maximum time, in seconds, to spend collecting variables per stop (0 = no limit)
+	};
+
+	class SCE_SLED_LINKAGE VarBudget
+	{
+	public:
+		static int32_t create(const VarBudgetConfig& budgetConfig, void *pLocation, VarBudget **ppBudget);
+		static int32_t requiredMemory(const VarBudgetConfig& budgetConfig, std::size_t *iRequiredMemory);
+		static int32_t requiredMemoryHelper(const VarBudgetConfig& budgetConfig, ISequentialAllocator *pAllocator, void **ppThis);
+		static void shutdown(VarBudget *pBudget);
+	private:
+		VarBudget(const VarBudgetConfig& budgetConfig, const void *pBudgetSeats);
+		~VarBudget() {}
+		VarBudget(const VarBudget&);
+		VarBudget& operator=(const VarBudget&);
+	public:
+		void begin();
+		void spend(std::size_t iBytes);
+
+		// Once any limit is hit the budget stays exhausted until the next begin()
+		bool isExhausted();
+
+		inline bool isEnabled() const					{ return (m_iMaxEntries != 0) || (m_iMaxBytes != 0) || (m_flTimeBudget > 0.0f); }
+		inline bool wasExhausted() const				{ return m_bExhausted; }
+		inline uint32_t getNumEntries() const			{ return m_iNumEntries; }
+		inline uint64_t getNumBytes() const				{ return m_iNumBytes; }
+	private:
+		const uint32_t		m_iMaxEntries;
+		const uint32_t		m_iMaxBytes;
+		const float			m_flTimeBudget;
+
+		uint32_t			m_iNumEntries;
+		uint64_t			m_iNumBytes;
+		bool				m_bExhausted;
+		Timer*				m_pTimer;
+	};
+}}
+
+#endif // __SCE_LIBSLEDLUAPLUGIN_VARBUDGET_H__
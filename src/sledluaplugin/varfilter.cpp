@@ -32,13 +32,17 @@ namespace sce { namespace Sled
 			void *m_this;
 
 			void *m_array;
-			void *m_arrayPool;
 
 			void Allocate(const VarFilterNameConfig& config, ISequentialAllocator *pAllocator)
 			{
 				m_this = pAllocator->allocate(sizeof(VarFilterName), __alignof(VarFilterName));
-				m_array = pAllocator->allocate(sizeof(StringArray), __alignof(StringArray));
-				m_arrayPool = pAllocator->allocate(config.maxPatterns * config.maxPatternLen, 4);
+
+				// For m_pPatterns (array, pool & free list)
+				StringArrayConfig arrayConfig;
+				arrayConfig.allowDuplicates = false;
+				arrayConfig.maxEntries = config.maxPatterns;
+				arrayConfig.maxEntryLen = config.maxPatternLen;
+				StringArray::requiredMemoryHelper(&arrayConfig, pAllocator, &m_array);
 			}
 		};
 
@@ -71,7 +75,6 @@ namespace sce { namespace Sled
 
 		SCE_SLED_ASSERT(seats.m_this != NULL);
 		SCE_SLED_ASSERT(seats.m_array != NULL);
-		SCE_SLED_ASSERT(seats.m_arrayPool != NULL);
 
 		*pFilter = new (seats.m_this) VarFilterName(varFilterNameConfig, seats.m_array);
 		return SCE_SLED_ERROR_OK;
@@ -135,6 +138,10 @@ namespace sce { namespace Sled
 		SCE_SLED_ASSERT(pszFilter != NULL);
 
 		m_chWhat = chWhat;
+		m_bFirst = false;
+		m_bLast = false;
+		m_iPatternLens = 0;
+		m_pPatterns->clear();
 
 		const char chAsterisk = '*';
 		const std::size_t len = std::strlen(pszFilter);
@@ -203,19 +210,36 @@ namespace sce { namespace Sled
 				return false;
 
 			bool bFailed = false;
-			int iPos = -1;
+			int iStart = 0;
 			const uint16_t iCount = m_pPatterns->getNumEntries();
 
 			for (uint16_t i = 0; (i < iCount) && !bFailed; i++)
 			{
-				// Search for the pattern string in pszName
-				iPos = Utilities::findFirstOf(pszName, iter[i], iPos + 1);
+				const int patLen = (int)std::strlen(iter[i]);
+				int iPos = -1;
 
-				// Didn't find pattern string in pszName
-				if (iPos == -1)
+				if ((i == (iCount - 1)) && !m_bLast)
 				{
-					bFailed = true;
-					continue;
+					// Without a trailing asterisk the last pattern string has to
+					// end pszName and can't overlap the previous pattern string
+					iPos = nameLen - patLen;
+					if ((iPos < iStart) || (std::strcmp(pszName + iPos, iter[i]) != 0))
+					{
+						bFailed = true;
+						continue;
+					}
+				}
+				else
+				{
+					// Search for the pattern string in pszName
+					iPos = Utilities::findFirstOf(pszName, iter[i], iStart);
+
+					// Didn't find pattern string in pszName
+					if (iPos == -1)
+					{
+						bFailed = true;
+						continue;
+					}
 				}
 
 				// On first iteration check bFirst condition
@@ -225,12 +249,8 @@ namespace sce { namespace Sled
 					continue;
 				}
 
-				// On last iteration check bLast condition
-				if ((i == (iCount - 1)) && !m_bLast && (iPos != (nameLen - (int32_t)std::strlen(iter[iCount - 1]))))
-				{
-					bFailed = true;
-					continue;
-				}
+				// Next pattern string has to start after this one
+				iStart = iPos + patLen;
 			}
 
 			if (!bFailed)
@@ -248,14 +268,81 @@ namespace sce { namespace Sled
 		maxPatternLen = pConfig->maxVarFilterPatternLen;
 	}
 
+	struct VarFilterNameContainer::MatchNode
+	{
+		uint16_t	firstChild;
+		uint16_t	nextSibling;
+		uint16_t	fail;
+		uint16_t	dictLink;		///< Nearest node on the fail chain that ends a fragment
+		uint16_t	firstOutput;	///< Fragments ending at this node
+		uint8_t		ch;
+	};
+
+	struct VarFilterNameContainer::MatchOutput
+	{
+		uint16_t	filter;
+		uint16_t	fragment;
+		uint16_t	len;
+		uint16_t	next;
+	};
+
+	struct VarFilterNameContainer::MatchProgress
+	{
+		uint32_t	stamp;			///< Match the progress belongs to
+		int32_t		minStart;		///< Earliest position the next fragment can start at
+		uint16_t	next;			///< Next fragment to find
+	};
+
 	namespace
 	{
+		const uint16_t kMatchNone = 0xFFFF;
+
+		// Automaton roots; node index is the scope index. Exact filters (no
+		// asterisks) compare case insensitively so they get their own roots
+		// holding lower cased fragments
+		const uint16_t kNumMatchScopes = 4;
+		const uint16_t kNumMatchRoots = kNumMatchScopes * 2;
+
+		inline int32_t MatchScope(char chWhat)
+		{
+			switch (chWhat)
+			{
+			case 'g': return 0;
+			case 'l': return 1;
+			case 'u': return 2;
+			case 'e': return 3;
+			default: return -1;
+			}
+		}
+
+		// Every fragment is shorter than maxPatternLen so the pattern pools bound
+		// the automaton; it gets capped to what 16 bit indices can address and
+		// compile() fails over to the per-filter loop if a filter set won't fit
+		inline uint16_t MaxMatchNodes(const VarFilterNameContainerConfig& config)
+		{
+			if (config.maxNumFilters == 0)
+				return 0;
+
+			const uint32_t iNodes = kNumMatchRoots + ((uint32_t)config.maxNumFilters * config.maxPatternsPerFilter * config.maxPatternLen);
+			return (uint16_t)((iNodes < kMatchNone) ? iNodes : (kMatchNone - 1));
+		}
+
+		inline uint16_t MaxMatchOutputs(const VarFilterNameContainerConfig& config)
+		{
+			const uint32_t iOutputs = (uint32_t)config.maxNumFilters * config.maxPatternsPerFilter;
+			return (uint16_t)((iOutputs < kMatchNone) ? iOutputs : (kMatchNone - 1));
+		}
+
 		struct VarFilterNameContainerSeats
 		{
 			void *m_this;	
 			void *m_filters;
 			void *m_freeList;
 			void *m_pool;
+			void *m_nodes;
+			void *m_outputs;
+			void *m_progress;
+			void *m_queue;
 
 			void Allocate(const VarFilterNameContainerConfig& varFilterContainerConfig, ISequentialAllocator *pAllocator)
 			{
@@ -290,6 +377,12 @@ namespace sce { namespace Sled
 
 				// Restore start of pool
 				m_pool = poolStart;
+
+				// For the compiled matcher
+				m_nodes = pAllocator->allocate(sizeof(VarFilterNameContainer::MatchNode) * MaxMatchNodes(varFilterContainerConfig), __alignof(VarFilterNameContainer::MatchNode));
+				m_outputs = pAllocator->allocate(sizeof(VarFilterNameContainer::MatchOutput) * MaxMatchOutputs(varFilterContainerConfig), __alignof(VarFilterNameContainer::MatchOutput));
+				m_progress = pAllocator->allocate(sizeof(VarFilterNameContainer::MatchProgress) * varFilterContainerConfig.maxNumFilters, __alignof(VarFilterNameContainer::MatchProgress));
+				m_queue = pAllocator->allocate(sizeof(uint16_t) * MaxMatchNodes(varFilterContainerConfig), __alignof(uint16_t));
 			}
 		};
 
@@ -372,6 +465,13 @@ namespace sce { namespace Sled
 	VarFilterNameContainer::VarFilterNameContainer(const VarFilterNameContainerConfig& varFilterContainerConfig, const void *pContainerSeats)
 		: m_iMaxFilters(varFilterContainerConfig.maxNumFilters)
 		, m_iNumFilters(0)
+		, m_iMaxNodes(MaxMatchNodes(varFilterContainerConfig))
+		, m_iMaxOutputs(MaxMatchOutputs(varFilterContainerConfig))
+		, m_iNumNodes(0)
+		, m_iNumOutputs(0)
+		, m_iMatchStamp(0)
+		, m_bDirty(false)
+		, m_bCompiled(false)
 	{
 		SCE_SLED_ASSERT(pContainerSeats != NULL);
 
@@ -384,6 +484,14 @@ namespace sce { namespace Sled
 		for (uint16_t i = 0; i < m_iMaxFilters; i++)
 			m_pFreeList[i] = 1;
 
+		m_pNodes = new (pSeats->m_nodes) MatchNode[m_iMaxNodes];
+		m_pOutputs = new (pSeats->m_outputs) MatchOutput[m_iMaxOutputs];
+		m_pProgress = new (pSeats->m_progress) MatchProgress[m_iMaxFilters];
+		m_pQueue = new (pSeats->m_queue) uint16_t[m_iMaxNodes];
+
+		for (uint16_t i = 0; i < kNumMatchScopes; i++)
+			m_matchAll[i] = 0;
+
 		const VarFilterNameConfig config(&varFilterContainerConfig);
 	
 		std::size_t iSizeOfVarNameFilter = 0;		
@@ -436,6 +544,7 @@ namespace sce { namespace Sled
 			// Mark spot as not free and increment item count
 			m_pFreeList[iIndex] = 0;
 			m_iNumFilters++;	
+			m_bDirty = true;
 		}
 
 		return bRetval;
@@ -448,6 +557,13 @@ namespace sce { namespace Sled
 		if (isEmpty())
 			return false;
 
+		if (m_bDirty)
+			compile();
+
+		const int32_t iScope = MatchScope(chWhat);
+		if (m_bCompiled && (iScope != -1))
+			return isFilteredCompiled(pszName, (uint16_t)iScope);
+
 		for (uint16_t i = 0; i < m_iMaxFilters; i++)
 		{
 			// Skip free entries
@@ -483,6 +599,7 @@ namespace sce { namespace Sled
 				m_pFreeList[i] = 1;
 				// Decrement total filter count
 				m_iNumFilters--;
+				m_bDirty = true;
 			}
 		}
 	}
@@ -494,5 +611,283 @@ namespace sce { namespace Sled
 		// Mark list as free
 		for (uint16_t i = 0; i < m_iMaxFilters; i++)
 			m_pFreeList[i] = 1;
+
+		m_bDirty = true;
+	}
+
+	bool VarFilterNameContainer::compile()
+	{
+		m_bDirty = false;
+		m_bCompiled = false;
+
+		if (m_iMaxNodes == 0)
+			return false;
+
+		// Reset roots
+		for (uint16_t i = 0; i < kNumMatchRoots; i++)
+		{
+			MatchNode& root = m_pNodes[i];
+			root.firstChild = kMatchNone;
+			root.nextSibling = kMatchNone;
+			root.fail = i;
+			root.dictLink = kMatchNone;
+			root.firstOutput = kMatchNone;
+			root.ch = 0;
+		}
+
+		for (uint16_t i = 0; i < kNumMatchScopes; i++)
+			m_matchAll[i] = 0;
+
+		m_iNumNodes = kNumMatchRoots;
+		m_iNumOutputs = 0;
+
+		// Build the tries out of every filter's fragments
+		for (uint16_t i = 0; i < m_iMaxFilters; i++)
+		{
+			if (m_pFreeList[i] == 1)
+				continue;
+
+			const VarFilterName *pFilter = m_ppFilters[i];
+
+			const int32_t iScope = MatchScope((char)pFilter->m_chWhat);
+			if (iScope == -1)
+				continue;
+
+			const uint16_t iCount = pFilter->m_pPatterns->getNumEntries();
+
+			// Only asterisks; matches anything
+			if (iCount == 0)
+			{
+				m_matchAll[iScope] = 1;
+				continue;
+			}
+
+			const bool bExact = !pFilter->m_bFirst && !pFilter->m_bLast && (iCount == 1);
+			const uint16_t iRoot = (uint16_t)(bExact ? (iScope + kNumMatchScopes) : iScope);
+
+			StringArrayIndexedConstIterator iter(pFilter->m_pPatterns);
+			for (uint16_t j = 0; j < iCount; j++)
+			{
+				if (!insertFragment(iRoot, i, j, iter[j], bExact))
+				{
+					SCE_SLED_LOG(Logging::kInfo, "[SLED] Variable filters don't fit the compiled matcher; checking them one at a time!");
+					return false;
+				}
+			}
+		}
+
+		// Breadth first to set fail & dictionary links
+		uint16_t iHead = 0;
+		uint16_t iTail = 0;
+
+		for (uint16_t i = 0; i < kNumMatchRoots; i++)
+			m_pQueue[iTail++] = i;
+
+		while (iHead != iTail)
+		{
+			const uint16_t iNode = m_pQueue[iHead++];
+
+			for (uint16_t iChild = m_pNodes[iNode].firstChild; iChild != kMatchNone; iChild = m_pNodes[iChild].nextSibling)
+			{
+				MatchNode& child = m_pNodes[iChild];
+
+				if (iNode < kNumMatchRoots)
+				{
+					child.fail = iNode;
+				}
+				else
+				{
+					uint16_t iFail = m_pNodes[iNode].fail;
+					for (;;)
+					{
+						const uint16_t iNext = findChild(iFail, child.ch);
+						if (iNext != kMatchNone)
+						{
+							child.fail = iNext;
+							break;
+						}
+
+						if (iFail < kNumMatchRoots)
+						{
+							child.fail = iFail;
+							break;
+						}
+
+						iFail = m_pNodes[iFail].fail;
+					}
+				}
+
+				const MatchNode& fail = m_pNodes[child.fail];
+				child.dictLink = (fail.firstOutput != kMatchNone) ? child.fail : fail.dictLink;
+
+				m_pQueue[iTail++] = iChild;
+			}
+		}
+
+		// Fresh progress stamps
+		m_iMatchStamp = 0;
+		for (uint16_t i = 0; i < m_iMaxFilters; i++)
+			m_pProgress[i].stamp = 0;
+
+		m_bCompiled = true;
+		return true;
+	}
+
+	uint16_t VarFilterNameContainer::findChild(uint16_t iNode, uint8_t ch) const
+	{
+		for (uint16_t iChild = m_pNodes[iNode].firstChild; iChild != kMatchNone; iChild = m_pNodes[iChild].nextSibling)
+		{
+			if (m_pNodes[iChild].ch == ch)
+				return iChild;
+		}
+
+		return kMatchNone;
+	}
+
+	bool VarFilterNameContainer::insertFragment(uint16_t iRoot, uint16_t iFilter, uint16_t iFragment, const char *pszFragment, bool bLowerCase)
+	{
+		uint16_t iNode = iRoot;
+		uint16_t len = 0;
+
+		for (const char *psz = pszFragment; *psz != '\0'; ++psz, ++len)
+		{
+			const uint8_t ch = bLowerCase ? (uint8_t)::tolower((uint8_t)*psz) : (uint8_t)*psz;
+
+			uint16_t iChild = findChild(iNode, ch);
+			if (iChild == kMatchNone)
+			{
+				if (m_iNumNodes == m_iMaxNodes)
+					return false;
+
+				iChild = m_iNumNodes++;
+
+				MatchNode& child = m_pNodes[iChild];
+				child.firstChild = kMatchNone;
+				child.nextSibling = m_pNodes[iNode].firstChild;
+				child.fail = iRoot;
+				child.dictLink = kMatchNone;
+				child.firstOutput = kMatchNone;
+				child.ch = ch;
+
+				m_pNodes[iNode].firstChild = iChild;
+			}
+
+			iNode = iChild;
+		}
+
+		if (m_iNumOutputs == m_iMaxOutputs)
+			return false;
+
+		const uint16_t iOutput = m_iNumOutputs++;
+
+		MatchOutput& output = m_pOutputs[iOutput];
+		output.filter = iFilter;
+		output.fragment = iFragment;
+		output.len = len;
+		output.next = m_pNodes[iNode].firstOutput;
+
+		m_pNodes[iNode].firstOutput = iOutput;
+		return true;
+	}
+
+	bool VarFilterNameContainer::advance(const MatchOutput& output, int32_t iEnd, int32_t iNameLen)
+	{
+		const VarFilterName *pFilter = m_ppFilters[output.filter];
+
+		MatchProgress& progress = m_pProgress[output.filter];
+		if (progress.stamp != m_iMatchStamp)
+		{
+			progress.stamp = m_iMatchStamp;
+			progress.minStart = 0;
+			progress.next = 0;
+		}
+
+		// Fragments are taken in order, each at its earliest end position,
+		// which leaves the most room for the ones after it
+		if (output.fragment != progress.next)
+			return false;
+
+		const int32_t iStart = iEnd - output.len + 1;
+		if (iStart < progress.minStart)
+			return false;
+
+		if ((output.fragment == 0) && !pFilter->m_bFirst && (iStart != 0))
+			return false;
+
+		const uint16_t iCount = pFilter->m_pPatterns->getNumEntries();
+
+		// Without a trailing asterisk the last fragment has to end the name
+		if ((output.fragment == (iCount - 1)) && !pFilter->m_bLast)
+			return iEnd == (iNameLen - 1);
+
+		progress.minStart = iEnd + 1;
+		progress.next++;
+
+		return progress.next == iCount;
+	}
+
+	bool VarFilterNameContainer::isFilteredCompiled(const char *pszName, uint16_t iRoot)
+	{
+		const int32_t nameLen = (int32_t)std::strlen(pszName);
+		if (nameLen <= 0)
+			return false;
+
+		if (m_matchAll[iRoot] != 0)
+			return true;
+
+		// Progress entries from earlier names get reset on first use
+		if (++m_iMatchStamp == 0)
+		{
+			for (uint16_t i = 0; i < m_iMaxFilters; i++)
+				m_pProgress[i].stamp = 0;
+
+			m_iMatchStamp = 1;
+		}
+
+		// Only walk the lower cased automaton if the scope has exact filters
+		const uint16_t iLowerRoot = iRoot + kNumMatchScopes;
+		const bool bAnyExact = m_pNodes[iLowerRoot].firstChild != kMatchNone;
+
+		uint16_t iNode = iRoot;
+		uint16_t iLowerNode = iLowerRoot;
+
+		for (int32_t i = 0; i < nameLen; i++)
+		{
+			const uint8_t ch = (uint8_t)pszName[i];
+
+			if (step(iNode, ch, i, nameLen))
+				return true;
+
+			if (bAnyExact && step(iLowerNode, (uint8_t)::tolower(ch), i, nameLen))
+				return true;
+		}
+
+		return false;
+	}
+
+	bool VarFilterNameContainer::step(uint16_t& iNode, uint8_t ch, int32_t iPos, int32_t iNameLen)
+	{
+		uint16_t iNext = findChild(iNode, ch);
+		while ((iNext == kMatchNone) && (iNode >= kNumMatchRoots))
+		{
+			iNode = m_pNodes[iNode].fail;
+			iNext = findChild(iNode, ch);
+		}
+
+		if (iNext != kMatchNone)
+			iNode = iNext;
+
+		// Every fragment ending here
+		const MatchNode& node = m_pNodes[iNode];
+		for (uint16_t iHit = (node.firstOutput != kMatchNone) ? iNode : node.dictLink; iHit != kMatchNone; iHit = m_pNodes[iHit].dictLink)
+		{
+			for (uint16_t iOutput = m_pNodes[iHit].firstOutput; iOutput != kMatchNone; iOutput = m_pOutputs[iOutput].next)
+			{
+				if (advance(m_pOutputs[iOutput], iPos, iNameLen))
+					return true;
+			}
+		}
+
+		return false;
 	}
 }}
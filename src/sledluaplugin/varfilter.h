@@ -83,11 +83,42 @@ namespace sce { namespace Sled
 		bool isFiltered(const char *pszName, char chWhat);
 		void clear(char chWhat);
 		void clearAll();
+
+		// Builds one Aho-Corasick automaton per scope ('g', 'l', 'u', 'e') over
+		// the literal fragments of every filter so isFiltered is a single pass
+		// over the name. Called when a filter update ends; isFiltered compiles
+		// lazily if the filters changed since. Returns false (and isFiltered
+		// falls back to testing each filter) if the automaton doesn't fit.
+		bool compile();
+		bool isCompiled() const { return m_bCompiled; }
+	public:
+		struct MatchNode;
+		struct MatchOutput;
+		struct MatchProgress;
+	private:
+		uint16_t findChild(uint16_t iNode, uint8_t ch) const;
+		bool insertFragment(uint16_t iRoot, uint16_t iFilter, uint16_t iFragment, const char *pszFragment, bool bLowerCase);
+		bool advance(const MatchOutput& output, int32_t iEnd, int32_t iNameLen);
+		bool step(uint16_t& iNode, uint8_t ch, int32_t iPos, int32_t iNameLen);
+		bool isFilteredCompiled(const char *pszName, uint16_t iRoot);
 	private:
 		const uint16_t		m_iMaxFilters;
 		uint16_t			m_iNumFilters;
 		VarFilterName**		m_ppFilters;
 		uint8_t*			m_pFreeList;
+
+		const uint16_t		m_iMaxNodes;
+		const uint16_t		m_iMaxOutputs;
+		uint16_t			m_iNumNodes;
+		uint16_t			m_iNumOutputs;
+		uint32_t			m_iMatchStamp;
+		bool				m_bDirty;
+		bool				m_bCompiled;
+		uint8_t				m_matchAll[4];
+		MatchNode*			m_pNodes;
+		MatchOutput*		m_pOutputs;
+		MatchProgress*		m_pProgress;
+		uint16_t*			m_pQueue;
 	};
 }}
 
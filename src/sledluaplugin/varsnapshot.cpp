@@ -0,0 +1,378 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "varsnapshot.h"
+#include "sledluaplugin.h"
+#include "scmp.h"
+#include "../sleddebugger/assert.h"
+#include "../sleddebugger/errorcodes.h"
+#include "../sleddebugger/sequentialallocator.h"
+
+#include <new>
+#include <cstring>
+
+namespace sce { namespace Sled
+{
+	void VarSnapshotConfig::init(const VarSnapshotConfig& rhs)
+	{
+		maxVars = rhs.maxVars;
+		maxNameBytes = rhs.maxNameBytes;
+	}
+
+	VarSnapshotConfig::VarSnapshotConfig(const LuaPluginConfig *pConfig)
+	{
+		SCE_SLED_ASSERT(pConfig != NULL);
+
+		maxVars = pConfig->maxSnapshotVars;
+		maxNameBytes = pConfig->maxSnapshotNameBytes;
+	}
+
+	namespace
+	{
+		const uint32_t kEmptySlot = 0xFFFFFFFF;
+
+		// Largest variable count that still lets the slot count fit in 32 bits
+		const uint32_t kMaxVarsLimit = 0x40000000;
+
+		const uint32_t kFNV1AOffset = 2166136261u;
+		const uint32_t kFNV1APrime = 16777619u;
+
+		inline uint32_t SlotCount(uint32_t iMaxVars)
+		{
+			if (iMaxVars == 0)
+				return 0;
+
+			// Power of two with at least half the slots free when full
+			uint32_t iSize = 1;
+			while (iSize < (iMaxVars * 2))
+				iSize <<= 1;
+
+			return iSize;
+		}
+
+		inline uint32_t HashBytes(uint32_t iHash, const void *pData, std::size_t iLen)
+		{
+			const uint8_t *pBytes = static_cast<const uint8_t*>(pData);
+			for (std::size_t i = 0; i < iLen; i++)
+				iHash = (iHash ^ pBytes[i]) * kFNV1APrime;
+
+			return iHash;
+		}
+
+		inline uint32_t HashString(uint32_t iHash, const char *pszStr)
+		{
+			return HashBytes(iHash, pszStr, std::strlen(pszStr));
+		}
+
+		struct VarSnapshotSeats
+		{
+			void *m_this;
+			void *m_entries[2];
+			void *m_slots[2];
+			void *m_names[2];
+
+			void Allocate(const VarSnapshotConfig& snapshotConfig, ISequentialAllocator *pAllocator)
+			{
+				// For this
+				m_this = pAllocator->allocate(sizeof(VarSnapshot), __alignof(VarSnapshot));
+
+				// For the previous and current stop
+				for (int i = 0; i < 2; i++)
+				{
+					m_entries[i] = pAllocator->allocate(sizeof(VarSnapshotEntry) * snapshotConfig.maxVars, __alignof(VarSnapshotEntry));
+					m_slots[i] = pAllocator->allocate(sizeof(uint32_t) * SlotCount(snapshotConfig.maxVars), __alignof(uint32_t));
+					m_names[i] = pAllocator->allocate(sizeof(char) * snapshotConfig.maxNameBytes, __alignof(char));
+				}
+			}
+		};
+
+		inline int32_t ValidateConfig(const VarSnapshotConfig& config)
+		{
+			if (config.maxVars > kMaxVarsLimit)
+				return SCE_SLED_ERROR_INVALIDCONFIGURATION;
+
+			if ((config.maxVars != 0) && (config.maxNameBytes == 0))
+				return SCE_SLED_ERROR_INVALIDCONFIGURATION;
+
+			return SCE_SLED_ERROR_OK;
+		}
+	}
+
+	int32_t VarSnapshot::create(const VarSnapshotConfig& snapshotConfig, void *pLocation, VarSnapshot **ppSnapshot)
+	{
+		SCE_SLED_ASSERT(pLocation != NULL);
+		SCE_SLED_ASSERT(ppSnapshot != NULL);
+
+		std::size_t iMemSize = 0;
+
+		const int32_t iConfigError = requiredMemory(snapshotConfig, &iMemSize);
+		if (iConfigError != 0)
+			return iConfigError;
+
+		SequentialAllocator allocator(pLocation, iMemSize);
+
+		VarSnapshotSeats seats;
+		seats.Allocate(snapshotConfig, &allocator);
+
+		SCE_SLED_ASSERT(seats.m_this != NULL);
+		SCE_SLED_ASSERT(seats.m_entries[0] != NULL);
+		SCE_SLED_ASSERT(seats.m_entries[1] != NULL);
+		SCE_SLED_ASSERT(seats.m_slots[0] != NULL);
+		SCE_SLED_ASSERT(seats.m_slots[1] != NULL);
+		SCE_SLED_ASSERT(seats.m_names[0] != NULL);
+		SCE_SLED_ASSERT(seats.m_names[1] != NULL);
+
+		*ppSnapshot = new (seats.m_this) VarSnapshot(snapshotConfig, &seats);
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t VarSnapshot::requiredMemory(const VarSnapshotConfig& snapshotConfig, std::size_t *iRequiredMemory)
+	{
+		SCE_SLED_ASSERT(iRequiredMemory != NULL);
+
+		const int32_t iConfigError = ValidateConfig(snapshotConfig);
+		if (iConfigError != 0)
+			return iConfigError;
+
+		SequentialAllocatorCalculator allocator;
+
+		VarSnapshotSeats seats;
+		seats.Allocate(snapshotConfig, &allocator);
+
+		*iRequiredMemory = allocator.bytesAllocated();
+		return SCE_SLED_ERROR_OK;
+	}
+
+	int32_t VarSnapshot::requiredMemoryHelper(const VarSnapshotConfig& snapshotConfig, ISequentialAllocator *pAllocator, void **ppThis)
+	{
+		SCE_SLED_ASSERT(pAllocator != NULL);
+		SCE_SLED_ASSERT(ppThis != NULL);
+
+		const int32_t iConfigError = ValidateConfig(snapshotConfig);
+		if (iConfigError != 0)
+			return iConfigError;
+
+		VarSnapshotSeats seats;
+		seats.Allocate(snapshotConfig, pAllocator);
+
+		*ppThis = seats.m_this;
+		return SCE_SLED_ERROR_OK;
+	}
+
+	void VarSnapshot::shutdown(VarSnapshot *pSnapshot)
+	{
+		SCE_SLED_ASSERT(pSnapshot != NULL);
+		pSnapshot->~VarSnapshot();
+	}
+
+	VarSnapshot::VarSnapshot(const VarSnapshotConfig& snapshotConfig, const void *pSnapshotSeats)
+		: m_iMaxVars(snapshotConfig.maxVars)
+		, m_iMaxNameBytes(snapshotConfig.maxNameBytes)
+		, m_iNumSlots(SlotCount(snapshotConfig.maxVars))
+		, m_pPrev(&m_gens[0])
+		, m_pCur(&m_gens[1])
+	{
+		SCE_SLED_ASSERT(pSnapshotSeats != NULL);
+
+		const VarSnapshotSeats *pSeats = static_cast<const VarSnapshotSeats*>(pSnapshotSeats);
+
+		for (int i = 0; i < 2; i++)
+		{
+			m_gens[i].entries = new (pSeats->m_entries[i]) VarSnapshotEntry[m_iMaxVars];
+			m_gens[i].slots = new (pSeats->m_slots[i]) uint32_t[m_iNumSlots];
+			m_gens[i].names = new (pSeats->m_names[i]) char[m_iMaxNameBytes];
+		}
+
+		clear();
+	}
+
+	void VarSnapshot::clear()
+	{
+		clearGeneration(m_pPrev, m_iNumSlots);
+		clearGeneration(m_pCur, m_iNumSlots);
+
+		m_pOwner = 0;
+		m_bPrevValid = false;
+		m_bFull = true;
+		m_bOverflow = false;
+		m_bTruncated = false;
+
+		m_iNumAdded = 0;
+		m_iNumChanged = 0;
+		m_iNumUnchanged = 0;
+	}
+
+	void VarSnapshot::begin(const void *pOwner)
+	{
+		m_bFull = !m_bPrevValid || (pOwner != m_pOwner);
+		m_bOverflow = false;
+		m_bTruncated = false;
+		m_pOwner = pOwner;
+
+		// Nothing to diff against so nothing can be reported as removed
+		if (m_bFull)
+			clearGeneration(m_pPrev, m_iNumSlots);
+
+		clearGeneration(m_pCur, m_iNumSlots);
+
+		m_iNumAdded = 0;
+		m_iNumChanged = 0;
+		m_iNumUnchanged = 0;
+	}
+
+	bool VarSnapshot::update(char chWhat, int32_t iStackLevel, int32_t iIndex, const char *pszName, int32_t iNameType, const char *pszValue, int32_t iValueType)
+	{
+		SCE_SLED_ASSERT(pszValue != NULL);
+		return update(chWhat, iStackLevel, iIndex, pszName, iNameType, pszValue, std::strlen(pszValue), iValueType);
+	}
+
+	bool VarSnapshot::update(char chWhat, int32_t iStackLevel, int32_t iIndex, const char *pszName, int32_t iNameType, const void *pValue, std::size_t iValueLen, int32_t iValueType)
+	{
+		SCE_SLED_ASSERT(pValue != NULL);
+
+		if (!isEnabled())
+			return true;
+
+		return updateHashed(chWhat, iStackLevel, iIndex, pszName, iNameType, HashBytes(HashBytes(kFNV1AOffset, &iValueType, sizeof(iValueType)), pValue, iValueLen));
+	}
+
+	bool VarSnapshot::update(char chWhat, int32_t iStackLevel, int32_t iIndex, const char *pszName, int32_t iNameType, const SCMP::VarValue& value, int32_t iValueType)
+	{
+		if (!isEnabled())
+			return true;
+
+		uint32_t iValueHash = HashBytes(HashBytes(kFNV1AOffset, &iValueType, sizeof(iValueType)), value.getData(), value.getDataLen());
+
+		// Only the first part of a long string is kept, so strings that
+		// differ past it are told apart by their full length
+		if (value.kind == SCMP::VarValue::kString)
+		{
+			iValueHash = HashBytes(iValueHash, &value.length, sizeof(value.length));
+			iValueHash = HashBytes(iValueHash, &value.truncated, sizeof(value.truncated));
+		}
+
+		return updateHashed(chWhat, iStackLevel, iIndex, pszName, iNameType, iValueHash);
+	}
+
+	bool VarSnapshot::updateHashed(char chWhat, int32_t iStackLevel, int32_t iIndex, const char *pszName, int32_t iNameType, uint32_t iValueHash)
+	{
+		SCE_SLED_ASSERT(pszName != NULL);
+
+		VarSnapshotEntry entry;
+		entry.keyHash = HashString(HashBytes(HashBytes(HashBytes(kFNV1AOffset, &chWhat, sizeof(chWhat)), &iStackLevel, sizeof(iStackLevel)), &iIndex, sizeof(iIndex)), pszName);
+		entry.valueHash = iValueHash;
+		entry.nameOffset = 0;
+		entry.index = iIndex;
+		entry.stackLevel = (int16_t)iStackLevel;
+		entry.nameType = (int16_t)iNameType;
+		entry.what = chWhat;
+		entry.matched = 0;
+
+		if (!insert(m_pCur, entry, pszName))
+			m_bOverflow = true;
+
+		if (m_bFull)
+		{
+			++m_iNumAdded;
+			return true;
+		}
+
+		VarSnapshotEntry *pPrev = find(m_pPrev, entry.keyHash, chWhat, iStackLevel, iIndex, pszName);
+		if ((pPrev == NULL) || (pPrev->matched != 0))
+		{
+			++m_iNumAdded;
+			return true;
+		}
+
+		pPrev->matched = 1;
+
+		if (pPrev->valueHash != entry.valueHash)
+		{
+			++m_iNumChanged;
+			return true;
+		}
+
+		++m_iNumUnchanged;
+		return false;
+	}
+
+	void VarSnapshot::end()
+	{
+		// Current stop becomes the one the next stop diffs against; a stop
+		// that did not fit or was cut short is not a usable base
+		Generation *pTemp = m_pPrev;
+		m_pPrev = m_pCur;
+		m_pCur = pTemp;
+
+		m_bPrevValid = !m_bOverflow && !m_bTruncated;
+	}
+
+	const VarSnapshotEntry *VarSnapshot::getRemoved(uint32_t iIndex) const
+	{
+		if (iIndex >= m_pPrev->numEntries)
+			return 0;
+
+		const VarSnapshotEntry *pEntry = &m_pPrev->entries[iIndex];
+		return (pEntry->matched == 0) ? pEntry : 0;
+	}
+
+	const char *VarSnapshot::getRemovedName(const VarSnapshotEntry *pEntry) const
+	{
+		SCE_SLED_ASSERT(pEntry != NULL);
+		return m_pPrev->names + pEntry->nameOffset;
+	}
+
+	void VarSnapshot::clearGeneration(Generation *pGen, uint32_t iNumSlots)
+	{
+		if (iNumSlots != 0)
+			std::memset(pGen->slots, 0xFF, sizeof(uint32_t) * iNumSlots);
+
+		pGen->numEntries = 0;
+		pGen->nameBytes = 0;
+	}
+
+	VarSnapshotEntry *VarSnapshot::find(Generation *pGen, uint32_t iKeyHash, char chWhat, int32_t iStackLevel, int32_t iIndex, const char *pszName) const
+	{
+		const uint32_t iMask = m_iNumSlots - 1;
+
+		for (uint32_t iSlot = iKeyHash & iMask; pGen->slots[iSlot] != kEmptySlot; iSlot = (iSlot + 1) & iMask)
+		{
+			VarSnapshotEntry *pEntry = &pGen->entries[pGen->slots[iSlot]];
+
+			if ((pEntry->keyHash == iKeyHash) &&
+				(pEntry->what == chWhat) &&
+				(pEntry->stackLevel == iStackLevel) &&
+				(pEntry->index == iIndex) &&
+				(std::strcmp(pGen->names + pEntry->nameOffset, pszName) == 0))
+				return pEntry;
+		}
+
+		return 0;
+	}
+
+	bool VarSnapshot::insert(Generation *pGen, const VarSnapshotEntry& entry, const char *pszName)
+	{
+		const std::size_t iNameLen = std::strlen(pszName) + 1;
+
+		if ((pGen->numEntries >= m_iMaxVars) || ((pGen->nameBytes + iNameLen) > m_iMaxNameBytes))
+			return false;
+
+		const uint32_t iMask = m_iNumSlots - 1;
+
+		uint32_t iSlot = entry.keyHash & iMask;
+		while (pGen->slots[iSlot] != kEmptySlot)
+			iSlot = (iSlot + 1) & iMask;
+
+		VarSnapshotEntry *pEntry = &pGen->entries[pGen->numEntries];
+		(*pEntry) = entry;
+		pEntry->nameOffset = pGen->nameBytes;
+
+		std::memcpy(pGen->names + pGen->nameBytes, pszName, iNameLen);
+		pGen->nameBytes += (uint32_t)iNameLen;
+
+		pGen->slots[iSlot] = pGen->numEntries++;
+		return true;
+	}
+}}
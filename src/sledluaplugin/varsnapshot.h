@@ -0,0 +1,126 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#ifndef __SCE_LIBSLEDLUAPLUGIN_VARSNAPSHOT_H__
+#define __SCE_LIBSLEDLUAPLUGIN_VARSNAPSHOT_H__
+
+#include "../sledcore/base_types.h"
+#include <cstddef>
+
+#include "../sleddebugger/common.h"
+
+namespace sce { namespace Sled
+{
+	// Forward declarations
+	class ISequentialAllocator;
+
+	// Forward declarations
+	struct LuaPluginConfig;
+	namespace SCMP { struct VarValue; }
+
+	struct SCE_SLED_LINKAGE VarSnapshotEntry
+	{
+		uint32_t	keyHash;
+		uint32_t	valueHash;
+		uint32_t	nameOffset;
+		int32_t		index;
+		int16_t		stackLevel;
+		int16_t		nameType;
+		char		what;
+		uint8_t		matched;
+	};
+
+	struct SCE_SLED_LINKAGE VarSnapshotConfig
+	{
+		VarSnapshotConfig() : maxVars(0), maxNameBytes(0) {}
+		VarSnapshotConfig(const VarSnapshotConfig& rhs) { init(rhs); }
+		VarSnapshotConfig& operator=(const VarSnapshotConfig& rhs) { init(rhs); return *this; }
+
+		VarSnapshotConfig(const LuaPluginConfig *pConfig);
+
+	private:
+		void init(const VarSnapshotConfig& rhs);
+	public:
+
+		uint32_t		maxVars;		///< Maximum number of variables remembered per stop (0 disables snapshot diffing)
+		uint32_t		maxNameBytes;	///< Size, in bytes, of the variable name storage per stop
+	};
+
+	class SCE_SLED_LINKAGE VarSnapshot
+	{
+		// Fingerprints of the variables sent at one stop
+		struct Generation
+		{
+			VarSnapshotEntry*	entries;
+			uint32_t*			slots;
+			char*				names;
+			uint32_t			numEntries;
+			uint32_t			nameBytes;
+		};
+	public:
+		static int32_t create(const VarSnapshotConfig& snapshotConfig, void *pLocation, VarSnapshot **ppSnapshot);
+		static int32_t requiredMemory(const VarSnapshotConfig& snapshotConfig, std::size_t *iRequiredMemory);
+		static int32_t requiredMemoryHelper(const VarSnapshotConfig& snapshotConfig, ISequentialAllocator *pAllocator, void **ppThis);
+		static void shutdown(VarSnapshot *pSnapshot);
+	private:
+		VarSnapshot(const VarSnapshotConfig& snapshotConfig, const void *pSnapshotSeats);
+		~VarSnapshot() {}
+		VarSnapshot(const VarSnapshot&);
+		VarSnapshot& operator=(const VarSnapshot&);
+	public:
+		void clear();
+
+		// A stop is full (not a diff) when there is no usable previous
+		// stop: first stop, different owner or the last stop overflowed
+		void begin(const void *pOwner);
+		bool update(char chWhat, int32_t iStackLevel, int32_t iIndex, const char *pszName, int32_t iNameType, const char *pszValue, int32_t iValueType);
+		bool update(char chWhat, int32_t iStackLevel, int32_t iIndex, const char *pszName, int32_t iNameType, const void *pValue, std::size_t iValueLen, int32_t iValueType);
+		bool update(char chWhat, int32_t iStackLevel, int32_t iIndex, const char *pszName, int32_t iNameType, const SCMP::VarValue& value, int32_t iValueType);
+		void end();
+
+		// The current stop was cut short: nothing is reported removed
+		// and the next stop is full
+		inline void truncate()							{ m_bTruncated = true; }
+
+		// Entries of the previous stop not seen during the current one;
+		// only valid between begin() and end()
+		const VarSnapshotEntry *getRemoved(uint32_t iIndex) const;
+		const char *getRemovedName(const VarSnapshotEntry *pEntry) const;
+
+		inline bool isEnabled() const					{ return m_iMaxVars != 0; }
+		inline bool isFull() const						{ return m_bFull; }
+		inline bool isTruncated() const					{ return m_bTruncated; }
+		inline uint32_t getNumPrevious() const			{ return m_pPrev->numEntries; }
+		inline uint32_t getNumAdded() const				{ return m_iNumAdded; }
+		inline uint32_t getNumChanged() const			{ return m_iNumChanged; }
+		inline uint32_t getNumUnchanged() const			{ return m_iNumUnchanged; }
+		inline uint32_t getNumRemoved() const			{ return m_pPrev->numEntries - (m_iNumChanged + m_iNumUnchanged); }
+	private:
+		static void clearGeneration(Generation *pGen, uint32_t iNumSlots);
+		bool updateHashed(char chWhat, int32_t iStackLevel, int32_t iIndex, const char *pszName, int32_t iNameType, uint32_t iValueHash);
+		VarSnapshotEntry *find(Generation *pGen, uint32_t iKeyHash, char chWhat, int32_t iStackLevel, int32_t iIndex, const char *pszName) const;
+		bool insert(Generation *pGen, const VarSnapshotEntry& entry, const char *pszName);
+	private:
+		const uint32_t		m_iMaxVars;
+		const uint32_t		m_iMaxNameBytes;
+		const uint32_t		m_iNumSlots;
+
+		Generation			m_gens[2];
+		Generation*			m_pPrev;
+		Generation*			m_pCur;
+
+		const void*			m_pOwner;
+		bool				m_bPrevValid;
+		bool				m_bFull;
+		bool				m_bOverflow;
+		bool				m_bTruncated;
+
+		uint32_t			m_iNumAdded;
+		uint32_t			m_iNumChanged;
+		uint32_t			m_iNumUnchanged;
+	};
+}}
+
+#endif // __SCE_LIBSLEDLUAPLUGIN_VARSNAPSHOT_H__
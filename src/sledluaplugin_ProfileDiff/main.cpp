@@ -0,0 +1,512 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+//
+// Compares two profile captures written by luaPluginWriteProfileCapture,
+// typically of the same scripted run on two builds, and prints the
+// functions whose time, or with -a bytes allocated, grew past a
+// threshold. Exits with 1 if any did, so it can gate a build in CI.
+//
+// Usage: sce_sledprofilediff [options] <baseline capture> <candidate capture>
+//
+
+#include "../sledluaplugin/profilecapturewriter.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace sce::Sled;
+
+namespace
+{
+	const int kExitSame = 0;
+	const int kExitRegressed = 1;
+	const int kExitError = 2;
+
+	struct Function
+	{
+		std::string	name;
+		std::string	file;
+		int32_t		line;
+		uint32_t	callCount;
+		uint64_t	timeElapsed;
+		uint64_t	timeInnerElapsed;
+		uint64_t	timeElapsedCorrected;
+		uint64_t	timeInnerElapsedCorrected;
+		uint32_t	allocCount;
+		uint64_t	allocBytes;
+	};
+
+	struct Capture
+	{
+		Capture() : timeProfiled(0), numFrames(0), calibrationCalls(0) {}
+
+		std::string				buildId;
+		uint64_t				timeProfiled;
+		uint64_t				numFrames;
+		uint64_t				calibrationCalls;
+		std::vector<Function>	functions;
+	};
+
+	// Functions are the same across captures if their name, file & line are
+	struct FunctionKey
+	{
+		FunctionKey(const Function& function) : name(&function.name), file(&function.file), line(function.line) {}
+
+		bool operator<(const FunctionKey& rhs) const
+		{
+			const int iName = name->compare(*rhs.name);
+			if (iName != 0)
+				return iName < 0;
+
+			const int iFile = file->compare(*rhs.file);
+			if (iFile != 0)
+				return iFile < 0;
+
+			return line < rhs.line;
+		}
+
+		const std::string	*name;
+		const std::string	*file;
+		int32_t				line;
+	};
+
+	class CaptureReader
+	{
+	public:
+		CaptureReader(const std::vector<uint8_t>& data) : m_data(data), m_iPos(0), m_bFailed(false) {}
+
+		uint8_t byte()
+		{
+			if (m_iPos >= m_data.size())
+			{
+				m_bFailed = true;
+				return 0;
+			}
+
+			return m_data[m_iPos++];
+		}
+
+		uint64_t varint()
+		{
+			uint64_t iValue = 0;
+			for (int iShift = 0; iShift < 64; iShift += 7)
+			{
+				const uint8_t iByte = byte();
+				iValue |= (uint64_t)(iByte & 0x7F) << iShift;
+				if ((iByte & 0x80) == 0)
+					return iValue;
+			}
+
+			m_bFailed = true;
+			return 0;
+		}
+
+		int64_t signedVarint()
+		{
+			const uint64_t iValue = varint();
+			return (iValue & 1) ? ~(int64_t)(iValue >> 1) : (int64_t)(iValue >> 1);
+		}
+
+		std::string string()
+		{
+			const uint64_t iLen = varint();
+			if (iLen > (m_data.size() - m_iPos))
+			{
+				m_bFailed = true;
+				return std::string();
+			}
+
+			const std::string str(m_data.begin() + m_iPos, m_data.begin() + m_iPos + (std::size_t)iLen);
+			m_iPos += (std::size_t)iLen;
+			return str;
+		}
+
+		inline bool hasFailed() const { return m_bFailed; }
+	private:
+		const std::vector<uint8_t>&	m_data;
+		std::size_t					m_iPos;
+		bool						m_bFailed;
+	};
+
+	bool ReadFile(const char *pszPath, std::vector<uint8_t> *pData)
+	{
+		FILE *pFile = std::fopen(pszPath, "rb");
+		if (!pFile)
+			return false;
+
+		uint8_t buffer[4096];
+		std::size_t iRead;
+		while ((iRead = std::fread(buffer, 1, sizeof(buffer), pFile)) > 0)
+			pData->insert(pData->end(), buffer, buffer + iRead);
+
+		const bool bOk = (std::ferror(pFile) == 0);
+		std::fclose(pFile);
+		return bOk;
+	}
+
+	bool LoadCapture(const char *pszPath, Capture *pCapture)
+	{
+		std::vector<uint8_t> data;
+		if (!ReadFile(pszPath, &data))
+		{
+			std::fprintf(stderr, "%s: can't read file\n", pszPath);
+			return false;
+		}
+
+		CaptureReader reader(data);
+		if ((reader.byte() != 'S') || (reader.byte() != 'L') || (reader.byte() != 'P') || (reader.byte() != 'C'))
+		{
+			std::fprintf(stderr, "%s: not a profile capture\n", pszPath);
+			return false;
+		}
+
+		const uint8_t iVersion = reader.byte();
+		// Version 1 is the same less the memory records
+		if ((iVersion < 1) || (iVersion > ProfileCaptureWriter::kVersion))
+		{
+			std::fprintf(stderr, "%s: capture version %u; only versions 1 to %u are supported\n", pszPath, (unsigned)iVersion, (unsigned)ProfileCaptureWriter::kVersion);
+			return false;
+		}
+
+		for (;;)
+		{
+			const uint8_t iTag = reader.byte();
+			if (reader.hasFailed())
+				break;
+
+			if (iTag == ProfileCaptureWriter::kTagEnd)
+			{
+				if (reader.varint() != pCapture->functions.size())
+					break;
+
+				return true;
+			}
+			else if (iTag == ProfileCaptureWriter::kTagInfo)
+			{
+				pCapture->buildId = reader.string();
+				reader.varint();
+				reader.varint();
+				reader.varint();
+				pCapture->timeProfiled = reader.varint();
+				pCapture->numFrames = reader.varint();
+				pCapture->calibrationCalls = reader.varint();
+				reader.varint();
+				reader.varint();
+			}
+			else if (iTag == ProfileCaptureWriter::kTagFunction)
+			{
+				Function function;
+				function.name = reader.string();
+				function.file = reader.string();
+				function.line = (int32_t)reader.signedVarint();
+				function.callCount = (uint32_t)reader.varint();
+				function.timeElapsed = reader.varint();
+				reader.varint();
+				reader.varint();
+				function.timeInnerElapsed = reader.varint();
+				reader.varint();
+				reader.varint();
+				function.timeElapsedCorrected = reader.varint();
+				function.timeInnerElapsedCorrected = reader.varint();
+				function.allocCount = 0;
+				function.allocBytes = 0;
+				pCapture->functions.push_back(function);
+			}
+			else if (iTag == ProfileCaptureWriter::kTagEdge)
+			{
+				reader.varint();
+				reader.varint();
+			}
+			else if (iTag == ProfileCaptureWriter::kTagCallPath)
+			{
+				for (int i = 0; i < 4; i++)
+					reader.varint();
+			}
+			else if (iTag == ProfileCaptureWriter::kTagHistogram)
+			{
+				reader.varint();
+				reader.byte();
+				reader.varint();
+				reader.varint();
+
+				const uint64_t iNumUsed = reader.varint();
+				for (uint64_t i = 0; (i < iNumUsed) && !reader.hasFailed(); i++)
+				{
+					reader.varint();
+					reader.varint();
+				}
+			}
+			else if ((iTag == ProfileCaptureWriter::kTagMemory) && (iVersion >= 2))
+			{
+				const uint64_t iFunction = reader.varint();
+				const uint32_t iAllocCount = (uint32_t)reader.varint();
+				const uint64_t iAllocBytes = reader.varint();
+				reader.varint();
+
+				if (iFunction >= pCapture->functions.size())
+					break;
+
+				pCapture->functions[(std::size_t)iFunction].allocCount = iAllocCount;
+				pCapture->functions[(std::size_t)iFunction].allocBytes = iAllocBytes;
+			}
+			else
+			{
+				std::fprintf(stderr, "%s: unknown record %u\n", pszPath, (unsigned)iTag);
+				return false;
+			}
+		}
+
+		std::fprintf(stderr, "%s: capture is cut short or damaged\n", pszPath);
+		return false;
+	}
+
+	struct Options
+	{
+		Options() : threshold(10.0), minimum(50.0), maxListed(20), inclusive(false), allocations(false), baseline(0), candidate(0) {}
+
+		// Percent a function's value has to grow by to count as a regression
+		double		threshold;
+		// Microseconds or bytes (per frame, or per second profiled) it has to grow by
+		double		minimum;
+		std::size_t	maxListed;
+		// Compare time including the functions called rather than inner time
+		bool		inclusive;
+		// Compare bytes allocated rather than time
+		bool		allocations;
+
+		const char	*baseline;
+		const char	*candidate;
+	};
+
+	// How the two captures' times are made comparable
+	struct Scale
+	{
+		bool		perFrame;
+		bool		corrected;
+		double		baseline;
+		double		candidate;
+	};
+
+	struct Change
+	{
+		const Function	*baseline;
+		const Function	*candidate;
+		double			before;
+		double			after;
+
+		double delta() const { return after - before; }
+		double percent() const { return (before > 0.0) ? ((after - before) * 100.0 / before) : 0.0; }
+
+		// Biggest growth first
+		bool operator<(const Change& rhs) const { return delta() > rhs.delta(); }
+	};
+
+	void PrintUsage()
+	{
+		std::printf("Usage: sce_sledprofilediff [options] <baseline capture> <candidate capture>\n");
+		std::printf("\n");
+		std::printf("Lists the functions whose time grew between two profile captures written by\n");
+		std::printf("luaPluginWriteProfileCapture. Values are per frame if both captures marked frames,\n");
+		std::printf("otherwise per second profiled. Exits with 1 if any function regressed.\n");
+		std::printf("\n");
+		std::printf("  -t <percent>  growth to count as a regression (default 10)\n");
+		std::printf("  -m <amount>   smallest growth, in microseconds or bytes per frame or second, to count (default 50)\n");
+		std::printf("  -n <count>    most functions to list (default 20)\n");
+		std::printf("  -i            compare time including the functions called instead of inner time\n");
+		std::printf("  -a            compare bytes allocated instead of time; needs captures made while\n");
+		std::printf("                allocations were profiled\n");
+	}
+
+	bool ParseOptions(int argc, char **argv, Options *pOptions)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const char *pszArg = argv[i];
+
+			if ((std::strcmp(pszArg, "-t") == 0) && ((i + 1) < argc))
+				pOptions->threshold = std::atof(argv[++i]);
+			else if ((std::strcmp(pszArg, "-m") == 0) && ((i + 1) < argc))
+				pOptions->minimum = std::atof(argv[++i]);
+			else if ((std::strcmp(pszArg, "-n") == 0) && ((i + 1) < argc))
+				pOptions->maxListed = (std::size_t)std::atoi(argv[++i]);
+			else if (std::strcmp(pszArg, "-i") == 0)
+				pOptions->inclusive = true;
+			else if (std::strcmp(pszArg, "-a") == 0)
+				pOptions->allocations = true;
+			else if (pszArg[0] == '-')
+				return false;
+			else if (!pOptions->baseline)
+				pOptions->baseline = pszArg;
+			else if (!pOptions->candidate)
+				pOptions->candidate = pszArg;
+			else
+				return false;
+		}
+
+		return (pOptions->baseline != 0) && (pOptions->candidate != 0);
+	}
+
+	double FunctionValue(const Function& function, const Options& options, bool bCorrected)
+	{
+		if (options.allocations)
+			return (double)function.allocBytes;
+
+		if (options.inclusive)
+			return (double)(bCorrected ? function.timeElapsedCorrected : function.timeElapsed);
+
+		return (double)(bCorrected ? function.timeInnerElapsedCorrected : function.timeInnerElapsed);
+	}
+
+	void PrintCapture(const char *pszLabel, const char *pszPath, const Capture& capture)
+	{
+		std::printf("%s %s: build \"%s\", %.2f s profiled, %llu frames, %u functions\n",
+			pszLabel, pszPath, capture.buildId.c_str(), (double)capture.timeProfiled / 1000000.0,
+			(unsigned long long)capture.numFrames, (unsigned)capture.functions.size());
+	}
+
+	void PrintFunction(const Function& function)
+	{
+		// Functions without a name are tagged ":<line>:<file>"
+		const char *pszName = (function.name[0] == ':') ? "(anonymous)" : function.name.c_str();
+
+		if (function.line < 0)
+			std::printf("%s (%s)\n", pszName, function.file.c_str());
+		else
+			std::printf("%s (%s:%d)\n", pszName, function.file.c_str(), function.line);
+	}
+
+	void PrintChanges(const char *pszTitle, const std::vector<Change>& changes, const Options& options)
+	{
+		if (changes.empty())
+			return;
+
+		std::printf("\n%s (%u):\n", pszTitle, (unsigned)changes.size());
+		std::printf("%12s %12s %9s %16s  %s\n", "baseline", "candidate", "change", options.allocations ? "allocations" : "calls", "function");
+
+		for (std::size_t i = 0; (i < changes.size()) && (i < options.maxListed); i++)
+		{
+			const Change& change = changes[i];
+
+			// Totals for the whole capture, unlike the scaled values
+			uint32_t iCountBefore = 0;
+			if (change.baseline)
+				iCountBefore = options.allocations ? change.baseline->allocCount : change.baseline->callCount;
+			const uint32_t iCountAfter = options.allocations ? change.candidate->allocCount : change.candidate->callCount;
+
+			char szPercent[32];
+			if (change.baseline)
+				std::sprintf(szPercent, "%+.1f%%", change.percent());
+			else
+				std::sprintf(szPercent, "new");
+
+			std::printf("%12.1f %12.1f %9s %7u -> %-7u  ", change.before, change.after, szPercent, iCountBefore, iCountAfter);
+			PrintFunction(*change.candidate);
+		}
+
+		if (changes.size() > options.maxListed)
+			std::printf("... and %u more\n", (unsigned)(changes.size() - options.maxListed));
+	}
+}
+
+int main(int argc, char **argv)
+{
+	Options options;
+	if (!ParseOptions(argc, argv, &options))
+	{
+		PrintUsage();
+		return kExitError;
+	}
+
+	Capture baseline;
+	Capture candidate;
+	if (!LoadCapture(options.baseline, &baseline) || !LoadCapture(options.candidate, &candidate))
+		return kExitError;
+
+	PrintCapture("baseline: ", options.baseline, baseline);
+	PrintCapture("candidate:", options.candidate, candidate);
+
+	Scale scale;
+	scale.perFrame = (baseline.numFrames > 0) && (candidate.numFrames > 0);
+	scale.corrected = (baseline.calibrationCalls > 0) && (candidate.calibrationCalls > 0);
+	scale.baseline = scale.perFrame ? (double)baseline.numFrames : ((double)baseline.timeProfiled / 1000000.0);
+	scale.candidate = scale.perFrame ? (double)candidate.numFrames : ((double)candidate.timeProfiled / 1000000.0);
+
+	if ((scale.baseline <= 0.0) || (scale.candidate <= 0.0))
+	{
+		std::fprintf(stderr, "captures hold no profile time to compare\n");
+		return kExitError;
+	}
+
+	if (options.allocations)
+	{
+		std::printf("\ncomparing bytes allocated per %s\n", scale.perFrame ? "frame" : "second profiled");
+	}
+	else
+	{
+		std::printf("\ncomparing %s time in microseconds per %s%s\n",
+			options.inclusive ? "inclusive" : "inner", scale.perFrame ? "frame" : "second profiled",
+			scale.corrected ? ", corrected for profiler overhead" : "");
+	}
+
+	std::map<FunctionKey, const Function*> baselineFunctions;
+	for (std::size_t i = 0; i < baseline.functions.size(); i++)
+		baselineFunctions.insert(std::make_pair(FunctionKey(baseline.functions[i]), &baseline.functions[i]));
+
+	std::vector<Change> regressions;
+	std::vector<Change> added;
+	std::size_t iNumImproved = 0;
+	std::size_t iNumCompared = 0;
+
+	for (std::size_t i = 0; i < candidate.functions.size(); i++)
+	{
+		const Function& function = candidate.functions[i];
+
+		Change change;
+		change.candidate = &function;
+		change.after = FunctionValue(function, options, scale.corrected) / scale.candidate;
+
+		std::map<FunctionKey, const Function*>::const_iterator iter = baselineFunctions.find(FunctionKey(function));
+		if (iter == baselineFunctions.end())
+		{
+			change.baseline = 0;
+			change.before = 0.0;
+
+			if (change.after >= options.minimum)
+				added.push_back(change);
+			continue;
+		}
+
+		change.baseline = iter->second;
+		change.before = FunctionValue(*iter->second, options, scale.corrected) / scale.baseline;
+		iNumCompared++;
+
+		if (change.delta() >= options.minimum)
+		{
+			if ((change.before <= 0.0) || (change.percent() >= options.threshold))
+				regressions.push_back(change);
+		}
+		else if ((-change.delta() >= options.minimum) && (-change.percent() >= options.threshold))
+		{
+			iNumImproved++;
+		}
+	}
+
+	std::sort(regressions.begin(), regressions.end());
+	std::sort(added.begin(), added.end());
+
+	PrintChanges("regressions", regressions, options);
+	PrintChanges("new functions", added, options);
+
+	std::printf("\n%u functions compared: %u regressed, %u improved, %u new\n",
+		(unsigned)iNumCompared, (unsigned)regressions.size(), (unsigned)iNumImproved, (unsigned)added.size());
+
+	return regressions.empty() ? kExitSame : kExitRegressed;
+}
@@ -0,0 +1,38 @@
+-- Copyright (C) Sony Computer Entertainment America LLC. 
+-- All Rights Reserved. 
+
+--
+-- Premake build script for the sce profile capture diff tool
+--
+
+sdk_project "sce_sledprofilediff"
+	sdk_location "."
+	sdk_kind "ConsoleApp"
+
+	uuid "6B2F4E81-0C5D-4A37-9E1B-3D74A2C58F06"
+
+	configurations { sdk.DEBUG, sdk.RELEASE }
+	platforms { sdk.WIN_STATIC_ALL }
+
+	files { 
+		"*.cpp", 
+		"../sledluaplugin/profilecapturewriter.h",
+		"../sledcore/*.h",
+		"../sledcore/windows/*.h"
+	}
+	
+	vpaths {
+		["Headers"] = {
+			"**.h",
+			"../sledluaplugin/profilecapturewriter.h" } }
+	vpaths {
+		["Source"] = {
+			"**.cpp" } }
+	
+	includedirs { "../../", "../../../" }
+
+	objdir(path.join(sdk.rootdir, "tmp/sce_sled/%{prj.name}/%{sdk.platform(cfg)}"))
+	targetdir(path.join(sdk.rootdir, "bin/sce_sled/runtime/%{sdk.platform(cfg)}"))
+
+	configuration { "Debug*" }
+		defines { "SCE_SLED_ASSERT_ENABLED=1" }
@@ -0,0 +1,200 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "../sledluaplugin/sledluaplugin.h"
+#include "../sledluaplugin/coveragewriter.h"
+
+#include <unittest-cpp/UnitTest++/UnitTest++.h>
+
+#include <cstring>
+
+namespace sce { namespace Sled { namespace
+{
+	struct Output
+	{
+		Output() : size(0), numWrites(0), largestWrite(0), failAfter(-1) {}
+
+		uint8_t	data[8192];
+		int32_t	size;
+		int32_t	numWrites;
+		int32_t	largestWrite;
+		int32_t	failAfter;
+	};
+
+	bool WriteFunc(const uint8_t *pData, int32_t iSize, void *pUserData)
+	{
+		Output *pOut = static_cast<Output*>(pUserData);
+
+		if (pOut->numWrites == pOut->failAfter)
+			return false;
+
+		std::memcpy(pOut->data + pOut->size, pData, iSize);
+		pOut->size += iSize;
+		pOut->numWrites++;
+		if (iSize > pOut->largestWrite)
+			pOut->largestWrite = iSize;
+
+		return true;
+	}
+
+	struct Reader
+	{
+		Reader(const Output& out) : data(out.data), size(out.size), pos(0) {}
+
+		uint8_t byte() { return (pos < size) ? data[pos++] : 0xFF; }
+
+		uint64_t varint()
+		{
+			uint64_t iValue = 0;
+			for (int iShift = 0; pos < size; iShift += 7)
+			{
+				const uint8_t iByte = data[pos++];
+				iValue |= (uint64_t)(iByte & 0x7F) << iShift;
+				if ((iByte & 0x80) == 0)
+					break;
+			}
+			return iValue;
+		}
+
+		const uint8_t	*data;
+		int32_t			size;
+		int32_t			pos;
+	};
+
+	TEST(CoverageWriter_HeaderAndEnd)
+	{
+		Output out;
+		CoverageWriter writer(WriteFunc, &out);
+		writer.begin();
+		CHECK(writer.end());
+
+		CHECK_EQUAL(7, out.size);
+		CHECK_EQUAL(0, std::memcmp(out.data, "SLCV", 4));
+
+		Reader reader(out);
+		reader.pos = 4;
+		CHECK_EQUAL((int)CoverageWriter::kVersion, (int)reader.byte());
+		CHECK_EQUAL((int)CoverageWriter::kTagEnd, (int)reader.byte());
+		CHECK_EQUAL(0U, reader.varint());
+		CHECK_EQUAL((uint64_t)out.size, writer.getNumBytes());
+	}
+
+	TEST(CoverageWriter_Chunk)
+	{
+		// Lines 10, 11 & 13 hold code, line 10 twice (a loop)
+		const int32_t lineInfo[] = { 10, 11, 13, 10 };
+		const uint32_t counts[] = { 5, 300, 0, 0 };
+
+		Output out;
+		CoverageWriter writer(WriteFunc, &out);
+		writer.begin();
+		writer.addChunk("@test.lua", 9, lineInfo, 4, counts, 10, 4);
+		CHECK(writer.end());
+		CHECK_EQUAL(1U, writer.getNumChunks());
+
+		Reader reader(out);
+		reader.pos = 5;
+		CHECK_EQUAL((int)CoverageWriter::kTagChunk, (int)reader.byte());
+		CHECK_EQUAL(9U, reader.varint());
+		CHECK_EQUAL(0, std::memcmp(out.data + reader.pos, "@test.lua", 9));
+		reader.pos += 9;
+		CHECK_EQUAL(9U, reader.varint());
+		CHECK_EQUAL(10U, reader.varint());
+		CHECK_EQUAL(4U, reader.varint());
+		CHECK_EQUAL(0x0B, reader.byte());
+		CHECK_EQUAL(5U, reader.varint());
+		CHECK_EQUAL(300U, reader.varint());
+		CHECK_EQUAL(0U, reader.varint());
+		CHECK_EQUAL((int)CoverageWriter::kTagEnd, (int)reader.byte());
+		CHECK_EQUAL(1U, reader.varint());
+		CHECK_EQUAL(out.size, reader.pos);
+	}
+
+	TEST(CoverageWriter_NoCounts)
+	{
+		const int32_t lineInfo[] = { 3, 4 };
+
+		Output out;
+		CoverageWriter writer(WriteFunc, &out);
+		writer.begin();
+		writer.addChunk("=chunk", 2, lineInfo, 2, NULL, 0, 0);
+		writer.addChunk("=empty", 0, NULL, 0, NULL, 0, 0);
+		CHECK(writer.end());
+		CHECK_EQUAL(1U, writer.getNumChunks());
+
+		Reader reader(out);
+		reader.pos = 5;
+		CHECK_EQUAL((int)CoverageWriter::kTagChunk, (int)reader.byte());
+		reader.pos += (int32_t)reader.varint();
+		CHECK_EQUAL(2U, reader.varint());
+		CHECK_EQUAL(3U, reader.varint());
+		CHECK_EQUAL(2U, reader.varint());
+		CHECK_EQUAL(0x03, reader.byte());
+		CHECK_EQUAL(0U, reader.varint());
+		CHECK_EQUAL(0U, reader.varint());
+	}
+
+	TEST(CoverageWriter_LongChunkSplitsWrites)
+	{
+		// Every other line over several windows of code bits
+		static int32_t lineInfo[3000];
+		for (int32_t i = 0; i < 3000; i++)
+			lineInfo[i] = 1 + ((i * 2) % 6000);
+
+		Output out;
+		CoverageWriter writer(WriteFunc, &out);
+		writer.begin();
+		writer.addChunk("=long", 0, lineInfo, 3000, NULL, 0, 0);
+		CHECK(writer.end());
+
+		CHECK(out.numWrites > 1);
+		CHECK_EQUAL((int32_t)CoverageWriter::kMaxWriteSize, out.largestWrite);
+
+		Reader reader(out);
+		reader.pos = 5;
+		CHECK_EQUAL((int)CoverageWriter::kTagChunk, (int)reader.byte());
+		reader.pos += (int32_t)reader.varint();
+		reader.varint();
+		CHECK_EQUAL(1U, reader.varint());
+		const uint64_t iNumLines = reader.varint();
+		CHECK_EQUAL(5999U, iNumLines);
+
+		int32_t iCodeLines = 0;
+		for (uint64_t iGroup = 0; iGroup < iNumLines; iGroup += 8)
+		{
+			const uint8_t iBits = reader.byte();
+			CHECK_EQUAL(0, iBits & 0xAA);
+			for (int iBit = 0; iBit < 8; iBit++)
+			{
+				if (iBits & (1 << iBit))
+				{
+					CHECK_EQUAL(0U, reader.varint());
+					iCodeLines++;
+				}
+			}
+		}
+
+		CHECK_EQUAL(3000, iCodeLines);
+		CHECK_EQUAL((int)CoverageWriter::kTagEnd, (int)reader.byte());
+	}
+
+	TEST(CoverageWriter_CallbackFailureStops)
+	{
+		static int32_t lineInfo[2000];
+		for (int32_t i = 0; i < 2000; i++)
+			lineInfo[i] = i + 1;
+
+		Output out;
+		out.failAfter = 1;
+
+		CoverageWriter writer(WriteFunc, &out);
+		writer.begin();
+		writer.addChunk("=long", 0, lineInfo, 2000, NULL, 0, 0);
+		CHECK(!writer.end());
+		CHECK(writer.hasFailed());
+		CHECK_EQUAL(1, out.numWrites);
+		CHECK_EQUAL((uint64_t)CoverageWriter::kMaxWriteSize, writer.getNumBytes());
+	}
+}}}
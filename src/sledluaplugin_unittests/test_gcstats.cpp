@@ -0,0 +1,144 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "../sledluaplugin/sledluaplugin.h"
+#include "../sledluaplugin/gcstats.h"
+
+#include <unittest-cpp/UnitTest++/UnitTest++.h>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+namespace sce { namespace Sled { namespace
+{
+	class HostedGcStats
+	{
+	public:
+		HostedGcStats()
+		{
+			m_stats = 0;
+			m_statsMem = 0;
+		}
+
+		~HostedGcStats()
+		{
+			if (m_stats)
+			{
+				GcStats::shutdown(m_stats);
+				m_stats = 0;
+			}
+
+			if (m_statsMem)
+			{
+				delete [] m_statsMem;
+				m_statsMem = 0;
+			}
+		}
+
+		int32_t Setup()
+		{
+			std::size_t iMemSize;
+
+			const int32_t iError = GcStats::requiredMemory(&iMemSize);
+			if (iError != 0)
+				return iError;
+
+			m_statsMem = new char[iMemSize];
+			std::memset(m_statsMem, 0xAB, iMemSize);
+			if (!m_statsMem)
+				return -1;
+
+			return GcStats::create(m_statsMem, &m_stats);
+		}
+
+		GcStats *m_stats;
+
+	private:
+		char *m_statsMem;
+	};
+
+	struct Fixture
+	{
+		Fixture()
+		{
+		}
+
+		HostedGcStats host;
+	};
+
+	TEST_FIXTURE(Fixture, GcStats_Create)
+	{
+		CHECK_EQUAL(0, host.Setup());
+		CHECK_EQUAL(false, host.m_stats->hasData());
+		CHECK_EQUAL((uint32_t)0, host.m_stats->getNumCycles());
+	}
+
+	TEST_FIXTURE(Fixture, GcStats_NestedSteps)
+	{
+		CHECK_EQUAL(0, host.Setup());
+
+		// Full collection run from inside a step counts as one pause
+		host.m_stats->stepBegin();
+		host.m_stats->stepBegin();
+		host.m_stats->stepEnd();
+		CHECK_EQUAL(false, host.m_stats->hasData());
+		host.m_stats->stepEnd();
+
+		CHECK_EQUAL((uint32_t)1, host.m_stats->getStepPauses().count);
+
+		// Unmatched end is ignored
+		host.m_stats->stepEnd();
+		CHECK_EQUAL((uint32_t)1, host.m_stats->getStepPauses().count);
+	}
+
+	TEST_FIXTURE(Fixture, GcStats_AtomicSweepAndCycles)
+	{
+		CHECK_EQUAL(0, host.Setup());
+
+		host.m_stats->stepBegin();
+		host.m_stats->atomicBegin();
+		host.m_stats->atomicEnd();
+		host.m_stats->swept(100);
+		host.m_stats->swept(28);
+		host.m_stats->cycleEnd(4096);
+		host.m_stats->stepEnd();
+
+		CHECK_EQUAL((uint32_t)1, host.m_stats->getAtomicPauses().count);
+		CHECK_EQUAL((uint64_t)128, host.m_stats->getBytesSwept());
+		CHECK_EQUAL((uint32_t)1, host.m_stats->getNumCycles());
+		CHECK_EQUAL((uint64_t)4096, host.m_stats->getBytesInUse());
+
+		host.m_stats->clear();
+		CHECK_EQUAL(false, host.m_stats->hasData());
+		CHECK_EQUAL((uint32_t)0, host.m_stats->getAtomicPauses().count);
+		CHECK_EQUAL((uint64_t)0, host.m_stats->getBytesSwept());
+	}
+
+	TEST(GcPauseHistogram_Buckets)
+	{
+		GcPauseHistogram histogram;
+
+		const float flFirst = GcPauseHistogram::kFirstBucketUpperBound;
+
+		histogram.add(flFirst * 0.5f);
+		histogram.add(flFirst * 1.5f);
+		histogram.add(flFirst * 3.0f);
+		histogram.add(1000.0f);
+
+		CHECK_EQUAL((uint32_t)4, histogram.count);
+		CHECK_EQUAL((uint32_t)1, histogram.buckets[0]);
+		CHECK_EQUAL((uint32_t)1, histogram.buckets[1]);
+		CHECK_EQUAL((uint32_t)1, histogram.buckets[2]);
+		CHECK_EQUAL((uint32_t)1, histogram.buckets[GcPauseHistogram::kNumBuckets - 1]);
+		CHECK_CLOSE(1000.0f, histogram.longest, 0.001f);
+
+		CHECK_CLOSE(flFirst * 4.0f, GcPauseHistogram::getBucketUpperBound(2), flFirst * 0.01f);
+
+		histogram.clear();
+		CHECK_EQUAL((uint32_t)0, histogram.count);
+		CHECK_EQUAL((uint32_t)0, histogram.buckets[0]);
+	}
+}}}
@@ -0,0 +1,285 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "../sledluaplugin/sledluaplugin.h"
+#include "../sleddebugger/utilities.h"
+#include "../sleddebugger/errorcodes.h"
+#include "../sledluaplugin/heapcensus.h"
+
+#include <unittest-cpp/UnitTest++/UnitTest++.h>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+namespace sce { namespace Sled { namespace
+{
+	class HostedHeapCensusConfig
+	{
+	public:	
+		HeapCensusConfig Default()
+		{
+			HeapCensusConfig config;
+			Setup(config);
+			return config;
+		}
+	private:
+		static void Setup(HeapCensusConfig& config)
+		{
+			config.maxObjects = 64;
+			config.maxTables = 4;
+			config.maxRoots = 4;
+			config.maxDepth = 16;
+			config.timeBudget = 0.0f;
+		}
+	};
+
+	class HostedHeapCensus
+	{
+	public:
+		HostedHeapCensus()
+		{
+			m_census = 0;
+			m_censusMem = 0;
+		}
+
+		~HostedHeapCensus()
+		{
+			if (m_census)
+			{
+				HeapCensus::shutdown(m_census);
+				m_census = 0;
+			}
+
+			if (m_censusMem)
+			{
+				delete [] m_censusMem;
+				m_censusMem = 0;
+			}
+		}
+
+		int32_t Setup(const HeapCensusConfig& config)
+		{
+			std::size_t iMemSize;
+
+			const int32_t iError = HeapCensus::requiredMemory(config, &iMemSize);
+			if (iError != 0)
+				return iError;
+
+			m_censusMem = new char[iMemSize];
+			std::memset(m_censusMem, 0xAB, iMemSize);
+			if (!m_censusMem)
+				return -1;
+
+			return HeapCensus::create(config, m_censusMem, &m_census);
+		}
+
+		HeapCensus *m_census;
+
+	private:
+		char *m_censusMem;
+	};
+
+	struct Fixture
+	{
+		Fixture()
+		{
+		}
+
+		HostedHeapCensus host;
+		HostedHeapCensusConfig config;
+	};
+
+	TEST_FIXTURE(Fixture, HeapCensus_Create)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+		CHECK_EQUAL(true, host.m_census->isEnabled());
+		CHECK_EQUAL((uint32_t)0, host.m_census->getNumObjects());
+		CHECK_EQUAL((uint16_t)0, host.m_census->getNumTables());
+		CHECK_EQUAL((uint16_t)0, host.m_census->getNumRoots());
+	}
+
+	TEST_FIXTURE(Fixture, HeapCensus_CreateDisabled)
+	{
+		HeapCensusConfig censusConfig;
+		CHECK_EQUAL(0, host.Setup(censusConfig));
+		CHECK_EQUAL(false, host.m_census->isEnabled());
+
+		int iObject = 0;
+		host.m_census->begin();
+		CHECK_EQUAL(HeapCensus::kVisitSkip, host.m_census->visit(&iObject, 1));
+		host.m_census->end();
+	}
+
+	TEST_FIXTURE(Fixture, HeapCensus_InvalidConfig)
+	{
+		HeapCensusConfig censusConfig = config.Default();
+		censusConfig.maxDepth = 0;
+
+		std::size_t iMemSize;
+		CHECK_EQUAL(SCE_SLED_ERROR_INVALIDCONFIGURATION, HeapCensus::requiredMemory(censusConfig, &iMemSize));
+
+		censusConfig = config.Default();
+		censusConfig.timeBudget = -1.0f;
+		CHECK_EQUAL(SCE_SLED_ERROR_INVALIDCONFIGURATION, HeapCensus::requiredMemory(censusConfig, &iMemSize));
+	}
+
+	TEST_FIXTURE(Fixture, HeapCensus_VisitOnce)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		int objects[8];
+
+		host.m_census->begin();
+
+		for (int i = 0; i < 8; i++)
+			CHECK_EQUAL(HeapCensus::kVisitNew, host.m_census->visit(&objects[i], 1));
+
+		for (int i = 0; i < 8; i++)
+			CHECK_EQUAL(HeapCensus::kVisitSkip, host.m_census->visit(&objects[i], 1));
+
+		host.m_census->end();
+
+		CHECK_EQUAL((uint32_t)8, host.m_census->getNumObjects());
+		CHECK_EQUAL(false, host.m_census->isTruncated());
+
+		// Starting over forgets previous visits
+		host.m_census->begin();
+		CHECK_EQUAL(HeapCensus::kVisitNew, host.m_census->visit(&objects[0], 1));
+		host.m_census->end();
+
+		CHECK_EQUAL((uint32_t)1, host.m_census->getNumObjects());
+	}
+
+	TEST_FIXTURE(Fixture, HeapCensus_VisitShallower)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		int iObject = 0;
+
+		host.m_census->begin();
+
+		CHECK_EQUAL(HeapCensus::kVisitNew, host.m_census->visit(&iObject, 16));
+
+		// Deeper or as deep is skipped, closer to a root is walked again
+		CHECK_EQUAL(HeapCensus::kVisitSkip, host.m_census->visit(&iObject, 16));
+		CHECK_EQUAL(HeapCensus::kVisitAgain, host.m_census->visit(&iObject, 3));
+		CHECK_EQUAL(HeapCensus::kVisitSkip, host.m_census->visit(&iObject, 3));
+		CHECK_EQUAL(HeapCensus::kVisitSkip, host.m_census->visit(&iObject, 8));
+		CHECK_EQUAL(HeapCensus::kVisitAgain, host.m_census->visit(&iObject, 1));
+
+		host.m_census->end();
+
+		// Only counted once
+		CHECK_EQUAL((uint32_t)1, host.m_census->getNumObjects());
+	}
+
+	TEST_FIXTURE(Fixture, HeapCensus_ObjectBudget)
+	{
+		HeapCensusConfig censusConfig = config.Default();
+		censusConfig.maxObjects = 4;
+		CHECK_EQUAL(0, host.Setup(censusConfig));
+
+		int objects[8];
+
+		host.m_census->begin();
+
+		for (int i = 0; i < 4; i++)
+			CHECK_EQUAL(HeapCensus::kVisitNew, host.m_census->visit(&objects[i], 1));
+
+		CHECK_EQUAL(false, host.m_census->isTruncated());
+		CHECK_EQUAL(HeapCensus::kVisitSkip, host.m_census->visit(&objects[4], 1));
+		CHECK_EQUAL(true, host.m_census->isTruncated());
+
+		host.m_census->end();
+
+		CHECK_EQUAL((uint32_t)4, host.m_census->getNumObjects());
+	}
+
+	TEST_FIXTURE(Fixture, HeapCensus_TypeTotals)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		host.m_census->begin();
+		host.m_census->addObject(4, 32);
+		host.m_census->addObject(4, 48);
+		host.m_census->addObject(5, 100);
+		host.m_census->addObject(HeapCensus::kNumLuaTypes, 1000);
+		host.m_census->end();
+
+		CHECK_EQUAL((uint32_t)2, host.m_census->getTypeCount(4));
+		CHECK_EQUAL((uint64_t)80, host.m_census->getTypeBytes(4));
+		CHECK_EQUAL((uint32_t)1, host.m_census->getTypeCount(5));
+		CHECK_EQUAL((uint64_t)180, host.m_census->getTotalBytes());
+
+		HeapCensusSummary summary;
+		host.m_census->getSummary(&summary);
+		CHECK_EQUAL((uint64_t)180, summary.totalBytes);
+		CHECK_EQUAL((uint32_t)2, summary.typeCounts[4]);
+		CHECK_EQUAL(false, summary.truncated);
+	}
+
+	TEST_FIXTURE(Fixture, HeapCensus_LargestTables)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		const std::size_t sizes[] = { 50, 400, 10, 300, 200, 100 };
+		int tables[6];
+
+		host.m_census->begin();
+		for (int i = 0; i < 6; i++)
+			host.m_census->addTable(&tables[i], 0, 0, sizes[i]);
+		host.m_census->end();
+
+		// Only the four largest kept, largest first
+		CHECK_EQUAL((uint16_t)4, host.m_census->getNumTables());
+		CHECK_EQUAL((uint32_t)400, host.m_census->getTable(0)->bytes);
+		CHECK_EQUAL((uint32_t)300, host.m_census->getTable(1)->bytes);
+		CHECK_EQUAL((uint32_t)200, host.m_census->getTable(2)->bytes);
+		CHECK_EQUAL((uint32_t)100, host.m_census->getTable(3)->bytes);
+		CHECK_EQUAL(true, host.m_census->getTable(0)->table == &tables[1]);
+		CHECK_EQUAL(true, host.m_census->getTable(4) == NULL);
+	}
+
+	TEST_FIXTURE(Fixture, HeapCensus_LargestRoots)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		host.m_census->begin();
+
+		host.m_census->beginRoot("small");
+		host.m_census->addObject(4, 10);
+		host.m_census->endRoot();
+
+		host.m_census->beginRoot("empty");
+		host.m_census->endRoot();
+
+		host.m_census->beginRoot("large");
+		host.m_census->addObject(5, 500);
+		host.m_census->addTable(&host, 0, 1, 500);
+		host.m_census->addObject(4, 20);
+
+		// Ending the census closes the open root
+		host.m_census->end();
+
+		// Roots that retained nothing are not kept
+		CHECK_EQUAL((uint16_t)2, host.m_census->getNumRoots());
+		CHECK_EQUAL("large", host.m_census->getRoot(0)->name);
+		CHECK_EQUAL((uint32_t)2, host.m_census->getRoot(0)->objects);
+		CHECK_EQUAL((uint64_t)520, host.m_census->getRoot(0)->bytes);
+		CHECK_EQUAL("small", host.m_census->getRoot(1)->name);
+
+		// Tables remember the root they were reached from
+		CHECK_EQUAL("large", host.m_census->getTable(0)->root);
+	}
+
+	TEST(HeapCensus_Estimates)
+	{
+		CHECK_EQUAL(true, HeapCensus::estimateStringBytes(100) > HeapCensus::estimateStringBytes(10));
+		CHECK_EQUAL(true, HeapCensus::estimateTableBytes(16, 0) > HeapCensus::estimateTableBytes(0, 0));
+		CHECK_EQUAL(true, HeapCensus::estimateTableBytes(0, 16) > HeapCensus::estimateTableBytes(16, 0));
+		CHECK_EQUAL(true, HeapCensus::estimateClosureBytes(4, true) > HeapCensus::estimateClosureBytes(0, true));
+	}
+}}}
@@ -11,6 +11,8 @@
 
 #include <unittest-cpp/UnitTest++/UnitTest++.h>
 #include <string>
+#include <cstdio>
+#include <cstring>
 
 #include "logstealer.h"
 
@@ -35,6 +37,17 @@ namespace sce { namespace Sled { namespace
 			config.maxLuaStates = maxStates;
 			return config;
 		}
+
+		LuaPluginConfig DefaultWithHeapCensus()
+		{
+			LuaPluginConfig config;
+			Setup(config);
+			config.maxHeapCensusObjects = 4096;
+			config.maxHeapCensusTables = 8;
+			config.maxHeapCensusRoots = 8;
+			config.maxHeapCensusDepth = 32;
+			return config;
+		}
 	private:
 		static void Setup(LuaPluginConfig& config)
 		{
@@ -50,6 +63,11 @@ namespace sce { namespace Sled { namespace
 			config.maxProfileFunctions = 0;
 			/*config.maxProfileFunctionCalls = 0;*/
 			config.maxProfileCallStackDepth = 0;
+			config.maxHeapCensusObjects = 0;
+			config.maxHeapCensusTables = 0;
+			config.maxHeapCensusRoots = 0;
+			config.maxHeapCensusDepth = 0;
+			config.heapCensusTimeBudgetMs = 0;
 			config.maxWorkBufferSize = 1024;
 		}
 	};
@@ -166,6 +184,52 @@ namespace sce { namespace Sled { namespace
 		{
 			LuaInterface::OpenLibs(state);
 		}
+
+		// root = { [1] = { { x } }, [2] = shared } where shared = { {}, {}, ... }
+		// and x is shared itself or a new empty table. Array entries are
+		// walked in order so the deep path to shared is always walked first.
+		void SetHeapCensusSharedRoot(lua_State *state, bool bDeepIsShared)
+		{
+			LuaInterface::NewTable(state);
+			for (int i = 1; i <= 8; i++)
+			{
+				LuaInterface::PushNumber(state, i);
+				LuaInterface::NewTable(state);
+				LuaInterface::SetTable(state, -3);
+			}
+			LuaInterface::SetGlobal(state, "shared");
+
+			LuaInterface::NewTable(state);
+
+			LuaInterface::PushNumber(state, 1);
+			LuaInterface::NewTable(state);
+			LuaInterface::PushNumber(state, 1);
+			LuaInterface::NewTable(state);
+			LuaInterface::PushNumber(state, 1);
+			if (bDeepIsShared)
+				LuaInterface::GetGlobal(state, "shared");
+			else
+				LuaInterface::NewTable(state);
+			LuaInterface::SetTable(state, -3);
+			LuaInterface::SetTable(state, -3);
+			LuaInterface::SetTable(state, -3);
+
+			LuaInterface::PushNumber(state, 2);
+			LuaInterface::GetGlobal(state, "shared");
+			LuaInterface::SetTable(state, -3);
+
+			LuaInterface::SetGlobal(state, "root");
+
+			LuaInterface::PushNil(state);
+			LuaInterface::SetGlobal(state, "shared");
+		}
+
+		bool CountCoverageBytes(const uint8_t *pData, int32_t iSize, void *pUserData)
+		{
+			SCE_SLEDUNUSED(pData);
+			*static_cast<int32_t*>(pUserData) += iSize;
+			return true;
+		}
 	}
 
 	TEST_FIXTURE(Fixture, LuaPlugin_Create)
@@ -383,6 +447,123 @@ namespace sce { namespace Sled { namespace
 		CHECK_EQUAL(SCE_SLED_ERROR_OK, luaPluginResetMemoryTrace(host.m_plugin));
 	}
 
+	TEST_FIXTURE(Fixture, LuaPlugin_HeapCensusBasicChecks)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		HeapCensusSummary summary;
+		CHECK_EQUAL(SCE_SLED_ERROR_NULLPARAMETER, luaPluginHeapCensus(NULL, NULL, &summary));
+		CHECK_EQUAL(SCE_SLED_LUA_ERROR_NODEBUGGERINSTANCE, luaPluginHeapCensus(host.m_plugin, NULL, &summary));
+
+		SledDebugger *pDebugger = 0;
+		CHECK_EQUAL(0, host.CreateDebuggerAndAddPlugin(&pDebugger));
+
+		lua_State *state = LuaInterface::Open();
+		LuaHelpers::OpenLibs(state);
+
+		CHECK_EQUAL(SCE_SLED_LUA_ERROR_INVALIDLUASTATE, luaPluginHeapCensus(host.m_plugin, NULL, &summary));
+		CHECK_EQUAL(SCE_SLED_LUA_ERROR_HEAPCENSUSDISABLED, luaPluginHeapCensus(host.m_plugin, state, &summary));
+
+		LuaInterface::Close(state);
+	}
+
+	TEST_FIXTURE(Fixture, LuaPlugin_HeapCensus)
+	{
+		CHECK_EQUAL(0, host.Setup(config.DefaultWithHeapCensus()));
+
+		SledDebugger *pDebugger = 0;
+		CHECK_EQUAL(0, host.CreateDebuggerAndAddPlugin(&pDebugger));
+
+		lua_State *state = LuaInterface::Open();
+		LuaHelpers::OpenLibs(state);
+
+		// bigTable = { {}, {}, ... }
+		LuaInterface::NewTable(state);
+		for (int i = 1; i <= 100; i++)
+		{
+			LuaInterface::PushNumber(state, i);
+			LuaInterface::NewTable(state);
+			LuaInterface::SetTable(state, -3);
+		}
+		LuaInterface::SetGlobal(state, "bigTable");
+
+		HeapCensusSummary summary;
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, luaPluginHeapCensus(host.m_plugin, state, &summary));
+		CHECK_EQUAL(false, summary.truncated);
+		CHECK_EQUAL(true, summary.numObjects > 100);
+		CHECK_EQUAL(true, summary.totalBytes > 0);
+
+		LuaInterface::Close(state);
+	}
+
+	TEST_FIXTURE(Fixture, LuaPlugin_HeapCensusSharedAtTwoDepths)
+	{
+		LuaPluginConfig pluginConfig = config.DefaultWithHeapCensus();
+		pluginConfig.maxHeapCensusDepth = 4;
+		CHECK_EQUAL(0, host.Setup(pluginConfig));
+
+		SledDebugger *pDebugger = 0;
+		CHECK_EQUAL(0, host.CreateDebuggerAndAddPlugin(&pDebugger));
+
+		// The shared table is first reached at the depth limit and then
+		// from the root directly, so its contents must still be counted
+		lua_State *state = LuaInterface::Open();
+		LuaHelpers::OpenLibs(state);
+		LuaHelpers::SetHeapCensusSharedRoot(state, true);
+
+		HeapCensusSummary sharedSummary;
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, luaPluginHeapCensus(host.m_plugin, state, &sharedSummary));
+		LuaInterface::Close(state);
+
+		// Same layout with a separate empty table at the depth limit
+		state = LuaInterface::Open();
+		LuaHelpers::OpenLibs(state);
+		LuaHelpers::SetHeapCensusSharedRoot(state, false);
+
+		HeapCensusSummary separateSummary;
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, luaPluginHeapCensus(host.m_plugin, state, &separateSummary));
+		LuaInterface::Close(state);
+
+		CHECK_EQUAL(false, sharedSummary.truncated);
+		CHECK_EQUAL(false, separateSummary.truncated);
+		CHECK_EQUAL(separateSummary.numObjects - 1, sharedSummary.numObjects);
+	}
+
+	TEST_FIXTURE(Fixture, LuaPlugin_WriteCoverageDuringCollection)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		SledDebugger *pDebugger = 0;
+		CHECK_EQUAL(0, host.CreateDebuggerAndAddPlugin(&pDebugger));
+
+		lua_State *state = LuaInterface::Open();
+		LuaHelpers::OpenLibs(state);
+
+		// Chunks that are garbage straight away, each with its own source name
+		char szChunk[64];
+		char szName[32];
+		for (int i = 0; i < 200; i++)
+		{
+			std::sprintf(szChunk, "return function() return %d end", i);
+			std::sprintf(szName, "=chunk%d", i);
+			CHECK_EQUAL(0, LuaInterface::LoadBuffer(state, szChunk, std::strlen(szChunk), szName));
+			LuaInterface::Pop(state, 1);
+		}
+
+		// Write after every step of a collection, including while it is
+		// sweeping and prototypes can be dead but not freed yet
+		for (int i = 0; i < 400; i++)
+		{
+			LuaInterface::GcStep(state, 0);
+
+			int32_t iBytes = 0;
+			CHECK_EQUAL(SCE_SLED_ERROR_OK, luaPluginWriteCoverage(host.m_plugin, state, LuaHelpers::CountCoverageBytes, &iBytes));
+			CHECK_EQUAL(true, iBytes > 0);
+		}
+
+		LuaInterface::Close(state);
+	}
+
 	TEST_FIXTURE(Fixture, LuaPlugin_GetAndSetVarExcludeFlags)
 	{
 		CHECK_EQUAL(0, host.Setup(config.Default()));
@@ -431,6 +612,26 @@ namespace sce { namespace Sled { namespace
 		CHECK_EQUAL(VarExcludeFlags::kEnvironment, flags & VarExcludeFlags::kEnvironment);
 	}
 
+	TEST_FIXTURE(Fixture, LuaPlugin_GetAndSetVarTransferMode)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		VarTransferMode::Enum mode = VarTransferMode::kLazy;
+		CHECK_EQUAL(SCE_SLED_ERROR_NULLPARAMETER, luaPluginGetVarTransferMode(host.m_plugin, NULL));
+		CHECK_EQUAL(SCE_SLED_ERROR_NULLPARAMETER, luaPluginSetVarTransferMode(NULL, VarTransferMode::kLazy));
+
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, luaPluginGetVarTransferMode(host.m_plugin, &mode));
+		CHECK_EQUAL(VarTransferMode::kEager, mode);
+
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, luaPluginSetVarTransferMode(host.m_plugin, VarTransferMode::kLazy));
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, luaPluginGetVarTransferMode(host.m_plugin, &mode));
+		CHECK_EQUAL(VarTransferMode::kLazy, mode);
+
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, luaPluginSetVarTransferMode(host.m_plugin, VarTransferMode::kEager));
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, luaPluginGetVarTransferMode(host.m_plugin, &mode));
+		CHECK_EQUAL(VarTransferMode::kEager, mode);
+	}
+
 	TEST_FIXTURE(Fixture, LuaPlugin_Lua_CheckSledDebuggerPointerExists)
 	{
 		CHECK_EQUAL(0, host.Setup(config.Default()));
@@ -0,0 +1,146 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "../sledluaplugin/sledluaplugin.h"
+#include "../sleddebugger/utilities.h"
+#include "../sledluaplugin/numberformat.h"
+
+#include <unittest-cpp/UnitTest++/UnitTest++.h>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+namespace sce { namespace Sled { namespace
+{
+	TEST(NumberFormat_Integers)
+	{
+		char szBuffer[32];
+
+		CHECK_EQUAL((std::size_t)1, NumberFormat::formatInteger(szBuffer, sizeof(szBuffer), 0));
+		CHECK_EQUAL("0", szBuffer);
+
+		NumberFormat::formatInteger(szBuffer, sizeof(szBuffer), -42);
+		CHECK_EQUAL("-42", szBuffer);
+
+		NumberFormat::formatInteger(szBuffer, sizeof(szBuffer), 1234567890123LL);
+		CHECK_EQUAL("1234567890123", szBuffer);
+
+		NumberFormat::formatInteger(szBuffer, sizeof(szBuffer), (-9223372036854775807LL - 1));
+		CHECK_EQUAL("-9223372036854775808", szBuffer);
+
+		NumberFormat::formatUnsigned(szBuffer, sizeof(szBuffer), 18446744073709551615ULL);
+		CHECK_EQUAL("18446744073709551615", szBuffer);
+	}
+
+	TEST(NumberFormat_IntegralDoubles)
+	{
+		char szBuffer[NumberFormat::kMaxDoubleLen];
+
+		NumberFormat::formatDouble(szBuffer, sizeof(szBuffer), 100.0);
+		CHECK_EQUAL("100", szBuffer);
+
+		// Used to wrap around through unsigned long
+		NumberFormat::formatDouble(szBuffer, sizeof(szBuffer), -5.0);
+		CHECK_EQUAL("-5", szBuffer);
+
+		NumberFormat::formatDouble(szBuffer, sizeof(szBuffer), 9007199254740992.0);
+		CHECK_EQUAL("9007199254740992", szBuffer);
+
+		NumberFormat::formatDouble(szBuffer, sizeof(szBuffer), 1.0e300);
+		CHECK_EQUAL("1e+300", szBuffer);
+	}
+
+	TEST(NumberFormat_ShortestDoubles)
+	{
+		char szBuffer[NumberFormat::kMaxDoubleLen];
+
+		NumberFormat::formatDouble(szBuffer, sizeof(szBuffer), 0.1);
+		CHECK_EQUAL("0.1", szBuffer);
+
+		NumberFormat::formatDouble(szBuffer, sizeof(szBuffer), 0.1 + 0.2);
+		CHECK_EQUAL("0.30000000000000004", szBuffer);
+
+		NumberFormat::formatDouble(szBuffer, sizeof(szBuffer), 3.141592653589793);
+		CHECK_EQUAL("3.141592653589793", szBuffer);
+
+		NumberFormat::formatDouble(szBuffer, sizeof(szBuffer), -123.456);
+		CHECK_EQUAL("-123.456", szBuffer);
+
+		NumberFormat::formatDouble(szBuffer, sizeof(szBuffer), 0.0001);
+		CHECK_EQUAL("0.0001", szBuffer);
+
+		NumberFormat::formatDouble(szBuffer, sizeof(szBuffer), 0.00001);
+		CHECK_EQUAL("1e-05", szBuffer);
+
+		NumberFormat::formatDouble(szBuffer, sizeof(szBuffer), 5e-324);
+		CHECK_EQUAL("5e-324", szBuffer);
+
+		NumberFormat::formatDouble(szBuffer, sizeof(szBuffer), 1.7976931348623157e308);
+		CHECK_EQUAL("1.7976931348623157e+308", szBuffer);
+	}
+
+	TEST(NumberFormat_DoublesRoundTrip)
+	{
+		char szBuffer[NumberFormat::kMaxDoubleLen];
+
+		// Walk a spread of magnitudes and bit patterns
+		uint64_t bits = 0x3FF0000000000001ULL;
+		for (int i = 0; i < 10000; ++i)
+		{
+			bits = (bits * 6364136223846793005ULL) + 1442695040888963407ULL;
+
+			double value;
+			std::memcpy(&value, &bits, sizeof(value));
+			if ((value != value) || (value - value != 0.0))
+				continue;
+
+			NumberFormat::formatDouble(szBuffer, sizeof(szBuffer), value);
+			CHECK_EQUAL(value, std::strtod(szBuffer, NULL));
+		}
+	}
+
+	TEST(NumberFormat_NonFinite)
+	{
+		char szBuffer[NumberFormat::kMaxDoubleLen];
+
+		const double zero = 0.0;
+
+		NumberFormat::formatDouble(szBuffer, sizeof(szBuffer), 1.0 / zero);
+		CHECK_EQUAL("inf", szBuffer);
+
+		NumberFormat::formatDouble(szBuffer, sizeof(szBuffer), -1.0 / zero);
+		CHECK_EQUAL("-inf", szBuffer);
+
+		NumberFormat::formatDouble(szBuffer, sizeof(szBuffer), zero / zero);
+		CHECK_EQUAL("nan", szBuffer);
+	}
+
+	TEST(NumberFormat_Pointer)
+	{
+		char szBuffer[32];
+		const void *ptr = (const void*)(uintptr_t)0xABC123;
+
+		char szExpected[32];
+		std::sprintf(szExpected, "0x%0*lX", (int)(sizeof(void*) * 2), (unsigned long)0xABC123);
+
+		NumberFormat::formatPointer(szBuffer, sizeof(szBuffer), ptr);
+		CHECK_EQUAL(szExpected, szBuffer);
+
+		NumberFormat::formatPointer(szBuffer, sizeof(szBuffer), ptr, false);
+		CHECK_EQUAL(szExpected + 2, szBuffer);
+	}
+
+	TEST(NumberFormat_Truncates)
+	{
+		char szBuffer[4];
+
+		CHECK_EQUAL((std::size_t)3, NumberFormat::formatInteger(szBuffer, sizeof(szBuffer), 123456));
+		CHECK_EQUAL("123", szBuffer);
+
+		NumberFormat::formatDouble(szBuffer, sizeof(szBuffer), 0.125);
+		CHECK_EQUAL("0.1", szBuffer);
+	}
+}}}
@@ -0,0 +1,175 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "../sledluaplugin/sledluaplugin.h"
+#include "../sleddebugger/utilities.h"
+#include "../sleddebugger/errorcodes.h"
+#include "../sledluaplugin/opcodeprofile.h"
+
+#include <unittest-cpp/UnitTest++/UnitTest++.h>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+namespace sce { namespace Sled { namespace
+{
+	class HostedOpcodeProfileConfig
+	{
+	public:	
+		OpcodeProfileConfig Default()
+		{
+			OpcodeProfileConfig config;
+			Setup(config);
+			return config;
+		}
+	private:
+		static void Setup(OpcodeProfileConfig& config)
+		{
+			config.maxFunctions = 2;
+		}
+	};
+
+	class HostedOpcodeProfile
+	{
+	public:
+		HostedOpcodeProfile()
+		{
+			m_profile = 0;
+			m_profileMem = 0;
+		}
+
+		~HostedOpcodeProfile()
+		{
+			if (m_profile)
+			{
+				OpcodeProfile::shutdown(m_profile);
+				m_profile = 0;
+			}
+
+			if (m_profileMem)
+			{
+				delete [] m_profileMem;
+				m_profileMem = 0;
+			}
+		}
+
+		int32_t Setup(const OpcodeProfileConfig& config)
+		{
+			std::size_t iMemSize;
+
+			const int32_t iError = OpcodeProfile::requiredMemory(config, &iMemSize);
+			if (iError != 0)
+				return iError;
+
+			m_profileMem = new char[iMemSize];
+			std::memset(m_profileMem, 0xAB, iMemSize);
+			if (!m_profileMem)
+				return -1;
+
+			return OpcodeProfile::create(config, m_profileMem, &m_profile);
+		}
+
+		OpcodeProfile *m_profile;
+	private:
+		char *m_profileMem;
+	};
+
+	struct Fixture
+	{
+		Fixture()
+		{
+		}
+
+		HostedOpcodeProfile host;
+		HostedOpcodeProfileConfig config;
+	};
+
+	TEST_FIXTURE(Fixture, OpcodeProfile_Create)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+		CHECK_EQUAL(true, host.m_profile->isEnabled());
+		CHECK_EQUAL((uint16_t)0, host.m_profile->getNumOpcodes());
+		CHECK_EQUAL((uint16_t)0, host.m_profile->getNumFunctions());
+		CHECK_EQUAL((uint64_t)0, host.m_profile->getTotalInstructions());
+	}
+
+	TEST_FIXTURE(Fixture, OpcodeProfile_CreateDisabled)
+	{
+		OpcodeProfileConfig profileConfig;
+		CHECK_EQUAL(0, host.Setup(profileConfig));
+		CHECK_EQUAL(false, host.m_profile->isEnabled());
+
+		const std::size_t counts[2] = { 5, 5 };
+
+		host.m_profile->begin(2);
+		host.m_profile->addFunction("a.lua", 1, counts);
+		host.m_profile->end();
+
+		CHECK_EQUAL((uint16_t)0, host.m_profile->getNumFunctions());
+		CHECK_EQUAL((uint32_t)1, host.m_profile->getNumFunctionsSeen());
+	}
+
+	TEST_FIXTURE(Fixture, OpcodeProfile_Totals)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		host.m_profile->begin(3);
+		host.m_profile->setOpcode(0, "MOVE", 10);
+		host.m_profile->setOpcode(1, "LOADK", 20);
+		host.m_profile->setOpcode(2, "CALL", 30);
+		host.m_profile->setOpcode(3, "JMP", 1000);
+		host.m_profile->end();
+
+		CHECK_EQUAL((uint16_t)3, host.m_profile->getNumOpcodes());
+		CHECK_EQUAL((uint64_t)60, host.m_profile->getTotalInstructions());
+		CHECK_EQUAL("LOADK", host.m_profile->getOpcodeName(1));
+		CHECK(host.m_profile->getOpcodeName(3) == 0);
+		CHECK_EQUAL((uint64_t)0, host.m_profile->getOpcodeTotal(3));
+
+		OpcodeProfileSummary summary;
+		host.m_profile->getSummary(&summary);
+		CHECK_EQUAL((uint16_t)3, summary.numOpcodes);
+		CHECK_EQUAL((uint64_t)60, summary.totalInstructions);
+		CHECK_EQUAL((uint64_t)30, summary.opcodeCounts[2]);
+		CHECK_EQUAL("CALL", summary.opcodeNames[2]);
+		CHECK(summary.opcodeNames[3] == 0);
+	}
+
+	TEST_FIXTURE(Fixture, OpcodeProfile_TopFunctions)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		const std::size_t least[2] = { 1, 1 };
+		const std::size_t most[2] = { 50, 50 };
+		const std::size_t middle[2] = { 10, 0 };
+		const std::size_t none[2] = { 0, 0 };
+
+		host.m_profile->begin(2);
+		host.m_profile->addFunction("least.lua", 1, least);
+		host.m_profile->addFunction("middle.lua", 2, middle);
+		host.m_profile->addFunction("most.lua", 3, most);
+		host.m_profile->addFunction("none.lua", 4, none);
+		host.m_profile->end();
+
+		CHECK_EQUAL((uint32_t)4, host.m_profile->getNumFunctionsSeen());
+		CHECK_EQUAL((uint16_t)2, host.m_profile->getNumFunctions());
+
+		const OpcodeProfileFunction *pFirst = host.m_profile->getFunction(0);
+		const OpcodeProfileFunction *pSecond = host.m_profile->getFunction(1);
+		CHECK_EQUAL("most.lua", pFirst->source);
+		CHECK_EQUAL((uint64_t)100, pFirst->total);
+		CHECK_EQUAL("middle.lua", pSecond->source);
+		CHECK_EQUAL((int32_t)2, pSecond->lineDefined);
+		CHECK_EQUAL((uint64_t)10, pSecond->counts[0]);
+		CHECK_EQUAL((uint64_t)0, pSecond->counts[1]);
+		CHECK(host.m_profile->getFunction(2) == 0);
+
+		// Starting over forgets the functions kept
+		host.m_profile->begin(2);
+		host.m_profile->end();
+		CHECK_EQUAL((uint16_t)0, host.m_profile->getNumFunctions());
+	}
+}}}
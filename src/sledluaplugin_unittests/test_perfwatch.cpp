@@ -0,0 +1,254 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "../sledluaplugin/sledluaplugin.h"
+#include "../sledluaplugin/profilestack.h"
+#include "../sledluaplugin/perfwatch.h"
+#include "../sleddebugger/errorcodes.h"
+
+#include <unittest-cpp/UnitTest++/UnitTest++.h>
+
+#include <cstring>
+#include <ctime>
+
+namespace sce { namespace Sled { namespace
+{
+	class HostedPerfWatch
+	{
+	public:
+		HostedPerfWatch()
+			: m_watch(0)
+			, m_stack(0)
+			, m_watchMem(0)
+			, m_stackMem(0)
+		{
+		}
+
+		~HostedPerfWatch()
+		{
+			if (m_watch)
+				PerfWatch::shutdown(m_watch);
+
+			if (m_stack)
+				ProfileStack::shutdown(m_stack);
+
+			delete [] m_watchMem;
+			delete [] m_stackMem;
+		}
+
+		int32_t Setup(uint16_t iMaxWatches, uint16_t iMaxIncidents)
+		{
+			ProfileStackConfig stackConfig;
+			stackConfig.maxFunctions = 8;
+			stackConfig.maxCallStackDepth = 8;
+
+			std::size_t iMemSize;
+
+			int32_t iError = ProfileStack::requiredMemory(stackConfig, &iMemSize);
+			if (iError != 0)
+				return iError;
+
+			m_stackMem = new char[iMemSize];
+			iError = ProfileStack::create(stackConfig, m_stackMem, &m_stack);
+			if (iError != 0)
+				return iError;
+
+			PerfWatchConfig config;
+			config.maxWatches = iMaxWatches;
+			config.maxIncidents = iMaxIncidents;
+			config.maxFunctions = stackConfig.maxFunctions;
+
+			iError = PerfWatch::requiredMemory(config, &iMemSize);
+			if (iError != 0)
+				return iError;
+
+			m_watchMem = new char[iMemSize];
+			std::memset(m_watchMem, 0xAB, iMemSize);
+
+			return PerfWatch::create(config, m_watchMem, &m_watch);
+		}
+
+		// Returns from a function the way the plugin's hook does
+		const PerfWatchIncident *Leave(const char *pszFnName, int32_t iLine)
+		{
+			const ProfileEntry *pEntry = m_stack->leaveFn(pszFnName, "ai.lua", iLine);
+			return pEntry ? m_watch->check(m_stack, pEntry, 7) : 0;
+		}
+
+		PerfWatch *m_watch;
+		ProfileStack *m_stack;
+
+	private:
+		char *m_watchMem;
+		char *m_stackMem;
+	};
+
+	// Keeps a function busy for a couple of milliseconds
+	void Spin()
+	{
+		const std::clock_t end = std::clock() + (CLOCKS_PER_SEC / 500) + 1;
+		while (std::clock() < end) {}
+	}
+
+	TEST(PerfWatch_InvalidConfig)
+	{
+		PerfWatchConfig config;
+		config.maxWatches = 4;
+		config.maxIncidents = 4;
+
+		std::size_t iMemSize;
+		CHECK_EQUAL(SCE_SLED_ERROR_INVALIDCONFIGURATION, PerfWatch::requiredMemory(config, &iMemSize));
+
+		config.maxFunctions = 8;
+		config.maxIncidents = 0;
+		CHECK_EQUAL(SCE_SLED_ERROR_INVALIDCONFIGURATION, PerfWatch::requiredMemory(config, &iMemSize));
+
+		// Disabled needs neither
+		config.maxWatches = 0;
+		config.maxFunctions = 0;
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, PerfWatch::requiredMemory(config, &iMemSize));
+	}
+
+	TEST(PerfWatch_AddRemove)
+	{
+		HostedPerfWatch host;
+		CHECK_EQUAL(0, host.Setup(2, 4));
+		CHECK_EQUAL(true, host.m_watch->isEnabled());
+
+		uint16_t iFirst = 0;
+		uint16_t iSecond = 0;
+		uint16_t iThird = 0;
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, host.m_watch->add("think", NULL, 1000, PerfWatchFlags::kNone, &iFirst));
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, host.m_watch->add("move", "ai.lua", 1000, PerfWatchFlags::kNone, &iSecond));
+		CHECK(iFirst != iSecond);
+		CHECK_EQUAL(SCE_SLED_LUA_ERROR_PERFWATCHESFULL, host.m_watch->add("update", NULL, 1000, PerfWatchFlags::kNone, &iThird));
+		CHECK_EQUAL((uint16_t)2, host.m_watch->getNumWatches());
+
+		CHECK_EQUAL(true, host.m_watch->remove(iFirst));
+		CHECK_EQUAL(false, host.m_watch->remove(iFirst));
+		CHECK_EQUAL(false, host.m_watch->remove((uint16_t)PerfWatch::kNoWatch));
+
+		// The freed slot is reused
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, host.m_watch->add("update", NULL, 1000, PerfWatchFlags::kNone, &iThird));
+		CHECK_EQUAL(iFirst, iThird);
+	}
+
+	TEST(PerfWatch_Incident)
+	{
+		HostedPerfWatch host;
+		CHECK_EQUAL(0, host.Setup(2, 2));
+
+		uint16_t iSlow = 0;
+		uint16_t iRelaxed = 0;
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, host.m_watch->add("think", "ai.lua", 100, PerfWatchFlags::kTtyNotify, &iSlow));
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, host.m_watch->add("move", NULL, 1000000, PerfWatchFlags::kNone, &iRelaxed));
+
+		host.m_stack->enterFn("update", "ai.lua", 1);
+		host.m_stack->enterFn("think", "ai.lua", 10);
+		host.m_stack->enterFn("move", "ai.lua", 20);
+		CHECK(host.Leave("move", 20) == NULL);
+		Spin();
+
+		const PerfWatchIncident *pIncident = host.Leave("think", 10);
+		CHECK(pIncident != NULL);
+		CHECK(host.Leave("update", 1) == NULL);
+
+		if (!pIncident)
+			return;
+
+		CHECK_EQUAL(iSlow, pIncident->watch);
+		CHECK_EQUAL((uint32_t)PerfWatchFlags::kTtyNotify, pIncident->flags);
+		CHECK(pIncident->timeElapsed > 100);
+
+		CHECK_EQUAL((uint16_t)1, host.m_watch->getNumIncidents());
+
+		PerfIncident incident;
+		CHECK_EQUAL(true, host.m_watch->getIncident(host.m_stack, 0, &incident));
+		CHECK_EQUAL(false, host.m_watch->getIncident(host.m_stack, 1, &incident));
+		CHECK_EQUAL((uint64_t)7, incident.frame);
+		CHECK_EQUAL((uint32_t)100, incident.budget);
+		CHECK_EQUAL("ai.lua", incident.source);
+		CHECK_EQUAL(10, incident.line);
+		CHECK_EQUAL(false, incident.callPathTruncated);
+		CHECK_EQUAL((uint16_t)2, incident.callPathDepth);
+		CHECK_EQUAL("update", incident.callPath[0]);
+		CHECK_EQUAL("think", incident.callPath[1]);
+
+		// Only the most recent are kept
+		for (int i = 0; i < 3; i++)
+		{
+			host.m_stack->enterFn("think", "ai.lua", 10);
+			Spin();
+			CHECK(host.Leave("think", 10) != NULL);
+		}
+
+		CHECK_EQUAL((uint16_t)2, host.m_watch->getNumIncidents());
+		CHECK_EQUAL((uint64_t)4, host.m_watch->getNumIncidentsTotal());
+		CHECK_EQUAL(true, host.m_watch->getIncident(host.m_stack, 1, &incident));
+		CHECK_EQUAL((uint16_t)1, incident.callPathDepth);
+
+		// A watch in another script doesn't match
+		CHECK_EQUAL(true, host.m_watch->remove(iSlow));
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, host.m_watch->add("think", "player.lua", 100, PerfWatchFlags::kNone, &iSlow));
+		host.m_stack->enterFn("think", "ai.lua", 10);
+		Spin();
+		CHECK(host.Leave("think", 10) == NULL);
+	}
+
+	TEST(PerfWatch_InnerTime)
+	{
+		HostedPerfWatch host;
+		CHECK_EQUAL(0, host.Setup(1, 4));
+
+		uint16_t iId = 0;
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, host.m_watch->add("update", NULL, 1000, PerfWatchFlags::kInnerTime, &iId));
+
+		// The time is all in what update calls
+		host.m_stack->enterFn("update", "ai.lua", 1);
+		host.m_stack->enterFn("think", "ai.lua", 10);
+		Spin();
+		CHECK(host.Leave("think", 10) == NULL);
+		CHECK(host.Leave("update", 1) == NULL);
+
+		CHECK_EQUAL(true, host.m_watch->remove(iId));
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, host.m_watch->add("update", NULL, 1000, PerfWatchFlags::kNone, &iId));
+
+		host.m_stack->enterFn("update", "ai.lua", 1);
+		host.m_stack->enterFn("think", "ai.lua", 10);
+		Spin();
+		CHECK(host.Leave("think", 10) == NULL);
+		CHECK(host.Leave("update", 1) != NULL);
+	}
+
+	TEST(PerfWatch_Clear)
+	{
+		HostedPerfWatch host;
+		CHECK_EQUAL(0, host.Setup(1, 4));
+
+		uint16_t iId = 0;
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, host.m_watch->add("think", NULL, 100, PerfWatchFlags::kNone, &iId));
+
+		host.m_stack->enterFn("think", "ai.lua", 10);
+		Spin();
+		CHECK(host.Leave("think", 10) != NULL);
+
+		// The profile is reset as the plugin does; watches stay
+		host.m_stack->clear();
+		host.m_watch->clear();
+		CHECK_EQUAL((uint16_t)0, host.m_watch->getNumIncidents());
+		CHECK_EQUAL((uint64_t)0, host.m_watch->getNumIncidentsTotal());
+		CHECK_EQUAL((uint16_t)1, host.m_watch->getNumWatches());
+
+		// Functions get new indices after the reset
+		host.m_stack->enterFn("move", "ai.lua", 20);
+		Spin();
+		CHECK(host.Leave("move", 20) == NULL);
+
+		host.m_stack->enterFn("think", "ai.lua", 10);
+		Spin();
+		CHECK(host.Leave("think", 10) != NULL);
+		CHECK_EQUAL((uint16_t)1, host.m_watch->getNumIncidents());
+	}
+}}}
@@ -0,0 +1,265 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "../sledluaplugin/sledluaplugin.h"
+#include "../sledluaplugin/profilecapturewriter.h"
+#include "../sledluaplugin/profilestack.h"
+
+#include <unittest-cpp/UnitTest++/UnitTest++.h>
+
+#include <cstring>
+
+namespace sce { namespace Sled { namespace
+{
+	struct Output
+	{
+		Output() : size(0), numWrites(0), largestWrite(0), failAfter(-1) {}
+
+		uint8_t	data[8192];
+		int32_t	size;
+		int32_t	numWrites;
+		int32_t	largestWrite;
+		int32_t	failAfter;
+	};
+
+	bool WriteFunc(const uint8_t *pData, int32_t iSize, void *pUserData)
+	{
+		Output *pOut = static_cast<Output*>(pUserData);
+
+		if (pOut->numWrites == pOut->failAfter)
+			return false;
+
+		std::memcpy(pOut->data + pOut->size, pData, iSize);
+		pOut->size += iSize;
+		pOut->numWrites++;
+		if (iSize > pOut->largestWrite)
+			pOut->largestWrite = iSize;
+
+		return true;
+	}
+
+	struct Reader
+	{
+		Reader(const Output& out) : data(out.data), size(out.size), pos(0) {}
+
+		uint8_t byte() { return (pos < size) ? data[pos++] : 0xFF; }
+
+		uint64_t varint()
+		{
+			uint64_t iValue = 0;
+			for (int iShift = 0; pos < size; iShift += 7)
+			{
+				const uint8_t iByte = data[pos++];
+				iValue |= (uint64_t)(iByte & 0x7F) << iShift;
+				if ((iByte & 0x80) == 0)
+					break;
+			}
+			return iValue;
+		}
+
+		bool string(const char *pszExpected)
+		{
+			const std::size_t iLen = (std::size_t)varint();
+			const bool bSame = (iLen == std::strlen(pszExpected)) && (std::memcmp(data + pos, pszExpected, iLen) == 0);
+			pos += (int32_t)iLen;
+			return bSame;
+		}
+
+		const uint8_t	*data;
+		int32_t			size;
+		int32_t			pos;
+	};
+
+	ProfileCaptureFunction MakeFunction(const char *pszName, const char *pszFile, int32_t iLine)
+	{
+		ProfileCaptureFunction function;
+		std::memset(&function, 0, sizeof(function));
+		function.name = pszName;
+		function.file = pszFile;
+		function.line = iLine;
+		return function;
+	}
+
+	TEST(ProfileCaptureWriter_HeaderInfoAndEnd)
+	{
+		ProfileOverhead overhead;
+		overhead.calibrationCalls = 100;
+		overhead.selfTime = 250;
+		overhead.callTime = 400;
+
+		Output out;
+		ProfileCaptureWriter writer(WriteFunc, &out);
+		writer.begin();
+		writer.addInfo("r1234", 2000000, 120, overhead);
+		CHECK(writer.end());
+
+		CHECK_EQUAL(0, std::memcmp(out.data, "SLPC", 4));
+
+		Reader reader(out);
+		reader.pos = 4;
+		CHECK_EQUAL((int)ProfileCaptureWriter::kVersion, (int)reader.byte());
+		CHECK_EQUAL((int)ProfileCaptureWriter::kTagInfo, (int)reader.byte());
+		CHECK(reader.string("r1234"));
+		CHECK_EQUAL((uint64_t)SCE_LIBSLEDLUAPLUGIN_VER_MAJOR, reader.varint());
+		CHECK_EQUAL((uint64_t)SCE_LIBSLEDLUAPLUGIN_VER_MINOR, reader.varint());
+		CHECK_EQUAL((uint64_t)SCE_LIBSLEDLUAPLUGIN_VER_REVISION, reader.varint());
+		CHECK_EQUAL(2000000U, reader.varint());
+		CHECK_EQUAL(120U, reader.varint());
+		CHECK_EQUAL(100U, reader.varint());
+		CHECK_EQUAL(250U, reader.varint());
+		CHECK_EQUAL(400U, reader.varint());
+		CHECK_EQUAL((int)ProfileCaptureWriter::kTagEnd, (int)reader.byte());
+		CHECK_EQUAL(0U, reader.varint());
+		CHECK_EQUAL(out.size, reader.pos);
+		CHECK_EQUAL((uint64_t)out.size, writer.getNumBytes());
+	}
+
+	TEST(ProfileCaptureWriter_FunctionsEdgesAndPaths)
+	{
+		ProfileCaptureFunction update = MakeFunction("update", "game.lua", 10);
+		update.callCount = 3;
+		update.timeElapsed = 900;
+		update.timeInnerElapsed = 300;
+
+		Output out;
+		ProfileCaptureWriter writer(WriteFunc, &out);
+		writer.begin();
+		writer.addFunction(update);
+		writer.addFunction(MakeFunction("print", "[C]", -1));
+		writer.addEdge(0, 1);
+		writer.addCallPath(ProfileCallPath::kNone, 0, 3, 900);
+		writer.addCallPath(0, 1, 6, 600);
+		CHECK(writer.end());
+		CHECK_EQUAL(2U, writer.getNumFunctions());
+
+		Reader reader(out);
+		reader.pos = 5;
+		CHECK_EQUAL((int)ProfileCaptureWriter::kTagFunction, (int)reader.byte());
+		CHECK(reader.string("update"));
+		CHECK(reader.string("game.lua"));
+		CHECK_EQUAL(20U, reader.varint());
+		CHECK_EQUAL(3U, reader.varint());
+		CHECK_EQUAL(900U, reader.varint());
+		CHECK_EQUAL(0U, reader.varint());
+		CHECK_EQUAL(0U, reader.varint());
+		CHECK_EQUAL(300U, reader.varint());
+		for (int i = 0; i < 4; i++)
+			CHECK_EQUAL(0U, reader.varint());
+
+		CHECK_EQUAL((int)ProfileCaptureWriter::kTagFunction, (int)reader.byte());
+		CHECK(reader.string("print"));
+		CHECK(reader.string("[C]"));
+		// -1 zigzag encoded
+		CHECK_EQUAL(1U, reader.varint());
+		for (int i = 0; i < 9; i++)
+			CHECK_EQUAL(0U, reader.varint());
+
+		CHECK_EQUAL((int)ProfileCaptureWriter::kTagEdge, (int)reader.byte());
+		CHECK_EQUAL(0U, reader.varint());
+		CHECK_EQUAL(1U, reader.varint());
+
+		CHECK_EQUAL((int)ProfileCaptureWriter::kTagCallPath, (int)reader.byte());
+		CHECK_EQUAL(0U, reader.varint());
+		CHECK_EQUAL(0U, reader.varint());
+		CHECK_EQUAL(3U, reader.varint());
+		CHECK_EQUAL(900U, reader.varint());
+
+		CHECK_EQUAL((int)ProfileCaptureWriter::kTagCallPath, (int)reader.byte());
+		CHECK_EQUAL(1U, reader.varint());
+		CHECK_EQUAL(1U, reader.varint());
+		CHECK_EQUAL(6U, reader.varint());
+		CHECK_EQUAL(600U, reader.varint());
+
+		CHECK_EQUAL((int)ProfileCaptureWriter::kTagEnd, (int)reader.byte());
+		CHECK_EQUAL(2U, reader.varint());
+		CHECK_EQUAL(out.size, reader.pos);
+	}
+
+	TEST(ProfileCaptureWriter_HistogramKeepsUsedBuckets)
+	{
+		ProfileLatencyHistogram histogram;
+		histogram.clear();
+		histogram.add(3);
+		histogram.add(3);
+		histogram.add(5);
+		histogram.add(1000);
+
+		Output out;
+		ProfileCaptureWriter writer(WriteFunc, &out);
+		writer.begin();
+		writer.addFunction(MakeFunction("f", "=test", 1));
+		writer.addHistogram(0, ProfileCaptureWriter::kHistogramInner, histogram);
+		CHECK(writer.end());
+
+		Reader reader(out);
+		reader.pos = 5;
+		CHECK_EQUAL((int)ProfileCaptureWriter::kTagFunction, (int)reader.byte());
+		reader.pos += (int32_t)reader.varint();
+		reader.pos += (int32_t)reader.varint();
+		for (int i = 0; i < 10; i++)
+			reader.varint();
+
+		CHECK_EQUAL((int)ProfileCaptureWriter::kTagHistogram, (int)reader.byte());
+		CHECK_EQUAL(0U, reader.varint());
+		CHECK_EQUAL((int)ProfileCaptureWriter::kHistogramInner, (int)reader.byte());
+		CHECK_EQUAL(4U, reader.varint());
+		CHECK_EQUAL(1000U, reader.varint());
+		CHECK_EQUAL(3U, reader.varint());
+
+		const uint16_t iSlow = ProfileLatencyHistogram::getBucket(1000);
+		CHECK_EQUAL(3U, reader.varint());
+		CHECK_EQUAL(2U, reader.varint());
+		CHECK_EQUAL(1U, reader.varint());
+		CHECK_EQUAL(1U, reader.varint());
+		CHECK_EQUAL((uint64_t)(iSlow - 6), reader.varint());
+		CHECK_EQUAL(1U, reader.varint());
+		CHECK_EQUAL((int)ProfileCaptureWriter::kTagEnd, (int)reader.byte());
+	}
+
+	TEST(ProfileCaptureWriter_Memory)
+	{
+		Output out;
+		ProfileCaptureWriter writer(WriteFunc, &out);
+		writer.begin();
+		writer.addFunction(MakeFunction("f", "=test", 1));
+		writer.addMemory(0, 3, 4096, 200);
+		CHECK(writer.end());
+
+		Reader reader(out);
+		reader.pos = 5;
+		CHECK_EQUAL((int)ProfileCaptureWriter::kTagFunction, (int)reader.byte());
+		reader.pos += (int32_t)reader.varint();
+		reader.pos += (int32_t)reader.varint();
+		for (int i = 0; i < 10; i++)
+			reader.varint();
+
+		CHECK_EQUAL((int)ProfileCaptureWriter::kTagMemory, (int)reader.byte());
+		CHECK_EQUAL(0U, reader.varint());
+		CHECK_EQUAL(3U, reader.varint());
+		CHECK_EQUAL(4096U, reader.varint());
+		CHECK_EQUAL(200U, reader.varint());
+		CHECK_EQUAL((int)ProfileCaptureWriter::kTagEnd, (int)reader.byte());
+	}
+
+	TEST(ProfileCaptureWriter_CallbackFailureStops)
+	{
+		static char name[200];
+		std::memset(name, 'x', sizeof(name) - 1);
+		name[sizeof(name) - 1] = 0;
+
+		Output out;
+		out.failAfter = 1;
+
+		ProfileCaptureWriter writer(WriteFunc, &out);
+		writer.begin();
+		for (int i = 0; i < 10; i++)
+			writer.addFunction(MakeFunction(name, "=test", i));
+		CHECK(!writer.end());
+		CHECK(writer.hasFailed());
+		CHECK_EQUAL(1, out.numWrites);
+		CHECK_EQUAL((int32_t)ProfileCaptureWriter::kMaxWriteSize, out.largestWrite);
+		CHECK_EQUAL((uint64_t)ProfileCaptureWriter::kMaxWriteSize, writer.getNumBytes());
+	}
+}}}
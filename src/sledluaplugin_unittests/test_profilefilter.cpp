@@ -0,0 +1,137 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "../sledluaplugin/sledluaplugin.h"
+#include "../sledluaplugin/profilefilter.h"
+#include "../sleddebugger/errorcodes.h"
+
+#include <unittest-cpp/UnitTest++/UnitTest++.h>
+
+#include <cstring>
+
+namespace sce { namespace Sled { namespace
+{
+	class HostedProfileFilter
+	{
+	public:
+		HostedProfileFilter()
+			: m_filter(0)
+			, m_mem(0)
+		{
+		}
+
+		~HostedProfileFilter()
+		{
+			if (m_filter)
+				ProfileFilter::shutdown(m_filter);
+
+			delete [] m_mem;
+		}
+
+		int32_t Setup(uint16_t iMaxFilters, uint16_t iMaxPatternLen)
+		{
+			ProfileFilterConfig config;
+			config.maxFilters = iMaxFilters;
+			config.maxPatternLen = iMaxPatternLen;
+
+			std::size_t iMemSize;
+
+			const int32_t iError = ProfileFilter::requiredMemory(config, &iMemSize);
+			if (iError != 0)
+				return iError;
+
+			m_mem = new char[iMemSize];
+			std::memset(m_mem, 0xAB, iMemSize);
+
+			return ProfileFilter::create(config, m_mem, &m_filter);
+		}
+
+		ProfileFilter *m_filter;
+
+	private:
+		char *m_mem;
+	};
+
+	TEST(ProfileFilter_InvalidConfig)
+	{
+		ProfileFilterConfig config;
+		config.maxFilters = 4;
+
+		std::size_t iMemSize;
+		CHECK_EQUAL(SCE_SLED_ERROR_INVALIDCONFIGURATION, ProfileFilter::requiredMemory(config, &iMemSize));
+
+		config.maxFilters = 0;
+		config.maxPatternLen = 32;
+		CHECK_EQUAL(SCE_SLED_ERROR_INVALIDCONFIGURATION, ProfileFilter::requiredMemory(config, &iMemSize));
+
+		config.maxPatternLen = 0;
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, ProfileFilter::requiredMemory(config, &iMemSize));
+	}
+
+	TEST(ProfileFilter_GlobMatch)
+	{
+		CHECK_EQUAL(true, ProfileFilter::isGlobMatch("ai.lua", "ai.lua"));
+		CHECK_EQUAL(false, ProfileFilter::isGlobMatch("ai.lua", "ai.luac"));
+		CHECK_EQUAL(true, ProfileFilter::isGlobMatch("*", ""));
+		CHECK_EQUAL(true, ProfileFilter::isGlobMatch("scripts/*/ai.lua", "scripts/npc/boss/ai.lua"));
+		CHECK_EQUAL(false, ProfileFilter::isGlobMatch("scripts/*/ai.lua", "scripts/ai.lua"));
+		CHECK_EQUAL(true, ProfileFilter::isGlobMatch("ai?.lua", "ai2.lua"));
+		CHECK_EQUAL(false, ProfileFilter::isGlobMatch("ai?.lua", "ai.lua"));
+		CHECK_EQUAL(true, ProfileFilter::isGlobMatch("*a*b*c", "xaxbxbc"));
+		CHECK_EQUAL(false, ProfileFilter::isGlobMatch("*a*b*c", "xaxbxcb"));
+		CHECK_EQUAL(true, ProfileFilter::isGlobMatch("a**b", "ab"));
+	}
+
+	TEST(ProfileFilter_AddAndClear)
+	{
+		HostedProfileFilter host;
+		CHECK_EQUAL(0, host.Setup(2, 8));
+		CHECK_EQUAL(true, host.m_filter->isEnabled());
+		CHECK_EQUAL(false, host.m_filter->hasSourceFilters());
+
+		CHECK_EQUAL(SCE_SLED_ERROR_INVALIDPARAMETER, host.m_filter->add(ProfileFilterKind::kIncludeSource, ""));
+		CHECK_EQUAL(SCE_SLED_ERROR_INVALIDPARAMETER, host.m_filter->add(ProfileFilterKind::kIncludeSource, "scripts/*.lua"));
+		CHECK_EQUAL(SCE_SLED_ERROR_INVALIDPARAMETER, host.m_filter->add((ProfileFilterKind::Enum)4, "ai/*"));
+
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, host.m_filter->add(ProfileFilterKind::kIncludeSource, "ai/*"));
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, host.m_filter->add(ProfileFilterKind::kExcludeFunction, "debug*"));
+		CHECK_EQUAL(SCE_SLED_LUA_ERROR_PROFILEFILTERSFULL, host.m_filter->add(ProfileFilterKind::kExcludeSource, "*.luac"));
+		CHECK_EQUAL(true, host.m_filter->hasSourceFilters());
+		CHECK_EQUAL(true, host.m_filter->hasFunctionFilters());
+
+		host.m_filter->clear();
+		CHECK_EQUAL((uint16_t)0, host.m_filter->getNumFilters());
+		CHECK_EQUAL(false, host.m_filter->hasSourceFilters());
+		CHECK_EQUAL(false, host.m_filter->hasFunctionFilters());
+		CHECK_EQUAL(true, host.m_filter->isSourceProfiled("render/draw.lua"));
+	}
+
+	TEST(ProfileFilter_IncludeExclude)
+	{
+		HostedProfileFilter host;
+		CHECK_EQUAL(0, host.Setup(8, 32));
+
+		// Only AI scripts, less the generated ones
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, host.m_filter->add(ProfileFilterKind::kIncludeSource, "ai/*"));
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, host.m_filter->add(ProfileFilterKind::kIncludeSource, "*/behavior.lua"));
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, host.m_filter->add(ProfileFilterKind::kExcludeSource, "*_gen*"));
+
+		CHECK_EQUAL(true, host.m_filter->isSourceProfiled("ai/think.lua"));
+		CHECK_EQUAL(true, host.m_filter->isSourceProfiled("npc/behavior.lua"));
+		CHECK_EQUAL(false, host.m_filter->isSourceProfiled("ai/paths_gen.lua"));
+		CHECK_EQUAL(false, host.m_filter->isSourceProfiled("render/draw.lua"));
+		CHECK_EQUAL(false, host.m_filter->isSourceProfiled("=[C]"));
+
+		// Function names have their own lists
+		CHECK_EQUAL(true, host.m_filter->isFunctionProfiled("anything"));
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, host.m_filter->add(ProfileFilterKind::kExcludeFunction, "log?"));
+		CHECK_EQUAL(SCE_SLED_ERROR_OK, host.m_filter->add(ProfileFilterKind::kExcludeFunction, "trace"));
+		CHECK_EQUAL(false, host.m_filter->isFunctionProfiled("log2"));
+		CHECK_EQUAL(true, host.m_filter->isFunctionProfiled("log"));
+		CHECK_EQUAL(false, host.m_filter->isFunctionProfiled("trace"));
+		CHECK_EQUAL(true, host.m_filter->isFunctionProfiled("traceRay"));
+		CHECK_EQUAL(true, host.m_filter->isSourceProfiled("ai/think.lua"));
+	}
+}}}
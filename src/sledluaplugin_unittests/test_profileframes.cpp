@@ -0,0 +1,213 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "../sledluaplugin/sledluaplugin.h"
+#include "../sledluaplugin/profilestack.h"
+#include "../sledluaplugin/profileframes.h"
+#include "../sleddebugger/errorcodes.h"
+
+#include <unittest-cpp/UnitTest++/UnitTest++.h>
+
+#include <cstring>
+
+namespace sce { namespace Sled { namespace
+{
+	class HostedProfileFrames
+	{
+	public:
+		HostedProfileFrames()
+			: m_frames(0)
+			, m_stack(0)
+			, m_framesMem(0)
+			, m_stackMem(0)
+		{
+		}
+
+		~HostedProfileFrames()
+		{
+			if (m_frames)
+				ProfileFrames::shutdown(m_frames);
+
+			if (m_stack)
+				ProfileStack::shutdown(m_stack);
+
+			delete [] m_framesMem;
+			delete [] m_stackMem;
+		}
+
+		int32_t Setup(uint16_t iMaxFrames, uint16_t iMaxSlowFrames, uint32_t iFrameBudget)
+		{
+			ProfileStackConfig stackConfig;
+			stackConfig.maxFunctions = 8;
+			stackConfig.maxCallStackDepth = 8;
+
+			std::size_t iMemSize;
+
+			int32_t iError = ProfileStack::requiredMemory(stackConfig, &iMemSize);
+			if (iError != 0)
+				return iError;
+
+			m_stackMem = new char[iMemSize];
+			iError = ProfileStack::create(stackConfig, m_stackMem, &m_stack);
+			if (iError != 0)
+				return iError;
+
+			ProfileFramesConfig config;
+			config.maxFrames = iMaxFrames;
+			config.maxSlowFrames = iMaxSlowFrames;
+			config.maxFunctions = stackConfig.maxFunctions;
+			config.frameBudget = iFrameBudget;
+
+			iError = ProfileFrames::requiredMemory(config, &iMemSize);
+			if (iError != 0)
+				return iError;
+
+			m_framesMem = new char[iMemSize];
+			std::memset(m_framesMem, 0xAB, iMemSize);
+
+			return ProfileFrames::create(config, m_framesMem, &m_frames);
+		}
+
+		// One frame's Lua: update calls move iMoves times
+		void RunFrame(int iMoves)
+		{
+			m_stack->enterFn("update", "level1.lua", 10);
+			for (int i = 0; i < iMoves; i++)
+			{
+				m_stack->enterFn("move", "level1.lua", 20);
+				m_stack->leaveFn("move", "level1.lua", 20);
+			}
+			m_stack->leaveFn("update", "level1.lua", 10);
+		}
+
+		ProfileFrames *m_frames;
+		ProfileStack *m_stack;
+
+	private:
+		char *m_framesMem;
+		char *m_stackMem;
+	};
+
+	struct FunctionTotals
+	{
+		FunctionTotals() : numFunctions(0), updateCalls(0), moveCalls(0) {}
+
+		static void Add(const ProfileFrameFunction *pFunction, void *pUserData)
+		{
+			FunctionTotals *pTotals = static_cast<FunctionTotals*>(pUserData);
+			pTotals->numFunctions++;
+
+			if (std::strcmp(pFunction->name, "update") == 0)
+				pTotals->updateCalls += pFunction->callCount;
+			else if (std::strcmp(pFunction->name, "move") == 0)
+				pTotals->moveCalls += pFunction->callCount;
+
+			CHECK(pFunction->timeElapsed >= pFunction->timeInnerElapsed);
+		}
+
+		int numFunctions;
+		uint32_t updateCalls;
+		uint32_t moveCalls;
+	};
+
+	TEST(ProfileFrames_InvalidConfig)
+	{
+		ProfileFramesConfig config;
+		config.maxFrames = 4;
+
+		std::size_t iMemSize;
+		CHECK_EQUAL(SCE_SLED_ERROR_INVALIDCONFIGURATION, ProfileFrames::requiredMemory(config, &iMemSize));
+
+		config.maxFrames = 0;
+		config.maxFunctions = 8;
+		config.maxSlowFrames = 2;
+		CHECK_EQUAL(SCE_SLED_ERROR_INVALIDCONFIGURATION, ProfileFrames::requiredMemory(config, &iMemSize));
+
+		config.maxSlowFrames = 0;
+		CHECK_EQUAL(0, ProfileFrames::requiredMemory(config, &iMemSize));
+	}
+
+	TEST(ProfileFrames_Window)
+	{
+		HostedProfileFrames host;
+		CHECK_EQUAL(0, host.Setup(3, 0, 0));
+
+		// Calls before the first mark don't belong to any frame
+		host.RunFrame(5);
+		host.m_frames->mark(host.m_stack);
+
+		ProfileFrameStats stats;
+		host.m_frames->getStats(&stats);
+		CHECK_EQUAL((uint64_t)0, stats.numFrames);
+
+		// Five frames through a window of three: 2, 3 & 4 moves remain
+		for (int i = 0; i < 5; i++)
+		{
+			host.RunFrame(i);
+			host.m_frames->mark(host.m_stack);
+		}
+
+		host.m_frames->getStats(&stats);
+		CHECK_EQUAL((uint64_t)5, stats.numFrames);
+		CHECK_EQUAL((uint16_t)3, stats.windowFrames);
+		CHECK_EQUAL((uint16_t)0, stats.windowFramesOverBudget);
+		CHECK(stats.windowFrameTime >= stats.windowLongestFrameTime);
+		CHECK(stats.windowFrameTime >= stats.windowProfiledTime);
+
+		FunctionTotals totals;
+		host.m_frames->forEachFunction(host.m_stack, FunctionTotals::Add, &totals);
+		CHECK_EQUAL(2, totals.numFunctions);
+		CHECK_EQUAL((uint32_t)3, totals.updateCalls);
+		CHECK_EQUAL((uint32_t)9, totals.moveCalls);
+
+		// The whole profile is untouched
+		CHECK_EQUAL((uint32_t)15, host.m_stack->findFn("move", "level1.lua", 20)->getFnCallCount());
+
+		host.m_frames->clear();
+		host.m_frames->getStats(&stats);
+		CHECK_EQUAL((uint64_t)0, stats.numFrames);
+		CHECK_EQUAL((uint16_t)0, stats.windowFrames);
+	}
+
+	TEST(ProfileFrames_SlowFrames)
+	{
+		HostedProfileFrames host;
+
+		// Any frame doing work is over a microsecond
+		CHECK_EQUAL(0, host.Setup(4, 2, 1));
+		host.m_frames->mark(host.m_stack);
+
+		for (int i = 1; i <= 3; i++)
+		{
+			host.RunFrame(i * 1000);
+			host.m_frames->mark(host.m_stack);
+		}
+
+		ProfileFrameStats stats;
+		host.m_frames->getStats(&stats);
+		CHECK_EQUAL((uint64_t)3, stats.numFramesOverBudget);
+		CHECK_EQUAL((uint16_t)3, stats.windowFramesOverBudget);
+		CHECK_EQUAL((uint16_t)2, stats.numSlowFrames);
+
+		// Only the last two are kept, most recent first
+		ProfileSlowFrame frame;
+		FunctionTotals totals;
+		CHECK_EQUAL(true, host.m_frames->getSlowFrame(host.m_stack, 0, &frame, FunctionTotals::Add, &totals));
+		CHECK_EQUAL((uint64_t)3, frame.frame);
+		CHECK_EQUAL((uint16_t)2, frame.numFunctions);
+		CHECK_EQUAL((uint32_t)1, totals.updateCalls);
+		CHECK_EQUAL((uint32_t)3000, totals.moveCalls);
+
+		CHECK_EQUAL(true, host.m_frames->getSlowFrame(host.m_stack, 1, &frame, 0, 0));
+		CHECK_EQUAL((uint64_t)2, frame.frame);
+		CHECK_EQUAL(false, host.m_frames->getSlowFrame(host.m_stack, 2, &frame, 0, 0));
+
+		// A skipped frame isn't counted
+		host.m_frames->skip();
+		host.m_frames->mark(host.m_stack);
+		host.m_frames->getStats(&stats);
+		CHECK_EQUAL((uint64_t)3, stats.numFrames);
+	}
+}}}
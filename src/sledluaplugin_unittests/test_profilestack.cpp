@@ -6,12 +6,15 @@
 #include "../sledluaplugin/sledluaplugin.h"
 #include "../sleddebugger/utilities.h"
 #include "../sledluaplugin/profilestack.h"
+#include "../sledluaplugin/foldedstackwriter.h"
+#include "../sleddebugger/errorcodes.h"
 
 #include <unittest-cpp/UnitTest++/UnitTest++.h>
 
 #include <cstdlib>
 #include <cstdio>
 #include <cstring>
+#include <ctime>
 
 #include <wws_lua/extras/Lua.Utilities/LuaInterface.h>
 
@@ -206,4 +209,381 @@ namespace sce { namespace Sled { namespace
 		host.m_stack->clear();
 		CHECK_EQUAL((uint32_t)0, host.m_stack->getNumFunctions());
 	}
+
+	struct FoldedText
+	{
+		FoldedText() : len(0), calls(0) { text[0] = '\0'; }
+
+		static bool Write(const char *pszText, int32_t iLen, void *pUserData)
+		{
+			FoldedText *pFolded = static_cast<FoldedText*>(pUserData);
+			std::memcpy(pFolded->text + pFolded->len, pszText, iLen);
+			pFolded->len += iLen;
+			pFolded->text[pFolded->len] = '\0';
+			pFolded->calls++;
+			return true;
+		}
+
+		char text[2048];
+		int32_t len;
+		int32_t calls;
+	};
+
+	TEST_FIXTURE(Fixture, ProfileStack_CallPathsInvalidConfig)
+	{
+		ProfileStackConfig stackConfig;
+		stackConfig.maxCallPaths = 16;
+
+		std::size_t iMemSize;
+		CHECK_EQUAL(SCE_SLED_ERROR_INVALIDCONFIGURATION, ProfileStack::requiredMemory(stackConfig, &iMemSize));
+	}
+
+	TEST_FIXTURE(Fixture, ProfileStack_CallPaths)
+	{
+		ProfileStackConfig stackConfig = config.Default();
+		stackConfig.maxCallPaths = 3;
+		CHECK_EQUAL(0, host.Setup(stackConfig));
+
+		const char *pszFile = "level1.lua";
+
+		// main -> update -> draw twice, then main -> draw
+		host.m_stack->enterFn("main", pszFile, 1);
+		for (int i = 0; i < 2; i++)
+		{
+			host.m_stack->enterFn("update", pszFile, 10);
+			host.m_stack->enterFn("draw", pszFile, 20);
+			host.m_stack->leaveFn("draw", pszFile, 20);
+			host.m_stack->leaveFn("update", pszFile, 10);
+		}
+		host.m_stack->enterFn("draw", pszFile, 20);
+		host.m_stack->leaveFn("draw", pszFile, 20);
+		host.m_stack->leaveFn("main", pszFile, 1);
+
+		// main;draw didn't fit
+		CHECK_EQUAL((uint32_t)3, host.m_stack->getNumCallPaths());
+		CHECK_EQUAL((uint32_t)1, host.m_stack->getNumCallPathsDropped());
+
+		const ProfileCallPath *pMain = host.m_stack->getCallPath(0);
+		const ProfileCallPath *pDraw = host.m_stack->getCallPath(2);
+		CHECK_EQUAL("main", pMain->entry->getFnName());
+		CHECK_EQUAL((uint32_t)ProfileCallPath::kNone, pMain->parent);
+		CHECK_EQUAL((uint32_t)1, pMain->callCount);
+		CHECK_EQUAL("draw", pDraw->entry->getFnName());
+		CHECK_EQUAL((uint32_t)1, pDraw->parent);
+		CHECK_EQUAL((uint32_t)2, pDraw->callCount);
+		CHECK(pMain->timeInclusive >= host.m_stack->getCallPath(1)->timeInclusive);
+
+		FoldedText folded;
+		FoldedStackWriter writer(FoldedText::Write, &folded);
+		host.m_stack->writeFolded(&writer, ProfileFoldedWeight::kCallCount);
+		CHECK_EQUAL(true, writer.end());
+		CHECK_EQUAL((uint32_t)3, writer.getNumLines());
+		CHECK_EQUAL(
+			"main (level1.lua:1) 1\n"
+			"main (level1.lua:1);update (level1.lua:10) 2\n"
+			"main (level1.lua:1);update (level1.lua:10);draw (level1.lua:20) 2\n",
+			folded.text);
+
+		host.m_stack->clear();
+		CHECK_EQUAL((uint32_t)0, host.m_stack->getNumCallPaths());
+		CHECK_EQUAL((uint32_t)0, host.m_stack->getNumCallPathsDropped());
+	}
+
+	TEST(ProfileLatencyHistogram_Buckets)
+	{
+		// Exact below the sub buckets, then eight buckets per power of two
+		CHECK_EQUAL((uint16_t)0, ProfileLatencyHistogram::getBucket(0));
+		CHECK_EQUAL((uint16_t)15, ProfileLatencyHistogram::getBucket(15));
+		CHECK_EQUAL((uint16_t)16, ProfileLatencyHistogram::getBucket(16));
+		CHECK_EQUAL((uint16_t)16, ProfileLatencyHistogram::getBucket(17));
+		CHECK_EQUAL((uint16_t)23, ProfileLatencyHistogram::getBucket(31));
+		CHECK_EQUAL((uint16_t)24, ProfileLatencyHistogram::getBucket(32));
+		CHECK_EQUAL((uint16_t)(ProfileLatencyHistogram::kNumBuckets - 1), ProfileLatencyHistogram::getBucket(0xFFFFFFFF));
+		CHECK_EQUAL((uint16_t)(ProfileLatencyHistogram::kNumBuckets - 1), ProfileLatencyHistogram::getBucket((uint64_t)1 << 40));
+
+		CHECK_EQUAL((uint64_t)15, ProfileLatencyHistogram::getBucketUpperBound(15));
+		CHECK_EQUAL((uint64_t)17, ProfileLatencyHistogram::getBucketUpperBound(16));
+		CHECK_EQUAL((uint64_t)35, ProfileLatencyHistogram::getBucketUpperBound(24));
+		CHECK_EQUAL((uint64_t)0xFFFFFFFF, ProfileLatencyHistogram::getBucketUpperBound(ProfileLatencyHistogram::kNumBuckets - 1));
+
+		// Every time lands in a bucket whose upper bound covers it
+		for (uint64_t iTime = 1; iTime < 100000; iTime = (iTime * 3) / 2 + 1)
+		{
+			const uint16_t iBucket = ProfileLatencyHistogram::getBucket(iTime);
+			CHECK(ProfileLatencyHistogram::getBucketUpperBound(iBucket) >= iTime);
+			CHECK((iBucket == 0) || (ProfileLatencyHistogram::getBucketUpperBound(iBucket - 1) < iTime));
+		}
+	}
+
+	TEST(ProfileLatencyHistogram_Percentiles)
+	{
+		ProfileLatencyHistogram histogram;
+		histogram.clear();
+		CHECK_EQUAL((uint64_t)0, histogram.getValueAtPercentile(50.0));
+
+		// 990 fast calls, 9 slow ones & one very slow one
+		for (int i = 0; i < 990; i++)
+			histogram.add(10);
+		for (int i = 0; i < 9; i++)
+			histogram.add(1000);
+		histogram.add(50000);
+
+		CHECK_EQUAL((uint32_t)1000, histogram.count);
+		CHECK_EQUAL((uint64_t)50000, histogram.longest);
+		CHECK_EQUAL((uint64_t)10, histogram.getValueAtPercentile(50.0));
+		CHECK_EQUAL((uint64_t)10, histogram.getValueAtPercentile(99.0));
+		CHECK(histogram.getValueAtPercentile(99.9) >= 1000);
+		CHECK(histogram.getValueAtPercentile(99.9) <= 1000 + (1000 / 8));
+		CHECK_EQUAL((uint64_t)50000, histogram.getValueAtPercentile(100.0));
+	}
+
+	TEST_FIXTURE(Fixture, ProfileStack_LatencyHistograms)
+	{
+		ProfileStackConfig stackConfig = config.Default();
+		stackConfig.maxHistograms = (uint16_t)(stackConfig.maxFunctions + 1);
+
+		std::size_t iMemSize;
+		CHECK_EQUAL(SCE_SLED_ERROR_INVALIDCONFIGURATION, ProfileStack::requiredMemory(stackConfig, &iMemSize));
+
+		stackConfig.maxHistograms = 1;
+		CHECK_EQUAL(0, host.Setup(stackConfig));
+
+		const char *pszFile = "level1.lua";
+
+		for (int i = 0; i < 3; i++)
+		{
+			host.m_stack->enterFn("main", pszFile, 1);
+			host.m_stack->enterFn("update", pszFile, 10);
+			host.m_stack->leaveFn("update", pszFile, 10);
+			host.m_stack->leaveFn("main", pszFile, 1);
+		}
+
+		// Only the first function seen gets histograms
+		const ProfileEntry *pMain = host.m_stack->findFn("main", pszFile, 1);
+		const ProfileEntry *pUpdate = host.m_stack->findFn("update", pszFile, 10);
+		CHECK(pMain->getFnLatency() != NULL);
+		CHECK(pMain->getFnInnerLatency() != NULL);
+		CHECK(pUpdate->getFnLatency() == NULL);
+		CHECK(pUpdate->getFnInnerLatency() == NULL);
+
+		CHECK_EQUAL((uint32_t)3, pMain->getFnLatency()->count);
+		CHECK_EQUAL((uint32_t)3, pMain->getFnInnerLatency()->count);
+		CHECK(pMain->getFnLatency()->longest >= pMain->getFnInnerLatency()->longest);
+
+		// Histograms start over with the entries
+		host.m_stack->clear();
+		host.m_stack->enterFn("update", pszFile, 10);
+		host.m_stack->leaveFn("update", pszFile, 10);
+
+		pUpdate = host.m_stack->findFn("update", pszFile, 10);
+		CHECK(pUpdate->getFnLatency() != NULL);
+		CHECK_EQUAL((uint32_t)1, pUpdate->getFnLatency()->count);
+	}
+
+	TEST_FIXTURE(Fixture, ProfileStack_Calibrate)
+	{
+		ProfileStackConfig stackConfig = config.Default();
+		stackConfig.calibrationCalls = 200;
+		stackConfig.maxFunctions = 1;
+
+		std::size_t iMemSize;
+		CHECK_EQUAL(SCE_SLED_ERROR_INVALIDCONFIGURATION, ProfileStack::requiredMemory(stackConfig, &iMemSize));
+
+		stackConfig.maxFunctions = 100;
+		CHECK_EQUAL(0, host.Setup(stackConfig));
+
+		host.m_stack->calibrate();
+		CHECK_EQUAL(true, host.m_stack->isEmpty());
+		CHECK(host.m_stack->getSelfOverhead() > 0.0f);
+		CHECK(host.m_stack->getCallOverhead() >= host.m_stack->getSelfOverhead());
+
+		// Calls don't finish in less than nothing
+		host.m_stack->enterFn("update", "level1.lua", 10);
+		host.m_stack->leaveFn("update", "level1.lua", 10);
+
+		const ProfileEntry *pUpdate = host.m_stack->findFn("update", "level1.lua", 10);
+		CHECK(pUpdate->getFnTimeElapsedCorrected() >= 0.0f);
+		CHECK(pUpdate->getFnTimeElapsedCorrected() <= pUpdate->getFnTimeElapsed());
+	}
+
+	TEST_FIXTURE(Fixture, ProfileStack_OverheadCorrection)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		// Not calibrating leaves nothing to take off
+		host.m_stack->calibrate();
+		CHECK_EQUAL(0.0f, host.m_stack->getCallOverhead());
+
+		const char *pszFile = "level1.lua";
+
+		host.m_stack->enterFn("main", pszFile, 1);
+		host.m_stack->enterFn("update", pszFile, 10);
+		host.m_stack->leaveFn("update", pszFile, 10);
+		host.m_stack->leaveFn("main", pszFile, 1);
+
+		const ProfileEntry *pMain = host.m_stack->findFn("main", pszFile, 1);
+		CHECK_EQUAL(pMain->getFnTimeElapsed(), pMain->getFnTimeElapsedCorrected());
+		CHECK_EQUAL(pMain->getFnTimeInnerElapsed(), pMain->getFnTimeInnerElapsedCorrected());
+
+		// Each call made under main adds its overhead to main's time
+		const float flCallOverhead = 0.0001f;
+		host.m_stack->clear();
+		host.m_stack->setOverhead(0.0f, flCallOverhead);
+
+		host.m_stack->enterFn("main", pszFile, 1);
+		for (int i = 0; i < 3; i++)
+		{
+			host.m_stack->enterFn("update", pszFile, 10);
+			host.m_stack->leaveFn("update", pszFile, 10);
+		}
+
+		const std::clock_t end = std::clock() + (CLOCKS_PER_SEC / 500) + 1;
+		while (std::clock() < end) {}
+		host.m_stack->leaveFn("main", pszFile, 1);
+
+		pMain = host.m_stack->findFn("main", pszFile, 1);
+		const ProfileEntry *pUpdate = host.m_stack->findFn("update", pszFile, 10);
+		CHECK_CLOSE(pMain->getFnTimeElapsed() - (3.0f * flCallOverhead), pMain->getFnTimeElapsedCorrected(), 0.000001f);
+		CHECK_CLOSE(pMain->getFnTimeInnerElapsed() - (3.0f * flCallOverhead), pMain->getFnTimeInnerElapsedCorrected(), 0.000001f);
+		CHECK_EQUAL(pUpdate->getFnTimeElapsed(), pUpdate->getFnTimeElapsedCorrected());
+
+		// More overhead than time adds nothing
+		const float flCorrected = pUpdate->getFnTimeElapsedCorrected();
+		host.m_stack->setOverhead(1.0f, 1.0f);
+		host.m_stack->enterFn("update", pszFile, 10);
+		host.m_stack->leaveFn("update", pszFile, 10);
+		CHECK_EQUAL(flCorrected, pUpdate->getFnTimeElapsedCorrected());
+		CHECK(pUpdate->getFnTimeElapsed() > flCorrected);
+	}
+
+	TEST_FIXTURE(Fixture, ProfileStack_Zones)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		static ProfileZoneSite raycast = { "Physics::raycast", "physics.cpp", 42, 0, 0, 0 };
+
+		// A zone under the C function Lua called, called twice
+		for (int i = 0; i < 2; i++)
+		{
+			host.m_stack->enterFn("update", "level1.lua", 10);
+			host.m_stack->enterFn("raycast", "=[C]", -1);
+			CHECK(host.m_stack->enterZone(&raycast) != NULL);
+			CHECK(raycast.owner == host.m_stack);
+			CHECK(host.m_stack->leaveZone(&raycast) != NULL);
+			host.m_stack->leaveFn("raycast", "=[C]", -1);
+			host.m_stack->leaveFn("update", "level1.lua", 10);
+		}
+
+		const ProfileEntry *pZone = host.m_stack->findFn("Physics::raycast", "physics.cpp", 42);
+		CHECK(pZone != NULL);
+		CHECK_EQUAL((uint32_t)2, pZone->getFnCallCount());
+		CHECK_EQUAL(host.m_stack->getFnIndex(pZone), (uint32_t)raycast.index);
+
+		const ProfileEntry *pBinding = host.m_stack->findFn("raycast", "=[C]", -1);
+		ProfileEntry::ConstIterator iter(pBinding);
+		CHECK(iter());
+		CHECK(iter.get() == pZone);
+
+		// After a clear the site looks its entry up again
+		host.m_stack->clear();
+		host.m_stack->enterFn("draw", "level1.lua", 20);
+		CHECK(host.m_stack->enterZone(&raycast) != NULL);
+		CHECK(host.m_stack->leaveZone(&raycast) != NULL);
+		host.m_stack->leaveFn("draw", "level1.lua", 20);
+
+		pZone = host.m_stack->findFn("Physics::raycast", "physics.cpp", 42);
+		CHECK_EQUAL((uint32_t)1, pZone->getFnCallCount());
+		CHECK_EQUAL((uint16_t)1, raycast.index);
+
+		// Leaving a zone of an empty profile does nothing
+		host.m_stack->clear();
+		CHECK(host.m_stack->leaveZone(&raycast) == NULL);
+	}
+
+	TEST_FIXTURE(Fixture, ProfileStack_ChargeMemory)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		// Nothing running to charge
+		host.m_stack->chargeMemory(64, 0);
+
+		host.m_stack->enterFn("update", "level1.lua", 10);
+		host.m_stack->chargeMemory(32, 0);
+		host.m_stack->enterFn("spawn", "level1.lua", 30);
+		host.m_stack->chargeMemory(100, 0);
+		host.m_stack->chargeMemory(28, 0);
+		host.m_stack->chargeMemory(0, 500);
+		host.m_stack->leaveFn("spawn", "level1.lua", 30);
+		host.m_stack->chargeMemory(0, 16);
+		host.m_stack->leaveFn("update", "level1.lua", 10);
+
+		const ProfileEntry *pUpdate = host.m_stack->findFn("update", "level1.lua", 10);
+		CHECK_EQUAL((uint32_t)1, pUpdate->getFnAllocCount());
+		CHECK_EQUAL((uint64_t)32, pUpdate->getFnAllocBytes());
+		CHECK_EQUAL((uint64_t)16, pUpdate->getFnFreeBytes());
+
+		const ProfileEntry *pSpawn = host.m_stack->findFn("spawn", "level1.lua", 30);
+		CHECK_EQUAL((uint32_t)2, pSpawn->getFnAllocCount());
+		CHECK_EQUAL((uint64_t)128, pSpawn->getFnAllocBytes());
+		CHECK_EQUAL((uint64_t)500, pSpawn->getFnFreeBytes());
+
+		// Charges go with the profile
+		host.m_stack->clear();
+		host.m_stack->enterFn("update", "level1.lua", 10);
+		host.m_stack->leaveFn("update", "level1.lua", 10);
+		CHECK_EQUAL((uint32_t)0, host.m_stack->findFn("update", "level1.lua", 10)->getFnAllocCount());
+	}
+
+	TEST_FIXTURE(Fixture, ProfileStack_LeaveTop)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		// Nothing to leave
+		CHECK_EQUAL(true, host.m_stack->leaveTop() == NULL);
+
+		ProfileEntry *pUpdate = host.m_stack->enterFn("update", "level1.lua", 10);
+		ProfileEntry *pSpawn = host.m_stack->enterFn("spawn", "level1.lua", 30);
+		CHECK_EQUAL((uint16_t)2, host.m_stack->getCallStackDepth());
+
+		// A frame reused by a tail call returns under another name; leaving
+		// the top still pops the function that was entered
+		CHECK_EQUAL(true, host.m_stack->leaveTop() == pSpawn);
+		CHECK_EQUAL((uint16_t)1, host.m_stack->getCallStackDepth());
+		CHECK_EQUAL(true, host.m_stack->leaveTop() == pUpdate);
+		CHECK_EQUAL((uint16_t)0, host.m_stack->getCallStackDepth());
+
+		CHECK_EQUAL(true, host.m_stack->leaveTop() == NULL);
+	}
+
+	TEST(FoldedStackWriter_Names)
+	{
+		FoldedText folded;
+		FoldedStackWriter writer(FoldedText::Write, &folded);
+
+		// Tagged functions are written as anonymous by the profile stack;
+		// the writer only keeps separators out of names
+		writer.addFrame("a;b", "dir\nfile.lua", 3);
+		writer.endLine(7);
+		writer.endLine(8);
+		CHECK_EQUAL(true, writer.end());
+
+		CHECK_EQUAL("a_b (dir_file.lua:3) 7\n", folded.text);
+		CHECK_EQUAL((uint32_t)1, writer.getNumLines());
+	}
+
+	TEST(FoldedStackWriter_Chunks)
+	{
+		FoldedText folded;
+		FoldedStackWriter writer(FoldedText::Write, &folded);
+
+		for (int i = 0; i < 40; i++)
+		{
+			writer.addFrame("function", "file.lua", i);
+			writer.endLine(1);
+		}
+
+		CHECK_EQUAL(true, writer.end());
+		CHECK_EQUAL((uint64_t)folded.len, writer.getNumBytes());
+		CHECK(folded.calls > 1);
+	}
 }}}
@@ -0,0 +1,252 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "../sledluaplugin/sledluaplugin.h"
+#include "../sledluaplugin/sendpipeline.h"
+
+#include <unittest-cpp/UnitTest++/UnitTest++.h>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+namespace sce { namespace Sled { namespace
+{
+	class HostedSendPipelineConfig
+	{
+	public:	
+		SendPipelineConfig Default()
+		{
+			SendPipelineConfig config;
+			Setup(config);
+			return config;
+		}
+	private:
+		static void Setup(SendPipelineConfig& config)
+		{
+			// Small so messages wrap around the arena
+			config.arenaSize = 64;
+		}
+	};
+
+	class HostedSendPipeline
+	{
+	public:
+		HostedSendPipeline()
+		{
+			m_pipeline = 0;
+			m_pipelineMem = 0;
+		}
+
+		~HostedSendPipeline()
+		{
+			if (m_pipeline)
+			{
+				SendPipeline::shutdown(m_pipeline);
+				m_pipeline = 0;
+			}
+
+			if (m_pipelineMem)
+			{
+				delete [] m_pipelineMem;
+				m_pipelineMem = 0;
+			}
+		}
+
+		int32_t Setup(const SendPipelineConfig& config)
+		{
+			std::size_t iMemSize;
+
+			const int32_t iError = SendPipeline::requiredMemory(config, &iMemSize);
+			if (iError != 0)
+				return iError;
+
+			m_pipelineMem = new char[iMemSize];
+			std::memset(m_pipelineMem, 0xAB, iMemSize);
+			if (!m_pipelineMem)
+				return -1;
+
+			return SendPipeline::create(config, m_pipelineMem, &m_pipeline);
+		}
+
+		SendPipeline *m_pipeline;
+
+	private:
+		char *m_pipelineMem;
+	};
+
+	// Stands in for the socket; only ever touched by the worker thread until end()
+	struct Receiver
+	{
+		static const int32_t kCapacity = 16 * 1024;
+
+		Receiver() : size(0), maxPerSend(0), fail(false) {}
+
+		static int32_t Send(void *pUserData, const uint8_t *pData, int32_t iSize)
+		{
+			Receiver *pReceiver = static_cast<Receiver*>(pUserData);
+			if (pReceiver->fail)
+				return -1;
+
+			if ((pReceiver->maxPerSend != 0) && (iSize > pReceiver->maxPerSend))
+				iSize = pReceiver->maxPerSend;
+
+			if ((pReceiver->size + iSize) > kCapacity)
+				return -1;
+
+			std::memcpy(pReceiver->data + pReceiver->size, pData, iSize);
+			pReceiver->size += iSize;
+			return iSize;
+		}
+
+		uint8_t		data[kCapacity];
+		int32_t		size;
+		int32_t		maxPerSend;
+		bool		fail;
+	};
+
+	// Messages of varying length with a running byte pattern
+	int32_t EnqueueMessages(SendPipeline *pPipeline, int iCount)
+	{
+		uint8_t message[40];
+		uint8_t value = 0;
+		int32_t iTotal = 0;
+
+		for (int i = 0; i < iCount; i++)
+		{
+			const int32_t iLen = 1 + (i % (int)sizeof(message));
+			for (int32_t j = 0; j < iLen; j++)
+				message[j] = value++;
+
+			pPipeline->enqueue(message, iLen);
+			iTotal += iLen;
+		}
+
+		return iTotal;
+	}
+
+	bool CheckPattern(const Receiver& receiver)
+	{
+		for (int32_t i = 0; i < receiver.size; i++)
+		{
+			if (receiver.data[i] != (uint8_t)i)
+				return false;
+		}
+
+		return true;
+	}
+
+	struct Fixture
+	{
+		Fixture()
+		{
+		}
+
+		HostedSendPipeline host;
+		HostedSendPipelineConfig config;
+		Receiver receiver;
+	};
+
+	TEST_FIXTURE(Fixture, SendPipeline_Create)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+		CHECK_EQUAL(true, host.m_pipeline->isEnabled());
+		CHECK_EQUAL(false, host.m_pipeline->isRunning());
+	}
+
+	TEST_FIXTURE(Fixture, SendPipeline_CreateDisabled)
+	{
+		SendPipelineConfig pipelineConfig;
+		CHECK_EQUAL(0, host.Setup(pipelineConfig));
+		CHECK_EQUAL(false, host.m_pipeline->isEnabled());
+
+		// Draining or ending a pipeline that never started is harmless
+		host.m_pipeline->drain();
+		host.m_pipeline->end();
+		CHECK_EQUAL(false, host.m_pipeline->isRunning());
+	}
+
+	TEST_FIXTURE(Fixture, SendPipeline_SendsInOrder)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		host.m_pipeline->begin(Receiver::Send, &receiver);
+		CHECK_EQUAL(true, host.m_pipeline->isRunning());
+
+		const int32_t iTotal = EnqueueMessages(host.m_pipeline, 200);
+		host.m_pipeline->end();
+
+		CHECK_EQUAL(false, host.m_pipeline->isRunning());
+		CHECK_EQUAL(false, host.m_pipeline->hadSendError());
+		CHECK_EQUAL(iTotal, receiver.size);
+		CHECK_EQUAL((uint64_t)iTotal, host.m_pipeline->getNumBytes());
+		CHECK(CheckPattern(receiver));
+	}
+
+	TEST_FIXTURE(Fixture, SendPipeline_PartialSends)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		receiver.maxPerSend = 3;
+		host.m_pipeline->begin(Receiver::Send, &receiver);
+
+		const int32_t iTotal = EnqueueMessages(host.m_pipeline, 100);
+		host.m_pipeline->end();
+
+		CHECK_EQUAL(iTotal, receiver.size);
+		CHECK(host.m_pipeline->getNumSends() >= (uint32_t)(iTotal / 3));
+		CHECK(CheckPattern(receiver));
+	}
+
+	TEST_FIXTURE(Fixture, SendPipeline_DrainEmptiesQueue)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		host.m_pipeline->begin(Receiver::Send, &receiver);
+
+		const int32_t iTotal = EnqueueMessages(host.m_pipeline, 10);
+		host.m_pipeline->drain();
+
+		// Everything is out while the worker is still running
+		CHECK_EQUAL(true, host.m_pipeline->isRunning());
+		CHECK_EQUAL(iTotal, receiver.size);
+
+		host.m_pipeline->end();
+	}
+
+	TEST_FIXTURE(Fixture, SendPipeline_SendErrorDropsRest)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		receiver.fail = true;
+		host.m_pipeline->begin(Receiver::Send, &receiver);
+
+		// Must not block even though nothing goes out
+		EnqueueMessages(host.m_pipeline, 100);
+		host.m_pipeline->end();
+
+		CHECK_EQUAL(true, host.m_pipeline->hadSendError());
+		CHECK_EQUAL(0, receiver.size);
+		CHECK_EQUAL((uint64_t)0, host.m_pipeline->getNumBytes());
+	}
+
+	TEST_FIXTURE(Fixture, SendPipeline_Restart)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		host.m_pipeline->begin(Receiver::Send, &receiver);
+		EnqueueMessages(host.m_pipeline, 5);
+		host.m_pipeline->end();
+
+		// Each stop starts from a clean queue
+		receiver.size = 0;
+		host.m_pipeline->begin(Receiver::Send, &receiver);
+		const int32_t iTotal = EnqueueMessages(host.m_pipeline, 50);
+		host.m_pipeline->end();
+
+		CHECK_EQUAL(iTotal, receiver.size);
+		CHECK(CheckPattern(receiver));
+	}
+}}}
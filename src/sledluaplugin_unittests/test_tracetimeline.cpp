@@ -0,0 +1,196 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "../sledluaplugin/sledluaplugin.h"
+#include "../sledluaplugin/profilestack.h"
+#include "../sledluaplugin/tracetimeline.h"
+
+#include <unittest-cpp/UnitTest++/UnitTest++.h>
+
+#include <cstring>
+#include <string>
+
+namespace sce { namespace Sled { namespace
+{
+	class HostedTraceTimeline
+	{
+	public:
+		HostedTraceTimeline()
+			: m_timeline(0)
+			, m_stack(0)
+			, m_timelineMem(0)
+			, m_stackMem(0)
+		{
+		}
+
+		~HostedTraceTimeline()
+		{
+			if (m_timeline)
+				TraceTimeline::shutdown(m_timeline);
+
+			if (m_stack)
+				ProfileStack::shutdown(m_stack);
+
+			delete [] m_timelineMem;
+			delete [] m_stackMem;
+		}
+
+		int32_t Setup(uint32_t iMaxEvents, uint16_t iMaxRings)
+		{
+			ProfileStackConfig stackConfig;
+			stackConfig.maxFunctions = 16;
+			stackConfig.maxCallStackDepth = 16;
+
+			std::size_t iMemSize;
+
+			int32_t iError = ProfileStack::requiredMemory(stackConfig, &iMemSize);
+			if (iError != 0)
+				return iError;
+
+			m_stackMem = new char[iMemSize];
+			iError = ProfileStack::create(stackConfig, m_stackMem, &m_stack);
+			if (iError != 0)
+				return iError;
+
+			TraceTimelineConfig config;
+			config.maxEvents = iMaxEvents;
+			config.maxRings = iMaxRings;
+
+			iError = TraceTimeline::requiredMemory(config, &iMemSize);
+			if (iError != 0)
+				return iError;
+
+			m_timelineMem = new char[iMemSize];
+			std::memset(m_timelineMem, 0xAB, iMemSize);
+
+			return TraceTimeline::create(config, m_timelineMem, &m_timeline);
+		}
+
+		// Enters or leaves a function through the stack, recording it the way the plugin's hook does
+		void Record(const void *pOwner, uint32_t iType, const char *pszName)
+		{
+			ProfileEntry *pEntry = (iType == TraceEvent::kEnter)
+				? m_stack->enterFn(pszName, "level1.lua", 10)
+				: m_stack->leaveFn(pszName, "level1.lua", 10);
+
+			if (pEntry)
+				m_timeline->record(pOwner, iType, m_stack->getFnIndex(pEntry));
+		}
+
+		TraceTimeline *m_timeline;
+		ProfileStack *m_stack;
+
+	private:
+		char *m_timelineMem;
+		char *m_stackMem;
+	};
+
+	bool WriteToString(const char *pData, int32_t iLen, void *pUserData)
+	{
+		static_cast<std::string*>(pUserData)->append(pData, iLen);
+		return true;
+	}
+
+	bool FailWrite(const char *, int32_t, void *)
+	{
+		return false;
+	}
+
+	int CountOf(const std::string& text, const char *pszFind)
+	{
+		int iCount = 0;
+		for (std::string::size_type pos = text.find(pszFind); pos != std::string::npos; pos = text.find(pszFind, pos + 1))
+			iCount++;
+
+		return iCount;
+	}
+
+	const int kState1 = 1;
+	const int kState2 = 2;
+	const int kState3 = 3;
+
+	TEST(TraceTimeline_Disabled)
+	{
+		HostedTraceTimeline host;
+		CHECK_EQUAL(0, host.Setup(0, 2));
+		CHECK_EQUAL(false, host.m_timeline->isEnabled());
+		CHECK_EQUAL(false, host.m_timeline->acquireRing(&kState1));
+		CHECK_EQUAL(false, host.m_timeline->record(&kState1, TraceEvent::kEnter, 0));
+	}
+
+	TEST(TraceTimeline_Rings)
+	{
+		HostedTraceTimeline host;
+		CHECK_EQUAL(0, host.Setup(8, 2));
+		CHECK_EQUAL(true, host.m_timeline->acquireRing(&kState1));
+		CHECK_EQUAL(true, host.m_timeline->acquireRing(&kState2));
+		CHECK_EQUAL(false, host.m_timeline->acquireRing(&kState3));
+
+		// Only owners of a ring are recorded
+		CHECK_EQUAL(false, host.m_timeline->record(&kState3, TraceEvent::kEnter, 0));
+		CHECK_EQUAL(true, host.m_timeline->record(&kState2, TraceEvent::kEnter, 0));
+		CHECK_EQUAL((uint32_t)1, host.m_timeline->getNumEvents(&kState2));
+		CHECK_EQUAL((uint32_t)0, host.m_timeline->getNumEvents(&kState1));
+
+		host.m_timeline->releaseRing(&kState2);
+		CHECK_EQUAL(true, host.m_timeline->acquireRing(&kState3));
+		CHECK_EQUAL((uint32_t)0, host.m_timeline->getNumEvents(&kState3));
+	}
+
+	TEST(TraceTimeline_RingWraps)
+	{
+		HostedTraceTimeline host;
+		CHECK_EQUAL(0, host.Setup(4, 1));
+		CHECK_EQUAL(true, host.m_timeline->acquireRing(&kState1));
+
+		host.Record(&kState1, TraceEvent::kEnter, "update");
+		host.Record(&kState1, TraceEvent::kEnter, "move");
+		host.Record(&kState1, TraceEvent::kLeave, "move");
+		host.Record(&kState1, TraceEvent::kLeave, "update");
+		host.Record(&kState1, TraceEvent::kEnter, "draw");
+		host.Record(&kState1, TraceEvent::kLeave, "draw");
+		CHECK_EQUAL((uint32_t)4, host.m_timeline->getNumEvents(&kState1));
+
+		// The returns from calls that fell out of the ring are left out
+		std::string json;
+		CHECK_EQUAL(true, host.m_timeline->writeJson(host.m_stack, WriteToString, &json, 0, 0));
+		CHECK_EQUAL(1, CountOf(json, "\"ph\":\"B\""));
+		CHECK_EQUAL(1, CountOf(json, "\"ph\":\"E\""));
+		CHECK_EQUAL(1, CountOf(json, "\"name\":\"draw\""));
+		CHECK_EQUAL(0, CountOf(json, "\"name\":\"update\""));
+	}
+
+	TEST(TraceTimeline_WriteJson)
+	{
+		HostedTraceTimeline host;
+		CHECK_EQUAL(0, host.Setup(16, 2));
+		CHECK_EQUAL(true, host.m_timeline->acquireRing(&kState1));
+		CHECK_EQUAL(true, host.m_timeline->acquireRing(&kState2));
+
+		host.Record(&kState1, TraceEvent::kEnter, "update");
+		host.Record(&kState1, TraceEvent::kEnter, "move");
+		host.Record(&kState1, TraceEvent::kLeave, "move");
+		host.Record(&kState2, TraceEvent::kEnter, "ai\"think");
+
+		std::string json;
+		CHECK_EQUAL(true, host.m_timeline->writeJson(host.m_stack, WriteToString, &json, 0, 0));
+
+		CHECK_EQUAL((std::string::size_type)0, json.find("{\"traceEvents\":["));
+		CHECK(json.find("],\"displayTimeUnit\":\"ms\"}") != std::string::npos);
+		CHECK_EQUAL(2, CountOf(json, "\"thread_name\""));
+		CHECK_EQUAL(1, CountOf(json, "\"name\":\"ai\\\"think\""));
+		CHECK_EQUAL(3, CountOf(json, "\"source\":\"level1.lua\",\"line\":10"));
+
+		// Calls still open at the end are closed
+		CHECK_EQUAL(3, CountOf(json, "\"ph\":\"B\""));
+		CHECK_EQUAL(3, CountOf(json, "\"ph\":\"E\""));
+
+		CHECK_EQUAL(false, host.m_timeline->writeJson(host.m_stack, FailWrite, 0, 0, 0));
+
+		host.m_timeline->clear();
+		CHECK_EQUAL((uint32_t)0, host.m_timeline->getNumEvents(&kState1));
+		CHECK_EQUAL((uint32_t)0, host.m_timeline->getNumEvents(&kState2));
+	}
+}}}
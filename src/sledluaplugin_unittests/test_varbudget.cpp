@@ -0,0 +1,178 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "../sledluaplugin/sledluaplugin.h"
+#include "../sledluaplugin/varbudget.h"
+
+#include <unittest-cpp/UnitTest++/UnitTest++.h>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+namespace sce { namespace Sled { namespace
+{
+	class HostedVarBudgetConfig
+	{
+	public:	
+		VarBudgetConfig Default()
+		{
+			VarBudgetConfig config;
+			Setup(config);
+			return config;
+		}
+	private:
+		static void Setup(VarBudgetConfig& config)
+		{
+			config.maxEntries = 4;
+			config.maxBytes = 100;
+			config.timeBudget = 0.0f;
+		}
+	};
+
+	class HostedVarBudget
+	{
+	public:
+		HostedVarBudget()
+		{
+			m_budget = 0;
+			m_budgetMem = 0;
+		}
+
+		~HostedVarBudget()
+		{
+			if (m_budget)
+			{
+				VarBudget::shutdown(m_budget);
+				m_budget = 0;
+			}
+
+			if (m_budgetMem)
+			{
+				delete [] m_budgetMem;
+				m_budgetMem = 0;
+			}
+		}
+
+		int32_t Setup(const VarBudgetConfig& config)
+		{
+			std::size_t iMemSize;
+
+			const int32_t iError = VarBudget::requiredMemory(config, &iMemSize);
+			if (iError != 0)
+				return iError;
+
+			m_budgetMem = new char[iMemSize];
+			std::memset(m_budgetMem, 0xAB, iMemSize);
+			if (!m_budgetMem)
+				return -1;
+
+			return VarBudget::create(config, m_budgetMem, &m_budget);
+		}
+
+		VarBudget *m_budget;
+
+	private:
+		char *m_budgetMem;
+	};
+
+	struct Fixture
+	{
+		Fixture()
+		{
+		}
+
+		HostedVarBudget host;
+		HostedVarBudgetConfig config;
+	};
+
+	TEST_FIXTURE(Fixture, VarBudget_Create)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+		CHECK_EQUAL(true, host.m_budget->isEnabled());
+
+		host.m_budget->begin();
+		CHECK_EQUAL(false, host.m_budget->isExhausted());
+		CHECK_EQUAL((uint32_t)0, host.m_budget->getNumEntries());
+		CHECK_EQUAL((uint64_t)0, host.m_budget->getNumBytes());
+	}
+
+	TEST_FIXTURE(Fixture, VarBudget_CreateDisabled)
+	{
+		VarBudgetConfig budgetConfig;
+		CHECK_EQUAL(0, host.Setup(budgetConfig));
+		CHECK_EQUAL(false, host.m_budget->isEnabled());
+
+		// No limits means never exhausted
+		host.m_budget->begin();
+		for (int i = 0; i < 1000; i++)
+			host.m_budget->spend(1000);
+		CHECK_EQUAL(false, host.m_budget->isExhausted());
+	}
+
+	TEST_FIXTURE(Fixture, VarBudget_EntryLimit)
+	{
+		VarBudgetConfig budgetConfig = config.Default();
+		budgetConfig.maxBytes = 0;
+		CHECK_EQUAL(0, host.Setup(budgetConfig));
+
+		host.m_budget->begin();
+		for (int i = 0; i < 3; i++)
+		{
+			host.m_budget->spend(10);
+			CHECK_EQUAL(false, host.m_budget->isExhausted());
+		}
+
+		host.m_budget->spend(10);
+		CHECK_EQUAL(true, host.m_budget->isExhausted());
+		CHECK_EQUAL((uint32_t)4, host.m_budget->getNumEntries());
+	}
+
+	TEST_FIXTURE(Fixture, VarBudget_ByteLimit)
+	{
+		VarBudgetConfig budgetConfig = config.Default();
+		budgetConfig.maxEntries = 0;
+		CHECK_EQUAL(0, host.Setup(budgetConfig));
+
+		host.m_budget->begin();
+		host.m_budget->spend(60);
+		CHECK_EQUAL(false, host.m_budget->isExhausted());
+		host.m_budget->spend(60);
+		CHECK_EQUAL(true, host.m_budget->isExhausted());
+		CHECK_EQUAL((uint64_t)120, host.m_budget->getNumBytes());
+	}
+
+	TEST_FIXTURE(Fixture, VarBudget_TimeLimit)
+	{
+		VarBudgetConfig budgetConfig;
+		budgetConfig.timeBudget = 0.000001f;
+		CHECK_EQUAL(0, host.Setup(budgetConfig));
+		CHECK_EQUAL(true, host.m_budget->isEnabled());
+
+		host.m_budget->begin();
+
+		// Spin until the clock moves past the budget
+		bool bExhausted = false;
+		for (int i = 0; (i < 100000000) && !bExhausted; i++)
+			bExhausted = host.m_budget->isExhausted();
+
+		CHECK_EQUAL(true, bExhausted);
+	}
+
+	TEST_FIXTURE(Fixture, VarBudget_StaysExhaustedUntilBegin)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		host.m_budget->begin();
+		host.m_budget->spend(200);
+		CHECK_EQUAL(true, host.m_budget->isExhausted());
+		CHECK_EQUAL(true, host.m_budget->wasExhausted());
+		CHECK_EQUAL(true, host.m_budget->isExhausted());
+
+		host.m_budget->begin();
+		CHECK_EQUAL(false, host.m_budget->wasExhausted());
+		CHECK_EQUAL(false, host.m_budget->isExhausted());
+	}
+}}}
@@ -0,0 +1,215 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "../sledluaplugin/sledluaplugin.h"
+#include "../sleddebugger/utilities.h"
+#include "../sleddebugger/errorcodes.h"
+#include "../sledluaplugin/varfilter.h"
+
+#include <unittest-cpp/UnitTest++/UnitTest++.h>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+namespace sce { namespace Sled { namespace
+{
+	class HostedVarFilterNameContainerConfig
+	{
+	public:	
+		VarFilterNameContainerConfig Default()
+		{
+			LuaPluginConfig luaConfig;
+			luaConfig.maxNumVarFilters = 8;
+			luaConfig.maxPatternsPerVarFilter = 4;
+			luaConfig.maxVarFilterPatternLen = 32;
+			return VarFilterNameContainerConfig(&luaConfig);
+		}
+	};
+
+	class HostedVarFilterNameContainer
+	{
+	public:
+		HostedVarFilterNameContainer()
+		{
+			m_container = 0;
+			m_containerMem = 0;
+		}
+
+		~HostedVarFilterNameContainer()
+		{
+			if (m_container)
+			{
+				VarFilterNameContainer::shutdown(m_container);
+				m_container = 0;
+			}
+
+			if (m_containerMem)
+			{
+				delete [] m_containerMem;
+				m_containerMem = 0;
+			}
+		}
+
+		int32_t Setup(const VarFilterNameContainerConfig& config)
+		{
+			std::size_t iMemSize;
+
+			const int32_t iError = VarFilterNameContainer::requiredMemory(config, &iMemSize);
+			if (iError != 0)
+				return iError;
+
+			m_containerMem = new char[iMemSize];
+			std::memset(m_containerMem, 0xAB, iMemSize);
+			if (!m_containerMem)
+				return -1;
+
+			return VarFilterNameContainer::create(config, m_containerMem, &m_container);
+		}
+
+		VarFilterNameContainer *m_container;
+
+	private:
+		char *m_containerMem;
+	};
+
+	struct Fixture
+	{
+		Fixture()
+		{
+		}
+
+		HostedVarFilterNameContainer host;
+		HostedVarFilterNameContainerConfig config;
+	};
+
+	TEST_FIXTURE(Fixture, VarFilterNameContainer_Create)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+		CHECK_EQUAL(true, host.m_container->isEmpty());
+		CHECK_EQUAL(false, host.m_container->isFiltered("a", 'g'));
+	}
+
+	TEST_FIXTURE(Fixture, VarFilterNameContainer_Compile)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+		CHECK_EQUAL(true, host.m_container->addFilter('g', "foo"));
+		CHECK_EQUAL(false, host.m_container->isCompiled());
+		CHECK_EQUAL(true, host.m_container->compile());
+		CHECK_EQUAL(true, host.m_container->isCompiled());
+
+		// Changing the filters recompiles on the next check
+		CHECK_EQUAL(true, host.m_container->addFilter('g', "bar"));
+		CHECK_EQUAL(true, host.m_container->isFiltered("bar", 'g'));
+		CHECK_EQUAL(true, host.m_container->isCompiled());
+
+		host.m_container->clear('g');
+		CHECK_EQUAL(false, host.m_container->isFiltered("foo", 'g'));
+		CHECK_EQUAL(false, host.m_container->isFiltered("bar", 'g'));
+	}
+
+	TEST_FIXTURE(Fixture, VarFilterNameContainer_Patterns)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+		CHECK_EQUAL(true, host.m_container->addFilter('g', "exact"));
+		CHECK_EQUAL(true, host.m_container->addFilter('g', "pre*"));
+		CHECK_EQUAL(true, host.m_container->addFilter('g', "*post"));
+		CHECK_EQUAL(true, host.m_container->addFilter('g', "*mid*"));
+		CHECK_EQUAL(true, host.m_container->addFilter('g', "a*b*c"));
+		host.m_container->compile();
+
+		CHECK_EQUAL(true, host.m_container->isFiltered("exact", 'g'));
+		CHECK_EQUAL(false, host.m_container->isFiltered("exactly", 'g'));
+		CHECK_EQUAL(false, host.m_container->isFiltered("inexact", 'g'));
+
+		CHECK_EQUAL(true, host.m_container->isFiltered("pre", 'g'));
+		CHECK_EQUAL(true, host.m_container->isFiltered("prefix", 'g'));
+		CHECK_EQUAL(false, host.m_container->isFiltered("xpre", 'g'));
+
+		CHECK_EQUAL(true, host.m_container->isFiltered("post", 'g'));
+		CHECK_EQUAL(true, host.m_container->isFiltered("signpost", 'g'));
+		CHECK_EQUAL(false, host.m_container->isFiltered("postage", 'g'));
+
+		CHECK_EQUAL(true, host.m_container->isFiltered("mid", 'g'));
+		CHECK_EQUAL(true, host.m_container->isFiltered("amidst", 'g'));
+
+		CHECK_EQUAL(true, host.m_container->isFiltered("abc", 'g'));
+		CHECK_EQUAL(true, host.m_container->isFiltered("axxbyyc", 'g'));
+		CHECK_EQUAL(true, host.m_container->isFiltered("abcabc", 'g'));
+		CHECK_EQUAL(false, host.m_container->isFiltered("acb", 'g'));
+		CHECK_EQUAL(false, host.m_container->isFiltered("abcd", 'g'));
+
+		CHECK_EQUAL(false, host.m_container->isFiltered("", 'g'));
+		CHECK_EQUAL(false, host.m_container->isFiltered("other", 'g'));
+	}
+
+	TEST_FIXTURE(Fixture, VarFilterNameContainer_FragmentsDontOverlap)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+		CHECK_EQUAL(true, host.m_container->addFilter('g', "ab*bc*"));
+		CHECK_EQUAL(true, host.m_container->addFilter('l', "a*b"));
+		host.m_container->compile();
+
+		CHECK_EQUAL(false, host.m_container->isFiltered("abcx", 'g'));
+		CHECK_EQUAL(true, host.m_container->isFiltered("abbcx", 'g'));
+
+		// Last fragment is anchored to the end, not taken at its first match
+		CHECK_EQUAL(true, host.m_container->isFiltered("abab", 'l'));
+		CHECK_EQUAL(true, host.m_container->isFiltered("ab", 'l'));
+		CHECK_EQUAL(false, host.m_container->isFiltered("aba", 'l'));
+	}
+
+	TEST_FIXTURE(Fixture, VarFilterNameContainer_Scopes)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+		CHECK_EQUAL(true, host.m_container->addFilter('g', "x"));
+		CHECK_EQUAL(true, host.m_container->addFilter('u', "*"));
+		host.m_container->compile();
+
+		CHECK_EQUAL(true, host.m_container->isFiltered("x", 'g'));
+		CHECK_EQUAL(false, host.m_container->isFiltered("x", 'l'));
+		CHECK_EQUAL(false, host.m_container->isFiltered("x", 'e'));
+
+		// Only asterisks matches every name
+		CHECK_EQUAL(true, host.m_container->isFiltered("x", 'u'));
+		CHECK_EQUAL(true, host.m_container->isFiltered("anything", 'u'));
+
+		host.m_container->clear('u');
+		CHECK_EQUAL(false, host.m_container->isFiltered("x", 'u'));
+		CHECK_EQUAL(true, host.m_container->isFiltered("x", 'g'));
+	}
+
+	TEST_FIXTURE(Fixture, VarFilterNameContainer_SharedFragments)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+		CHECK_EQUAL(true, host.m_container->addFilter('e', "he*"));
+		CHECK_EQUAL(true, host.m_container->addFilter('e', "*she"));
+		CHECK_EQUAL(true, host.m_container->addFilter('e', "*his*hers"));
+		host.m_container->compile();
+
+		CHECK_EQUAL(true, host.m_container->isFiltered("hello", 'e'));
+		CHECK_EQUAL(true, host.m_container->isFiltered("ushe", 'e'));
+		CHECK_EQUAL(true, host.m_container->isFiltered("xhis_hers", 'e'));
+		CHECK_EQUAL(true, host.m_container->isFiltered("hishers", 'e'));
+		CHECK_EQUAL(false, host.m_container->isFiltered("ahers", 'e'));
+		CHECK_EQUAL(false, host.m_container->isFiltered("shell", 'e'));
+	}
+
+	TEST_FIXTURE(Fixture, VarFilterNameContainer_ExactIgnoresCase)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+		CHECK_EQUAL(true, host.m_container->addFilter('g', "Self"));
+		CHECK_EQUAL(true, host.m_container->addFilter('g', "Tmp*"));
+		host.m_container->compile();
+
+		CHECK_EQUAL(true, host.m_container->isFiltered("self", 'g'));
+		CHECK_EQUAL(true, host.m_container->isFiltered("SELF", 'g'));
+		CHECK_EQUAL(false, host.m_container->isFiltered("selfish", 'g'));
+
+		// Wildcard fragments are case sensitive
+		CHECK_EQUAL(true, host.m_container->isFiltered("Tmp1", 'g'));
+		CHECK_EQUAL(false, host.m_container->isFiltered("tmp1", 'g'));
+	}
+}}}
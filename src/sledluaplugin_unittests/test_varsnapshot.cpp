@@ -0,0 +1,305 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "../sledluaplugin/sledluaplugin.h"
+#include "../sleddebugger/utilities.h"
+#include "../sleddebugger/errorcodes.h"
+#include "../sledluaplugin/varsnapshot.h"
+#include "../sledluaplugin/scmp.h"
+
+#include <unittest-cpp/UnitTest++/UnitTest++.h>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+namespace sce { namespace Sled { namespace
+{
+	class HostedVarSnapshotConfig
+	{
+	public:	
+		VarSnapshotConfig Default()
+		{
+			VarSnapshotConfig config;
+			Setup(config);
+			return config;
+		}
+	private:
+		static void Setup(VarSnapshotConfig& config)
+		{
+			config.maxVars = 8;
+			config.maxNameBytes = 64;
+		}
+	};
+
+	class HostedVarSnapshot
+	{
+	public:
+		HostedVarSnapshot()
+		{
+			m_snapshot = 0;
+			m_snapshotMem = 0;
+		}
+
+		~HostedVarSnapshot()
+		{
+			if (m_snapshot)
+			{
+				VarSnapshot::shutdown(m_snapshot);
+				m_snapshot = 0;
+			}
+
+			if (m_snapshotMem)
+			{
+				delete [] m_snapshotMem;
+				m_snapshotMem = 0;
+			}
+		}
+
+		int32_t Setup(const VarSnapshotConfig& config)
+		{
+			std::size_t iMemSize;
+
+			const int32_t iError = VarSnapshot::requiredMemory(config, &iMemSize);
+			if (iError != 0)
+				return iError;
+
+			m_snapshotMem = new char[iMemSize];
+			std::memset(m_snapshotMem, 0xAB, iMemSize);
+			if (!m_snapshotMem)
+				return -1;
+
+			return VarSnapshot::create(config, m_snapshotMem, &m_snapshot);
+		}
+
+		VarSnapshot *m_snapshot;
+
+	private:
+		char *m_snapshotMem;
+	};
+
+	struct Fixture
+	{
+		Fixture()
+		{
+		}
+
+		HostedVarSnapshot host;
+		HostedVarSnapshotConfig config;
+	};
+
+	// Lua type codes as used by the plugin
+	const int32_t kNumber = 3;
+	const int32_t kString = 4;
+
+	TEST_FIXTURE(Fixture, VarSnapshot_Create)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+		CHECK_EQUAL(true, host.m_snapshot->isEnabled());
+		CHECK_EQUAL(true, host.m_snapshot->isFull());
+		CHECK_EQUAL((uint32_t)0, host.m_snapshot->getNumPrevious());
+	}
+
+	TEST_FIXTURE(Fixture, VarSnapshot_CreateDisabled)
+	{
+		VarSnapshotConfig snapshotConfig;
+		CHECK_EQUAL(0, host.Setup(snapshotConfig));
+		CHECK_EQUAL(false, host.m_snapshot->isEnabled());
+
+		// Everything is sent when disabled
+		host.m_snapshot->begin(&host);
+		CHECK_EQUAL(true, host.m_snapshot->update('g', 0, 0, "a", kString, "1", kNumber));
+		host.m_snapshot->end();
+		host.m_snapshot->begin(&host);
+		CHECK_EQUAL(true, host.m_snapshot->update('g', 0, 0, "a", kString, "1", kNumber));
+		host.m_snapshot->end();
+	}
+
+	TEST_FIXTURE(Fixture, VarSnapshot_InvalidConfig)
+	{
+		VarSnapshotConfig snapshotConfig = config.Default();
+		snapshotConfig.maxNameBytes = 0;
+		CHECK_EQUAL(SCE_SLED_ERROR_INVALIDCONFIGURATION, host.Setup(snapshotConfig));
+	}
+
+	TEST_FIXTURE(Fixture, VarSnapshot_FirstStopIsFull)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		host.m_snapshot->begin(&host);
+		CHECK_EQUAL(true, host.m_snapshot->isFull());
+		CHECK_EQUAL(true, host.m_snapshot->update('g', 0, 0, "a", kString, "1", kNumber));
+		CHECK_EQUAL(true, host.m_snapshot->update('g', 0, 0, "b", kString, "2", kNumber));
+		CHECK_EQUAL((uint32_t)2, host.m_snapshot->getNumAdded());
+		CHECK_EQUAL((uint32_t)0, host.m_snapshot->getNumRemoved());
+		host.m_snapshot->end();
+	}
+
+	TEST_FIXTURE(Fixture, VarSnapshot_Diff)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		host.m_snapshot->begin(&host);
+		host.m_snapshot->update('g', 0, 0, "same", kString, "1", kNumber);
+		host.m_snapshot->update('g', 0, 0, "changed", kString, "2", kNumber);
+		host.m_snapshot->update('g', 0, 0, "removed", kString, "3", kNumber);
+		host.m_snapshot->update('l', 0, 1, "i", kString, "4", kNumber);
+		host.m_snapshot->end();
+
+		host.m_snapshot->begin(&host);
+		CHECK_EQUAL(false, host.m_snapshot->isFull());
+		CHECK_EQUAL(false, host.m_snapshot->update('g', 0, 0, "same", kString, "1", kNumber));
+		CHECK_EQUAL(true, host.m_snapshot->update('g', 0, 0, "changed", kString, "20", kNumber));
+		CHECK_EQUAL(true, host.m_snapshot->update('g', 0, 0, "added", kString, "5", kNumber));
+
+		// Same name at a different stack level is a different variable
+		CHECK_EQUAL(true, host.m_snapshot->update('l', 1, 1, "i", kString, "4", kNumber));
+
+		CHECK_EQUAL((uint32_t)2, host.m_snapshot->getNumAdded());
+		CHECK_EQUAL((uint32_t)1, host.m_snapshot->getNumChanged());
+		CHECK_EQUAL((uint32_t)1, host.m_snapshot->getNumUnchanged());
+
+		uint32_t iNumRemoved = 0;
+		bool bFoundRemoved = false;
+		for (uint32_t i = 0; i < host.m_snapshot->getNumPrevious(); i++)
+		{
+			const VarSnapshotEntry *pEntry = host.m_snapshot->getRemoved(i);
+			if (pEntry == NULL)
+				continue;
+
+			++iNumRemoved;
+			if (std::strcmp(host.m_snapshot->getRemovedName(pEntry), "removed") == 0)
+				bFoundRemoved = (pEntry->what == 'g');
+		}
+
+		CHECK_EQUAL((uint32_t)2, iNumRemoved);
+		CHECK_EQUAL(iNumRemoved, host.m_snapshot->getNumRemoved());
+		CHECK_EQUAL(true, bFoundRemoved);
+		host.m_snapshot->end();
+	}
+
+	TEST_FIXTURE(Fixture, VarSnapshot_TypeChangeIsChange)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		host.m_snapshot->begin(&host);
+		host.m_snapshot->update('g', 0, 0, "a", kString, "1", kNumber);
+		host.m_snapshot->end();
+
+		host.m_snapshot->begin(&host);
+		CHECK_EQUAL(true, host.m_snapshot->update('g', 0, 0, "a", kString, "1", kString));
+		CHECK_EQUAL((uint32_t)1, host.m_snapshot->getNumChanged());
+		host.m_snapshot->end();
+	}
+
+	TEST_FIXTURE(Fixture, VarSnapshot_LongStringChangeIsChange)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		// Two strings longer than a VarValue holds that only differ past
+		// the part that is kept
+		char szLong[400];
+		std::memset(szLong, 'x', sizeof(szLong));
+
+		SCMP::VarValue first;
+		first.setString(szLong, 300);
+
+		SCMP::VarValue second;
+		second.setString(szLong, 400);
+
+		CHECK_EQUAL(0, std::strcmp(first.text, second.text));
+
+		host.m_snapshot->begin(&host);
+		host.m_snapshot->update('g', 0, 0, "s", kString, first, kString);
+		host.m_snapshot->end();
+
+		host.m_snapshot->begin(&host);
+		CHECK_EQUAL(false, host.m_snapshot->update('g', 0, 0, "s", kString, first, kString));
+		host.m_snapshot->end();
+
+		host.m_snapshot->begin(&host);
+		CHECK_EQUAL(true, host.m_snapshot->update('g', 0, 0, "s", kString, second, kString));
+		CHECK_EQUAL((uint32_t)1, host.m_snapshot->getNumChanged());
+		host.m_snapshot->end();
+	}
+
+	TEST_FIXTURE(Fixture, VarSnapshot_DifferentOwnerIsFull)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		int iOtherOwner = 0;
+
+		host.m_snapshot->begin(&host);
+		host.m_snapshot->update('g', 0, 0, "a", kString, "1", kNumber);
+		host.m_snapshot->end();
+
+		host.m_snapshot->begin(&iOtherOwner);
+		CHECK_EQUAL(true, host.m_snapshot->isFull());
+		CHECK_EQUAL(true, host.m_snapshot->update('g', 0, 0, "a", kString, "1", kNumber));
+		CHECK_EQUAL((uint32_t)0, host.m_snapshot->getNumRemoved());
+		host.m_snapshot->end();
+	}
+
+	TEST_FIXTURE(Fixture, VarSnapshot_OverflowForcesFullStop)
+	{
+		VarSnapshotConfig snapshotConfig = config.Default();
+		snapshotConfig.maxVars = 2;
+		CHECK_EQUAL(0, host.Setup(snapshotConfig));
+
+		host.m_snapshot->begin(&host);
+		host.m_snapshot->update('g', 0, 0, "a", kString, "1", kNumber);
+		host.m_snapshot->update('g', 0, 0, "b", kString, "2", kNumber);
+		host.m_snapshot->update('g', 0, 0, "c", kString, "3", kNumber);
+		host.m_snapshot->end();
+
+		// Previous stop did not fit so there is nothing to diff against
+		host.m_snapshot->begin(&host);
+		CHECK_EQUAL(true, host.m_snapshot->isFull());
+		host.m_snapshot->update('g', 0, 0, "a", kString, "1", kNumber);
+		host.m_snapshot->end();
+
+		host.m_snapshot->begin(&host);
+		CHECK_EQUAL(false, host.m_snapshot->isFull());
+		CHECK_EQUAL(false, host.m_snapshot->update('g', 0, 0, "a", kString, "1", kNumber));
+		host.m_snapshot->end();
+	}
+
+	TEST_FIXTURE(Fixture, VarSnapshot_TruncateForcesFullStop)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		host.m_snapshot->begin(&host);
+		host.m_snapshot->update('g', 0, 0, "a", kString, "1", kNumber);
+		host.m_snapshot->end();
+
+		host.m_snapshot->begin(&host);
+		CHECK_EQUAL(false, host.m_snapshot->isTruncated());
+		host.m_snapshot->truncate();
+		CHECK_EQUAL(true, host.m_snapshot->isTruncated());
+		host.m_snapshot->end();
+
+		host.m_snapshot->begin(&host);
+		CHECK_EQUAL(false, host.m_snapshot->isTruncated());
+		CHECK_EQUAL(true, host.m_snapshot->isFull());
+		CHECK_EQUAL(true, host.m_snapshot->update('g', 0, 0, "a", kString, "1", kNumber));
+		host.m_snapshot->end();
+	}
+
+	TEST_FIXTURE(Fixture, VarSnapshot_Clear)
+	{
+		CHECK_EQUAL(0, host.Setup(config.Default()));
+
+		host.m_snapshot->begin(&host);
+		host.m_snapshot->update('g', 0, 0, "a", kString, "1", kNumber);
+		host.m_snapshot->end();
+
+		host.m_snapshot->clear();
+
+		host.m_snapshot->begin(&host);
+		CHECK_EQUAL(true, host.m_snapshot->isFull());
+		CHECK_EQUAL(true, host.m_snapshot->update('g', 0, 0, "a", kString, "1", kNumber));
+		host.m_snapshot->end();
+	}
+}}}
@@ -0,0 +1,109 @@
+﻿/*
+ * Copyright (C) Sony Computer Entertainment America LLC. 
+ * All Rights Reserved. 
+ */
+
+#include "../sledluaplugin/sledluaplugin.h"
+#include "../sleddebugger/utilities.h"
+#include "../sledluaplugin/scmp.h"
+
+#include <unittest-cpp/UnitTest++/UnitTest++.h>
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+
+namespace sce { namespace Sled { namespace
+{
+	TEST(VarValue_DefaultIsEmptyText)
+	{
+		const SCMP::VarValue value;
+		CHECK_EQUAL((int)SCMP::VarValue::kText, (int)value.kind);
+		CHECK_EQUAL("", value.text);
+		CHECK_EQUAL((std::size_t)0, value.getDataLen());
+	}
+
+	TEST(VarValue_IntegralNumbersAreIntegers)
+	{
+		SCMP::VarValue value;
+
+		value.setNumber(-42.0);
+		CHECK_EQUAL((int)SCMP::VarValue::kInteger, (int)value.kind);
+		CHECK(value.integer == -42);
+
+		value.setNumber(4294967296.0);
+		CHECK_EQUAL((int)SCMP::VarValue::kInteger, (int)value.kind);
+		CHECK(value.integer == 4294967296LL);
+		CHECK_EQUAL(sizeof(int64_t), value.getDataLen());
+	}
+
+	TEST(VarValue_OtherNumbersAreDoubles)
+	{
+		SCMP::VarValue value;
+
+		value.setNumber(0.5);
+		CHECK_EQUAL((int)SCMP::VarValue::kNumber, (int)value.kind);
+		CHECK_EQUAL(0.5, value.number);
+
+		// Out of int64 range
+		value.setNumber(1.0e300);
+		CHECK_EQUAL((int)SCMP::VarValue::kNumber, (int)value.kind);
+
+		const double zero = 0.0;
+		value.setNumber(zero / zero);
+		CHECK_EQUAL((int)SCMP::VarValue::kNumber, (int)value.kind);
+		CHECK_EQUAL(sizeof(double), value.getDataLen());
+	}
+
+	TEST(VarValue_Boolean)
+	{
+		SCMP::VarValue value;
+
+		value.setBoolean(true);
+		CHECK_EQUAL((int)SCMP::VarValue::kBoolean, (int)value.kind);
+		CHECK(value.integer == 1);
+
+		value.setBoolean(false);
+		CHECK(value.integer == 0);
+	}
+
+	TEST(VarValue_String)
+	{
+		SCMP::VarValue value;
+
+		value.setString("hello", 5);
+		CHECK_EQUAL((int)SCMP::VarValue::kString, (int)value.kind);
+		CHECK_EQUAL("hello", value.text);
+		CHECK_EQUAL((uint32_t)5, value.length);
+		CHECK_EQUAL(0, (int)value.truncated);
+		CHECK_EQUAL((std::size_t)5, value.getDataLen());
+	}
+
+	TEST(VarValue_StringTruncated)
+	{
+		char szLong[SCMP::Sizes::kVarValueLen * 2];
+		std::memset(szLong, 'x', sizeof(szLong));
+
+		SCMP::VarValue value;
+		value.setString(szLong, sizeof(szLong));
+		CHECK_EQUAL((uint32_t)sizeof(szLong), value.length);
+		CHECK_EQUAL(1, (int)value.truncated);
+		CHECK_EQUAL((std::size_t)(SCMP::Sizes::kVarValueLen - 1), std::strlen(value.text));
+
+		// Embedded zero ends the slice
+		value.setString("ab\0cd", 5);
+		CHECK_EQUAL("ab", value.text);
+		CHECK_EQUAL((uint32_t)5, value.length);
+		CHECK_EQUAL(1, (int)value.truncated);
+	}
+
+	TEST(VarValue_SetTextResetsKind)
+	{
+		SCMP::VarValue value;
+		value.setString("abc", 3);
+		value.setText("<table>");
+		CHECK_EQUAL((int)SCMP::VarValue::kText, (int)value.kind);
+		CHECK_EQUAL("<table>", value.text);
+		CHECK_EQUAL(0, (int)value.truncated);
+	}
+}}}
@@ -104,6 +104,11 @@ lua_State* LuaInterface::NewThread(lua_State* luaState)
 	return ::lua_newthread(luaState);
 }
 
+int LuaInterface::GcStep(lua_State* luaState, int stepSize)
+{
+	return ::lua_gc(luaState, LUA_GCSTEP, stepSize);
+}
+
 void LuaInterface::NewTable(lua_State* luaState)
 {
 	::lua_newtable(luaState);
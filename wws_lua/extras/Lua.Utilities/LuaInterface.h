@@ -38,6 +38,7 @@ namespace LuaInterface
 	void Pop(lua_State* luaState, int count);
 
 	lua_State* NewThread(lua_State* luaState);
+	int GcStep(lua_State* luaState, int stepSize);
 	void NewTable(lua_State* luaState);
 	void SetTable(lua_State* luaState, int index);
 	void GetField(lua_State* luaState, int index, const char* key);
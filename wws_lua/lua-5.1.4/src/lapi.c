@@ -22,6 +22,7 @@
 #include "lgc.h"
 #include "lmem.h"
 #include "lobject.h"
+#include "lopcodes.h"
 #include "lstate.h"
 #include "lstring.h"
 #include "ltable.h"
@@ -681,6 +682,7 @@ LUA_API void lua_rawset (lua_State *L, int idx) {
   t = index2adr(L, idx);
   api_check(L, ttistable(t));
   setobj2t(L, luaH_set(L, hvalue(t), L->top-2), L->top-1);
+  luaH_touch(hvalue(t));
   luaC_barriert(L, hvalue(t), L->top-1);
   L->top -= 2;
   lua_unlock(L);
@@ -694,6 +696,7 @@ LUA_API void lua_rawseti (lua_State *L, int idx, int n) {
   o = index2adr(L, idx);
   api_check(L, ttistable(o));
   setobj2t(L, luaH_setnum(L, hvalue(o), n), L->top-1);
+  luaH_touch(hvalue(o));
   luaC_barriert(L, hvalue(o), L->top-1);
   L->top--;
   lua_unlock(L);
@@ -1059,6 +1062,274 @@ LUA_API int lua_dumpEx(lua_State *L, lua_Writer writer, void *data, int strip, L
 	return status;
 }
 
+LUA_API void lua_setgchook(lua_State *L, lua_GCHook hook, void *ud) {
+	lua_lock(L);
+	G(L)->gchook = hook;
+	G(L)->gchookud = ud;
+	lua_unlock(L);
+}
+
+LUA_API lua_GCHook lua_getgchook(lua_State *L, void **ud) {
+	lua_GCHook hook;
+	lua_lock(L);
+	hook = G(L)->gchook;
+	if (ud != NULL)
+		*ud = G(L)->gchookud;
+	lua_unlock(L);
+	return hook;
+}
+
+LUA_API void lua_setlinemask(lua_State *L, lua_LineMask fn, void *ud) {
+	global_State *g;
+	lua_lock(L);
+	g = G(L);
+	g->linemask = fn;
+	g->linemaskud = ud;
+	/* prototypes start at 0 so skip it to make them all rebuild */
+	if (++g->linemaskgen == 0)
+		g->linemaskgen = 1;
+	lua_unlock(L);
+}
+
+LUA_API void lua_setprofilefilter(lua_State *L, lua_ProfileFilter fn, void *ud) {
+	global_State *g;
+	lua_lock(L);
+	g = G(L);
+	g->profilefilter = fn;
+	g->profilefilterud = ud;
+	/* C functions have no prototype so share one verdict */
+	g->profilefilterc = cast_byte(fn == NULL || (*fn)("=[C]", -1, ud) != 0);
+	/* prototypes start at 0 so skip it to make them all ask again */
+	if (++g->profilefiltergen == 0)
+		g->profilefiltergen = 1;
+	lua_unlock(L);
+}
+
+LUA_API void lua_rejectprofilecall(lua_State *L) {
+	lua_lock(L);
+	L->ci->profiled = 0;
+	lua_unlock(L);
+}
+
+LUA_API void lua_setcoverage(lua_State *L, int on) {
+	lua_lock(L);
+	if (on) {
+		L->hookmask = cast_byte(L->hookmask | LUAI_MASKCOVER);
+	}
+	else
+		L->hookmask = cast_byte(L->hookmask & ~LUAI_MASKCOVER);
+	lua_unlock(L);
+}
+
+LUA_API int lua_getcoverage(lua_State *L) {
+	return (L->hookmask & LUAI_MASKCOVER) != 0;
+}
+
+LUA_API void lua_visitcoverage(lua_State *L, lua_CoverageVisitor fn, void *ud) {
+	GCObject *o;
+	lua_Coverage cov;
+	lua_lock(L);
+	for (o = G(L)->rootgc; o != NULL; o = o->gch.next) {
+		Proto *p;
+		/* Sony: a prototype that is dead but not swept yet may already
+		   have lost its source string (strings are swept first) */
+		if (o->gch.tt != LUA_TPROTO || isdead(G(L), o))
+			continue;
+		p = gco2p(o);
+		if (p->sizelineinfo == 0)
+			continue;
+		cov.source = p->source ? getstr(p->source) : "=?";
+		cov.linedefined = p->linedefined;
+		cov.firstline = p->linecountfirst;
+		cov.nlines = p->sizelinecounts;
+		cov.counts = p->linecounts;
+		cov.lineinfo = p->lineinfo;
+		cov.sizelineinfo = p->sizelineinfo;
+		(*fn)(&cov, ud);
+	}
+	lua_unlock(L);
+}
+
+LUA_API void lua_resetcoverage(lua_State *L) {
+	GCObject *o;
+	lua_lock(L);
+	for (o = G(L)->rootgc; o != NULL; o = o->gch.next) {
+		Proto *p;
+		/* Sony: dead but not swept yet (see lua_visitcoverage) */
+		if (o->gch.tt != LUA_TPROTO || isdead(G(L), o))
+			continue;
+		p = gco2p(o);
+		if (p->linecounts != NULL)
+			memset(p->linecounts, 0, p->sizelinecounts * sizeof(unsigned int));
+	}
+	lua_unlock(L);
+}
+
+LUA_API void lua_setopcodeprofile(lua_State *L, int on) {
+	lua_lock(L);
+	if (on)
+		L->hookmask = cast_byte(L->hookmask | LUAI_MASKOPCODES);
+	else
+		L->hookmask = cast_byte(L->hookmask & ~LUAI_MASKOPCODES);
+	lua_unlock(L);
+}
+
+LUA_API int lua_getopcodeprofile(lua_State *L) {
+	return (L->hookmask & LUAI_MASKOPCODES) != 0;
+}
+
+LUA_API int lua_numopcodes(void) {
+	return NUM_OPCODES;
+}
+
+LUA_API const char *lua_opcodename(int op) {
+	return (op >= 0 && op < NUM_OPCODES) ? luaP_opnames[op] : NULL;
+}
+
+LUA_API const size_t *lua_opcodetotals(lua_State *L) {
+	return G(L)->opcounts;
+}
+
+LUA_API void lua_visitopcodes(lua_State *L, lua_OpcodeVisitor fn, void *ud) {
+	GCObject *o;
+	lua_lock(L);
+	for (o = G(L)->rootgc; o != NULL; o = o->gch.next) {
+		Proto *p;
+		/* Sony: dead but not swept yet (see lua_visitcoverage) */
+		if (o->gch.tt != LUA_TPROTO || isdead(G(L), o))
+			continue;
+		p = gco2p(o);
+		if (p->opcounts != NULL)
+			(*fn)(p->source ? getstr(p->source) : "=?", p->linedefined, p->opcounts, ud);
+	}
+	lua_unlock(L);
+}
+
+LUA_API void lua_resetopcodeprofile(lua_State *L) {
+	GCObject *o;
+	lua_lock(L);
+	if (G(L)->opcounts != NULL)
+		memset(G(L)->opcounts, 0, NUM_OPCODES * sizeof(size_t));
+	for (o = G(L)->rootgc; o != NULL; o = o->gch.next) {
+		Proto *p;
+		/* Sony: dead but not swept yet (see lua_visitcoverage) */
+		if (o->gch.tt != LUA_TPROTO || isdead(G(L), o))
+			continue;
+		p = gco2p(o);
+		if (p->opcounts != NULL)
+			memset(p->opcounts, 0, NUM_OPCODES * sizeof(size_t));
+	}
+	lua_unlock(L);
+}
+
+LUA_API lua_State *lua_mainthread(lua_State *L) {
+	return G(L)->mainthread;
+}
+
+LUA_API unsigned int lua_tableversion(lua_State *L, int idx) {
+	StkId o;
+	unsigned int version;
+	lua_lock(L);
+	o = index2adr(L, idx);
+	version = ttistable(o) ? (unsigned int)hvalue(o)->version : 0;
+	lua_unlock(L);
+	return version;
+}
+
+static void walktable_item(lua_TableItem *item, const TValue *o) {
+	item->type = ttype(o);
+	item->len = 0;
+	item->v.p = NULL;
+	switch (item->type) {
+		case LUA_TNIL: break;
+		case LUA_TNUMBER: item->v.n = nvalue(o); break;
+		case LUA_TBOOLEAN: item->v.b = bvalue(o); break;
+		case LUA_TSTRING:
+			item->v.s = svalue(o);
+			item->len = tsvalue(o)->len;
+			break;
+		case LUA_TTABLE: item->v.p = hvalue(o); break;
+		case LUA_TFUNCTION: item->v.p = clvalue(o); break;
+		case LUA_TTHREAD: item->v.p = thvalue(o); break;
+		case LUA_TUSERDATA: item->v.p = rawuvalue(o) + 1; break;
+		case LUA_TLIGHTUSERDATA: item->v.p = pvalue(o); break;
+		default: break;
+	}
+}
+
+LUA_API int lua_walktable(lua_State *L, int idx, unsigned int *cursor, lua_TableEntry *entries, int max) {
+	StkId o;
+	Table *t;
+	unsigned int i, sizearray, total;
+	int n = 0;
+	lua_lock(L);
+	o = index2adr(L, idx);
+	if (!ttistable(o)) {
+		lua_unlock(L);
+		return 0;
+	}
+	t = hvalue(o);
+	sizearray = (unsigned int)t->sizearray;
+	total = sizearray + (unsigned int)sizenode(t);
+	for (i = *cursor; (i < total) && (n < max); i++) {
+		lua_TableEntry *entry = &entries[n];
+		if (i < sizearray) {
+			if (ttisnil(&t->array[i]))
+				continue;
+			entry->key.type = LUA_TNUMBER;
+			entry->key.len = 0;
+			entry->key.v.n = cast_num(i + 1);
+			walktable_item(&entry->value, &t->array[i]);
+		}
+		else {
+			Node *node = gnode(t, i - sizearray);
+			if (ttisnil(gval(node)))
+				continue;
+			walktable_item(&entry->key, key2tval(node));
+			walktable_item(&entry->value, gval(node));
+		}
+		entry->slot = i;
+		n++;
+	}
+	*cursor = i;
+	lua_unlock(L);
+	return n;
+}
+
+LUA_API int lua_pushtableslot(lua_State *L, int idx, unsigned int slot) {
+	StkId o;
+	Table *t;
+	unsigned int sizearray;
+	int found = 0;
+	lua_lock(L);
+	o = index2adr(L, idx);
+	if (ttistable(o)) {
+		t = hvalue(o);
+		sizearray = (unsigned int)t->sizearray;
+		if (slot < sizearray) {
+			if (!ttisnil(&t->array[slot])) {
+				setnvalue(L->top, cast_num(slot + 1));
+				api_incr_top(L);
+				setobj2s(L, L->top, &t->array[slot]);
+				api_incr_top(L);
+				found = 1;
+			}
+		}
+		else if ((slot - sizearray) < (unsigned int)sizenode(t)) {
+			Node *node = gnode(t, slot - sizearray);
+			if (!ttisnil(gval(node))) {
+				setobj2s(L, L->top, key2tval(node));
+				api_incr_top(L);
+				setobj2s(L, L->top, gval(node));
+				api_incr_top(L);
+				found = 1;
+			}
+		}
+	}
+	lua_unlock(L);
+	return found;
+}
+
 static const char *aux_upvalue (StkId fi, int n, TValue **val) {
   Closure *f;
   if (!ttisfunction(fi)) return NULL;
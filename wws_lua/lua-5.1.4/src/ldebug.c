@@ -20,6 +20,7 @@
 #include "ldebug.h"
 #include "ldo.h"
 #include "lfunc.h"
+#include "lmem.h"
 #include "lobject.h"
 #include "lopcodes.h"
 #include "lstate.h"
@@ -61,7 +62,8 @@ LUA_API int lua_sethook (lua_State *L, lua_Hook func, int mask, int count) {
   L->hook = func;
   L->basehookcount = count;
   resethookcount(L);
-  L->hookmask = cast_byte(mask);
+  L->hookmask = cast_byte(mask |  /* Sony */
+                          (L->hookmask & (LUAI_MASKCOVER | LUAI_MASKOPCODES)));
   return 1;
 }
 
@@ -72,7 +74,8 @@ LUA_API lua_Hook lua_gethook (lua_State *L) {
 
 
 LUA_API int lua_gethookmask (lua_State *L) {
-  return L->hookmask;
+  /* Sony: coverage & the opcode profile are not hooks */
+  return L->hookmask & ~(LUAI_MASKCOVER | LUAI_MASKOPCODES);
 }
 
 
@@ -638,6 +641,113 @@ void luaG_runerror (lua_State *L, const char *fmt, ...) {
   va_end(argp);
   luaG_errormsg(L);
 }
+
+/*
+** Sony: line breakpoint masks; see lua_setlinemask
+*/
+
+static int linerange (const Proto *p, int *first) {
+  int last = -1, i;
+  *first = 0;
+  for (i = 0; i < p->sizelineinfo; i++) {  /* range of lines with code */
+    int line = p->lineinfo[i];
+    if (last < *first) *first = last = line;
+    else if (line < *first) *first = line;
+    else if (line > last) last = line;
+  }
+  return last - *first + 1;
+}
+
+
+static void buildlinemask (lua_State *L, Proto *p, lua_LineMask fn) {
+  global_State *g = G(L);
+  int first, nlines = linerange(p, &first);
+  int size = (nlines + 7) / 8;
+  if (size != p->sizelinemask) {
+    luaM_reallocvector(L, p->linemask, p->sizelinemask, size, lu_byte);
+    p->sizelinemask = size;
+  }
+  if (size > 0) {
+    memset(p->linemask, 0, size);
+    (*fn)(p->source ? getstr(p->source) : "=?", first, nlines,
+          p->linemask, g->linemaskud);
+  }
+  p->linemaskfirst = first;
+  p->linemaskgen = g->linemaskgen;
+}
+
+
+int luaG_checklinemask (lua_State *L, Proto *p, int line) {
+  lua_LineMask fn = G(L)->linemask;  /* read once; may be cleared meanwhile */
+  if (fn == NULL) return 1;
+  if (p->linemaskgen != G(L)->linemaskgen)
+    buildlinemask(L, p, fn);
+  line -= p->linemaskfirst;
+  if (line < 0 || line >= p->sizelinemask * 8) return 0;
+  return (p->linemask[line >> 3] >> (line & 7)) & 1;
+}
+
+
+/*
+** Sony: line coverage; see lua_setcoverage
+*/
+
+void luaG_countline (lua_State *L, Proto *p, int line) {
+  unsigned int *count;
+  if (p->linecounts == NULL) {  /* first line run with coverage on? */
+    int first, nlines = linerange(p, &first);
+    if (nlines <= 0) return;
+    p->linecounts = luaM_newvector(L, nlines, unsigned int);
+    memset(p->linecounts, 0, nlines * sizeof(unsigned int));
+    p->sizelinecounts = nlines;
+    p->linecountfirst = first;
+  }
+  line -= p->linecountfirst;
+  if (line < 0 || line >= p->sizelinecounts) return;
+  count = &p->linecounts[line];
+  if (*count + 1 != 0) (*count)++;  /* saturate */
+}
+
+
+/*
+** Sony: opcode profile; see lua_setopcodeprofile
+*/
+
+static size_t *newopcounts (lua_State *L) {
+  size_t *counts = luaM_newvector(L, NUM_OPCODES, size_t);
+  memset(counts, 0, NUM_OPCODES * sizeof(size_t));
+  return counts;
+}
+
+
+void luaG_countopcode (lua_State *L, Proto *p, int op) {
+  global_State *g = G(L);
+  if (g->opcounts == NULL) g->opcounts = newopcounts(L);
+  if (p->opcounts == NULL) p->opcounts = newopcounts(L);
+  if (g->opcounts[op] + 1 != 0) g->opcounts[op]++;  /* saturate */
+  if (p->opcounts[op] + 1 != 0) p->opcounts[op]++;
+}
+
+
+/*
+** Sony: profile filters; see lua_setprofilefilter
+*/
+
+int luaG_checkprofilefilter (lua_State *L, CallInfo *ci) {
+  global_State *g = G(L);
+  lua_ProfileFilter fn = g->profilefilter;  /* read once; may be cleared meanwhile */
+  Proto *p;
+  if (fn == NULL) return 1;
+  if (clvalue(ci->func)->c.isC) return g->profilefilterc;
+  p = clvalue(ci->func)->l.p;
+  if (p->profilefiltergen != g->profilefiltergen) {
+    p->profiled = cast_byte((*fn)(p->source ? getstr(p->source) : "=?",
+                                  p->linedefined, g->profilefilterud) != 0);
+    p->profilefiltergen = g->profilefiltergen;
+  }
+  return p->profiled;
+}
+
 #ifdef _MANAGED
 	#pragma managed(pop)
 #endif
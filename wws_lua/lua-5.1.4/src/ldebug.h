@@ -29,5 +29,17 @@ LUAI_FUNC void luaG_runerror (lua_State *L, const char *fmt, ...);
 LUAI_FUNC void luaG_errormsg (lua_State *L);
 LUAI_FUNC int luaG_checkcode (const Proto *pt);
 LUAI_FUNC int luaG_checkopenop (Instruction i);
+LUAI_FUNC int luaG_checklinemask (lua_State *L, Proto *p, int line);
+LUAI_FUNC void luaG_countline (lua_State *L, Proto *p, int line);
+LUAI_FUNC void luaG_countopcode (lua_State *L, Proto *p, int op);
+LUAI_FUNC int luaG_checkprofilefilter (lua_State *L, CallInfo *ci);
+
+/* Sony: whether the line hook should run for `line' of `p' */
+#define luaG_linehooked(L,p,line) \
+	(G(L)->linemask == NULL || luaG_checklinemask(L, p, line))
+
+/* Sony: whether call & return hooks should run for the function of `ci' */
+#define luaG_profilehooked(L,ci) \
+	(G(L)->profilefilter == NULL || luaG_checkprofilefilter(L, ci))
 
 #endif
@@ -184,6 +184,15 @@ void luaD_callhook (lua_State *L, int event, int line) {
     ptrdiff_t top = savestack(L, L->top);
     ptrdiff_t ci_top = savestack(L, L->ci->top);
     lua_Debug ar;
+    /* Sony: profile filters; each call or return uses the verdict taken
+       when its frame was entered, so they stay paired */
+    if (event == LUA_HOOKCALL || event == LUA_HOOKRET) {
+      if (!L->ci->profiled) return;
+    }
+    else if (event == LUA_HOOKTAILRET) {
+      if (L->ci->profiledtails == 0) return;
+      L->ci->profiledtails--;
+    }
     ar.event = event;
     ar.currentline = line;
     if (event == LUA_HOOKTAILRET)
@@ -292,6 +301,8 @@ int luaD_precall (lua_State *L, StkId func, int nresults) {
     lua_assert(ci->top <= L->stack_last);
     L->savedpc = p->code;  /* starting point */
     ci->tailcalls = 0;
+    ci->profiledtails = 0;  /* Sony */
+    ci->profiled = cast_byte(luaG_profilehooked(L, ci));  /* Sony */
     ci->nresults = nresults;
     for (st = L->top; st < ci->top; st++)
       setnilvalue(st);
@@ -313,6 +324,7 @@ int luaD_precall (lua_State *L, StkId func, int nresults) {
     ci->top = L->top + LUA_MINSTACK;
     lua_assert(ci->top <= L->stack_last);
     ci->nresults = nresults;
+    ci->profiled = cast_byte(luaG_profilehooked(L, ci));  /* Sony */
     if (L->hookmask & LUA_MASKCALL)
       luaD_callhook(L, LUA_HOOKCALL, -1);
     lua_unlock(L);
@@ -16,6 +16,7 @@
 #include "lgc.h"
 #include "lmem.h"
 #include "lobject.h"
+#include "lopcodes.h"
 #include "lstate.h"
 
 
@@ -134,6 +135,16 @@ Proto *luaF_newproto (lua_State *L) {
   f->linedefined = 0;
   f->lastlinedefined = 0;
   f->source = NULL;
+  f->linemask = NULL;
+  f->sizelinemask = 0;
+  f->linemaskfirst = 0;
+  f->linemaskgen = 0;
+  f->linecounts = NULL;
+  f->sizelinecounts = 0;
+  f->linecountfirst = 0;
+  f->opcounts = NULL;
+  f->profilefiltergen = 0;
+  f->profiled = 1;
   return f;
 }
 
@@ -145,6 +156,9 @@ void luaF_freeproto (lua_State *L, Proto *f) {
   luaM_freearray(L, f->lineinfo, f->sizelineinfo, int);
   luaM_freearray(L, f->locvars, f->sizelocvars, struct LocVar);
   luaM_freearray(L, f->upvalues, f->sizeupvalues, TString *);
+  luaM_freearray(L, f->linemask, f->sizelinemask, lu_byte);
+  luaM_freearray(L, f->linecounts, f->sizelinecounts, unsigned int);
+  luaM_freearray(L, f->opcounts, (f->opcounts ? NUM_OPCODES : 0), size_t);
   luaM_free(L, f);
 }
 
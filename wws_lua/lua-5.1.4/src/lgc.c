@@ -347,6 +347,8 @@ static int iscleared (const TValue *o, int iskey) {
 
 /*
 ** clear collected entries from weaktables
+** Sony: each cleared entry is a store into the table, so it bumps the
+** table version like any other store (see lua_tableversion)
 */
 static void cleartable (GCObject *l) {
   while (l) {
@@ -357,8 +359,10 @@ static void cleartable (GCObject *l) {
     if (testbit(h->marked, VALUEWEAKBIT)) {
       while (i--) {
         TValue *o = &h->array[i];
-        if (iscleared(o, 0))  /* value was collected? */
+        if (iscleared(o, 0)) {  /* value was collected? */
           setnilvalue(o);  /* remove value */
+          luaH_touch(h);
+        }
       }
     }
     i = sizenode(h);
@@ -368,6 +372,7 @@ static void cleartable (GCObject *l) {
           (iscleared(key2tval(n), 1) || iscleared(gval(n), 0))) {
         setnilvalue(gval(n));  /* remove value ... */
         removeentry(n);  /* remove entry from table */
+        luaH_touch(h);
       }
     }
     l = h->gclist;
@@ -576,7 +581,17 @@ static void atomic (lua_State *L) {
 }
 
 
-static l_mem singlestep (lua_State *L) {
+/*
+** Sony: report collector activity to the GC hook, if any
+*/
+static void gcevent (lua_State *L, int event, lu_mem arg) {
+  global_State *g = G(L);
+  if (g->gchook != NULL)
+    g->gchook(L, event, cast(size_t, arg), g->gchookud);
+}
+
+
+static l_mem rawsinglestep (lua_State *L) {
   global_State *g = G(L);
   /*lua_checkmemory(L);*/
   switch (g->gcstate) {
@@ -588,7 +603,9 @@ static l_mem singlestep (lua_State *L) {
       if (g->gray)
         return propagatemark(g);
       else {  /* no more `gray' objects */
+        gcevent(L, LUA_GCEVATOMICBEGIN, 0);
         atomic(L);  /* finish mark phase */
+        gcevent(L, LUA_GCEVATOMICEND, 0);
         return 0;
       }
     }
@@ -630,9 +647,30 @@ static l_mem singlestep (lua_State *L) {
 }
 
 
+/*
+** Sony: one collector step, reporting swept memory and the end of a
+** cycle to the GC hook
+*/
+static l_mem singlestep (lua_State *L) {
+  global_State *g = G(L);
+  lu_byte oldstate = g->gcstate;
+  lu_mem oldbytes = g->totalbytes;
+  l_mem work = rawsinglestep(L);
+  if (g->gchook != NULL) {
+    if ((oldstate == GCSsweepstring || oldstate == GCSsweep) &&
+        oldbytes > g->totalbytes)
+      gcevent(L, LUA_GCEVSWEEP, oldbytes - g->totalbytes);
+    if (oldstate != GCSpause && g->gcstate == GCSpause)
+      gcevent(L, LUA_GCEVCYCLEEND, g->totalbytes);
+  }
+  return work;
+}
+
+
 void luaC_step (lua_State *L) {
   global_State *g = G(L);
   l_mem lim = (GCSTEPSIZE/100) * g->gcstepmul;
+  gcevent(L, LUA_GCEVSTEPBEGIN, g->totalbytes);
   if (lim == 0)
     lim = (MAX_LUMEM-1)/2;  /* no limit */
   g->gcdept += g->totalbytes - g->GCthreshold;
@@ -653,11 +691,13 @@ void luaC_step (lua_State *L) {
     lua_assert(g->totalbytes >= g->estimate);
     setthreshold(g);
   }
+  gcevent(L, LUA_GCEVSTEPEND, g->totalbytes);
 }
 
 
 void luaC_fullgc (lua_State *L) {
   global_State *g = G(L);
+  gcevent(L, LUA_GCEVSTEPBEGIN, g->totalbytes);
   if (g->gcstate <= GCSpropagate) {
     /* reset sweep marks to sweep all elements (returning them to white) */
     g->sweepstrgc = 0;
@@ -679,6 +719,7 @@ void luaC_fullgc (lua_State *L) {
     singlestep(L);
   }
   setthreshold(g);
+  gcevent(L, LUA_GCEVSTEPEND, g->totalbytes);
 }
 
 
@@ -245,6 +245,16 @@ typedef struct Proto {
   int sizelocvars;
   int linedefined;
   int lastlinedefined;
+  lu_byte *linemask;  /* Sony: line breakpoint bits; see lua_setlinemask */
+  int sizelinemask;  /* size of `linemask' in bytes */
+  int linemaskfirst;  /* line of bit 0 of `linemask' */
+  unsigned int linemaskgen;  /* lua_setlinemask generation of `linemask' */
+  unsigned int *linecounts;  /* Sony: line coverage counters; see lua_setcoverage */
+  int sizelinecounts;
+  int linecountfirst;  /* line of linecounts[0] */
+  size_t *opcounts;  /* Sony: opcode profile counters; see lua_setopcodeprofile */
+  unsigned int profilefiltergen;  /* Sony: lua_setprofilefilter generation of `profiled' */
+  lu_byte profiled;  /* profile filter verdict; call & return hooks run if set */
   GCObject *gclist;
   lu_byte nups;  /* number of upvalues */
   lu_byte numparams;
@@ -345,6 +355,7 @@ typedef struct Table {
   Node *lastfree;  /* any free position is before this position */
   GCObject *gclist;
   int sizearray;  /* size of `array' array */
+  lu_int32 version;  /* Sony: bumped on every store; see lua_tableversion */
 } Table;
 
 
@@ -18,6 +18,7 @@
 #include "lgc.h"
 #include "llex.h"
 #include "lmem.h"
+#include "lopcodes.h"
 #include "lstate.h"
 #include "lstring.h"
 #include "ltable.h"
@@ -109,6 +110,7 @@ static void close_state (lua_State *L) {
   lua_assert(g->rootgc == obj2gco(L));
   lua_assert(g->strt.nuse == 0);
   luaM_freearray(L, G(L)->strt.hash, G(L)->strt.size, TString *);
+  luaM_freearray(L, g->opcounts, (g->opcounts ? NUM_OPCODES : 0), size_t);
   luaZ_freebuffer(L, &g->buff);
   freestack(L, L);
   lua_assert(g->totalbytes == sizeof(LG));
@@ -177,6 +179,16 @@ LUA_API lua_State *lua_newstate (lua_Alloc f, void *ud) {
   g->totalbytes = sizeof(LG);
   g->gcpause = LUAI_GCPAUSE;
   g->gcstepmul = LUAI_GCMUL;
+  g->gchook = NULL;
+  g->gchookud = NULL;
+  g->linemask = NULL;
+  g->linemaskud = NULL;
+  g->linemaskgen = 0;
+  g->opcounts = NULL;
+  g->profilefilter = NULL;
+  g->profilefilterud = NULL;
+  g->profilefiltergen = 0;
+  g->profilefilterc = 1;
   g->gcdept = 0;
   for (i=0; i<NUM_TAGS; i++) g->mt[i] = NULL;
   if (luaD_rawrunprotected(L, f_luaopen, NULL) != 0) {
@@ -52,6 +52,8 @@ typedef struct CallInfo {
   const Instruction *savedpc;
   int nresults;  /* expected number of results from this function */
   int tailcalls;  /* number of tail calls lost under this entry */
+  int profiledtails;  /* Sony: lost tail calls whose entry was profiled */
+  lu_byte profiled;  /* Sony: profile filter verdict taken on entry */
 } CallInfo;
 
 
@@ -62,6 +64,12 @@ typedef struct CallInfo {
 #define isLua(ci)	(ttisfunction((ci)->func) && f_isLua(ci))
 
 
+/* Sony: line coverage & opcode profile bits in `hookmask', beside the
+   LUA_MASK* hook bits */
+#define LUAI_MASKCOVER	(1 << 6)
+#define LUAI_MASKOPCODES	(1 << 5)
+
+
 /*
 ** `global state', shared by all threads of this state
 */
@@ -91,6 +99,16 @@ typedef struct global_State {
   UpVal uvhead;  /* head of double-linked list of all open upvalues */
   struct Table *mt[NUM_TAGS];  /* metatables for basic types */
   TString *tmname[TM_N];  /* array with tag-method names */
+  lua_GCHook gchook;  /* Sony: GC instrumentation hook */
+  void *gchookud;  /* auxiliary data to `gchook' */
+  lua_LineMask linemask;  /* Sony: line breakpoint mask function */
+  void *linemaskud;  /* auxiliary data to `linemask' */
+  unsigned int linemaskgen;  /* bumped by lua_setlinemask */
+  size_t *opcounts;  /* Sony: opcode profile totals; see lua_setopcodeprofile */
+  lua_ProfileFilter profilefilter;  /* Sony: profile filter function */
+  void *profilefilterud;  /* auxiliary data to `profilefilter' */
+  unsigned int profilefiltergen;  /* bumped by lua_setprofilefilter */
+  lu_byte profilefilterc;  /* profile filter verdict for C functions */
 } global_State;
 
 
@@ -113,7 +131,7 @@ struct lua_State {
   int size_ci;  /* size of array `base_ci' */
   unsigned short nCcalls;  /* number of nested C calls */
   unsigned short baseCcalls;  /* nested C calls when resuming coroutine */
-  lu_byte hookmask;
+  lu_byte hookmask;  /* Sony: may also hold LUAI_MASKCOVER & LUAI_MASKOPCODES */
   lu_byte allowhook;
   int basehookcount;
   int hookcount;
@@ -15,6 +15,9 @@
 #define gval(n)		(&(n)->i_val)
 #define gnext(n)	((n)->i_key.nk.next)
 
+/* Sony: record a store into `t' (see lua_tableversion) */
+#define luaH_touch(t)	((t)->version++)
+
 #define key2tval(n)	(&(n)->i_key.tvk)
 
 
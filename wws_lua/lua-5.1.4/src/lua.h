@@ -313,6 +313,155 @@ typedef struct LuaDumpConfig
 
 LUA_API int lua_dumpEx(lua_State *L, lua_Writer writer, void *data, int strip, LuaDumpConfig *config);
 
+/* GC instrumentation; one hook is shared by all threads of a state. The hook
+   runs inside the collector, possibly in the middle of an allocation, so it
+   must not call back into Lua. Step events can nest when a full collection
+   is run from inside a step. */
+#define LUA_GCEVSTEPBEGIN	0	/* step or full collection starting; arg = bytes in use */
+#define LUA_GCEVSTEPEND		1	/* step or full collection finished; arg = bytes in use */
+#define LUA_GCEVATOMICBEGIN	2	/* atomic phase starting */
+#define LUA_GCEVATOMICEND	3	/* atomic phase finished */
+#define LUA_GCEVSWEEP		4	/* sweep step finished; arg = bytes freed */
+#define LUA_GCEVCYCLEEND	5	/* collection cycle finished; arg = bytes in use */
+
+typedef void (*lua_GCHook) (lua_State *L, int event, size_t arg, void *ud);
+
+LUA_API void lua_setgchook(lua_State *L, lua_GCHook hook, void *ud);
+LUA_API lua_GCHook lua_getgchook(lua_State *L, void **ud);
+
+/* Line breakpoint masks. With a mask function set, the line hook only runs on
+   lines whose bit is set in the running function's mask; with none (the
+   default) it runs on every line as usual. A function prototype builds its
+   mask the first time it runs a line after lua_setlinemask: the VM calls `fn'
+   with the prototype's source, first line, line count and a zeroed mask of
+   (nlines + 7) / 8 bytes, and `fn' sets bit (line - firstline) for each line
+   that must reach the hook. `fn' runs inside the VM and must not use the Lua
+   state. One mask function is shared by all threads of a state; every call to
+   lua_setlinemask, even with the same function, discards the masks built so
+   far. */
+typedef void (*lua_LineMask) (const char *source, int firstline, int nlines, unsigned char *mask, void *ud);
+
+LUA_API void lua_setlinemask(lua_State *L, lua_LineMask fn, void *ud);
+
+/* Profile filters. With a filter function set, call and return hooks only
+   run for functions the filter accepts; line and count hooks are not
+   filtered. The verdict is taken as a function is entered and kept until it
+   returns, so its call hook, its return hook and, for a call lost to a tail
+   call, its tail return hook always agree. Each function prototype asks `fn' once after
+   lua_setprofilefilter, with its source and the line it is defined on, and
+   keeps the verdict (nonzero to hook the function); C functions share one
+   verdict, asked for with source "=[C]" and line -1 when the filter is set.
+   `fn' runs inside the VM and must not use the Lua state. One filter
+   function is shared by all threads of a state; every call to
+   lua_setprofilefilter, even with the same function, discards the verdicts
+   kept so far. */
+typedef int (*lua_ProfileFilter) (const char *source, int linedefined, void *ud);
+
+LUA_API void lua_setprofilefilter(lua_State *L, lua_ProfileFilter fn, void *ud);
+
+/* Called from a call hook: rejects the function being entered as the
+   profile filter would, so the hooks for its return are skipped too. Works
+   with or without a filter function set. */
+LUA_API void lua_rejectprofilecall(lua_State *L);
+
+/* Line coverage. While on for a thread (threads it creates afterwards inherit
+   it, and lua_sethook leaves it alone) the VM counts, per function prototype,
+   every time a Lua function starts running a line; these are the points the
+   line hook runs at, but no hook is called. Counters stop at UINT_MAX. They
+   belong to the prototype, so a collected chunk takes its counts with it. */
+LUA_API void lua_setcoverage(lua_State *L, int on);
+LUA_API int lua_getcoverage(lua_State *L);
+
+/* One function prototype as seen by lua_visitcoverage. `counts[i]' is the
+   count for line `firstline + i'; `counts' is NULL when the function has not
+   run a line with coverage on. The lines that hold code are the values of
+   `lineinfo'. */
+typedef struct lua_Coverage {
+	const char *source;
+	int linedefined;
+	int firstline;
+	int nlines;
+	const unsigned int *counts;
+	const int *lineinfo;
+	int sizelineinfo;
+} lua_Coverage;
+
+typedef void (*lua_CoverageVisitor) (const lua_Coverage *cov, void *ud);
+
+/* Calls `fn' for every live function prototype of the state that has line
+   information. `fn' must not use the Lua state. */
+LUA_API void lua_visitcoverage(lua_State *L, lua_CoverageVisitor fn, void *ud);
+
+/* Zeroes every coverage counter of the state. */
+LUA_API void lua_resetcoverage(lua_State *L);
+
+/* Opcode profile. While on for a thread (inherited and kept the same way as
+   coverage) the VM counts every instruction it runs by opcode, per function
+   prototype and for the whole state. Counters stop at their maximum. */
+LUA_API void lua_setopcodeprofile(lua_State *L, int on);
+LUA_API int lua_getopcodeprofile(lua_State *L);
+
+/* Number of opcodes & the name of one, or NULL if `op' is out of range */
+LUA_API int lua_numopcodes(void);
+LUA_API const char *lua_opcodename(int op);
+
+/* Counts for the whole state, indexed by opcode, or NULL if nothing has been
+   counted. Unlike the per prototype counts they outlive collected chunks. */
+LUA_API const size_t *lua_opcodetotals(lua_State *L);
+
+/* Called for every live function prototype that has run an instruction
+   with the opcode profile on; `counts' is indexed by opcode. `fn' must not
+   use the Lua state. */
+typedef void (*lua_OpcodeVisitor) (const char *source, int linedefined,
+                                   const size_t *counts, void *ud);
+LUA_API void lua_visitopcodes(lua_State *L, lua_OpcodeVisitor fn, void *ud);
+
+/* Zeroes every opcode counter of the state. */
+LUA_API void lua_resetopcodeprofile(lua_State *L);
+
+/* Main thread of the state `L' belongs to (`L' itself unless it is a
+   coroutine). */
+LUA_API lua_State *lua_mainthread(lua_State *L);
+
+/* Store counter of the table at `idx' (0 if it is not a table). Every raw or
+   non-metamethod store bumps it, including stores of the same value, so an
+   unchanged counter means the table's own contents are unchanged; tables it
+   refers to have counters of their own. Wraps around after 2^32 stores. */
+LUA_API unsigned int lua_tableversion(lua_State *L, int idx);
+
+/* Debugger enumeration of a table without touching the stack. Fills up to
+   `max' entries with the non-nil slots of the table at `idx', starting at
+   `*cursor' (0 to begin) and advancing it; returns the number filled, 0 once
+   the walk is done or if `idx' is not a table. Slots run over the array part
+   and then the hash part, in lua_next order. Nil, boolean, number and string
+   items carry their value; strings point into the VM and stay valid only
+   while the table is unchanged and nothing runs a collection. Other types
+   carry only `p' (as lua_topointer would); use lua_pushtableslot to get them
+   onto the stack. No metamethods are called. */
+typedef struct lua_TableItem {
+	int type;
+	size_t len;
+	union {
+		lua_Number n;
+		int b;
+		const char *s;
+		const void *p;
+	} v;
+} lua_TableItem;
+
+typedef struct lua_TableEntry {
+	unsigned int slot;
+	lua_TableItem key;
+	lua_TableItem value;
+} lua_TableEntry;
+
+LUA_API int lua_walktable(lua_State *L, int idx, unsigned int *cursor, lua_TableEntry *entries, int max);
+
+/* Pushes the key and value stored in `slot' (from lua_walktable) of the table
+   at `idx' and returns 1; pushes nothing and returns 0 if the slot is out of
+   range or now holds nil. */
+LUA_API int lua_pushtableslot(lua_State *L, int idx, unsigned int slot);
+
 
 /*
 ** {======================================================================
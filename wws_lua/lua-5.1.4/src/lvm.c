@@ -155,15 +155,24 @@ static void traceexec (lua_State *L, const Instruction *pc) {
     resethookcount(L);
     luaD_callhook(L, LUA_HOOKCOUNT, -1);
   }
-  if (mask & LUA_MASKLINE) {
+  if (mask & (LUA_MASKLINE | LUAI_MASKCOVER)) {
     Proto *p = ci_func(L->ci)->l.p;
     int npc = pcRel(pc, p);
     int newline = getline(p, npc);
     /* call linehook when enter a new function, when jump back (loop),
        or when enter a new line */
-    if (npc == 0 || pc <= oldpc || newline != getline(p, pcRel(oldpc, p)))
-      luaD_callhook(L, LUA_HOOKLINE, newline);
+    if (npc == 0 || pc <= oldpc || newline != getline(p, pcRel(oldpc, p))) {
+      if (mask & LUAI_MASKCOVER)  /* Sony: line coverage */
+        luaG_countline(L, p, newline);
+      if ((mask & LUA_MASKLINE) &&
+          luaG_linehooked(L, p, newline))  /* Sony: line breakpoint masks */
+        luaD_callhook(L, LUA_HOOKLINE, newline);
+    }
   }
+  /* Sony: opcode profile; not when a hook yielded, as the instruction will
+     run again on resume */
+  if ((mask & LUAI_MASKOPCODES) && L->status != LUA_YIELD)
+    luaG_countopcode(L, ci_func(L->ci)->l.p, GET_OPCODE(*(pc - 1)));
 }
 
 
@@ -233,6 +242,7 @@ void luaV_settable (lua_State *L, const TValue *t, TValue *key, StkId val) {
           (tm = fasttm(L, h->metatable, TM_NEWINDEX)) == NULL) { /* or no TM? */
         setobj2t(L, oldval, val);
 		h->flags = 0;
+        luaH_touch(h);
         luaC_barriert(L, h, val);
         return;
       }
@@ -479,8 +489,8 @@ void luaV_execute (lua_State *L, int nexeccalls) {
   for (;;) {
     const Instruction i = *pc++;
     StkId ra;
-    if ((L->hookmask & (LUA_MASKLINE | LUA_MASKCOUNT)) &&
-        (--L->hookcount == 0 || L->hookmask & LUA_MASKLINE)) {
+    if ((L->hookmask & (LUA_MASKLINE | LUA_MASKCOUNT | LUAI_MASKCOVER | LUAI_MASKOPCODES)) &&
+        (--L->hookcount == 0 || L->hookmask & (LUA_MASKLINE | LUAI_MASKCOVER | LUAI_MASKOPCODES))) {
       traceexec(L, pc);
       if (L->status == LUA_YIELD) {  /* did hook yield? */
         L->savedpc = pc - 1;
@@ -714,6 +724,10 @@ void luaV_execute (lua_State *L, int nexeccalls) {
             lua_assert(L->top == L->base + clvalue(func)->l.p->maxstacksize);
             ci->savedpc = L->savedpc;
             ci->tailcalls++;  /* one more call lost */
+            /* Sony: the lost entry returns through a tail return hook;
+               the frame's own return now belongs to the called function */
+            ci->profiledtails += ci->profiled;
+            ci->profiled = (ci+1)->profiled;
             L->ci--;  /* remove new frame */
             goto reentry;
           }
@@ -802,6 +816,7 @@ void luaV_execute (lua_State *L, int nexeccalls) {
         for (; n > 0; n--) {
           TValue *val = ra+n;
           setobj2t(L, luaH_setnum(L, h, last--), val);
+          luaH_touch(h);
           luaC_barriert(L, h, val);
         }
         continue;
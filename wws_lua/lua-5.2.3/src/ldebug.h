@@ -30,5 +30,17 @@ LUAI_FUNC l_noret luaG_ordererror (lua_State *L, const TValue *p1,
                                                  const TValue *p2);
 LUAI_FUNC l_noret luaG_runerror (lua_State *L, const char *fmt, ...);
 LUAI_FUNC l_noret luaG_errormsg (lua_State *L);
+LUAI_FUNC int luaG_checklinemask (lua_State *L, Proto *p, int line);
+LUAI_FUNC void luaG_countline (lua_State *L, Proto *p, int line);
+LUAI_FUNC void luaG_countopcode (lua_State *L, Proto *p, int op);
+LUAI_FUNC int luaG_checkprofilefilter (lua_State *L, CallInfo *ci);
+
+/* Sony: whether the line hook should run for `line' of `p' */
+#define luaG_linehooked(L,p,line) \
+	(G(L)->linemask == NULL || luaG_checklinemask(L, p, line))
+
+/* Sony: whether call & return hooks should run for the function of `ci' */
+#define luaG_profilehooked(L,ci) \
+	(G(L)->profilefilter == NULL || luaG_checkprofilefilter(L, ci))
 
 #endif
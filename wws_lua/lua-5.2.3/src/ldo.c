@@ -221,6 +221,10 @@ void luaD_hook (lua_State *L, int event, int line) {
     ptrdiff_t top = savestack(L, L->top);
     ptrdiff_t ci_top = savestack(L, ci->top);
     lua_Debug ar;
+    /* Sony: profile filters; a frame reused by tail calls keeps the
+       verdict of its first entry, so its return pairs with that call */
+    if ((event == LUA_HOOKCALL || event == LUA_HOOKRET) && !ci->profiled)
+      return;
     ar.event = event;
     ar.currentline = line;
     ar.i_ci = ci;
@@ -312,6 +316,7 @@ int luaD_precall (lua_State *L, StkId func, int nresults) {
       ci->top = L->top + LUA_MINSTACK;
       lua_assert(ci->top <= L->stack_last);
       ci->callstatus = 0;
+      ci->profiled = cast_byte(luaG_profilehooked(L, ci));  /* Sony */
       luaC_checkGC(L);  /* stack grow uses memory */
       if (L->hookmask & LUA_MASKCALL)
         luaD_hook(L, LUA_HOOKCALL, -1);
@@ -345,6 +350,7 @@ int luaD_precall (lua_State *L, StkId func, int nresults) {
       lua_assert(ci->top <= L->stack_last);
       ci->u.l.savedpc = p->code;  /* starting point */
       ci->callstatus = CIST_LUA;
+      ci->profiled = cast_byte(luaG_profilehooked(L, ci));  /* Sony */
       L->top = ci->top;
       luaC_checkGC(L);  /* stack grow uses memory */
       if (L->hookmask & LUA_MASKCALL)
@@ -363,7 +369,7 @@ int luaD_poscall (lua_State *L, StkId firstResult) {
   StkId res;
   int wanted, i;
   CallInfo *ci = L->ci;
-  if (L->hookmask & (LUA_MASKRET | LUA_MASKLINE)) {
+  if (L->hookmask & (LUA_MASKRET | LUA_MASKLINE | LUAI_MASKCOVER)) {
     if (L->hookmask & LUA_MASKRET) {
       ptrdiff_t fr = savestack(L, firstResult);  /* hook may change stack */
       luaD_hook(L, LUA_HOOKRET, -1);
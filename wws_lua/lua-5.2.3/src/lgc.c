@@ -621,6 +621,8 @@ static void convergeephemerons (global_State *g) {
 /*
 ** clear entries with unmarked keys from all weaktables in list 'l' up
 ** to element 'f'
+** Sony: each cleared entry is a store into the table, so it bumps the
+** table version like any other store (see lua_tableversion)
 */
 static void clearkeys (global_State *g, GCObject *l, GCObject *f) {
   for (; l != f; l = gco2t(l)->gclist) {
@@ -630,6 +632,7 @@ static void clearkeys (global_State *g, GCObject *l, GCObject *f) {
       if (!ttisnil(gval(n)) && (iscleared(g, gkey(n)))) {
         setnilvalue(gval(n));  /* remove value ... */
         removeentry(n);  /* and remove entry from table */
+        luaH_touch(h);
       }
     }
   }
@@ -639,6 +642,7 @@ static void clearkeys (global_State *g, GCObject *l, GCObject *f) {
 /*
 ** clear entries with unmarked values from all weaktables in list 'l' up
 ** to element 'f'
+** Sony: bumps the table version too (see clearkeys)
 */
 static void clearvalues (global_State *g, GCObject *l, GCObject *f) {
   for (; l != f; l = gco2t(l)->gclist) {
@@ -647,13 +651,16 @@ static void clearvalues (global_State *g, GCObject *l, GCObject *f) {
     int i;
     for (i = 0; i < h->sizearray; i++) {
       TValue *o = &h->array[i];
-      if (iscleared(g, o))  /* value was collected? */
+      if (iscleared(g, o)) {  /* value was collected? */
         setnilvalue(o);  /* remove value */
+        luaH_touch(h);
+      }
     }
     for (n = gnode(h, 0); n < limit; n++) {
       if (!ttisnil(gval(n)) && iscleared(g, gval(n))) {
         setnilvalue(gval(n));  /* remove value ... */
         removeentry(n);  /* and remove entry from table */
+        luaH_touch(h);
       }
     }
   }
@@ -1037,7 +1044,17 @@ static l_mem atomic (lua_State *L) {
 }
 
 
-static lu_mem singlestep (lua_State *L) {
+/*
+** Sony: report collector activity to the GC hook, if any
+*/
+static void gcevent (lua_State *L, int event, lu_mem arg) {
+  global_State *g = G(L);
+  if (g->gchook != NULL)
+    g->gchook(L, event, cast(size_t, arg), g->gchookud);
+}
+
+
+static lu_mem rawsinglestep (lua_State *L) {
   global_State *g = G(L);
   switch (g->gcstate) {
     case GCSpause: {
@@ -1059,7 +1076,9 @@ static lu_mem singlestep (lua_State *L) {
         int sw;
         g->gcstate = GCSatomic;  /* finish mark phase */
         g->GCestimate = g->GCmemtrav;  /* save what was counted */;
+        gcevent(L, LUA_GCEVATOMICBEGIN, 0);
         work = atomic(L);  /* add what was traversed by 'atomic' */
+        gcevent(L, LUA_GCEVATOMICEND, 0);
         g->GCestimate += work;  /* estimate of total memory traversed */ 
         sw = entersweep(L);
         return work + sw * GCSWEEPCOST;
@@ -1103,6 +1122,26 @@ static lu_mem singlestep (lua_State *L) {
 }
 
 
+/*
+** Sony: one collector step, reporting swept memory and the end of a
+** cycle to the GC hook
+*/
+static lu_mem singlestep (lua_State *L) {
+  global_State *g = G(L);
+  lu_byte oldstate = g->gcstate;
+  lu_mem oldbytes = gettotalbytes(g);
+  lu_mem work = rawsinglestep(L);
+  if (g->gchook != NULL) {
+    if ((GCSsweepstring <= oldstate && oldstate <= GCSsweep) &&
+        oldbytes > gettotalbytes(g))
+      gcevent(L, LUA_GCEVSWEEP, oldbytes - gettotalbytes(g));
+    if (oldstate != GCSpause && g->gcstate == GCSpause)
+      gcevent(L, LUA_GCEVCYCLEEND, gettotalbytes(g));
+  }
+  return work;
+}
+
+
 /*
 ** advances the garbage collector until it reaches a state allowed
 ** by 'statemask'
@@ -1163,11 +1202,13 @@ static void incstep (lua_State *L) {
 void luaC_forcestep (lua_State *L) {
   global_State *g = G(L);
   int i;
+  gcevent(L, LUA_GCEVSTEPBEGIN, gettotalbytes(g));
   if (isgenerational(g)) generationalcollection(L);
   else incstep(L);
   /* run a few finalizers (or all of them at the end of a collect cycle) */
   for (i = 0; g->tobefnz && (i < GCFINALIZENUM || g->gcstate == GCSpause); i++)
     GCTM(L, 1);  /* call one finalizer */
+  gcevent(L, LUA_GCEVSTEPEND, gettotalbytes(g));
 }
 
 
@@ -1190,6 +1231,7 @@ void luaC_fullgc (lua_State *L, int isemergency) {
   global_State *g = G(L);
   int origkind = g->gckind;
   lua_assert(origkind != KGC_EMERGENCY);
+  gcevent(L, LUA_GCEVSTEPBEGIN, gettotalbytes(g));
   if (isemergency)  /* do not run finalizers during emergency GC */
     g->gckind = KGC_EMERGENCY;
   else {
@@ -1213,6 +1255,7 @@ void luaC_fullgc (lua_State *L, int isemergency) {
   setpause(g, gettotalbytes(g));
   if (!isemergency)   /* do not run finalizers during emergency GC */
     callallpendingfinalizers(L, 1);
+  gcevent(L, LUA_GCEVSTEPEND, gettotalbytes(g));
 }
 
 /* }====================================================== */
@@ -20,6 +20,7 @@
 #include "lgc.h"
 #include "llex.h"
 #include "lmem.h"
+#include "lopcodes.h"
 #include "lstate.h"
 #include "lstring.h"
 #include "ltable.h"
@@ -227,6 +228,7 @@ static void close_state (lua_State *L) {
   if (g->version)  /* closing a fully built state? */
     luai_userstateclose(L);
   luaM_freearray(L, G(L)->strt.hash, G(L)->strt.size);
+  luaM_freearray(L, g->opcounts, (g->opcounts ? NUM_OPCODES : 0));
   luaZ_freebuffer(L, &g->buff);
   freestack(L);
   lua_assert(gettotalbytes(g) == sizeof(LG));
@@ -304,6 +306,16 @@ LUA_API lua_State *lua_newstate (lua_Alloc f, void *ud) {
   g->gcpause = LUAI_GCPAUSE;
   g->gcmajorinc = LUAI_GCMAJOR;
   g->gcstepmul = LUAI_GCMUL;
+  g->gchook = NULL;
+  g->gchookud = NULL;
+  g->linemask = NULL;
+  g->linemaskud = NULL;
+  g->linemaskgen = 0;
+  g->opcounts = NULL;
+  g->profilefilter = NULL;
+  g->profilefilterud = NULL;
+  g->profilefiltergen = 0;
+  g->profilefilterc = 1;
   for (i=0; i < LUA_NUMTAGS; i++) g->mt[i] = NULL;
   if (luaD_rawrunprotected(L, f_luaopen, NULL) != LUA_OK) {
     /* memory allocation error: free partial state */
@@ -72,6 +72,7 @@ typedef struct CallInfo {
   struct CallInfo *previous, *next;  /* dynamic call link */
   short nresults;  /* expected number of results from this function */
   lu_byte callstatus;
+  lu_byte profiled;  /* Sony: profile filter verdict taken on entry */
   ptrdiff_t extra;
   union {
     struct {  /* only for Lua functions */
@@ -106,6 +107,12 @@ typedef struct CallInfo {
 #define isLua(ci)	((ci)->callstatus & CIST_LUA)
 
 
+/* Sony: line coverage & opcode profile bits in `hookmask', beside the
+   LUA_MASK* hook bits */
+#define LUAI_MASKCOVER	(1 << 6)
+#define LUAI_MASKOPCODES	(1 << 5)
+
+
 /*
 ** `global state', shared by all threads of this state
 */
@@ -145,6 +152,16 @@ typedef struct global_State {
   TString *memerrmsg;  /* memory-error message */
   TString *tmname[TM_N];  /* array with tag-method names */
   struct Table *mt[LUA_NUMTAGS];  /* metatables for basic types */
+  lua_GCHook gchook;  /* Sony: GC instrumentation hook */
+  void *gchookud;  /* auxiliary data to `gchook' */
+  lua_LineMask linemask;  /* Sony: line breakpoint mask function */
+  void *linemaskud;  /* auxiliary data to `linemask' */
+  unsigned int linemaskgen;  /* bumped by lua_setlinemask */
+  size_t *opcounts;  /* Sony: opcode profile totals; see lua_setopcodeprofile */
+  lua_ProfileFilter profilefilter;  /* Sony: profile filter function */
+  void *profilefilterud;  /* auxiliary data to `profilefilter' */
+  unsigned int profilefiltergen;  /* bumped by lua_setprofilefilter */
+  lu_byte profilefilterc;  /* profile filter verdict for C functions */
 } global_State;
 
 
@@ -163,7 +180,7 @@ struct lua_State {
   int stacksize;
   unsigned short nny;  /* number of non-yieldable calls in stack */
   unsigned short nCcalls;  /* number of nested C calls */
-  lu_byte hookmask;
+  lu_byte hookmask;  /* Sony: may also hold LUAI_MASKCOVER & LUAI_MASKOPCODES */
   lu_byte allowhook;
   int basehookcount;
   int hookcount;
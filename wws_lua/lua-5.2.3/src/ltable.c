@@ -381,6 +381,7 @@ Table *luaH_new (lua_State *L) {
   Table *t = &luaC_newobj(L, LUA_TTABLE, sizeof(Table), NULL, 0)->h;
   t->metatable = NULL;
   t->flags = cast_byte(~0);
+  t->version = 0;
   t->array = NULL;
   t->sizearray = 0;
   setnodevector(L, t, 0);
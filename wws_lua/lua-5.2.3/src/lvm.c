@@ -67,16 +67,23 @@ static void traceexec (lua_State *L) {
     ci->callstatus &= ~CIST_HOOKYIELD;  /* erase mark */
     return;  /* do not call hook again (VM yielded, so it did not move) */
   }
+  if (mask & LUAI_MASKOPCODES)  /* Sony: opcode profile */
+    luaG_countopcode(L, ci_func(ci)->p, GET_OPCODE(*(ci->u.l.savedpc - 1)));
   if (counthook)
     luaD_hook(L, LUA_HOOKCOUNT, -1);  /* call count hook */
-  if (mask & LUA_MASKLINE) {
+  if (mask & (LUA_MASKLINE | LUAI_MASKCOVER)) {
     Proto *p = ci_func(ci)->p;
     int npc = pcRel(ci->u.l.savedpc, p);
     int newline = getfuncline(p, npc);
     if (npc == 0 ||  /* call linehook when enter a new function, */
         ci->u.l.savedpc <= L->oldpc ||  /* when jump back (loop), or when */
-        newline != getfuncline(p, pcRel(L->oldpc, p)))  /* enter a new line */
-      luaD_hook(L, LUA_HOOKLINE, newline);  /* call line hook */
+        newline != getfuncline(p, pcRel(L->oldpc, p))) {  /* enter a new line */
+      if (mask & LUAI_MASKCOVER)  /* Sony: line coverage */
+        luaG_countline(L, p, newline);
+      if ((mask & LUA_MASKLINE) &&
+          luaG_linehooked(L, p, newline))  /* Sony: line breakpoint masks */
+        luaD_hook(L, LUA_HOOKLINE, newline);  /* call line hook */
+    }
   }
   L->oldpc = ci->u.l.savedpc;
   if (L->status == LUA_YIELD) {  /* did hook yield? */
@@ -153,6 +160,7 @@ void luaV_settable (lua_State *L, const TValue *t, TValue *key, StkId val) {
         /* no metamethod and (now) there is an entry with given key */
         setobj2t(L, oldval, val);  /* assign new value to that entry */
         invalidateTMcache(h);
+        luaH_touch(h);
         luaC_barrierback(L, obj2gco(h), val);
         return;
       }
@@ -545,8 +553,8 @@ void luaV_execute (lua_State *L) {
   for (;;) {
     Instruction i = *(ci->u.l.savedpc++);
     StkId ra;
-    if ((L->hookmask & (LUA_MASKLINE | LUA_MASKCOUNT)) &&
-        (--L->hookcount == 0 || L->hookmask & LUA_MASKLINE)) {
+    if ((L->hookmask & (LUA_MASKLINE | LUA_MASKCOUNT | LUAI_MASKCOVER | LUAI_MASKOPCODES)) &&
+        (--L->hookcount == 0 || L->hookmask & (LUA_MASKLINE | LUAI_MASKCOVER | LUAI_MASKOPCODES))) {
       Protect(traceexec(L));
     }
     /* WARNING: several calls may realloc the stack and invalidate `ra' */
@@ -826,6 +834,7 @@ void luaV_execute (lua_State *L) {
         for (; n > 0; n--) {
           TValue *val = ra+n;
           luaH_setint(L, h, last--, val);
+          luaH_touch(h);
           luaC_barrierback(L, obj2gco(h), val);
         }
         L->top = ci->top;  /* correct top (in case of previous open call) */